@@ -25,15 +25,33 @@
 #	define _CRT_NONSTDC_NO_DEPRECATE
 #endif
 
-#define WIN32_LEAN_AND_MEAN
-#include <windows.h>			// For FindFirstFile()
+#ifdef _WIN32
+#	define WIN32_LEAN_AND_MEAN
+#	include <windows.h>			// For FindFirstFile() and threads.
 
-#include <malloc.h>
+#	define PATH_SEPARATOR			'\\'
+#	define PATH_SEPARATOR_STRING	"\\"
+#else
+#	include <dirent.h>
+#	include <pthread.h>
+#	include <strings.h>
+#	include <sys/stat.h>
+#	include <unistd.h>
+
+#	define stricmp		strcasecmp
+#	define strnicmp		strncasecmp
+
+#	define PATH_SEPARATOR			'/'
+#	define PATH_SEPARATOR_STRING	"/"
+#endif
+
+#include <ctype.h>
+#include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 #include <stdarg.h>
 
-#include "..\lib\VTFLib.h"
+#include "../lib/VTFLib.h"
 #ifdef _DEBUG
 #	ifdef _WIN64
 #		pragma comment(lib, "../VTFLib/x64/Debug/VTFLib.lib")
@@ -48,7 +66,7 @@
 #	endif
 #endif
 
-#include "IL\il.h"
+#include "IL/il.h"
 #pragma comment(lib, "DevIL.lib")
 
 #endif
\ No newline at end of file
@@ -20,16 +20,29 @@
 #include "stdafx.h"
 #include "enumerations.h"
 
-#define MAX_ITEMS	1024
+#ifdef _WIN32
+typedef HANDLE THREAD;
+typedef CRITICAL_SECTION LOCK;
+#	define THREAD_PROC(Name)	DWORD WINAPI Name(LPVOID lpParameter)
+#else
+typedef pthread_t THREAD;
+typedef pthread_mutex_t LOCK;
+#	define THREAD_PROC(Name)	void *Name(void *lpParameter)
+#endif
 
 vlUInt uiFileCount = 0;
-vlChar *lpFiles[MAX_ITEMS];							// Files to convert.
+vlChar **lpFiles;									// Files to convert.
 vlUInt uiFolderCount = 0;
-vlChar *lpFolders[MAX_ITEMS];						// Folders to convert.
+vlChar **lpFolders;									// Folders to convert.
 vlBool bRecursive = vlFalse;						// Recursively search folders.
+vlBool bWriteCRC = vlFalse;							// Add an image data CRC resource.
+vlUInt uiThreadCount = 0;							// Worker threads, 0 for one per processor.
+vlChar *lpManifestFile = 0;							// Record of earlier runs, to skip unchanged files.
 
 vlUInt uiProcessed = 0;								// Files processed.
 vlUInt uiCompleted = 0;								// Files processed without error.
+vlUInt uiSkipped = 0;								// Files whose outputs were up to date.
+vlUInt uiDeleted = 0;								// Outputs deleted because no file makes them any more.
 
 vlChar *lpPrefix = "";								// String to add to start of output file name.
 vlChar *lpPostfix = "";								// String to add to end of output file name.
@@ -39,80 +52,1584 @@ vlBool bSilent = vlFalse;							// Don't display output.
 vlBool bPause = vlFalse;							// Don't pause the console.
 vlBool bHelp = vlFalse;								// Display help.
 
-vlUInt uiVTFImage;									// VTF image handle.
-vlUInt uiVMTMaterial;								// VMT material handle.
-ILuint uiDevILImage;								// DevIL image handle.
+VTFImageFormat AlphaFormat = IMAGE_FORMAT_DXT5;		// VTF image format for alpha textures.
+VTFImageFormat NormalFormat = IMAGE_FORMAT_DXT1;	// VTF image format for non-alpha textures.
+SVTFCreateOptions CreateOptions;					// VTF creation options.
+vlChar *lpShader = 0;								// VMT shader to use.
+vlUInt uiParameterCount = 0;
+vlChar *(*lpParameters)[2];							// VMT parameters.
+vlChar *lpExportFormat = "tga";						// Format extension for exporting VTF images.
+vlBool bDecodeDDS = vlFalse;						// Re-encode DDS input rather than copying its surfaces.
+
+//
+// Each worker converts one file at a time with its own images, so nothing but
+// DevIL (which only has one bound image per process) and the output is shared.
+//
+typedef struct tagSWorker
+{
+	VLContext *Context;								// VTFLib context.
+	vlUInt uiVTFImage;								// VTF image handle.
+	vlUInt uiVMTMaterial;							// VMT material handle.
+	ILuint uiDevILImage;							// DevIL image handle.
+	SVTFCreateOptions CreateOptions;				// VTF creation options for the current file.
+
+	vlChar *lpLog;									// Output for the current file.
+	vlUInt uiLogLength;
+	vlUInt uiLogSize;
+
+	vlChar *lpOutputs;								// Files written for the current file, tab separated.
+	vlUInt uiOutputsLength;
+	vlUInt uiOutputsSize;
+
+	THREAD Thread;
+	vlBool bThread;									// Thread was started.
+} SWorker;
+
+//
+// A folder found by the walker, with the files in it that match its wildcard.
+//
+typedef struct tagSFolder
+{
+	vlChar *lpPath;
+	const vlChar *lpWildcard;
+
+	struct tagSFolder **lpFolders;					// Sub folders, if recursing.
+	vlUInt uiFolderCount;
+	vlUInt uiFolderSize;
+
+	vlChar **lpFiles;
+	vlUInt uiFileCount;
+	vlUInt uiFileSize;
+} SFolder;
+
+//
+// What a run made from one input, so the next run can tell if it is up to
+// date.  uiSettings is a hash of every option that changes the outputs.
+// Paths are full paths, so a manifest means the same files from any folder.
+//
+typedef struct tagSManifestEntry
+{
+	vlChar *lpInput;
+	vlUInt64 uiSize;
+	vlUInt64 uiTime;								// Modification time, as the system gives it.
+	vlUInt64 uiHash;								// Hash of the contents.
+	vlUInt64 uiSettings;
+	vlUInt uiVersion;								// VTFLib version.
+	vlChar *lpOutputs;								// Files written, tab separated.
+	vlBool bSeen;									// Input was queued this run.
+} SManifestEntry;
+
+#define MANIFEST_HEADER		"VTFCmd manifest 2"
+#define HASH_BASIS			(((vlUInt64)0xcbf29ce4 << 32) | 0x84222325)
+
+typedef enum tagJobType
+{
+	JOB_FILE = 0,
+	JOB_FOLDER_BEGIN,
+	JOB_FOLDER_END,
+	JOB_DUPLICATE									// A file queued again, which is left out.
+} JobType;
+
+//
+// Jobs are printed in the order they were queued, however they finish.
+//
+typedef struct tagSJob
+{
+	JobType Type;
+	vlChar *lpPath;
+	vlChar *lpFullPath;								// Full path of a file, the manifest's key for it.
+
+	vlChar *lpLog;									// Output, held until every job before it is printed.
+	vlBool bDone;
+	vlBool bCompleted;
+	vlBool bSkipped;								// Outputs were up to date.
+	SManifestEntry Entry;							// Manifest entry for this run, if any.
+} SJob;
+
+typedef void (*PWorkProc)(SWorker *Worker, vlUInt uiIndex);
+
+SWorker *lpWorkers = 0;								// Worker state, one per thread.
+vlUInt uiWorkerCount = 0;
+
+SJob *lpJobs = 0;									// Files and folder messages, in output order.
+vlUInt uiJobCount = 0;
+vlUInt uiJobSize = 0;
+vlUInt uiNextPrint = 0;								// First job not yet printed.
+
+SFolder **lpLevel = 0;								// Folders being listed by the walker.
+vlUInt uiLevelCount = 0;
+
+SManifestEntry *lpManifest = 0;						// Entries from the last run, sorted by input.
+vlUInt uiManifestCount = 0;
+vlChar *lpManifestData = 0;							// Manifest file the entries point into.
+vlChar *lpManifestRoot = 0;							// Output root the last run recorded.
+vlChar *lpOutputRoot = 0;							// Full path of the -output folder, or the manifest's.
+vlUInt64 uiSettings = 0;							// Hash of the options for this run.
+
+PWorkProc pWork = 0;								// Work being run by RunWorkers().
+vlUInt uiWorkCount = 0;
+vlUInt uiWorkNext = 0;
+
+LOCK WorkLock;										// Guards uiWorkNext.
+LOCK PrintLock;										// Guards job results and the console.
+LOCK DevILLock;										// Guards every DevIL call.
+
+void Pause();
+void Print(const vlChar *lpFormat, ...);
+void PrintUsage(const vlChar *lpError, ...);
+
+void WorkerPrint(SWorker *Worker, const vlChar *lpFormat, ...);
+
+vlChar *CreateOutputPath(const vlChar *lpInputFile, const vlChar *lpExtension);
+vlBool ProcessFile(SWorker *Worker, vlChar *lpInputFile);
+
+//
+// stristr()
+// Case insensitive version of strstr().
+//
+char *stristr(const char *string, const char *strSearch)
+{
+	const char *ptr = string;
+	const char *ptr2;
+
+    while(1)
+	{
+		ptr = strchr(string, toupper(*strSearch));
+		ptr2 = strchr(string, tolower(*strSearch));
+
+		if(ptr == 0)
+		{
+			ptr = ptr2;
+		}
+		if(ptr == 0)
+		{
+			break;
+		}
+		if(ptr2 && (ptr2 < ptr))
+		{
+			ptr = ptr2;
+		}
+		if(!strnicmp(ptr, strSearch, strlen(strSearch)))
+		{
+			return (char *)ptr;
+		}
+
+		string = ptr + 1;
+    }
+
+    return 0;
+}
+
+//
+// strrpl()
+// Replace a char in a string with another.
+//
+void strrpl(char *string, char chr, char rplChr)
+{
+	while(*string != 0)
+	{
+		if(*string == chr)
+			*string = rplChr;
+		string++;
+	}
+}
+
+//
+// Reserve()
+// Grow an array so it can hold at least uiCount items.
+//
+vlVoid *Reserve(vlVoid *lpArray, vlUInt uiCount, vlUInt *uiSize, vlUInt uiItemSize)
+{
+	vlUInt uiNewSize;
+
+	if(uiCount <= *uiSize)
+	{
+		return lpArray;
+	}
+
+	uiNewSize = *uiSize != 0 ? *uiSize : 16;
+	while(uiNewSize < uiCount)
+	{
+		uiNewSize *= 2;
+	}
+
+	lpArray = realloc(lpArray, uiNewSize * uiItemSize);
+	if(lpArray == 0)
+	{
+		printf("Out of memory.\n");
+		exit(1);
+	}
+
+	*uiSize = uiNewSize;
+
+	return lpArray;
+}
+
+//
+// InitLock(), DeleteLock(), EnterLock(), LeaveLock()
+// Mutexes.
+//
+void InitLock(LOCK *Lock)
+{
+#ifdef _WIN32
+	InitializeCriticalSection(Lock);
+#else
+	pthread_mutex_init(Lock, 0);
+#endif
+}
+
+void DeleteLock(LOCK *Lock)
+{
+#ifdef _WIN32
+	DeleteCriticalSection(Lock);
+#else
+	pthread_mutex_destroy(Lock);
+#endif
+}
+
+void EnterLock(LOCK *Lock)
+{
+#ifdef _WIN32
+	EnterCriticalSection(Lock);
+#else
+	pthread_mutex_lock(Lock);
+#endif
+}
+
+void LeaveLock(LOCK *Lock)
+{
+#ifdef _WIN32
+	LeaveCriticalSection(Lock);
+#else
+	pthread_mutex_unlock(Lock);
+#endif
+}
+
+//
+// GetProcessorCount()
+// Number of processors to start workers for.
+//
+vlUInt GetProcessorCount()
+{
+#ifdef _WIN32
+	SYSTEM_INFO SystemInfo;
+
+	GetSystemInfo(&SystemInfo);
+
+	return SystemInfo.dwNumberOfProcessors != 0 ? (vlUInt)SystemInfo.dwNumberOfProcessors : 1;
+#else
+	long lCount = sysconf(_SC_NPROCESSORS_ONLN);
+
+	return lCount > 0 ? (vlUInt)lCount : 1;
+#endif
+}
+
+//
+// GetPathType()
+// Returns 0 if lpPath doesn't exist, 1 for a file and 2 for a folder.
+//
+vlUInt GetPathType(const vlChar *lpPath)
+{
+#ifdef _WIN32
+	DWORD dwAttributes = GetFileAttributes(lpPath);
+
+	if(dwAttributes == INVALID_FILE_ATTRIBUTES)
+	{
+		return 0;
+	}
+
+	return (dwAttributes & FILE_ATTRIBUTE_DIRECTORY) ? 2 : 1;
+#else
+	struct stat Stat;
+
+	if(stat(lpPath, &Stat) != 0)
+	{
+		return 0;
+	}
+
+	return S_ISDIR(Stat.st_mode) ? 2 : 1;
+#endif
+}
+
+//
+// FindFileName()
+// Returns the part of lpPath after the last path separator.
+//
+vlChar *FindFileName(vlChar *lpPath)
+{
+	vlChar *lpName = lpPath;
+
+	for(; *lpPath != '\0'; lpPath++)
+	{
+#ifdef _WIN32
+		if(*lpPath == '\\' || *lpPath == '/')
+#else
+		if(*lpPath == PATH_SEPARATOR)
+#endif
+		{
+			lpName = lpPath + 1;
+		}
+	}
+
+	return lpName;
+}
+
+//
+// JoinPath()
+// Allocate lpFolder\lpName.
+//
+vlChar *JoinPath(const vlChar *lpFolder, const vlChar *lpName)
+{
+	vlChar *lpPath = malloc(strlen(lpFolder) + strlen(lpName) + 2);
+
+	if(lpPath == 0)
+	{
+		printf("Out of memory.\n");
+		exit(1);
+	}
+
+	sprintf(lpPath, "%s%c%s", lpFolder, PATH_SEPARATOR, lpName);
+
+	return lpPath;
+}
+
+//
+// GetFullPath()
+// Allocate the full path of lpPath, with . and .. folded away.
+//
+vlChar *GetFullPath(const vlChar *lpPath)
+{
+	vlChar *lpFullPath;
+#ifdef _WIN32
+	DWORD dwSize = GetFullPathName(lpPath, 0, 0, 0);
+
+	lpFullPath = malloc(dwSize != 0 ? dwSize : strlen(lpPath) + 1);
+	if(lpFullPath == 0)
+	{
+		printf("Out of memory.\n");
+		exit(1);
+	}
+
+	if(dwSize == 0 || GetFullPathName(lpPath, dwSize, lpFullPath, 0) == 0)
+	{
+		strcpy(lpFullPath, lpPath);
+	}
+#else
+	vlChar *lpFolder = *lpPath != '/' ? getcwd(0, 0) : 0;
+	const vlChar *lpIn, *lpEnd;
+	vlChar *lpOut;
+
+	lpFullPath = malloc((lpFolder != 0 ? strlen(lpFolder) + 1 : 0) + strlen(lpPath) + 1);
+	if(lpFullPath == 0)
+	{
+		printf("Out of memory.\n");
+		exit(1);
+	}
+
+	sprintf(lpFullPath, "%s%s%s", lpFolder != 0 ? lpFolder : "", lpFolder != 0 ? "/" : "", lpPath);
+	free(lpFolder);
+
+	if(*lpFullPath != '/')
+	{
+		return lpFullPath;
+	}
+
+	// Copy each part back over itself, dropping empty and . parts and
+	// backing up over the last part for a .. one.
+	for(lpIn = lpOut = lpFullPath; *lpIn != '\0'; lpIn = lpEnd)
+	{
+		while(*lpIn == '/')
+		{
+			lpIn++;
+		}
+
+		if((lpEnd = strchr(lpIn, '/')) == 0)
+		{
+			lpEnd = lpIn + strlen(lpIn);
+		}
+
+		if(lpEnd == lpIn || (lpEnd - lpIn == 1 && lpIn[0] == '.'))
+		{
+			continue;
+		}
+
+		if(lpEnd - lpIn == 2 && lpIn[0] == '.' && lpIn[1] == '.')
+		{
+			while(lpOut > lpFullPath && *--lpOut != '/');
+			continue;
+		}
+
+		*lpOut++ = '/';
+		memmove(lpOut, lpIn, lpEnd - lpIn);
+		lpOut += lpEnd - lpIn;
+	}
+
+	if(lpOut == lpFullPath)
+	{
+		*lpOut++ = '/';
+	}
+	*lpOut = '\0';
+#endif
+
+	return lpFullPath;
+}
+
+//
+// WorkerMain()
+// Run pWork until there is none left.
+//
+THREAD_PROC(WorkerMain)
+{
+	SWorker *Worker = (SWorker *)lpParameter;
+	vlUInt uiIndex;
+
+	while(1)
+	{
+		EnterLock(&WorkLock);
+		uiIndex = uiWorkNext < uiWorkCount ? uiWorkNext++ : uiWorkCount;
+		LeaveLock(&WorkLock);
+
+		if(uiIndex == uiWorkCount)
+		{
+			break;
+		}
+
+		pWork(Worker, uiIndex);
+	}
+
+	return 0;
+}
+
+//
+// RunWorkers()
+// Run pProc(Worker, 0) to pProc(Worker, uiCount - 1) on every worker and wait
+// for them to finish.  The first worker runs on this thread, so work still gets
+// done if no threads can be started.
+//
+void RunWorkers(PWorkProc pProc, vlUInt uiCount)
+{
+	vlUInt i;
+
+	pWork = pProc;
+	uiWorkCount = uiCount;
+	uiWorkNext = 0;
+
+	for(i = 1; i < uiWorkerCount && i < uiCount; i++)
+	{
+#ifdef _WIN32
+		lpWorkers[i].Thread = CreateThread(0, 0, WorkerMain, &lpWorkers[i], 0, 0);
+		lpWorkers[i].bThread = lpWorkers[i].Thread != 0;
+#else
+		lpWorkers[i].bThread = pthread_create(&lpWorkers[i].Thread, 0, WorkerMain, &lpWorkers[i]) == 0;
+#endif
+	}
+
+	WorkerMain(&lpWorkers[0]);
+
+	for(i = 1; i < uiWorkerCount; i++)
+	{
+		if(lpWorkers[i].bThread)
+		{
+#ifdef _WIN32
+			WaitForSingleObject(lpWorkers[i].Thread, INFINITE);
+			CloseHandle(lpWorkers[i].Thread);
+#else
+			pthread_join(lpWorkers[i].Thread, 0);
+#endif
+			lpWorkers[i].bThread = vlFalse;
+		}
+	}
+}
+
+//
+// CreateFolder()
+// Allocate a folder for the walker to list.
+//
+SFolder *CreateFolder(vlChar *lpPath, const vlChar *lpWildcard)
+{
+	SFolder *Folder = calloc(1, sizeof(SFolder));
+
+	if(Folder == 0)
+	{
+		printf("Out of memory.\n");
+		exit(1);
+	}
+
+	Folder->lpPath = lpPath;
+	Folder->lpWildcard = lpWildcard;
+
+	return Folder;
+}
+
+//
+// FreeFolder()
+// Free a folder, its sub folders and their paths.
+//
+void FreeFolder(SFolder *Folder)
+{
+	vlUInt i;
+
+	for(i = 0; i < Folder->uiFolderCount; i++)
+	{
+		FreeFolder(Folder->lpFolders[i]);
+	}
+
+	for(i = 0; i < Folder->uiFileCount; i++)
+	{
+		free(Folder->lpFiles[i]);
+	}
+
+	free(Folder->lpFolders);
+	free(Folder->lpFiles);
+	free(Folder->lpPath);
+	free(Folder);
+}
+
+//
+// AddSubFolder(), AddFile()
+// Add an entry found while listing a folder.
+//
+void AddSubFolder(SFolder *Folder, vlChar *lpPath)
+{
+	Folder->lpFolders = Reserve(Folder->lpFolders, Folder->uiFolderCount + 1, &Folder->uiFolderSize, sizeof(SFolder *));
+	Folder->lpFolders[Folder->uiFolderCount++] = CreateFolder(lpPath, Folder->lpWildcard);
+}
+
+void AddFile(SFolder *Folder, vlChar *lpPath)
+{
+	Folder->lpFiles = Reserve(Folder->lpFiles, Folder->uiFileCount + 1, &Folder->uiFileSize, sizeof(vlChar *));
+	Folder->lpFiles[Folder->uiFileCount++] = lpPath;
+}
+
+#ifndef _WIN32
+//
+// ComparePaths(), CompareFolders()
+// qsort() callbacks.  readdir() has no order, sort so the output always does.
+//
+int ComparePaths(const void *lpLeft, const void *lpRight)
+{
+	return strcmp(*(const vlChar **)lpLeft, *(const vlChar **)lpRight);
+}
+
+int CompareFolders(const void *lpLeft, const void *lpRight)
+{
+	return strcmp((*(const SFolder **)lpLeft)->lpPath, (*(const SFolder **)lpRight)->lpPath);
+}
+
+//
+// MatchWildcard()
+// Match a file name the way FindFirstFile() would, ignoring case.
+//
+vlBool MatchWildcard(const vlChar *lpWildcard, const vlChar *lpName)
+{
+	// *.* matches names without an extension too.
+	if(strcmp(lpWildcard, "*.*") == 0)
+	{
+		return vlTrue;
+	}
+
+	for(; *lpWildcard != '\0'; lpWildcard++, lpName++)
+	{
+		if(*lpWildcard == '*')
+		{
+			// Try the rest of the wildcard against every tail of the name.
+			for(; ; lpName++)
+			{
+				if(MatchWildcard(lpWildcard + 1, lpName))
+				{
+					return vlTrue;
+				}
+				if(*lpName == '\0')
+				{
+					return vlFalse;
+				}
+			}
+		}
+
+		if(*lpName == '\0' || (*lpWildcard != '?' && tolower((unsigned char)*lpWildcard) != tolower((unsigned char)*lpName)))
+		{
+			return vlFalse;
+		}
+	}
+
+	return *lpName == '\0';
+}
+#endif
+
+//
+// ListFolder()
+// Find the sub folders (if recursing) and matching files in a folder.
+//
+void ListFolder(SFolder *Folder)
+{
+#ifdef _WIN32
+	vlChar *lpSearchString;
+
+	WIN32_FIND_DATA FindData;
+	HANDLE Handle;
+
+	if(bRecursive)
+	{
+		lpSearchString = JoinPath(Folder->lpPath, "*");
+
+		Handle = FindFirstFile(lpSearchString, &FindData);
+
+		if(Handle != INVALID_HANDLE_VALUE)
+		{
+			do
+			{
+				if(stricmp(FindData.cFileName, ".") != 0 && stricmp(FindData.cFileName, "..") != 0)
+				{
+					if(FindData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+					{
+						AddSubFolder(Folder, JoinPath(Folder->lpPath, FindData.cFileName));
+					}
+				}
+			} while(FindNextFile(Handle, &FindData));
+
+			FindClose(Handle);
+		}
+
+		free(lpSearchString);
+	}
+
+	lpSearchString = JoinPath(Folder->lpPath, Folder->lpWildcard);
+
+	Handle = FindFirstFile(lpSearchString, &FindData);
+
+	if(Handle != INVALID_HANDLE_VALUE)
+	{
+		do
+		{
+			if(stricmp(FindData.cFileName, ".") != 0 && stricmp(FindData.cFileName, "..") != 0)
+			{
+				if((FindData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == 0)
+				{
+					AddFile(Folder, JoinPath(Folder->lpPath, FindData.cFileName));
+				}
+			}
+		} while(FindNextFile(Handle, &FindData));
+
+		FindClose(Handle);
+	}
+
+	free(lpSearchString);
+#else
+	vlChar *lpPath;
+
+	DIR *Directory;
+	struct dirent *Entry;
+	struct stat Stat;
+
+	if((Directory = opendir(Folder->lpPath)) == 0)
+	{
+		return;
+	}
+
+	while((Entry = readdir(Directory)) != 0)
+	{
+		if(strcmp(Entry->d_name, ".") == 0 || strcmp(Entry->d_name, "..") == 0)
+		{
+			continue;
+		}
+
+		lpPath = JoinPath(Folder->lpPath, Entry->d_name);
+
+		if(stat(lpPath, &Stat) != 0)
+		{
+			free(lpPath);
+		}
+		else if(S_ISDIR(Stat.st_mode))
+		{
+			if(bRecursive)
+			{
+				AddSubFolder(Folder, lpPath);
+			}
+			else
+			{
+				free(lpPath);
+			}
+		}
+		else if(MatchWildcard(Folder->lpWildcard, Entry->d_name))
+		{
+			AddFile(Folder, lpPath);
+		}
+		else
+		{
+			free(lpPath);
+		}
+	}
+
+	closedir(Directory);
+
+	if(Folder->uiFileCount > 1)
+	{
+		qsort(Folder->lpFiles, Folder->uiFileCount, sizeof(vlChar *), ComparePaths);
+	}
+	if(Folder->uiFolderCount > 1)
+	{
+		qsort(Folder->lpFolders, Folder->uiFolderCount, sizeof(SFolder *), CompareFolders);
+	}
+#endif
+}
+
+//
+// ListLevel()
+// RunWorkers() callback to list one folder of the current level.  Listing
+// needs no images, so the worker goes unused.
+//
+void ListLevel(SWorker *Worker, vlUInt uiIndex)
+{
+	(void)Worker;
+
+	ListFolder(lpLevel[uiIndex]);
+}
+
+//
+// WalkFolders()
+// List every folder a level at a time, each level in parallel.
+//
+void WalkFolders(SFolder **lpRoots, vlUInt uiRootCount)
+{
+	vlUInt i, j;
+
+	SFolder **lpNext = 0;
+	vlUInt uiNextCount, uiNextSize = 0;
+	vlUInt uiLevelSize = 0;
+
+	if(uiRootCount == 0)
+	{
+		return;
+	}
+
+	lpLevel = Reserve(lpLevel, uiRootCount, &uiLevelSize, sizeof(SFolder *));
+	memcpy(lpLevel, lpRoots, uiRootCount * sizeof(SFolder *));
+	uiLevelCount = uiRootCount;
+
+	while(uiLevelCount != 0)
+	{
+		RunWorkers(ListLevel, uiLevelCount);
+
+		// The sub folders found make up the next level.
+		uiNextCount = 0;
+		for(i = 0; i < uiLevelCount; i++)
+		{
+			lpNext = Reserve(lpNext, uiNextCount + lpLevel[i]->uiFolderCount, &uiNextSize, sizeof(SFolder *));
+			for(j = 0; j < lpLevel[i]->uiFolderCount; j++)
+			{
+				lpNext[uiNextCount++] = lpLevel[i]->lpFolders[j];
+			}
+		}
+
+		lpLevel = Reserve(lpLevel, uiNextCount, &uiLevelSize, sizeof(SFolder *));
+		if(uiNextCount != 0)
+		{
+			memcpy(lpLevel, lpNext, uiNextCount * sizeof(SFolder *));
+		}
+		uiLevelCount = uiNextCount;
+	}
+
+	free(lpNext);
+	free(lpLevel);
+	lpLevel = 0;
+}
+
+//
+// AddJob()
+// Queue a file, or a folder message, for output.
+//
+void AddJob(JobType Type, vlChar *lpPath)
+{
+	lpJobs = Reserve(lpJobs, uiJobCount + 1, &uiJobSize, sizeof(SJob));
+
+	lpJobs[uiJobCount].Type = Type;
+	lpJobs[uiJobCount].lpPath = lpPath;
+	lpJobs[uiJobCount].lpFullPath = Type == JOB_FILE && lpManifestFile != 0 ? GetFullPath(lpPath) : 0;
+	lpJobs[uiJobCount].lpLog = 0;
+	lpJobs[uiJobCount].bDone = Type != JOB_FILE;
+	lpJobs[uiJobCount].bCompleted = vlFalse;
+	lpJobs[uiJobCount].bSkipped = vlFalse;
+	memset(&lpJobs[uiJobCount].Entry, 0, sizeof(SManifestEntry));
+
+	uiJobCount++;
+}
+
+//
+// AddFolderJobs()
+// Queue a walked folder in the order a serial walk would process it: sub
+// folders first, then files.
+//
+void AddFolderJobs(SFolder *Folder)
+{
+	vlUInt i;
+
+	AddJob(JOB_FOLDER_BEGIN, Folder->lpPath);
+
+	for(i = 0; i < Folder->uiFolderCount; i++)
+	{
+		AddFolderJobs(Folder->lpFolders[i]);
+	}
+
+	for(i = 0; i < Folder->uiFileCount; i++)
+	{
+		AddJob(JOB_FILE, Folder->lpFiles[i]);
+	}
+
+	AddJob(JOB_FOLDER_END, Folder->lpPath);
+}
+
+//
+// FlushJobs()
+// Print every finished job that has no unfinished job before it.  PrintLock
+// must be held.
+//
+void FlushJobs()
+{
+	SJob *Job;
+
+	while(uiNextPrint < uiJobCount && lpJobs[uiNextPrint].bDone)
+	{
+		Job = &lpJobs[uiNextPrint++];
+
+		switch(Job->Type)
+		{
+		case JOB_FILE:
+			if(Job->lpLog != 0)
+			{
+				Print("%s", Job->lpLog);
+				free(Job->lpLog);
+				Job->lpLog = 0;
+			}
+
+			if(Job->bSkipped)
+			{
+				uiSkipped++;
+				break;
+			}
+
+			uiProcessed++;
+			if(Job->bCompleted)
+			{
+				uiCompleted++;
+			}
+			break;
+		case JOB_FOLDER_BEGIN:
+			Print("Processing %s%c...\n\n", Job->lpPath, PATH_SEPARATOR);
+			break;
+		case JOB_FOLDER_END:
+			Print("%s%c processed.\n\n", Job->lpPath, PATH_SEPARATOR);
+			break;
+		case JOB_DUPLICATE:
+			break;
+		}
+	}
+
+	fflush(stdout);
+}
+
+//
+// HashBytes(), HashString()
+// 64 bit FNV-1a.
+//
+vlUInt64 HashBytes(vlUInt64 uiHash, const vlVoid *lpData, vlUInt uiSize)
+{
+	const vlByte *lpBytes = (const vlByte *)lpData;
+	const vlUInt64 uiPrime = ((vlUInt64)0x00000100 << 32) | 0x000001b3;
+
+	while(uiSize-- != 0)
+	{
+		uiHash = (uiHash ^ *lpBytes++) * uiPrime;
+	}
+
+	return uiHash;
+}
+
+vlUInt64 HashString(vlUInt64 uiHash, const vlChar *lpString)
+{
+	if(lpString == 0)
+	{
+		lpString = "";
+	}
+
+	// Include the terminator so adjacent strings can't run together.
+	return HashBytes(uiHash, lpString, (vlUInt)strlen(lpString) + 1);
+}
+
+//
+// HashFile()
+// Hash the contents of a file.
+//
+vlBool HashFile(const vlChar *lpPath, vlUInt64 *uiHash)
+{
+	FILE *File;
+	vlByte lpBuffer[65536];
+	size_t uiRead;
+
+	if((File = fopen(lpPath, "rb")) == 0)
+	{
+		return vlFalse;
+	}
+
+	*uiHash = HASH_BASIS;
+	while((uiRead = fread(lpBuffer, 1, sizeof(lpBuffer), File)) != 0)
+	{
+		*uiHash = HashBytes(*uiHash, lpBuffer, (vlUInt)uiRead);
+	}
+
+	fclose(File);
+
+	return vlTrue;
+}
+
+//
+// GetFileInfo()
+// Get the size and modification time of a file.
+//
+vlBool GetFileInfo(const vlChar *lpPath, vlUInt64 *uiSize, vlUInt64 *uiTime)
+{
+#ifdef _WIN32
+	WIN32_FILE_ATTRIBUTE_DATA Data;
+
+	if(!GetFileAttributesEx(lpPath, GetFileExInfoStandard, &Data))
+	{
+		return vlFalse;
+	}
+
+	*uiSize = ((vlUInt64)Data.nFileSizeHigh << 32) | Data.nFileSizeLow;
+	*uiTime = ((vlUInt64)Data.ftLastWriteTime.dwHighDateTime << 32) | Data.ftLastWriteTime.dwLowDateTime;
+#else
+	struct stat Stat;
+
+	if(stat(lpPath, &Stat) != 0)
+	{
+		return vlFalse;
+	}
+
+	*uiSize = (vlUInt64)Stat.st_size;
+#if defined(_POSIX_C_SOURCE) && _POSIX_C_SOURCE >= 200809L
+	*uiTime = (vlUInt64)Stat.st_mtim.tv_sec * 1000000000 + (vlUInt64)Stat.st_mtim.tv_nsec;
+#else
+	*uiTime = (vlUInt64)Stat.st_mtime;
+#endif
+#endif
+
+	return vlTrue;
+}
+
+//
+// ComparePath()
+// Compare paths the way the file system does.
+//
+int ComparePath(const vlChar *lpLeft, const vlChar *lpRight)
+{
+#ifdef _WIN32
+	return stricmp(lpLeft, lpRight);
+#else
+	return strcmp(lpLeft, lpRight);
+#endif
+}
+
+//
+// IsInFolder()
+// Check the full path lpPath is somewhere under the full path lpFolder.
+//
+vlBool IsInFolder(const vlChar *lpPath, const vlChar *lpFolder)
+{
+	size_t uiLength = strlen(lpFolder);
+
+	if(uiLength == 0)
+	{
+		return vlFalse;
+	}
+
+#ifdef _WIN32
+	if(strnicmp(lpPath, lpFolder, uiLength) != 0)
+	{
+		return vlFalse;
+	}
+
+	// A drive root keeps its separator.
+	return lpFolder[uiLength - 1] == '\\' || lpFolder[uiLength - 1] == '/' || lpPath[uiLength] == '\\' || lpPath[uiLength] == '/';
+#else
+	if(strncmp(lpPath, lpFolder, uiLength) != 0)
+	{
+		return vlFalse;
+	}
+
+	return lpFolder[uiLength - 1] == '/' || lpPath[uiLength] == '/';
+#endif
+}
+
+int CompareEntries(const void *lpLeft, const void *lpRight)
+{
+	return ComparePath(((const SManifestEntry *)lpLeft)->lpInput, ((const SManifestEntry *)lpRight)->lpInput);
+}
+
+int CompareOutputs(const void *lpLeft, const void *lpRight)
+{
+	return ComparePath(*(const vlChar **)lpLeft, *(const vlChar **)lpRight);
+}
+
+//
+// FindEntry()
+// Find the manifest entry for an input file, or 0 if it has none.
+//
+SManifestEntry *FindEntry(const vlChar *lpInput)
+{
+	SManifestEntry Key;
+
+	if(uiManifestCount == 0)
+	{
+		return 0;
+	}
+
+	Key.lpInput = (vlChar *)lpInput;
+
+	return bsearch(&Key, lpManifest, uiManifestCount, sizeof(SManifestEntry), CompareEntries);
+}
+
+//
+// NextOutput()
+// Allocate a copy of the next path from a tab separated output list, or
+// return 0 at the end of the list.
+//
+vlChar *NextOutput(const vlChar **lpOutputs)
+{
+	const vlChar *lpEnd;
+	vlChar *lpPath;
+	vlUInt uiLength;
+
+	if(**lpOutputs == '\0')
+	{
+		return 0;
+	}
+
+	if((lpEnd = strchr(*lpOutputs, '\t')) == 0)
+	{
+		lpEnd = *lpOutputs + strlen(*lpOutputs);
+	}
+
+	uiLength = (vlUInt)(lpEnd - *lpOutputs);
+
+	lpPath = malloc(uiLength + 1);
+	if(lpPath == 0)
+	{
+		printf("Out of memory.\n");
+		exit(1);
+	}
+
+	memcpy(lpPath, *lpOutputs, uiLength);
+	lpPath[uiLength] = '\0';
+
+	*lpOutputs = *lpEnd == '\t' ? lpEnd + 1 : lpEnd;
+
+	return lpPath;
+}
+
+//
+// AddOutput()
+// Record a file written for the current input.
+//
+void AddOutput(SWorker *Worker, const vlChar *lpPath)
+{
+	vlChar *lpFullPath;
+	vlUInt uiLength;
+
+	if(lpManifestFile == 0)
+	{
+		return;
+	}
+
+	lpFullPath = GetFullPath(lpPath);
+	uiLength = (vlUInt)strlen(lpFullPath);
+
+	Worker->lpOutputs = Reserve(Worker->lpOutputs, Worker->uiOutputsLength + uiLength + 2, &Worker->uiOutputsSize, sizeof(vlChar));
+
+	if(Worker->uiOutputsLength != 0)
+	{
+		Worker->lpOutputs[Worker->uiOutputsLength++] = '\t';
+	}
+
+	strcpy(Worker->lpOutputs + Worker->uiOutputsLength, lpFullPath);
+	Worker->uiOutputsLength += uiLength;
+
+	free(lpFullPath);
+}
+
+//
+// IsUpToDate()
+// Check an input's outputs were made from it as it is now, with the same
+// settings.  The contents are only hashed if the size matches but the time
+// doesn't, e.g. after a checkout; bHashed says if uiHash was set.
+//
+vlBool IsUpToDate(const SManifestEntry *Entry, const vlChar *lpInput, vlUInt64 uiSize, vlUInt64 uiTime, vlUInt64 *uiHash, vlBool *bHashed)
+{
+	const vlChar *lpOutputs;
+	vlChar *lpPath;
+	vlBool bFound;
+
+	if(Entry->uiSettings != uiSettings || Entry->uiVersion != vlGetVersion() || Entry->uiSize != uiSize)
+	{
+		return vlFalse;
+	}
+
+	if(Entry->uiTime != uiTime)
+	{
+		*bHashed = HashFile(lpInput, uiHash);
+		if(!*bHashed || *uiHash != Entry->uiHash)
+		{
+			return vlFalse;
+		}
+	}
+
+	for(lpOutputs = Entry->lpOutputs; (lpPath = NextOutput(&lpOutputs)) != 0; )
+	{
+		bFound = GetPathType(lpPath) != 0;
+		free(lpPath);
+
+		if(!bFound)
+		{
+			return vlFalse;
+		}
+	}
+
+	return vlTrue;
+}
+
+//
+// ParseHex()
+// Parse a 64 bit hexadecimal field.
+//
+vlBool ParseHex(const vlChar *lpString, vlUInt64 *uiValue)
+{
+	vlUInt uiDigit;
+
+	*uiValue = 0;
+	for(; *lpString != '\0'; lpString++)
+	{
+		if(*lpString >= '0' && *lpString <= '9')
+		{
+			uiDigit = *lpString - '0';
+		}
+		else if(*lpString >= 'a' && *lpString <= 'f')
+		{
+			uiDigit = *lpString - 'a' + 10;
+		}
+		else
+		{
+			return vlFalse;
+		}
+
+		*uiValue = (*uiValue << 4) | uiDigit;
+	}
 
-VTFImageFormat AlphaFormat = IMAGE_FORMAT_DXT5;		// VTF image format for alpha textures.
-VTFImageFormat NormalFormat = IMAGE_FORMAT_DXT1;	// VTF image format for non-alpha textures.
-SVTFCreateOptions CreateOptions;					// VTF creation options.
-vlChar *lpShader = 0;								// VMT shader to use.
-vlUInt uiParameterCount = 0;
-vlChar *lpParameters[MAX_ITEMS][2];					// VMT parameters.
-vlChar *lpExportFormat = "tga";						// Format extension for exporting VTF images.
+	return vlTrue;
+}
 
-void Pause();
-void Print(const vlChar *lpFormat, ...);
-void PrintUsage(const vlChar *lpError, ...);
+//
+// LoadManifest()
+// Read the manifest left by the last run.  A missing or unreadable manifest
+// just means everything is converted.
+//
+void LoadManifest()
+{
+	FILE *File;
+	long lSize;
+	vlChar *lpLine, *lpNext, *lpFields[7];
+	vlUInt i, uiSize = 0;
+	vlUInt64 uiVersion;
+	SManifestEntry Entry;
+
+	if((File = fopen(lpManifestFile, "rb")) == 0)
+	{
+		return;
+	}
+
+	fseek(File, 0, SEEK_END);
+	lSize = ftell(File);
+	fseek(File, 0, SEEK_SET);
+
+	if(lSize <= 0 || (lpManifestData = malloc(lSize + 1)) == 0 || fread(lpManifestData, 1, lSize, File) != (size_t)lSize)
+	{
+		fclose(File);
+		return;
+	}
+	lpManifestData[lSize] = '\0';
+
+	fclose(File);
+
+	for(lpLine = lpManifestData; lpLine != 0 && *lpLine != '\0'; lpLine = lpNext)
+	{
+		if((lpNext = strchr(lpLine, '\n')) != 0)
+		{
+			*lpNext++ = '\0';
+		}
+		if(*lpLine != '\0' && lpLine[strlen(lpLine) - 1] == '\r')
+		{
+			lpLine[strlen(lpLine) - 1] = '\0';
+		}
+
+		if(lpLine == lpManifestData)
+		{
+			// A manifest from another version is ignored.
+			if(strcmp(lpLine, MANIFEST_HEADER) != 0)
+			{
+				break;
+			}
+			continue;
+		}
 
-void ProcessFile(vlChar *lpInputFile);
-void ProcessFolder(vlChar *lpInputFolder, vlChar *lpWildcard);
+		// The output root comes next; nothing outside it is ever deleted.
+		if(lpManifestRoot == 0)
+		{
+			lpManifestRoot = lpLine;
+			continue;
+		}
+
+		// input, size, time, hash, settings, version, outputs...
+		lpFields[0] = lpLine;
+		for(i = 1; i < 7 && (lpFields[i] = strchr(lpFields[i - 1], '\t')) != 0; i++)
+		{
+			*lpFields[i]++ = '\0';
+		}
+
+		if(i < 7 || !ParseHex(lpFields[1], &Entry.uiSize) || !ParseHex(lpFields[2], &Entry.uiTime) || !ParseHex(lpFields[3], &Entry.uiHash) || !ParseHex(lpFields[4], &Entry.uiSettings) || !ParseHex(lpFields[5], &uiVersion))
+		{
+			continue;
+		}
+
+		Entry.lpInput = lpFields[0];
+		Entry.uiVersion = (vlUInt)uiVersion;
+		Entry.lpOutputs = lpFields[6];
+		Entry.bSeen = vlFalse;
+
+		lpManifest = Reserve(lpManifest, uiManifestCount + 1, &uiSize, sizeof(SManifestEntry));
+		lpManifest[uiManifestCount++] = Entry;
+	}
+
+	qsort(lpManifest, uiManifestCount, sizeof(SManifestEntry), CompareEntries);
+}
 
 //
-// stristr()
-// Case insensitive version of strstr().
+// SaveManifest()
+// Write the manifest for this run and delete outputs that no input makes
+// any more: those of inputs that have gone, and old outputs of inputs that
+// now make different ones.  Only outputs under the output root the last run
+// recorded are deleted.
 //
-char *stristr(const char *string, const char *strSearch)
+void SaveManifest()
 {
-	const char *ptr = string;
-	const char *ptr2;
+	vlUInt i;
 
-    while(1)
+	SManifestEntry *lpEntries, *Entry;
+	vlUInt uiEntryCount = 0, uiEntrySize = 0;
+	vlChar **lpClaimed = 0;
+	vlUInt uiClaimedCount = 0, uiClaimedSize = 0;
+
+	const vlChar *lpOutputs;
+	vlChar *lpPath;
+	vlChar *lpTempFile;
+	FILE *File;
+
+	lpEntries = Reserve(0, uiJobCount + uiManifestCount + 1, &uiEntrySize, sizeof(SManifestEntry));
+
+	// This run's files.
+	for(i = 0; i < uiJobCount; i++)
 	{
-		ptr = strchr(string, toupper(*strSearch));
-		ptr2 = strchr(string, tolower(*strSearch));
+		if(lpJobs[i].Type != JOB_FILE)
+		{
+			continue;
+		}
 
-		if(ptr == 0)
+		if((Entry = FindEntry(lpJobs[i].lpFullPath)) != 0)
 		{
-			ptr = ptr2;
+			Entry->bSeen = vlTrue;
 		}
-		if(ptr == 0)
+
+		if(lpJobs[i].Entry.lpInput != 0)
 		{
-			break;
+			lpEntries[uiEntryCount++] = lpJobs[i].Entry;
 		}
-		if(ptr2 && (ptr2 < ptr))
+		else if(Entry != 0)
 		{
-			ptr = ptr2;
+			// Failed, keep its outputs but convert it again next time.
+			lpEntries[uiEntryCount] = *Entry;
+			lpEntries[uiEntryCount].uiSize = lpEntries[uiEntryCount].uiTime = lpEntries[uiEntryCount].uiHash = 0;
+			uiEntryCount++;
 		}
-		if(!strnicmp(ptr, strSearch, strlen(strSearch)))
+	}
+
+	// Files from other runs that are still there.
+	for(i = 0; i < uiManifestCount; i++)
+	{
+		if(!lpManifest[i].bSeen && GetPathType(lpManifest[i].lpInput) != 0)
 		{
-			return (char *)ptr;
+			lpEntries[uiEntryCount++] = lpManifest[i];
 		}
+	}
 
-		string = ptr + 1;
-    }
+	qsort(lpEntries, uiEntryCount, sizeof(SManifestEntry), CompareEntries);
 
-    return 0;
+	// Delete old outputs nothing claims.
+	for(i = 0; i < uiEntryCount; i++)
+	{
+		for(lpOutputs = lpEntries[i].lpOutputs; (lpPath = NextOutput(&lpOutputs)) != 0; )
+		{
+			lpClaimed = Reserve(lpClaimed, uiClaimedCount + 1, &uiClaimedSize, sizeof(vlChar *));
+			lpClaimed[uiClaimedCount++] = lpPath;
+		}
+	}
+
+	if(uiClaimedCount != 0)
+	{
+		qsort(lpClaimed, uiClaimedCount, sizeof(vlChar *), CompareOutputs);
+	}
+
+	for(i = 0; i < uiManifestCount; i++)
+	{
+		for(lpOutputs = lpManifest[i].lpOutputs; (lpPath = NextOutput(&lpOutputs)) != 0; )
+		{
+			if(IsInFolder(lpPath, lpManifestRoot) && (uiClaimedCount == 0 || bsearch(&lpPath, lpClaimed, uiClaimedCount, sizeof(vlChar *), CompareOutputs) == 0) && remove(lpPath) == 0)
+			{
+				Print("Deleted %s.\n", lpPath);
+				uiDeleted++;
+			}
+
+			free(lpPath);
+		}
+	}
+
+	for(i = 0; i < uiClaimedCount; i++)
+	{
+		free(lpClaimed[i]);
+	}
+	free(lpClaimed);
+
+	// Write the new manifest beside the old one and swap it in, so a failed
+	// write never loses the old one.
+	lpTempFile = malloc(strlen(lpManifestFile) + 5);
+	if(lpTempFile == 0)
+	{
+		free(lpEntries);
+		return;
+	}
+	sprintf(lpTempFile, "%s.tmp", lpManifestFile);
+
+	if((File = fopen(lpTempFile, "wb")) == 0)
+	{
+		Print("Error writing %s.\n", lpTempFile);
+		free(lpTempFile);
+		free(lpEntries);
+		return;
+	}
+
+	fprintf(File, "%s\n%s\n", MANIFEST_HEADER, lpOutputRoot);
+	for(i = 0; i < uiEntryCount; i++)
+	{
+		Entry = &lpEntries[i];
+		fprintf(File, "%s\t%08x%08x\t%08x%08x\t%08x%08x\t%08x%08x\t%x\t%s\n", Entry->lpInput,
+			(vlUInt)(Entry->uiSize >> 32), (vlUInt)Entry->uiSize,
+			(vlUInt)(Entry->uiTime >> 32), (vlUInt)Entry->uiTime,
+			(vlUInt)(Entry->uiHash >> 32), (vlUInt)Entry->uiHash,
+			(vlUInt)(Entry->uiSettings >> 32), (vlUInt)Entry->uiSettings,
+			Entry->uiVersion, Entry->lpOutputs);
+	}
+
+	if(fclose(File) != 0)
+	{
+		Print("Error writing %s.\n", lpTempFile);
+		remove(lpTempFile);
+	}
+#ifdef _WIN32
+	else if(!MoveFileEx(lpTempFile, lpManifestFile, MOVEFILE_REPLACE_EXISTING))
+#else
+	else if(rename(lpTempFile, lpManifestFile) != 0)
+#endif
+	{
+		Print("Error writing %s.\n", lpManifestFile);
+		remove(lpTempFile);
+	}
+
+	free(lpTempFile);
+	free(lpEntries);
 }
 
 //
-// strrpl()
-// Replace a char in a string with another.
+// A job's main output, for finding jobs that would write the same file.
 //
-void strrpl(char *string, char chr, char rplChr)
+typedef struct tagSJobOutput
 {
-	while(*string != 0)
+	vlChar *lpOutput;
+	vlUInt uiJob;
+} SJobOutput;
+
+int CompareJobOutputs(const void *lpLeft, const void *lpRight)
+{
+	const SJobOutput *Left = (const SJobOutput *)lpLeft, *Right = (const SJobOutput *)lpRight;
+	int iResult = ComparePath(Left->lpOutput, Right->lpOutput);
+
+	return iResult != 0 ? iResult : (Left->uiJob > Right->uiJob) - (Left->uiJob < Right->uiJob);
+}
+
+//
+// DropDuplicateJobs()
+// Keep two jobs from writing the same file at once.  The first job queued
+// for an output keeps it; the same file queued again is left out, and a
+// different file that would make the same output fails.
+//
+void DropDuplicateJobs()
+{
+	SJobOutput *lpOutputs;
+	vlUInt i, uiCount = 0, uiFirst = 0;
+	const vlChar *lpExtension;
+	SJob *Job, *First;
+
+	lpOutputs = malloc((uiJobCount + 1) * sizeof(SJobOutput));
+	if(lpOutputs == 0)
 	{
-		if(*string == chr)
-			*string = rplChr;
-		string++;
+		Print("Out of memory.\n");
+		exit(1);
+	}
+
+	// ProcessFile() exports .vtf files and converts everything else to one.
+	for(i = 0; i < uiJobCount; i++)
+	{
+		if(lpJobs[i].Type == JOB_FILE)
+		{
+			lpExtension = strrchr(lpJobs[i].lpPath, '.');
+			lpOutputs[uiCount].lpOutput = CreateOutputPath(lpJobs[i].lpPath, lpExtension != 0 && stricmp(lpExtension, ".vtf") == 0 ? lpExportFormat : "vtf");
+			lpOutputs[uiCount].uiJob = i;
+			uiCount++;
+		}
+	}
+
+	qsort(lpOutputs, uiCount, sizeof(SJobOutput), CompareJobOutputs);
+
+	for(i = 0; i < uiCount; i++)
+	{
+		if(i == 0 || ComparePath(lpOutputs[i].lpOutput, lpOutputs[uiFirst].lpOutput) != 0)
+		{
+			uiFirst = i;
+			continue;
+		}
+
+		Job = &lpJobs[lpOutputs[i].uiJob];
+		First = &lpJobs[lpOutputs[uiFirst].uiJob];
+
+		if(ComparePath(Job->lpPath, First->lpPath) == 0)
+		{
+			Job->Type = JOB_DUPLICATE;
+			Job->bDone = vlTrue;
+			continue;
+		}
+
+		Job->lpLog = malloc(strlen(Job->lpPath) + strlen(lpOutputs[i].lpOutput) + strlen(First->lpPath) + 64);
+		if(Job->lpLog == 0)
+		{
+			Print("Out of memory.\n");
+			exit(1);
+		}
+		sprintf(Job->lpLog, "Processing %s...\n Error: %s is already made from %s.\n\n", Job->lpPath, lpOutputs[i].lpOutput, First->lpPath);
+
+		Job->bDone = vlTrue;
+	}
+
+	for(i = 0; i < uiCount; i++)
+	{
+		free(lpOutputs[i].lpOutput);
+	}
+	free(lpOutputs);
+}
+
+//
+// ProcessJob()
+// RunWorkers() callback to convert one queued file.  With a manifest, files
+// whose outputs are up to date are skipped, and what was made is recorded.
+//
+void ProcessJob(SWorker *Worker, vlUInt uiIndex)
+{
+	SJob *Job = &lpJobs[uiIndex];
+	SManifestEntry *Entry;
+	vlUInt64 uiSize, uiTime, uiHash = 0;
+	vlBool bHashed = vlFalse, bInfo = vlFalse, bCompleted;
+
+	// Jobs that would overwrite another's output are already done.
+	if(Job->Type != JOB_FILE || Job->bDone)
+	{
+		return;
+	}
+
+	if(lpManifestFile != 0)
+	{
+		bInfo = GetFileInfo(Job->lpPath, &uiSize, &uiTime);
+
+		if(bInfo && (Entry = FindEntry(Job->lpFullPath)) != 0 && IsUpToDate(Entry, Job->lpPath, uiSize, uiTime, &uiHash, &bHashed))
+		{
+			// Keep the new time so the contents aren't hashed again next run.
+			Job->Entry = *Entry;
+			Job->Entry.lpInput = Job->lpFullPath;
+			Job->Entry.uiTime = uiTime;
+			Job->bSkipped = vlTrue;
+
+			EnterLock(&PrintLock);
+			Job->bDone = vlTrue;
+			FlushJobs();
+			LeaveLock(&PrintLock);
+			return;
+		}
+
+		if(bInfo && !bHashed)
+		{
+			bHashed = HashFile(Job->lpPath, &uiHash);
+		}
+	}
+
+	Worker->uiOutputsLength = 0;
+	if(Worker->lpOutputs != 0)
+	{
+		*Worker->lpOutputs = '\0';
+	}
+
+	bCompleted = ProcessFile(Worker, Job->lpPath);
+
+	if(bCompleted && bHashed && Worker->lpOutputs != 0)
+	{
+		// The outputs now belong to the job.
+		Job->Entry.lpInput = Job->lpFullPath;
+		Job->Entry.uiSize = uiSize;
+		Job->Entry.uiTime = uiTime;
+		Job->Entry.uiHash = uiHash;
+		Job->Entry.uiSettings = uiSettings;
+		Job->Entry.uiVersion = vlGetVersion();
+		Job->Entry.lpOutputs = Worker->lpOutputs;
+
+		Worker->lpOutputs = 0;
+		Worker->uiOutputsLength = 0;
+		Worker->uiOutputsSize = 0;
 	}
+
+	EnterLock(&PrintLock);
+
+	Job->lpLog = Worker->lpLog;
+	Job->bCompleted = bCompleted;
+	Job->bDone = vlTrue;
+
+	FlushJobs();
+
+	LeaveLock(&PrintLock);
+
+	// The log now belongs to the job.
+	Worker->lpLog = 0;
+	Worker->uiLogLength = 0;
+	Worker->uiLogSize = 0;
 }
 
 int main(int argc, char* argv[])
 {
 	int i;
+	vlChar *lpFolder;					// Holds folder path for folder searches.
 	vlChar *lpWildcard;					// Holds wildcard string for folder searches.
+	SFolder **lpRoots;					// Folders to walk.
 
 	VTFImageFormat ImageFormat;			// Temp variable for string to VTFImageFormat test.
 	VTFImageFlag ImageFlag;				// Temp variable for string to VTFImageFlag test.
@@ -129,8 +1646,7 @@ int main(int argc, char* argv[])
 	VTFHeightConversionMethod HeightConversionMethod;	// Temp variable for string to VTFHeightConversionMethod test.
 	VTFNormalAlphaResult NormalAlphaResult;				// Temp variable for string to VTFNormalAlphaResult test.
 
-	WIN32_FIND_DATA FindData;
-	HANDLE Handle;
+	SVTFLibOptions Options;				// VTFLib options for each worker context.
 
 	// Check we have the right DLL version.
 	if(vlGetVersion() != VL_VERSION)
@@ -142,6 +1658,17 @@ int main(int argc, char* argv[])
 	// Fill in our CreateOptions struct with VTFLib defaults.
 	vlImageCreateDefaultCreateStructure(&CreateOptions);
 
+	// No option takes more than one of these per argument.
+	lpFiles = malloc(argc * sizeof(vlChar *));
+	lpFolders = malloc(argc * sizeof(vlChar *));
+	lpParameters = malloc(argc * sizeof(*lpParameters));
+
+	if(lpFiles == 0 || lpFolders == 0 || lpParameters == 0)
+	{
+		Print("Out of memory.\n");
+		return 1;
+	}
+
 	// Grab command arguments.
 	switch(argc)
 	{
@@ -151,24 +1678,22 @@ int main(int argc, char* argv[])
 		break;
 	case 2:
 		// If only one argument assume drag and drop.
-		Handle = FindFirstFile(argv[1], &FindData);
-
-		if(Handle != INVALID_HANDLE_VALUE)
+		switch(GetPathType(argv[1]))
 		{
-			if(FindData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
-			{
-				lpFolders[uiFolderCount++] = argv[1];
-				CreateOptions.bResize = vlTrue;
-				bPause = vlTrue;
-			}
-			else
-			{
-				lpFiles[uiFileCount++] = argv[1];
-				CreateOptions.bResize = vlTrue;
-				bPause = vlTrue;
-			}
+		case 2:
+			lpFolders[uiFolderCount++] = argv[1];
+			CreateOptions.bResize = vlTrue;
+			bPause = vlTrue;
+			break;
+		case 1:
+			lpFiles[uiFileCount++] = argv[1];
+			CreateOptions.bResize = vlTrue;
+			bPause = vlTrue;
+			break;
+		}
 
-			FindClose(Handle);
+		if(uiFileCount != 0 || uiFolderCount != 0)
+		{
 			break;
 		}
 		// Fall through.
@@ -177,7 +1702,7 @@ int main(int argc, char* argv[])
 		{
 			if(stricmp(argv[i], "-file") == 0)
 			{
-				if(i + 1 < argc && uiFileCount < MAX_ITEMS)
+				if(i + 1 < argc)
 				{
 					lpFiles[uiFileCount++] = argv[++i];
 				}
@@ -189,7 +1714,7 @@ int main(int argc, char* argv[])
 			}
 			else if(stricmp(argv[i], "-folder") == 0)
 			{
-				if(i + 1 < argc && uiFolderCount < MAX_ITEMS)
+				if(i + 1 < argc)
 				{
 					lpFolders[uiFolderCount++] = argv[++i];
 				}
@@ -256,6 +1781,7 @@ int main(int argc, char* argv[])
 					if(ImageFormat != IMAGE_FORMAT_COUNT)
 					{
 						NormalFormat = ImageFormat;
+						bDecodeDDS = vlTrue;
 					}
 					else
 					{
@@ -277,6 +1803,7 @@ int main(int argc, char* argv[])
 					if(ImageFormat != IMAGE_FORMAT_COUNT)
 					{
 						AlphaFormat = ImageFormat;
+						bDecodeDDS = vlTrue;
 					}
 					else
 					{
@@ -511,6 +2038,7 @@ int main(int argc, char* argv[])
 			else if(stricmp(argv[i], "-normal") == 0)
 			{
 				CreateOptions.bNormalMap = vlTrue;
+				bDecodeDDS = vlTrue;
 			}
 			else if(stricmp(argv[i], "-nkernel") == 0)
 			{
@@ -611,6 +2139,10 @@ int main(int argc, char* argv[])
 			{
 				CreateOptions.bReflectivity = vlFalse;
 			}
+			else if(stricmp(argv[i], "-crc") == 0)
+			{
+				bWriteCRC = vlTrue;
+			}
 			else if(stricmp(argv[i], "-shader") == 0)
 			{
 				if(i + 1 < argc)
@@ -642,6 +2174,30 @@ int main(int argc, char* argv[])
 			{
 				bRecursive = vlTrue;
 			}
+			else if(stricmp(argv[i], "-threads") == 0)
+			{
+				if(i + 1 < argc && sscanf(argv[++i], "%u", &uiTemp0) == 1)
+				{
+					uiThreadCount = uiTemp0;
+				}
+				else
+				{
+					PrintUsage("-threads expects unsigned integer argument.");
+					return 2;
+				}
+			}
+			else if(stricmp(argv[i], "-manifest") == 0)
+			{
+				if(i + 1 < argc)
+				{
+					lpManifestFile = argv[++i];
+				}
+				else
+				{
+					PrintUsage("-manifest expects string argument.");
+					return 2;
+				}
+			}
 			else if(stricmp(argv[i], "-silent") == 0)
 			{
 				bSilent = vlTrue;
@@ -680,11 +2236,43 @@ int main(int argc, char* argv[])
 	// Initialize VTFLib.
 	vlInitialize();
 
-	vlCreateImage(&uiVTFImage);
-	vlBindImage(uiVTFImage);
+	vlGetOptions(&Options);
+	Options.bWriteCRC = bWriteCRC;
+
+	if(lpManifestFile != 0)
+	{
+		// Outputs go under the -output folder, or beside their inputs, which are
+		// most likely under the manifest's folder.
+		if(lpOutput != 0 && *lpOutput != '\0')
+		{
+			lpOutputRoot = GetFullPath(lpOutput);
+		}
+		else
+		{
+			lpOutputRoot = GetFullPath(lpManifestFile);
+			*FindFileName(lpOutputRoot) = '\0';
+		}
+
+		// Anything that changes the outputs, or where they go, must be in the hash.
+		uiSettings = HashBytes(HASH_BASIS, &CreateOptions, sizeof(SVTFCreateOptions));
+		uiSettings = HashBytes(uiSettings, &Options, sizeof(SVTFLibOptions));
+		uiSettings = HashBytes(uiSettings, &NormalFormat, sizeof(VTFImageFormat));
+		uiSettings = HashBytes(uiSettings, &AlphaFormat, sizeof(VTFImageFormat));
+		uiSettings = HashBytes(uiSettings, &bDecodeDDS, sizeof(vlBool));
+		uiSettings = HashString(uiSettings, lpShader);
+		for(i = 0; i < (int)uiParameterCount; i++)
+		{
+			uiSettings = HashString(uiSettings, lpParameters[i][0]);
+			uiSettings = HashString(uiSettings, lpParameters[i][1]);
+		}
+		uiSettings = HashString(uiSettings, lpExportFormat);
+		uiSettings = HashString(uiSettings, lpPrefix);
+		uiSettings = HashString(uiSettings, lpPostfix);
+		uiSettings = HashString(uiSettings, lpOutput);
+		uiSettings = HashString(uiSettings, lpOutputRoot);
 
-	vlCreateMaterial(&uiVMTMaterial);
-	vlBindMaterial(uiVMTMaterial);
+		LoadManifest();
+	}
 
 	// Initialize DevIL.
 	ilInit();
@@ -692,28 +2280,77 @@ int main(int argc, char* argv[])
 	ilEnable(IL_ORIGIN_SET);  // Filps images that are upside down (by format).
 	ilOriginFunc(IL_ORIGIN_UPPER_LEFT);
 
-	ilGenImages(1, &uiDevILImage);
-	ilBindImage(uiDevILImage);
+	InitLock(&WorkLock);
+	InitLock(&PrintLock);
+	InitLock(&DevILLock);
 
-	// Process files.
+	// Create the workers, each with its own images.
+	uiWorkerCount = uiThreadCount != 0 ? uiThreadCount : GetProcessorCount();
+
+	lpWorkers = calloc(uiWorkerCount, sizeof(SWorker));
+	if(lpWorkers == 0)
+	{
+		Print("Out of memory.\n");
+		return 1;
+	}
+
+	for(i = 0; i < (int)uiWorkerCount; i++)
+	{
+		if(!vlCreateContext(&lpWorkers[i].Context))
+		{
+			Print("Error creating context:\n%s\n", vlGetLastError());
+			return 1;
+		}
+
+		vlContextSetOptions(lpWorkers[i].Context, &Options);
+
+		vlContextCreateImage(lpWorkers[i].Context, &lpWorkers[i].uiVTFImage);
+		vlContextCreateMaterial(lpWorkers[i].Context, &lpWorkers[i].uiVMTMaterial);
+
+		ilGenImages(1, &lpWorkers[i].uiDevILImage);
+	}
+
+	// Queue files.
 	for(i = 0; i < (int)uiFileCount; i++)
 	{
-		ProcessFile(lpFiles[i]);
+		AddJob(JOB_FILE, lpFiles[i]);
+	}
+
+	// Walk folders.
+	lpRoots = malloc((uiFolderCount + 1) * sizeof(SFolder *));
+	if(lpRoots == 0)
+	{
+		Print("Out of memory.\n");
+		return 1;
 	}
 
-	// Process folders.
-	for(i = 0; i < (int)uiFolderCount; i++)
-	{
-		// Grab the wildcard string from the folder path.
-		if((lpWildcard = strrchr(lpFolders[i], '\\')) == 0)
+	for(i = 0; i < (int)uiFolderCount; i++)
+	{
+		if((lpFolder = strdup(lpFolders[i])) == 0)
+		{
+			Print("Out of memory.\n");
+			return 1;
+		}
+
+		// Grab the wildcard string from the folder path, unless the path is a folder.
+		if(GetPathType(lpFolder) == 2)
+		{
+			// Drop trailing separators, but leave roots such as C:\ alone.
+			while((lpWildcard = FindFileName(lpFolder)) > lpFolder + 1 && *lpWildcard == '\0' && *(lpWildcard - 2) != ':')
+			{
+				*(lpWildcard - 1) = '\0';
+			}
+
+			lpWildcard = "*.*";
+		}
+		else if((lpWildcard = FindFileName(lpFolder)) == lpFolder)
 		{
 			lpWildcard = "*.*";
 		}
 		else
 		{
 			// Wildcard starts after last \ in path.  e.g. C:\input\*.bmp
-			*lpWildcard = '\0';
-			lpWildcard++;
+			*(lpWildcard - 1) = '\0';
 
 			// If there is no wildcard after the last \, use *.* as defult.
 			if(*lpWildcard == '\0')
@@ -722,27 +2359,84 @@ int main(int argc, char* argv[])
 			}
 		}
 
-		ProcessFolder(lpFolders[i], lpWildcard);
+		lpRoots[i] = CreateFolder(lpFolder, lpWildcard);
 	}
 
-	// Shutdown DevIL.
-	ilDeleteImages(1, &uiDevILImage);
+	WalkFolders(lpRoots, uiFolderCount);
 
-	ilShutDown();
+	for(i = 0; i < (int)uiFolderCount; i++)
+	{
+		AddFolderJobs(lpRoots[i]);
+	}
 
-	// Shutdown VTFLib.
-	vlDeleteMaterial(uiVMTMaterial);
+	// Process files.
+	DropDuplicateJobs();
+	RunWorkers(ProcessJob, uiJobCount);
+
+	// Print whatever follows the last file.
+	EnterLock(&PrintLock);
+	FlushJobs();
+	LeaveLock(&PrintLock);
+
+	if(lpManifestFile != 0)
+	{
+		SaveManifest();
+
+		for(i = 0; i < (int)uiJobCount; i++)
+		{
+			if(!lpJobs[i].bSkipped)
+			{
+				free(lpJobs[i].Entry.lpOutputs);
+			}
+			free(lpJobs[i].lpFullPath);
+		}
+		free(lpManifest);
+		free(lpManifestData);
+		free(lpOutputRoot);
+	}
+
+	for(i = 0; i < (int)uiFolderCount; i++)
+	{
+		FreeFolder(lpRoots[i]);
+	}
+	free(lpRoots);
+	free(lpJobs);
+
+	// Shutdown the workers.
+	for(i = 0; i < (int)uiWorkerCount; i++)
+	{
+		ilDeleteImages(1, &lpWorkers[i].uiDevILImage);
+
+		vlContextDeleteMaterial(lpWorkers[i].Context, lpWorkers[i].uiVMTMaterial);
+		vlContextDeleteImage(lpWorkers[i].Context, lpWorkers[i].uiVTFImage);
+
+		vlDeleteContext(lpWorkers[i].Context);
+
+		free(lpWorkers[i].lpLog);
+		free(lpWorkers[i].lpOutputs);
+	}
+	free(lpWorkers);
+
+	DeleteLock(&DevILLock);
+	DeleteLock(&PrintLock);
+	DeleteLock(&WorkLock);
 
-	vlDeleteImage(uiVTFImage);
+	// Shutdown DevIL.
+	ilShutDown();
 
+	// Shutdown VTFLib.
 	vlShutdown();
 
-	Print("%d/%d files completed.\n", uiCompleted, uiProcessed);
+	Print("%u files processed, %u completed, %u failed.\n", uiProcessed, uiCompleted, uiProcessed - uiCompleted);
+	if(lpManifestFile != 0)
+	{
+		Print("%u files up to date, %u outputs deleted.\n", uiSkipped, uiDeleted);
+	}
 
 	// Pause the console.
 	Pause();
 
-	return 0;
+	return uiCompleted == uiProcessed ? 0 : 3;
 }
 
 //
@@ -774,6 +2468,43 @@ void Print(const vlChar *lpFormat, ...)
 	}
 }
 
+//
+// WorkerPrint()
+// Print() to the worker's log, which is written out once every file before
+// it has been, so output from different files never interleaves.
+//
+void WorkerPrint(SWorker *Worker, const vlChar *lpFormat, ...)
+{
+	va_list ArgumentList;
+	int iLength;
+
+	if(bSilent)
+	{
+		return;
+	}
+
+	va_start(ArgumentList, lpFormat);
+#ifdef _WIN32
+	iLength = _vscprintf(lpFormat, ArgumentList);
+#else
+	iLength = vsnprintf(0, 0, lpFormat, ArgumentList);
+#endif
+	va_end(ArgumentList);
+
+	if(iLength <= 0)
+	{
+		return;
+	}
+
+	Worker->lpLog = Reserve(Worker->lpLog, Worker->uiLogLength + (vlUInt)iLength + 1, &Worker->uiLogSize, sizeof(vlChar));
+
+	va_start(ArgumentList, lpFormat);
+	vsprintf(Worker->lpLog + Worker->uiLogLength, lpFormat, ArgumentList);
+	va_end(ArgumentList);
+
+	Worker->uiLogLength += (vlUInt)iLength;
+}
+
 //
 // PrintUsage()
 // Print VTFCmd command line usage help string.
@@ -814,9 +2545,12 @@ void PrintUsage(const vlChar *lpError, ...)
 	Print(" -bumpscale <single>      (Engine bump mapping scale to use.)\n");
 	Print(" -nothumbnail             (Don't generate thumbnail image.)\n");
 	Print(" -noreflectivity          (Don't calculate reflectivity.)\n");
+	Print(" -crc                     (Add an image data CRC, v7.3 and up.)\n");
 	Print(" -shader <string>         (Create a material for the texture.)\n");
 	Print(" -param <string> <string> (Add a parameter to the material.)\n");
 	Print(" -recurse                 (Process directories recursively.)\n");
+	Print(" -threads <integer>       (Files to process at once, 0 for one per processor.)\n");
+	Print(" -manifest <string>       (Skip files unchanged since the run that wrote it.)\n");
 	Print(" -exportformat <string>   (Convert VTF files to the format of this extension.)\n");
 	Print(" -silent                  (Silent mode.)\n");
 	Print(" -pause                   (Pause when done.)\n");
@@ -827,6 +2561,7 @@ void PrintUsage(const vlChar *lpError, ...)
 	Print("vtfcmd.exe -file \"C:\\texture.bmp\" -format \"bgr888\" -normal -postfix \"normal_\"\n");
 	Print("vtfcmd.exe -folder \"C:\\input\\*.tga\" -output \"C:\\output\" -recurse -pause\n");
 	Print("vtfcmd.exe -folder \"C:\\output\\*.vtf\" -output \"C:\\input\" -exportformat \"jpg\"\n");
+	Print("vtfcmd.exe -folder \"C:\\output\\*.vtf\" -output \"C:\\input\" -exportformat \"dds\"\n");
 
 	if(lpError != 0 && !bSilent)
 	{
@@ -842,6 +2577,10 @@ void PrintUsage(const vlChar *lpError, ...)
 
 	if(bHelp)
 	{
+		Print("\n");
+		Print("DDS files are copied to and from VTF surface by surface, with every mipmap,\n");
+		Print("face and frame, when both can hold the format.  Use -format, -alphaformat or\n");
+		Print("-normal to re-encode DDS input instead.\n");
 		Print("\n");
 		Print("Formats: RGBA8888, ABGR8888, RGB888, BGR888, RGB565, I8, IA88, A8,\n");
 		Print("         RGB888_BLUESCREEN, BGR888_BLUESCREEN, ARGB8888, BGRA8888, DXT1,\n");
@@ -883,56 +2622,40 @@ void PrintUsage(const vlChar *lpError, ...)
 
 //
 // CreateOutputPath()
-// Create an output file path from the input file path.
+// Allocate an output file path from the input file path.
 //
-void CreateOutputPath(vlChar *lpOutputFile, vlChar *lpInputFile, vlChar *lpExtension)
+vlChar *CreateOutputPath(const vlChar *lpInputFile, const vlChar *lpExtension)
 {
-	vlChar *lpTemp;
+	const vlChar *lpName = FindFileName((vlChar *)lpInputFile), *lpTemp;
+	vlUInt uiFolderLength, uiNameLength;
+	vlChar *lpOutputFile;
 
-	// Create output file string.
-	if(lpOutput != 0 && *lpOutput != '\0')
-	{
-		// Put the file in the lpOutput directory.
-		sprintf(lpOutputFile, "%s\\", lpOutput);
-	}
-	else
-	{
-		// Put the file in the same directory as the input file.
-		strcpy(lpOutputFile, lpInputFile);
-		if((lpTemp = strrchr(lpOutputFile, '\\')) != 0)
-		{
-			*(lpTemp + 1) = '\0';
-		}
-		else
-		{
-			*lpOutputFile = '\0';
-		}
-	}
+	// Put the file in the lpOutput directory, or the same directory as the input file.
+	uiFolderLength = lpOutput != 0 && *lpOutput != '\0' ? (vlUInt)strlen(lpOutput) + 1 : (vlUInt)(lpName - lpInputFile);
 
-	// Add the prefix to the file name.
-	strcat(lpOutputFile, lpPrefix);
+	// Replace the input file's extension.
+	uiNameLength = (lpTemp = strrchr(lpName, '.')) != 0 ? (vlUInt)(lpTemp - lpName) : (vlUInt)strlen(lpName);
 
-	// Add the file name of the input file to the file name.
-	if((lpTemp = strrchr(lpInputFile, '\\')) != 0)
+	lpOutputFile = malloc(uiFolderLength + strlen(lpPrefix) + uiNameLength + strlen(lpPostfix) + strlen(lpExtension) + 2);
+	if(lpOutputFile == 0)
 	{
-		strcat(lpOutputFile, lpTemp + 1);
+		printf("Out of memory.\n");
+		exit(1);
 	}
-	else
+
+	if(lpOutput != 0 && *lpOutput != '\0')
 	{
-		strcat(lpOutputFile, lpInputFile);
+		sprintf(lpOutputFile, "%s%c", lpOutput, PATH_SEPARATOR);
 	}
-
-	if((lpTemp = strrchr(lpOutputFile, '.')) != 0 && lpTemp > strrchr(lpOutputFile, '\\'))
+	else
 	{
-		*lpTemp = '\0';
+		memcpy(lpOutputFile, lpInputFile, uiFolderLength);
+		lpOutputFile[uiFolderLength] = '\0';
 	}
 
-	// Add the postfix to the file name.
-	strcat(lpOutputFile, lpPostfix);
+	sprintf(lpOutputFile + uiFolderLength, "%s%.*s%s.%s", lpPrefix, (int)uiNameLength, lpName, lpPostfix, lpExtension);
 
-	// Add the extension to the file name.
-	strcat(lpOutputFile, ".");
-	strcat(lpOutputFile, lpExtension);
+	return lpOutputFile;
 }
 
 //
@@ -961,103 +2684,294 @@ void FlipImage(vlByte *lpImageData, vlUInt uiWidth, vlUInt uiHeight, vlUInt uiCh
 	}
 }
 
+//
+// ImportImage()
+// Create the vtf image from an image file DevIL can read.
+//
+vlBool ImportImage(SWorker *Worker, vlChar *lpInputFile)
+{
+	vlBool bLoaded;					// Input loaded.
+	vlBool bConverted = vlFalse;	// Input converted to RGBA.
+	vlBool bHasAlpha;				// Input has an alpha channel.
+	vlUInt uiWidth = 0, uiHeight = 0, uiBPP = 0;
+	vlByte *lpImageData = 0;		// Input data.
+	SVTFImageStatistics Statistics;	// Input analysis.
+
+	// DevIL only has one bound image per process, so only one worker can use it
+	// at a time.  The image is the worker's own though, so its data stays put
+	// once loaded.
+	EnterLock(&DevILLock);
+
+	ilBindImage(Worker->uiDevILImage);
+
+	// Load input file.
+	bLoaded = ilLoadImage(lpInputFile);
+	if(bLoaded)
+	{
+		uiWidth = (vlUInt)ilGetInteger(IL_IMAGE_WIDTH);
+		uiHeight = (vlUInt)ilGetInteger(IL_IMAGE_HEIGHT);
+		uiBPP = (vlUInt)ilGetInteger(IL_IMAGE_BYTES_PER_PIXEL);
+
+		// Convert input file to RGBA.
+		bConverted = ilConvertImage(IL_RGBA, IL_UNSIGNED_BYTE);
+		lpImageData = ilGetData();
+	}
+
+	LeaveLock(&DevILLock);
+
+	if(!bLoaded)
+	{
+		WorkerPrint(Worker, " Error loading input file.\n\n");
+		return vlFalse;
+	}
+
+	WorkerPrint(Worker, " Information:\n");
+
+	// Display input file info.
+	WorkerPrint(Worker, "  Width: %u\n", uiWidth);
+	WorkerPrint(Worker, "  Height: %u\n", uiHeight);
+	WorkerPrint(Worker, "  BPP: %u\n\n", uiBPP);
+
+	bHasAlpha = uiBPP == 4;
+
+	WorkerPrint(Worker, " Creating texture:\n");
+
+	if(!bConverted)
+	{
+		WorkerPrint(Worker, "  Error converting input file.\n\n");
+		return vlFalse;
+	}
+
+	// Only use the alpha format if the alpha channel is actually used, plenty of
+	// 32 bit images are fully opaque.
+	Worker->CreateOptions = CreateOptions;
+	Worker->CreateOptions.ImageFormat = NormalFormat;
+	if(bHasAlpha && vlImageComputeImageStatistics(lpImageData, uiWidth, uiHeight, IMAGE_FORMAT_RGBA8888, &Statistics) && Statistics.AlphaUsage != ALPHA_USAGE_NONE)
+	{
+		Worker->CreateOptions.ImageFormat = AlphaFormat;
+	}
+
+	// Create vtf file.
+	if(!vlContextImageCreateSingle(Worker->Context, Worker->uiVTFImage, uiWidth, uiHeight, lpImageData, &Worker->CreateOptions))
+	{
+		WorkerPrint(Worker, "  Error creating vtf file:\n%s\n\n", vlGetLastError());
+		return vlFalse;
+	}
+
+	return vlTrue;
+}
+
+//
+// ImportDDS()
+// Create the vtf image from a dds file's surfaces as they are, without decoding
+// them.  Returns false if VTF has no format for them, so the file can be decoded
+// with ImportImage() instead.
+//
+vlBool ImportDDS(SWorker *Worker, vlChar *lpInputFile)
+{
+	if(!vlContextImageLoadDDS(Worker->Context, Worker->uiVTFImage, lpInputFile))
+	{
+		WorkerPrint(Worker, " Unable to copy dds surfaces, decoding instead:\n%s\n\n", vlGetLastError());
+		return vlFalse;
+	}
+
+	WorkerPrint(Worker, " Information:\n");
+
+	// Display input file info.
+	WorkerPrint(Worker, "  Width: %u\n", vlContextImageGetWidth(Worker->Context, Worker->uiVTFImage));
+	WorkerPrint(Worker, "  Height: %u\n", vlContextImageGetHeight(Worker->Context, Worker->uiVTFImage));
+	WorkerPrint(Worker, "  Depth: %u\n", vlContextImageGetDepth(Worker->Context, Worker->uiVTFImage));
+	WorkerPrint(Worker, "  Frames: %u\n", vlContextImageGetFrameCount(Worker->Context, Worker->uiVTFImage));
+	WorkerPrint(Worker, "  Faces: %u\n", vlContextImageGetFaceCount(Worker->Context, Worker->uiVTFImage));
+	WorkerPrint(Worker, "  Mipmaps: %u\n", vlContextImageGetMipmapCount(Worker->Context, Worker->uiVTFImage));
+	WorkerPrint(Worker, "  Format: %s\n\n", vlImageGetImageFormatInfo(vlContextImageGetFormat(Worker->Context, Worker->uiVTFImage))->lpName);
+
+	WorkerPrint(Worker, " Creating texture:\n");
+
+	// The surfaces are final, so only the options that describe them apply.
+	vlContextImageSetFlags(Worker->Context, Worker->uiVTFImage, vlContextImageGetFlags(Worker->Context, Worker->uiVTFImage) | CreateOptions.uiFlags);
+	vlContextImageSetBumpmapScale(Worker->Context, Worker->uiVTFImage, CreateOptions.sBumpScale);
+
+	if(!CreateOptions.bReflectivity)
+	{
+		vlContextImageSetReflectivity(Worker->Context, Worker->uiVTFImage, CreateOptions.sReflectivity[0], CreateOptions.sReflectivity[1], CreateOptions.sReflectivity[2]);
+	}
+	else if(!vlContextImageComputeReflectivity(Worker->Context, Worker->uiVTFImage))
+	{
+		WorkerPrint(Worker, "  Unable to compute reflectivity:\n%s\n", vlGetLastError());
+	}
+
+	return vlTrue;
+}
+
+//
+// ExportImage()
+// Write the first frame of the vtf image through DevIL.
+//
+vlBool ExportImage(SWorker *Worker, vlChar *lpExportFile)
+{
+	vlUInt uiWidth, uiHeight;		// Export size.
+	vlByte *lpImageData;			// Export data.
+	VTFImageFormat DestFormat;		// Export format.
+	vlBool bSaved;					// Export written.
+
+	uiWidth = vlContextImageGetWidth(Worker->Context, Worker->uiVTFImage);
+	uiHeight = vlContextImageGetHeight(Worker->Context, Worker->uiVTFImage);
+
+	// Figure out which destination format to use.
+	DestFormat = (vlContextImageGetFlags(Worker->Context, Worker->uiVTFImage) & (TEXTUREFLAGS_ONEBITALPHA | TEXTUREFLAGS_EIGHTBITALPHA)) ? IMAGE_FORMAT_RGBA8888 : IMAGE_FORMAT_RGB888;
+
+	// Alocate the required memory to convert the vtf to.
+	lpImageData = malloc(vlImageComputeImageSize(uiWidth, uiHeight, 1, 1, DestFormat));
+
+	if(lpImageData == 0)
+	{
+		WorkerPrint(Worker, " malloc() failed.\n\n");
+		return vlFalse;
+	}
+
+	// Convert the .vtf.
+	if(!vlContextImageConvert(Worker->Context, vlContextImageGetData(Worker->Context, Worker->uiVTFImage, 0, 0, 0, 0), lpImageData, uiWidth, uiHeight, vlContextImageGetFormat(Worker->Context, Worker->uiVTFImage), DestFormat))
+	{
+		free(lpImageData);
+
+		WorkerPrint(Worker, " Error converting input file:\n%s\n\n", vlGetLastError());
+		return vlFalse;
+	}
+
+	// DevIL likes the image data upside down.
+	FlipImage(lpImageData, uiWidth, uiHeight, DestFormat == IMAGE_FORMAT_RGBA8888 ? 4 : 3);
+
+	// Only one worker can use DevIL at a time, see ImportImage().
+	EnterLock(&DevILLock);
+
+	ilBindImage(Worker->uiDevILImage);
+
+	// Create a new image with the converted image data in DevIL.
+	if(!ilTexImage(uiWidth, uiHeight, 1, DestFormat == IMAGE_FORMAT_RGBA8888 ? 4 : 3, DestFormat == IMAGE_FORMAT_RGBA8888 ? IL_RGBA : IL_RGB, IL_UNSIGNED_BYTE, lpImageData))
+	{
+		LeaveLock(&DevILLock);
+
+		free(lpImageData);
+
+		WorkerPrint(Worker, "  Error creating %s file.\n\n", lpExportFormat);
+		return vlFalse;
+	}
+
+	free(lpImageData);
+
+	// Write tga file.
+	WorkerPrint(Worker, "  Writing %s...\n", lpExportFile);
+	bSaved = ilSaveImage(lpExportFile);
+
+	LeaveLock(&DevILLock);
+
+	if(!bSaved)
+	{
+		WorkerPrint(Worker, " Error creating %s file.\n\n", lpExportFormat);
+		return vlFalse;
+	}
+	WorkerPrint(Worker, "  %s written.\n\n", lpExportFile);
+
+	return vlTrue;
+}
+
+//
+// ExportDDS()
+// Write the vtf image to a dds file as it is, with all its mipmaps, faces and
+// frames.  Returns false if DDS has no format for it, so it can be decoded with
+// ExportImage() instead.
+//
+vlBool ExportDDS(SWorker *Worker, vlChar *lpExportFile)
+{
+	WorkerPrint(Worker, "  Writing %s...\n", lpExportFile);
+	if(!vlContextImageSaveDDS(Worker->Context, Worker->uiVTFImage, lpExportFile))
+	{
+		WorkerPrint(Worker, "  Unable to copy vtf surfaces, decoding instead:\n%s\n", vlGetLastError());
+		return vlFalse;
+	}
+	WorkerPrint(Worker, "  %s written.\n\n", lpExportFile);
+
+	return vlTrue;
+}
+
 //
 // ProcessFile()
-// Convert input file to a vtf file and place it in the output folder.
+// Convert input file to a vtf file and place it in the output folder.  Returns
+// true if it was converted without error.
 //
-void ProcessFile(vlChar *lpInputFile)
+vlBool ProcessFile(SWorker *Worker, vlChar *lpInputFile)
 {
 	vlUInt i;
 
 	vlChar *lpTemp;					// Temp variable for string manipulation.
-	vlChar lpVTFFile[512];			// Holds output .vtf file name.
-	vlChar lpVMTFile[512];			// Holds output .vmt file name.
-	vlChar lpVMTBaseTexture[512];	// Holds $basetexture .vmt param.
-	vlChar lpExportFile[512];		// Holds output export file name.
+	vlChar *lpVTFFile;				// Holds output .vtf file name.
+	vlChar *lpVMTFile;				// Holds output .vmt file name.
+	vlChar *lpVMTBaseTexture;		// Holds $basetexture .vmt param.
+	vlChar *lpExportFile;			// Holds output export file name.
 
 	vlInt iTest;					// Holds .vmt integer test result.
 	vlSingle sTest;					// Holds .vmt float test result.
 	vlChar cTest[4096];				// Holds .vmt string test result.
 
 	vlSingle sR, sG, sB;			// Reflectivity.
-	vlByte *lpImageData;			// Export data.
-	VTFImageFormat DestFormat;		// Export format.
-
-	uiProcessed++;
 
-	Print("Processing %s...\n", lpInputFile);
+	WorkerPrint(Worker, "Processing %s...\n", lpInputFile);
 
 	lpTemp = strrchr(lpInputFile, '.');
 	
 	if(lpTemp == 0 || stricmp(lpTemp, ".vtf") != 0)
 	{
-		// Load input file.
-		if(!ilLoadImage(lpInputFile))
-		{
-			Print(" Error loading input file.\n\n");
-			return;
-		}
-
-		Print(" Information:\n");
-
-		// Display input file info.
-		Print("  Width: %d\n", ilGetInteger(IL_IMAGE_WIDTH));
-		Print("  Height: %d\n", ilGetInteger(IL_IMAGE_HEIGHT));
-		Print("  BPP: %d\n\n", ilGetInteger(IL_IMAGE_BYTES_PER_PIXEL));
-
-		CreateOptions.ImageFormat = ilGetInteger(IL_IMAGE_BYTES_PER_PIXEL) == 4 ? AlphaFormat : NormalFormat;
-
-		Print(" Creating texture:\n");
-
-		// Convert input file to RGBA.
-		if(!ilConvertImage(IL_RGBA, IL_UNSIGNED_BYTE))
-		{
-			Print("  Error converting input file.\n\n");
-			return;
-		}
-
-		// Create vtf file.
-		if(!vlImageCreateSingle((vlUInt)ilGetInteger(IL_IMAGE_WIDTH), (vlUInt)ilGetInteger(IL_IMAGE_HEIGHT), ilGetData(), &CreateOptions))
+		// Copy the surfaces of dds files across unless asked to re-encode them.
+		if(lpTemp == 0 || stricmp(lpTemp, ".dds") != 0 || bDecodeDDS || !ImportDDS(Worker, lpInputFile))
 		{
-			Print("  Error creating vtf file:\n%s\n\n", vlGetLastError());
-			return;
+			if(!ImportImage(Worker, lpInputFile))
+				return vlFalse;
 		}
 
-		CreateOutputPath(lpVTFFile, lpInputFile, "vtf");
+		lpVTFFile = CreateOutputPath(lpInputFile, "vtf");
 
 		// Write vtf file.
-		Print("  Writing %s...\n", lpVTFFile);
-		if(!vlImageSave(lpVTFFile))
+		WorkerPrint(Worker, "  Writing %s...\n", lpVTFFile);
+		if(!vlContextImageSave(Worker->Context, Worker->uiVTFImage, lpVTFFile))
 		{
-			Print(" Error creating vtf file:\n%s\n\n", vlGetLastError());
-			return;
+			WorkerPrint(Worker, " Error creating vtf file:\n%s\n\n", vlGetLastError());
+			free(lpVTFFile);
+			return vlFalse;
 		}
-		Print("  %s written.\n\n", lpVTFFile);
+		WorkerPrint(Worker, "  %s written.\n\n", lpVTFFile);
+		AddOutput(Worker, lpVTFFile);
 
 		// Do we build a material?
 		if(lpShader != 0)
 		{
-			Print(" Creating material:\n");
+			WorkerPrint(Worker, " Creating material:\n");
 
 			// We need to constuct a $basetexture string, to do this we need the path
 			// of the vtf file relative to the materials folder.  If we arn't in a
 			// materials folder we can't do this.
-			if((lpTemp = stristr(lpVTFFile, "materials\\")) == 0)
+			if((lpTemp = stristr(lpVTFFile, "materials" PATH_SEPARATOR_STRING)) == 0)
 			{
-				Print("  Error creating vmt: texture is not in a ...\\materials\\ folder.\n\n");
+				WorkerPrint(Worker, "  Error creating vmt: texture is not in a ...\\materials\\ folder.\n\n");
 			}
 			else
 			{
-				strcpy(lpVMTFile, lpVTFFile);
-				strcpy(strrchr(lpVMTFile, '.'), ".vmt");
+				// The .vtf extension is as long as the .vmt one.
+				lpVMTFile = strdup(lpVTFFile);
+				lpVMTBaseTexture = strdup(lpTemp + strlen("materials" PATH_SEPARATOR_STRING));
+				if(lpVMTFile == 0 || lpVMTBaseTexture == 0)
+				{
+					printf("Out of memory.\n");
+					exit(1);
+				}
 
-				strcpy(lpVMTBaseTexture, lpTemp + strlen("materials\\"));
+				strcpy(strrchr(lpVMTFile, '.'), ".vmt");
 				*strrchr(lpVMTBaseTexture, '.') = '\0';
-				strrpl(lpVMTBaseTexture, '\\', '/');
+				strrpl(lpVMTBaseTexture, PATH_SEPARATOR, '/');
 
-				vlMaterialCreate(lpShader); // Create the root node.
-				vlMaterialGetFirstNode(); // Go to the root node.
-				vlMaterialAddNodeString("$basetexture", lpVMTBaseTexture); // Add a string node to the root node.
+				vlContextMaterialCreate(Worker->Context, Worker->uiVMTMaterial, lpShader); // Create the root node.
+				vlContextMaterialGetFirstNode(Worker->Context, Worker->uiVMTMaterial); // Go to the root node.
+				vlContextMaterialAddNodeString(Worker->Context, Worker->uiVMTMaterial, "$basetexture", lpVMTBaseTexture); // Add a string node to the root node.
 
 				// Add the custom parameters.
 				for(i = 0; i < uiParameterCount; i++)
@@ -1067,172 +2981,85 @@ void ProcessFile(vlChar *lpInputFile)
 					if(sscanf(lpParameters[i][1], "%d%s", &iTest, cTest) == 1)
 					{
 						// We can interpet the string as an integer, assume it is one.
-						vlMaterialAddNodeInteger(lpParameters[i][0], iTest);
+						vlContextMaterialAddNodeInteger(Worker->Context, Worker->uiVMTMaterial, lpParameters[i][0], iTest);
 					}
 					else if(sscanf(lpParameters[i][1], "%f%s", &sTest, cTest) == 1)
 					{
 						// We can interpet the string as an single, assume it is one.
-						vlMaterialAddNodeSingle(lpParameters[i][0], sTest);
+						vlContextMaterialAddNodeSingle(Worker->Context, Worker->uiVMTMaterial, lpParameters[i][0], sTest);
 					}
 					else
 					{
 						// The string must be a string...
-						vlMaterialAddNodeString(lpParameters[i][0], lpParameters[i][1]);
+						vlContextMaterialAddNodeString(Worker->Context, Worker->uiVMTMaterial, lpParameters[i][0], lpParameters[i][1]);
 					}
 				}
 
 				// Write vmt file.
-				Print("  Writing %s...\n", lpVMTFile);
-				if(!vlMaterialSave(lpVMTFile))
+				WorkerPrint(Worker, "  Writing %s...\n", lpVMTFile);
+				if(!vlContextMaterialSave(Worker->Context, Worker->uiVMTMaterial, lpVMTFile))
 				{
-					Print("Error creating vtf file:\n%s\n\n", vlGetLastError());
-					return;
+					WorkerPrint(Worker, "Error creating vtf file:\n%s\n\n", vlGetLastError());
+					free(lpVMTBaseTexture);
+					free(lpVMTFile);
+					free(lpVTFFile);
+					return vlFalse;
 				}
-				Print("  %s written.\n\n", lpVMTFile);
+				WorkerPrint(Worker, "  %s written.\n\n", lpVMTFile);
+				AddOutput(Worker, lpVMTFile);
+
+				free(lpVMTBaseTexture);
+				free(lpVMTFile);
 			}
 		}
+
+		free(lpVTFFile);
 	}
 	else
 	{
-		if(!vlImageLoad(lpInputFile, vlFalse))
+		if(!vlContextImageLoad(Worker->Context, Worker->uiVTFImage, lpInputFile, vlFalse))
 		{
-			Print(" Error loading input file:\n%s\n\n", vlGetLastError());
-			return;
+			WorkerPrint(Worker, " Error loading input file:\n%s\n\n", vlGetLastError());
+			return vlFalse;
 		}
 
-		Print(" Information:\n");
+		WorkerPrint(Worker, " Information:\n");
 
 		// Display input file info.
-		Print("  Version: v%u.%u\n", vlImageGetMajorVersion(), vlImageGetMinorVersion());
-		Print("  Size On Disk: %.2f KB\n", (vlSingle)vlImageGetSize() / 1024.0f);
-		Print("  Width: %u\n", vlImageGetWidth());
-		Print("  Height: %u\n", vlImageGetHeight());
-		Print("  Depth: %u\n", vlImageGetDepth());
-		Print("  Frames: %u\n", vlImageGetFrameCount());
-		Print("  Start Frame: %u\n", vlImageGetStartFrame());
-		Print("  Faces: %u\n", vlImageGetFaceCount());
-		Print("  Mipmaps: %u\n", vlImageGetMipmapCount());
-		Print("  Flags: %#.8x\n", vlImageGetFlags());
-		Print("  Bumpmap Scale: %.2f\n", vlImageGetBumpmapScale());
-		vlImageGetReflectivity(&sR, &sG, &sB);
-		Print("  Reflectivity: %.2f, %.2f, %.2f\n", sR, sG, sB);
-		Print("  Format: %s\n\n", vlImageGetImageFormatInfo(vlImageGetFormat())->lpName);
-		Print("  Resources: %u\n", vlImageGetResourceCount());
-
-		Print(" Creating texture:\n");
-
-		// Figure out which destination format to use.
-		DestFormat = (vlImageGetFlags() & (TEXTUREFLAGS_ONEBITALPHA | TEXTUREFLAGS_EIGHTBITALPHA)) ? IMAGE_FORMAT_RGBA8888 : IMAGE_FORMAT_RGB888;
-
-		// Alocate the required memory to convert the vtf to.
-		lpImageData = malloc(vlImageComputeImageSize(vlImageGetWidth(), vlImageGetHeight(), 1, 1, DestFormat));
-
-		if(lpImageData == 0)
-		{
-			Print(" malloc() failed.\n\n");
-			return;
-		}
-
-		// Convert the .vtf.
-		if(!vlImageConvert(vlImageGetData(0, 0, 0, 0), lpImageData, vlImageGetWidth(), vlImageGetHeight(), vlImageGetFormat(), DestFormat))
-		{
-			free(lpImageData);
-
-			Print(" Error converting input file:\n%s\n\n", vlGetLastError());
-			return;
-		}
-
-		// DevIL likes the image data upside down.
-		FlipImage(lpImageData, vlImageGetWidth(), vlImageGetHeight(), DestFormat == IMAGE_FORMAT_RGBA8888 ? 4 : 3);
-
-		// Create a new image with the converted image data in DevIL.
-		if(!ilTexImage(vlImageGetWidth(), vlImageGetHeight(), 1, DestFormat == IMAGE_FORMAT_RGBA8888 ? 4 : 3, DestFormat == IMAGE_FORMAT_RGBA8888 ? IL_RGBA : IL_RGB, IL_UNSIGNED_BYTE, lpImageData))
-		{
-			free(lpImageData);
-
-			Print("  Error creating %s file.\n\n", lpExportFormat);
-			return;
-		}
-
-		free(lpImageData);
-
-		CreateOutputPath(lpExportFile, lpInputFile, lpExportFormat);
-
-		// Write tga file.
-		Print("  Writing %s...\n", lpExportFile);
-		if(!ilSaveImage(lpExportFile))
-		{
-			Print(" Error creating %s file.\n\n", lpExportFormat);
-			return;
-		}
-		Print("  %s written.\n\n", lpExportFile);
-	}
-
-	Print("%s processed.\n\n", lpInputFile);
-
-	uiCompleted++;
-}
-
-//
-// ProcessFile()
-// Process all files in the input folder.
-//
-void ProcessFolder(vlChar *lpInputFolder, vlChar *lpWildcard)
-{
-	vlChar lpSearchString[512];
-	vlChar lpPath[512];
-
-	WIN32_FIND_DATA FindData;
-	HANDLE Handle;
-
-	Print("Processing %s\\...\n\n", lpInputFolder);
-
-	if(bRecursive)
-	{
-		sprintf(lpSearchString, "%s\\*", lpInputFolder);
-
-		Handle = FindFirstFile(lpSearchString, &FindData);
-
-		if(Handle != INVALID_HANDLE_VALUE)
-		{
-			do
-			{
-				if(stricmp(FindData.cFileName, ".") != 0 && stricmp(FindData.cFileName, "..") != 0)
-				{
-					sprintf(lpPath, "%s\\%s", lpInputFolder, FindData.cFileName);
-
-					if(FindData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
-					{
-						ProcessFolder(lpPath, lpWildcard);
-					}
-				}
-			} while(FindNextFile(Handle, &FindData));
-
-			FindClose(Handle);
-		}
-	}
-
-	sprintf(lpSearchString, "%s\\%s", lpInputFolder, lpWildcard);
-
-	Handle = FindFirstFile(lpSearchString, &FindData);
-
-	if(Handle != INVALID_HANDLE_VALUE)
-	{
-		do
+		WorkerPrint(Worker, "  Version: v%u.%u\n", vlContextImageGetMajorVersion(Worker->Context, Worker->uiVTFImage), vlContextImageGetMinorVersion(Worker->Context, Worker->uiVTFImage));
+		WorkerPrint(Worker, "  Size On Disk: %.2f KB\n", (vlSingle)vlContextImageGetSize(Worker->Context, Worker->uiVTFImage) / 1024.0f);
+		WorkerPrint(Worker, "  Width: %u\n", vlContextImageGetWidth(Worker->Context, Worker->uiVTFImage));
+		WorkerPrint(Worker, "  Height: %u\n", vlContextImageGetHeight(Worker->Context, Worker->uiVTFImage));
+		WorkerPrint(Worker, "  Depth: %u\n", vlContextImageGetDepth(Worker->Context, Worker->uiVTFImage));
+		WorkerPrint(Worker, "  Frames: %u\n", vlContextImageGetFrameCount(Worker->Context, Worker->uiVTFImage));
+		WorkerPrint(Worker, "  Start Frame: %u\n", vlContextImageGetStartFrame(Worker->Context, Worker->uiVTFImage));
+		WorkerPrint(Worker, "  Faces: %u\n", vlContextImageGetFaceCount(Worker->Context, Worker->uiVTFImage));
+		WorkerPrint(Worker, "  Mipmaps: %u\n", vlContextImageGetMipmapCount(Worker->Context, Worker->uiVTFImage));
+		WorkerPrint(Worker, "  Flags: %#.8x\n", vlContextImageGetFlags(Worker->Context, Worker->uiVTFImage));
+		WorkerPrint(Worker, "  Bumpmap Scale: %.2f\n", vlContextImageGetBumpmapScale(Worker->Context, Worker->uiVTFImage));
+		vlContextImageGetReflectivity(Worker->Context, Worker->uiVTFImage, &sR, &sG, &sB);
+		WorkerPrint(Worker, "  Reflectivity: %.2f, %.2f, %.2f\n", sR, sG, sB);
+		WorkerPrint(Worker, "  Format: %s\n\n", vlImageGetImageFormatInfo(vlContextImageGetFormat(Worker->Context, Worker->uiVTFImage))->lpName);
+		WorkerPrint(Worker, "  Resources: %u\n", vlContextImageGetResourceCount(Worker->Context, Worker->uiVTFImage));
+
+		WorkerPrint(Worker, " Creating texture:\n");
+
+		lpExportFile = CreateOutputPath(lpInputFile, lpExportFormat);
+
+		if(stricmp(lpExportFormat, "dds") != 0 || !ExportDDS(Worker, lpExportFile))
 		{
-			if(stricmp(FindData.cFileName, ".") != 0 && stricmp(FindData.cFileName, "..") != 0)
+			if(!ExportImage(Worker, lpExportFile))
 			{
-				sprintf(lpPath, "%s\\%s", lpInputFolder, FindData.cFileName);
-
-				if((FindData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == 0)
-				{
-					ProcessFile(lpPath);
-				}
+				free(lpExportFile);
+				return vlFalse;
 			}
-		} while(FindNextFile(Handle, &FindData));
+		}
+		AddOutput(Worker, lpExportFile);
 
-		FindClose(Handle);
+		free(lpExportFile);
 	}
 
-	Print("%s\\ processed.\n\n", lpInputFolder);
+	WorkerPrint(Worker, "%s processed.\n\n", lpInputFile);
+
+	return vlTrue;
 }
\ No newline at end of file
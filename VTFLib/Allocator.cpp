@@ -0,0 +1,438 @@
+/*
+ * VTFLib
+ * Copyright (C) 2005-2010 Neil Jedrzejewski & Ryan Gregg
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later
+ * version.
+ */
+
+#include "VTFLib.h"
+#include "Allocator.h"
+#include "StatTimer.h"
+
+#include <atomic>
+#include <mutex>
+#include <new>
+
+#ifndef _WIN32
+#	include <stdlib.h>
+#endif
+
+using namespace VTFLib;
+using namespace VTFLib::Memory;
+
+// Set on blocks that came from VirtualAlloc() with MEM_LARGE_PAGES.
+#define BLOCK_FLAG_LARGE_PAGES	0x01
+
+namespace
+{
+	// Every block starts with a header in the MEMORY_ALIGNMENT bytes before the
+	// data recording how to free it, so blocks outlive allocator changes.
+	struct SBlockHeader
+	{
+		PFreeProc pFree;
+		vlVoid *pUserData;
+		vlVoid *lpBase;
+		vlUInt64 uiSize;
+		vlUInt uiFlags;
+	};
+
+	STATIC_ASSERT(sizeof(SBlockHeader) <= MEMORY_ALIGNMENT, "Block header must fit in the alignment padding.");
+
+	vlVoid *DefaultAllocate(vlUInt64 uiSize, vlUInt uiAlignment, vlVoid *pUserData)
+	{
+		if(uiSize > (size_t)-1)
+		{
+			return 0;
+		}
+
+#ifdef _WIN32
+		return _aligned_malloc((size_t)uiSize, uiAlignment);
+#else
+		vlVoid *lpData;
+		return posix_memalign(&lpData, uiAlignment < sizeof(vlVoid *) ? sizeof(vlVoid *) : uiAlignment, (size_t)uiSize) == 0 ? lpData : 0;
+#endif
+	}
+
+	vlVoid DefaultFree(vlVoid *lpData, vlVoid *pUserData)
+	{
+#ifdef _WIN32
+		_aligned_free(lpData);
+#else
+		free(lpData);
+#endif
+	}
+
+	std::mutex AllocatorMutex;
+	PAllocateProc pAllocateProc = DefaultAllocate;
+	PFreeProc pFreeProc = DefaultFree;
+	vlVoid *pAllocatorUserData = 0;
+
+	std::atomic<vlBool> bLargePages(vlFalse);
+
+	SBlockHeader *GetHeader(vlByte *lpData)
+	{
+		return reinterpret_cast<SBlockHeader *>(lpData - MEMORY_ALIGNMENT);
+	}
+
+	//
+	// AllocateLargePages()
+	// Tries to allocate a block on large pages, which needs the "Lock pages in
+	// memory" privilege.  Returns 0 if the block is too small to be worth it or
+	// the system refuses.  Other systems always return 0 and leave it to the
+	// kernel to back big blocks with large pages.
+	//
+	vlByte *AllocateLargePages(vlUInt64 uiSize)
+	{
+#ifdef _WIN32
+		vlUInt64 uiPageSize = (vlUInt64)GetLargePageMinimum();
+		if(uiPageSize == 0 || uiSize < uiPageSize || uiSize + MEMORY_ALIGNMENT > (size_t)-1)
+		{
+			return 0;
+		}
+
+		vlUInt64 uiAllocationSize = (uiSize + MEMORY_ALIGNMENT + uiPageSize - 1) / uiPageSize * uiPageSize;
+
+		vlVoid *lpBase = VirtualAlloc(0, (SIZE_T)uiAllocationSize, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+		if(lpBase == 0)
+		{
+			return 0;
+		}
+
+		vlByte *lpData = static_cast<vlByte *>(lpBase) + MEMORY_ALIGNMENT;
+
+		SBlockHeader *pHeader = GetHeader(lpData);
+		pHeader->pFree = 0;
+		pHeader->pUserData = 0;
+		pHeader->lpBase = lpBase;
+		pHeader->uiSize = uiSize;
+		pHeader->uiFlags = BLOCK_FLAG_LARGE_PAGES;
+
+		return lpData;
+#else
+		return 0;
+#endif
+	}
+
+	//
+	// AllocateBlock()
+	// Allocates a block from the current allocator.  Throws std::bad_alloc on
+	// failure.
+	//
+	vlByte *AllocateBlock(vlUInt64 uiSize, vlBool bAllowLargePages)
+	{
+		vlByte *lpData = 0;
+
+		PAllocateProc pAllocate;
+		PFreeProc pFree;
+		vlVoid *pUserData;
+		{
+			std::lock_guard<std::mutex> Lock(AllocatorMutex);
+			pAllocate = pAllocateProc;
+			pFree = pFreeProc;
+			pUserData = pAllocatorUserData;
+		}
+
+		if(bAllowLargePages && pAllocate == DefaultAllocate && bLargePages.load(std::memory_order_relaxed))
+		{
+			lpData = AllocateLargePages(uiSize);
+		}
+
+		if(lpData == 0)
+		{
+			vlVoid *lpBase = uiSize + MEMORY_ALIGNMENT < uiSize ? 0 : pAllocate(uiSize + MEMORY_ALIGNMENT, MEMORY_ALIGNMENT, pUserData);
+			if(lpBase == 0)
+			{
+				throw std::bad_alloc();
+			}
+
+			lpData = static_cast<vlByte *>(lpBase) + MEMORY_ALIGNMENT;
+
+			SBlockHeader *pHeader = GetHeader(lpData);
+			pHeader->pFree = pFree;
+			pHeader->pUserData = pUserData;
+			pHeader->lpBase = lpBase;
+			pHeader->uiSize = uiSize;
+			pHeader->uiFlags = 0;
+		}
+
+		Diagnostics::StatAllocate(uiSize);
+
+		return lpData;
+	}
+
+	vlVoid FreeBlock(vlByte *lpData)
+	{
+		SBlockHeader *pHeader = GetHeader(lpData);
+
+		Diagnostics::StatFree(pHeader->uiSize);
+
+#ifdef _WIN32
+		if(pHeader->uiFlags & BLOCK_FLAG_LARGE_PAGES)
+		{
+			VirtualFree(pHeader->lpBase, 0, MEM_RELEASE);
+			return;
+		}
+#endif
+
+		pHeader->pFree(pHeader->lpBase, pHeader->pUserData);
+	}
+
+	// Bytes cached by all threads' scratch pools, kept under SCRATCH_POOL_LIMIT.
+	std::atomic<vlUInt64> uiPooledBytes(0);
+
+	//
+	// ReservePool()
+	// Takes uiSize bytes of the shared pool limit, or returns false if they
+	// would go over it.
+	//
+	vlBool ReservePool(vlUInt64 uiSize)
+	{
+		vlUInt64 uiPooled = uiPooledBytes.load(std::memory_order_relaxed);
+		do
+		{
+			if(uiSize > SCRATCH_POOL_LIMIT || uiPooled > SCRATCH_POOL_LIMIT - uiSize)
+			{
+				return vlFalse;
+			}
+		} while(!uiPooledBytes.compare_exchange_weak(uiPooled, uiPooled + uiSize, std::memory_order_relaxed));
+
+		return vlTrue;
+	}
+
+	// Scratch blocks a thread has finished with, kept for the next call.
+	class CScratchPool
+	{
+	private:
+		vlByte *lpBlocks[SCRATCH_POOL_BLOCKS];
+		vlUInt uiBlockCount;
+
+	public:
+		CScratchPool() : uiBlockCount(0)
+		{
+		}
+
+		~CScratchPool()
+		{
+			this->Clear();
+		}
+
+		//
+		// Acquire()
+		// Takes the smallest cached block that holds uiSize bytes, or allocates a
+		// new one.
+		//
+		vlByte *Acquire(vlUInt64 uiSize)
+		{
+			vlUInt uiBest = this->uiBlockCount;
+			for(vlUInt i = 0; i < this->uiBlockCount; i++)
+			{
+				vlUInt64 uiBlockSize = GetHeader(this->lpBlocks[i])->uiSize;
+				if(uiBlockSize >= uiSize && (uiBest == this->uiBlockCount || uiBlockSize < GetHeader(this->lpBlocks[uiBest])->uiSize))
+				{
+					uiBest = i;
+				}
+			}
+
+			if(uiBest != this->uiBlockCount)
+			{
+				vlByte *lpData = this->lpBlocks[uiBest];
+				uiPooledBytes.fetch_sub(GetHeader(lpData)->uiSize, std::memory_order_relaxed);
+				this->lpBlocks[uiBest] = this->lpBlocks[--this->uiBlockCount];
+				return lpData;
+			}
+
+			vlUInt64 uiRounded = (uiSize + SCRATCH_GRANULARITY - 1) / SCRATCH_GRANULARITY * SCRATCH_GRANULARITY;
+			return AllocateBlock(uiRounded < uiSize ? uiSize : uiRounded, vlFalse);
+		}
+
+		//
+		// Release()
+		// Caches a block, making room by freeing the smallest cached blocks if they
+		// are smaller than it.  Blocks that don't fit are freed.  Only this thread's
+		// blocks are freed to make room, so a block may also be freed because other
+		// threads hold the rest of the shared limit.
+		//
+		vlVoid Release(vlByte *lpData)
+		{
+			vlUInt64 uiSize = GetHeader(lpData)->uiSize;
+
+			vlBool bReserved = this->uiBlockCount < SCRATCH_POOL_BLOCKS && ReservePool(uiSize);
+			while(!bReserved && this->uiBlockCount > 0)
+			{
+				vlUInt uiSmallest = 0;
+				for(vlUInt i = 1; i < this->uiBlockCount; i++)
+				{
+					if(GetHeader(this->lpBlocks[i])->uiSize < GetHeader(this->lpBlocks[uiSmallest])->uiSize)
+					{
+						uiSmallest = i;
+					}
+				}
+
+				vlByte *lpSmallest = this->lpBlocks[uiSmallest];
+				if(GetHeader(lpSmallest)->uiSize >= uiSize)
+				{
+					break;
+				}
+
+				uiPooledBytes.fetch_sub(GetHeader(lpSmallest)->uiSize, std::memory_order_relaxed);
+				this->lpBlocks[uiSmallest] = this->lpBlocks[--this->uiBlockCount];
+				FreeBlock(lpSmallest);
+
+				bReserved = ReservePool(uiSize);
+			}
+
+			if(!bReserved)
+			{
+				FreeBlock(lpData);
+				return;
+			}
+
+			this->lpBlocks[this->uiBlockCount++] = lpData;
+		}
+
+		vlVoid Clear()
+		{
+			while(this->uiBlockCount > 0)
+			{
+				vlByte *lpData = this->lpBlocks[--this->uiBlockCount];
+				uiPooledBytes.fetch_sub(GetHeader(lpData)->uiSize, std::memory_order_relaxed);
+				FreeBlock(lpData);
+			}
+		}
+	};
+
+	thread_local CScratchPool ScratchPool;
+}
+
+vlByte *Memory::AllocateImage(vlUInt64 uiSize)
+{
+	return AllocateBlock(uiSize, vlTrue);
+}
+
+vlVoid Memory::FreeImage(vlByte *lpData)
+{
+	if(lpData != 0)
+	{
+		FreeBlock(lpData);
+	}
+}
+
+vlVoid Memory::SetLargePages(vlBool bEnabled)
+{
+	bLargePages.store(bEnabled ? vlTrue : vlFalse);
+}
+
+vlBool Memory::GetLargePages()
+{
+	return bLargePages.load();
+}
+
+CScratchBuffer::CScratchBuffer() : lpData(0), uiCapacity(0)
+{
+}
+
+CScratchBuffer::CScratchBuffer(vlUInt64 uiSize) : lpData(0), uiCapacity(0)
+{
+	this->Allocate(uiSize);
+}
+
+CScratchBuffer::~CScratchBuffer()
+{
+	this->Release();
+}
+
+vlByte *CScratchBuffer::Allocate(vlUInt64 uiSize)
+{
+	if(this->lpData != 0 && this->uiCapacity >= uiSize)
+	{
+		return this->lpData;
+	}
+
+	this->Release();
+
+	this->lpData = ScratchPool.Acquire(uiSize);
+	this->uiCapacity = GetHeader(this->lpData)->uiSize;
+
+	return this->lpData;
+}
+
+vlByte *CScratchBuffer::Grow(vlUInt64 uiSize)
+{
+	if(this->lpData != 0 && this->uiCapacity >= uiSize)
+	{
+		return this->lpData;
+	}
+
+	// Grow geometrically so building up a buffer a piece at a time stays linear.
+	if(uiSize < this->uiCapacity * 2)
+	{
+		uiSize = this->uiCapacity * 2;
+	}
+
+	vlByte *lpNewData = ScratchPool.Acquire(uiSize);
+
+	if(this->lpData != 0)
+	{
+		memcpy(lpNewData, this->lpData, (size_t)this->uiCapacity);
+		ScratchPool.Release(this->lpData);
+	}
+
+	this->lpData = lpNewData;
+	this->uiCapacity = GetHeader(this->lpData)->uiSize;
+
+	return this->lpData;
+}
+
+vlVoid CScratchBuffer::Release()
+{
+	if(this->lpData != 0)
+	{
+		ScratchPool.Release(this->lpData);
+		this->lpData = 0;
+		this->uiCapacity = 0;
+	}
+}
+
+//
+// vlSetAllocator()
+// Sets the allocator for image data and scratch memory, or restores the
+// default if both procs are null.
+//
+VTFLIB_API vlBool vlSetAllocator(PAllocateProc pAllocate, PFreeProc pFree, vlVoid *pUserData)
+{
+	if((pAllocate == 0) != (pFree == 0))
+	{
+		LastError.Set("Allocate and free procs must both be set or both be null.");
+		return vlFalse;
+	}
+
+	std::lock_guard<std::mutex> Lock(AllocatorMutex);
+
+	if(pAllocate == 0)
+	{
+		pAllocateProc = DefaultAllocate;
+		pFreeProc = DefaultFree;
+		pAllocatorUserData = 0;
+	}
+	else
+	{
+		pAllocateProc = pAllocate;
+		pFreeProc = pFree;
+		pAllocatorUserData = pUserData;
+	}
+
+	return vlTrue;
+}
+
+//
+// vlFreeScratch()
+// Frees the calling thread's cached scratch memory.
+//
+VTFLIB_API vlVoid vlFreeScratch()
+{
+	ScratchPool.Clear();
+}
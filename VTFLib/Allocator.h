@@ -0,0 +1,115 @@
+/*
+ * VTFLib
+ * Copyright (C) 2005-2010 Neil Jedrzejewski & Ryan Gregg
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later
+ * version.
+ */
+
+// ============================================================
+// NOTE: This file is commented for compatibility with Doxygen.
+// ============================================================
+/*!
+	\file Allocator.h
+	\brief Image buffer allocation and per thread scratch memory.
+*/
+
+#ifndef ALLOCATOR_H
+#define ALLOCATOR_H
+
+#include "stdafx.h"
+
+#define MEMORY_ALIGNMENT		64							//!< Alignment of image and scratch buffers, a cache line and wide enough for any SIMD load.
+
+#define SCRATCH_POOL_BLOCKS		8							//!< Most scratch buffers each thread keeps for reuse.
+#define SCRATCH_POOL_LIMIT		(256 * 1024 * 1024)			//!< Most scratch memory all threads together keep for reuse.
+#define SCRATCH_GRANULARITY		(64 * 1024)					//!< Scratch buffers are rounded up to this so similar sizes share them.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//! Allocates uiSize bytes aligned to uiAlignment (a power of two), or returns 0.
+typedef vlVoid *(*PAllocateProc)(vlUInt64 uiSize, vlUInt uiAlignment, vlVoid *pUserData);
+//! Frees memory returned by the matching PAllocateProc.
+typedef vlVoid (*PFreeProc)(vlVoid *lpData, vlVoid *pUserData);
+
+//! Sets the allocator used for image data and scratch memory.
+/*!
+	Pass 0 for both procs to go back to the default allocator.  Memory is
+	always returned to the allocator that provided it, so the allocator may
+	be changed at any time, but the procs and pUserData must stay valid
+	until everything they allocated has been freed.
+*/
+VTFLIB_API vlBool vlSetAllocator(PAllocateProc pAllocate, PFreeProc pFree, vlVoid *pUserData);
+
+//! Frees the scratch memory the calling thread keeps for reuse.
+VTFLIB_API vlVoid vlFreeScratch();
+
+#ifdef __cplusplus
+}
+#endif
+
+namespace VTFLib
+{
+	namespace Memory
+	{
+		//! Allocates an image buffer aligned to MEMORY_ALIGNMENT.
+		/*!
+			Uses large pages for big buffers when the VTFLIB_LARGE_PAGES option is
+			set and the process holds the "Lock pages in memory" privilege.
+			Throws std::bad_alloc on failure, like new.
+		*/
+		vlByte *AllocateImage(vlUInt64 uiSize);
+
+		//! Frees a buffer from AllocateImage().  Does nothing for 0.
+		vlVoid FreeImage(vlByte *lpData);
+
+		vlVoid SetLargePages(vlBool bLargePages);
+		vlBool GetLargePages();
+
+		//! Temporary memory for the length of a call.
+		/*!
+			Buffers come from a small pool kept by each thread and go back to it
+			when the scratch buffer is destroyed, so repeated calls with images of
+			the same size don't touch the heap.  The pools share one size limit,
+			so threads started for a single call can't each hold on to a full
+			pool.  Contents are not cleared.
+		*/
+		class CScratchBuffer
+		{
+		private:
+			vlByte *lpData;
+			vlUInt64 uiCapacity;
+
+		public:
+			CScratchBuffer();
+			explicit CScratchBuffer(vlUInt64 uiSize);
+			~CScratchBuffer();
+
+		private:
+			CScratchBuffer(const CScratchBuffer &);
+			CScratchBuffer &operator=(const CScratchBuffer &);
+
+		public:
+			//! Makes the buffer at least uiSize bytes, discarding its contents, and returns it.
+			vlByte *Allocate(vlUInt64 uiSize);
+
+			//! Makes the buffer at least uiSize bytes, keeping its contents, and returns it.
+			vlByte *Grow(vlUInt64 uiSize);
+
+			//! Returns the buffer to the pool.
+			vlVoid Release();
+
+			vlByte *Get() const
+			{
+				return this->lpData;
+			}
+		};
+	}
+}
+
+#endif
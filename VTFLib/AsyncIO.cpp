@@ -0,0 +1,903 @@
+/*
+ * VTFLib
+ * Copyright (C) 2005-2010 Neil Jedrzejewski & Ryan Gregg
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later
+ * version.
+ */
+
+#include "VTFLib.h"
+#include "AsyncIO.h"
+#include "Context.h"
+#include "FileReader.h"
+#include "FileWriter.h"
+
+#if defined(__linux__) && !defined(_WIN32)
+#	include <errno.h>
+#	include <fcntl.h>
+#	include <linux/io_uring.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <sys/syscall.h>
+#	include <unistd.h>
+#	if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter) && defined(__NR_io_uring_register)
+#		define USE_IO_URING
+#	endif
+#endif
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace VTFLib;
+using namespace VTFLib::IO;
+
+namespace VTFLib
+{
+	namespace IO
+	{
+		struct SAsyncJob
+		{
+			std::string FileName;
+			vlByte *lpData;
+			vlUInt uiSize;
+
+			vlBool bDone;
+			std::string Error;		// empty on success, without the "Error:" line LastError adds
+
+			SAsyncJob(const vlChar *cFileName) : FileName(cFileName), lpData(0), uiSize(0), bDone(vlFalse)
+			{
+
+			}
+
+			~SAsyncJob()
+			{
+				delete []this->lpData;
+			}
+		};
+
+#ifdef USE_IO_URING
+		#define URING_DEPTH			8						// reads in flight per I/O thread
+		#define URING_CHUNK			(1024 * 1024)			// bytes per read
+
+		//
+		// One io_uring per I/O thread, used to read a whole file as several
+		// chunks in flight at once instead of one pread() after another.  Set up
+		// with the raw system calls so there is no liburing dependency; if the
+		// kernel or a sandbox refuses, or the kernel can't read through a ring,
+		// Open() fails and the thread reads with CFileReader instead.
+		//
+		class CURing
+		{
+		private:
+			int iRing;
+
+			vlVoid *lpSQRing;
+			size_t uiSQRingSize;
+			vlVoid *lpCQRing;
+			size_t uiCQRingSize;
+			struct io_uring_sqe *lpSQEs;
+			size_t uiSQEsSize;
+
+			unsigned *lpSQTail;
+			unsigned uiSQMask;
+			unsigned *lpSQArray;
+
+			unsigned *lpCQHead;
+			unsigned *lpCQTail;
+			unsigned uiCQMask;
+			struct io_uring_cqe *lpCQEs;
+
+		public:
+			vlBool bBroken;			// a Read() failed with reads in flight
+			vlBool bDisabled;		// the ring failed rather than the file, so stop using it
+
+			CURing() : iRing(-1), lpSQRing(MAP_FAILED), uiSQRingSize(0), lpCQRing(MAP_FAILED), uiCQRingSize(0), lpSQEs((struct io_uring_sqe *)MAP_FAILED), uiSQEsSize(0), bBroken(vlFalse), bDisabled(vlFalse)
+			{
+
+			}
+
+			~CURing()
+			{
+				if(this->lpSQEs != MAP_FAILED)
+					munmap(this->lpSQEs, this->uiSQEsSize);
+				if(this->lpCQRing != MAP_FAILED && this->lpCQRing != this->lpSQRing)
+					munmap(this->lpCQRing, this->uiCQRingSize);
+				if(this->lpSQRing != MAP_FAILED)
+					munmap(this->lpSQRing, this->uiSQRingSize);
+				if(this->iRing != -1)
+					close(this->iRing);
+			}
+
+			vlBool Open();
+			vlBool Read(int iFile, vlByte *lpData, vlUInt uiSize);
+
+		private:
+			vlBool SupportsRead() const;
+
+			CURing(const CURing &);
+			CURing &operator=(const CURing &);
+		};
+#endif
+
+		//
+		// Everything the I/O threads share with the owner.  All members are guarded by
+		// Mutex except the data of a job while a single thread is working on it.
+		//
+		class CAsyncIOState
+		{
+		public:
+			std::mutex Mutex;
+			std::condition_variable WorkReady;		// I/O threads wait here
+			std::condition_variable ReadDone;		// ReadNext() waits here
+			std::condition_variable WriteDone;		// Write() and Flush() wait here
+
+			vlUInt uiReadLimit;
+			vlUInt uiWriteLimit;
+
+			std::deque<SAsyncJob *> Reads;			// queued and unconsumed, in queue order
+			vlUInt uiReadsStarted;					// the first uiReadsStarted of Reads are started
+			vlUInt64 uiReadBytes;					// held by started reads and Current
+			SAsyncJob *Current;						// the read last returned by ReadNext()
+
+			std::deque<SAsyncJob *> Writes;			// not yet started
+			vlUInt uiWritesRunning;
+			vlUInt64 uiWriteBytes;					// held by queued and running writes
+			vlUInt uiWriteFailures;
+			std::string WriteError;					// the first failure since the last Flush()
+
+			vlBool bStop;
+			std::vector<std::thread> Threads;
+
+			CAsyncIOState() : uiReadLimit(0), uiWriteLimit(0), uiReadsStarted(0), uiReadBytes(0), Current(0), uiWritesRunning(0), uiWriteBytes(0), uiWriteFailures(0), bStop(vlFalse)
+			{
+
+			}
+
+			~CAsyncIOState()
+			{
+				for(std::deque<SAsyncJob *>::iterator i = this->Reads.begin(); i != this->Reads.end(); ++i)
+				{
+					delete *i;
+				}
+				delete this->Current;
+			}
+
+			vlVoid Run();
+
+		private:
+			vlVoid Read(SAsyncJob *Job);
+#ifdef USE_IO_URING
+			vlVoid Read(SAsyncJob *Job, CURing &Ring);
+#endif
+			vlVoid Write(SAsyncJob *Job);
+		};
+	}
+}
+
+//
+// GetErrorMessage()
+// Gets the last error of this thread as it was passed to LastError.Set(), so it
+// can be set again on the owner's thread.
+//
+static std::string GetErrorMessage()
+{
+	const vlChar *cError = LastError.Get();
+	if(strncmp(cError, "Error:\n", 7) == 0)
+	{
+		cError += 7;
+	}
+	return cError;
+}
+
+#ifdef USE_IO_URING
+//
+// SupportsRead()
+// Asks the kernel if the ring can do IORING_OP_READ.  Kernels before 5.6 set
+// up a ring but fail every read with -EINVAL; they can't be probed either.
+//
+vlBool CURing::SupportsRead() const
+{
+	vlByte Buffer[sizeof(struct io_uring_probe) + 256 * sizeof(struct io_uring_probe_op)];
+	struct io_uring_probe *Probe = (struct io_uring_probe *)Buffer;
+	memset(Buffer, 0, sizeof(Buffer));
+
+	if(syscall(__NR_io_uring_register, this->iRing, IORING_REGISTER_PROBE, Probe, 256) < 0)
+	{
+		return vlFalse;
+	}
+
+	return Probe->last_op >= IORING_OP_READ && (Probe->ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED) != 0;
+}
+
+//
+// Open()
+// Sets up the ring and maps its queues.
+//
+vlBool CURing::Open()
+{
+	struct io_uring_params Params;
+	memset(&Params, 0, sizeof(Params));
+
+	this->iRing = (int)syscall(__NR_io_uring_setup, URING_DEPTH, &Params);
+	if(this->iRing == -1)
+	{
+		return vlFalse;
+	}
+
+	if(!this->SupportsRead())
+	{
+		return vlFalse;
+	}
+
+	this->uiSQRingSize = Params.sq_off.array + Params.sq_entries * sizeof(unsigned);
+	this->uiCQRingSize = Params.cq_off.cqes + Params.cq_entries * sizeof(struct io_uring_cqe);
+
+	// Newer kernels map both rings at once.
+	if(Params.features & IORING_FEAT_SINGLE_MMAP)
+	{
+		if(this->uiCQRingSize > this->uiSQRingSize)
+			this->uiSQRingSize = this->uiCQRingSize;
+		this->uiCQRingSize = this->uiSQRingSize;
+	}
+
+	this->lpSQRing = mmap(0, this->uiSQRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, this->iRing, IORING_OFF_SQ_RING);
+	if(this->lpSQRing == MAP_FAILED)
+	{
+		return vlFalse;
+	}
+
+	if(Params.features & IORING_FEAT_SINGLE_MMAP)
+	{
+		this->lpCQRing = this->lpSQRing;
+	}
+	else
+	{
+		this->lpCQRing = mmap(0, this->uiCQRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, this->iRing, IORING_OFF_CQ_RING);
+		if(this->lpCQRing == MAP_FAILED)
+		{
+			return vlFalse;
+		}
+	}
+
+	this->uiSQEsSize = Params.sq_entries * sizeof(struct io_uring_sqe);
+	this->lpSQEs = (struct io_uring_sqe *)mmap(0, this->uiSQEsSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, this->iRing, IORING_OFF_SQES);
+	if(this->lpSQEs == MAP_FAILED)
+	{
+		return vlFalse;
+	}
+
+	this->lpSQTail = (unsigned *)((vlByte *)this->lpSQRing + Params.sq_off.tail);
+	this->uiSQMask = *(unsigned *)((vlByte *)this->lpSQRing + Params.sq_off.ring_mask);
+	this->lpSQArray = (unsigned *)((vlByte *)this->lpSQRing + Params.sq_off.array);
+
+	this->lpCQHead = (unsigned *)((vlByte *)this->lpCQRing + Params.cq_off.head);
+	this->lpCQTail = (unsigned *)((vlByte *)this->lpCQRing + Params.cq_off.tail);
+	this->uiCQMask = *(unsigned *)((vlByte *)this->lpCQRing + Params.cq_off.ring_mask);
+	this->lpCQEs = (struct io_uring_cqe *)((vlByte *)this->lpCQRing + Params.cq_off.cqes);
+
+	return vlTrue;
+}
+
+//
+// Read()
+// Reads uiSize bytes from the start of iFile, keeping up to URING_DEPTH chunks
+// in flight.  A short read goes straight back in for the rest of its chunk.
+// On failure errno is set for LastError, and bDisabled is set if the ring
+// rather than the file was at fault.
+//
+vlBool CURing::Read(int iFile, vlByte *lpData, vlUInt uiSize)
+{
+	vlUInt uiOffsets[URING_DEPTH];
+	vlUInt uiLengths[URING_DEPTH];
+	vlUInt uiFree[URING_DEPTH];				// slots with nothing to do
+	vlUInt uiFreeCount = 0;
+	vlUInt uiRetry[URING_DEPTH];			// slots to submit again as they are
+	vlUInt uiRetryCount = 0;
+	vlUInt uiInFlight = 0;					// submitted, including those the kernel hasn't taken
+	vlUInt uiUnsubmitted = 0;				// queued but not yet taken by the kernel
+
+	for(vlUInt i = 0; i < URING_DEPTH; i++)
+	{
+		uiFree[uiFreeCount++] = URING_DEPTH - 1 - i;
+	}
+
+	vlUInt uiNext = 0;						// first byte not yet given to a slot
+	vlBool bResult = vlTrue;
+
+	while(uiInFlight != 0 || (bResult && (uiRetryCount != 0 || uiNext < uiSize)))
+	{
+		while(bResult && (uiRetryCount != 0 || (uiFreeCount != 0 && uiNext < uiSize)))
+		{
+			vlUInt uiSlot;
+			if(uiRetryCount != 0)
+			{
+				uiSlot = uiRetry[--uiRetryCount];
+			}
+			else
+			{
+				uiSlot = uiFree[--uiFreeCount];
+				uiOffsets[uiSlot] = uiNext;
+				uiLengths[uiSlot] = uiSize - uiNext < URING_CHUNK ? uiSize - uiNext : URING_CHUNK;
+				uiNext += uiLengths[uiSlot];
+			}
+
+			unsigned uiTail = *this->lpSQTail;
+			unsigned uiIndex = uiTail & this->uiSQMask;
+
+			struct io_uring_sqe *SQE = &this->lpSQEs[uiIndex];
+			memset(SQE, 0, sizeof(struct io_uring_sqe));
+			SQE->opcode = IORING_OP_READ;
+			SQE->fd = iFile;
+			SQE->addr = (unsigned long long)(size_t)(lpData + uiOffsets[uiSlot]);
+			SQE->len = uiLengths[uiSlot];
+			SQE->off = uiOffsets[uiSlot];
+			SQE->user_data = uiSlot;
+
+			this->lpSQArray[uiIndex] = uiIndex;
+			__atomic_store_n(this->lpSQTail, uiTail + 1, __ATOMIC_RELEASE);
+
+			uiUnsubmitted++;
+			uiInFlight++;
+		}
+
+		long lTaken = syscall(__NR_io_uring_enter, this->iRing, uiUnsubmitted, 1, IORING_ENTER_GETEVENTS, (void *)0, (size_t)0);
+		if(lTaken < 0)
+		{
+			if(errno == EINTR || errno == EAGAIN || errno == EBUSY)
+			{
+				continue;
+			}
+
+			// Reads the kernel took may still land in lpData, so neither the
+			// ring nor the buffer can be used again.
+			this->bBroken = vlTrue;
+			this->bDisabled = vlTrue;
+			return vlFalse;
+		}
+		uiUnsubmitted -= (vlUInt)lTaken;
+
+		unsigned uiHead = *this->lpCQHead;
+		unsigned uiTail = __atomic_load_n(this->lpCQTail, __ATOMIC_ACQUIRE);
+		for(; uiHead != uiTail; uiHead++)
+		{
+			const struct io_uring_cqe *CQE = &this->lpCQEs[uiHead & this->uiCQMask];
+			vlUInt uiSlot = (vlUInt)CQE->user_data;
+			uiInFlight--;
+
+			if(CQE->res == -EINTR || CQE->res == -EAGAIN)
+			{
+				uiRetry[uiRetryCount++] = uiSlot;
+			}
+			else if(CQE->res <= 0)
+			{
+				// The read failed, or the file shrank while it was being read.
+				// A ring that can't do the read at all won't do the next one.
+				if(CQE->res == -EINVAL || CQE->res == -EOPNOTSUPP)
+				{
+					this->bDisabled = vlTrue;
+				}
+				if(bResult)
+				{
+					errno = CQE->res < 0 ? -CQE->res : EIO;
+					bResult = vlFalse;
+				}
+				uiFree[uiFreeCount++] = uiSlot;
+			}
+			else if((vlUInt)CQE->res < uiLengths[uiSlot])
+			{
+				uiOffsets[uiSlot] += (vlUInt)CQE->res;
+				uiLengths[uiSlot] -= (vlUInt)CQE->res;
+				uiRetry[uiRetryCount++] = uiSlot;
+			}
+			else
+			{
+				uiFree[uiFreeCount++] = uiSlot;
+			}
+		}
+		__atomic_store_n(this->lpCQHead, uiHead, __ATOMIC_RELEASE);
+	}
+
+	return bResult;
+}
+#endif
+
+//
+// Run()
+// I/O thread body.  Writes come first since they free memory; reads only start
+// while the read ahead is under its limit.  A read that finds its file is
+// bigger than what is left still goes ahead, so the limit can be overshot by up
+// to one file per thread but the owner is never left waiting on nothing.
+//
+vlVoid CAsyncIOState::Run()
+{
+#ifdef USE_IO_URING
+	CURing Ring;
+	vlBool bRing = Ring.Open();
+#endif
+
+	std::unique_lock<std::mutex> Lock(this->Mutex);
+	while(true)
+	{
+		if(!this->Writes.empty())
+		{
+			SAsyncJob *Job = this->Writes.front();
+			this->Writes.pop_front();
+			this->uiWritesRunning++;
+
+			Lock.unlock();
+			this->Write(Job);
+			Lock.lock();
+
+			this->uiWritesRunning--;
+			this->uiWriteBytes -= Job->uiSize;
+			if(!Job->Error.empty())
+			{
+				if(this->uiWriteFailures++ == 0)
+				{
+					this->WriteError = Job->Error;
+				}
+			}
+			delete Job;
+
+			this->WriteDone.notify_all();
+			continue;
+		}
+
+		if(this->uiReadsStarted < (vlUInt)this->Reads.size() && this->uiReadBytes < this->uiReadLimit)
+		{
+			SAsyncJob *Job = this->Reads[this->uiReadsStarted++];
+
+			Lock.unlock();
+#ifdef USE_IO_URING
+			if(bRing && !Ring.bDisabled)
+			{
+				this->Read(Job, Ring);
+			}
+			else
+#endif
+			{
+				this->Read(Job);
+			}
+			Lock.lock();
+
+			this->uiReadBytes += Job->uiSize;
+			Job->bDone = vlTrue;
+
+			this->ReadDone.notify_all();
+			continue;
+		}
+
+		if(this->bStop)
+		{
+			break;
+		}
+
+		this->WorkReady.wait(Lock);
+	}
+}
+
+vlVoid CAsyncIOState::Read(SAsyncJob *Job)
+{
+	Readers::CFileReader Reader(Job->FileName.c_str());
+	if(!Reader.Open())
+	{
+		Job->Error = GetErrorMessage();
+		return;
+	}
+
+	vlUInt uiSize = Reader.GetStreamSize();
+
+	// The caller always gets a buffer back, even for an empty file.
+	Job->lpData = new vlByte[uiSize ? uiSize : 1];
+	if(Reader.Read(Job->lpData, uiSize) != uiSize)
+	{
+		Job->Error = "Failed to read whole file.";
+		delete []Job->lpData;
+		Job->lpData = 0;
+		Reader.Close();
+		return;
+	}
+	Job->uiSize = uiSize;
+
+	Reader.Close();
+}
+
+#ifdef USE_IO_URING
+vlVoid CAsyncIOState::Read(SAsyncJob *Job, CURing &Ring)
+{
+	int iFile = open(Job->FileName.c_str(), O_RDONLY | O_CLOEXEC);
+	if(iFile == -1)
+	{
+		LastError.Set("Error opening file.", vlTrue);
+		Job->Error = GetErrorMessage();
+		return;
+	}
+
+	struct stat Stat;
+	if(fstat(iFile, &Stat) != 0)
+	{
+		LastError.Set("Error opening file.", vlTrue);
+		Job->Error = GetErrorMessage();
+		close(iFile);
+		return;
+	}
+
+	vlUInt uiSize = (vlUInt)Stat.st_size;
+
+	Job->lpData = new vlByte[uiSize ? uiSize : 1];
+	if(!Ring.Read(iFile, Job->lpData, uiSize))
+	{
+		LastError.Set("Failed to read whole file.", vlTrue);
+		Job->Error = GetErrorMessage();
+
+		// A broken ring may still write into the buffer, so it is left alone.
+		if(!Ring.bBroken)
+		{
+			delete []Job->lpData;
+		}
+		Job->lpData = 0;
+
+		close(iFile);
+
+		// The file isn't at fault, so read it again without the ring.
+		if(Ring.bDisabled)
+		{
+			Job->Error.clear();
+			this->Read(Job);
+		}
+		return;
+	}
+	Job->uiSize = uiSize;
+
+	close(iFile);
+}
+#endif
+
+vlVoid CAsyncIOState::Write(SAsyncJob *Job)
+{
+	Writers::CFileWriter Writer(Job->FileName.c_str());
+	if(!Writer.Open())
+	{
+		Job->Error = GetErrorMessage();
+		return;
+	}
+
+	if(Writer.Write(Job->lpData, Job->uiSize) != Job->uiSize)
+	{
+		Job->Error = "Failed to write whole file.";
+		Writer.Close();
+		return;
+	}
+
+	// The file is only in place once it closes.
+	if(!Writer.Close())
+	{
+		Job->Error = GetErrorMessage();
+	}
+}
+
+CAsyncIO::CAsyncIO(vlUInt uiThreads, vlUInt uiMemoryLimit) : State(new CAsyncIOState())
+{
+	if(uiThreads == 0)
+	{
+		uiThreads = ASYNCIO_DEFAULT_THREADS;
+	}
+
+	if(uiMemoryLimit == 0)
+	{
+		uiMemoryLimit = ASYNCIO_DEFAULT_MEMORY_LIMIT;
+	}
+
+	this->State->uiReadLimit = uiMemoryLimit / 2;
+	this->State->uiWriteLimit = uiMemoryLimit - this->State->uiReadLimit;
+
+	for(vlUInt i = 0; i < uiThreads; i++)
+	{
+		this->State->Threads.push_back(std::thread(&CAsyncIOState::Run, this->State));
+	}
+}
+
+CAsyncIO::~CAsyncIO()
+{
+	this->Flush();
+
+	{
+		std::lock_guard<std::mutex> Lock(this->State->Mutex);
+
+		// Reads nobody will take back are dropped rather than finished.
+		while(this->State->Reads.size() > this->State->uiReadsStarted)
+		{
+			delete this->State->Reads.back();
+			this->State->Reads.pop_back();
+		}
+
+		this->State->bStop = vlTrue;
+	}
+	this->State->WorkReady.notify_all();
+
+	for(std::vector<std::thread>::iterator i = this->State->Threads.begin(); i != this->State->Threads.end(); ++i)
+	{
+		(*i).join();
+	}
+
+	delete this->State;
+}
+
+vlVoid CAsyncIO::QueueRead(const vlChar *cFileName)
+{
+	{
+		std::lock_guard<std::mutex> Lock(this->State->Mutex);
+		this->State->Reads.push_back(new SAsyncJob(cFileName));
+	}
+	this->State->WorkReady.notify_one();
+}
+
+vlBool CAsyncIO::HasNext() const
+{
+	std::lock_guard<std::mutex> Lock(this->State->Mutex);
+	return !this->State->Reads.empty();
+}
+
+vlBool CAsyncIO::ReadNext(const vlChar *&cFileName, const vlByte *&lpData, vlUInt &uiSize)
+{
+	std::unique_lock<std::mutex> Lock(this->State->Mutex);
+
+	// The last file handed out is finished with, which makes room to read further ahead.
+	if(this->State->Current != 0)
+	{
+		this->State->uiReadBytes -= this->State->Current->uiSize;
+		delete this->State->Current;
+		this->State->Current = 0;
+		this->State->WorkReady.notify_all();
+	}
+
+	if(this->State->Reads.empty())
+	{
+		cFileName = 0;
+		lpData = 0;
+		uiSize = 0;
+
+		LastError.Set("No reads queued.");
+		return vlFalse;
+	}
+
+	SAsyncJob *Job = this->State->Reads.front();
+	while(!Job->bDone)
+	{
+		this->State->ReadDone.wait(Lock);
+	}
+
+	this->State->Reads.pop_front();
+	this->State->uiReadsStarted--;
+	this->State->Current = Job;
+
+	cFileName = Job->FileName.c_str();
+	lpData = Job->lpData;
+	uiSize = Job->uiSize;
+
+	if(!Job->Error.empty())
+	{
+		LastError.Set(Job->Error.c_str());
+		return vlFalse;
+	}
+
+	return vlTrue;
+}
+
+vlBool CAsyncIO::Write(const vlChar *cFileName, const vlVoid *lpData, vlUInt uiSize)
+{
+	vlByte *lpCopy = new vlByte[uiSize ? uiSize : 1];
+	memcpy(lpCopy, lpData, uiSize);
+
+	return this->Queue(cFileName, lpCopy, uiSize);
+}
+
+vlBool CAsyncIO::Write(const vlChar *cFileName, const CVTFFile &Image)
+{
+	vlUInt uiBufferSize = Image.GetSize();
+	if(uiBufferSize == 0)
+	{
+		LastError.Set("No image to save.");
+		return vlFalse;
+	}
+
+	vlByte *lpData = new vlByte[uiBufferSize];
+
+	vlUInt uiSize = 0;
+	if(!Image.Save(lpData, uiBufferSize, uiSize))
+	{
+		delete []lpData;
+		return vlFalse;
+	}
+
+	return this->Queue(cFileName, lpData, uiSize);
+}
+
+//
+// Queue()
+// Takes ownership of lpData and queues it for writing, first waiting for room
+// if the writes in flight already hold their share of the memory limit.
+//
+vlBool CAsyncIO::Queue(const vlChar *cFileName, vlByte *lpData, vlUInt uiSize)
+{
+	SAsyncJob *Job = new SAsyncJob(cFileName);
+	Job->lpData = lpData;
+	Job->uiSize = uiSize;
+
+	{
+		std::unique_lock<std::mutex> Lock(this->State->Mutex);
+		while(this->State->uiWriteBytes != 0 && this->State->uiWriteBytes + uiSize > this->State->uiWriteLimit)
+		{
+			this->State->WriteDone.wait(Lock);
+		}
+
+		this->State->uiWriteBytes += uiSize;
+		this->State->Writes.push_back(Job);
+	}
+	this->State->WorkReady.notify_one();
+
+	return vlTrue;
+}
+
+vlBool CAsyncIO::Flush()
+{
+	std::unique_lock<std::mutex> Lock(this->State->Mutex);
+	while(!this->State->Writes.empty() || this->State->uiWritesRunning != 0)
+	{
+		this->State->WriteDone.wait(Lock);
+	}
+
+	vlUInt uiFailures = this->State->uiWriteFailures;
+	std::string Error = this->State->WriteError;
+
+	this->State->uiWriteFailures = 0;
+	this->State->WriteError.clear();
+
+	if(uiFailures != 0)
+	{
+		if(uiFailures == 1)
+		{
+			LastError.Set(Error.c_str());
+		}
+		else
+		{
+			LastError.SetFormatted("%u writes failed, the first with:\n%s", uiFailures, Error.c_str());
+		}
+		return vlFalse;
+	}
+
+	return vlTrue;
+}
+
+//
+// vlCreateAsyncIO()
+// Starts uiThreads I/O threads whose read ahead and write behind use at most
+// about uiMemoryLimit bytes together.  Pass 0 for either to use the default.
+//
+VTFLIB_API vlBool vlCreateAsyncIO(vlUInt uiThreads, vlUInt uiMemoryLimit, VLAsyncIO **AsyncIO)
+{
+	if(!bInitialized)
+	{
+		LastError.Set("VTFLib not initialized.");
+		return vlFalse;
+	}
+
+	*AsyncIO = reinterpret_cast<VLAsyncIO *>(new CAsyncIO(uiThreads, uiMemoryLimit));
+
+	return vlTrue;
+}
+
+//
+// vlDeleteAsyncIO()
+// Finishes every queued write, then stops the I/O threads.  Write errors are
+// lost; call vlAsyncIOFlush() first to see them.
+//
+VTFLIB_API vlVoid vlDeleteAsyncIO(VLAsyncIO *AsyncIO)
+{
+	delete reinterpret_cast<CAsyncIO *>(AsyncIO);
+}
+
+static CAsyncIO *FromHandle(VLAsyncIO *AsyncIO)
+{
+	if(AsyncIO == 0)
+	{
+		LastError.Set("Invalid async I/O.");
+		return 0;
+	}
+
+	return reinterpret_cast<CAsyncIO *>(AsyncIO);
+}
+
+VTFLIB_API vlVoid vlAsyncIOQueueRead(VLAsyncIO *AsyncIO, const vlChar *cFileName)
+{
+	CAsyncIO *Instance = FromHandle(AsyncIO);
+	if(Instance == 0)
+		return;
+
+	Instance->QueueRead(cFileName);
+}
+
+VTFLIB_API vlBool vlAsyncIOHasNext(VLAsyncIO *AsyncIO)
+{
+	CAsyncIO *Instance = FromHandle(AsyncIO);
+	if(Instance == 0)
+		return vlFalse;
+
+	return Instance->HasNext();
+}
+
+//
+// vlAsyncIOReadNext()
+// Gets the next queued file in queue order.  The data is valid until the next
+// call.  On failure cFileName is still set so the caller can report it.
+//
+VTFLIB_API vlBool vlAsyncIOReadNext(VLAsyncIO *AsyncIO, const vlChar **cFileName, const vlVoid **lpData, vlUInt *uiSize)
+{
+	CAsyncIO *Instance = FromHandle(AsyncIO);
+	if(Instance == 0)
+		return vlFalse;
+
+	const vlByte *lpBytes = 0;
+	vlBool bResult = Instance->ReadNext(*cFileName, lpBytes, *uiSize);
+	*lpData = lpBytes;
+
+	return bResult;
+}
+
+VTFLIB_API vlBool vlAsyncIOWrite(VLAsyncIO *AsyncIO, const vlChar *cFileName, const vlVoid *lpData, vlUInt uiSize)
+{
+	CAsyncIO *Instance = FromHandle(AsyncIO);
+	if(Instance == 0)
+		return vlFalse;
+
+	return Instance->Write(cFileName, lpData, uiSize);
+}
+
+//
+// vlAsyncIOWriteImage()
+// Queues the bound image to be written.  It is saved to memory first, so it
+// can be changed or deleted as soon as this returns.
+//
+VTFLIB_API vlBool vlAsyncIOWriteImage(VLAsyncIO *AsyncIO, const vlChar *cFileName)
+{
+	CAsyncIO *Instance = FromHandle(AsyncIO);
+	if(Instance == 0)
+		return vlFalse;
+
+	if(Image == 0)
+	{
+		LastError.Set("No image bound.");
+		return vlFalse;
+	}
+
+	return Instance->Write(cFileName, *Image);
+}
+
+VTFLIB_API vlBool vlContextAsyncIOWriteImage(VLAsyncIO *AsyncIO, VLContext *Context, vlUInt uiImage, const vlChar *cFileName)
+{
+	CAsyncIO *Instance = FromHandle(AsyncIO);
+	if(Instance == 0)
+		return vlFalse;
+
+	CHandleRef<CVTFFile> ContextImage(Context != 0 ? &CContext::FromHandle(Context)->GetImages() : 0, uiImage, "Invalid image.");
+	if(!ContextImage)
+		return vlFalse;
+
+	return Instance->Write(cFileName, *ContextImage.Get());
+}
+
+VTFLIB_API vlBool vlAsyncIOFlush(VLAsyncIO *AsyncIO)
+{
+	CAsyncIO *Instance = FromHandle(AsyncIO);
+	if(Instance == 0)
+		return vlFalse;
+
+	return Instance->Flush();
+}
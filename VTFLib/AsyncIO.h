@@ -0,0 +1,126 @@
+/*
+ * VTFLib
+ * Copyright (C) 2005-2010 Neil Jedrzejewski & Ryan Gregg
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later
+ * version.
+ */
+
+// ============================================================
+// NOTE: This file is commented for compatibility with Doxygen.
+// ============================================================
+/*!
+	\file AsyncIO.h
+	\brief Background file reads and writes for batch tools.
+*/
+
+#ifndef ASYNCIO_H
+#define ASYNCIO_H
+
+#include "stdafx.h"
+#include "AsyncIOWrapper.h"
+
+#define ASYNCIO_DEFAULT_THREADS			4
+#define ASYNCIO_DEFAULT_MEMORY_LIMIT	(256 * 1024 * 1024)
+
+namespace VTFLib
+{
+	class CVTFFile;
+
+	namespace IO
+	{
+		class CAsyncIOState;
+
+		//! Reads upcoming input files and writes finished output files in the background.
+		/*!
+			Batch tools queue every input file up front and take them back one at a time,
+			in queue order, with ReadNext(); files further down the queue are read while
+			the current one is being converted.  Finished files are handed to Write(),
+			which returns as soon as the data is queued.
+
+			Reads ahead and writes behind each hold at most about half of the memory
+			limit, so the queues stay bounded however long the batch is.  When the limit
+			is reached reads stop running ahead and Write() waits for earlier writes to
+			finish.
+
+			The I/O threads read and write with CFileReader and CFileWriter.  On Linux
+			each thread also sets up an io_uring and reads each file as several chunks
+			in flight at once; where the kernel or a sandbox refuses io_uring the thread
+			keeps to CFileReader.  Writes always go through CFileWriter, which replaces
+			the target in one step.
+
+			One thread may use an instance at a time.
+		*/
+		class VTFLIB_API CAsyncIO
+		{
+		private:
+			CAsyncIOState *State;
+
+		public:
+			//! Starts the I/O threads.
+			/*!
+				\param uiThreads is the number of I/O threads, 0 for the default.
+				\param uiMemoryLimit is the memory read ahead and write behind data may use together, 0 for the default.
+			*/
+			CAsyncIO(vlUInt uiThreads = 0, vlUInt uiMemoryLimit = 0);
+
+			//! Finishes all queued writes and stops the I/O threads.
+			~CAsyncIO();
+
+		private:
+			CAsyncIO(const CAsyncIO &);
+			CAsyncIO &operator=(const CAsyncIO &);
+
+		public:
+			//! Adds a file to the end of the read queue.
+			vlVoid QueueRead(const vlChar *cFileName);
+
+			//! Returns true if ReadNext() has a queued file to return.
+			vlBool HasNext() const;
+
+			//! Gets the next file in the read queue, waiting for it if it is still being read.
+			/*!
+				The data stays valid until the next call to ReadNext() or until the object
+				is destroyed.
+
+				\param cFileName is set to the file name, also on failure.
+				\param lpData is set to the file contents.
+				\param uiSize is set to the file size in bytes.
+				\return true on success, false if the file could not be read or nothing is queued.
+			*/
+			vlBool ReadNext(const vlChar *&cFileName, const vlByte *&lpData, vlUInt &uiSize);
+
+			//! Queues a copy of lpData to be written to cFileName.
+			/*!
+				Waits if the write queue is full.  Write errors are reported by Flush().
+
+				\return true if the write was queued.
+			*/
+			vlBool Write(const vlChar *cFileName, const vlVoid *lpData, vlUInt uiSize);
+
+			//! Saves Image to memory and queues it to be written to cFileName.
+			/*!
+				The image is serialized before this returns so it may be changed or
+				destroyed straight away.
+
+				\return true if the write was queued.
+			*/
+			vlBool Write(const vlChar *cFileName, const CVTFFile &Image);
+
+			//! Waits for every queued write to finish.
+			/*!
+				\return true if every write since the last Flush() succeeded, otherwise
+				false with the first failure as the last error.
+			*/
+			vlBool Flush();
+
+		private:
+			vlBool Queue(const vlChar *cFileName, vlByte *lpData, vlUInt uiSize);
+		};
+	}
+}
+
+#endif
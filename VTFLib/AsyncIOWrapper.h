@@ -0,0 +1,48 @@
+/*
+ * VTFLib
+ * Copyright (C) 2005-2010 Neil Jedrzejewski & Ryan Gregg
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later
+ * version.
+ */
+
+#ifndef ASYNCIOWRAPPER_H
+#define ASYNCIOWRAPPER_H
+
+#include "stdafx.h"
+#include "ContextWrapper.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//
+// Background reads and writes for batch tools.  Queue every input with
+// vlAsyncIOQueueRead() and take them back in order with vlAsyncIOReadNext();
+// later files are read while the current one is converted.  Finished files
+// are queued with vlAsyncIOWrite() and written while the next is converted.
+// One thread may use a VLAsyncIO at a time.
+//
+
+typedef struct tagVLAsyncIO VLAsyncIO;
+
+VTFLIB_API vlBool vlCreateAsyncIO(vlUInt uiThreads, vlUInt uiMemoryLimit, VLAsyncIO **AsyncIO);
+VTFLIB_API vlVoid vlDeleteAsyncIO(VLAsyncIO *AsyncIO);
+
+VTFLIB_API vlVoid vlAsyncIOQueueRead(VLAsyncIO *AsyncIO, const vlChar *cFileName);
+VTFLIB_API vlBool vlAsyncIOHasNext(VLAsyncIO *AsyncIO);
+VTFLIB_API vlBool vlAsyncIOReadNext(VLAsyncIO *AsyncIO, const vlChar **cFileName, const vlVoid **lpData, vlUInt *uiSize);
+
+VTFLIB_API vlBool vlAsyncIOWrite(VLAsyncIO *AsyncIO, const vlChar *cFileName, const vlVoid *lpData, vlUInt uiSize);
+VTFLIB_API vlBool vlAsyncIOWriteImage(VLAsyncIO *AsyncIO, const vlChar *cFileName);
+VTFLIB_API vlBool vlContextAsyncIOWriteImage(VLAsyncIO *AsyncIO, VLContext *Context, vlUInt uiImage, const vlChar *cFileName);
+VTFLIB_API vlBool vlAsyncIOFlush(VLAsyncIO *AsyncIO);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,1123 @@
+/*
+ * VTFLib
+ * Copyright (C) 2005-2010 Neil Jedrzejewski & Ryan Gregg
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later
+ * version.
+ */
+
+#include "VTFLib.h"
+#include "BSPFile.h"
+#include "CRC32.h"
+
+#ifndef _WIN32
+#	include <errno.h>
+#	include <fcntl.h>
+#	include <sys/stat.h>
+#	include <unistd.h>
+#endif
+
+#include <stddef.h>
+#include <time.h>
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace VTFLib;
+
+//
+// Map layout.
+//
+// SBSPHeader					lump offsets and lengths from the start of the file
+// lumps						each 4 byte aligned, in any order
+//
+// The pakfile lump is a zip of uncompressed files whose offsets are from the
+// start of the lump:
+//
+// for each file				SZipLocalHeader name extra data
+// directory					for each file SZipCentralHeader name extra comment
+// SZipEnd comment
+//
+// The game lump starts with a count and that many SBSPGameLump, whose offsets
+// are from the start of the file.
+//
+
+#define BSP_MIN_VERSION			17
+#define BSP_MAX_VERSION			21
+#define BSP_COPY_BUFFER_SIZE	(1024 * 1024)
+
+#define ZIP_LOCAL_SIGNATURE		0x04034b50
+#define ZIP_CENTRAL_SIGNATURE	0x02014b50
+#define ZIP_END_SIGNATURE		0x06054b50
+
+#pragma pack(1)
+
+struct SBSPHeader
+{
+	vlUInt uiIdent;				// BSP_IDENT
+	vlInt iVersion;
+	vlInt Lumps[BSP_LUMP_COUNT][4];	// Offset, length, version, four CC; Left 4 Dead 2 has version, offset, length, four CC.
+	vlInt iRevision;
+};
+
+struct SBSPGameLump
+{
+	vlInt iID;
+	vlUShort usFlags;
+	vlUShort usVersion;
+	vlInt iOffset;
+	vlInt iLength;
+};
+
+struct SZipLocalHeader
+{
+	vlUInt uiSignature;			// ZIP_LOCAL_SIGNATURE
+	vlUShort usVersionNeeded;
+	vlUShort usFlags;
+	vlUShort usMethod;
+	vlUShort usTime;
+	vlUShort usDate;
+	vlUInt uiCRC;
+	vlUInt uiCompressedSize;
+	vlUInt uiSize;
+	vlUShort usNameLength;
+	vlUShort usExtraLength;
+};
+
+struct SZipCentralHeader
+{
+	vlUInt uiSignature;			// ZIP_CENTRAL_SIGNATURE
+	vlUShort usVersionMadeBy;
+	vlUShort usVersionNeeded;
+	vlUShort usFlags;
+	vlUShort usMethod;
+	vlUShort usTime;
+	vlUShort usDate;
+	vlUInt uiCRC;
+	vlUInt uiCompressedSize;
+	vlUInt uiSize;
+	vlUShort usNameLength;
+	vlUShort usExtraLength;
+	vlUShort usCommentLength;
+	vlUShort usDisk;
+	vlUShort usInternalAttributes;
+	vlUInt uiExternalAttributes;
+	vlUInt uiLocalOffset;
+};
+
+struct SZipEnd
+{
+	vlUInt uiSignature;			// ZIP_END_SIGNATURE
+	vlUShort usDisk;
+	vlUShort usDirectoryDisk;
+	vlUShort usDiskEntries;
+	vlUShort usEntries;
+	vlUInt uiDirectorySize;
+	vlUInt uiDirectoryOffset;
+	vlUShort usCommentLength;
+};
+
+#pragma pack()
+
+// Numbers the temporary files saves write beside their maps.
+static std::atomic<vlUInt> uiTempCount(0);
+
+namespace VTFLib
+{
+	//
+	// A file read and written at given offsets.
+	//
+	class CBSPStream
+	{
+	private:
+#ifdef _WIN32
+		HANDLE hFile;
+#else
+		vlInt iFile;
+#endif
+
+	public:
+		CBSPStream()
+		{
+#ifdef _WIN32
+			this->hFile = INVALID_HANDLE_VALUE;
+#else
+			this->iFile = -1;
+#endif
+		}
+
+		~CBSPStream()
+		{
+			this->Close();
+		}
+
+		vlBool Opened() const
+		{
+#ifdef _WIN32
+			return this->hFile != INVALID_HANDLE_VALUE;
+#else
+			return this->iFile != -1;
+#endif
+		}
+
+		// Opens a file to read.
+		vlBool Open(const vlChar *cFileName)
+		{
+			this->Close();
+
+#ifdef _WIN32
+			this->hFile = CreateFileA(cFileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+#else
+			this->iFile = open(cFileName, O_RDONLY | O_CLOEXEC);
+#endif
+
+			if(!this->Opened())
+			{
+				LastError.SetFormatted("Error opening %s.", cFileName);
+				return vlFalse;
+			}
+
+			return vlTrue;
+		}
+
+		// Creates a new file beside cFileName to read and write and returns its
+		// name in TempName.  The name only has to be unique; creating it
+		// exclusively settles any race and never touches an existing file.
+		vlBool CreateTemp(const vlChar *cFileName, std::string &TempName)
+		{
+			this->Close();
+
+			for(vlUInt i = 0; i < 16; i++)
+			{
+				vlChar cSuffix[32];
+#ifdef _WIN32
+				sprintf(cSuffix, ".%u.%u.tmp", (vlUInt)GetCurrentProcessId(), uiTempCount++);
+				TempName = std::string(cFileName) + cSuffix;
+
+				this->hFile = CreateFileA(TempName.c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_NEW, FILE_ATTRIBUTE_NORMAL, NULL);
+
+				if(this->Opened() || GetLastError() != ERROR_FILE_EXISTS)
+				{
+					break;
+				}
+#else
+				sprintf(cSuffix, ".%u.%u.tmp", (vlUInt)getpid(), uiTempCount++);
+				TempName = std::string(cFileName) + cSuffix;
+
+				this->iFile = open(TempName.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0666);
+
+				if(this->Opened() || errno != EEXIST)
+				{
+					break;
+				}
+#endif
+			}
+
+			if(!this->Opened())
+			{
+				LastError.SetFormatted("Error creating %s.", TempName.c_str());
+				return vlFalse;
+			}
+
+			return vlTrue;
+		}
+
+		vlVoid Close()
+		{
+#ifdef _WIN32
+			if(this->hFile != INVALID_HANDLE_VALUE)
+				CloseHandle(this->hFile);
+			this->hFile = INVALID_HANDLE_VALUE;
+#else
+			if(this->iFile != -1)
+				close(this->iFile);
+			this->iFile = -1;
+#endif
+		}
+
+		vlUInt64 GetSize() const
+		{
+#ifdef _WIN32
+			LARGE_INTEGER Size;
+			return GetFileSizeEx(this->hFile, &Size) ? (vlUInt64)Size.QuadPart : 0;
+#else
+			struct stat Stat;
+			return fstat(this->iFile, &Stat) == 0 ? (vlUInt64)Stat.st_size : 0;
+#endif
+		}
+
+		vlBool Read(vlUInt64 uiOffset, vlVoid *lpData, vlUInt uiSize) const
+		{
+#ifdef _WIN32
+			OVERLAPPED Overlapped = { 0 };
+			Overlapped.Offset = (DWORD)uiOffset;
+			Overlapped.OffsetHigh = (DWORD)(uiOffset >> 32);
+
+			DWORD dwRead = 0;
+			if(!ReadFile(this->hFile, lpData, uiSize, &dwRead, &Overlapped) || dwRead != uiSize)
+			{
+				LastError.Set("Error reading file.", vlTrue);
+				return vlFalse;
+			}
+#else
+			vlByte *lpBytes = static_cast<vlByte *>(lpData);
+			while(uiSize != 0)
+			{
+				ssize_t iRead = pread(this->iFile, lpBytes, uiSize, (off_t)uiOffset);
+				if(iRead <= 0)
+				{
+					if(iRead < 0 && errno == EINTR)
+						continue;
+
+					LastError.Set(iRead == 0 ? "Unexpected end of file." : "Error reading file.", iRead < 0);
+					return vlFalse;
+				}
+
+				lpBytes += iRead;
+				uiOffset += (vlUInt64)iRead;
+				uiSize -= (vlUInt)iRead;
+			}
+#endif
+
+			return vlTrue;
+		}
+
+		vlBool Write(vlUInt64 uiOffset, const vlVoid *lpData, vlUInt uiSize)
+		{
+#ifdef _WIN32
+			OVERLAPPED Overlapped = { 0 };
+			Overlapped.Offset = (DWORD)uiOffset;
+			Overlapped.OffsetHigh = (DWORD)(uiOffset >> 32);
+
+			DWORD dwWritten = 0;
+			if(!WriteFile(this->hFile, lpData, uiSize, &dwWritten, &Overlapped) || dwWritten != uiSize)
+			{
+				LastError.Set("Error writing file.", vlTrue);
+				return vlFalse;
+			}
+#else
+			const vlByte *lpBytes = static_cast<const vlByte *>(lpData);
+			while(uiSize != 0)
+			{
+				ssize_t iWritten = pwrite(this->iFile, lpBytes, uiSize, (off_t)uiOffset);
+				if(iWritten <= 0)
+				{
+					if(iWritten < 0 && errno == EINTR)
+						continue;
+
+					LastError.Set("Error writing file.", vlTrue);
+					return vlFalse;
+				}
+
+				lpBytes += iWritten;
+				uiOffset += (vlUInt64)iWritten;
+				uiSize -= (vlUInt)iWritten;
+			}
+#endif
+
+			return vlTrue;
+		}
+
+		// Copies bytes from another file.  On Linux the kernel does it, sharing
+		// the blocks where the file system can; otherwise, or if it can't
+		// (different file systems, older kernels), they go through a buffer.
+		vlBool Copy(const CBSPStream &Source, vlUInt64 uiSourceOffset, vlUInt64 uiOffset, vlUInt64 uiSize)
+		{
+#if defined(__linux__) && !defined(_WIN32)
+			while(uiSize != 0)
+			{
+				loff_t lIn = (loff_t)uiSourceOffset, lOut = (loff_t)uiOffset;
+				ssize_t iCopied = copy_file_range(Source.iFile, &lIn, this->iFile, &lOut, (size_t)std::min<vlUInt64>(uiSize, 0x40000000), 0);
+				if(iCopied <= 0)
+				{
+					if(iCopied < 0 && errno == EINTR)
+						continue;
+
+					break;
+				}
+
+				uiSourceOffset += (vlUInt64)iCopied;
+				uiOffset += (vlUInt64)iCopied;
+				uiSize -= (vlUInt64)iCopied;
+			}
+#endif
+
+			if(uiSize == 0)
+			{
+				return vlTrue;
+			}
+
+			std::vector<vlByte> Buffer((vlUInt)std::min<vlUInt64>(uiSize, BSP_COPY_BUFFER_SIZE));
+			while(uiSize != 0)
+			{
+				vlUInt uiChunk = (vlUInt)std::min<vlUInt64>(uiSize, Buffer.size());
+				if(!Source.Read(uiSourceOffset, &Buffer[0], uiChunk) || !this->Write(uiOffset, &Buffer[0], uiChunk))
+				{
+					return vlFalse;
+				}
+
+				uiSourceOffset += uiChunk;
+				uiOffset += uiChunk;
+				uiSize -= uiChunk;
+			}
+
+			return vlTrue;
+		}
+	};
+
+	struct SBSPEntry
+	{
+		std::string Name;
+		vlUInt uiCRC;
+		vlUInt uiSize;
+
+		vlUInt uiOffset;				// Local header in the pakfile as opened.
+		vlUInt uiExtent;				// Local header, data and anything else up to the next entry.
+		std::vector<vlByte> Central;	// Directory record as opened, with its name, extra and comment.
+
+		vlBool bAdded;					// Written from Data instead.
+		std::vector<vlByte> Data;
+		vlUShort usTime;
+		vlUShort usDate;
+	};
+
+	class CBSPFileState
+	{
+	public:
+		std::string FileName;
+		CBSPStream File;
+		vlUInt64 uiFileSize;
+
+		SBSPHeader Header;
+		vlUInt uiOffsetField;
+		vlUInt uiLengthField;
+
+		vlUInt uiDirectoryOffset;		// Of the zip directory in the pakfile as opened, where its entries end.
+		std::vector<vlByte> Comment;
+
+		std::vector<SBSPEntry> Entries;
+		std::map<std::string, vlUInt> Index;	// Entry by normalized path; the first of any duplicates.
+
+	public:
+		vlUInt GetLumpOffset(vlUInt uiLump) const
+		{
+			return (vlUInt)this->Header.Lumps[uiLump][this->uiOffsetField];
+		}
+
+		vlUInt GetLumpLength(vlUInt uiLump) const
+		{
+			return (vlUInt)this->Header.Lumps[uiLump][this->uiLengthField];
+		}
+	};
+}
+
+//
+// NormalizePath()
+// Folds case and slashes the way the engine looks files up.
+//
+static std::string NormalizePath(const vlChar *cPath)
+{
+	std::string Path = cPath;
+	for(std::string::iterator i = Path.begin(); i != Path.end(); ++i)
+	{
+		*i = *i == '\\' ? '/' : (vlChar)tolower((vlByte)*i);
+	}
+
+	return Path;
+}
+
+//
+// LumpsFit()
+// Checks that every lump is inside the file when the header is read with the
+// given field order.
+//
+static vlBool LumpsFit(const SBSPHeader &Header, vlUInt uiOffsetField, vlUInt uiLengthField, vlUInt64 uiFileSize)
+{
+	for(vlUInt i = 0; i < BSP_LUMP_COUNT; i++)
+	{
+		vlInt iOffset = Header.Lumps[i][uiOffsetField];
+		vlInt iLength = Header.Lumps[i][uiLengthField];
+
+		if(iOffset < 0 || iLength < 0)
+		{
+			return vlFalse;
+		}
+
+		if(iLength != 0 && ((vlUInt)iOffset < sizeof(SBSPHeader) || (vlUInt64)iOffset + (vlUInt64)iLength > uiFileSize))
+		{
+			return vlFalse;
+		}
+	}
+
+	return vlTrue;
+}
+
+//
+// GetDOSTime()
+// Gets the current local time the way zip stores it.
+//
+static vlVoid GetDOSTime(vlUShort &usTime, vlUShort &usDate)
+{
+	time_t Now = time(0);
+	struct tm Time;
+#ifdef _WIN32
+	localtime_s(&Time, &Now);
+#else
+	localtime_r(&Now, &Time);
+#endif
+
+	usTime = (vlUShort)((Time.tm_hour << 11) | (Time.tm_min << 5) | (Time.tm_sec / 2));
+	usDate = (vlUShort)(((Time.tm_year - 80) << 9) | ((Time.tm_mon + 1) << 5) | Time.tm_mday);
+}
+
+CBSPFile::CBSPFile() : State(new CBSPFileState())
+{
+
+}
+
+CBSPFile::~CBSPFile()
+{
+	delete this->State;
+}
+
+vlBool CBSPFile::Open(const vlChar *cFileName)
+{
+	this->Close();
+
+	CBSPFileState *State = this->State;
+
+	if(!State->File.Open(cFileName))
+	{
+		return vlFalse;
+	}
+
+	State->FileName = cFileName;
+	State->uiFileSize = State->File.GetSize();
+
+	SBSPHeader &Header = State->Header;
+	if(State->uiFileSize < sizeof(SBSPHeader) || !State->File.Read(0, &Header, sizeof(SBSPHeader))
+		|| Header.uiIdent != BSP_IDENT || Header.iVersion < BSP_MIN_VERSION || Header.iVersion > BSP_MAX_VERSION)
+	{
+		this->Close();
+		LastError.SetFormatted("%s is not a Source map.", cFileName);
+		return vlFalse;
+	}
+
+	// Left 4 Dead 2 moved the lump version first without changing the map
+	// version, so read the header whichever way puts every lump in the file.
+	if(LumpsFit(Header, 0, 1, State->uiFileSize))
+	{
+		State->uiOffsetField = 0;
+		State->uiLengthField = 1;
+	}
+	else if(Header.iVersion == 21 && LumpsFit(Header, 1, 2, State->uiFileSize))
+	{
+		State->uiOffsetField = 1;
+		State->uiLengthField = 2;
+	}
+	else
+	{
+		this->Close();
+		LastError.SetFormatted("%s is truncated.", cFileName);
+		return vlFalse;
+	}
+
+	vlUInt uiPakOffset = State->GetLumpOffset(BSP_LUMP_PAKFILE);
+	vlUInt uiPakLength = State->GetLumpLength(BSP_LUMP_PAKFILE);
+
+	if(uiPakLength == 0)
+	{
+		State->uiDirectoryOffset = 0;
+		return vlTrue;
+	}
+
+	// The end record is the last thing in the zip, before its comment.
+	vlUInt uiTailLength = std::min<vlUInt>(uiPakLength, sizeof(SZipEnd) + 0xffff);
+	vlUInt uiTailOffset = uiPakLength - uiTailLength;
+	std::vector<vlByte> Tail(uiTailLength);
+	if(!State->File.Read(uiPakOffset + uiTailOffset, &Tail[0], uiTailLength))
+	{
+		this->Close();
+		return vlFalse;
+	}
+
+	SZipEnd End;
+	vlBool bFound = vlFalse;
+	for(vlUInt i = uiTailLength >= sizeof(SZipEnd) ? uiTailLength - sizeof(SZipEnd) + 1 : 0; i-- > 0;)
+	{
+		memcpy(&End, &Tail[i], sizeof(SZipEnd));
+		if(End.uiSignature == ZIP_END_SIGNATURE && i + sizeof(SZipEnd) + End.usCommentLength <= uiTailLength)
+		{
+			State->Comment.assign(Tail.begin() + i + sizeof(SZipEnd), Tail.begin() + i + sizeof(SZipEnd) + End.usCommentLength);
+			uiTailOffset += i;
+			bFound = vlTrue;
+			break;
+		}
+	}
+
+	if(!bFound || End.usDisk != 0 || End.usDirectoryDisk != 0 || End.usDiskEntries != End.usEntries
+		|| End.uiDirectoryOffset > uiTailOffset || End.uiDirectorySize > uiTailOffset - End.uiDirectoryOffset)
+	{
+		this->Close();
+		LastError.SetFormatted("%s has an invalid pakfile.", cFileName);
+		return vlFalse;
+	}
+
+	State->uiDirectoryOffset = End.uiDirectoryOffset;
+
+	std::vector<vlByte> Directory(End.uiDirectorySize);
+	if(!Directory.empty() && !State->File.Read(uiPakOffset + End.uiDirectoryOffset, &Directory[0], End.uiDirectorySize))
+	{
+		this->Close();
+		return vlFalse;
+	}
+
+	vlBool bValid = vlTrue;
+	vlUInt uiPointer = 0;
+	State->Entries.resize(End.usEntries);
+	for(vlUInt i = 0; i < End.usEntries && bValid; i++)
+	{
+		SZipCentralHeader Central;
+		if(Directory.size() - uiPointer < sizeof(SZipCentralHeader))
+		{
+			bValid = vlFalse;
+			break;
+		}
+		memcpy(&Central, &Directory[uiPointer], sizeof(SZipCentralHeader));
+
+		vlUInt uiRecordSize = sizeof(SZipCentralHeader) + Central.usNameLength + Central.usExtraLength + Central.usCommentLength;
+		if(Central.uiSignature != ZIP_CENTRAL_SIGNATURE || Directory.size() - uiPointer < uiRecordSize
+			|| Central.uiLocalOffset >= End.uiDirectoryOffset)
+		{
+			bValid = vlFalse;
+			break;
+		}
+
+		SBSPEntry &Entry = State->Entries[i];
+		Entry.Name.assign(reinterpret_cast<const vlChar *>(&Directory[uiPointer + sizeof(SZipCentralHeader)]), Central.usNameLength);
+		Entry.uiCRC = Central.uiCRC;
+		Entry.uiSize = Central.uiSize;
+		Entry.uiOffset = Central.uiLocalOffset;
+		Entry.uiExtent = 0;
+		Entry.Central.assign(Directory.begin() + uiPointer, Directory.begin() + uiPointer + uiRecordSize);
+		Entry.bAdded = vlFalse;
+		Entry.usTime = Central.usTime;
+		Entry.usDate = Central.usDate;
+
+		State->Index.insert(std::make_pair(NormalizePath(Entry.Name.c_str()), i));
+
+		uiPointer += uiRecordSize;
+	}
+
+	// Each entry runs to the next one, or to the directory, so whatever is
+	// stored between them (data descriptors, padding) moves with it.
+	std::vector<vlUInt> Order(State->Entries.size());
+	for(vlUInt i = 0; i < (vlUInt)Order.size(); i++)
+	{
+		Order[i] = i;
+	}
+	std::sort(Order.begin(), Order.end(), [State](vlUInt uiA, vlUInt uiB) { return State->Entries[uiA].uiOffset < State->Entries[uiB].uiOffset; });
+
+	for(vlUInt i = 0; i < (vlUInt)Order.size() && bValid; i++)
+	{
+		SBSPEntry &Entry = State->Entries[Order[i]];
+		vlUInt uiNext = i + 1 < (vlUInt)Order.size() ? State->Entries[Order[i + 1]].uiOffset : End.uiDirectoryOffset;
+
+		Entry.uiExtent = uiNext - Entry.uiOffset;
+		bValid = Entry.uiExtent >= sizeof(SZipLocalHeader);
+	}
+
+	if(!bValid || uiPointer != Directory.size())
+	{
+		this->Close();
+		LastError.SetFormatted("%s has an invalid pakfile directory.", cFileName);
+		return vlFalse;
+	}
+
+	return vlTrue;
+}
+
+vlBool CBSPFile::Save(const vlChar *cFileName)
+{
+	CBSPFileState *State = this->State;
+
+	if(!State->File.Opened())
+	{
+		LastError.Set("No map open.");
+		return vlFalse;
+	}
+
+	vlBool bPakfile = State->GetLumpLength(BSP_LUMP_PAKFILE) != 0;
+
+	// A map without a pakfile gets one on the end.  Otherwise it is rewritten
+	// where it is and everything after it moves.
+	vlUInt64 uiPakOffset = bPakfile ? State->GetLumpOffset(BSP_LUMP_PAKFILE) : (State->uiFileSize + 3) & ~(vlUInt64)3;
+	vlUInt64 uiTrailing = bPakfile ? uiPakOffset + State->GetLumpLength(BSP_LUMP_PAKFILE) : State->uiFileSize;
+
+	// Entries that are kept go first, in their old order, so runs of them copy
+	// in one go.  Added entries follow, then the directory.
+	std::vector<vlUInt> Order;
+	for(vlUInt i = 0; i < (vlUInt)State->Entries.size(); i++)
+	{
+		if(!State->Entries[i].bAdded)
+			Order.push_back(i);
+	}
+	std::sort(Order.begin(), Order.end(), [State](vlUInt uiA, vlUInt uiB) { return State->Entries[uiA].uiOffset < State->Entries[uiB].uiOffset; });
+	vlUInt uiKept = (vlUInt)Order.size();
+	for(vlUInt i = 0; i < (vlUInt)State->Entries.size(); i++)
+	{
+		if(State->Entries[i].bAdded)
+			Order.push_back(i);
+	}
+
+	vlUInt64 uiPakSize = 0;
+	std::vector<vlByte> Directory;
+	for(vlUInt i = 0; i < (vlUInt)Order.size(); i++)
+	{
+		const SBSPEntry &Entry = State->Entries[Order[i]];
+		vlUInt uiLocalOffset = (vlUInt)uiPakSize;
+
+		if(Entry.bAdded)
+		{
+			SZipCentralHeader Central;
+			Central.uiSignature = ZIP_CENTRAL_SIGNATURE;
+			Central.usVersionMadeBy = 20;
+			Central.usVersionNeeded = 10;
+			Central.usFlags = 0;
+			Central.usMethod = 0;
+			Central.usTime = Entry.usTime;
+			Central.usDate = Entry.usDate;
+			Central.uiCRC = Entry.uiCRC;
+			Central.uiCompressedSize = Entry.uiSize;
+			Central.uiSize = Entry.uiSize;
+			Central.usNameLength = (vlUShort)Entry.Name.size();
+			Central.usExtraLength = 0;
+			Central.usCommentLength = 0;
+			Central.usDisk = 0;
+			Central.usInternalAttributes = 0;
+			Central.uiExternalAttributes = 0;
+			Central.uiLocalOffset = uiLocalOffset;
+
+			const vlByte *lpCentral = reinterpret_cast<const vlByte *>(&Central);
+			Directory.insert(Directory.end(), lpCentral, lpCentral + sizeof(SZipCentralHeader));
+			Directory.insert(Directory.end(), Entry.Name.begin(), Entry.Name.end());
+
+			uiPakSize += sizeof(SZipLocalHeader) + Entry.Name.size() + Entry.Data.size();
+		}
+		else
+		{
+			vlUInt uiRecord = (vlUInt)Directory.size();
+			Directory.insert(Directory.end(), Entry.Central.begin(), Entry.Central.end());
+			memcpy(&Directory[uiRecord + offsetof(SZipCentralHeader, uiLocalOffset)], &uiLocalOffset, sizeof(vlUInt));
+
+			uiPakSize += Entry.uiExtent;
+		}
+	}
+
+	SZipEnd End;
+	End.uiSignature = ZIP_END_SIGNATURE;
+	End.usDisk = 0;
+	End.usDirectoryDisk = 0;
+	End.usDiskEntries = (vlUShort)Order.size();
+	End.usEntries = (vlUShort)Order.size();
+	End.uiDirectorySize = (vlUInt)Directory.size();
+	End.uiDirectoryOffset = (vlUInt)uiPakSize;
+	End.usCommentLength = (vlUShort)State->Comment.size();
+
+	const vlByte *lpEnd = reinterpret_cast<const vlByte *>(&End);
+	Directory.insert(Directory.end(), lpEnd, lpEnd + sizeof(SZipEnd));
+	Directory.insert(Directory.end(), State->Comment.begin(), State->Comment.end());
+
+	vlUInt64 uiDirectoryOffset = uiPakSize;
+	uiPakSize += Directory.size();
+
+	if(Order.size() > 0xffff || uiPakSize > 0x7fffffff)
+	{
+		LastError.Set("Pakfile is too large.");
+		return vlFalse;
+	}
+
+	// Keep the lumps after the pakfile on the same 4 byte alignment.
+	vlUInt64 uiPadding = (uiTrailing - (uiPakOffset + uiPakSize)) & 3;
+	vlUInt64 uiNewTrailing = uiPakOffset + uiPakSize + uiPadding;
+
+	SBSPHeader Header = State->Header;
+	for(vlUInt i = 0; i < BSP_LUMP_COUNT; i++)
+	{
+		vlUInt64 uiOffset = (vlUInt)Header.Lumps[i][State->uiOffsetField];
+		if(i == BSP_LUMP_PAKFILE || !bPakfile || uiOffset < uiTrailing)
+		{
+			continue;
+		}
+
+		uiOffset = uiOffset - uiTrailing + uiNewTrailing;
+		if(uiOffset > 0x7fffffff)
+		{
+			LastError.Set("Map is too large.");
+			return vlFalse;
+		}
+		Header.Lumps[i][State->uiOffsetField] = (vlInt)uiOffset;
+	}
+
+	Header.Lumps[BSP_LUMP_PAKFILE][State->uiOffsetField] = (vlInt)uiPakOffset;
+	Header.Lumps[BSP_LUMP_PAKFILE][State->uiLengthField] = (vlInt)uiPakSize;
+	Header.Lumps[BSP_LUMP_PAKFILE][3] = 0;	// The uncompressed size of compressed lumps; the pakfile never is.
+
+	// Write beside the target and swap it in, so an interrupted save never
+	// leaves half a map.
+	std::string Temp;
+	CBSPStream Output;
+	if(!Output.CreateTemp(cFileName, Temp))
+	{
+		return vlFalse;
+	}
+
+	const vlByte Zero[4] = { 0, 0, 0, 0 };
+	vlUInt64 uiLeading = std::min<vlUInt64>(uiPakOffset, State->uiFileSize);
+
+	vlBool bWritten = Output.Copy(State->File, 0, 0, uiLeading)
+		&& (uiLeading == uiPakOffset || Output.Write(uiLeading, Zero, (vlUInt)(uiPakOffset - uiLeading)));
+
+	// Runs of kept entries that were next to each other copy in one go.
+	vlUInt64 uiWriteOffset = uiPakOffset;
+	for(vlUInt i = 0; i < uiKept && bWritten;)
+	{
+		vlUInt64 uiRunOffset = State->Entries[Order[i]].uiOffset;
+		vlUInt64 uiRunSize = 0;
+
+		do
+		{
+			uiRunSize += State->Entries[Order[i]].uiExtent;
+			i++;
+		}
+		while(i < uiKept && State->Entries[Order[i]].uiOffset == uiRunOffset + uiRunSize);
+
+		bWritten = Output.Copy(State->File, uiPakOffset + uiRunOffset, uiWriteOffset, uiRunSize);
+		uiWriteOffset += uiRunSize;
+	}
+
+	for(vlUInt i = uiKept; i < (vlUInt)Order.size() && bWritten; i++)
+	{
+		const SBSPEntry &Entry = State->Entries[Order[i]];
+
+		SZipLocalHeader Local;
+		Local.uiSignature = ZIP_LOCAL_SIGNATURE;
+		Local.usVersionNeeded = 10;
+		Local.usFlags = 0;
+		Local.usMethod = 0;
+		Local.usTime = Entry.usTime;
+		Local.usDate = Entry.usDate;
+		Local.uiCRC = Entry.uiCRC;
+		Local.uiCompressedSize = Entry.uiSize;
+		Local.uiSize = Entry.uiSize;
+		Local.usNameLength = (vlUShort)Entry.Name.size();
+		Local.usExtraLength = 0;
+
+		std::vector<vlByte> Record(sizeof(SZipLocalHeader) + Entry.Name.size());
+		memcpy(&Record[0], &Local, sizeof(SZipLocalHeader));
+		memcpy(&Record[sizeof(SZipLocalHeader)], Entry.Name.data(), Entry.Name.size());
+
+		bWritten = Output.Write(uiWriteOffset, &Record[0], (vlUInt)Record.size())
+			&& (Entry.Data.empty() || Output.Write(uiWriteOffset + Record.size(), &Entry.Data[0], (vlUInt)Entry.Data.size()));
+		uiWriteOffset += Record.size() + Entry.Data.size();
+	}
+
+	bWritten = bWritten
+		&& Output.Write(uiPakOffset + uiDirectoryOffset, &Directory[0], (vlUInt)Directory.size())
+		&& (uiPadding == 0 || Output.Write(uiPakOffset + uiPakSize, Zero, (vlUInt)uiPadding))
+		&& Output.Copy(State->File, uiTrailing, uiNewTrailing, State->uiFileSize - uiTrailing)
+		&& Output.Write(0, &Header, sizeof(SBSPHeader));
+
+	// The game lump points at its parts by file offset, so move those too.
+	vlUInt uiGameOffset = (vlUInt)Header.Lumps[BSP_LUMP_GAME][State->uiOffsetField];
+	vlUInt uiGameLength = (vlUInt)Header.Lumps[BSP_LUMP_GAME][State->uiLengthField];
+	if(bWritten && bPakfile && uiNewTrailing != uiTrailing && uiGameLength >= sizeof(vlInt))
+	{
+		vlInt iCount = 0;
+		bWritten = Output.Read(uiGameOffset, &iCount, sizeof(vlInt));
+
+		vlUInt uiCount = iCount < 0 ? 0 : std::min<vlUInt>((vlUInt)iCount, (uiGameLength - sizeof(vlInt)) / sizeof(SBSPGameLump));
+		std::vector<SBSPGameLump> GameLumps(uiCount);
+		if(bWritten && uiCount != 0)
+		{
+			vlUInt uiSize = uiCount * sizeof(SBSPGameLump);
+			bWritten = Output.Read(uiGameOffset + sizeof(vlInt), &GameLumps[0], uiSize);
+
+			for(vlUInt i = 0; i < uiCount && bWritten; i++)
+			{
+				if(GameLumps[i].iOffset >= 0 && (vlUInt64)GameLumps[i].iOffset >= uiTrailing)
+				{
+					GameLumps[i].iOffset = (vlInt)((vlUInt64)GameLumps[i].iOffset - uiTrailing + uiNewTrailing);
+				}
+			}
+
+			bWritten = bWritten && Output.Write(uiGameOffset + sizeof(vlInt), &GameLumps[0], uiSize);
+		}
+	}
+
+	Output.Close();
+
+	// The map can't be replaced while it is open.  If that fails the old
+	// one is untouched, so carry on with it.
+	State->File.Close();
+
+#ifdef _WIN32
+	vlBool bReplaced = bWritten && MoveFileExA(Temp.c_str(), cFileName, MOVEFILE_REPLACE_EXISTING);
+	if(!bReplaced)
+		DeleteFileA(Temp.c_str());
+#else
+	vlBool bReplaced = bWritten && rename(Temp.c_str(), cFileName) == 0;
+	if(!bReplaced)
+		unlink(Temp.c_str());
+#endif
+
+	if(!bReplaced)
+	{
+		if(bWritten)
+		{
+			LastError.SetFormatted("Error replacing %s.", cFileName);
+		}
+
+		State->File.Open(State->FileName.c_str());
+		return vlFalse;
+	}
+
+	return this->Open(cFileName);
+}
+
+vlVoid CBSPFile::Close()
+{
+	CBSPFileState *State = this->State;
+
+	State->File.Close();
+	State->FileName.clear();
+	State->uiFileSize = 0;
+	State->uiDirectoryOffset = 0;
+	State->Comment.clear();
+	State->Entries.clear();
+	State->Index.clear();
+}
+
+vlUInt CBSPFile::GetEntryCount() const
+{
+	return (vlUInt)this->State->Entries.size();
+}
+
+vlUInt CBSPFile::FindEntry(const vlChar *cPath) const
+{
+	std::map<std::string, vlUInt>::const_iterator i = this->State->Index.find(NormalizePath(cPath));
+
+	return i != this->State->Index.end() ? i->second : BSP_INVALID_INDEX;
+}
+
+const vlChar *CBSPFile::GetEntryName(vlUInt uiEntry) const
+{
+	if(uiEntry >= this->State->Entries.size())
+	{
+		LastError.Set("Invalid entry index.");
+		return 0;
+	}
+
+	return this->State->Entries[uiEntry].Name.c_str();
+}
+
+vlUInt CBSPFile::GetEntrySize(vlUInt uiEntry) const
+{
+	if(uiEntry >= this->State->Entries.size())
+	{
+		LastError.Set("Invalid entry index.");
+		return 0;
+	}
+
+	return this->State->Entries[uiEntry].uiSize;
+}
+
+vlBool CBSPFile::Add(const vlChar *cPath, const vlVoid *lpData, vlUInt uiSize)
+{
+	CBSPFileState *State = this->State;
+
+	if(!State->File.Opened())
+	{
+		LastError.Set("No map open.");
+		return vlFalse;
+	}
+
+	std::string Path = NormalizePath(cPath);
+	Path.erase(0, Path.find_first_not_of('/'));
+
+	if(Path.empty() || Path.size() > 0xffff)
+	{
+		LastError.Set("Invalid pakfile path.");
+		return vlFalse;
+	}
+
+	if(uiSize > 0x7fffffff)
+	{
+		LastError.Set("File is too large.");
+		return vlFalse;
+	}
+
+	std::map<std::string, vlUInt>::iterator i = State->Index.find(Path);
+	if(i == State->Index.end())
+	{
+		i = State->Index.insert(std::make_pair(Path, (vlUInt)State->Entries.size())).first;
+		State->Entries.push_back(SBSPEntry());
+	}
+
+	SBSPEntry &Entry = State->Entries[i->second];
+	Entry.Name = Path;
+	Entry.uiCRC = Checksum::CRC32(lpData, uiSize);
+	Entry.uiSize = uiSize;
+	Entry.uiOffset = 0;
+	Entry.uiExtent = 0;
+	Entry.Central.clear();
+	Entry.bAdded = vlTrue;
+	Entry.Data.assign(static_cast<const vlByte *>(lpData), static_cast<const vlByte *>(lpData) + uiSize);
+	GetDOSTime(Entry.usTime, Entry.usDate);
+
+	return vlTrue;
+}
+
+vlBool CBSPFile::AddFile(const vlChar *cPath, const vlChar *cFileName)
+{
+	CBSPStream File;
+	if(!File.Open(cFileName))
+	{
+		return vlFalse;
+	}
+
+	vlUInt64 uiSize = File.GetSize();
+	if(uiSize > 0x7fffffff)
+	{
+		LastError.SetFormatted("%s is too large.", cFileName);
+		return vlFalse;
+	}
+
+	std::vector<vlByte> Data((vlUInt)uiSize);
+	if(!Data.empty() && !File.Read(0, &Data[0], (vlUInt)uiSize))
+	{
+		return vlFalse;
+	}
+
+	return this->Add(cPath, Data.empty() ? 0 : &Data[0], (vlUInt)uiSize);
+}
+
+//
+// vlCreateMap()
+// Creates an empty map.  Open a map with vlMapOpen().
+//
+VTFLIB_API vlBool vlCreateMap(VLMap **Map)
+{
+	if(!bInitialized)
+	{
+		LastError.Set("VTFLib not initialized.");
+		return vlFalse;
+	}
+
+	*Map = reinterpret_cast<VLMap *>(new CBSPFile());
+
+	return vlTrue;
+}
+
+VTFLIB_API vlVoid vlDeleteMap(VLMap *Map)
+{
+	delete reinterpret_cast<CBSPFile *>(Map);
+}
+
+static CBSPFile *FromHandle(VLMap *Map)
+{
+	if(Map == 0)
+	{
+		LastError.Set("Invalid map.");
+		return 0;
+	}
+
+	return reinterpret_cast<CBSPFile *>(Map);
+}
+
+VTFLIB_API vlBool vlMapOpen(VLMap *Map, const vlChar *cFileName)
+{
+	CBSPFile *Instance = FromHandle(Map);
+	if(Instance == 0)
+		return vlFalse;
+
+	return Instance->Open(cFileName);
+}
+
+VTFLIB_API vlBool vlMapSave(VLMap *Map, const vlChar *cFileName)
+{
+	CBSPFile *Instance = FromHandle(Map);
+	if(Instance == 0)
+		return vlFalse;
+
+	return Instance->Save(cFileName);
+}
+
+VTFLIB_API vlVoid vlMapClose(VLMap *Map)
+{
+	CBSPFile *Instance = FromHandle(Map);
+	if(Instance == 0)
+		return;
+
+	Instance->Close();
+}
+
+VTFLIB_API vlUInt vlMapGetEntryCount(VLMap *Map)
+{
+	CBSPFile *Instance = FromHandle(Map);
+	if(Instance == 0)
+		return 0;
+
+	return Instance->GetEntryCount();
+}
+
+VTFLIB_API vlUInt vlMapFindEntry(VLMap *Map, const vlChar *cPath)
+{
+	CBSPFile *Instance = FromHandle(Map);
+	if(Instance == 0)
+		return BSP_INVALID_INDEX;
+
+	return Instance->FindEntry(cPath);
+}
+
+VTFLIB_API const vlChar *vlMapGetEntryName(VLMap *Map, vlUInt uiEntry)
+{
+	CBSPFile *Instance = FromHandle(Map);
+	if(Instance == 0)
+		return 0;
+
+	return Instance->GetEntryName(uiEntry);
+}
+
+VTFLIB_API vlUInt vlMapGetEntrySize(VLMap *Map, vlUInt uiEntry)
+{
+	CBSPFile *Instance = FromHandle(Map);
+	if(Instance == 0)
+		return 0;
+
+	return Instance->GetEntrySize(uiEntry);
+}
+
+VTFLIB_API vlBool vlMapAddFile(VLMap *Map, const vlChar *cPath, const vlChar *cFileName)
+{
+	CBSPFile *Instance = FromHandle(Map);
+	if(Instance == 0)
+		return vlFalse;
+
+	return Instance->AddFile(cPath, cFileName);
+}
+
+VTFLIB_API vlBool vlMapAddFileData(VLMap *Map, const vlChar *cPath, const vlVoid *lpData, vlUInt uiSize)
+{
+	CBSPFile *Instance = FromHandle(Map);
+	if(Instance == 0)
+		return vlFalse;
+
+	return Instance->Add(cPath, lpData, uiSize);
+}
@@ -0,0 +1,105 @@
+/*
+ * VTFLib
+ * Copyright (C) 2005-2010 Neil Jedrzejewski & Ryan Gregg
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later
+ * version.
+ */
+
+// ============================================================
+// NOTE: This file is commented for compatibility with Doxygen.
+// ============================================================
+/*!
+	\file BSPFile.h
+	\brief Adds files to the pakfile lump of a compiled map.
+*/
+
+#ifndef BSPFILE_H
+#define BSPFILE_H
+
+#include "stdafx.h"
+#include "BSPWrapper.h"
+
+#define BSP_IDENT			0x50534256	//!< "VBSP", the first four bytes of a map.
+#define BSP_LUMP_COUNT		64
+#define BSP_LUMP_GAME		35			//!< Game lump, whose own directory holds file offsets.
+#define BSP_LUMP_PAKFILE	40			//!< Uncompressed zip of files packed into the map.
+
+namespace VTFLib
+{
+	class CBSPFileState;
+
+	//! The pakfile of a compiled Source map (VBSP versions 17 to 21).
+	/*!
+		Open() reads the map's lump directory and the pakfile's zip directory;
+		nothing else is loaded.  Files added with Add() or AddFile() are held in
+		memory, replacing any packed file with the same path, until Save().
+
+		Save() writes the map beside the target and swaps it in.  Everything
+		but the pakfile is streamed across unchanged (with copy_file_range()
+		where the system has it, so the kernel copies or shares the blocks), and
+		only the offsets of the lumps after the pakfile, including those in the
+		game lump, are rewritten.  Files already in the pakfile are copied the
+		same way rather than unpacked.
+
+		Paths are matched in any case and with either slash, and added files
+		are stored lower case with forward slashes, uncompressed.
+	*/
+	class VTFLIB_API CBSPFile
+	{
+	private:
+		CBSPFileState *State;
+
+	public:
+		CBSPFile();
+		~CBSPFile();
+
+	private:
+		CBSPFile(const CBSPFile &);
+		CBSPFile &operator=(const CBSPFile &);
+
+	public:
+		//! Reads the lump directory and pakfile directory of a map.
+		/*!
+			\return true on success, otherwise false and the map is closed.
+		*/
+		vlBool Open(const vlChar *cFileName);
+
+		//! Writes the map with the added files in its pakfile.
+		/*!
+			cFileName may be the map that was opened.  The map stays open on the
+			new file.
+
+			\return true on success, otherwise false and the opened map is unchanged.
+		*/
+		vlBool Save(const vlChar *cFileName);
+
+		vlVoid Close();		//!< Closes the map and forgets added files.
+
+		vlUInt GetEntryCount() const;
+
+		//! Returns the index of a packed or added file, or BSP_INVALID_INDEX if there is none.
+		vlUInt FindEntry(const vlChar *cPath) const;
+
+		const vlChar *GetEntryName(vlUInt uiEntry) const;	//!< Returns the path as stored.
+		vlUInt GetEntrySize(vlUInt uiEntry) const;			//!< Returns the uncompressed size.
+
+	public:
+		//! Adds a file to the pakfile from memory, replacing any with the same path.
+		/*!
+			\return true on success, otherwise false.
+		*/
+		vlBool Add(const vlChar *cPath, const vlVoid *lpData, vlUInt uiSize);
+
+		//! Adds a file to the pakfile from disk, replacing any with the same path.
+		/*!
+			\return true on success, otherwise false.
+		*/
+		vlBool AddFile(const vlChar *cPath, const vlChar *cFileName);
+	};
+}
+
+#endif
@@ -0,0 +1,51 @@
+/*
+ * VTFLib
+ * Copyright (C) 2005-2010 Neil Jedrzejewski & Ryan Gregg
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later
+ * version.
+ */
+
+#ifndef BSPWRAPPER_H
+#define BSPWRAPPER_H
+
+#include "stdafx.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BSP_INVALID_INDEX	0xffffffff
+
+//
+// The files packed into a compiled map (.bsp).  Open the map, add or replace
+// files with vlMapAddFile() or vlMapAddFileData(), then vlMapSave() writes
+// the map again with only its pakfile lump rebuilt.  Paths are the ones the
+// game would open, e.g. "materials/cubemap_skyboxes/sky_cubemap.vtf".
+//
+
+typedef struct tagVLMap VLMap;
+
+VTFLIB_API vlBool vlCreateMap(VLMap **Map);
+VTFLIB_API vlVoid vlDeleteMap(VLMap *Map);
+
+VTFLIB_API vlBool vlMapOpen(VLMap *Map, const vlChar *cFileName);
+VTFLIB_API vlBool vlMapSave(VLMap *Map, const vlChar *cFileName);
+VTFLIB_API vlVoid vlMapClose(VLMap *Map);
+
+VTFLIB_API vlUInt vlMapGetEntryCount(VLMap *Map);
+VTFLIB_API vlUInt vlMapFindEntry(VLMap *Map, const vlChar *cPath);
+VTFLIB_API const vlChar *vlMapGetEntryName(VLMap *Map, vlUInt uiEntry);
+VTFLIB_API vlUInt vlMapGetEntrySize(VLMap *Map, vlUInt uiEntry);
+
+VTFLIB_API vlBool vlMapAddFile(VLMap *Map, const vlChar *cPath, const vlChar *cFileName);
+VTFLIB_API vlBool vlMapAddFileData(VLMap *Map, const vlChar *cPath, const vlVoid *lpData, vlUInt uiSize);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
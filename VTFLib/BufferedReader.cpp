@@ -0,0 +1,184 @@
+/*
+ * VTFLib
+ * Copyright (C) 2005-2010 Neil Jedrzejewski & Ryan Gregg
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later
+ * version.
+ */
+
+#include "VTFLib.h"
+#include "BufferedReader.h"
+
+using namespace VTFLib;
+using namespace VTFLib::IO::Readers;
+
+CBufferedReader::CBufferedReader(IReader *Reader, vlUInt uiBufferSize)
+{
+	this->Reader = Reader;
+
+	this->uiBufferSize = uiBufferSize != 0 ? uiBufferSize : 1;
+	this->lpBuffer = new vlByte[this->uiBufferSize];
+
+	this->Drop(0);
+}
+
+CBufferedReader::~CBufferedReader()
+{
+	delete []this->lpBuffer;
+}
+
+vlBool CBufferedReader::Opened() const
+{
+	return this->Reader->Opened();
+}
+
+vlBool CBufferedReader::Open()
+{
+	if(!this->Reader->Open())
+	{
+		return vlFalse;
+	}
+
+	this->Drop(this->Reader->GetStreamPointer());
+
+	return vlTrue;
+}
+
+vlVoid CBufferedReader::Close()
+{
+	this->Reader->Close();
+
+	this->Drop(0);
+}
+
+vlUInt CBufferedReader::GetStreamSize() const
+{
+	return this->Reader->GetStreamSize();
+}
+
+vlUInt CBufferedReader::GetStreamPointer() const
+{
+	if(!this->Reader->Opened())
+	{
+		return 0;
+	}
+
+	return this->uiBufferStart + this->uiBufferPointer;
+}
+
+vlUInt CBufferedReader::Seek(vlLong lOffset, vlUInt uiMode)
+{
+	if(!this->Reader->Opened())
+	{
+		return 0;
+	}
+
+	// Stay in the buffer if we can, the stream is already past it.
+	if(uiMode != FILE_END)
+	{
+		vlLong lPointer = uiMode == FILE_BEGIN ? lOffset : (vlLong)(this->uiBufferStart + this->uiBufferPointer) + lOffset;
+
+		if(lPointer >= (vlLong)this->uiBufferStart && lPointer <= (vlLong)(this->uiBufferStart + this->uiBufferLength))
+		{
+			this->uiBufferPointer = (vlUInt)(lPointer - (vlLong)this->uiBufferStart);
+
+			return (vlUInt)lPointer;
+		}
+
+		// The stream is at the end of the buffer, not at our pointer.
+		lOffset = lPointer < 0 ? 0 : lPointer;
+		uiMode = FILE_BEGIN;
+	}
+
+	this->Drop(this->Reader->Seek(lOffset, uiMode));
+
+	return this->uiBufferStart;
+}
+
+vlBool CBufferedReader::Read(vlChar &cChar)
+{
+	if(this->uiBufferPointer == this->uiBufferLength && !this->Fill())
+	{
+		return vlFalse;
+	}
+
+	cChar = (vlChar)this->lpBuffer[this->uiBufferPointer++];
+
+	return vlTrue;
+}
+
+vlUInt CBufferedReader::Read(vlVoid *vData, vlUInt uiBytes)
+{
+	vlByte *lpData = static_cast<vlByte *>(vData);
+	vlUInt uiRead = 0;
+
+	while(uiRead < uiBytes)
+	{
+		vlUInt uiAvailable = this->uiBufferLength - this->uiBufferPointer;
+
+		if(uiAvailable != 0)
+		{
+			vlUInt uiCopy = uiBytes - uiRead < uiAvailable ? uiBytes - uiRead : uiAvailable;
+
+			memcpy(lpData + uiRead, this->lpBuffer + this->uiBufferPointer, uiCopy);
+
+			this->uiBufferPointer += uiCopy;
+			uiRead += uiCopy;
+		}
+		else if(uiBytes - uiRead >= this->uiBufferSize)
+		{
+			// Too big to be worth copying twice.
+			if(!this->Reader->Opened())
+			{
+				break;
+			}
+
+			this->Drop(this->uiBufferStart + this->uiBufferLength);
+
+			vlUInt uiDirect = this->Reader->Read(lpData + uiRead, uiBytes - uiRead);
+
+			this->uiBufferStart += uiDirect;
+			uiRead += uiDirect;
+
+			break;
+		}
+		else if(!this->Fill())
+		{
+			break;
+		}
+	}
+
+	return uiRead;
+}
+
+//
+// Drop()
+// Empties the buffer, which now starts at the stream's pointer.
+//
+vlVoid CBufferedReader::Drop(vlUInt uiPointer)
+{
+	this->uiBufferStart = uiPointer;
+	this->uiBufferLength = 0;
+	this->uiBufferPointer = 0;
+}
+
+//
+// Fill()
+// Replaces the consumed buffer with the next block of the stream.
+//
+vlBool CBufferedReader::Fill()
+{
+	if(!this->Reader->Opened())
+	{
+		return vlFalse;
+	}
+
+	this->Drop(this->uiBufferStart + this->uiBufferLength);
+
+	this->uiBufferLength = this->Reader->Read(this->lpBuffer, this->uiBufferSize);
+
+	return this->uiBufferLength != 0;
+}
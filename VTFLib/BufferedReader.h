@@ -0,0 +1,74 @@
+/*
+ * VTFLib
+ * Copyright (C) 2005-2010 Neil Jedrzejewski & Ryan Gregg
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later
+ * version.
+ */
+
+#ifndef BUFFEREDREADER_H
+#define BUFFEREDREADER_H
+
+#include "stdafx.h"
+#include "Reader.h"
+
+#define BUFFERED_READER_SIZE	(64 * 1024)
+
+namespace VTFLib
+{
+	namespace IO
+	{
+		namespace Readers
+		{
+			//
+			// Reads another reader through a buffer so small reads don't each
+			// reach the stream.  Reads of a buffer or more go straight through
+			// and seeks inside the buffer don't touch the stream.  The stream
+			// isn't owned.
+			//
+			class CBufferedReader : public IReader
+			{
+			private:
+				IReader *Reader;
+
+				vlByte *lpBuffer;
+				vlUInt uiBufferSize;
+
+				vlUInt uiBufferStart;	// Stream offset of the first buffered byte.
+				vlUInt uiBufferLength;
+				vlUInt uiBufferPointer;
+
+			public:
+				CBufferedReader(IReader *Reader, vlUInt uiBufferSize = BUFFERED_READER_SIZE);
+				~CBufferedReader();
+
+			private:
+				CBufferedReader(const CBufferedReader &);
+				CBufferedReader &operator=(const CBufferedReader &);
+
+			public:
+				virtual vlBool Opened() const;
+
+				virtual vlBool Open();
+				virtual vlVoid Close();
+
+				virtual vlUInt GetStreamSize() const;
+				virtual vlUInt GetStreamPointer() const;
+
+				virtual vlUInt Seek(vlLong lOffset, vlUInt uiMode);
+
+				virtual vlBool Read(vlChar &cChar);
+				virtual vlUInt Read(vlVoid *vData, vlUInt uiBytes);
+
+			private:
+				vlVoid Drop(vlUInt uiPointer);
+				vlBool Fill();
+			};
+		}
+	}
+}
+
+#endif
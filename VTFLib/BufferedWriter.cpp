@@ -0,0 +1,168 @@
+/*
+ * VTFLib
+ * Copyright (C) 2005-2010 Neil Jedrzejewski & Ryan Gregg
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later
+ * version.
+ */
+
+#include "VTFLib.h"
+#include "BufferedWriter.h"
+
+using namespace VTFLib;
+using namespace VTFLib::IO::Writers;
+
+CBufferedWriter::CBufferedWriter(IWriter *Writer, vlUInt uiBufferSize)
+{
+	this->Writer = Writer;
+
+	this->uiBufferSize = uiBufferSize != 0 ? uiBufferSize : 1;
+	this->lpBuffer = new vlByte[this->uiBufferSize];
+	this->uiBufferLength = 0;
+
+	this->bError = vlFalse;
+}
+
+CBufferedWriter::~CBufferedWriter()
+{
+	if(this->Writer->Opened())
+	{
+		this->Flush();
+	}
+
+	delete []this->lpBuffer;
+}
+
+vlBool CBufferedWriter::Opened() const
+{
+	return this->Writer->Opened();
+}
+
+vlBool CBufferedWriter::Open()
+{
+	this->uiBufferLength = 0;
+	this->bError = vlFalse;
+
+	return this->Writer->Open();
+}
+
+vlBool CBufferedWriter::Close()
+{
+	if(this->Writer->Opened())
+	{
+		this->Flush();
+	}
+
+	// A file that didn't close was never replaced, so Flush() fails from now on.
+	if(!this->Writer->Close())
+	{
+		this->bError = vlTrue;
+	}
+
+	return !this->bError;
+}
+
+vlUInt CBufferedWriter::GetStreamSize() const
+{
+	vlUInt uiSize = this->Writer->GetStreamSize();
+	vlUInt uiEnd = this->GetStreamPointer();
+
+	return uiEnd > uiSize ? uiEnd : uiSize;
+}
+
+vlUInt CBufferedWriter::GetStreamPointer() const
+{
+	if(!this->Writer->Opened())
+	{
+		return 0;
+	}
+
+	// The buffer goes out at the stream's pointer.
+	return this->Writer->GetStreamPointer() + this->uiBufferLength;
+}
+
+vlUInt CBufferedWriter::Seek(vlLong lOffset, vlUInt uiMode)
+{
+	if(!this->Writer->Opened())
+	{
+		return 0;
+	}
+
+	this->Flush();
+
+	return this->Writer->Seek(lOffset, uiMode);
+}
+
+vlBool CBufferedWriter::Write(vlChar cChar)
+{
+	if(this->bError || !this->Writer->Opened())
+	{
+		return vlFalse;
+	}
+
+	if(this->uiBufferLength == this->uiBufferSize && !this->Flush())
+	{
+		return vlFalse;
+	}
+
+	this->lpBuffer[this->uiBufferLength++] = (vlByte)cChar;
+
+	return vlTrue;
+}
+
+vlUInt CBufferedWriter::Write(vlVoid *vData, vlUInt uiBytes)
+{
+	if(this->bError || !this->Writer->Opened())
+	{
+		return 0;
+	}
+
+	if(uiBytes > this->uiBufferSize - this->uiBufferLength)
+	{
+		if(!this->Flush())
+		{
+			return 0;
+		}
+
+		// Too big to be worth copying twice.
+		if(uiBytes >= this->uiBufferSize)
+		{
+			vlUInt uiWritten = this->Writer->Write(vData, uiBytes);
+
+			if(uiWritten != uiBytes)
+			{
+				this->bError = vlTrue;
+			}
+
+			return uiWritten;
+		}
+	}
+
+	memcpy(this->lpBuffer + this->uiBufferLength, vData, uiBytes);
+	this->uiBufferLength += uiBytes;
+
+	return uiBytes;
+}
+
+//
+// Flush()
+// Passes the buffer on.  Returns false if this or any earlier write to the
+// stream came up short, or the stream failed to close.
+//
+vlBool CBufferedWriter::Flush()
+{
+	if(this->uiBufferLength != 0)
+	{
+		if(this->Writer->Write(this->lpBuffer, this->uiBufferLength) != this->uiBufferLength)
+		{
+			this->bError = vlTrue;
+		}
+
+		this->uiBufferLength = 0;
+	}
+
+	return !this->bError;
+}
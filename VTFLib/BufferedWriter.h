@@ -0,0 +1,72 @@
+/*
+ * VTFLib
+ * Copyright (C) 2005-2010 Neil Jedrzejewski & Ryan Gregg
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later
+ * version.
+ */
+
+#ifndef BUFFEREDWRITER_H
+#define BUFFEREDWRITER_H
+
+#include "stdafx.h"
+#include "Writer.h"
+
+#define BUFFERED_WRITER_SIZE	(1024 * 1024)
+
+namespace VTFLib
+{
+	namespace IO
+	{
+		namespace Writers
+		{
+			//
+			// Collects small writes to another writer and passes them on a buffer
+			// at a time.  Writes of a buffer or more go straight through.  Once
+			// passing the buffer on fails every later write fails, so checking
+			// Flush() after the last write is enough to catch a lost write.  The
+			// stream isn't owned.
+			//
+			class CBufferedWriter : public IWriter
+			{
+			private:
+				IWriter *Writer;
+
+				vlByte *lpBuffer;
+				vlUInt uiBufferSize;
+				vlUInt uiBufferLength;
+
+				vlBool bError;
+
+			public:
+				CBufferedWriter(IWriter *Writer, vlUInt uiBufferSize = BUFFERED_WRITER_SIZE);
+				~CBufferedWriter();
+
+			private:
+				CBufferedWriter(const CBufferedWriter &);
+				CBufferedWriter &operator=(const CBufferedWriter &);
+
+			public:
+				virtual vlBool Opened() const;
+
+				virtual vlBool Open();
+				virtual vlBool Close();
+
+				virtual vlUInt GetStreamSize() const;
+				virtual vlUInt GetStreamPointer() const;
+
+				virtual vlUInt Seek(vlLong lOffset, vlUInt uiMode);
+
+				virtual vlBool Write(vlChar cChar);
+				virtual vlUInt Write(vlVoid *vData, vlUInt uiBytes);
+
+				vlBool Flush();
+			};
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,152 @@
+/*
+ * VTFLib
+ * Copyright (C) 2005-2010 Neil Jedrzejewski & Ryan Gregg
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later
+ * version.
+ */
+
+#include "CRC32.h"
+
+using namespace VTFLib;
+
+#define CRC32_POLYNOMIAL	0xEDB88320
+
+namespace
+{
+	// Table[0] is the classic byte table; Table[k][n] is the CRC of byte n
+	// followed by k zero bytes.
+	struct SCRC32Tables
+	{
+		vlUInt Table[8][256];
+
+		SCRC32Tables()
+		{
+			for(vlUInt i = 0; i < 256; i++)
+			{
+				vlUInt uiCRC = i;
+				for(vlUInt j = 0; j < 8; j++)
+				{
+					uiCRC = (uiCRC >> 1) ^ (CRC32_POLYNOMIAL & (0 - (uiCRC & 1)));
+				}
+				this->Table[0][i] = uiCRC;
+			}
+
+			for(vlUInt i = 0; i < 256; i++)
+			{
+				for(vlUInt k = 1; k < 8; k++)
+				{
+					this->Table[k][i] = (this->Table[k - 1][i] >> 8) ^ this->Table[0][this->Table[k - 1][i] & 0xff];
+				}
+			}
+		}
+	};
+
+	const SCRC32Tables &GetTables()
+	{
+		static const SCRC32Tables Tables;
+		return Tables;
+	}
+
+	// Multiplies a vector by a 32x32 bit matrix over GF(2).
+	vlUInt MultiplyMatrix(const vlUInt *lpMatrix, vlUInt uiVector)
+	{
+		vlUInt uiSum = 0;
+		for(; uiVector; uiVector >>= 1, lpMatrix++)
+		{
+			if(uiVector & 1)
+				uiSum ^= *lpMatrix;
+		}
+		return uiSum;
+	}
+
+	vlVoid SquareMatrix(vlUInt *lpSquare, const vlUInt *lpMatrix)
+	{
+		for(vlUInt i = 0; i < 32; i++)
+		{
+			lpSquare[i] = MultiplyMatrix(lpMatrix, lpMatrix[i]);
+		}
+	}
+}
+
+vlUInt Checksum::CRC32(const vlVoid *lpData, vlUInt uiSize, vlUInt uiCRC)
+{
+	const vlUInt (&Table)[8][256] = GetTables().Table;
+	const vlByte *lpBytes = static_cast<const vlByte *>(lpData);
+
+	uiCRC = ~uiCRC;
+
+	// Byte at a time up to an 8 byte boundary.
+	while(uiSize && (reinterpret_cast<size_t>(lpBytes) & 7))
+	{
+		uiCRC = (uiCRC >> 8) ^ Table[0][(uiCRC ^ *lpBytes++) & 0xff];
+		uiSize--;
+	}
+
+	// Eight bytes per step; x86 and ARM are both little endian.
+	while(uiSize >= 8)
+	{
+		vlUInt uiLow = *reinterpret_cast<const vlUInt *>(lpBytes) ^ uiCRC;
+		vlUInt uiHigh = *reinterpret_cast<const vlUInt *>(lpBytes + 4);
+
+		uiCRC = Table[7][uiLow & 0xff] ^ Table[6][(uiLow >> 8) & 0xff] ^ Table[5][(uiLow >> 16) & 0xff] ^ Table[4][uiLow >> 24] ^
+				Table[3][uiHigh & 0xff] ^ Table[2][(uiHigh >> 8) & 0xff] ^ Table[1][(uiHigh >> 16) & 0xff] ^ Table[0][uiHigh >> 24];
+
+		lpBytes += 8;
+		uiSize -= 8;
+	}
+
+	while(uiSize--)
+	{
+		uiCRC = (uiCRC >> 8) ^ Table[0][(uiCRC ^ *lpBytes++) & 0xff];
+	}
+
+	return ~uiCRC;
+}
+
+//
+// CRC32Combine()
+// Shifts the first CRC past uiSize2 zero bytes by repeated squaring of the
+// one zero bit operator, then adds in the second (the method used by zlib).
+//
+vlUInt Checksum::CRC32Combine(vlUInt uiCRC1, vlUInt uiCRC2, vlUInt64 uiSize2)
+{
+	if(uiSize2 == 0)
+		return uiCRC1;
+
+	vlUInt uiEven[32];	// Operator for an even power of two zero bits.
+	vlUInt uiOdd[32];	// Operator for an odd power of two zero bits.
+
+	// One zero bit.
+	uiOdd[0] = CRC32_POLYNOMIAL;
+	for(vlUInt i = 1, uiRow = 1; i < 32; i++, uiRow <<= 1)
+	{
+		uiOdd[i] = uiRow;
+	}
+
+	// Two then four zero bits.
+	SquareMatrix(uiEven, uiOdd);
+	SquareMatrix(uiOdd, uiEven);
+
+	// Apply one zero byte, two, four... for each set bit of the length.
+	do
+	{
+		SquareMatrix(uiEven, uiOdd);
+		if(uiSize2 & 1)
+			uiCRC1 = MultiplyMatrix(uiEven, uiCRC1);
+		uiSize2 >>= 1;
+
+		if(uiSize2 == 0)
+			break;
+
+		SquareMatrix(uiOdd, uiEven);
+		if(uiSize2 & 1)
+			uiCRC1 = MultiplyMatrix(uiOdd, uiCRC1);
+		uiSize2 >>= 1;
+	} while(uiSize2 != 0);
+
+	return uiCRC1 ^ uiCRC2;
+}
@@ -0,0 +1,33 @@
+/*
+ * VTFLib
+ * Copyright (C) 2005-2010 Neil Jedrzejewski & Ryan Gregg
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later
+ * version.
+ */
+
+// Standard CRC-32 (polynomial 0x04C11DB7 reflected, as used by zip and PNG).
+// Computed eight bytes at a time with the slice-by-8 tables.
+
+#ifndef CRC32_H
+#define CRC32_H
+
+#include "stdafx.h"
+
+namespace VTFLib
+{
+	namespace Checksum
+	{
+		// Continues the CRC uiCRC (0 to start) over lpData.
+		vlUInt CRC32(const vlVoid *lpData, vlUInt uiSize, vlUInt uiCRC = 0);
+
+		// Gets the CRC of two buffers back to back from their separate CRCs, so
+		// large buffers can be checksummed in parallel.  uiSize2 is the size of the second.
+		vlUInt CRC32Combine(vlUInt uiCRC1, vlUInt uiCRC2, vlUInt64 uiSize2);
+	}
+}
+
+#endif
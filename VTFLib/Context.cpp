@@ -0,0 +1,124 @@
+/*
+ * VTFLib
+ * Copyright (C) 2005-2011 Neil Jedrzejewski & Ryan Gregg
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later
+ * version.
+ */
+
+#include "Context.h"
+
+using namespace VTFLib;
+
+CContext::CContext()
+{
+	VTFLib::GetOptions(this->Options);
+}
+
+CContext::~CContext()
+{
+
+}
+
+vlVoid CContext::GetOptions(SVTFLibOptions &Options) const
+{
+	std::lock_guard<std::mutex> Lock(this->OptionsMutex);
+	Options = this->Options;
+}
+
+vlVoid CContext::SetOptions(const SVTFLibOptions &Options)
+{
+	std::lock_guard<std::mutex> Lock(this->OptionsMutex);
+
+	SVTFLibOptions Valid = this->Options;
+	ValidateOptions(Valid, Options);
+
+	this->Options = Valid;
+}
+
+CHandleTable<CVTFFile> &CContext::GetImages()
+{
+	return this->Images;
+}
+
+CHandleTable<CMaterialInstance> &CContext::GetMaterials()
+{
+	return this->Materials;
+}
+
+//
+// FromHandle()
+// Gets the context behind a C API handle, setting the last error if it is null.
+//
+CContext *CContext::FromHandle(VLContext *Context)
+{
+	if(Context == 0)
+	{
+		LastError.Set("Invalid context.");
+		return 0;
+	}
+
+	return reinterpret_cast<CContext *>(Context);
+}
+
+//
+// vlCreateContext()
+// Creates a context.  It starts with a copy of the process wide options.
+//
+VTFLIB_API vlBool vlCreateContext(VLContext **Context)
+{
+	if(!bInitialized)
+	{
+		LastError.Set("VTFLib not initialized.");
+		return vlFalse;
+	}
+
+	*Context = reinterpret_cast<VLContext *>(new CContext());
+
+	return vlTrue;
+}
+
+//
+// vlDeleteContext()
+// Deletes a context and every image and material it owns.  No other thread
+// may be using the context.
+//
+VTFLIB_API vlVoid vlDeleteContext(VLContext *Context)
+{
+	delete reinterpret_cast<CContext *>(Context);
+}
+
+//
+// vlContextGetOptions()
+// Gets the options new images and materials in the context are created with.
+//
+VTFLIB_API vlBool vlContextGetOptions(VLContext *Context, SVTFLibOptions *Options)
+{
+	CContext *Instance = CContext::FromHandle(Context);
+	if(Instance == 0)
+		return vlFalse;
+
+	Instance->GetOptions(*Options);
+
+	return vlTrue;
+}
+
+//
+// vlContextSetOptions()
+// Sets the options new images and materials in the context are created with,
+// validated as vlSetOptions() does.  Existing images keep the options they
+// were created with.
+//
+VTFLIB_API vlBool vlContextSetOptions(VLContext *Context, const SVTFLibOptions *Options)
+{
+	CContext *Instance = CContext::FromHandle(Context);
+	if(Instance == 0)
+		return vlFalse;
+
+	Instance->SetOptions(*Options);
+
+	return vlTrue;
+}
@@ -0,0 +1,333 @@
+/*
+ * VTFLib
+ * Copyright (C) 2005-2011 Neil Jedrzejewski & Ryan Gregg
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later
+ * version.
+ */
+
+#ifndef CONTEXT_H
+#define CONTEXT_H
+
+#include "VTFLib.h"
+#include "ContextWrapper.h"
+
+#include <deque>
+#include <mutex>
+#include <vector>
+
+namespace VTFLib
+{
+	//
+	// Table of heap objects addressed by 32 bit handles.  The low bits of a handle
+	// are the slot index plus one, the high bits the slot's generation.  The
+	// generation is bumped every time a slot is freed so stale handles are
+	// rejected instead of reaching whatever reused the slot.
+	//
+	// Objects are reference counted while in use so one thread can delete a handle
+	// while another is still working on it; the object is freed on the last Release().
+	// Two threads working on the same object at once must still synchronise themselves.
+	//
+	template<typename T>
+	class CHandleTable
+	{
+	private:
+		enum
+		{
+			INDEX_BITS = 20,
+			INDEX_MASK = (1 << INDEX_BITS) - 1,
+			GENERATION_MASK = (1 << (32 - INDEX_BITS)) - 1
+		};
+
+		struct SSlot
+		{
+			T *Object;
+			vlUInt uiGeneration;
+			vlUInt uiReferences;
+			vlBool bDeleted;
+		};
+
+		std::mutex Mutex;
+		std::vector<SSlot> Slots;
+		std::vector<vlUInt> FreeSlots;
+
+	public:
+		CHandleTable()
+		{
+
+		}
+
+		~CHandleTable()
+		{
+			for(typename std::vector<SSlot>::iterator i = this->Slots.begin(); i != this->Slots.end(); ++i)
+			{
+				delete (*i).Object;
+			}
+		}
+
+	private:
+		CHandleTable(const CHandleTable &);
+		CHandleTable &operator=(const CHandleTable &);
+
+		static vlUInt MakeHandle(vlUInt uiIndex, vlUInt uiGeneration)
+		{
+			return (uiGeneration << INDEX_BITS) | (uiIndex + 1);
+		}
+
+		// Gets the slot a handle refers to, null if the handle is stale.  Lock must be held.
+		SSlot *Lookup(vlUInt uiHandle)
+		{
+			vlUInt uiIndex = (uiHandle & INDEX_MASK);
+			if(uiIndex == 0 || uiIndex > (vlUInt)this->Slots.size())
+				return 0;
+
+			SSlot &Slot = this->Slots[uiIndex - 1];
+			if(Slot.Object == 0 || Slot.bDeleted || Slot.uiGeneration != (uiHandle >> INDEX_BITS))
+				return 0;
+
+			return &Slot;
+		}
+
+		// Empties a slot and bumps its generation.  Lock must be held.
+		T *Free(vlUInt uiIndex)
+		{
+			SSlot &Slot = this->Slots[uiIndex];
+
+			T *Object = Slot.Object;
+			Slot.Object = 0;
+			Slot.bDeleted = vlFalse;
+			Slot.uiReferences = 0;
+			Slot.uiGeneration = (Slot.uiGeneration + 1) & GENERATION_MASK;
+			if(Slot.uiGeneration == 0)
+				Slot.uiGeneration = 1;
+
+			this->FreeSlots.push_back(uiIndex);
+
+			return Object;
+		}
+
+	public:
+		//
+		// Add()
+		// Takes ownership of an object and returns its handle, 0 if the table is full.
+		//
+		vlUInt Add(T *Object)
+		{
+			std::lock_guard<std::mutex> Lock(this->Mutex);
+
+			vlUInt uiIndex;
+			if(!this->FreeSlots.empty())
+			{
+				uiIndex = this->FreeSlots.back();
+				this->FreeSlots.pop_back();
+			}
+			else
+			{
+				if(this->Slots.size() >= INDEX_MASK)
+					return 0;
+
+				SSlot Slot = { 0, 1, 0, vlFalse };
+				this->Slots.push_back(Slot);
+
+				uiIndex = (vlUInt)this->Slots.size() - 1;
+			}
+
+			this->Slots[uiIndex].Object = Object;
+
+			return MakeHandle(uiIndex, this->Slots[uiIndex].uiGeneration);
+		}
+
+		//
+		// Remove()
+		// Deletes the object a handle refers to.  If it is in use it is freed when the
+		// last user releases it.  Returns false if the handle is invalid.
+		//
+		vlBool Remove(vlUInt uiHandle)
+		{
+			T *Object = 0;
+			{
+				std::lock_guard<std::mutex> Lock(this->Mutex);
+
+				SSlot *Slot = this->Lookup(uiHandle);
+				if(Slot == 0)
+					return vlFalse;
+
+				Slot->bDeleted = vlTrue;
+				if(Slot->uiReferences == 0)
+				{
+					Object = this->Free((vlUInt)(Slot - &this->Slots[0]));
+				}
+			}
+
+			delete Object;
+
+			return vlTrue;
+		}
+
+		//
+		// Acquire()
+		// Pins the object a handle refers to until Release() is called.
+		// Returns null if the handle is invalid.
+		//
+		T *Acquire(vlUInt uiHandle)
+		{
+			std::lock_guard<std::mutex> Lock(this->Mutex);
+
+			SSlot *Slot = this->Lookup(uiHandle);
+			if(Slot == 0)
+				return 0;
+
+			Slot->uiReferences++;
+
+			return Slot->Object;
+		}
+
+		//
+		// Release()
+		// Unpins an object returned by Acquire().
+		//
+		vlVoid Release(vlUInt uiHandle)
+		{
+			T *Object = 0;
+			{
+				std::lock_guard<std::mutex> Lock(this->Mutex);
+
+				vlUInt uiIndex = (uiHandle & INDEX_MASK);
+				assert(uiIndex != 0 && uiIndex <= (vlUInt)this->Slots.size());
+
+				SSlot &Slot = this->Slots[uiIndex - 1];
+				assert(Slot.uiReferences > 0);
+
+				if(--Slot.uiReferences == 0 && Slot.bDeleted)
+				{
+					Object = this->Free(uiIndex - 1);
+				}
+			}
+
+			delete Object;
+		}
+
+		//
+		// GetCount()
+		// Gets the number of live objects.
+		//
+		vlUInt GetCount()
+		{
+			std::lock_guard<std::mutex> Lock(this->Mutex);
+
+			return (vlUInt)(this->Slots.size() - this->FreeSlots.size());
+		}
+	};
+
+	//
+	// Holds an object acquired from a handle table for the length of a scope.
+	// Sets the last error if the table or handle is invalid.
+	//
+	template<typename T>
+	class CHandleRef
+	{
+	private:
+		CHandleTable<T> *Table;
+		vlUInt uiHandle;
+		T *Object;
+
+	public:
+		CHandleRef(CHandleTable<T> *Table, vlUInt uiHandle, const vlChar *cInvalidError) : Table(Table), uiHandle(uiHandle), Object(0)
+		{
+			if(this->Table == 0)
+			{
+				LastError.Set("Invalid context.");
+				return;
+			}
+
+			this->Object = this->Table->Acquire(this->uiHandle);
+			if(this->Object == 0)
+			{
+				LastError.Set(cInvalidError);
+			}
+		}
+
+		~CHandleRef()
+		{
+			if(this->Object != 0)
+			{
+				this->Table->Release(this->uiHandle);
+			}
+		}
+
+	private:
+		CHandleRef(const CHandleRef &);
+		CHandleRef &operator=(const CHandleRef &);
+
+	public:
+		vlBool operator!() const
+		{
+			return this->Object == 0;
+		}
+
+		T *operator->() const
+		{
+			return this->Object;
+		}
+
+		T *Get() const
+		{
+			return this->Object;
+		}
+	};
+
+	//
+	// A material plus the node the C API is currently pointing at.
+	//
+	class CMaterialInstance
+	{
+	public:
+		CVMTFile Material;
+
+		std::deque<vlInt> CurrentIndex;
+		Nodes::CVMTGroupNode *CurrentNode;
+
+	public:
+		CMaterialInstance() : CurrentNode(0)
+		{
+
+		}
+	};
+
+	//
+	// State behind a VLContext handle.  Each context has its own options and its own
+	// image and material tables, so hosts can run one context per worker without
+	// sharing the bound image of the global API.
+	//
+	class CContext
+	{
+	private:
+		mutable std::mutex OptionsMutex;
+		SVTFLibOptions Options;
+
+		CHandleTable<CVTFFile> Images;
+		CHandleTable<CMaterialInstance> Materials;
+
+	public:
+		CContext();
+		~CContext();
+
+	private:
+		CContext(const CContext &);
+		CContext &operator=(const CContext &);
+
+	public:
+		vlVoid GetOptions(SVTFLibOptions &Options) const;
+		vlVoid SetOptions(const SVTFLibOptions &Options);
+
+		CHandleTable<CVTFFile> &GetImages();
+		CHandleTable<CMaterialInstance> &GetMaterials();
+
+		static CContext *FromHandle(VLContext *Context);
+	};
+}
+
+#endif
@@ -0,0 +1,41 @@
+/*
+ * VTFLib
+ * Copyright (C) 2005-2011 Neil Jedrzejewski & Ryan Gregg
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later
+ * version.
+ */
+
+#ifndef CONTEXTWRAPPER_H
+#define CONTEXTWRAPPER_H
+
+#include "stdafx.h"
+#include "Options.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//
+// Contexts own their own images, materials and options.  Unlike the bound
+// image API, different threads may use different images of the same context
+// at the same time, and create or delete handles concurrently.  A single
+// image or material must still only be used by one thread at a time.
+//
+
+typedef struct tagVLContext VLContext;
+
+VTFLIB_API vlBool vlCreateContext(VLContext **Context);
+VTFLIB_API vlVoid vlDeleteContext(VLContext *Context);
+
+VTFLIB_API vlBool vlContextGetOptions(VLContext *Context, SVTFLibOptions *Options);
+VTFLIB_API vlBool vlContextSetOptions(VLContext *Context, const SVTFLibOptions *Options);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -11,6 +11,10 @@
 
 #include "Error.h"
 
+#ifndef _WIN32
+#	include <errno.h>
+#endif
+
 using namespace VTFLib::Diagnostics;
 
 CError::CError()
@@ -51,6 +55,7 @@ vlVoid CError::Set(const vlChar *cErrorMessage, vlBool bSystemError)
 	vlChar cBuffer[2048];
 	if(bSystemError)
 	{
+#ifdef _WIN32
 		LPSTR lpMessage = NULL;
 		vlUInt uiLastError = GetLastError(); 
 
@@ -64,14 +69,18 @@ vlVoid CError::Set(const vlChar *cErrorMessage, vlBool bSystemError)
 		{
 			sprintf(cBuffer, "Error:\n%s\n\nSystem Error: 0x%.8x.", cErrorMessage, uiLastError); 
 		}
+#else
+		vlInt iLastError = errno;
 
-		
+		sprintf(cBuffer, "Error:\n%s\n\nSystem Error: %d:\n%s", cErrorMessage, iLastError, strerror(iLastError));
+#endif
 	}
 	else
 	{
 		sprintf(cBuffer, "Error:\n%s", cErrorMessage); 
 	}
-	
+
+	delete []this->cErrorMessage;
 	this->cErrorMessage = new vlChar[strlen(cBuffer) + 1];
 	strcpy(this->cErrorMessage, cBuffer);
 }
\ No newline at end of file
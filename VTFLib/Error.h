@@ -29,7 +29,8 @@ namespace VTFLib
 		//! VTFLib Error handling class
 		/*!
 			The Error handling class allows you to aceess a text description 
-			for the last error encountered.
+			for the last error encountered.  VTFLib keeps one instance per
+			thread so errors raised on one thread never overwrite another's.
 		*/
 		class CError
 		{
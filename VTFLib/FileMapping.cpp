@@ -0,0 +1,113 @@
+/*
+ * VTFLib
+ * Copyright (C) 2005-2010 Neil Jedrzejewski & Ryan Gregg
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later
+ * version.
+ */
+
+#include "VTFLib.h"
+#include "FileMapping.h"
+
+#ifndef _WIN32
+#	include <fcntl.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <unistd.h>
+#endif
+
+using namespace VTFLib;
+
+CFileMapping::CFileMapping() : lpData(0), uiSize(0)
+{
+#ifdef _WIN32
+	this->hFile = INVALID_HANDLE_VALUE;
+	this->hMapping = NULL;
+#endif
+}
+
+CFileMapping::~CFileMapping()
+{
+	this->Unmap();
+}
+
+vlBool CFileMapping::Map(const vlChar *cFileName)
+{
+	this->Unmap();
+
+#ifdef _WIN32
+	this->hFile = CreateFileA(cFileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if(this->hFile == INVALID_HANDLE_VALUE)
+	{
+		LastError.SetFormatted("Error opening %s.", cFileName);
+		return vlFalse;
+	}
+
+	LARGE_INTEGER FileSize;
+	if(!GetFileSizeEx(this->hFile, &FileSize) || FileSize.QuadPart == 0 || FileSize.QuadPart > 0xffffffff)
+	{
+		this->Unmap();
+		LastError.SetFormatted("%s is empty or too large.", cFileName);
+		return vlFalse;
+	}
+	this->uiSize = (vlUInt)FileSize.QuadPart;
+
+	this->hMapping = CreateFileMappingA(this->hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+	this->lpData = this->hMapping != NULL ? static_cast<const vlByte *>(MapViewOfFile(this->hMapping, FILE_MAP_READ, 0, 0, 0)) : 0;
+#else
+	vlInt iFile = open(cFileName, O_RDONLY | O_CLOEXEC);
+	if(iFile == -1)
+	{
+		LastError.SetFormatted("Error opening %s.", cFileName);
+		return vlFalse;
+	}
+
+	struct stat Stat;
+	if(fstat(iFile, &Stat) != 0 || Stat.st_size == 0 || (vlUInt64)Stat.st_size > 0xffffffff)
+	{
+		close(iFile);
+		LastError.SetFormatted("%s is empty or too large.", cFileName);
+		return vlFalse;
+	}
+	this->uiSize = (vlUInt)Stat.st_size;
+
+	// The mapping keeps the file; the descriptor isn't needed.
+	vlVoid *lpMapping = mmap(0, this->uiSize, PROT_READ, MAP_SHARED, iFile, 0);
+	close(iFile);
+
+	this->lpData = lpMapping != MAP_FAILED ? static_cast<const vlByte *>(lpMapping) : 0;
+#endif
+
+	if(this->lpData == 0)
+	{
+		this->Unmap();
+		LastError.SetFormatted("Error mapping %s.", cFileName);
+		return vlFalse;
+	}
+
+	return vlTrue;
+}
+
+vlVoid CFileMapping::Unmap()
+{
+#ifdef _WIN32
+	if(this->lpData != 0)
+		UnmapViewOfFile(this->lpData);
+	if(this->hMapping != NULL)
+		CloseHandle(this->hMapping);
+	if(this->hFile != INVALID_HANDLE_VALUE)
+		CloseHandle(this->hFile);
+
+	this->hFile = INVALID_HANDLE_VALUE;
+	this->hMapping = NULL;
+#else
+	if(this->lpData != 0)
+		munmap(const_cast<vlByte *>(this->lpData), this->uiSize);
+#endif
+
+	this->lpData = 0;
+	this->uiSize = 0;
+}
@@ -0,0 +1,48 @@
+/*
+ * VTFLib
+ * Copyright (C) 2005-2010 Neil Jedrzejewski & Ryan Gregg
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later
+ * version.
+ */
+
+// A read only view of a whole file, for the package and material cache readers.
+
+#ifndef FILEMAPPING_H
+#define FILEMAPPING_H
+
+#include "stdafx.h"
+
+namespace VTFLib
+{
+	class CFileMapping
+	{
+	public:
+		const vlByte *lpData;		// Null if nothing is mapped.
+		vlUInt uiSize;
+
+	private:
+#ifdef _WIN32
+		HANDLE hFile;
+		HANDLE hMapping;
+#endif
+
+	public:
+		CFileMapping();
+		~CFileMapping();
+
+		// Maps cFileName, replacing any earlier mapping.  Empty files and files
+		// over 4 GB can't be mapped.
+		vlBool Map(const vlChar *cFileName);
+		vlVoid Unmap();
+
+	private:
+		CFileMapping(const CFileMapping &);
+		CFileMapping &operator=(const CFileMapping &);
+	};
+}
+
+#endif
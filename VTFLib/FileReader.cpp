@@ -12,12 +12,25 @@
 #include "VTFLib.h"
 #include "FileReader.h"
 
+#ifndef _WIN32
+#	include <errno.h>
+#	include <fcntl.h>
+#	include <sys/stat.h>
+#	include <unistd.h>
+#endif
+
 using namespace VTFLib;
 using namespace VTFLib::IO::Readers;
 
 CFileReader::CFileReader(const vlChar *cFileName)
 {
+#ifdef _WIN32
 	this->hFile = NULL;
+#else
+	this->iFile = -1;
+	this->uiPointer = 0;
+	this->uiSize = 0;
+#endif
 
 	this->cFileName = new vlChar[strlen(cFileName) + 1];
 	strcpy(this->cFileName, cFileName);
@@ -30,6 +43,8 @@ CFileReader::~CFileReader()
 	delete []this->cFileName;
 }
 
+#ifdef _WIN32
+
 vlBool CFileReader::Opened() const
 {
 	return this->hFile != NULL;
@@ -124,4 +139,147 @@ vlUInt CFileReader::Read(vlVoid *vData, vlUInt uiBytes)
 	}
 
 	return (vlUInt)ulBytesRead;
-}
\ No newline at end of file
+}
+
+#else
+
+vlBool CFileReader::Opened() const
+{
+	return this->iFile != -1;
+}
+
+vlBool CFileReader::Open()
+{
+	this->Close();
+
+	this->iFile = open(this->cFileName, O_RDONLY | O_CLOEXEC);
+
+	if(this->iFile == -1)
+	{
+		LastError.Set("Error opening file.", vlTrue);
+
+		return vlFalse;
+	}
+
+	struct stat Stat;
+	if(fstat(this->iFile, &Stat) != 0)
+	{
+		LastError.Set("Error opening file.", vlTrue);
+
+		this->Close();
+
+		return vlFalse;
+	}
+
+	this->uiPointer = 0;
+	this->uiSize = (vlUInt)Stat.st_size;
+
+#ifdef POSIX_FADV_SEQUENTIAL
+	// Files are read front to back; let the kernel read ahead further.
+	posix_fadvise(this->iFile, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+	return vlTrue;
+}
+
+vlVoid CFileReader::Close()
+{
+	if(this->iFile != -1)
+	{
+		close(this->iFile);
+		this->iFile = -1;
+	}
+}
+
+vlUInt CFileReader::GetStreamSize() const
+{
+	if(this->iFile == -1)
+	{
+		return 0;
+	}
+
+	return this->uiSize;
+}
+
+vlUInt CFileReader::GetStreamPointer() const
+{
+	if(this->iFile == -1)
+	{
+		return 0;
+	}
+
+	return this->uiPointer;
+}
+
+vlUInt CFileReader::Seek(vlLong lOffset, vlUInt uiMode)
+{
+	if(this->iFile == -1)
+	{
+		return 0;
+	}
+
+	vlLong lPointer = lOffset;
+
+	switch(uiMode)
+	{
+		case FILE_CURRENT:
+			lPointer += (vlLong)this->uiPointer;
+			break;
+		case FILE_END:
+			lPointer += (vlLong)this->uiSize;
+			break;
+	}
+
+	if(lPointer < 0)
+	{
+		lPointer = 0;
+	}
+
+	this->uiPointer = (vlUInt)lPointer;
+
+	return this->uiPointer;
+}
+
+vlBool CFileReader::Read(vlChar &cChar)
+{
+	return this->Read(&cChar, 1) == 1;
+}
+
+vlUInt CFileReader::Read(vlVoid *vData, vlUInt uiBytes)
+{
+	if(this->iFile == -1)
+	{
+		return 0;
+	}
+
+	// Reads at our own pointer, so seeking costs nothing until the next read.
+	vlUInt uiRead = 0;
+	while(uiRead < uiBytes)
+	{
+		ssize_t iResult = pread(this->iFile, (vlByte *)vData + uiRead, uiBytes - uiRead, (off_t)this->uiPointer + uiRead);
+
+		if(iResult < 0)
+		{
+			if(errno == EINTR)
+			{
+				continue;
+			}
+
+			LastError.Set("pread() failed.", vlTrue);
+			break;
+		}
+
+		if(iResult == 0)
+		{
+			break;
+		}
+
+		uiRead += (vlUInt)iResult;
+	}
+
+	this->uiPointer += uiRead;
+
+	return uiRead;
+}
+
+#endif
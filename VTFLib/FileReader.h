@@ -24,7 +24,13 @@ namespace VTFLib
 			class CFileReader : public IReader
 			{
 			private:
+#ifdef _WIN32
 				HANDLE hFile;
+#else
+				vlInt iFile;
+				vlUInt uiPointer;
+				vlUInt uiSize;
+#endif
 				vlChar *cFileName;
 
 			public:
@@ -12,15 +12,32 @@
 #include "VTFLib.h"
 #include "FileWriter.h"
 
+#ifndef _WIN32
+#	include <atomic>
+#	include <errno.h>
+#	include <fcntl.h>
+#	include <unistd.h>
+#endif
+
 using namespace VTFLib;
 using namespace VTFLib::IO::Writers;
 
-CFileWriter::CFileWriter(const vlChar *cFileName)
+CFileWriter::CFileWriter(const vlChar *cFileName, vlUInt uiSizeHint)
 {
+#ifdef _WIN32
 	this->hFile = NULL;
+#else
+	this->iFile = -1;
+	this->cTempName = new vlChar[strlen(cFileName) + 32];
+	this->uiPointer = 0;
+	this->uiSize = 0;
+	this->bError = vlFalse;
+#endif
 
 	this->cFileName = new vlChar[strlen(cFileName) + 1];
 	strcpy(this->cFileName, cFileName);
+
+	this->uiSizeHint = uiSizeHint;
 }
 
 CFileWriter::~CFileWriter()
@@ -28,8 +45,13 @@ CFileWriter::~CFileWriter()
 	this->Close();
 
 	delete []this->cFileName;
+#ifndef _WIN32
+	delete []this->cTempName;
+#endif
 }
 
+#ifdef _WIN32
+
 vlBool CFileWriter::Opened() const
 {
 	return this->hFile != NULL;
@@ -53,13 +75,23 @@ vlBool CFileWriter::Open()
 	return vlTrue;
 }
 
-vlVoid CFileWriter::Close()
+vlBool CFileWriter::Close()
 {
-	if(this->hFile != NULL)
+	if(this->hFile == NULL)
 	{
-		CloseHandle(this->hFile);
-		this->hFile = NULL;
+		return vlTrue;
 	}
+
+	vlBool bResult = CloseHandle(this->hFile) != FALSE;
+
+	if(!bResult)
+	{
+		LastError.Set("Error closing file.", vlTrue);
+	}
+
+	this->hFile = NULL;
+
+	return bResult;
 }
 
 vlUInt CFileWriter::GetStreamSize() const
@@ -124,4 +156,179 @@ vlUInt CFileWriter::Write(vlVoid *vData, vlUInt uiBytes)
 	}
 
 	return (vlUInt)ulBytesWritten;
-}
\ No newline at end of file
+}
+
+#else
+
+static std::atomic<vlUInt> uiTempCount(0);
+
+vlBool CFileWriter::Opened() const
+{
+	return this->iFile != -1;
+}
+
+vlBool CFileWriter::Open()
+{
+	this->Close();
+
+	// Write beside the file so Close() can rename over it.  The name only has
+	// to be unique; O_EXCL settles any race and the mode honors the umask.
+	for(vlUInt i = 0; i < 16; i++)
+	{
+		sprintf(this->cTempName, "%s.%u.%u.tmp", this->cFileName, (vlUInt)getpid(), uiTempCount++);
+
+		this->iFile = open(this->cTempName, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0666);
+
+		if(this->iFile != -1 || errno != EEXIST)
+		{
+			break;
+		}
+	}
+
+	if(this->iFile == -1)
+	{
+		LastError.Set("Error opening file.", vlTrue);
+
+		return vlFalse;
+	}
+
+	this->uiPointer = 0;
+	this->uiSize = 0;
+	this->bError = vlFalse;
+
+#ifdef __linux__
+	// Reserve the space in one go; the size stays what we write.
+	if(this->uiSizeHint != 0)
+	{
+		fallocate(this->iFile, FALLOC_FL_KEEP_SIZE, 0, (off_t)this->uiSizeHint);
+	}
+#endif
+
+	return vlTrue;
+}
+
+vlBool CFileWriter::Close()
+{
+	if(this->iFile == -1)
+	{
+		return vlTrue;
+	}
+
+	vlBool bKeep = !this->bError;
+
+	if(close(this->iFile) != 0 && bKeep)
+	{
+		LastError.Set("Error closing file.", vlTrue);
+		bKeep = vlFalse;
+	}
+
+	this->iFile = -1;
+
+	if(bKeep && rename(this->cTempName, this->cFileName) != 0)
+	{
+		LastError.Set("Error replacing file.", vlTrue);
+		bKeep = vlFalse;
+	}
+
+	if(!bKeep)
+	{
+		unlink(this->cTempName);
+	}
+
+	return bKeep;
+}
+
+vlUInt CFileWriter::GetStreamSize() const
+{
+	if(this->iFile == -1)
+	{
+		return 0;
+	}
+
+	return this->uiSize;
+}
+
+vlUInt CFileWriter::GetStreamPointer() const
+{
+	if(this->iFile == -1)
+	{
+		return 0;
+	}
+
+	return this->uiPointer;
+}
+
+vlUInt CFileWriter::Seek(vlLong lOffset, vlUInt uiMode)
+{
+	if(this->iFile == -1)
+	{
+		return 0;
+	}
+
+	vlLong lPointer = lOffset;
+
+	switch(uiMode)
+	{
+		case FILE_CURRENT:
+			lPointer += (vlLong)this->uiPointer;
+			break;
+		case FILE_END:
+			lPointer += (vlLong)this->uiSize;
+			break;
+	}
+
+	if(lPointer < 0)
+	{
+		lPointer = 0;
+	}
+
+	this->uiPointer = (vlUInt)lPointer;
+
+	return this->uiPointer;
+}
+
+vlBool CFileWriter::Write(vlChar cChar)
+{
+	return this->Write(&cChar, 1) == 1;
+}
+
+vlUInt CFileWriter::Write(vlVoid *vData, vlUInt uiBytes)
+{
+	if(this->iFile == -1)
+	{
+		return 0;
+	}
+
+	vlUInt uiWritten = 0;
+	while(uiWritten < uiBytes)
+	{
+		ssize_t iResult = pwrite(this->iFile, (vlByte *)vData + uiWritten, uiBytes - uiWritten, (off_t)this->uiPointer + uiWritten);
+
+		if(iResult < 0)
+		{
+			if(errno == EINTR)
+			{
+				continue;
+			}
+
+			LastError.Set("pwrite() failed.", vlTrue);
+
+			// Keep the old file rather than swap in a broken one.
+			this->bError = vlTrue;
+			break;
+		}
+
+		uiWritten += (vlUInt)iResult;
+	}
+
+	this->uiPointer += uiWritten;
+
+	if(this->uiPointer > this->uiSize)
+	{
+		this->uiSize = this->uiPointer;
+	}
+
+	return uiWritten;
+}
+
+#endif
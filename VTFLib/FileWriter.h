@@ -21,21 +21,38 @@ namespace VTFLib
 	{
 		namespace Writers
 		{
+			//
+			// Writes a file from scratch.  On POSIX systems the data goes to a
+			// temporary file beside it which replaces the file on Close(), or is
+			// removed if a write failed, so a failed save leaves the old file.
+			// Close() returns false if the file wasn't written.
+			// uiSizeHint is the least the file will hold, which lets the file
+			// system reserve it up front.
+			//
 			class CFileWriter : public IWriter
 			{
 			private:
+#ifdef _WIN32
 				HANDLE hFile;
+#else
+				vlInt iFile;
+				vlChar *cTempName;
+				vlUInt uiPointer;
+				vlUInt uiSize;
+				vlBool bError;
+#endif
 				vlChar *cFileName;
+				vlUInt uiSizeHint;
 
 			public:
-				CFileWriter(const vlChar *cFileName);
+				CFileWriter(const vlChar *cFileName, vlUInt uiSizeHint = 0);
 				~CFileWriter();
 
 			public:
 				virtual vlBool Opened() const;
 
 				virtual vlBool Open();
-				virtual vlVoid Close();
+				virtual vlBool Close();
 
 				virtual vlUInt GetStreamSize() const;
 				virtual vlUInt GetStreamPointer() const;
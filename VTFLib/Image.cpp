@@ -0,0 +1,245 @@
+/*
+ * VTFLib
+ * Copyright (C) 2005-2010 Neil Jedrzejewski & Ryan Gregg
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later
+ * version.
+ */
+
+#include "VTFLib.h"
+#include "Image.h"
+#include "Allocator.h"
+
+#include <new>
+
+using namespace VTFLib;
+
+// Pixel rows in one row of data: 4 for a row of DXTn blocks, otherwise 1.
+static vlUInt GetRowHeight(VTFImageFormat ImageFormat)
+{
+	return CVTFFile::GetImageFormatInfo(ImageFormat).bIsCompressed ? 4 : 1;
+}
+
+CImageView::CImageView() : lpData(0), uiWidth(0), uiHeight(0), uiPitch(0), ImageFormat(IMAGE_FORMAT_NONE)
+{
+
+}
+
+CImageView::CImageView(vlByte *lpData, vlUInt uiWidth, vlUInt uiHeight, VTFImageFormat ImageFormat, vlUInt uiPitch) : lpData(lpData), uiWidth(uiWidth), uiHeight(uiHeight), uiPitch(uiPitch), ImageFormat(ImageFormat)
+{
+	assert(ImageFormat >= 0 && ImageFormat < IMAGE_FORMAT_COUNT);
+
+	if(this->uiPitch == 0)
+	{
+		this->uiPitch = CImageView::ComputePitch(uiWidth, ImageFormat);
+	}
+
+	assert(this->uiPitch >= CImageView::ComputePitch(uiWidth, ImageFormat));
+}
+
+vlBool CImageView::IsEmpty() const
+{
+	return this->lpData == 0 || this->uiWidth == 0 || this->uiHeight == 0;
+}
+
+vlBool CImageView::IsPacked() const
+{
+	return this->uiPitch == this->GetRowSize() || this->uiHeight <= GetRowHeight(this->ImageFormat);
+}
+
+vlByte *CImageView::GetData() const
+{
+	return this->lpData;
+}
+
+vlUInt CImageView::GetWidth() const
+{
+	return this->uiWidth;
+}
+
+vlUInt CImageView::GetHeight() const
+{
+	return this->uiHeight;
+}
+
+vlUInt CImageView::GetPitch() const
+{
+	return this->uiPitch;
+}
+
+VTFImageFormat CImageView::GetFormat() const
+{
+	return this->ImageFormat;
+}
+
+vlUInt CImageView::GetRowSize() const
+{
+	return CImageView::ComputePitch(this->uiWidth, this->ImageFormat);
+}
+
+vlByte *CImageView::GetRow(vlUInt uiRow) const
+{
+	assert(uiRow < this->uiHeight);
+
+	return this->lpData + (size_t)(uiRow / GetRowHeight(this->ImageFormat)) * this->uiPitch;
+}
+
+vlBool CImageView::GetSubView(vlUInt uiX, vlUInt uiY, vlUInt uiWidth, vlUInt uiHeight, CImageView &View) const
+{
+	if(uiX > this->uiWidth || uiWidth > this->uiWidth - uiX || uiY > this->uiHeight || uiHeight > this->uiHeight - uiY)
+	{
+		LastError.Set("Sub view is outside the image.");
+		return vlFalse;
+	}
+
+	vlUInt uiRowHeight = GetRowHeight(this->ImageFormat);
+	if(uiRowHeight > 1)
+	{
+		if(uiX % uiRowHeight != 0 || uiY % uiRowHeight != 0 || (uiWidth % uiRowHeight != 0 && uiX + uiWidth != this->uiWidth) || (uiHeight % uiRowHeight != 0 && uiY + uiHeight != this->uiHeight))
+		{
+			LastError.Set("Sub view of DXTn data must be aligned to 4x4 blocks.");
+			return vlFalse;
+		}
+	}
+
+	vlByte *lpSubData = this->lpData + (size_t)(uiY / uiRowHeight) * this->uiPitch + CImageView::ComputePitch(uiX, this->ImageFormat);
+
+	View = CImageView(lpSubData, uiWidth, uiHeight, this->ImageFormat, this->uiPitch);
+
+	return vlTrue;
+}
+
+vlUInt CImageView::ComputePitch(vlUInt uiWidth, VTFImageFormat ImageFormat)
+{
+	if(uiWidth == 0)
+	{
+		return 0;
+	}
+
+	return CVTFFile::ComputeImageSize(uiWidth, GetRowHeight(ImageFormat), 1, ImageFormat);
+}
+
+CImage::CImage() : lpData(0), uiWidth(0), uiHeight(0), ImageFormat(IMAGE_FORMAT_NONE)
+{
+
+}
+
+CImage::CImage(CImage &&Image) : lpData(Image.lpData), uiWidth(Image.uiWidth), uiHeight(Image.uiHeight), ImageFormat(Image.ImageFormat)
+{
+	Image.lpData = 0;
+	Image.uiWidth = 0;
+	Image.uiHeight = 0;
+	Image.ImageFormat = IMAGE_FORMAT_NONE;
+}
+
+CImage::~CImage()
+{
+	this->Destroy();
+}
+
+CImage &CImage::operator=(CImage &&Image)
+{
+	if(this != &Image)
+	{
+		this->Destroy();
+
+		this->lpData = Image.lpData;
+		this->uiWidth = Image.uiWidth;
+		this->uiHeight = Image.uiHeight;
+		this->ImageFormat = Image.ImageFormat;
+
+		Image.lpData = 0;
+		Image.uiWidth = 0;
+		Image.uiHeight = 0;
+		Image.ImageFormat = IMAGE_FORMAT_NONE;
+	}
+
+	return *this;
+}
+
+vlBool CImage::Create(vlUInt uiWidth, vlUInt uiHeight, VTFImageFormat ImageFormat)
+{
+	if(ImageFormat < 0 || ImageFormat >= IMAGE_FORMAT_COUNT || !CVTFFile::GetImageFormatInfo(ImageFormat).bIsSupported)
+	{
+		LastError.Set("Invalid image format.");
+		return vlFalse;
+	}
+
+	vlUInt uiSize = CVTFFile::ComputeImageSize(uiWidth, uiHeight, 1, ImageFormat);
+	if(uiSize == 0)
+	{
+		LastError.Set("Invalid image size.");
+		return vlFalse;
+	}
+
+	this->Destroy();
+
+	try
+	{
+		this->lpData = Memory::AllocateImage(uiSize);
+	}
+	catch(std::bad_alloc &)
+	{
+		LastError.Set("Out of memory.");
+		return vlFalse;
+	}
+
+	this->uiWidth = uiWidth;
+	this->uiHeight = uiHeight;
+	this->ImageFormat = ImageFormat;
+
+	return vlTrue;
+}
+
+vlVoid CImage::Destroy()
+{
+	Memory::FreeImage(this->lpData);
+
+	this->lpData = 0;
+	this->uiWidth = 0;
+	this->uiHeight = 0;
+	this->ImageFormat = IMAGE_FORMAT_NONE;
+}
+
+vlBool CImage::IsLoaded() const
+{
+	return this->lpData != 0;
+}
+
+vlByte *CImage::GetData() const
+{
+	return this->lpData;
+}
+
+vlUInt CImage::GetWidth() const
+{
+	return this->uiWidth;
+}
+
+vlUInt CImage::GetHeight() const
+{
+	return this->uiHeight;
+}
+
+VTFImageFormat CImage::GetFormat() const
+{
+	return this->ImageFormat;
+}
+
+vlUInt CImage::GetSize() const
+{
+	return this->lpData != 0 ? CVTFFile::ComputeImageSize(this->uiWidth, this->uiHeight, 1, this->ImageFormat) : 0;
+}
+
+CImageView CImage::GetView() const
+{
+	if(this->lpData == 0)
+	{
+		return CImageView();
+	}
+
+	return CImageView(this->lpData, this->uiWidth, this->uiHeight, this->ImageFormat);
+}
@@ -0,0 +1,138 @@
+/*
+ * VTFLib
+ * Copyright (C) 2005-2010 Neil Jedrzejewski & Ryan Gregg
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later
+ * version.
+ */
+
+// ============================================================
+// NOTE: This file is commented for compatibility with Doxygen.
+// ============================================================
+/*!
+	\file Image.h
+	\brief Image buffers and views of image data owned by someone else.
+*/
+
+#ifndef IMAGE_H
+#define IMAGE_H
+
+#include "stdafx.h"
+#include "VTFFormat.h"
+
+namespace VTFLib
+{
+	//! A view of image data in memory VTFLib doesn't own.
+	/*!
+		A view describes where the rows of an image are without copying them, so
+		a part of a larger image or a bitmap owned by another library (DevIL, a
+		GUI toolkit) can be passed straight to CVTFFile's image functions.
+
+		The pitch is the number of bytes from the start of one row to the start
+		of the next.  For DXTn formats a row is a row of 4x4 blocks.  A pitch of 0
+		means the rows are packed one after the other.
+
+		Views don't own their data, which must outlive them.
+	*/
+	class VTFLIB_API CImageView
+	{
+	private:
+		vlByte *lpData;
+		vlUInt uiWidth;
+		vlUInt uiHeight;
+		vlUInt uiPitch;
+		VTFImageFormat ImageFormat;
+
+	public:
+		CImageView();	//!< Creates an empty view.
+
+		//! Creates a view of image data.
+		/*!
+			\param lpData is a pointer to the first row.
+			\param uiWidth is the width of the image in pixels.
+			\param uiHeight is the height of the image in pixels.
+			\param ImageFormat is the format of the data.
+			\param uiPitch is the number of bytes between rows, 0 if they are packed.
+		*/
+		CImageView(vlByte *lpData, vlUInt uiWidth, vlUInt uiHeight, VTFImageFormat ImageFormat, vlUInt uiPitch = 0);
+
+	public:
+		vlBool IsEmpty() const;		//!< Returns true if the view has no data or no pixels.
+		vlBool IsPacked() const;	//!< Returns true if the rows follow each other with no padding.
+
+		vlByte *GetData() const;
+		vlUInt GetWidth() const;
+		vlUInt GetHeight() const;
+		vlUInt GetPitch() const;
+		VTFImageFormat GetFormat() const;
+
+		//! Returns the number of bytes of image data in a row, which is at most the pitch.
+		vlUInt GetRowSize() const;
+
+		//! Returns a pointer to a row of pixels, or for DXTn formats the row of blocks holding it.
+		vlByte *GetRow(vlUInt uiRow) const;
+
+		//! Gets a view of part of this view.
+		/*!
+			For DXTn formats the rectangle must start on a block and its size must
+			be a multiple of 4, unless it reaches the right or bottom edge.
+
+			\return true if the rectangle is inside the view, otherwise false.
+		*/
+		vlBool GetSubView(vlUInt uiX, vlUInt uiY, vlUInt uiWidth, vlUInt uiHeight, CImageView &View) const;
+
+	public:
+		//! Returns the pitch of packed rows of an image.
+		static vlUInt ComputePitch(vlUInt uiWidth, VTFImageFormat ImageFormat);
+	};
+
+	//! Image data owned by VTFLib.
+	/*!
+		Holds one image in any format with packed rows, allocated from VTFLib's
+		allocator.  Images can be moved but not copied; use GetView() to pass
+		one to CVTFFile's image functions.
+	*/
+	class VTFLIB_API CImage
+	{
+	private:
+		vlByte *lpData;
+		vlUInt uiWidth;
+		vlUInt uiHeight;
+		VTFImageFormat ImageFormat;
+
+	public:
+		CImage();	//!< Creates an empty image.
+		CImage(CImage &&Image);
+		~CImage();
+
+		CImage &operator=(CImage &&Image);
+
+	private:
+		CImage(const CImage &);
+		CImage &operator=(const CImage &);
+
+	public:
+		//! Allocates an image.  The data is not cleared.
+		/*!
+			\return true on success, otherwise false.
+		*/
+		vlBool Create(vlUInt uiWidth, vlUInt uiHeight, VTFImageFormat ImageFormat);
+
+		vlVoid Destroy();	//!< Frees the image data.
+
+		vlBool IsLoaded() const;
+
+		vlByte *GetData() const;
+		vlUInt GetWidth() const;
+		vlUInt GetHeight() const;
+		VTFImageFormat GetFormat() const;
+		vlUInt GetSize() const;		//!< Returns the size of the image data in bytes.
+
+		CImageView GetView() const;	//!< Returns a view of the whole image.
+	};
+}
+
+#endif
@@ -0,0 +1,899 @@
+/*
+ * VTFLib
+ * Copyright (C) 2005-2010 Neil Jedrzejewski & Ryan Gregg
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later
+ * version.
+ */
+
+#include "VTFLib.h"
+#include "MaterialGraph.h"
+#include "Readers.h"
+#include "Writers.h"
+
+#ifndef _WIN32
+#	include <dirent.h>
+#	include <strings.h>
+#	include <sys/stat.h>
+#	include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace VTFLib;
+using namespace VTFLib::Nodes;
+
+#ifdef _WIN32
+#	define PATH_SEPARATOR "\\"
+#else
+#	define PATH_SEPARATOR "/"
+#endif
+
+//
+// Cache file layout.  Everything is addressed by offset from the start of the
+// strings.
+//
+// SGraphHeader
+// SGraphMaterial[uiMaterialCount]		sorted by name
+// SGraphReference[uiReferenceCount]	each material's references together, in order
+// vlChar strings[uiStringsSize]		root folder, then names, shaders and errors, null terminated
+//
+
+#define MATERIAL_GRAPH_NO_STRING	0xffffffff
+
+#pragma pack(1)
+
+struct SGraphHeader
+{
+	vlChar cSignature[4];		// "VMTG"
+	vlUInt uiVersion;
+	vlUInt uiMaterialCount;
+	vlUInt uiReferenceCount;
+	vlUInt uiStringsSize;
+	vlUInt uiRootOffset;
+};
+
+struct SGraphMaterial
+{
+	vlUInt uiNameOffset;
+	vlUInt uiShaderOffset;
+	vlUInt uiErrorOffset;		// MATERIAL_GRAPH_NO_STRING if the material parsed.
+	vlUInt uiFileSize;
+	vlUInt64 uiModified;		// FILETIME of the last write, or the stat() time on POSIX.
+	vlUInt uiFirstReference;
+	vlUInt uiReferenceCount;
+};
+
+struct SGraphReference
+{
+	vlUInt uiType;				// MaterialReferenceType
+	vlUInt uiNameOffset;
+};
+
+#pragma pack()
+
+// The material keys that name another file.
+static const struct
+{
+	const vlChar *cKey;
+	MaterialReferenceType ReferenceType;
+} ReferenceKeys[] =
+{
+	{ "$basetexture", MATERIAL_REFERENCE_BASETEXTURE },
+	{ "$basetexture2", MATERIAL_REFERENCE_BASETEXTURE2 },
+	{ "$bumpmap", MATERIAL_REFERENCE_BUMPMAP },
+	{ "$bumpmap2", MATERIAL_REFERENCE_BUMPMAP2 },
+	{ "$envmap", MATERIAL_REFERENCE_ENVMAP },
+	{ "include", MATERIAL_REFERENCE_INCLUDE }
+};
+
+namespace VTFLib
+{
+	struct SMaterialReference
+	{
+		MaterialReferenceType ReferenceType;
+		std::string Name;
+	};
+
+	struct SMaterial
+	{
+		std::string Name;
+		std::string Shader;
+		std::string Error;
+		vlBool bError;
+		vlUInt uiFileSize;
+		vlUInt64 uiModified;
+		std::vector<SMaterialReference> References;
+	};
+
+	class CMaterialGraphState
+	{
+	public:
+		std::string Root;
+		std::vector<SMaterial> Materials;	// Sorted by name.
+
+		vlUInt uiParsed;
+		vlUInt uiReused;
+
+	public:
+		CMaterialGraphState() : uiParsed(0), uiReused(0)
+		{
+
+		}
+
+		const SMaterial *Find(const std::string &Name) const
+		{
+			std::vector<SMaterial>::const_iterator i = std::lower_bound(this->Materials.begin(), this->Materials.end(), Name, [](const SMaterial &Material, const std::string &Name) { return Material.Name < Name; });
+			return i != this->Materials.end() && i->Name == Name ? &*i : 0;
+		}
+	};
+}
+
+//
+// Normalize()
+// Converts a path or material value to a name: forward slashes, lower case, no
+// leading materials folder and no extension.
+//
+static std::string Normalize(const vlChar *cPath)
+{
+	std::string Name = cPath;
+	for(std::string::iterator i = Name.begin(); i != Name.end(); ++i)
+	{
+		*i = *i == '\\' ? '/' : (vlChar)tolower((vlByte)*i);
+	}
+
+	size_t uiStart = Name.find_first_not_of('/');
+	Name.erase(0, uiStart == std::string::npos ? Name.size() : uiStart);
+
+	if(Name.compare(0, 10, "materials/") == 0)
+	{
+		Name.erase(0, 10);
+	}
+
+	if(Name.size() >= 4 && (Name.compare(Name.size() - 4, 4, ".vmt") == 0 || Name.compare(Name.size() - 4, 4, ".vtf") == 0))
+	{
+		Name.resize(Name.size() - 4);
+	}
+
+	return Name;
+}
+
+//
+// WalkFolder()
+// Adds every .vmt under cRoot + Relative to Materials, with the size and time
+// from the listing so unchanged files are never opened.  Paths go in Paths.
+// Returns false if the folder can't be listed.
+//
+static vlBool WalkFolder(const std::string &Root, const std::string &Relative, std::vector<SMaterial> &Materials, std::vector<std::string> &Paths)
+{
+#ifdef _WIN32
+	std::string Search = Root + "\\" + Relative + (Relative.empty() ? "*" : "\\*");
+
+	WIN32_FIND_DATAA FindData;
+	HANDLE hFind = FindFirstFileExA(Search.c_str(), FindExInfoBasic, &FindData, FindExSearchNameMatch, NULL, FIND_FIRST_EX_LARGE_FETCH);
+	if(hFind == INVALID_HANDLE_VALUE)
+	{
+		return vlFalse;
+	}
+
+	do
+	{
+		if(strcmp(FindData.cFileName, ".") == 0 || strcmp(FindData.cFileName, "..") == 0)
+		{
+			continue;
+		}
+
+		std::string Path = Relative.empty() ? FindData.cFileName : Relative + "\\" + FindData.cFileName;
+
+		if(FindData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+		{
+			WalkFolder(Root, Path, Materials, Paths);
+		}
+		else
+		{
+			size_t uiLength = strlen(FindData.cFileName);
+			if(uiLength >= 4 && stricmp(FindData.cFileName + uiLength - 4, ".vmt") == 0)
+			{
+				SMaterial Material;
+				Material.Name = Normalize(Path.c_str());
+				Material.bError = vlFalse;
+				Material.uiFileSize = FindData.nFileSizeLow;
+				Material.uiModified = ((vlUInt64)FindData.ftLastWriteTime.dwHighDateTime << 32) | FindData.ftLastWriteTime.dwLowDateTime;
+
+				Materials.push_back(Material);
+				Paths.push_back(Path);
+			}
+		}
+	} while(FindNextFileA(hFind, &FindData));
+
+	FindClose(hFind);
+#else
+	std::string Folder = Relative.empty() ? Root : Root + "/" + Relative;
+
+	DIR *pDirectory = opendir(Folder.c_str());
+	if(pDirectory == NULL)
+	{
+		return vlFalse;
+	}
+
+	struct dirent *pEntry;
+	while((pEntry = readdir(pDirectory)) != NULL)
+	{
+		if(strcmp(pEntry->d_name, ".") == 0 || strcmp(pEntry->d_name, "..") == 0)
+		{
+			continue;
+		}
+
+		std::string Path = Relative.empty() ? pEntry->d_name : Relative + "/" + pEntry->d_name;
+
+		// The listing only has the name, so stat for the rest.
+		struct stat Stat;
+		if(stat((Root + "/" + Path).c_str(), &Stat) != 0)
+		{
+			continue;
+		}
+
+		if(S_ISDIR(Stat.st_mode))
+		{
+			WalkFolder(Root, Path, Materials, Paths);
+		}
+		else
+		{
+			size_t uiLength = strlen(pEntry->d_name);
+			if(uiLength >= 4 && strcasecmp(pEntry->d_name + uiLength - 4, ".vmt") == 0)
+			{
+				SMaterial Material;
+				Material.Name = Normalize(Path.c_str());
+				Material.bError = vlFalse;
+				Material.uiFileSize = (vlUInt)Stat.st_size;
+#if defined(_POSIX_C_SOURCE) && _POSIX_C_SOURCE >= 200809L
+				Material.uiModified = (vlUInt64)Stat.st_mtim.tv_sec * 1000000000 + (vlUInt64)Stat.st_mtim.tv_nsec;
+#else
+				Material.uiModified = (vlUInt64)Stat.st_mtime;
+#endif
+
+				Materials.push_back(Material);
+				Paths.push_back(Path);
+			}
+		}
+	}
+
+	closedir(pDirectory);
+#endif
+
+	return vlTrue;
+}
+
+//
+// AddReferences()
+// Records the keys of Group that name another file.  For a patch the replace
+// and insert blocks are looked in too, as those keys become the material's.
+//
+static vlVoid AddReferences(const CVMTGroupNode *Group, vlBool bRoot, std::vector<SMaterialReference> &References)
+{
+	for(vlUInt i = 0; i < sizeof(ReferenceKeys) / sizeof(ReferenceKeys[0]); i++)
+	{
+		const CVMTNode *Node = Group->GetNode(ReferenceKeys[i].cKey);
+		if(Node != 0 && Node->GetType() == NODE_TYPE_STRING)
+		{
+			SMaterialReference Reference;
+			Reference.ReferenceType = ReferenceKeys[i].ReferenceType;
+			Reference.Name = Normalize(static_cast<const CVMTStringNode *>(Node)->GetValue());
+			References.push_back(Reference);
+		}
+	}
+
+	if(bRoot)
+	{
+		static const vlChar *cBlocks[] = { "replace", "insert" };
+		for(vlUInt i = 0; i < sizeof(cBlocks) / sizeof(cBlocks[0]); i++)
+		{
+			const CVMTNode *Node = Group->GetNode(cBlocks[i]);
+			if(Node != 0 && Node->GetType() == NODE_TYPE_GROUP)
+			{
+				AddReferences(static_cast<const CVMTGroupNode *>(Node), vlFalse, References);
+			}
+		}
+	}
+}
+
+//
+// ParseMaterial()
+// Reads a material's shader and references.  Failures are recorded in the
+// material rather than returned.
+//
+static vlVoid ParseMaterial(const std::string &FileName, const SVTFLibOptions &Options, SMaterial &Material)
+{
+	Material.Shader.clear();
+	Material.Error.clear();
+	Material.References.clear();
+
+	try
+	{
+		CVMTFile File;
+		File.SetOptions(&Options);
+
+		if(!File.Load(FileName.c_str()))
+		{
+			Material.bError = vlTrue;
+			Material.Error = LastError.Get();
+			return;
+		}
+
+		Material.bError = vlFalse;
+		Material.Shader = File.GetRoot()->GetName();
+		AddReferences(File.GetRoot(), vlTrue, Material.References);
+	}
+	catch(std::bad_alloc &)
+	{
+		Material.bError = vlTrue;
+		Material.Error = "Out of memory.";
+		Material.References.clear();
+	}
+}
+
+CMaterialGraph::CMaterialGraph() : State(new CMaterialGraphState())
+{
+
+}
+
+CMaterialGraph::~CMaterialGraph()
+{
+	delete this->State;
+}
+
+vlVoid CMaterialGraph::Destroy()
+{
+	this->State->Root.clear();
+	this->State->Materials.clear();
+	this->State->uiParsed = 0;
+	this->State->uiReused = 0;
+}
+
+vlBool CMaterialGraph::Load(const vlChar *cFileName)
+{
+	this->Destroy();
+
+	IO::Readers::CFileReader Reader(cFileName);
+	if(!Reader.Open())
+	{
+		return vlFalse;
+	}
+
+	vlUInt uiSize = Reader.GetStreamSize();
+	std::vector<vlByte> Data(uiSize);
+	vlBool bRead = uiSize == 0 || Reader.Read(Data.data(), uiSize) == uiSize;
+	Reader.Close();
+
+	if(!bRead)
+	{
+		LastError.SetFormatted("Error reading %s.", cFileName);
+		return vlFalse;
+	}
+
+	const SGraphHeader *Header = reinterpret_cast<const SGraphHeader *>(Data.data());
+	if(uiSize < sizeof(SGraphHeader) || memcmp(Header->cSignature, "VMTG", 4) != 0)
+	{
+		LastError.Set("Invalid material graph.");
+		return vlFalse;
+	}
+
+	if(Header->uiVersion != MATERIAL_GRAPH_VERSION)
+	{
+		LastError.SetFormatted("Unsupported material graph version %u.", Header->uiVersion);
+		return vlFalse;
+	}
+
+	vlUInt64 uiExpected = (vlUInt64)sizeof(SGraphHeader) + (vlUInt64)Header->uiMaterialCount * sizeof(SGraphMaterial) + (vlUInt64)Header->uiReferenceCount * sizeof(SGraphReference) + Header->uiStringsSize;
+	if(uiExpected != uiSize || Header->uiStringsSize == 0)
+	{
+		LastError.Set("Material graph is truncated.");
+		return vlFalse;
+	}
+
+	const SGraphMaterial *Materials = reinterpret_cast<const SGraphMaterial *>(Header + 1);
+	const SGraphReference *References = reinterpret_cast<const SGraphReference *>(Materials + Header->uiMaterialCount);
+	const vlChar *cStrings = reinterpret_cast<const vlChar *>(References + Header->uiReferenceCount);
+
+	// Every string must start inside the strings and they must end with a null.
+	vlUInt uiStringsSize = Header->uiStringsSize;
+	vlBool bValid = cStrings[uiStringsSize - 1] == '\0' && Header->uiRootOffset < uiStringsSize;
+	for(vlUInt i = 0; i < Header->uiMaterialCount && bValid; i++)
+	{
+		const SGraphMaterial &Material = Materials[i];
+		bValid = Material.uiNameOffset < uiStringsSize && Material.uiShaderOffset < uiStringsSize
+			&& (Material.uiErrorOffset == MATERIAL_GRAPH_NO_STRING || Material.uiErrorOffset < uiStringsSize)
+			&& Material.uiFirstReference <= Header->uiReferenceCount && Material.uiReferenceCount <= Header->uiReferenceCount - Material.uiFirstReference;
+	}
+	for(vlUInt i = 0; i < Header->uiReferenceCount && bValid; i++)
+	{
+		bValid = References[i].uiType < MATERIAL_REFERENCE_COUNT && References[i].uiNameOffset < uiStringsSize;
+	}
+
+	if(!bValid)
+	{
+		LastError.Set("Material graph is corrupt.");
+		return vlFalse;
+	}
+
+	std::vector<SMaterial> Loaded(Header->uiMaterialCount);
+	for(vlUInt i = 0; i < Header->uiMaterialCount; i++)
+	{
+		const SGraphMaterial &Record = Materials[i];
+		SMaterial &Material = Loaded[i];
+
+		Material.Name = cStrings + Record.uiNameOffset;
+		Material.Shader = cStrings + Record.uiShaderOffset;
+		Material.bError = Record.uiErrorOffset != MATERIAL_GRAPH_NO_STRING;
+		if(Material.bError)
+		{
+			Material.Error = cStrings + Record.uiErrorOffset;
+		}
+		Material.uiFileSize = Record.uiFileSize;
+		Material.uiModified = Record.uiModified;
+
+		Material.References.resize(Record.uiReferenceCount);
+		for(vlUInt j = 0; j < Record.uiReferenceCount; j++)
+		{
+			const SGraphReference &Reference = References[Record.uiFirstReference + j];
+			Material.References[j].ReferenceType = (MaterialReferenceType)Reference.uiType;
+			Material.References[j].Name = cStrings + Reference.uiNameOffset;
+		}
+
+		// Lookups depend on the order.
+		if(i > 0 && !(Loaded[i - 1].Name < Material.Name))
+		{
+			LastError.Set("Material graph is corrupt.");
+			return vlFalse;
+		}
+	}
+
+	this->State->Root = cStrings + Header->uiRootOffset;
+	this->State->Materials.swap(Loaded);
+
+	return vlTrue;
+}
+
+vlBool CMaterialGraph::Save(const vlChar *cFileName) const
+{
+	std::string Strings = this->State->Root;
+	Strings.push_back('\0');
+
+	std::vector<SGraphMaterial> Materials;
+	std::vector<SGraphReference> References;
+	Materials.reserve(this->State->Materials.size());
+
+	for(std::vector<SMaterial>::const_iterator i = this->State->Materials.begin(); i != this->State->Materials.end(); ++i)
+	{
+		SGraphMaterial Record;
+		Record.uiNameOffset = (vlUInt)Strings.size();
+		Strings.append(i->Name);
+		Strings.push_back('\0');
+		Record.uiShaderOffset = (vlUInt)Strings.size();
+		Strings.append(i->Shader);
+		Strings.push_back('\0');
+		Record.uiErrorOffset = MATERIAL_GRAPH_NO_STRING;
+		if(i->bError)
+		{
+			Record.uiErrorOffset = (vlUInt)Strings.size();
+			Strings.append(i->Error);
+			Strings.push_back('\0');
+		}
+		Record.uiFileSize = i->uiFileSize;
+		Record.uiModified = i->uiModified;
+		Record.uiFirstReference = (vlUInt)References.size();
+		Record.uiReferenceCount = (vlUInt)i->References.size();
+
+		for(std::vector<SMaterialReference>::const_iterator j = i->References.begin(); j != i->References.end(); ++j)
+		{
+			SGraphReference Reference;
+			Reference.uiType = (vlUInt)j->ReferenceType;
+			Reference.uiNameOffset = (vlUInt)Strings.size();
+			Strings.append(j->Name);
+			Strings.push_back('\0');
+			References.push_back(Reference);
+		}
+
+		Materials.push_back(Record);
+	}
+
+	SGraphHeader Header;
+	memcpy(Header.cSignature, "VMTG", 4);
+	Header.uiVersion = MATERIAL_GRAPH_VERSION;
+	Header.uiMaterialCount = (vlUInt)Materials.size();
+	Header.uiReferenceCount = (vlUInt)References.size();
+	Header.uiStringsSize = (vlUInt)Strings.size();
+	Header.uiRootOffset = 0;
+
+	// Write beside the old graph and swap it in, so an interrupted save never
+	// leaves half a file.
+	std::string Temp = std::string(cFileName) + ".tmp";
+	vlBool bWritten;
+	{
+		IO::Writers::CFileWriter Writer(Temp.c_str());
+		if(!Writer.Open())
+		{
+			return vlFalse;
+		}
+
+		vlUInt uiMaterialsSize = (vlUInt)(Materials.size() * sizeof(SGraphMaterial));
+		vlUInt uiReferencesSize = (vlUInt)(References.size() * sizeof(SGraphReference));
+
+		bWritten = Writer.Write(&Header, sizeof(Header)) == sizeof(Header)
+			&& (uiMaterialsSize == 0 || Writer.Write(Materials.data(), uiMaterialsSize) == uiMaterialsSize)
+			&& (uiReferencesSize == 0 || Writer.Write(References.data(), uiReferencesSize) == uiReferencesSize)
+			&& Writer.Write(&Strings[0], (vlUInt)Strings.size()) == Strings.size();
+
+		if(!Writer.Close())
+		{
+			bWritten = vlFalse;
+		}
+	}
+
+#ifdef _WIN32
+	if(!bWritten || !MoveFileExA(Temp.c_str(), cFileName, MOVEFILE_REPLACE_EXISTING))
+	{
+		DeleteFileA(Temp.c_str());
+#else
+	if(!bWritten || rename(Temp.c_str(), cFileName) != 0)
+	{
+		unlink(Temp.c_str());
+#endif
+		LastError.SetFormatted("Error writing %s.", cFileName);
+		return vlFalse;
+	}
+
+	return vlTrue;
+}
+
+vlBool CMaterialGraph::Scan(const vlChar *cRoot, vlUInt uiThreads)
+{
+	std::string Root = cRoot;
+	while(!Root.empty() && (Root.back() == '\\' || Root.back() == '/'))
+	{
+		Root.pop_back();
+	}
+
+	std::vector<SMaterial> Materials;
+	std::vector<std::string> Paths;
+	if(!WalkFolder(Root, "", Materials, Paths))
+	{
+		LastError.SetFormatted("Error listing folder %s.", cRoot);
+		return vlFalse;
+	}
+
+	std::vector<vlUInt> Order(Materials.size());
+	for(vlUInt i = 0; i < (vlUInt)Order.size(); i++)
+	{
+		Order[i] = i;
+	}
+	std::sort(Order.begin(), Order.end(), [&](vlUInt a, vlUInt b) { return Materials[a].Name < Materials[b].Name; });
+
+	std::vector<SMaterial> Sorted(Materials.size());
+	std::vector<std::string> SortedPaths(Materials.size());
+	for(vlUInt i = 0; i < (vlUInt)Order.size(); i++)
+	{
+		Sorted[i].Name.swap(Materials[Order[i]].Name);
+		Sorted[i].bError = vlFalse;
+		Sorted[i].uiFileSize = Materials[Order[i]].uiFileSize;
+		Sorted[i].uiModified = Materials[Order[i]].uiModified;
+		SortedPaths[i].swap(Paths[Order[i]]);
+	}
+
+	// Take what hasn't changed from the old graph; both are sorted by name.
+	std::vector<vlUInt> Pending;
+#ifdef _WIN32
+	vlBool bSameRoot = stricmp(this->State->Root.c_str(), Root.c_str()) == 0;
+#else
+	vlBool bSameRoot = strcmp(this->State->Root.c_str(), Root.c_str()) == 0;
+#endif
+	std::vector<SMaterial>::iterator Old = this->State->Materials.begin();
+	for(vlUInt i = 0; i < (vlUInt)Sorted.size(); i++)
+	{
+		SMaterial &Material = Sorted[i];
+
+		if(bSameRoot)
+		{
+			while(Old != this->State->Materials.end() && Old->Name < Material.Name)
+			{
+				++Old;
+			}
+
+			if(Old != this->State->Materials.end() && Old->Name == Material.Name && Old->uiFileSize == Material.uiFileSize && Old->uiModified == Material.uiModified)
+			{
+				Material.Shader.swap(Old->Shader);
+				Material.Error.swap(Old->Error);
+				Material.bError = Old->bError;
+				Material.References.swap(Old->References);
+				continue;
+			}
+		}
+
+		Pending.push_back(i);
+	}
+
+	// Materials are small, so opening them is most of the cost; keep plenty in flight.
+	if(uiThreads == 0)
+	{
+		uiThreads = std::max(1u, std::thread::hardware_concurrency()) * 2;
+	}
+	if(uiThreads > Pending.size())
+	{
+		uiThreads = (vlUInt)Pending.size();
+	}
+
+	SVTFLibOptions Options;
+	VTFLib::GetOptions(Options);
+	Options.uiVMTParseMode = PARSE_MODE_LOOSE;
+
+	std::atomic<vlUInt> uiNext(0);
+	auto Worker = [&]()
+	{
+		for(vlUInt i = uiNext++; i < Pending.size(); i = uiNext++)
+		{
+			ParseMaterial(Root + PATH_SEPARATOR + SortedPaths[Pending[i]], Options, Sorted[Pending[i]]);
+		}
+	};
+
+	std::vector<std::thread> Threads;
+	for(vlUInt i = 1; i < uiThreads; i++)
+	{
+		Threads.push_back(std::thread(Worker));
+	}
+
+	Worker();
+
+	for(std::vector<std::thread>::iterator i = Threads.begin(); i != Threads.end(); ++i)
+	{
+		(*i).join();
+	}
+
+	this->State->Root = Root;
+	this->State->Materials.swap(Sorted);
+	this->State->uiParsed = (vlUInt)Pending.size();
+	this->State->uiReused = (vlUInt)(this->State->Materials.size() - Pending.size());
+
+	return vlTrue;
+}
+
+const vlChar *CMaterialGraph::GetRoot() const
+{
+	return this->State->Root.c_str();
+}
+
+vlUInt CMaterialGraph::GetParsedCount() const
+{
+	return this->State->uiParsed;
+}
+
+vlUInt CMaterialGraph::GetReusedCount() const
+{
+	return this->State->uiReused;
+}
+
+vlUInt CMaterialGraph::GetMaterialCount() const
+{
+	return (vlUInt)this->State->Materials.size();
+}
+
+vlUInt CMaterialGraph::FindMaterial(const vlChar *cName) const
+{
+	const SMaterial *Material = this->State->Find(Normalize(cName));
+	return Material != 0 ? (vlUInt)(Material - this->State->Materials.data()) : MATERIAL_GRAPH_INVALID_INDEX;
+}
+
+const vlChar *CMaterialGraph::GetMaterialName(vlUInt uiMaterial) const
+{
+	return uiMaterial < this->State->Materials.size() ? this->State->Materials[uiMaterial].Name.c_str() : 0;
+}
+
+const vlChar *CMaterialGraph::GetMaterialShader(vlUInt uiMaterial) const
+{
+	return uiMaterial < this->State->Materials.size() ? this->State->Materials[uiMaterial].Shader.c_str() : 0;
+}
+
+const vlChar *CMaterialGraph::GetMaterialError(vlUInt uiMaterial) const
+{
+	if(uiMaterial >= this->State->Materials.size() || !this->State->Materials[uiMaterial].bError)
+	{
+		return 0;
+	}
+
+	return this->State->Materials[uiMaterial].Error.c_str();
+}
+
+vlUInt CMaterialGraph::GetReferenceCount(vlUInt uiMaterial) const
+{
+	return uiMaterial < this->State->Materials.size() ? (vlUInt)this->State->Materials[uiMaterial].References.size() : 0;
+}
+
+MaterialReferenceType CMaterialGraph::GetReferenceType(vlUInt uiMaterial, vlUInt uiReference) const
+{
+	if(uiReference >= this->GetReferenceCount(uiMaterial))
+	{
+		return MATERIAL_REFERENCE_COUNT;
+	}
+
+	return this->State->Materials[uiMaterial].References[uiReference].ReferenceType;
+}
+
+const vlChar *CMaterialGraph::GetReferenceName(vlUInt uiMaterial, vlUInt uiReference) const
+{
+	if(uiReference >= this->GetReferenceCount(uiMaterial))
+	{
+		return 0;
+	}
+
+	return this->State->Materials[uiMaterial].References[uiReference].Name.c_str();
+}
+
+const vlChar *CMaterialGraph::Resolve(const vlChar *cName, MaterialReferenceType ReferenceType) const
+{
+	if(ReferenceType < 0 || ReferenceType >= MATERIAL_REFERENCE_COUNT)
+	{
+		LastError.Set("Invalid reference type.");
+		return 0;
+	}
+
+	std::string Name = Normalize(cName);
+	for(vlUInt uiDepth = 0; uiDepth <= MATERIAL_GRAPH_MAX_INCLUDE_DEPTH; uiDepth++)
+	{
+		const SMaterial *Material = this->State->Find(Name);
+		if(Material == 0)
+		{
+			LastError.SetFormatted("Material %s not found.", Name.c_str());
+			return 0;
+		}
+
+		const SMaterialReference *Include = 0;
+		for(std::vector<SMaterialReference>::const_iterator i = Material->References.begin(); i != Material->References.end(); ++i)
+		{
+			if(i->ReferenceType == ReferenceType)
+			{
+				return i->Name.c_str();
+			}
+
+			if(i->ReferenceType == MATERIAL_REFERENCE_INCLUDE && Include == 0)
+			{
+				Include = &*i;
+			}
+		}
+
+		if(Include == 0)
+		{
+			break;
+		}
+
+		Name = Include->Name;
+	}
+
+	LastError.SetFormatted("Material %s has no %s.", cName, ReferenceKeys[ReferenceType].cKey);
+	return 0;
+}
+
+vlVoid CMaterialGraph::NormalizeName(const vlChar *cPath, vlChar *cName, vlUInt uiNameSize)
+{
+	if(uiNameSize == 0)
+	{
+		return;
+	}
+
+	std::string Name = Normalize(cPath);
+	strncpy(cName, Name.c_str(), uiNameSize - 1);
+	cName[uiNameSize - 1] = '\0';
+}
+
+//
+// vlCreateMaterialGraph()
+// Creates an empty material graph.  Fill it with vlMaterialGraphLoad() and
+// vlMaterialGraphScan().
+//
+VTFLIB_API vlBool vlCreateMaterialGraph(VLMaterialGraph **MaterialGraph)
+{
+	if(!bInitialized)
+	{
+		LastError.Set("VTFLib not initialized.");
+		return vlFalse;
+	}
+
+	*MaterialGraph = reinterpret_cast<VLMaterialGraph *>(new CMaterialGraph());
+
+	return vlTrue;
+}
+
+VTFLIB_API vlVoid vlDeleteMaterialGraph(VLMaterialGraph *MaterialGraph)
+{
+	delete reinterpret_cast<CMaterialGraph *>(MaterialGraph);
+}
+
+static CMaterialGraph *FromHandle(VLMaterialGraph *MaterialGraph)
+{
+	if(MaterialGraph == 0)
+	{
+		LastError.Set("Invalid material graph.");
+		return 0;
+	}
+
+	return reinterpret_cast<CMaterialGraph *>(MaterialGraph);
+}
+
+VTFLIB_API vlBool vlMaterialGraphLoad(VLMaterialGraph *MaterialGraph, const vlChar *cFileName)
+{
+	CMaterialGraph *Instance = FromHandle(MaterialGraph);
+	if(Instance == 0)
+		return vlFalse;
+
+	return Instance->Load(cFileName);
+}
+
+VTFLIB_API vlBool vlMaterialGraphSave(VLMaterialGraph *MaterialGraph, const vlChar *cFileName)
+{
+	CMaterialGraph *Instance = FromHandle(MaterialGraph);
+	if(Instance == 0)
+		return vlFalse;
+
+	return Instance->Save(cFileName);
+}
+
+//
+// vlMaterialGraphScan()
+// Brings the graph up to date with a materials folder, parsing only the
+// materials that changed since it was last scanned or loaded.
+//
+VTFLIB_API vlBool vlMaterialGraphScan(VLMaterialGraph *MaterialGraph, const vlChar *cRoot, vlUInt uiThreads)
+{
+	CMaterialGraph *Instance = FromHandle(MaterialGraph);
+	if(Instance == 0)
+		return vlFalse;
+
+	return Instance->Scan(cRoot, uiThreads);
+}
+
+VTFLIB_API vlUInt vlMaterialGraphGetMaterialCount(VLMaterialGraph *MaterialGraph)
+{
+	CMaterialGraph *Instance = FromHandle(MaterialGraph);
+	if(Instance == 0)
+		return 0;
+
+	return Instance->GetMaterialCount();
+}
+
+VTFLIB_API vlUInt vlMaterialGraphFindMaterial(VLMaterialGraph *MaterialGraph, const vlChar *cName)
+{
+	CMaterialGraph *Instance = FromHandle(MaterialGraph);
+	if(Instance == 0)
+		return MATERIAL_GRAPH_INVALID_INDEX;
+
+	return Instance->FindMaterial(cName);
+}
+
+VTFLIB_API const vlChar *vlMaterialGraphGetMaterialName(VLMaterialGraph *MaterialGraph, vlUInt uiMaterial)
+{
+	CMaterialGraph *Instance = FromHandle(MaterialGraph);
+	if(Instance == 0)
+		return 0;
+
+	return Instance->GetMaterialName(uiMaterial);
+}
+
+//
+// vlMaterialGraphResolve()
+// Finds what a material uses for a reference, following includes.  Returns
+// null if the material or reference can't be found.
+//
+VTFLIB_API const vlChar *vlMaterialGraphResolve(VLMaterialGraph *MaterialGraph, const vlChar *cName, MaterialReferenceType ReferenceType)
+{
+	CMaterialGraph *Instance = FromHandle(MaterialGraph);
+	if(Instance == 0)
+		return 0;
+
+	return Instance->Resolve(cName, ReferenceType);
+}
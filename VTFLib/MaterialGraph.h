@@ -0,0 +1,127 @@
+/*
+ * VTFLib
+ * Copyright (C) 2005-2010 Neil Jedrzejewski & Ryan Gregg
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later
+ * version.
+ */
+
+// ============================================================
+// NOTE: This file is commented for compatibility with Doxygen.
+// ============================================================
+/*!
+	\file MaterialGraph.h
+	\brief The textures and materials every material in a folder refers to.
+*/
+
+#ifndef MATERIALGRAPH_H
+#define MATERIALGRAPH_H
+
+#include "stdafx.h"
+#include "MaterialGraphWrapper.h"
+
+#define MATERIAL_GRAPH_VERSION			1	//!< Version of the cache file format.
+#define MATERIAL_GRAPH_MAX_INCLUDE_DEPTH	8	//!< Longest chain of includes Resolve() follows.
+
+namespace VTFLib
+{
+	class CMaterialGraphState;
+
+	//! The references between the materials under a materials folder.
+	/*!
+		Scan() parses every .vmt under the folder on a pool of threads and records
+		the textures ($basetexture, $bumpmap, $envmap and their second layers) and
+		materials (the include of a patch material) each one names.  The graph can
+		be saved and loaded again, after which Scan() only parses materials whose
+		size or modified time changed, so refreshing a large tree costs little more
+		than listing it.
+
+		Names are the way materials refer to each other: relative to the materials
+		folder, lower case, forward slashes and no extension.  Any spelling of a
+		name is accepted and normalized.
+
+		Materials that fail to parse stay in the graph with an error and no
+		references.
+	*/
+	class VTFLIB_API CMaterialGraph
+	{
+	private:
+		CMaterialGraphState *State;
+
+	public:
+		CMaterialGraph();
+		~CMaterialGraph();
+
+	private:
+		CMaterialGraph(const CMaterialGraph &);
+		CMaterialGraph &operator=(const CMaterialGraph &);
+
+	public:
+		vlVoid Destroy();	//!< Forgets every material.
+
+		//! Loads a graph saved with Save().
+		/*!
+			\return true on success, otherwise false and the graph is empty.
+		*/
+		vlBool Load(const vlChar *cFileName);
+
+		//! Saves the graph.  The file is written beside the old one and swapped in.
+		/*!
+			\return true on success, otherwise false.
+		*/
+		vlBool Save(const vlChar *cFileName) const;
+
+		//! Brings the graph up to date with a materials folder.
+		/*!
+			Materials already in the graph from the same folder are reused if their
+			size and modified time haven't changed.
+
+			\param cRoot is the materials folder.
+			\param uiThreads is the number of parsing threads, 0 for one per core.
+			\return true if the folder could be listed, otherwise false.
+		*/
+		vlBool Scan(const vlChar *cRoot, vlUInt uiThreads = 0);
+
+		const vlChar *GetRoot() const;		//!< Returns the folder of the last scan, empty if none.
+
+		vlUInt GetParsedCount() const;		//!< Returns the number of materials the last scan parsed.
+		vlUInt GetReusedCount() const;		//!< Returns the number of materials the last scan reused.
+
+	public:
+		vlUInt GetMaterialCount() const;
+
+		//! Returns the index of a material, or MATERIAL_GRAPH_INVALID_INDEX if there is none.
+		vlUInt FindMaterial(const vlChar *cName) const;
+
+		const vlChar *GetMaterialName(vlUInt uiMaterial) const;
+		const vlChar *GetMaterialShader(vlUInt uiMaterial) const;	//!< Returns the shader, empty if the material failed to parse.
+		const vlChar *GetMaterialError(vlUInt uiMaterial) const;	//!< Returns the parse error, or null if the material parsed.
+
+		vlUInt GetReferenceCount(vlUInt uiMaterial) const;
+		MaterialReferenceType GetReferenceType(vlUInt uiMaterial, vlUInt uiReference) const;
+		const vlChar *GetReferenceName(vlUInt uiMaterial, vlUInt uiReference) const;
+
+		//! Finds what a material uses for a reference, following includes.
+		/*!
+			A reference in the material itself (for a patch, in its replace or
+			insert block) wins over one in the material it includes.
+
+			\return the texture or material name, or null if the material or
+			reference can't be found.
+		*/
+		const vlChar *Resolve(const vlChar *cName, MaterialReferenceType ReferenceType) const;
+
+	public:
+		//! Converts a file path or material value to a name.
+		/*!
+			Backslashes become forward slashes, case is folded, a leading materials
+			folder and a .vmt or .vtf extension are removed.
+		*/
+		static vlVoid NormalizeName(const vlChar *cPath, vlChar *cName, vlUInt uiNameSize);
+	};
+}
+
+#endif
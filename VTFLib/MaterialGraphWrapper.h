@@ -0,0 +1,60 @@
+/*
+ * VTFLib
+ * Copyright (C) 2005-2010 Neil Jedrzejewski & Ryan Gregg
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later
+ * version.
+ */
+
+#ifndef MATERIALGRAPHWRAPPER_H
+#define MATERIALGRAPHWRAPPER_H
+
+#include "stdafx.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MATERIAL_GRAPH_INVALID_INDEX	0xffffffff
+
+typedef enum tagMaterialReferenceType
+{
+	MATERIAL_REFERENCE_BASETEXTURE = 0,
+	MATERIAL_REFERENCE_BASETEXTURE2,
+	MATERIAL_REFERENCE_BUMPMAP,
+	MATERIAL_REFERENCE_BUMPMAP2,
+	MATERIAL_REFERENCE_ENVMAP,
+	MATERIAL_REFERENCE_INCLUDE,
+	MATERIAL_REFERENCE_COUNT
+} MaterialReferenceType;
+
+//
+// What every .vmt under a materials folder refers to, scanned in parallel and
+// cached in a file so later scans only parse materials that changed.  Names
+// are the way materials refer to each other: relative to the materials
+// folder, lower case, forward slashes and no extension.
+//
+
+typedef struct tagVLMaterialGraph VLMaterialGraph;
+
+VTFLIB_API vlBool vlCreateMaterialGraph(VLMaterialGraph **MaterialGraph);
+VTFLIB_API vlVoid vlDeleteMaterialGraph(VLMaterialGraph *MaterialGraph);
+
+VTFLIB_API vlBool vlMaterialGraphLoad(VLMaterialGraph *MaterialGraph, const vlChar *cFileName);
+VTFLIB_API vlBool vlMaterialGraphSave(VLMaterialGraph *MaterialGraph, const vlChar *cFileName);
+VTFLIB_API vlBool vlMaterialGraphScan(VLMaterialGraph *MaterialGraph, const vlChar *cRoot, vlUInt uiThreads);
+
+VTFLIB_API vlUInt vlMaterialGraphGetMaterialCount(VLMaterialGraph *MaterialGraph);
+VTFLIB_API vlUInt vlMaterialGraphFindMaterial(VLMaterialGraph *MaterialGraph, const vlChar *cName);
+VTFLIB_API const vlChar *vlMaterialGraphGetMaterialName(VLMaterialGraph *MaterialGraph, vlUInt uiMaterial);
+
+VTFLIB_API const vlChar *vlMaterialGraphResolve(VLMaterialGraph *MaterialGraph, const vlChar *cName, MaterialReferenceType ReferenceType);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
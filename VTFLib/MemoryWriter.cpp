@@ -52,9 +52,11 @@ vlBool CMemoryWriter::Open()
 	return vlTrue;
 }
 
-vlVoid CMemoryWriter::Close()
+vlBool CMemoryWriter::Close()
 {
 	this->bOpened = vlFalse;
+
+	return vlTrue;
 }
 
 vlUInt CMemoryWriter::GetStreamSize() const
@@ -40,7 +40,7 @@ namespace VTFLib
 				virtual vlBool Opened() const;
 
 				virtual vlBool Open();
-				virtual vlVoid Close();
+				virtual vlBool Close();
 
 				virtual vlUInt GetStreamSize() const;
 				virtual vlUInt GetStreamPointer() const;
@@ -0,0 +1,79 @@
+/*
+ * VTFLib
+ * Copyright (C) 2005-2011 Neil Jedrzejewski & Ryan Gregg
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later
+ * version.
+ */
+
+// ============================================================
+// NOTE: This file is commented for compatibility with Doxygen.
+// ============================================================
+/*!
+	\file Options.h
+	\brief Header file for the processing options struct.
+*/
+
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+#include "stdafx.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//! VTFLib processing options struct.
+/*!
+	The SVTFLibOptions struct holds every tunable used while converting,
+	compressing, re-sizing and parsing.  The library keeps one process wide
+	copy (set with vlSetInteger() and friends) which is used when no other
+	options are given.  Objects and functions that take an SVTFLibOptions
+	use it instead, so several threads can process images at the same time
+	with different settings.
+
+	\see vlGetOptions()
+	\see CVTFFile::SetOptions()
+*/
+#pragma pack(1)
+typedef struct tagSVTFLibOptions
+{
+	vlUInt uiDXTQuality;				//!< DXT compression quality (see VTFDXTQuality).
+
+	vlSingle sLuminanceWeightR;			//!< Red weight used when converting to luminance formats.
+	vlSingle sLuminanceWeightG;			//!< Green weight used when converting to luminance formats.
+	vlSingle sLuminanceWeightB;			//!< Blue weight used when converting to luminance formats.
+
+	vlUShort uiBlueScreenMaskR;			//!< Blue screen mask red value.
+	vlUShort uiBlueScreenMaskG;			//!< Blue screen mask green value.
+	vlUShort uiBlueScreenMaskB;			//!< Blue screen mask blue value.
+
+	vlUShort uiBlueScreenClearR;		//!< Blue screen clear red value.
+	vlUShort uiBlueScreenClearG;		//!< Blue screen clear green value.
+	vlUShort uiBlueScreenClearB;		//!< Blue screen clear blue value.
+
+	vlSingle sFP16HDRKey;				//!< FP16 HDR tone mapping key.
+	vlSingle sFP16HDRShift;				//!< FP16 HDR tone mapping shift.
+	vlSingle sFP16HDRGamma;				//!< FP16 HDR tone mapping gamma.
+
+	vlSingle sUnsharpenRadius;			//!< Unsharpen mask radius.
+	vlSingle sUnsharpenAmount;			//!< Unsharpen mask amount.
+	vlSingle sUnsharpenThreshold;		//!< Unsharpen mask threshold.
+
+	vlSingle sXSharpenStrength;			//!< XSharpen strength.
+	vlSingle sXSharpenThreshold;		//!< XSharpen threshold.
+
+	vlUInt uiVMTParseMode;				//!< VMT parsing mode (see VMTParseMode).
+
+	vlBool bWriteCRC;					//!< Add an image data CRC resource when saving v7.3+ images.
+} SVTFLibOptions;
+#pragma pack()
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
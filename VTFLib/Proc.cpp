@@ -28,6 +28,26 @@ namespace VTFLib
 	PWriteSeekProc pWriteSeekProc = 0;
 	PWriteSizeProc pWriteSizeProc = 0;
 	PWriteTellProc pWriteTellProc = 0;
+
+	vlVoid GetReadProcs(SVLReadProcs &ReadProcs)
+	{
+		ReadProcs.pReadCloseProc = pReadCloseProc;
+		ReadProcs.pReadOpenProc = pReadOpenProc;
+		ReadProcs.pReadReadProc = pReadReadProc;
+		ReadProcs.pReadSeekProc = pReadSeekProc;
+		ReadProcs.pReadSizeProc = pReadSizeProc;
+		ReadProcs.pReadTellProc = pReadTellProc;
+	}
+
+	vlVoid GetWriteProcs(SVLWriteProcs &WriteProcs)
+	{
+		WriteProcs.pWriteCloseProc = pWriteCloseProc;
+		WriteProcs.pWriteOpenProc = pWriteOpenProc;
+		WriteProcs.pWriteWriteProc = pWriteWriteProc;
+		WriteProcs.pWriteSeekProc = pWriteSeekProc;
+		WriteProcs.pWriteSizeProc = pWriteSizeProc;
+		WriteProcs.pWriteTellProc = pWriteTellProc;
+	}
 }
 
 VTFLIB_API vlVoid vlSetProc(VLProc Proc, vlVoid *pProc)
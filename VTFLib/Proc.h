@@ -57,6 +57,28 @@ typedef vlUInt (*PWriteSeekProc) (vlLong, VLSeekMode, vlVoid *);
 typedef vlUInt (*PWriteSizeProc) (vlVoid *);
 typedef vlUInt (*PWriteTellProc) (vlVoid *);
 
+//! Read callbacks used by a single proc reader.
+typedef struct tagSVLReadProcs
+{
+	PReadCloseProc pReadCloseProc;
+	PReadOpenProc pReadOpenProc;
+	PReadReadProc pReadReadProc;
+	PReadSeekProc pReadSeekProc;
+	PReadSizeProc pReadSizeProc;
+	PReadTellProc pReadTellProc;
+} SVLReadProcs;
+
+//! Write callbacks used by a single proc writer.
+typedef struct tagSVLWriteProcs
+{
+	PWriteCloseProc pWriteCloseProc;
+	PWriteOpenProc pWriteOpenProc;
+	PWriteWriteProc pWriteWriteProc;
+	PWriteSeekProc pWriteSeekProc;
+	PWriteSizeProc pWriteSizeProc;
+	PWriteTellProc pWriteTellProc;
+} SVLWriteProcs;
+
 #ifdef __cplusplus
 }
 #endif
@@ -76,6 +98,10 @@ namespace VTFLib
 	extern PWriteSeekProc pWriteSeekProc;
 	extern PWriteSizeProc pWriteSizeProc;
 	extern PWriteTellProc pWriteTellProc;
+
+	// Snapshot the callbacks set with vlSetProc().
+	vlVoid GetReadProcs(SVLReadProcs &ReadProcs);
+	vlVoid GetWriteProcs(SVLWriteProcs &WriteProcs);
 }
 
 #ifdef __cplusplus
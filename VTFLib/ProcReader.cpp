@@ -20,6 +20,15 @@ CProcReader::CProcReader(vlVoid *pUserData)
 {
 	this->bOpened = vlFalse;
 	this->pUserData = pUserData;
+
+	GetReadProcs(this->ReadProcs);
+}
+
+CProcReader::CProcReader(const SVLReadProcs &ReadProcs, vlVoid *pUserData)
+{
+	this->bOpened = vlFalse;
+	this->pUserData = pUserData;
+	this->ReadProcs = ReadProcs;
 }
 
 CProcReader::~CProcReader()
@@ -36,7 +45,7 @@ vlBool CProcReader::Open()
 {
 	this->Close();
 
-	if(pReadOpenProc == 0)
+	if(this->ReadProcs.pReadOpenProc == 0)
 	{
 		LastError.Set("pReadOpenProc not set.");
 		return vlFalse;
@@ -48,7 +57,7 @@ vlBool CProcReader::Open()
 		return vlFalse;
 	}
 
-	if(!pReadOpenProc(this->pUserData))
+	if(!this->ReadProcs.pReadOpenProc(this->pUserData))
 	{
 		LastError.Set("Error opening file.");
 		return vlFalse;
@@ -61,14 +70,14 @@ vlBool CProcReader::Open()
 
 vlVoid CProcReader::Close()
 {
-	if(pReadCloseProc == 0)
+	if(this->ReadProcs.pReadCloseProc == 0)
 	{
 		return;
 	}
 
 	if(this->bOpened)
 	{
-		pReadCloseProc(this->pUserData);
+		this->ReadProcs.pReadCloseProc(this->pUserData);
 		this->bOpened = vlFalse;
 	}
 }
@@ -80,13 +89,13 @@ vlUInt CProcReader::GetStreamSize() const
 		return 0;
 	}
 
-	if(pReadSizeProc == 0)
+	if(this->ReadProcs.pReadSizeProc == 0)
 	{
 		LastError.Set("pReadSizeProc not set.");
 		return 0xffffffff;
 	}
 
-	return pReadSizeProc(this->pUserData);
+	return this->ReadProcs.pReadSizeProc(this->pUserData);
 }
 
 vlUInt CProcReader::GetStreamPointer() const
@@ -96,13 +105,13 @@ vlUInt CProcReader::GetStreamPointer() const
 		return 0;
 	}
 
-	if(pReadTellProc == 0)
+	if(this->ReadProcs.pReadTellProc == 0)
 	{
 		LastError.Set("pReadTellProc not set.");
 		return 0;
 	}
 
-	return pReadTellProc(this->pUserData);
+	return this->ReadProcs.pReadTellProc(this->pUserData);
 }
 
 vlUInt CProcReader::Seek(vlLong lOffset, vlUInt uiMode)
@@ -112,13 +121,13 @@ vlUInt CProcReader::Seek(vlLong lOffset, vlUInt uiMode)
 		return 0;
 	}
 
-	if(pReadSeekProc == 0)
+	if(this->ReadProcs.pReadSeekProc == 0)
 	{
 		LastError.Set("pReadSeekProc not set.");
 		return 0;
 	}
 
-	return pReadSeekProc(lOffset, (VLSeekMode)uiMode, this->pUserData);
+	return this->ReadProcs.pReadSeekProc(lOffset, (VLSeekMode)uiMode, this->pUserData);
 }
 
 vlBool CProcReader::Read(vlChar &cChar)
@@ -128,13 +137,13 @@ vlBool CProcReader::Read(vlChar &cChar)
 		return vlFalse;
 	}
 
-	if(pReadReadProc == 0)
+	if(this->ReadProcs.pReadReadProc == 0)
 	{
 		LastError.Set("pReadReadProc not set.");
 		return vlFalse;
 	}
 
-	vlUInt uiBytesRead = pReadReadProc(&cChar, 1, this->pUserData);
+	vlUInt uiBytesRead = this->ReadProcs.pReadReadProc(&cChar, 1, this->pUserData);
 
 	if(uiBytesRead == 0)
 	{
@@ -151,13 +160,13 @@ vlUInt CProcReader::Read(vlVoid *vData, vlUInt uiBytes)
 		return 0;
 	}
 
-	if(pReadReadProc == 0)
+	if(this->ReadProcs.pReadReadProc == 0)
 	{
 		LastError.Set("pReadReadProc not set.");
 		return 0;
 	}
 
-	vlUInt uiBytesRead = pReadReadProc(vData, uiBytes, this->pUserData);
+	vlUInt uiBytesRead = this->ReadProcs.pReadReadProc(vData, uiBytes, this->pUserData);
 
 	if(uiBytesRead == 0)
 	{
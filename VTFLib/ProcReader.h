@@ -14,6 +14,7 @@
 
 #include "stdafx.h"
 #include "Reader.h"
+#include "Proc.h"
 
 namespace VTFLib
 {
@@ -26,9 +27,11 @@ namespace VTFLib
 			private:
 				vlBool bOpened;
 				vlVoid *pUserData;
+				SVLReadProcs ReadProcs;	// Copied on construction so vlSetProc() can't change them mid stream.
 
 			public:
 				CProcReader(vlVoid *pUserData);
+				CProcReader(const SVLReadProcs &ReadProcs, vlVoid *pUserData);
 				~CProcReader();
 
 			public:
@@ -20,6 +20,15 @@ CProcWriter::CProcWriter(vlVoid *pUserData)
 {
 	this->bOpened = vlFalse;
 	this->pUserData = pUserData;
+
+	GetWriteProcs(this->WriteProcs);
+}
+
+CProcWriter::CProcWriter(const SVLWriteProcs &WriteProcs, vlVoid *pUserData)
+{
+	this->bOpened = vlFalse;
+	this->pUserData = pUserData;
+	this->WriteProcs = WriteProcs;
 }
 
 CProcWriter::~CProcWriter()
@@ -36,7 +45,7 @@ vlBool CProcWriter::Open()
 {
 	this->Close();
 
-	if(pWriteOpenProc == 0)
+	if(this->WriteProcs.pWriteOpenProc == 0)
 	{
 		LastError.Set("pWriteOpenProc not set.");
 		return vlFalse;
@@ -48,7 +57,7 @@ vlBool CProcWriter::Open()
 		return vlFalse;
 	}
 
-	if(!pWriteOpenProc(this->pUserData))
+	if(!this->WriteProcs.pWriteOpenProc(this->pUserData))
 	{
 		LastError.Set("Error opening file.");
 		return vlFalse;
@@ -59,18 +68,20 @@ vlBool CProcWriter::Open()
 	return vlTrue;
 }
 
-vlVoid CProcWriter::Close()
+vlBool CProcWriter::Close()
 {
-	if(pWriteCloseProc == 0)
+	if(this->WriteProcs.pWriteCloseProc == 0)
 	{
-		return;
+		return vlTrue;
 	}
 
 	if(this->bOpened)
 	{
-		pWriteCloseProc(this->pUserData);
+		this->WriteProcs.pWriteCloseProc(this->pUserData);
 		this->bOpened = vlFalse;
 	}
+
+	return vlTrue;
 }
 
 vlUInt CProcWriter::GetStreamSize() const
@@ -80,13 +91,13 @@ vlUInt CProcWriter::GetStreamSize() const
 		return 0;
 	}
 
-	if(pWriteSizeProc == 0)
+	if(this->WriteProcs.pWriteSizeProc == 0)
 	{
 		LastError.Set("pWriteTellProc not set.");
 		return 0xffffffff;
 	}
 
-	return pWriteSizeProc(this->pUserData);
+	return this->WriteProcs.pWriteSizeProc(this->pUserData);
 }
 
 vlUInt CProcWriter::GetStreamPointer() const
@@ -96,13 +107,13 @@ vlUInt CProcWriter::GetStreamPointer() const
 		return 0;
 	}
 
-	if(pWriteTellProc == 0)
+	if(this->WriteProcs.pWriteTellProc == 0)
 	{
 		LastError.Set("pWriteTellProc not set.");
 		return 0;
 	}
 
-	return pWriteTellProc(this->pUserData);
+	return this->WriteProcs.pWriteTellProc(this->pUserData);
 }
 
 vlUInt CProcWriter::Seek(vlLong lOffset, vlUInt uiMode)
@@ -112,13 +123,13 @@ vlUInt CProcWriter::Seek(vlLong lOffset, vlUInt uiMode)
 		return 0;
 	}
 
-	if(pWriteSeekProc == 0)
+	if(this->WriteProcs.pWriteSeekProc == 0)
 	{
 		LastError.Set("pWriteSeekProc not set.");
 		return 0;
 	}
 
-	return pWriteSeekProc(lOffset, (VLSeekMode)uiMode, this->pUserData);
+	return this->WriteProcs.pWriteSeekProc(lOffset, (VLSeekMode)uiMode, this->pUserData);
 }
 
 vlBool CProcWriter::Write(vlChar cChar)
@@ -128,13 +139,13 @@ vlBool CProcWriter::Write(vlChar cChar)
 		return vlFalse;
 	}
 
-	if(pWriteWriteProc == 0)
+	if(this->WriteProcs.pWriteWriteProc == 0)
 	{
 		LastError.Set("pWriteWriteProc not set.");
 		return vlFalse;
 	}
 
-	vlUInt uiBytesWritten = pWriteWriteProc(&cChar, 1, this->pUserData);
+	vlUInt uiBytesWritten = this->WriteProcs.pWriteWriteProc(&cChar, 1, this->pUserData);
 
 	if(uiBytesWritten == 0)
 	{
@@ -151,13 +162,13 @@ vlUInt CProcWriter::Write(vlVoid *vData, vlUInt uiBytes)
 		return 0;
 	}
 
-	if(pWriteWriteProc == 0)
+	if(this->WriteProcs.pWriteWriteProc == 0)
 	{
 		LastError.Set("pWriteWriteProc not set.");
 		return 0;
 	}
 
-	vlUInt uiBytesWritten = pWriteWriteProc(vData, uiBytes, this->pUserData);
+	vlUInt uiBytesWritten = this->WriteProcs.pWriteWriteProc(vData, uiBytes, this->pUserData);
 
 	if(uiBytesWritten == 0)
 	{
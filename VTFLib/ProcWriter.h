@@ -14,6 +14,7 @@
 
 #include "stdafx.h"
 #include "Writer.h"
+#include "Proc.h"
 
 namespace VTFLib
 {
@@ -26,16 +27,18 @@ namespace VTFLib
 			private:
 				vlBool bOpened;
 				vlVoid *pUserData;
+				SVLWriteProcs WriteProcs;	// Copied on construction so vlSetProc() can't change them mid stream.
 
 			public:
 				CProcWriter(vlVoid *pUserData);
+				CProcWriter(const SVLWriteProcs &WriteProcs, vlVoid *pUserData);
 				~CProcWriter();
 
 			public:
 				virtual vlBool Opened() const;
 
 				virtual vlBool Open();
-				virtual vlVoid Close();
+				virtual vlBool Close();
 
 				virtual vlUInt GetStreamSize() const;
 				virtual vlUInt GetStreamPointer() const;
@@ -7,6 +7,8 @@
  */
 
 #include "Reader.h"
+#include "BufferedReader.h"
 #include "FileReader.h"
 #include "MemoryReader.h"
-#include "ProcReader.h"
\ No newline at end of file
+#include "ProcReader.h"
+#include "VPKReader.h"
\ No newline at end of file
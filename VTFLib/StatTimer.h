@@ -0,0 +1,116 @@
+/*
+ * VTFLib
+ * Copyright (C) 2005-2010 Neil Jedrzejewski & Ryan Gregg
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later
+ * version.
+ */
+
+// Hooks the library uses to feed Stats.h.  When statistics and tracing are
+// both off a timer costs one relaxed atomic load.
+
+#ifndef STATTIMER_H
+#define STATTIMER_H
+
+#include "stdafx.h"
+#include "Stats.h"
+
+#include <atomic>
+
+#define STAT_FLAG_COUNT		0x01
+#define STAT_FLAG_TRACE		0x02
+
+namespace VTFLib
+{
+	namespace Diagnostics
+	{
+		// STAT_FLAG_* bits, set by the VTFLIB_STATS and VTFLIB_TRACE options.
+		extern std::atomic<vlUInt> uiStatFlags;
+
+		vlVoid SetStatFlag(vlUInt uiFlag, vlBool bEnabled);
+		vlBool GetStatFlag(vlUInt uiFlag);
+
+		// Times one call and adds it to the statistics and the trace when it goes
+		// out of scope.
+		class CStatTimer
+		{
+		private:
+			vlUInt uiFlags;
+			vlUInt uiSlot;
+			vlUInt64 uiBytes;
+			vlUInt64 uiStart;
+
+		public:
+			CStatTimer(VTFLibStat Stat, vlUInt64 uiBytes = 0) : uiFlags(uiStatFlags.load(std::memory_order_relaxed)), uiSlot((vlUInt)Stat), uiBytes(uiBytes), uiStart(0)
+			{
+				if(this->uiFlags != 0)
+				{
+					this->Start();
+				}
+			}
+
+			// Conversions are counted per format pair, with the source image size
+			// as the bytes.  Conversions made inside another conversion on the
+			// same thread are not counted.
+			CStatTimer(VTFImageFormat SourceFormat, VTFImageFormat DestFormat, vlUInt uiWidth, vlUInt uiHeight) : uiFlags(uiStatFlags.load(std::memory_order_relaxed)), uiSlot(0), uiBytes(0), uiStart(0)
+			{
+				if(this->uiFlags != 0)
+				{
+					this->StartConvert(SourceFormat, DestFormat, uiWidth, uiHeight);
+				}
+			}
+
+			// DXTn decoding or encoding done by a conversion in Format, with the
+			// RGBA image size as the bytes.  Only counted when made before the
+			// conversion timer of the outermost conversion, so a conversion done a
+			// strip at a time is counted once for the whole image.  Formats other
+			// than DXTn aren't counted.
+			CStatTimer(VTFLibStat Stat, VTFImageFormat Format, vlUInt uiWidth, vlUInt uiHeight) : uiFlags(uiStatFlags.load(std::memory_order_relaxed)), uiSlot((vlUInt)Stat), uiBytes(0), uiStart(0)
+			{
+				if(this->uiFlags != 0)
+				{
+					this->StartDXT(Format, uiWidth, uiHeight);
+				}
+			}
+
+			~CStatTimer()
+			{
+				if(this->uiFlags != 0)
+				{
+					this->Stop();
+				}
+			}
+
+			// True if the call is being timed, so callers can skip working out
+			// the byte count when it isn't.
+			vlBool Active() const
+			{
+				return (this->uiFlags & (STAT_FLAG_COUNT | STAT_FLAG_TRACE)) != 0;
+			}
+
+			// For loads and saves, where the size is only known at the end.
+			vlVoid SetBytes(vlUInt64 uiBytes)
+			{
+				this->uiBytes = uiBytes;
+			}
+
+		private:
+			CStatTimer(const CStatTimer &);
+			CStatTimer &operator=(const CStatTimer &);
+
+			vlVoid Start();
+			vlVoid StartConvert(VTFImageFormat SourceFormat, VTFImageFormat DestFormat, vlUInt uiWidth, vlUInt uiHeight);
+			vlVoid StartDXT(VTFImageFormat Format, vlUInt uiWidth, vlUInt uiHeight);
+			vlVoid Stop();
+		};
+
+		// Record image buffer allocations and frees for SVTFLibAllocationStats.
+		vlVoid StatAllocate(vlUInt64 uiBytes);
+		vlVoid StatFree(vlUInt64 uiBytes);
+	}
+}
+
+#endif
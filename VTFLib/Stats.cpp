@@ -0,0 +1,372 @@
+/*
+ * VTFLib
+ * Copyright (C) 2005-2010 Neil Jedrzejewski & Ryan Gregg
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later
+ * version.
+ */
+
+#include "VTFLib.h"
+#include "StatTimer.h"
+#include "FileWriter.h"
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace VTFLib;
+using namespace VTFLib::Diagnostics;
+
+// One slot per VTFLibStat followed by one per conversion format pair.
+#define STAT_SLOT_COUNT		(VTFLIB_STAT_COUNT + IMAGE_FORMAT_COUNT * IMAGE_FORMAT_COUNT)
+
+// Set on a conversion timer started inside another conversion; only the
+// nesting depth is tracked.
+#define STAT_FLAG_NESTED	0x80000000
+
+#define TRACE_MAX_SPANS		(1024 * 1024)
+
+namespace
+{
+	struct SStatSlot
+	{
+		std::atomic<vlUInt64> uiCalls;
+		std::atomic<vlUInt64> uiBytes;
+		std::atomic<vlUInt64> uiNanoseconds;
+	};
+
+	struct STraceSpan
+	{
+		vlUInt uiSlot;
+		vlUInt uiThread;
+		vlUInt64 uiStart;
+		vlUInt64 uiDuration;
+		vlUInt64 uiBytes;
+	};
+
+	const vlChar *StatNames[VTFLIB_STAT_COUNT] =
+	{
+		"Convert",
+		"DXT Decode",
+		"DXT Encode",
+		"Resize",
+		"Load File",
+		"Load Memory",
+		"Load Proc",
+		"Save File",
+		"Save Memory",
+		"Save Proc",
+		"VMT Parse",
+		"VMT Load Binary",
+		"Load Package",
+		"Load DDS",
+		"Save DDS"
+	};
+
+	SStatSlot StatSlots[STAT_SLOT_COUNT];
+
+	std::mutex TraceMutex;
+	std::vector<STraceSpan> TraceSpans;
+	vlUInt64 uiTraceDropped = 0;
+
+	std::atomic<vlUInt64> uiAllocations(0);
+	std::atomic<vlUInt64> uiAllocatedBytes(0);
+	std::atomic<vlUInt64> uiPeakBytes(0);
+
+	std::atomic<vlUInt> uiNextThread(0);
+	thread_local vlUInt uiThreadIndex = 0;
+	thread_local vlUInt uiConvertDepth = 0;
+
+	const std::chrono::steady_clock::time_point Epoch = std::chrono::steady_clock::now();
+
+	vlUInt64 Now()
+	{
+		return (vlUInt64)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - Epoch).count();
+	}
+
+	vlVoid GetSlot(vlUInt uiSlot, SVTFLibStat *Stats)
+	{
+		Stats->uiCalls = StatSlots[uiSlot].uiCalls.load(std::memory_order_relaxed);
+		Stats->uiBytes = StatSlots[uiSlot].uiBytes.load(std::memory_order_relaxed);
+		Stats->uiNanoseconds = StatSlots[uiSlot].uiNanoseconds.load(std::memory_order_relaxed);
+	}
+}
+
+namespace VTFLib
+{
+	namespace Diagnostics
+	{
+		std::atomic<vlUInt> uiStatFlags(0);
+
+		vlVoid SetStatFlag(vlUInt uiFlag, vlBool bEnabled)
+		{
+			if(bEnabled)
+			{
+				uiStatFlags.fetch_or(uiFlag);
+			}
+			else
+			{
+				uiStatFlags.fetch_and(~uiFlag);
+			}
+		}
+
+		vlBool GetStatFlag(vlUInt uiFlag)
+		{
+			return (uiStatFlags.load() & uiFlag) != 0;
+		}
+
+		vlVoid StatAllocate(vlUInt64 uiBytes)
+		{
+			uiAllocations.fetch_add(1, std::memory_order_relaxed);
+			vlUInt64 uiTotal = uiAllocatedBytes.fetch_add(uiBytes, std::memory_order_relaxed) + uiBytes;
+
+			vlUInt64 uiPeak = uiPeakBytes.load(std::memory_order_relaxed);
+			while(uiTotal > uiPeak && !uiPeakBytes.compare_exchange_weak(uiPeak, uiTotal, std::memory_order_relaxed))
+			{
+			}
+		}
+
+		vlVoid StatFree(vlUInt64 uiBytes)
+		{
+			uiAllocatedBytes.fetch_sub(uiBytes, std::memory_order_relaxed);
+		}
+	}
+}
+
+vlVoid CStatTimer::Start()
+{
+	this->uiStart = Now();
+}
+
+vlVoid CStatTimer::StartConvert(VTFImageFormat SourceFormat, VTFImageFormat DestFormat, vlUInt uiWidth, vlUInt uiHeight)
+{
+	if(SourceFormat < 0 || SourceFormat >= IMAGE_FORMAT_COUNT || DestFormat < 0 || DestFormat >= IMAGE_FORMAT_COUNT)
+	{
+		this->uiFlags = 0;
+		return;
+	}
+
+	this->uiSlot = VTFLIB_STAT_COUNT + (vlUInt)SourceFormat * IMAGE_FORMAT_COUNT + (vlUInt)DestFormat;
+
+	if(uiConvertDepth++ != 0)
+	{
+		this->uiFlags = STAT_FLAG_NESTED;
+		return;
+	}
+
+	this->uiBytes = CVTFFile::ComputeImageSize(uiWidth, uiHeight, 1, SourceFormat);
+	this->Start();
+}
+
+vlVoid CStatTimer::StartDXT(VTFImageFormat Format, vlUInt uiWidth, vlUInt uiHeight)
+{
+	switch(Format)
+	{
+	case IMAGE_FORMAT_DXT1:
+	case IMAGE_FORMAT_DXT1_ONEBITALPHA:
+	case IMAGE_FORMAT_DXT3:
+	case IMAGE_FORMAT_DXT5:
+		break;
+	default:
+		this->uiFlags = 0;
+		return;
+	}
+
+	if(uiConvertDepth != 0)
+	{
+		this->uiFlags = 0;
+		return;
+	}
+
+	this->uiBytes = (vlUInt64)uiWidth * uiHeight * 4;
+	this->Start();
+}
+
+vlVoid CStatTimer::Stop()
+{
+	if(this->uiSlot >= VTFLIB_STAT_COUNT)
+	{
+		uiConvertDepth--;
+	}
+
+	if((this->uiFlags & (STAT_FLAG_COUNT | STAT_FLAG_TRACE)) == 0)
+	{
+		return;
+	}
+
+	vlUInt64 uiDuration = Now() - this->uiStart;
+
+	if(this->uiFlags & STAT_FLAG_COUNT)
+	{
+		StatSlots[this->uiSlot].uiCalls.fetch_add(1, std::memory_order_relaxed);
+		StatSlots[this->uiSlot].uiBytes.fetch_add(this->uiBytes, std::memory_order_relaxed);
+		StatSlots[this->uiSlot].uiNanoseconds.fetch_add(uiDuration, std::memory_order_relaxed);
+
+		// Conversions also count towards the total for all pairs.
+		if(this->uiSlot >= VTFLIB_STAT_COUNT)
+		{
+			StatSlots[VTFLIB_STAT_CONVERT].uiCalls.fetch_add(1, std::memory_order_relaxed);
+			StatSlots[VTFLIB_STAT_CONVERT].uiBytes.fetch_add(this->uiBytes, std::memory_order_relaxed);
+			StatSlots[VTFLIB_STAT_CONVERT].uiNanoseconds.fetch_add(uiDuration, std::memory_order_relaxed);
+		}
+	}
+
+	if(this->uiFlags & STAT_FLAG_TRACE)
+	{
+		if(uiThreadIndex == 0)
+		{
+			uiThreadIndex = ++uiNextThread;
+		}
+
+		STraceSpan Span = { this->uiSlot, uiThreadIndex, this->uiStart, uiDuration, this->uiBytes };
+
+		std::lock_guard<std::mutex> Lock(TraceMutex);
+		if(TraceSpans.size() < TRACE_MAX_SPANS)
+		{
+			TraceSpans.push_back(Span);
+		}
+		else
+		{
+			uiTraceDropped++;
+		}
+	}
+}
+
+//
+// vlGetStats()
+// Gets the totals for an operation.
+//
+VTFLIB_API vlBool vlGetStats(VTFLibStat Stat, SVTFLibStat *Stats)
+{
+	if(Stat < 0 || Stat >= VTFLIB_STAT_COUNT)
+	{
+		LastError.Set("Invalid statistic.");
+		return vlFalse;
+	}
+
+	GetSlot((vlUInt)Stat, Stats);
+
+	return vlTrue;
+}
+
+//
+// vlGetConvertStats()
+// Gets the totals for conversions from SourceFormat to DestFormat.
+//
+VTFLIB_API vlBool vlGetConvertStats(VTFImageFormat SourceFormat, VTFImageFormat DestFormat, SVTFLibStat *Stats)
+{
+	if(SourceFormat < 0 || SourceFormat >= IMAGE_FORMAT_COUNT || DestFormat < 0 || DestFormat >= IMAGE_FORMAT_COUNT)
+	{
+		LastError.Set("Invalid image format.");
+		return vlFalse;
+	}
+
+	GetSlot(VTFLIB_STAT_COUNT + (vlUInt)SourceFormat * IMAGE_FORMAT_COUNT + (vlUInt)DestFormat, Stats);
+
+	return vlTrue;
+}
+
+//
+// vlGetAllocationStats()
+// Gets the image buffer allocation counts.
+//
+VTFLIB_API vlVoid vlGetAllocationStats(SVTFLibAllocationStats *Stats)
+{
+	Stats->uiAllocations = uiAllocations.load(std::memory_order_relaxed);
+	Stats->uiBytes = uiAllocatedBytes.load(std::memory_order_relaxed);
+	Stats->uiPeakBytes = uiPeakBytes.load(std::memory_order_relaxed);
+}
+
+//
+// vlResetStats()
+// Zeroes the statistics and discards the trace.  Buffers that are still
+// allocated stay counted in the current and peak bytes.
+//
+VTFLIB_API vlVoid vlResetStats()
+{
+	for(vlUInt i = 0; i < STAT_SLOT_COUNT; i++)
+	{
+		StatSlots[i].uiCalls.store(0, std::memory_order_relaxed);
+		StatSlots[i].uiBytes.store(0, std::memory_order_relaxed);
+		StatSlots[i].uiNanoseconds.store(0, std::memory_order_relaxed);
+	}
+
+	uiAllocations.store(0, std::memory_order_relaxed);
+	uiPeakBytes.store(uiAllocatedBytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+
+	std::lock_guard<std::mutex> Lock(TraceMutex);
+	TraceSpans.clear();
+	TraceSpans.shrink_to_fit();
+	uiTraceDropped = 0;
+}
+
+//
+// vlWriteTrace()
+// Writes the captured spans as Chrome trace "complete" events, in
+// microseconds since the library was loaded.
+//
+VTFLIB_API vlBool vlWriteTrace(const vlChar *cFileName)
+{
+	std::vector<STraceSpan> Spans;
+	vlUInt64 uiDropped;
+	{
+		std::lock_guard<std::mutex> Lock(TraceMutex);
+		Spans = TraceSpans;
+		uiDropped = uiTraceDropped;
+	}
+
+	IO::Writers::CFileWriter Writer(cFileName);
+	if(!Writer.Open())
+	{
+		return vlFalse;
+	}
+
+	std::string Buffer;
+	vlChar cLine[512];
+
+	snprintf(cLine, sizeof(cLine), "{\"displayTimeUnit\":\"ns\",\"otherData\":{\"vtflib\":\"%s\",\"dropped\":\"%llu\"},\"traceEvents\":[\n", VL_VERSION_STRING, (unsigned long long)uiDropped);
+	Buffer += cLine;
+
+	for(vlUInt i = 0; i < Spans.size(); i++)
+	{
+		const STraceSpan &Span = Spans[i];
+		const vlChar *cSeparator = i + 1 < Spans.size() ? "," : "";
+
+		if(Span.uiSlot < VTFLIB_STAT_COUNT)
+		{
+			snprintf(cLine, sizeof(cLine), "{\"name\":\"%s\",\"cat\":\"vtflib\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"bytes\":%llu}}%s\n",
+				StatNames[Span.uiSlot], Span.uiThread, Span.uiStart / 1000.0, Span.uiDuration / 1000.0, (unsigned long long)Span.uiBytes, cSeparator);
+		}
+		else
+		{
+			vlUInt uiPair = Span.uiSlot - VTFLIB_STAT_COUNT;
+			snprintf(cLine, sizeof(cLine), "{\"name\":\"Convert\",\"cat\":\"vtflib\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"from\":\"%s\",\"to\":\"%s\",\"bytes\":%llu}}%s\n",
+				Span.uiThread, Span.uiStart / 1000.0, Span.uiDuration / 1000.0,
+				CVTFFile::GetImageFormatInfo((VTFImageFormat)(uiPair / IMAGE_FORMAT_COUNT)).lpName,
+				CVTFFile::GetImageFormatInfo((VTFImageFormat)(uiPair % IMAGE_FORMAT_COUNT)).lpName,
+				(unsigned long long)Span.uiBytes, cSeparator);
+		}
+		Buffer += cLine;
+
+		if(Buffer.size() >= 64 * 1024)
+		{
+			if(Writer.Write(&Buffer[0], (vlUInt)Buffer.size()) != Buffer.size())
+			{
+				Writer.Close();
+				return vlFalse;
+			}
+			Buffer.clear();
+		}
+	}
+
+	Buffer += "]}\n";
+
+	vlBool bResult = Writer.Write(&Buffer[0], (vlUInt)Buffer.size()) == Buffer.size();
+	Writer.Close();
+
+	return bResult;
+}
@@ -0,0 +1,112 @@
+/*
+ * VTFLib
+ * Copyright (C) 2005-2010 Neil Jedrzejewski & Ryan Gregg
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later
+ * version.
+ */
+
+// ============================================================
+// NOTE: This file is commented for compatibility with Doxygen.
+// ============================================================
+/*!
+	\file Stats.h
+	\brief Call statistics and trace capture for VTFLib's expensive operations.
+*/
+
+#ifndef STATS_H
+#define STATS_H
+
+#include "stdafx.h"
+#include "VTFFormat.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//! Operations VTFLib keeps statistics for.
+/*!
+	Statistics are only gathered while the VTFLIB_STATS option is set, and
+	trace spans only while VTFLIB_TRACE is set.  Both are off by default.
+
+	\see vlGetStats()
+*/
+typedef enum tagVTFLibStat
+{
+	VTFLIB_STAT_CONVERT = 0,		//!< CVTFFile::Convert() for any format pair, see vlGetConvertStats() for each pair.
+	VTFLIB_STAT_DXT_DECODE,			//!< Conversions from DXT1, DXT3 and DXT5, counted once for each image.
+	VTFLIB_STAT_DXT_ENCODE,			//!< Conversions to DXTn, counted once for each image.
+	VTFLIB_STAT_RESIZE,				//!< Image resizing.
+	VTFLIB_STAT_LOAD_FILE,			//!< VTF loads from files.
+	VTFLIB_STAT_LOAD_MEMORY,		//!< VTF loads from memory.
+	VTFLIB_STAT_LOAD_PROC,			//!< VTF loads through the read procs.
+	VTFLIB_STAT_SAVE_FILE,			//!< VTF saves to files.
+	VTFLIB_STAT_SAVE_MEMORY,		//!< VTF saves to memory.
+	VTFLIB_STAT_SAVE_PROC,			//!< VTF saves through the write procs.
+	VTFLIB_STAT_VMT_PARSE,			//!< VMT parsing from any source.
+	VTFLIB_STAT_VMT_LOAD_BINARY,	//!< VMT loads from binary node trees, see CVMTFile::LoadBinary().
+	VTFLIB_STAT_LOAD_PACKAGE,		//!< VTF loads from packages, see CVPKFile.
+	VTFLIB_STAT_LOAD_DDS,			//!< DDS loads, see CVTFFile::LoadDDS().
+	VTFLIB_STAT_SAVE_DDS,			//!< DDS saves, see CVTFFile::SaveDDS().
+	VTFLIB_STAT_COUNT
+} VTFLibStat;
+
+#pragma pack(1)
+
+//! Totals for one operation since the statistics were last reset.
+typedef struct tagSVTFLibStat
+{
+	vlUInt64 uiCalls;				//!< Number of calls.
+	vlUInt64 uiBytes;				//!< Bytes processed: the source image for conversions, the RGBA image for DXT and resizing, the file for loads and saves and the text for VMTs.
+	vlUInt64 uiNanoseconds;			//!< Total wall clock time spent in the calls.
+} SVTFLibStat;
+
+//! Image buffer allocations.
+/*!
+	Counts the memory VTFLib gets from its allocator: image and thumbnail
+	data owned by images and the scratch buffers each thread keeps for
+	conversions and other temporaries.  Scratch buffers reused from a
+	thread's pool are not counted again.  Unlike the operation statistics these are always kept, so
+	the current size stays right when statistics are turned on part way.
+*/
+typedef struct tagSVTFLibAllocationStats
+{
+	vlUInt64 uiAllocations;			//!< Number of buffers allocated since the last reset.
+	vlUInt64 uiBytes;				//!< Bytes currently allocated.
+	vlUInt64 uiPeakBytes;			//!< Most bytes allocated at once since the last reset.
+} SVTFLibAllocationStats;
+
+#pragma pack()
+
+//! Gets the totals for an operation.
+VTFLIB_API vlBool vlGetStats(VTFLibStat Stat, SVTFLibStat *Stats);
+
+//! Gets the totals for conversions from one format to another.
+/*!
+	Only the outermost conversion is counted; conversions VTFLib makes through
+	RGBA8888 internally are part of it and not counted separately.
+*/
+VTFLIB_API vlBool vlGetConvertStats(VTFImageFormat SourceFormat, VTFImageFormat DestFormat, SVTFLibStat *Stats);
+
+//! Gets the image buffer allocation statistics.
+VTFLIB_API vlVoid vlGetAllocationStats(SVTFLibAllocationStats *Stats);
+
+//! Zeroes all statistics, discards captured trace spans and restarts peak memory tracking from the current usage.
+VTFLIB_API vlVoid vlResetStats();
+
+//! Writes the captured trace spans to a file in the Chrome trace event format.
+/*!
+	The file can be opened in chrome://tracing or Perfetto.  At most about a
+	million spans are kept; later spans are dropped and the number dropped is
+	written to the file's metadata.
+*/
+VTFLIB_API vlBool vlWriteTrace(const vlChar *cFileName);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
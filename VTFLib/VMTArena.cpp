@@ -0,0 +1,263 @@
+/*
+ * VTFLib
+ * Copyright (C) 2005-2010 Neil Jedrzejewski & Ryan Gregg
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later
+ * version.
+ */
+
+#include "VMTArena.h"
+
+#include <stddef.h>
+
+using namespace VTFLib::Nodes;
+
+// Rounds a size up to the arena's 8 byte alignment.
+#define VMT_ARENA_ALIGN(size)	(((size) + 7) & ~7u)
+
+static inline vlChar FoldChar(vlChar cChar)
+{
+	return cChar >= 'A' && cChar <= 'Z' ? cChar + ('a' - 'A') : cChar;
+}
+
+CVMTArena::CVMTArena() : lpBlocks(0), lpPosition(0), lpEnd(0), uiNextBlockSize(VMT_ARENA_BLOCK_SIZE), lpKeys(0), uiKeyCount(0), uiKeyTableSize(0)
+{
+
+}
+
+CVMTArena::~CVMTArena()
+{
+	while(this->lpBlocks != 0)
+	{
+		SBlock *lpNext = this->lpBlocks->lpNext;
+		delete []reinterpret_cast<vlByte *>(this->lpBlocks);
+		this->lpBlocks = lpNext;
+	}
+}
+
+//
+// Allocate()
+// Carves uiSize bytes off the current block, starting a new one if they don't
+// fit.  Throws std::bad_alloc if a block can't be allocated.
+//
+vlVoid *CVMTArena::Allocate(vlUInt uiSize)
+{
+	uiSize = VMT_ARENA_ALIGN(uiSize);
+
+	if((vlUInt)(this->lpEnd - this->lpPosition) < uiSize)
+	{
+		this->lpPosition = this->AddBlock(uiSize);
+	}
+
+	vlVoid *lpData = this->lpPosition;
+	this->lpPosition += uiSize;
+
+	return lpData;
+}
+
+vlChar *CVMTArena::AddString(const vlChar *cString)
+{
+	vlUInt uiLength = (vlUInt)strlen(cString);
+
+	vlChar *cCopy = static_cast<vlChar *>(this->Allocate(uiLength + 1));
+	memcpy(cCopy, cString, uiLength + 1);
+
+	return cCopy;
+}
+
+//
+// AddKey()
+// Returns the arena's key for a name, adding it if this is the first node with
+// that name.
+//
+const SVMTKey *CVMTArena::AddKey(const vlChar *cName)
+{
+	vlUInt uiLength;
+	vlUInt uiHash = CVMTArena::Hash(cName, uiLength);
+
+	if((this->uiKeyCount + 1) * 4 > this->uiKeyTableSize * 3)
+	{
+		this->GrowKeyTable();
+	}
+
+	vlUInt uiMask = this->uiKeyTableSize - 1;
+	vlUInt uiSlot = uiHash & uiMask;
+	for(; this->lpKeys[uiSlot] != 0; uiSlot = (uiSlot + 1) & uiMask)
+	{
+		if(CVMTArena::CompareKey(this->lpKeys[uiSlot], cName, uiHash, uiLength))
+		{
+			return this->lpKeys[uiSlot];
+		}
+	}
+
+	SVMTKey *Key = static_cast<SVMTKey *>(this->Allocate(CVMTArena::GetKeySize(uiLength)));
+	CVMTArena::InitializeKey(Key, cName, uiHash, uiLength);
+
+	this->lpKeys[uiSlot] = Key;
+	this->uiKeyCount++;
+
+	return Key;
+}
+
+//
+// FindKey()
+// Returns the arena's key for a name already hashed with Hash(), or null if no
+// node in the arena has that name.
+//
+const SVMTKey *CVMTArena::FindKey(const vlChar *cName, vlUInt uiHash, vlUInt uiLength) const
+{
+	if(this->uiKeyTableSize == 0)
+	{
+		return 0;
+	}
+
+	vlUInt uiMask = this->uiKeyTableSize - 1;
+	for(vlUInt uiSlot = uiHash & uiMask; this->lpKeys[uiSlot] != 0; uiSlot = (uiSlot + 1) & uiMask)
+	{
+		if(CVMTArena::CompareKey(this->lpKeys[uiSlot], cName, uiHash, uiLength))
+		{
+			return this->lpKeys[uiSlot];
+		}
+	}
+
+	return 0;
+}
+
+vlVoid CVMTArena::Reset()
+{
+	if(this->lpBlocks == 0)
+	{
+		return;
+	}
+
+	while(this->lpBlocks->lpNext != 0)
+	{
+		SBlock *lpNext = this->lpBlocks->lpNext;
+		delete []reinterpret_cast<vlByte *>(this->lpBlocks);
+		this->lpBlocks = lpNext;
+	}
+
+	this->lpPosition = reinterpret_cast<vlByte *>(this->lpBlocks) + VMT_ARENA_ALIGN(sizeof(SBlock));
+	this->lpEnd = reinterpret_cast<vlByte *>(this->lpBlocks) + this->lpBlocks->uiSize;
+	this->uiNextBlockSize = this->lpBlocks->uiSize * 2 < VMT_ARENA_BLOCK_MAX ? this->lpBlocks->uiSize * 2 : VMT_ARENA_BLOCK_MAX;
+
+	this->lpKeys = 0;
+	this->uiKeyCount = 0;
+	this->uiKeyTableSize = 0;
+}
+
+//
+// AddBlock()
+// Starts a new block big enough for uiSize bytes and returns where they go.
+// What was left of the previous block is abandoned.
+//
+vlByte *CVMTArena::AddBlock(vlUInt uiSize)
+{
+	vlUInt uiBlockSize = this->uiNextBlockSize;
+	if(uiBlockSize < VMT_ARENA_ALIGN(sizeof(SBlock)) + uiSize)
+	{
+		uiBlockSize = VMT_ARENA_ALIGN(sizeof(SBlock)) + uiSize;
+	}
+
+	SBlock *lpBlock = reinterpret_cast<SBlock *>(new vlByte[uiBlockSize]);
+	lpBlock->uiSize = uiBlockSize;
+
+	// New blocks go on the front, leaving the first at the end for Reset().
+	lpBlock->lpNext = this->lpBlocks;
+	this->lpBlocks = lpBlock;
+
+	if(this->uiNextBlockSize < VMT_ARENA_BLOCK_MAX)
+	{
+		this->uiNextBlockSize *= 2;
+	}
+
+	this->lpEnd = reinterpret_cast<vlByte *>(lpBlock) + uiBlockSize;
+
+	return reinterpret_cast<vlByte *>(lpBlock) + VMT_ARENA_ALIGN(sizeof(SBlock));
+}
+
+//
+// GrowKeyTable()
+// Doubles the key table.  The old table stays in the arena until it is reset.
+//
+vlVoid CVMTArena::GrowKeyTable()
+{
+	vlUInt uiNewSize = this->uiKeyTableSize == 0 ? VMT_ARENA_KEY_TABLE : this->uiKeyTableSize * 2;
+
+	const SVMTKey **lpNewKeys = static_cast<const SVMTKey **>(this->Allocate(uiNewSize * sizeof(SVMTKey *)));
+	memset(lpNewKeys, 0, uiNewSize * sizeof(SVMTKey *));
+
+	vlUInt uiMask = uiNewSize - 1;
+	for(vlUInt i = 0; i < this->uiKeyTableSize; i++)
+	{
+		if(this->lpKeys[i] != 0)
+		{
+			vlUInt uiSlot = this->lpKeys[i]->uiHash & uiMask;
+			while(lpNewKeys[uiSlot] != 0)
+			{
+				uiSlot = (uiSlot + 1) & uiMask;
+			}
+			lpNewKeys[uiSlot] = this->lpKeys[i];
+		}
+	}
+
+	this->lpKeys = lpNewKeys;
+	this->uiKeyTableSize = uiNewSize;
+}
+
+//
+// Hash()
+// FNV-1a hash of a name folded to lower case.
+//
+vlUInt CVMTArena::Hash(const vlChar *cName, vlUInt &uiLength)
+{
+	vlUInt uiHash = 2166136261u;
+
+	const vlChar *lpChar = cName;
+	for(; *lpChar != '\0'; lpChar++)
+	{
+		uiHash = (uiHash ^ (vlByte)FoldChar(*lpChar)) * 16777619u;
+	}
+
+	uiLength = (vlUInt)(lpChar - cName);
+
+	return uiHash;
+}
+
+vlUInt CVMTArena::GetKeySize(vlUInt uiLength)
+{
+	return (vlUInt)offsetof(SVMTKey, cKey) + uiLength + 1;
+}
+
+vlVoid CVMTArena::InitializeKey(SVMTKey *Key, const vlChar *cName, vlUInt uiHash, vlUInt uiLength)
+{
+	Key->uiHash = uiHash;
+	Key->uiLength = uiLength;
+
+	for(vlUInt i = 0; i < uiLength; i++)
+	{
+		Key->cKey[i] = FoldChar(cName[i]);
+	}
+	Key->cKey[uiLength] = '\0';
+}
+
+vlBool CVMTArena::CompareKey(const SVMTKey *Key, const vlChar *cName, vlUInt uiHash, vlUInt uiLength)
+{
+	if(Key->uiHash != uiHash || Key->uiLength != uiLength)
+	{
+		return vlFalse;
+	}
+
+	for(vlUInt i = 0; i < uiLength; i++)
+	{
+		if(Key->cKey[i] != FoldChar(cName[i]))
+		{
+			return vlFalse;
+		}
+	}
+
+	return vlTrue;
+}
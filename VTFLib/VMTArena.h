@@ -0,0 +1,86 @@
+/*
+ * VTFLib
+ * Copyright (C) 2005-2010 Neil Jedrzejewski & Ryan Gregg
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later
+ * version.
+ */
+
+#ifndef VMTARENA_H
+#define VMTARENA_H
+
+#include "stdafx.h"
+
+#define VMT_ARENA_BLOCK_SIZE	(16 * 1024)		// Size of an arena's first block.
+#define VMT_ARENA_BLOCK_MAX		(256 * 1024)	// Later blocks double in size up to this.
+#define VMT_ARENA_KEY_TABLE		32				// Initial size of the key table.
+
+namespace VTFLib
+{
+	namespace Nodes
+	{
+		// A node name folded to lower case, the way stricmp() compares names.
+		struct SVMTKey
+		{
+			vlUInt uiHash;		// Hash of the folded name.
+			vlUInt uiLength;
+			vlChar cKey[1];		// Folded name, null terminated.
+		};
+
+		// Memory for one material's nodes.  Nodes, names, values and child arrays
+		// are carved out of large blocks and freed all at once by Reset() or the
+		// destructor; nothing in an arena is freed on its own.  Names are interned
+		// by their folded form, so nodes whose names match ignoring case share a
+		// key and can be compared by pointer.
+		class VTFLIB_API CVMTArena
+		{
+		private:
+			struct SBlock
+			{
+				SBlock *lpNext;
+				vlUInt uiSize;
+			};
+
+			SBlock *lpBlocks;			// Newest block first, the first block last.
+			vlByte *lpPosition;
+			vlByte *lpEnd;
+			vlUInt uiNextBlockSize;
+
+			const SVMTKey **lpKeys;		// Open addressed table of interned keys.
+			vlUInt uiKeyCount;
+			vlUInt uiKeyTableSize;
+
+		public:
+			CVMTArena();
+			~CVMTArena();
+
+		private:
+			CVMTArena(const CVMTArena &);
+			CVMTArena &operator=(const CVMTArena &);
+
+		public:
+			vlVoid *Allocate(vlUInt uiSize);				// 8 byte aligned.
+			vlChar *AddString(const vlChar *cString);
+
+			const SVMTKey *AddKey(const vlChar *cName);
+			const SVMTKey *FindKey(const vlChar *cName, vlUInt uiHash, vlUInt uiLength) const;
+
+			vlVoid Reset();		// Frees everything, keeping the first block for reuse.
+
+		private:
+			vlByte *AddBlock(vlUInt uiSize);
+			vlVoid GrowKeyTable();
+
+		public:
+			static vlUInt Hash(const vlChar *cName, vlUInt &uiLength);
+			static vlUInt GetKeySize(vlUInt uiLength);
+			static vlVoid InitializeKey(SVMTKey *Key, const vlChar *cName, vlUInt uiHash, vlUInt uiLength);
+			static vlBool CompareKey(const SVMTKey *Key, const vlChar *cName, vlUInt uiHash, vlUInt uiLength);
+		};
+	}
+}
+
+#endif
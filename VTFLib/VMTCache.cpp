@@ -0,0 +1,536 @@
+/*
+ * VTFLib
+ * Copyright (C) 2005-2010 Neil Jedrzejewski & Ryan Gregg
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later
+ * version.
+ */
+
+#include "VTFLib.h"
+#include "VMTCache.h"
+#include "FileMapping.h"
+#include "Writers.h"
+
+#ifndef _WIN32
+#	include <sys/stat.h>
+#	include <unistd.h>
+#endif
+
+#include <atomic>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace VTFLib;
+
+//
+// Cache file layout.  Offsets are from the start of the file.
+//
+// SVMTCacheHeader
+// SVMTCacheEntry[uiEntryCount]	sorted by path
+// vlChar paths[uiPathsSize]	normalized paths, null terminated
+// binary materials				each 8 byte aligned, see CVMTFile::SaveBinary()
+//
+
+#define VMT_CACHE_ALIGN(size)	(((size) + 7) & ~7u)
+
+#pragma pack(1)
+
+struct SVMTCacheHeader
+{
+	vlChar cSignature[4];		// "VMTC"
+	vlUInt uiVersion;
+	vlUInt uiEntryCount;
+	vlUInt uiPathsSize;
+};
+
+struct SVMTCacheEntry
+{
+	vlUInt uiPathOffset;		// From the start of the paths.
+	vlUInt uiDataOffset;
+	vlUInt uiDataSize;
+	vlUInt uiReserved;
+	vlUInt64 uiModified;		// FILETIME of the last write, or the stat() time on POSIX.
+};
+
+#pragma pack()
+
+namespace VTFLib
+{
+	struct SVMTCacheAdded
+	{
+		vlUInt64 uiModified;
+		std::vector<vlByte> Data;
+	};
+
+	class CVMTCacheState
+	{
+	public:
+		CFileMapping Mapping;
+
+		const SVMTCacheEntry *lpEntries;
+		vlUInt uiEntryCount;
+		const vlChar *lpPaths;
+
+		std::map<std::string, SVMTCacheAdded> Added;	// By normalized path.
+
+		mutable std::atomic<vlUInt> uiHits;
+		mutable std::atomic<vlUInt> uiMisses;
+
+	public:
+		CVMTCacheState() : lpEntries(0), uiEntryCount(0), lpPaths(0), uiHits(0), uiMisses(0)
+		{
+
+		}
+
+		~CVMTCacheState()
+		{
+			this->Unmap();
+		}
+
+		vlVoid Unmap()
+		{
+			this->Mapping.Unmap();
+			this->lpEntries = 0;
+			this->uiEntryCount = 0;
+			this->lpPaths = 0;
+		}
+
+		//
+		// Find()
+		// Returns the mapped entry for a normalized path, or null.
+		//
+		const SVMTCacheEntry *Find(const std::string &Path) const
+		{
+			vlUInt uiLow = 0;
+			vlUInt uiHigh = this->uiEntryCount;
+			while(uiLow < uiHigh)
+			{
+				vlUInt uiMiddle = uiLow + (uiHigh - uiLow) / 2;
+
+				vlInt iCompare = strcmp(this->lpPaths + this->lpEntries[uiMiddle].uiPathOffset, Path.c_str());
+				if(iCompare == 0)
+				{
+					return this->lpEntries + uiMiddle;
+				}
+
+				if(iCompare < 0)
+				{
+					uiLow = uiMiddle + 1;
+				}
+				else
+				{
+					uiHigh = uiMiddle;
+				}
+			}
+
+			return 0;
+		}
+	};
+}
+
+//
+// NormalizePath()
+// Folds case and slashes so every spelling of a path finds the same entry.
+//
+static std::string NormalizePath(const vlChar *cPath)
+{
+	std::string Path = cPath;
+	for(std::string::iterator i = Path.begin(); i != Path.end(); ++i)
+	{
+		*i = *i == '/' ? '\\' : (vlChar)tolower((vlByte)*i);
+	}
+
+	return Path;
+}
+
+CVMTCache::CVMTCache() : State(new CVMTCacheState())
+{
+
+}
+
+CVMTCache::~CVMTCache()
+{
+	delete this->State;
+}
+
+vlBool CVMTCache::Open(const vlChar *cFileName)
+{
+	this->Close();
+
+	CVMTCacheState *State = this->State;
+
+	if(!State->Mapping.Map(cFileName))
+	{
+		return vlFalse;
+	}
+
+	vlUInt uiSize = State->Mapping.uiSize;
+	if(uiSize < sizeof(SVMTCacheHeader))
+	{
+		State->Unmap();
+		LastError.Set("Invalid material cache.");
+		return vlFalse;
+	}
+
+	const SVMTCacheHeader *Header = reinterpret_cast<const SVMTCacheHeader *>(State->Mapping.lpData);
+	if(memcmp(Header->cSignature, "VMTC", 4) != 0 || Header->uiVersion != VMT_CACHE_VERSION)
+	{
+		State->Unmap();
+		LastError.Set("Invalid material cache.");
+		return vlFalse;
+	}
+
+	vlUInt64 uiPathsEnd = (vlUInt64)sizeof(SVMTCacheHeader) + (vlUInt64)Header->uiEntryCount * sizeof(SVMTCacheEntry) + Header->uiPathsSize;
+	if(uiPathsEnd > uiSize || (Header->uiEntryCount != 0 && Header->uiPathsSize == 0))
+	{
+		State->Unmap();
+		LastError.Set("Material cache is truncated.");
+		return vlFalse;
+	}
+
+	const SVMTCacheEntry *lpEntries = reinterpret_cast<const SVMTCacheEntry *>(Header + 1);
+	const vlChar *lpPaths = reinterpret_cast<const vlChar *>(lpEntries + Header->uiEntryCount);
+
+	// Paths must end inside the paths and be in order for Find(); materials are
+	// only checked when they are loaded.
+	vlBool bValid = Header->uiPathsSize == 0 || lpPaths[Header->uiPathsSize - 1] == '\0';
+	for(vlUInt i = 0; i < Header->uiEntryCount && bValid; i++)
+	{
+		const SVMTCacheEntry &Entry = lpEntries[i];
+		bValid = Entry.uiPathOffset < Header->uiPathsSize && Entry.uiDataOffset >= uiPathsEnd && (vlUInt64)Entry.uiDataOffset + Entry.uiDataSize <= uiSize
+			&& (i == 0 || strcmp(lpPaths + lpEntries[i - 1].uiPathOffset, lpPaths + Entry.uiPathOffset) < 0);
+	}
+
+	if(!bValid)
+	{
+		State->Unmap();
+		LastError.Set("Material cache is corrupt.");
+		return vlFalse;
+	}
+
+	State->lpEntries = lpEntries;
+	State->uiEntryCount = Header->uiEntryCount;
+	State->lpPaths = lpPaths;
+
+	return vlTrue;
+}
+
+vlVoid CVMTCache::Close()
+{
+	this->State->Unmap();
+	this->State->Added.clear();
+}
+
+vlBool CVMTCache::Save(const vlChar *cFileName)
+{
+	CVMTCacheState *State = this->State;
+
+	// Merge the mapped and added materials by path; added ones win.
+	struct SSaveEntry
+	{
+		const vlChar *cPath;
+		vlUInt64 uiModified;
+		const vlByte *lpData;
+		vlUInt uiDataSize;
+	};
+	std::vector<SSaveEntry> Entries;
+	Entries.reserve(State->uiEntryCount + State->Added.size());
+
+	vlUInt uiMapped = 0;
+	std::map<std::string, SVMTCacheAdded>::const_iterator Added = State->Added.begin();
+	while(uiMapped < State->uiEntryCount || Added != State->Added.end())
+	{
+		const SVMTCacheEntry *Entry = uiMapped < State->uiEntryCount ? State->lpEntries + uiMapped : 0;
+		vlInt iCompare = Entry == 0 ? 1 : Added == State->Added.end() ? -1 : strcmp(State->lpPaths + Entry->uiPathOffset, Added->first.c_str());
+
+		SSaveEntry SaveEntry;
+		if(iCompare < 0)
+		{
+			SaveEntry.cPath = State->lpPaths + Entry->uiPathOffset;
+			SaveEntry.uiModified = Entry->uiModified;
+			SaveEntry.lpData = State->Mapping.lpData + Entry->uiDataOffset;
+			SaveEntry.uiDataSize = Entry->uiDataSize;
+			uiMapped++;
+		}
+		else
+		{
+			SaveEntry.cPath = Added->first.c_str();
+			SaveEntry.uiModified = Added->second.uiModified;
+			SaveEntry.lpData = Added->second.Data.data();
+			SaveEntry.uiDataSize = (vlUInt)Added->second.Data.size();
+			++Added;
+			if(iCompare == 0)
+			{
+				uiMapped++;
+			}
+		}
+		Entries.push_back(SaveEntry);
+	}
+
+	SVMTCacheHeader Header;
+	memcpy(Header.cSignature, "VMTC", 4);
+	Header.uiVersion = VMT_CACHE_VERSION;
+	Header.uiEntryCount = (vlUInt)Entries.size();
+	Header.uiPathsSize = 0;
+
+	std::vector<SVMTCacheEntry> Records(Entries.size());
+	for(vlUInt i = 0; i < (vlUInt)Entries.size(); i++)
+	{
+		Records[i].uiPathOffset = Header.uiPathsSize;
+		Header.uiPathsSize += (vlUInt)strlen(Entries[i].cPath) + 1;
+	}
+
+	vlUInt64 uiOffset = VMT_CACHE_ALIGN(sizeof(SVMTCacheHeader) + Entries.size() * sizeof(SVMTCacheEntry) + Header.uiPathsSize);
+	for(vlUInt i = 0; i < (vlUInt)Entries.size(); i++)
+	{
+		Records[i].uiDataOffset = (vlUInt)uiOffset;
+		Records[i].uiDataSize = Entries[i].uiDataSize;
+		Records[i].uiReserved = 0;
+		Records[i].uiModified = Entries[i].uiModified;
+		uiOffset = VMT_CACHE_ALIGN(uiOffset + Entries[i].uiDataSize);
+	}
+
+	if(uiOffset > 0xffffffff)
+	{
+		LastError.Set("Material cache is too large.");
+		return vlFalse;
+	}
+
+	// Write beside the old cache and swap it in, so an interrupted save never
+	// leaves half a file.
+	std::string Temp = std::string(cFileName) + ".tmp";
+	vlBool bWritten;
+	{
+		IO::Writers::CFileWriter Writer(Temp.c_str());
+		if(!Writer.Open())
+		{
+			return vlFalse;
+		}
+
+		vlByte Padding[8] = { 0 };
+		vlUInt uiWritten = 0;
+
+		bWritten = Writer.Write(&Header, sizeof(Header)) == sizeof(Header);
+		uiWritten += sizeof(Header);
+
+		if(bWritten && !Records.empty())
+		{
+			vlUInt uiRecordsSize = (vlUInt)(Records.size() * sizeof(SVMTCacheEntry));
+			bWritten = Writer.Write(Records.data(), uiRecordsSize) == uiRecordsSize;
+			uiWritten += uiRecordsSize;
+		}
+
+		for(vlUInt i = 0; i < (vlUInt)Entries.size() && bWritten; i++)
+		{
+			vlUInt uiLength = (vlUInt)strlen(Entries[i].cPath) + 1;
+			bWritten = Writer.Write(const_cast<vlChar *>(Entries[i].cPath), uiLength) == uiLength;
+			uiWritten += uiLength;
+		}
+
+		for(vlUInt i = 0; i < (vlUInt)Entries.size() && bWritten; i++)
+		{
+			vlUInt uiPadding = Records[i].uiDataOffset - uiWritten;
+			bWritten = (uiPadding == 0 || Writer.Write(Padding, uiPadding) == uiPadding)
+				&& Writer.Write(const_cast<vlByte *>(Entries[i].lpData), Entries[i].uiDataSize) == Entries[i].uiDataSize;
+			uiWritten = Records[i].uiDataOffset + Entries[i].uiDataSize;
+		}
+
+		if(!Writer.Close())
+		{
+			bWritten = vlFalse;
+		}
+	}
+
+	// A mapped file can't be replaced, so let go of it first.  The added
+	// materials are kept until the new file is in place.
+	State->Unmap();
+
+#ifdef _WIN32
+	if(!bWritten || !MoveFileExA(Temp.c_str(), cFileName, MOVEFILE_REPLACE_EXISTING))
+	{
+		DeleteFileA(Temp.c_str());
+#else
+	if(!bWritten || rename(Temp.c_str(), cFileName) != 0)
+	{
+		unlink(Temp.c_str());
+#endif
+
+		// Try to carry on with what was mapped.
+		std::map<std::string, SVMTCacheAdded> Pending;
+		Pending.swap(State->Added);
+		this->Open(cFileName);
+		Pending.swap(State->Added);
+
+		LastError.SetFormatted("Error writing %s.", cFileName);
+		return vlFalse;
+	}
+
+	State->Added.clear();
+
+	return this->Open(cFileName);
+}
+
+vlUInt CVMTCache::GetMaterialCount() const
+{
+	vlUInt uiCount = this->State->uiEntryCount;
+	for(std::map<std::string, SVMTCacheAdded>::const_iterator i = this->State->Added.begin(); i != this->State->Added.end(); ++i)
+	{
+		if(this->State->Find(i->first) == 0)
+		{
+			uiCount++;
+		}
+	}
+
+	return uiCount;
+}
+
+vlBool CVMTCache::Load(const vlChar *cPath, vlUInt64 uiModified, CVMTFile &File) const
+{
+	std::string Path = NormalizePath(cPath);
+
+	std::map<std::string, SVMTCacheAdded>::const_iterator Added = this->State->Added.find(Path);
+	if(Added != this->State->Added.end())
+	{
+		if(Added->second.uiModified == uiModified && File.LoadBinary(Added->second.Data.data(), (vlUInt)Added->second.Data.size()))
+		{
+			this->State->uiHits++;
+			return vlTrue;
+		}
+	}
+	else
+	{
+		const SVMTCacheEntry *Entry = this->State->Find(Path);
+		if(Entry != 0 && Entry->uiModified == uiModified && File.LoadBinary(this->State->Mapping.lpData + Entry->uiDataOffset, Entry->uiDataSize))
+		{
+			this->State->uiHits++;
+			return vlTrue;
+		}
+	}
+
+	File.Destroy();
+	this->State->uiMisses++;
+
+	return vlFalse;
+}
+
+vlBool CVMTCache::Add(const vlChar *cPath, vlUInt64 uiModified, const CVMTFile &File)
+{
+	vlUInt uiSize;
+	File.SaveBinary(0, 0, uiSize);
+	if(uiSize == 0)
+	{
+		return vlFalse;
+	}
+
+	SVMTCacheAdded &Added = this->State->Added[NormalizePath(cPath)];
+	Added.uiModified = uiModified;
+	Added.Data.resize(uiSize);
+
+	return File.SaveBinary(Added.Data.data(), uiSize, uiSize);
+}
+
+vlBool CVMTCache::Load(const vlChar *cFileName, CVMTFile &File)
+{
+#ifdef _WIN32
+	WIN32_FILE_ATTRIBUTE_DATA Attributes;
+	if(!GetFileAttributesExA(cFileName, GetFileExInfoStandard, &Attributes))
+	{
+		// Let the parser report it.
+		return File.Load(cFileName);
+	}
+
+	vlUInt64 uiModified = ((vlUInt64)Attributes.ftLastWriteTime.dwHighDateTime << 32) | Attributes.ftLastWriteTime.dwLowDateTime;
+#else
+	struct stat Stat;
+	if(stat(cFileName, &Stat) != 0)
+	{
+		// Let the parser report it.
+		return File.Load(cFileName);
+	}
+
+	vlUInt64 uiModified;
+#if defined(_POSIX_C_SOURCE) && _POSIX_C_SOURCE >= 200809L
+	uiModified = (vlUInt64)Stat.st_mtim.tv_sec * 1000000000 + (vlUInt64)Stat.st_mtim.tv_nsec;
+#else
+	uiModified = (vlUInt64)Stat.st_mtime;
+#endif
+#endif
+	if(this->Load(cFileName, uiModified, File))
+	{
+		return vlTrue;
+	}
+
+	if(!File.Load(cFileName))
+	{
+		return vlFalse;
+	}
+
+	this->Add(cFileName, uiModified, File);
+
+	return vlTrue;
+}
+
+vlUInt CVMTCache::GetHitCount() const
+{
+	return this->State->uiHits;
+}
+
+vlUInt CVMTCache::GetMissCount() const
+{
+	return this->State->uiMisses;
+}
+
+//
+// vlCreateMaterialCache()
+// Creates an empty material cache.  Map a cache file with vlMaterialCacheOpen().
+//
+VTFLIB_API vlBool vlCreateMaterialCache(VLMaterialCache **MaterialCache)
+{
+	if(!bInitialized)
+	{
+		LastError.Set("VTFLib not initialized.");
+		return vlFalse;
+	}
+
+	*MaterialCache = reinterpret_cast<VLMaterialCache *>(new CVMTCache());
+
+	return vlTrue;
+}
+
+VTFLIB_API vlVoid vlDeleteMaterialCache(VLMaterialCache *MaterialCache)
+{
+	delete reinterpret_cast<CVMTCache *>(MaterialCache);
+}
+
+static CVMTCache *FromHandle(VLMaterialCache *MaterialCache)
+{
+	if(MaterialCache == 0)
+	{
+		LastError.Set("Invalid material cache.");
+		return 0;
+	}
+
+	return reinterpret_cast<CVMTCache *>(MaterialCache);
+}
+
+VTFLIB_API vlBool vlMaterialCacheOpen(VLMaterialCache *MaterialCache, const vlChar *cFileName)
+{
+	CVMTCache *Instance = FromHandle(MaterialCache);
+	if(Instance == 0)
+		return vlFalse;
+
+	return Instance->Open(cFileName);
+}
+
+VTFLIB_API vlBool vlMaterialCacheSave(VLMaterialCache *MaterialCache, const vlChar *cFileName)
+{
+	CVMTCache *Instance = FromHandle(MaterialCache);
+	if(Instance == 0)
+		return vlFalse;
+
+	return Instance->Save(cFileName);
+}
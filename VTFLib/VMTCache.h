@@ -0,0 +1,97 @@
+/*
+ * VTFLib
+ * Copyright (C) 2005-2010 Neil Jedrzejewski & Ryan Gregg
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later
+ * version.
+ */
+
+// ============================================================
+// NOTE: This file is commented for compatibility with Doxygen.
+// ============================================================
+/*!
+	\file VMTCache.h
+	\brief Parsed materials stored in one file, loaded without parsing.
+*/
+
+#ifndef VMTCACHE_H
+#define VMTCACHE_H
+
+#include "stdafx.h"
+#include "VMTFile.h"
+#include "VMTCacheWrapper.h"
+
+#define VMT_CACHE_VERSION	1	//!< Version of the cache file format.
+
+namespace VTFLib
+{
+	class CVMTCacheState;
+
+	//! Parsed materials kept in one memory mapped file.
+	/*!
+		Each material is stored in the binary form written by
+		CVMTFile::SaveBinary(), keyed by its path and modified time.  Loading a
+		material from the cache builds its nodes straight from the mapped file, so
+		tools that open the same unchanged materials on every run skip parsing.
+
+		Materials added with Add() or loaded through Load(const vlChar *, CVMTFile &)
+		are held in memory until Save() writes them out with the mapped ones.
+		Lookups may run on several threads at once, but Add(), Open(), Close()
+		and Save() must not run alongside anything else.
+	*/
+	class VTFLIB_API CVMTCache
+	{
+	private:
+		CVMTCacheState *State;
+
+	public:
+		CVMTCache();
+		~CVMTCache();
+
+	private:
+		CVMTCache(const CVMTCache &);
+		CVMTCache &operator=(const CVMTCache &);
+
+	public:
+		//! Maps a cache file.
+		/*!
+			\return true on success, otherwise false and the cache is empty.
+		*/
+		vlBool Open(const vlChar *cFileName);
+		vlVoid Close();		//!< Unmaps the file and forgets added materials.
+
+		//! Writes the mapped and added materials.  The file is written beside the old one and swapped in.
+		/*!
+			The cache stays open on the new file.
+
+			\return true on success, otherwise false.
+		*/
+		vlBool Save(const vlChar *cFileName);
+
+		vlUInt GetMaterialCount() const;	//!< Returns the number of materials mapped and added.
+
+	public:
+		//! Loads a material if the cache has it with the same modified time.
+		/*!
+			\return true on a hit, otherwise false and File is empty.
+		*/
+		vlBool Load(const vlChar *cPath, vlUInt64 uiModified, CVMTFile &File) const;
+
+		//! Adds a parsed material, replacing any with the same path.
+		vlBool Add(const vlChar *cPath, vlUInt64 uiModified, const CVMTFile &File);
+
+		//! Loads a material file from the cache if it hasn't changed, otherwise parses it and adds it.
+		/*!
+			\return true if the material was loaded, otherwise false.
+		*/
+		vlBool Load(const vlChar *cFileName, CVMTFile &File);
+
+		vlUInt GetHitCount() const;		//!< Returns the number of loads served from the cache.
+		vlUInt GetMissCount() const;	//!< Returns the number of loads that parsed the file.
+	};
+}
+
+#endif
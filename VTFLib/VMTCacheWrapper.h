@@ -0,0 +1,42 @@
+/*
+ * VTFLib
+ * Copyright (C) 2005-2010 Neil Jedrzejewski & Ryan Gregg
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later
+ * version.
+ */
+
+#ifndef VMTCACHEWRAPPER_H
+#define VMTCACHEWRAPPER_H
+
+#include "stdafx.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//
+// Parsed materials kept in one mapped file, keyed by path and modified time.
+// vlMaterialCacheLoad() loads the bound material from the cache if the file
+// hasn't changed, otherwise parses it and adds it to the cache.  Call
+// vlMaterialCacheSave() to write new materials out for the next run.
+//
+
+typedef struct tagVLMaterialCache VLMaterialCache;
+
+VTFLIB_API vlBool vlCreateMaterialCache(VLMaterialCache **MaterialCache);
+VTFLIB_API vlVoid vlDeleteMaterialCache(VLMaterialCache *MaterialCache);
+
+VTFLIB_API vlBool vlMaterialCacheOpen(VLMaterialCache *MaterialCache, const vlChar *cFileName);
+VTFLIB_API vlBool vlMaterialCacheSave(VLMaterialCache *MaterialCache, const vlChar *cFileName);
+
+VTFLIB_API vlBool vlMaterialCacheLoad(VLMaterialCache *MaterialCache, const vlChar *cFileName);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -11,6 +11,9 @@
 
 #include "VTFLib.h"
 #include "VMTFile.h"
+#include "StatTimer.h"
+#include "Allocator.h"
+#include "VPKFile.h"
 
 using namespace VTFLib;
 using namespace VTFLib::Nodes;
@@ -18,37 +21,95 @@ using namespace VTFLib::Nodes;
 CVMTFile::CVMTFile()
 {
 	this->Root = 0;
+	this->Arena = 0;
+	this->lpOptions = 0;
 }
 
 CVMTFile::CVMTFile(const CVMTFile &VMTFile)
 {
-	if(VMTFile.Root == 0)
+	this->Root = 0;
+	this->Arena = 0;
+	this->lpOptions = 0;
+	this->SetOptions(VMTFile.lpOptions);
+
+	if(VMTFile.Root != 0)
 	{
-		this->Root = 0;
+		this->Root = static_cast<CVMTGroupNode *>(CVMTNode::Copy(VMTFile.Root, this->GetArena()));
 	}
-	else
+}
+
+CVMTFile::~CVMTFile()
+{
+	// The tree lives in the arena, so this frees every node at once.
+	delete this->Arena;
+	delete this->lpOptions;
+}
+
+//
+// GetArena()
+// Gets the material's arena, creating it the first time.
+//
+CVMTArena *CVMTFile::GetArena()
+{
+	if(this->Arena == 0)
 	{
-		this->Root = new CVMTGroupNode(*VMTFile.Root);
+		this->Arena = new CVMTArena();
 	}
+
+	return this->Arena;
 }
 
-CVMTFile::~CVMTFile()
+//
+// GetOptions()
+// Gets the material's own options, null if it uses the process wide options.
+//
+const SVTFLibOptions *CVMTFile::GetOptions() const
 {
-	delete this->Root;
+	return this->lpOptions;
+}
+
+//
+// SetOptions()
+// Gives the material its own copy of the options, or pass null to use the process
+// wide options again.
+//
+vlVoid CVMTFile::SetOptions(const SVTFLibOptions *Options)
+{
+	if(Options == 0)
+	{
+		delete this->lpOptions;
+		this->lpOptions = 0;
+		return;
+	}
+
+	if(this->lpOptions == 0)
+	{
+		this->lpOptions = new SVTFLibOptions;
+	}
+
+	*this->lpOptions = *Options;
 }
 
 vlBool CVMTFile::Create(const vlChar *cRoot)
 {
-	delete this->Root;
-	this->Root = new CVMTGroupNode(cRoot);
+	this->Destroy();
+	this->Root = new(this->GetArena()) CVMTGroupNode(cRoot, this->GetArena());
 
 	return vlTrue;
 }
 
+//
+// Destroy()
+// Frees the node tree by resetting the arena; nodes aren't freed one by one.
+//
 vlVoid CVMTFile::Destroy()
 {
-	delete this->Root;
 	this->Root = 0;
+
+	if(this->Arena != 0)
+	{
+		this->Arena->Reset();
+	}
 }
 
 vlBool CVMTFile::IsLoaded() const
@@ -64,8 +125,16 @@ vlBool CVMTFile::Load(const vlChar *cFileName)
 
 vlBool CVMTFile::Load(const vlVoid *lpData, vlUInt uiBufferSize)
 {
-	auto r = IO::Readers::CMemoryReader(lpData, uiBufferSize);
-	return this->Load(&r);
+	if(lpData == 0)
+	{
+		this->Destroy();
+
+		LastError.Set("Memory stream is null.");
+		return vlFalse;
+	}
+
+	// Parse the caller's buffer in place.
+	return this->Parse(static_cast<const vlChar *>(lpData), uiBufferSize);
 }
 
 vlBool CVMTFile::Load(vlVoid *pUserData)
@@ -74,10 +143,45 @@ vlBool CVMTFile::Load(vlVoid *pUserData)
 	return this->Load(&r);
 }
 
+vlBool CVMTFile::Load(const CVPKFile &Package, const vlChar *cPath)
+{
+	vlUInt uiEntry = Package.FindEntry(cPath);
+
+	const vlVoid *lpPreload, *lpData;
+	vlUInt uiPreloadSize, uiDataSize;
+	if(uiEntry == VPK_INVALID_INDEX || !Package.GetEntryData(uiEntry, lpPreload, uiPreloadSize, lpData, uiDataSize))
+	{
+		this->Destroy();
+
+		if(uiEntry == VPK_INVALID_INDEX)
+		{
+			LastError.SetFormatted("%s is not in the package.", cPath);
+		}
+		return vlFalse;
+	}
+
+	// Materials are usually all preload or all archive; parse those in place.
+	if(uiDataSize == 0 && uiPreloadSize != 0)
+	{
+		return this->Parse(static_cast<const vlChar *>(lpPreload), uiPreloadSize);
+	}
+	else if(uiPreloadSize == 0 && uiDataSize != 0)
+	{
+		return this->Parse(static_cast<const vlChar *>(lpData), uiDataSize);
+	}
+
+	auto r = IO::Readers::CVPKReader(Package, uiEntry);
+	return this->Load(&r);
+}
+
 vlBool CVMTFile::Save(const vlChar *cFileName) const
 {
-	auto r = IO::Writers::CFileWriter(cFileName);
-	return this->Save(&r);
+	// The text goes out a token at a time and write results aren't checked
+	// along the way; Flush() catches any that came up short.
+	IO::Writers::CFileWriter FileWriter(cFileName);
+	IO::Writers::CBufferedWriter Writer(&FileWriter);
+
+	return this->Save(&Writer) && Writer.Flush();
 }
 
 vlBool CVMTFile::Save(vlVoid *lpData, vlUInt uiBufferSize, vlUInt &uiSize) const
@@ -99,447 +203,650 @@ vlBool CVMTFile::Save(vlVoid *pUserData) const
 	return this->Save(&r);
 }
 
-enum EToken
+//
+// Binary node tree layout.  Everything is addressed by offset, so a tree can
+// be copied or mapped anywhere.
+//
+// SVMTBinaryHeader
+// SVMTBinaryNode[uiNodeCount]		every node in document order, the root first;
+//									a group is followed by its uiChildCount children
+// vlChar strings[uiStringsSize]	names and string values, null terminated
+//
+
+#pragma pack(1)
+
+struct SVMTBinaryHeader
 {
-	TOKEN_EOF = 0,			// No more tokens to read.
-	TOKEN_NEWLINE,			// Token is a newline (\n).
-	TOKEN_WHITESPACE,		// Token is any whitespace other than a newline.
-	TOKEN_FORWARD_SLASH,	// Token is a forward slash (/).
-	TOKEN_QUOTE,			// Token is a quote (").
-	TOKEN_OPEN_BRACE,		// Token is an open brace ({).
-	TOKEN_CLOSE_BRACE,		// Token is a close brace (}).
-	TOKEN_CHAR,				// Token is a char (any char).  Use GetChar().
-	TOKEN_STRING,			// Token is a string.  Use GetString().
-	TOKEN_QUOTED_STRING,	
-	TOKEN_SPECIAL			// Token is a specified special char.
+	vlChar cSignature[4];		// "VMTB"
+	vlUInt uiVersion;
+	vlUInt uiNodeCount;
+	vlUInt uiStringsSize;
 };
 
-// Stores token information.
-class CToken
+struct SVMTBinaryNode
 {
-private:
-	EToken eToken;
-	vlChar cChar;
-	vlChar *lpString;
-
-public:
-	// Create a normal token.  cChar was the tokenized char.
-	CToken(EToken eToken, vlChar cChar = '\0') : eToken(eToken), cChar(cChar), lpString(0)
+	vlUInt uiType;				// VMTNodeType
+	vlUInt uiNameOffset;
+	union
 	{
-		assert(eToken != TOKEN_CHAR && eToken != TOKEN_STRING && eToken != TOKEN_QUOTED_STRING);
-	}
+		vlUInt uiChildCount;	// Group.
+		vlUInt uiValueOffset;	// String.
+		vlInt iValue;			// Integer.
+		vlFloat fValue;			// Single.
+	};
+};
 
-	// Create a char token.
-	CToken(vlChar cChar) : eToken(TOKEN_CHAR), cChar(cChar), lpString(0)
-	{
+#pragma pack()
 
-	}
+//
+// MeasureBinary()
+// Counts the nodes and string bytes under a node.
+//
+static vlVoid MeasureBinary(const CVMTNode *Node, vlUInt &uiNodeCount, vlUInt &uiStringsSize)
+{
+	uiNodeCount++;
+	uiStringsSize += (vlUInt)strlen(Node->GetName()) + 1;
 
-	// Create a string token.
-	CToken(vlChar *lpString, vlBool bQuoted) : eToken(bQuoted ? TOKEN_QUOTED_STRING : TOKEN_STRING), cChar('\0'), lpString(0)
+	switch(Node->GetType())
 	{
-		this->lpString = new vlChar[strlen(lpString) + 1];
-		strcpy(this->lpString, lpString);
+	case NODE_TYPE_GROUP:
+		{
+			const CVMTGroupNode *Group = static_cast<const CVMTGroupNode *>(Node);
+			for(vlUInt i = 0; i < Group->GetNodeCount(); i++)
+			{
+				MeasureBinary(Group->GetNode(i), uiNodeCount, uiStringsSize);
+			}
+			break;
+		}
+	case NODE_TYPE_STRING:
+		uiStringsSize += (vlUInt)strlen(static_cast<const CVMTStringNode *>(Node)->GetValue()) + 1;
+		break;
+	default:
+		break;
 	}
+}
 
-	// Copy a token.
-	CToken(const CToken &Token)
-	{
-		this->eToken = Token.eToken;
-		this->cChar = Token.cChar;
-		this->lpString = 0;
+//
+// WriteString()
+// Appends a string to the strings and returns its offset.
+//
+static vlUInt WriteString(vlChar *lpStrings, vlUInt &uiStringsSize, const vlChar *cString)
+{
+	vlUInt uiOffset = uiStringsSize;
+	vlUInt uiLength = (vlUInt)strlen(cString) + 1;
+
+	memcpy(lpStrings + uiOffset, cString, uiLength);
+	uiStringsSize += uiLength;
+
+	return uiOffset;
+}
+
+//
+// WriteBinary()
+// Writes a node and everything under it in document order.
+//
+static vlVoid WriteBinary(const CVMTNode *Node, SVMTBinaryNode *lpNodes, vlUInt &uiNodeCount, vlChar *lpStrings, vlUInt &uiStringsSize)
+{
+	SVMTBinaryNode &BinaryNode = lpNodes[uiNodeCount++];
+
+	BinaryNode.uiType = (vlUInt)Node->GetType();
+	BinaryNode.uiNameOffset = WriteString(lpStrings, uiStringsSize, Node->GetName());
 
-		if(Token.lpString != 0)
+	switch(Node->GetType())
+	{
+	case NODE_TYPE_GROUP:
 		{
-			this->lpString = new vlChar[strlen(Token.lpString) + 1];
-			strcpy(this->lpString, Token.lpString);
+			const CVMTGroupNode *Group = static_cast<const CVMTGroupNode *>(Node);
+
+			BinaryNode.uiChildCount = Group->GetNodeCount();
+			for(vlUInt i = 0; i < Group->GetNodeCount(); i++)
+			{
+				WriteBinary(Group->GetNode(i), lpNodes, uiNodeCount, lpStrings, uiStringsSize);
+			}
+			break;
 		}
+	case NODE_TYPE_STRING:
+		BinaryNode.uiValueOffset = WriteString(lpStrings, uiStringsSize, static_cast<const CVMTStringNode *>(Node)->GetValue());
+		break;
+	case NODE_TYPE_INTEGER:
+		BinaryNode.iValue = static_cast<const CVMTIntegerNode *>(Node)->GetValue();
+		break;
+	case NODE_TYPE_SINGLE:
+		BinaryNode.fValue = static_cast<const CVMTSingleNode *>(Node)->GetValue();
+		break;
+	default:
+		BinaryNode.uiValueOffset = 0;
+		break;
 	}
+}
 
-	~CToken()
+//
+// ReadBinary()
+// Builds the node at uiNode and everything under it, leaving uiNode after
+// them.  Returns null if the table is damaged; the nodes built so far are left
+// in the arena.
+//
+static CVMTNode *ReadBinary(const SVMTBinaryNode *lpNodes, vlUInt uiNodeCount, vlUInt &uiNode, const vlChar *lpStrings, vlUInt uiStringsSize, CVMTArena *Arena)
+{
+	const SVMTBinaryNode &BinaryNode = lpNodes[uiNode++];
+	if(BinaryNode.uiNameOffset >= uiStringsSize)
 	{
-		delete []this->lpString;
+		return 0;
 	}
 
-public:
-	// Convert the current token to a special token.
-	// We need to do this because the tokenizer reads ahead and doen't
-	// know if the requested token will be special until after the fact.
-	vlVoid ToSpecial(const vlChar *lpSpecial)
+	const vlChar *cName = lpStrings + BinaryNode.uiNameOffset;
+
+	switch(BinaryNode.uiType)
 	{
-		if(this->eToken == TOKEN_EOF)
+	case NODE_TYPE_GROUP:
 		{
-			return;
-		}
+			// Every child takes at least one node.
+			if(BinaryNode.uiChildCount > uiNodeCount - uiNode)
+			{
+				return 0;
+			}
 
-		for(vlChar *pSpecial = const_cast<vlChar *>(lpSpecial); *pSpecial != '\0'; pSpecial++)
-		{
-			if(this->cChar == *pSpecial)
+			CVMTGroupNode *Group = new(Arena) CVMTGroupNode(cName, Arena);
+			for(vlUInt i = 0; i < BinaryNode.uiChildCount; i++)
 			{
-				this->eToken = TOKEN_SPECIAL;
-				return;
+				CVMTNode *Node = ReadBinary(lpNodes, uiNodeCount, uiNode, lpStrings, uiStringsSize, Arena);
+				if(Node == 0)
+				{
+					return 0;
+				}
+				Group->AddNode(Node);
 			}
+			return Group;
 		}
+	case NODE_TYPE_STRING:
+		if(BinaryNode.uiValueOffset >= uiStringsSize)
+		{
+			return 0;
+		}
+		return new(Arena) CVMTStringNode(cName, lpStrings + BinaryNode.uiValueOffset, Arena);
+	case NODE_TYPE_INTEGER:
+		return new(Arena) CVMTIntegerNode(cName, BinaryNode.iValue, Arena);
+	case NODE_TYPE_SINGLE:
+		return new(Arena) CVMTSingleNode(cName, BinaryNode.fValue, Arena);
+	default:
+		return 0;
+	}
+}
+
+//
+// LoadBinary()
+// Builds the node tree from a binary tree written by SaveBinary().  The table
+// is checked as it is read, so a damaged tree fails rather than crashing.
+//
+vlBool CVMTFile::LoadBinary(const vlVoid *lpData, vlUInt uiSize)
+{
+	Diagnostics::CStatTimer Timer(VTFLIB_STAT_VMT_LOAD_BINARY, uiSize);
+
+	this->Destroy();
 
-		this->eToken = TOKEN_CHAR;
+	if(lpData == 0)
+	{
+		LastError.Set("Memory stream is null.");
+		return vlFalse;
 	}
 
-	// Get the token that was read.
-	EToken GetToken() const
+	const SVMTBinaryHeader *Header = static_cast<const SVMTBinaryHeader *>(lpData);
+	if(uiSize < sizeof(SVMTBinaryHeader) || memcmp(Header->cSignature, "VMTB", 4) != 0)
 	{
-		return this->eToken;
+		LastError.Set("Invalid binary material.");
+		return vlFalse;
 	}
 
-	// Get the char that was tokenized.  Only works if
-	// token is a TOKEN_CHAR or was tokenized by the byte
-	// tokenizer.
-	const vlChar GetChar() const
+	if(Header->uiVersion != VMT_BINARY_VERSION)
 	{
-		return this->cChar;
+		LastError.SetFormatted("Unsupported binary material version %u.", Header->uiVersion);
+		return vlFalse;
 	}
 
-	// Get the string that was tokenized.  Only works if
-	// token is a TOKEN_STRING.
-	const vlChar *GetString() const
+	vlUInt64 uiExpected = (vlUInt64)sizeof(SVMTBinaryHeader) + (vlUInt64)Header->uiNodeCount * sizeof(SVMTBinaryNode) + Header->uiStringsSize;
+	if(uiExpected > uiSize || Header->uiNodeCount == 0 || Header->uiStringsSize == 0)
 	{
-		return this->lpString;
+		LastError.Set("Binary material is truncated.");
+		return vlFalse;
 	}
-};
 
-// Tokenizes single byte tokens.
-class CByteTokenizer
-{
-private:
-	vlUInt uiLine;
-	IO::Readers::IReader *Reader;
+	const SVMTBinaryNode *lpNodes = reinterpret_cast<const SVMTBinaryNode *>(Header + 1);
+	const vlChar *lpStrings = reinterpret_cast<const vlChar *>(lpNodes + Header->uiNodeCount);
+	vlUInt uiStringsSize = Header->uiStringsSize;
 
-private:
-	CToken *CurrentToken;
-	CToken *NextToken;
+	// With a null at the end of the strings, a string at any offset inside them
+	// ends inside them too.
+	if(lpStrings[uiStringsSize - 1] != '\0' || lpNodes[0].uiType != NODE_TYPE_GROUP)
+	{
+		LastError.Set("Binary material is corrupt.");
+		return vlFalse;
+	}
 
-public:
-	CByteTokenizer(IO::Readers::IReader *Reader) : uiLine(1), Reader(Reader), CurrentToken(0), NextToken(0)
+	// The whole table must be used by the root's tree.
+	vlUInt uiNode = 0;
+	CVMTNode *Root = ReadBinary(lpNodes, Header->uiNodeCount, uiNode, lpStrings, uiStringsSize, this->GetArena());
+	if(Root == 0 || uiNode != Header->uiNodeCount)
 	{
-		this->GetNextToken();
+		this->Destroy();
+
+		LastError.Set("Binary material is corrupt.");
+		return vlFalse;
 	}
 
-	~CByteTokenizer()
+	this->Root = static_cast<CVMTGroupNode *>(Root);
+
+	return vlTrue;
+}
+
+vlBool CVMTFile::SaveBinary(vlVoid *lpData, vlUInt uiBufferSize, vlUInt &uiSize) const
+{
+	uiSize = 0;
+
+	if(this->Root == 0)
 	{
-		delete this->CurrentToken;
-		delete this->NextToken;
+		LastError.Set("No material loaded.");
+		return vlFalse;
 	}
 
-private:
-	vlVoid GetNextToken(const vlChar *lpSpecial = 0)
+	vlUInt uiNodeCount = 0;
+	vlUInt uiStringsSize = 0;
+	MeasureBinary(this->Root, uiNodeCount, uiStringsSize);
+
+	uiSize = (vlUInt)sizeof(SVMTBinaryHeader) + uiNodeCount * (vlUInt)sizeof(SVMTBinaryNode) + uiStringsSize;
+
+	if(lpData == 0 || uiBufferSize < uiSize)
 	{
-		vlChar cChar;
+		LastError.SetFormatted("Buffer too small, %u bytes needed.", uiSize);
+		return vlFalse;
+	}
 
-		if(!Reader->Read(cChar))
-		{
-			this->NextToken = new CToken(TOKEN_EOF);
-			return;
-		}
+	SVMTBinaryHeader *Header = static_cast<SVMTBinaryHeader *>(lpData);
+	memcpy(Header->cSignature, "VMTB", 4);
+	Header->uiVersion = VMT_BINARY_VERSION;
+	Header->uiNodeCount = uiNodeCount;
+	Header->uiStringsSize = uiStringsSize;
 
-		// Keep track of the line number.
-		if(cChar == '\n')
-		{
-			this->uiLine++;
-		}
+	SVMTBinaryNode *lpNodes = reinterpret_cast<SVMTBinaryNode *>(Header + 1);
+	vlChar *lpStrings = reinterpret_cast<vlChar *>(lpNodes + uiNodeCount);
 
-		// If a special char was specified, only return TOKEN_CHAR tokens
-		// unless the special char was found in which case return a
-		// TOKEN_SPECIAL.
-		if(lpSpecial)
-		{
-			for(vlChar *pSpecial = const_cast<vlChar *>(lpSpecial); *pSpecial != '\0'; pSpecial++)
-			{
-				if(cChar == *pSpecial)
-				{
-					this->NextToken = new CToken(TOKEN_SPECIAL, cChar);
-					return;
-				}
-			}
+	uiNodeCount = 0;
+	uiStringsSize = 0;
+	WriteBinary(this->Root, lpNodes, uiNodeCount, lpStrings, uiStringsSize);
 
-			this->NextToken = new CToken(cChar);
-			return;
-		}
-		
-		if(cChar == '\r' || cChar == '\n')
-		{
-			this->NextToken = new CToken(TOKEN_NEWLINE, cChar);
-		}
-		else if(isspace(cChar))
-		{
-			this->NextToken = new CToken(TOKEN_WHITESPACE, cChar);
-		}
-		else if(cChar == '/')
-		{
-			this->NextToken = new CToken(TOKEN_FORWARD_SLASH, cChar);
-		}
-		else if(cChar == '\"')
-		{
-			this->NextToken = new CToken(TOKEN_QUOTE, cChar);
-		}
-		else if(cChar == '{')
-		{
-			this->NextToken = new CToken(TOKEN_OPEN_BRACE, cChar);
-		}
-		else if(cChar == '}')
-		{
-			this->NextToken = new CToken(TOKEN_CLOSE_BRACE, cChar);
-		}
-		else
+	return vlTrue;
+}
+
+// Size of the first read when a stream doesn't know its size.
+#define VMT_READ_SIZE		(64 * 1024)
+
+enum EToken
+{
+	TOKEN_EOF = 0,			// No more tokens to read.
+	TOKEN_NEWLINE,			// One or more newlines (\r or \n) or comments, and any whitespace between them.
+	TOKEN_OPEN_BRACE,		// Token is an open brace ({).
+	TOKEN_CLOSE_BRACE,		// Token is a close brace (}).
+	TOKEN_STRING,			// Token is an unquoted string.
+	TOKEN_QUOTED_STRING		// Token is a quoted string, without the quotes.
+};
+
+// A token points into the text being parsed, so reading one doesn't copy or
+// allocate anything.  Strings are not null terminated.
+struct SToken
+{
+	EToken eToken;
+	const vlChar *lpString;
+	vlUInt uiLength;
+};
+
+enum ECharClass
+{
+	CHAR_STRING = 0,		// Part of an unquoted string.
+	CHAR_WHITESPACE,		// Whitespace other than a newline.
+	CHAR_NEWLINE,			// \r or \n.
+	CHAR_SPECIAL			// Starts a token of its own: / " { }
+};
+
+//
+// GetCharClasses()
+// Gets the class of every byte.  Only ASCII whitespace counts, other bytes
+// (including UTF-8) are part of strings.
+//
+static const vlByte *GetCharClasses()
+{
+	struct SCharClasses
+	{
+		vlByte uiClasses[256];
+
+		SCharClasses()
 		{
-			this->NextToken = new CToken(cChar);
+			memset(this->uiClasses, CHAR_STRING, sizeof(this->uiClasses));
+
+			this->uiClasses[(vlByte)' '] = CHAR_WHITESPACE;
+			this->uiClasses[(vlByte)'\t'] = CHAR_WHITESPACE;
+			this->uiClasses[(vlByte)'\v'] = CHAR_WHITESPACE;
+			this->uiClasses[(vlByte)'\f'] = CHAR_WHITESPACE;
+			this->uiClasses[(vlByte)'\r'] = CHAR_NEWLINE;
+			this->uiClasses[(vlByte)'\n'] = CHAR_NEWLINE;
+			this->uiClasses[(vlByte)'/'] = CHAR_SPECIAL;
+			this->uiClasses[(vlByte)'\"'] = CHAR_SPECIAL;
+			this->uiClasses[(vlByte)'{'] = CHAR_SPECIAL;
+			this->uiClasses[(vlByte)'}'] = CHAR_SPECIAL;
 		}
+	};
+
+	static const SCharClasses Classes;
+
+	return Classes.uiClasses;
+}
+
+// Growable string in scratch memory, so parsing doesn't allocate per token
+// and strings aren't limited to a fixed buffer.
+class CStringBuffer
+{
+private:
+	Memory::CScratchBuffer Buffer;
+	vlUInt uiLength;
+
+public:
+	CStringBuffer() : uiLength(0)
+	{
+
 	}
 
+private:
+	CStringBuffer(const CStringBuffer &);
+	CStringBuffer &operator=(const CStringBuffer &);
+
 public:
-	// Get the current token and return the next one.
-	CToken *Next(const vlChar *lpSpecial = 0)
+	vlVoid Clear()
 	{
-		delete this->CurrentToken;
-		this->CurrentToken = this->NextToken;
-		this->NextToken = 0;
+		this->uiLength = 0;
+		this->Buffer.Grow(1)[0] = '\0';
+	}
 
-		if(lpSpecial && this->CurrentToken)
-		{
-			this->CurrentToken->ToSpecial(lpSpecial);
-		}
+	vlVoid Append(vlChar cChar)
+	{
+		vlChar *lpString = reinterpret_cast<vlChar *>(this->Buffer.Grow((vlUInt64)this->uiLength + 2));
+		lpString[this->uiLength++] = cChar;
+		lpString[this->uiLength] = '\0';
+	}
 
-		this->GetNextToken();
+	vlVoid Append(const vlChar *lpString, vlUInt uiStringLength)
+	{
+		vlChar *lpDest = reinterpret_cast<vlChar *>(this->Buffer.Grow((vlUInt64)this->uiLength + uiStringLength + 1));
+		memcpy(lpDest + this->uiLength, lpString, uiStringLength);
+		this->uiLength += uiStringLength;
+		lpDest[this->uiLength] = '\0';
+	}
 
-		return this->CurrentToken;
+	vlVoid Set(const SToken &Token)
+	{
+		this->Clear();
+		this->Append(Token.lpString, Token.uiLength);
 	}
 
-	// Get the curret token.
-	CToken *Peek()
+	const vlChar *Get() const
 	{
-		return this->NextToken;
+		return reinterpret_cast<const vlChar *>(this->Buffer.Get());
 	}
 
-	// Get the current line.
-	vlUInt GetLine()
+	vlUInt GetLength() const
 	{
-		return this->uiLine;
+		return this->uiLength;
 	}
 };
 
-// Tokenizes multi byte tokens.
-class CTokenizer
+// Splits text in memory into tokens, one token ahead of the parser.  Comments
+// and whitespace are dropped and runs of newlines become one token, as the
+// parser treats them all the same.
+class CLexer
 {
 private:
-	CByteTokenizer *ByteTokenizer;
+	const vlByte *lpClasses;
 
-private:
-	CToken *CurrentToken;
-	CToken *NextToken;
+	const vlChar *lpStart;
+	const vlChar *lpEnd;
+	const vlChar *lpPosition;	// Where the next token will be read from.
+	const vlChar *lpError;		// Where the lexer found an error, if it did.
+
+	SToken CurrentToken;
+	SToken NextToken;
 
 public:
-	CTokenizer(CByteTokenizer *ByteTokenizer) : ByteTokenizer(ByteTokenizer), CurrentToken(0), NextToken(0)
+	CLexer(const vlChar *lpText, vlUInt uiTextSize) : lpClasses(GetCharClasses()), lpStart(lpText), lpEnd(lpText + uiTextSize), lpPosition(lpText), lpError(0)
 	{
-		this->GetNextToken();
+		this->CurrentToken.eToken = TOKEN_EOF;
+		this->CurrentToken.lpString = lpText;
+		this->CurrentToken.uiLength = 0;
+		this->NextToken = this->CurrentToken;
 	}
 
-	~CTokenizer()
+private:
+	CLexer(const CLexer &);
+	CLexer &operator=(const CLexer &);
+
+	vlByte GetClass(vlChar cChar) const
 	{
-		delete this->CurrentToken;
-		delete this->NextToken;
+		return this->lpClasses[(vlByte)cChar];
 	}
 
-public:
-	vlVoid GetNextToken()
+	vlVoid Read(SToken &Token)
 	{
-		CToken *Token;
-		
-		Token = this->ByteTokenizer->Next();
-
-		// Consume all whitespace.
-		while(Token->GetToken() == TOKEN_WHITESPACE)
-		{
-			Token = this->ByteTokenizer->Next();
-		}
-
-		vlUInt uiIndex = 0;
-		vlChar cBuffer[4096];
+		const vlChar *lpChar = this->lpPosition;
+		vlBool bNewline = vlFalse;
 
-		switch(Token->GetToken())
+		// Skip whitespace, newlines and comments.
+		while(lpChar != this->lpEnd)
 		{
-		// Comment (these are removed for the parser).
-		case TOKEN_FORWARD_SLASH:
-			Token = this->ByteTokenizer->Next();
-
-			if(Token->GetToken() != TOKEN_FORWARD_SLASH)
+			vlByte uiClass = this->GetClass(*lpChar);
+			if(uiClass == CHAR_WHITESPACE)
 			{
-				throw "expected comment string";
+				lpChar++;
 			}
-
-			do
+			else if(uiClass == CHAR_NEWLINE)
 			{
-				Token = this->ByteTokenizer->Next("\n");
-			} while(Token->GetToken() == TOKEN_CHAR);
-
-			if(Token->GetToken() == TOKEN_EOF)
+				bNewline = vlTrue;
+				lpChar++;
+			}
+			else if(*lpChar == '/')
 			{
-				this->NextToken = new CToken(TOKEN_EOF);
+				if(lpChar + 1 == this->lpEnd || lpChar[1] != '/')
+				{
+					// Let the parser see the newline before the error.
+					if(bNewline)
+					{
+						break;
+					}
+
+					this->lpError = lpChar;
+					throw "expected comment string";
+				}
+
+				// A comment runs to the next \n, or the end of the file which is no newline.
+				const vlChar *lpLineEnd = static_cast<const vlChar *>(memchr(lpChar + 2, '\n', this->lpEnd - lpChar - 2));
+				if(lpLineEnd == 0)
+				{
+					lpChar = this->lpEnd;
+				}
+				else
+				{
+					bNewline = vlTrue;
+					lpChar = lpLineEnd + 1;
+				}
 			}
 			else
 			{
-				this->NextToken = new CToken(TOKEN_NEWLINE);
+				break;
 			}
-			break;
-		// Quoted string.
-		case TOKEN_QUOTE:
-			while(true)
-			{
-				Token = this->ByteTokenizer->Next("\"");
+		}
 
-				if(Token->GetToken() != TOKEN_CHAR)
-				{
-					break;
-				}
+		Token.lpString = lpChar;
+		Token.uiLength = 0;
 
-				if(Token->GetChar() == '\r' || Token->GetChar() == '\n')
+		if(bNewline)
+		{
+			Token.eToken = TOKEN_NEWLINE;
+		}
+		else if(lpChar == this->lpEnd)
+		{
+			Token.eToken = TOKEN_EOF;
+		}
+		else if(*lpChar == '{')
+		{
+			Token.eToken = TOKEN_OPEN_BRACE;
+			lpChar++;
+		}
+		else if(*lpChar == '}')
+		{
+			Token.eToken = TOKEN_CLOSE_BRACE;
+			lpChar++;
+		}
+		else if(*lpChar == '\"')
+		{
+			const vlChar *lpString = ++lpChar;
+			while(lpChar != this->lpEnd && *lpChar != '\"')
+			{
+				if(*lpChar == '\r' || *lpChar == '\n')
 				{
+					this->lpError = lpChar;
 					throw "newline in string";
 				}
-
-				cBuffer[uiIndex++] = Token->GetChar();
+				lpChar++;
 			}
-			cBuffer[uiIndex++] = '\0';
 
-			if(Token->GetToken() != TOKEN_SPECIAL)
+			if(lpChar == this->lpEnd)
 			{
+				this->lpError = lpChar;
 				throw "expected closing quote";
 			}
-			else
-			{
-				this->NextToken = new CToken(cBuffer, vlTrue);
-			}
-			break;
-		// Unquoted string.
-		case TOKEN_CHAR:
-			cBuffer[uiIndex++] = Token->GetChar();
 
-			while(this->ByteTokenizer->Peek()->GetToken() == TOKEN_CHAR)
+			Token.eToken = TOKEN_QUOTED_STRING;
+			Token.lpString = lpString;
+			Token.uiLength = (vlUInt)(lpChar - lpString);
+			lpChar++;
+		}
+		else
+		{
+			while(lpChar != this->lpEnd && this->GetClass(*lpChar) == CHAR_STRING)
 			{
-				Token = this->ByteTokenizer->Next();
-
-				cBuffer[uiIndex++] = Token->GetChar();
+				lpChar++;
 			}
-			cBuffer[uiIndex++] = '\0';
-
-			assert(uiIndex <= 4096);
 
-			this->NextToken = new CToken(cBuffer, vlFalse);
-			break;
-		// Let these byte tokens "pass through".
-		case TOKEN_EOF:
-		case TOKEN_NEWLINE:
-		case TOKEN_OPEN_BRACE:
-		case TOKEN_CLOSE_BRACE:
-			this->NextToken = new CToken(*Token);
-			break;
-		// The parser doesn't care about anything else.
-		default:
-			throw "unexpected token";
-			break;
+			Token.eToken = TOKEN_STRING;
+			Token.uiLength = (vlUInt)(lpChar - Token.lpString);
 		}
+
+		this->lpPosition = lpChar;
+	}
+
+public:
+	// Read the first token.  Can throw, so it isn't done by the constructor.
+	vlVoid Start()
+	{
+		this->Read(this->NextToken);
 	}
 
-	CToken *Next()
+	// Get the next token.  The token is only valid until the next call.
+	const SToken &Next()
 	{
-		delete this->CurrentToken;
 		this->CurrentToken = this->NextToken;
-		this->NextToken = 0;
 
-		this->GetNextToken();
+		this->Read(this->NextToken);
 
 		return this->CurrentToken;
 	}
 
-	CToken *Peek()
+	// Get the token after the current one.
+	const SToken &Peek() const
 	{
 		return this->NextToken;
 	}
 
-	vlUInt GetLine()
+	// Get the line of the error or the current token, counted only when it is
+	// needed for an error.
+	vlUInt GetLine() const
 	{
-		return this->ByteTokenizer->GetLine();
+		const vlChar *lpLineEnd = this->lpError != 0 ? this->lpError : this->CurrentToken.lpString;
+
+		vlUInt uiLine = 1;
+		for(const vlChar *lpChar = this->lpStart; lpChar != lpLineEnd; lpChar++)
+		{
+			if(*lpChar == '\n')
+			{
+				uiLine++;
+			}
+		}
+		return uiLine;
 	}
 };
 
-// Uses multi byte tokenizer to process the file.
+// Builds the node tree from the lexer's tokens.
 class CParser
 {
 private:
-	CTokenizer *Tokenizer;
+	CLexer *Lexer;
+	vlUInt uiParseMode;
+	CVMTArena *Arena;	// Where the tree is built.
+
+	// Attribute name and value being read, reused for every pair.
+	CStringBuffer Name;
+	CStringBuffer Value;
 
 public:
-	CParser(CTokenizer *Tokenizer) : Tokenizer(Tokenizer)
+	CParser(CLexer *Lexer, vlUInt uiParseMode, CVMTArena *Arena) : Lexer(Lexer), uiParseMode(uiParseMode), Arena(Arena)
 	{
 
 	}
 
+private:
+	CParser(const CParser &);
+	CParser &operator=(const CParser &);
+
 public:
 	CVMTGroupNode *Parse()
 	{
-		CToken *Token;
-		CVMTGroupNode *Group = 0;
+		this->Lexer->Start();
 
 		// Consume all newlines.
-		Token = this->Tokenizer->Next();
-		while(Token->GetToken() == TOKEN_NEWLINE)
+		SToken Token = this->Lexer->Next();
+		while(Token.eToken == TOKEN_NEWLINE)
 		{
-			Token = this->Tokenizer->Next();
+			Token = this->Lexer->Next();
 		}
 
-		if(Token->GetToken() == TOKEN_STRING || Token->GetToken() == TOKEN_QUOTED_STRING)
-		{
-			Group = new CVMTGroupNode(Token->GetString());
-		}
-		else
+		if(Token.eToken != TOKEN_STRING && Token.eToken != TOKEN_QUOTED_STRING)
 		{
 			throw "expected shader name";
 		}
 
+		this->Name.Set(Token);
+
+		// If parsing fails the caller resets the arena, freeing what was built.
+		CVMTGroupNode *Group = new(this->Arena) CVMTGroupNode(this->Name.Get(), this->Arena);
+
 		// We *may* have a group, parse it.
 		this->Parse(Group);
 
-		if(uiVMTParseMode == PARSE_MODE_LOOSE)
+		if(this->uiParseMode == PARSE_MODE_LOOSE)
 		{
 			while(vlTrue)
 			{
 				// Consume all newlines.
-				while(this->Tokenizer->Peek()->GetToken() == TOKEN_NEWLINE)
+				while(this->Lexer->Peek().eToken == TOKEN_NEWLINE)
 				{
-					Token = this->Tokenizer->Next();
+					this->Lexer->Next();
 				}
 
-				CToken *Peek = this->Tokenizer->Peek();
+				EToken ePeek = this->Lexer->Peek().eToken;
 
-				if(Peek->GetToken() == TOKEN_EOF)
+				if(ePeek == TOKEN_EOF)
 				{
 					break;
 				}
-				else if(Peek->GetToken() == TOKEN_OPEN_BRACE)
+				else if(ePeek == TOKEN_OPEN_BRACE)
 				{
-					CVMTGroupNode *NextGroup = 0;
-					try
-					{
-						NextGroup = new CVMTGroupNode("");
-						this->Parse(NextGroup);
-					}
-					catch(char *cErrorMessage)
-					{
-						delete NextGroup;
-						throw cErrorMessage;
-					}
-					for(vlUInt i = 0; i < NextGroup->GetNodeCount(); i++)
-					{
-						Group->AddNode(NextGroup->GetNode(i)->Clone());
-					}
-					delete NextGroup;
+					// Groups that follow the first are merged into it.
+					this->Parse(Group);
 				}
 				else
 				{
@@ -550,13 +857,13 @@ public:
 		else
 		{
 			// Consume all newlines.
-			Token = this->Tokenizer->Next();
-			while(Token->GetToken() == TOKEN_NEWLINE)
+			Token = this->Lexer->Next();
+			while(Token.eToken == TOKEN_NEWLINE)
 			{
-				Token = this->Tokenizer->Next();
+				Token = this->Lexer->Next();
 			}
 
-			if(Token->GetToken() != TOKEN_EOF)
+			if(Token.eToken != TOKEN_EOF)
 			{
 				throw "expected end of file";
 			}
@@ -569,17 +876,15 @@ private:
 	// Prase a group starting at the first brace and ending at the last.
 	vlVoid Parse(CVMTGroupNode *Group)
 	{
-		CToken *Token;
-
 		// Consume all newlines.
-		Token = this->Tokenizer->Next();
-		while(Token->GetToken() == TOKEN_NEWLINE)
+		SToken Token = this->Lexer->Next();
+		while(Token.eToken == TOKEN_NEWLINE)
 		{
-			Token = this->Tokenizer->Next();
+			Token = this->Lexer->Next();
 		}
 
 		// The first token better be an open brace.
-		if(Token->GetToken() != TOKEN_OPEN_BRACE)
+		if(Token.eToken != TOKEN_OPEN_BRACE)
 		{
 			throw "expected open brace";
 		}
@@ -588,88 +893,87 @@ private:
 		while(true)
 		{
 			// Consume all newlines.
-			Token = this->Tokenizer->Next();
-			while(Token->GetToken() == TOKEN_NEWLINE)
+			Token = this->Lexer->Next();
+			while(Token.eToken == TOKEN_NEWLINE)
 			{
-				Token = this->Tokenizer->Next();
+				Token = this->Lexer->Next();
 			}
 
 			// If we have an end brace, we found the end of the group.
-			if(Token->GetToken() == TOKEN_CLOSE_BRACE || (uiVMTParseMode == PARSE_MODE_LOOSE && Token->GetToken() == TOKEN_EOF))
+			if(Token.eToken == TOKEN_CLOSE_BRACE || (this->uiParseMode == PARSE_MODE_LOOSE && Token.eToken == TOKEN_EOF))
 			{
 				return;
 			}
 
 			// If we have a string we could have a pair or nested group.
-			if(Token->GetToken() == TOKEN_STRING || Token->GetToken() == TOKEN_QUOTED_STRING)
+			if(Token.eToken == TOKEN_STRING || Token.eToken == TOKEN_QUOTED_STRING)
 			{
-				CToken *Peek = this->Tokenizer->Peek();
-				if(Peek->GetToken() == TOKEN_STRING || Peek->GetToken() == TOKEN_QUOTED_STRING)
+				const SToken &Peek = this->Lexer->Peek();
+				if(Peek.eToken == TOKEN_STRING || Peek.eToken == TOKEN_QUOTED_STRING)
 				{
 					// We have a pair.
+					this->Name.Set(Token);
 
-					if (Peek->GetToken() == TOKEN_QUOTED_STRING)
+					if(Peek.eToken == TOKEN_QUOTED_STRING)
 					{
-						Group->AddStringNode(Token->GetString(), Peek->GetString());
+						this->Value.Set(Peek);
+						Group->AddStringNode(this->Name.Get(), this->Value.Get());
 
-						Token = this->Tokenizer->Next();
+						Token = this->Lexer->Next();
 					}
 					else
 					{
-						vlChar *cName = new vlChar[strlen(Token->GetString()) + 1];
-						strcpy(cName, Token->GetString());
-
 						// Some materials contain properties such as '"$envmaptint" .1 .1 .1', we need to read
 						// the .1's as strings and concat them (way to be consistent Valve).
-						vlChar cBuffer[4096] = "";
-						while(this->Tokenizer->Peek()->GetToken() == TOKEN_STRING)
+						this->Value.Clear();
+						while(this->Lexer->Peek().eToken == TOKEN_STRING)
 						{
-							Token = this->Tokenizer->Next();
+							Token = this->Lexer->Next();
 
-							if(*cBuffer)
+							if(this->Value.GetLength() != 0)
 							{
-								strcat(cBuffer, " ");
+								this->Value.Append(' ');
 							}
-							strcat(cBuffer, Token->GetString());
+							this->Value.Append(Token.lpString, Token.uiLength);
 						}
 
 						vlInt iTest;
 						vlSingle sTest;
-						vlChar cTest[4096];
+						vlChar cTest[2];
 
-						if(sscanf(cBuffer, "%d%s", &iTest, cTest) == 1)
+						// Only whether anything follows the number matters, so read at most one char of it.
+						if(sscanf(this->Value.Get(), "%d%1s", &iTest, cTest) == 1)
 						{
 							// We can interpet the string as an integer, assume it is one.
-							Group->AddIntegerNode(cName, iTest);
+							Group->AddIntegerNode(this->Name.Get(), iTest);
 						}
-						else if(sscanf(cBuffer, "%f%s", &sTest, cTest) == 1)
+						else if(sscanf(this->Value.Get(), "%f%1s", &sTest, cTest) == 1)
 						{
 							// We can interpet the string as an single, assume it is one.
-							Group->AddSingleNode(cName, sTest);
+							Group->AddSingleNode(this->Name.Get(), sTest);
 						}
 						else
 						{
 							// The string must be a string...
-							Group->AddStringNode(cName, cBuffer);
+							Group->AddStringNode(this->Name.Get(), this->Value.Get());
 						}
-
-						delete []cName;
 					}
 
-					vlBool bNeedNewline = Token->GetToken() != TOKEN_QUOTED_STRING;
+					vlBool bNeedNewline = Token.eToken != TOKEN_QUOTED_STRING;
 					if(bNeedNewline)
 					{
-						Token = this->Tokenizer->Next();
-						if(Token->GetToken() != TOKEN_NEWLINE)
+						Token = this->Lexer->Next();
+						if(Token.eToken != TOKEN_NEWLINE)
 						{
 							throw "expected newline";
 						}
 					}
 				}
-				else if(Peek->GetToken() == TOKEN_NEWLINE || Peek->GetToken() == TOKEN_OPEN_BRACE)
+				else if(Peek.eToken == TOKEN_NEWLINE || Peek.eToken == TOKEN_OPEN_BRACE)
 				{
 					// We have a nested group, parse it.
-					this->Parse(Group->AddGroupNode(Token->GetString()));
+					this->Name.Set(Token);
+					this->Parse(Group->AddGroupNode(this->Name.Get()));
 				}
 				else
 				{
@@ -686,31 +990,82 @@ private:
 
 //
 // Load()
-// Parses a .vmt file.  Note, the parser is very loose.  .vmt files vary
-// so much in the official resources that it is hard to know what is legal.
+// Reads a whole .vmt stream into memory, with one read if the stream knows
+// its size, and parses it.
 //
 vlBool CVMTFile::Load(IO::Readers::IReader *Reader)
 {
-	delete this->Root;
-	this->Root = 0;
+	this->Destroy();
 
 	if(!Reader->Open())
 		return vlFalse;
 
-	CByteTokenizer ByteTokenizer = CByteTokenizer(Reader);
-	CTokenizer Tokenizer = CTokenizer(&ByteTokenizer);
-	CParser Parser = CParser(&Tokenizer);
+	// Procs may not know the size, then read until the stream runs out.
+	vlUInt uiStreamSize = Reader->GetStreamSize();
+	vlUInt uiCapacity = uiStreamSize != 0 && uiStreamSize != 0xffffffff ? uiStreamSize : VMT_READ_SIZE;
+	vlUInt uiSize = 0;
+
+	Memory::CScratchBuffer Buffer;
+	while(vlTrue)
+	{
+		vlByte *lpData = Buffer.Grow(uiCapacity);
+
+		vlUInt uiRead = Reader->Read(lpData + uiSize, uiCapacity - uiSize);
+		uiSize += uiRead;
+
+		if(uiRead == 0 || uiSize == uiStreamSize)
+		{
+			break;
+		}
+
+		if(uiSize == uiCapacity)
+		{
+			uiCapacity *= 2;
+		}
+	}
+
+	Reader->Close();
+
+	return this->Parse(reinterpret_cast<const vlChar *>(Buffer.Get()), uiSize);
+}
+
+//
+// Parse()
+// Parses a .vmt file in memory.  Note, the parser is very loose.  .vmt files
+// vary so much in the official resources that it is hard to know what is legal.
+//
+vlBool CVMTFile::Parse(const vlChar *lpText, vlUInt uiTextSize)
+{
+	Diagnostics::CStatTimer Timer(VTFLIB_STAT_VMT_PARSE, uiTextSize);
+
+	this->Destroy();
+
+	vlUInt uiParseMode;
+	if(this->lpOptions != 0)
+	{
+		uiParseMode = this->lpOptions->uiVMTParseMode;
+	}
+	else
+	{
+		SVTFLibOptions Options;
+		VTFLib::GetOptions(Options);
+		uiParseMode = Options.uiVMTParseMode;
+	}
+
+	CLexer Lexer(lpText, uiTextSize);
+	CParser Parser(&Lexer, uiParseMode, this->GetArena());
 
 	try
 	{
 		this->Root = Parser.Parse();
 	}
-	catch(char *cErrorMessage)
+	catch(const vlChar *cErrorMessage)
 	{
-		LastError.SetFormatted("Error parsing material on line %u (%s).", Tokenizer.GetLine(), cErrorMessage);
-	}
+		// Drop the partly built tree.
+		this->Destroy();
 
-	Reader->Close();
+		LastError.SetFormatted("Error parsing material on line %u (%s).", Lexer.GetLine(), cErrorMessage);
+	}
 
 	return this->Root != 0;
 }
@@ -949,9 +1304,7 @@ vlBool CVMTFile::Save(IO::Writers::IWriter *Writer) const
 
 	this->Save(Writer, this->Root);
 
-	Writer->Close();
-
-	return vlTrue;
+	return Writer->Close();
 }
 
 //
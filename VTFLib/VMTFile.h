@@ -16,6 +16,9 @@
 #include "Readers.h"
 #include "Writers.h"
 #include "VMTNodes.h"
+#include "Options.h"
+
+#define VMT_BINARY_VERSION	1	// Version of the binary node tree written by SaveBinary().
 
 #ifdef __cplusplus
 extern "C" {
@@ -39,6 +42,8 @@ namespace VTFLib
 	{
 	private:
 		Nodes::CVMTGroupNode *Root;
+		Nodes::CVMTArena *Arena;		// Holds the whole node tree, null until first needed.
+		SVTFLibOptions *lpOptions;	// Material options, null to use the process wide options.
 
 	public:
 		CVMTFile();
@@ -54,15 +59,27 @@ namespace VTFLib
 		vlBool Load(const vlChar *cFileName);
 		vlBool Load(const vlVoid *lpData, vlUInt uiBufferSize);
 		vlBool Load(vlVoid *pUserData);
+		vlBool Load(const CVPKFile &Package, const vlChar *cPath);	// Parses in place from the package when the file is in one piece.
 
 		vlBool Save(const vlChar *cFileName) const;
 		vlBool Save(vlVoid *lpData, vlUInt uiBufferSize, vlUInt &uiSize) const;
 		vlBool Save(vlVoid *pUserData) const;
 
+		// Binary form of the node tree, see VMTFile.cpp for the layout.  Loading
+		// one builds the nodes straight from their table without parsing text.
+		vlBool LoadBinary(const vlVoid *lpData, vlUInt uiSize);
+
+		// Writes the binary form if it fits in uiBufferSize.  uiSize is always set
+		// to the size it needs, so pass a null buffer to measure.
+		vlBool SaveBinary(vlVoid *lpData, vlUInt uiBufferSize, vlUInt &uiSize) const;
+
 	private:
 		vlBool Load(IO::Readers::IReader *Reader);
+		vlBool Parse(const vlChar *lpText, vlUInt uiTextSize);
 		vlBool Save(IO::Writers::IWriter *Writer) const;
 
+		Nodes::CVMTArena *GetArena();
+
 		//Nodes::CVMTNode *Load(IO::Readers::IReader *Reader, vlBool bInGroup);
 
 		vlVoid Indent(IO::Writers::IWriter *Writer, vlUInt uiLevel) const;
@@ -70,6 +87,9 @@ namespace VTFLib
 
 	public:
 		Nodes::CVMTGroupNode *GetRoot() const;
+
+		const SVTFLibOptions *GetOptions() const;
+		vlVoid SetOptions(const SVTFLibOptions *Options);
 	};
 }
 
@@ -13,28 +13,38 @@
 
 using namespace VTFLib::Nodes;
 
-CVMTGroupNode::CVMTGroupNode(const vlChar *cName) : CVMTNode(cName)
+// Interned keys are equal only if they are the same key; heap nodes each have their own.
+static inline vlBool IsSameKey(const SVMTKey *Key1, const SVMTKey *Key2)
 {
-	this->VMTNodeList = new CVMTNodeList();
+	return Key1 == Key2 || (Key1->uiHash == Key2->uiHash && Key1->uiLength == Key2->uiLength && strcmp(Key1->cKey, Key2->cKey) == 0);
 }
 
-#pragma warning( disable : 26495 )
-CVMTGroupNode::CVMTGroupNode(const CVMTGroupNode &GroupNode) : CVMTNode(GroupNode.GetName())
+CVMTGroupNode::CVMTGroupNode(const vlChar *cName, CVMTArena *Arena) : CVMTNode(cName, Arena), lpNodes(0), uiNodeCount(0), uiNodeCapacity(0), lpIndex(0), uiIndexSize(0)
 {
-	for(CVMTNodeList::const_iterator it = GroupNode.VMTNodeList->begin(); it != GroupNode.VMTNodeList->end(); ++it)
+
+}
+
+CVMTGroupNode::CVMTGroupNode(const CVMTGroupNode &GroupNode) : CVMTNode(GroupNode.GetName()), lpNodes(0), uiNodeCount(0), uiNodeCapacity(0), lpIndex(0), uiIndexSize(0)
+{
+	for(vlUInt i = 0; i < GroupNode.uiNodeCount; i++)
 	{
-		this->AddNode((*it)->Clone());
+		this->AddNode(GroupNode.lpNodes[i]->Clone());
 	}
 }
 
 CVMTGroupNode::~CVMTGroupNode()
 {
-	for(CVMTNodeList::const_iterator it = this->VMTNodeList->begin(); it != this->VMTNodeList->end(); ++it)
+	// Arena children and arrays are freed with the arena.
+	if(this->GetArena() == 0)
 	{
-		delete *it;
-	}
+		for(vlUInt i = 0; i < this->uiNodeCount; i++)
+		{
+			delete this->lpNodes[i];
+		}
 
-	delete this->VMTNodeList;
+		this->Free(this->lpNodes);
+		this->Free(this->lpIndex);
+	}
 }
 
 VMTNodeType CVMTGroupNode::GetType() const
@@ -44,22 +54,54 @@ VMTNodeType CVMTGroupNode::GetType() const
 
 vlUInt CVMTGroupNode::GetNodeCount() const
 {
-	return (vlUInt)this->VMTNodeList->size();
+	return this->uiNodeCount;
 }
 
 CVMTNode *CVMTGroupNode::AddNode(CVMTNode *VMTNode)
 {
+	// Children must live where the group does so they are freed with it.
+	if(VMTNode->Arena != this->GetArena())
+	{
+		CVMTNode *Copy = CVMTNode::Copy(VMTNode, this->GetArena());
+		delete VMTNode;
+		VMTNode = Copy;
+	}
+
+	if(this->uiNodeCount == this->uiNodeCapacity)
+	{
+		vlUInt uiNewCapacity = this->uiNodeCapacity == 0 ? 4 : this->uiNodeCapacity * 2;
+
+		CVMTNode **lpNewNodes = static_cast<CVMTNode **>(this->Allocate(uiNewCapacity * sizeof(CVMTNode *)));
+		if(this->uiNodeCount != 0)
+		{
+			memcpy(lpNewNodes, this->lpNodes, this->uiNodeCount * sizeof(CVMTNode *));
+		}
+		this->Free(this->lpNodes);
+
+		this->lpNodes = lpNewNodes;
+		this->uiNodeCapacity = uiNewCapacity;
+	}
+
 	// We can do this because we are friends.
 	VMTNode->Parent = this;
 
-	this->VMTNodeList->push_back(VMTNode);
+	this->lpNodes[this->uiNodeCount++] = VMTNode;
+
+	if(this->lpIndex != 0 && this->uiNodeCount * 2 <= this->uiIndexSize)
+	{
+		this->InsertIndex(this->uiNodeCount - 1);
+	}
+	else if(this->uiNodeCount > VMT_GROUP_INDEX_THRESHOLD)
+	{
+		this->BuildIndex();
+	}
 
 	return VMTNode;
 }
 
 CVMTGroupNode *CVMTGroupNode::AddGroupNode(const vlChar *cName)
 {
-	CVMTGroupNode *Group = new CVMTGroupNode(cName);
+	CVMTGroupNode *Group = new(this->GetArena()) CVMTGroupNode(cName, this->GetArena());
 	
 	this->AddNode(Group);
 
@@ -68,7 +110,7 @@ CVMTGroupNode *CVMTGroupNode::AddGroupNode(const vlChar *cName)
 
 CVMTStringNode *CVMTGroupNode::AddStringNode(const vlChar *cName, const vlChar *cValue)
 {
-	CVMTStringNode *String = new CVMTStringNode(cName, cValue);
+	CVMTStringNode *String = new(this->GetArena()) CVMTStringNode(cName, cValue, this->GetArena());
 	
 	this->AddNode(String);
 
@@ -77,7 +119,7 @@ CVMTStringNode *CVMTGroupNode::AddStringNode(const vlChar *cName, const vlChar *
 
 CVMTIntegerNode *CVMTGroupNode::AddIntegerNode(const vlChar *cName, vlInt iValue)
 {
-	CVMTIntegerNode *Integer = new CVMTIntegerNode(cName, iValue);
+	CVMTIntegerNode *Integer = new(this->GetArena()) CVMTIntegerNode(cName, iValue, this->GetArena());
 	
 	this->AddNode(Integer);
 
@@ -86,7 +128,7 @@ CVMTIntegerNode *CVMTGroupNode::AddIntegerNode(const vlChar *cName, vlInt iValue
 
 CVMTSingleNode *CVMTGroupNode::AddSingleNode(const vlChar *cName, vlFloat fValue)
 {
-	CVMTSingleNode *Single = new CVMTSingleNode(cName, fValue);
+	CVMTSingleNode *Single = new(this->GetArena()) CVMTSingleNode(cName, fValue, this->GetArena());
 	
 	this->AddNode(Single);
 
@@ -95,50 +137,90 @@ CVMTSingleNode *CVMTGroupNode::AddSingleNode(const vlChar *cName, vlFloat fValue
 
 vlVoid CVMTGroupNode::RemoveNode(CVMTNode *VMTNode)
 {
-	for(CVMTNodeList::const_iterator it = this->VMTNodeList->begin(); it != this->VMTNodeList->end(); ++it)
+	// The index only holds the first child with each name, so scan.  Removal
+	// moves the later children down anyway.
+	vlUInt uiNode = this->uiNodeCount;
+	for(vlUInt i = 0; i < this->uiNodeCount; i++)
 	{
-		if(*it == VMTNode)
+		if(this->lpNodes[i] == VMTNode)
 		{
-			delete *it;
-			this->VMTNodeList->remove(*it);
-
-			return;
+			uiNode = i;
+			break;
 		}
 	}
+
+	if(uiNode == this->uiNodeCount)
+	{
+		return;
+	}
+
+	memmove(this->lpNodes + uiNode, this->lpNodes + uiNode + 1, (this->uiNodeCount - uiNode - 1) * sizeof(CVMTNode *));
+	this->uiNodeCount--;
+
+	// Later children moved down, so their index entries are stale.
+	this->BuildIndex();
+
+	delete VMTNode;
 }
 
 vlVoid CVMTGroupNode::RemoveAllNodes()
 {
-	for(CVMTNodeList::const_iterator it = this->VMTNodeList->begin(); it != this->VMTNodeList->end(); ++it)
+	for(vlUInt i = 0; i < this->uiNodeCount; i++)
 	{
-		delete *it;
+		delete this->lpNodes[i];
 	}
 
-	this->VMTNodeList->clear();
+	this->uiNodeCount = 0;
+	this->BuildIndex();
 }
 
 CVMTNode *CVMTGroupNode::GetNode(vlUInt uiIndex) const
 {
-	vlUInt uiCount = 0;
-	for(CVMTNodeList::const_iterator it = this->VMTNodeList->begin(); it != this->VMTNodeList->end(); ++it)
+	return uiIndex < this->uiNodeCount ? this->lpNodes[uiIndex] : 0;
+}
+
+//
+// GetNode()
+// Finds the first child with a name, ignoring case.  Small groups are
+// scanned, larger ones go through the index; in an arena a name no node
+// has is rejected by the key table without touching the group.
+//
+CVMTNode *CVMTGroupNode::GetNode(const vlChar *cName) const
+{
+	if(this->lpIndex == 0)
 	{
-		if(uiCount == uiIndex)
+		for(vlUInt i = 0; i < this->uiNodeCount; i++)
 		{
-			return *it;
+			if(stricmp(cName, this->lpNodes[i]->GetName()) == 0)
+			{
+				return this->lpNodes[i];
+			}
 		}
-		uiCount++;
+
+		return 0;
 	}
 
-	return 0;
-}
+	vlUInt uiLength;
+	vlUInt uiHash = CVMTArena::Hash(cName, uiLength);
 
-CVMTNode *CVMTGroupNode::GetNode(const vlChar *cName) const
-{
-	for(CVMTNodeList::const_iterator it = this->VMTNodeList->begin(); it != this->VMTNodeList->end(); ++it)
+	// Arena keys are interned, so a match is the same key.
+	const SVMTKey *Key = 0;
+	if(this->GetArena() != 0)
+	{
+		Key = this->GetArena()->FindKey(cName, uiHash, uiLength);
+		if(Key == 0)
+		{
+			return 0;
+		}
+	}
+
+	vlUInt uiMask = this->uiIndexSize - 1;
+	for(vlUInt uiSlot = uiHash & uiMask; this->lpIndex[uiSlot] != 0; uiSlot = (uiSlot + 1) & uiMask)
 	{
-		if(stricmp(cName, (*it)->GetName()) == 0)
+		CVMTNode *Node = this->lpNodes[this->lpIndex[uiSlot] - 1];
+		if(Key != 0 ? Node->Key == Key : CVMTArena::CompareKey(Node->Key, cName, uiHash, uiLength))
 		{
-			return *it;
+			return Node;
 		}
 	}
 
@@ -148,4 +230,65 @@ CVMTNode *CVMTGroupNode::GetNode(const vlChar *cName) const
 CVMTNode *CVMTGroupNode::Clone() const
 {
 	return new CVMTGroupNode(*this);
-}
\ No newline at end of file
+}
+
+//
+// BuildIndex()
+// Rebuilds the index from the children.  Small groups have none.
+//
+vlVoid CVMTGroupNode::BuildIndex()
+{
+	if(this->uiNodeCount <= VMT_GROUP_INDEX_THRESHOLD)
+	{
+		this->Free(this->lpIndex);
+		this->lpIndex = 0;
+		this->uiIndexSize = 0;
+		return;
+	}
+
+	// Keep the table at most half full.
+	vlUInt uiSize = VMT_GROUP_INDEX_THRESHOLD * 4;
+	while(uiSize < this->uiNodeCount * 2)
+	{
+		uiSize *= 2;
+	}
+
+	if(uiSize != this->uiIndexSize)
+	{
+		vlUInt *lpNewIndex = static_cast<vlUInt *>(this->Allocate(uiSize * sizeof(vlUInt)));
+		this->Free(this->lpIndex);
+
+		this->lpIndex = lpNewIndex;
+		this->uiIndexSize = uiSize;
+	}
+
+	memset(this->lpIndex, 0, this->uiIndexSize * sizeof(vlUInt));
+
+	for(vlUInt i = 0; i < this->uiNodeCount; i++)
+	{
+		this->InsertIndex(i);
+	}
+}
+
+//
+// InsertIndex()
+// Indexes a child unless an earlier child has the same name, so lookups find
+// the first and repeated names (common in generated materials) don't build
+// long probe chains.
+//
+vlVoid CVMTGroupNode::InsertIndex(vlUInt uiNode)
+{
+	vlUInt uiMask = this->uiIndexSize - 1;
+	const SVMTKey *Key = this->lpNodes[uiNode]->Key;
+
+	vlUInt uiSlot = Key->uiHash & uiMask;
+	for(; this->lpIndex[uiSlot] != 0; uiSlot = (uiSlot + 1) & uiMask)
+	{
+		if(IsSameKey(this->lpNodes[this->lpIndex[uiSlot] - 1]->Key, Key))
+		{
+			return;
+		}
+	}
+
+	this->lpIndex[uiSlot] = uiNode + 1;
+}
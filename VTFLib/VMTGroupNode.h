@@ -19,7 +19,7 @@
 #include "VMTIntegerNode.h"
 #include "VMTSingleNode.h"
 
-#include <list>
+#define VMT_GROUP_INDEX_THRESHOLD	8	// Groups with more children than this get a hash index.
 
 namespace VTFLib
 {
@@ -33,13 +33,20 @@ namespace VTFLib
 		//	friend class CVMTFile;	// For direct node addition.
 
 		private:
-			typedef std::list<CVMTNode *> CVMTNodeList;
+			friend class CVMTNode;	// For reindexing renamed children.
 
 		private:
-			CVMTNodeList *VMTNodeList;
+			// Children in order, from the group's arena or the heap.
+			CVMTNode **lpNodes;
+			vlUInt uiNodeCount;
+			vlUInt uiNodeCapacity;
+
+			// Open addressed table of child index + 1 by key, null for small groups.
+			vlUInt *lpIndex;
+			vlUInt uiIndexSize;
 
 		public:
-			CVMTGroupNode(const vlChar *cName);
+			CVMTGroupNode(const vlChar *cName, CVMTArena *Arena = 0);
 			CVMTGroupNode(const CVMTGroupNode &GroupNode);
 			virtual ~CVMTGroupNode();
 
@@ -49,6 +56,9 @@ namespace VTFLib
 		public:
 			vlUInt GetNodeCount() const;
 
+			// Adds a node.  A node from another arena (or the heap, for an arena
+			// group) is copied into this group's and the original deleted, so use
+			// the returned node rather than the one passed in.
 			CVMTNode *AddNode(CVMTNode *VMTNode);
 			CVMTGroupNode *AddGroupNode(const vlChar *cName);
 			CVMTStringNode *AddStringNode(const vlChar *cName, const vlChar *cValue);
@@ -59,7 +69,11 @@ namespace VTFLib
 			vlVoid RemoveAllNodes();
 
 			CVMTNode *GetNode(vlUInt uiIndex) const;
-			CVMTNode *GetNode(const vlChar *cName) const;		
+			CVMTNode *GetNode(const vlChar *cName) const;
+
+		private:
+			vlVoid BuildIndex();
+			vlVoid InsertIndex(vlUInt uiNode);
 		};
 	}
 }
@@ -19,12 +19,12 @@ CVMTIntegerNode::CVMTIntegerNode(const vlChar *cName) : CVMTValueNode(cName)
 }
 
 #pragma warning( disable : 26495 )
-CVMTIntegerNode::CVMTIntegerNode(const vlChar *cName, const vlChar *cValue) : CVMTValueNode(cName)
+CVMTIntegerNode::CVMTIntegerNode(const vlChar *cName, const vlChar *cValue, CVMTArena *Arena) : CVMTValueNode(cName, Arena)
 {
 	this->SetValue(cValue);
 }
 
-CVMTIntegerNode::CVMTIntegerNode(const vlChar *cName, vlInt iValue) : CVMTValueNode(cName)
+CVMTIntegerNode::CVMTIntegerNode(const vlChar *cName, vlInt iValue, CVMTArena *Arena) : CVMTValueNode(cName, Arena)
 {
 	this->iValue = iValue;
 }
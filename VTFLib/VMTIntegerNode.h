@@ -26,8 +26,8 @@ namespace VTFLib
 
 		public:
 			CVMTIntegerNode(const vlChar *cName);
-			CVMTIntegerNode(const vlChar *cName, const vlChar *cValue);
-			CVMTIntegerNode(const vlChar *cName, vlInt iValue);
+			CVMTIntegerNode(const vlChar *cName, const vlChar *cValue, CVMTArena *Arena = 0);
+			CVMTIntegerNode(const vlChar *cName, vlInt iValue, CVMTArena *Arena = 0);
 			CVMTIntegerNode(const CVMTIntegerNode &IntegerNode);
 			virtual ~CVMTIntegerNode();
 
@@ -10,27 +10,46 @@
  */
 
 #include "VMTNode.h"
+#include "VMTGroupNode.h"
 
 using namespace VTFLib::Nodes;
 
-CVMTNode::CVMTNode(const vlChar *cName)
-{
-	this->cName = new vlChar[strlen(cName) + 1];
-	strcpy(this->cName, cName);
+// Every node is preceded by the arena it was allocated from, null for the
+// heap, so operator delete knows whether to free it.
+#define VMT_NODE_HEADER_SIZE	16
 
-	this->Parent = 0;
+CVMTNode::CVMTNode(const vlChar *cName, CVMTArena *Arena) : cName(0), Key(0), Parent(0), Arena(Arena)
+{
+	this->SetKey(cName);
 }
 
 CVMTNode::~CVMTNode()
 {
-	delete []this->cName;
+	if(this->cName != this->Key->cKey)
+	{
+		this->Free(const_cast<vlChar *>(this->cName));
+	}
+	this->Free(const_cast<SVMTKey *>(this->Key));
 }
 
 vlVoid CVMTNode::SetName(const vlChar *cName)
 {
-	delete []this->cName;
-	this->cName = new vlChar[strlen(cName) + 1];
-	strcpy(this->cName, cName);
+	const vlChar *cOldName = this->cName;
+	const SVMTKey *OldKey = this->Key;
+
+	this->SetKey(cName);
+
+	if(cOldName != OldKey->cKey)
+	{
+		this->Free(const_cast<vlChar *>(cOldName));
+	}
+	this->Free(const_cast<SVMTKey *>(OldKey));
+
+	// The parent's index is keyed on our name.
+	if(this->Parent != 0)
+	{
+		this->Parent->BuildIndex();
+	}
 }
 
 const vlChar *CVMTNode::GetName() const
@@ -41,4 +60,138 @@ const vlChar *CVMTNode::GetName() const
 CVMTGroupNode *CVMTNode::GetParent()
 {
 	return this->Parent;
-}
\ No newline at end of file
+}
+
+CVMTArena *CVMTNode::GetArena() const
+{
+	return this->Arena;
+}
+
+const SVMTKey *CVMTNode::GetKey() const
+{
+	return this->Key;
+}
+
+vlVoid *CVMTNode::operator new(size_t uiSize)
+{
+	vlByte *lpData = new vlByte[VMT_NODE_HEADER_SIZE + uiSize];
+	*reinterpret_cast<CVMTArena **>(lpData) = 0;
+
+	return lpData + VMT_NODE_HEADER_SIZE;
+}
+
+vlVoid *CVMTNode::operator new(size_t uiSize, CVMTArena *Arena)
+{
+	if(Arena == 0)
+	{
+		return CVMTNode::operator new(uiSize);
+	}
+
+	vlByte *lpData = static_cast<vlByte *>(Arena->Allocate((vlUInt)(VMT_NODE_HEADER_SIZE + uiSize)));
+	*reinterpret_cast<CVMTArena **>(lpData) = Arena;
+
+	return lpData + VMT_NODE_HEADER_SIZE;
+}
+
+vlVoid CVMTNode::operator delete(vlVoid *lpNode)
+{
+	if(lpNode == 0)
+	{
+		return;
+	}
+
+	// Arena nodes are freed with their arena.
+	vlByte *lpData = static_cast<vlByte *>(lpNode) - VMT_NODE_HEADER_SIZE;
+	if(*reinterpret_cast<CVMTArena **>(lpData) == 0)
+	{
+		delete []lpData;
+	}
+}
+
+vlVoid CVMTNode::operator delete(vlVoid *lpNode, CVMTArena *Arena)
+{
+	CVMTNode::operator delete(lpNode);
+}
+
+//
+// Copy()
+// Deep copies a node into an arena, or onto the heap if Arena is null.
+//
+CVMTNode *CVMTNode::Copy(const CVMTNode *Node, CVMTArena *Arena)
+{
+	switch(Node->GetType())
+	{
+	case NODE_TYPE_GROUP:
+		{
+			const CVMTGroupNode *Group = static_cast<const CVMTGroupNode *>(Node);
+
+			CVMTGroupNode *GroupCopy = new(Arena) CVMTGroupNode(Node->cName, Arena);
+			for(vlUInt i = 0; i < Group->GetNodeCount(); i++)
+			{
+				GroupCopy->AddNode(CVMTNode::Copy(Group->GetNode(i), Arena));
+			}
+			return GroupCopy;
+		}
+	case NODE_TYPE_STRING:
+		return new(Arena) CVMTStringNode(Node->cName, static_cast<const CVMTStringNode *>(Node)->GetValue(), Arena);
+	case NODE_TYPE_INTEGER:
+		return new(Arena) CVMTIntegerNode(Node->cName, static_cast<const CVMTIntegerNode *>(Node)->GetValue(), Arena);
+	case NODE_TYPE_SINGLE:
+		return new(Arena) CVMTSingleNode(Node->cName, static_cast<const CVMTSingleNode *>(Node)->GetValue(), Arena);
+	default:
+		return Node->Clone();
+	}
+}
+
+vlVoid *CVMTNode::Allocate(vlUInt uiSize) const
+{
+	if(this->Arena != 0)
+	{
+		return this->Arena->Allocate(uiSize);
+	}
+
+	return new vlByte[uiSize];
+}
+
+vlVoid CVMTNode::Free(vlVoid *lpData) const
+{
+	if(this->Arena == 0)
+	{
+		delete []static_cast<vlByte *>(lpData);
+	}
+}
+
+vlChar *CVMTNode::CopyString(const vlChar *cString) const
+{
+	vlUInt uiSize = (vlUInt)strlen(cString) + 1;
+
+	vlChar *cCopy = static_cast<vlChar *>(this->Allocate(uiSize));
+	memcpy(cCopy, cString, uiSize);
+
+	return cCopy;
+}
+
+//
+// SetKey()
+// Sets the node's name and its folded key.  Arena nodes share the interned key,
+// and its text too if the name is already lower case, as most are.
+//
+vlVoid CVMTNode::SetKey(const vlChar *cName)
+{
+	if(this->Arena != 0)
+	{
+		this->Key = this->Arena->AddKey(cName);
+		this->cName = strcmp(this->Key->cKey, cName) == 0 ? this->Key->cKey : this->Arena->AddString(cName);
+	}
+	else
+	{
+		vlUInt uiLength;
+		vlUInt uiHash = CVMTArena::Hash(cName, uiLength);
+
+		SVMTKey *NewKey = static_cast<SVMTKey *>(this->Allocate(CVMTArena::GetKeySize(uiLength)));
+		CVMTArena::InitializeKey(NewKey, cName, uiHash, uiLength);
+
+		this->Key = NewKey;
+		this->cName = this->CopyString(cName);
+	}
+}
@@ -13,6 +13,7 @@
 #define VMTNODE_H
 
 #include "stdafx.h"
+#include "VMTArena.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -38,26 +39,53 @@ namespace VTFLib
 	{
 		class CVMTGroupNode;
 
+		// Nodes live either on the heap or in a material's arena.  new(Arena)
+		// puts a node in an arena (or on the heap if Arena is null) and it should
+		// be given the same arena, which then also holds its name, value and
+		// children.  Deleting an arena node runs its destructor but frees nothing;
+		// the memory goes when the arena is reset.
 		class VTFLIB_API CVMTNode
 		{
 		private:
 			friend class CVMTGroupNode;	// For direct parent setting.
 
 		private:
-			vlChar *cName;
+			const vlChar *cName;
+			const SVMTKey *Key;
 			CVMTGroupNode *Parent;
+			CVMTArena *Arena;
 
 		public:
-			CVMTNode(const vlChar *cName);
+			CVMTNode(const vlChar *cName, CVMTArena *Arena = 0);
 			virtual ~CVMTNode();
 
 			const vlChar *GetName() const;
 			vlVoid SetName(const vlChar *cName);
 
 			CVMTGroupNode *GetParent();
+			CVMTArena *GetArena() const;	// Null for heap nodes.
+			const SVMTKey *GetKey() const;
 
 			virtual VMTNodeType GetType() const = 0;
 			virtual CVMTNode *Clone() const = 0;
+
+		public:
+			static vlVoid *operator new(size_t uiSize);
+			static vlVoid *operator new(size_t uiSize, CVMTArena *Arena);
+			static vlVoid operator delete(vlVoid *lpNode);
+			static vlVoid operator delete(vlVoid *lpNode, CVMTArena *Arena);
+
+			// Deep copies a node into an arena, or onto the heap if Arena is null.
+			static CVMTNode *Copy(const CVMTNode *Node, CVMTArena *Arena);
+
+		protected:
+			// Memory for the node's own data, from its arena or the heap.
+			vlVoid *Allocate(vlUInt uiSize) const;
+			vlVoid Free(vlVoid *lpData) const;
+			vlChar *CopyString(const vlChar *cString) const;
+
+		private:
+			vlVoid SetKey(const vlChar *cName);
 		};
 	}
 }
@@ -19,12 +19,12 @@ CVMTSingleNode::CVMTSingleNode(const vlChar *cName) : CVMTValueNode(cName)
 }
 
 #pragma warning( disable : 26495 )
-CVMTSingleNode::CVMTSingleNode(const vlChar *cName, const vlChar *cValue) : CVMTValueNode(cName)
+CVMTSingleNode::CVMTSingleNode(const vlChar *cName, const vlChar *cValue, CVMTArena *Arena) : CVMTValueNode(cName, Arena)
 {
 	this->SetValue(cValue);
 }
 
-CVMTSingleNode::CVMTSingleNode(const vlChar *cName, vlFloat fValue) : CVMTValueNode(cName)
+CVMTSingleNode::CVMTSingleNode(const vlChar *cName, vlFloat fValue, CVMTArena *Arena) : CVMTValueNode(cName, Arena)
 {
 	this->fValue = fValue;
 }
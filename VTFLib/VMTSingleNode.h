@@ -26,8 +26,8 @@ namespace VTFLib
 
 		public:
 			CVMTSingleNode(const vlChar *cName);
-			CVMTSingleNode(const vlChar *cName, const vlChar *cValue);
-			CVMTSingleNode(const vlChar *cName, vlFloat fValue);
+			CVMTSingleNode(const vlChar *cName, const vlChar *cValue, CVMTArena *Arena = 0);
+			CVMTSingleNode(const vlChar *cName, vlFloat fValue, CVMTArena *Arena = 0);
 			CVMTSingleNode(const CVMTSingleNode &SingleNode);
 			virtual ~CVMTSingleNode();
 
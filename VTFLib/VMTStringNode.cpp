@@ -15,32 +15,29 @@ using namespace VTFLib::Nodes;
 
 CVMTStringNode::CVMTStringNode(const vlChar *cName) : CVMTValueNode(cName)
 {
-	this->cValue = new vlChar[1];
-	*this->cValue = '\0';
+	this->cValue = this->CopyString("");
 }
 
-CVMTStringNode::CVMTStringNode(const vlChar *cName, const vlChar *cValue) : CVMTValueNode(cName)
+CVMTStringNode::CVMTStringNode(const vlChar *cName, const vlChar *cValue, CVMTArena *Arena) : CVMTValueNode(cName, Arena)
 {
-	this->cValue = new vlChar[strlen(cValue) + 1];
-	strcpy(this->cValue, cValue);
+	this->cValue = this->CopyString(cValue);
 }
 
 CVMTStringNode::CVMTStringNode(const CVMTStringNode &StringNode) : CVMTValueNode(StringNode.GetName())
 {
-	this->cValue = new vlChar[strlen(StringNode.cValue) + 1];
-	strcpy(this->cValue, StringNode.cValue);
+	this->cValue = this->CopyString(StringNode.cValue);
 }
 
 CVMTStringNode::~CVMTStringNode()
 {
-	delete this->cValue;
+	this->Free(this->cValue);
 }
 
 vlVoid CVMTStringNode::SetValue(const vlChar *cValue)
 {
-	delete this->cValue;
-	this->cValue = new vlChar[strlen(cValue) + 1];
-	strcpy(this->cValue, cValue);
+	vlChar *cOldValue = this->cValue;
+	this->cValue = this->CopyString(cValue);
+	this->Free(cOldValue);
 }
 
 const vlChar *CVMTStringNode::GetValue() const
@@ -26,7 +26,7 @@ namespace VTFLib
 
 		public:
 			CVMTStringNode(const vlChar *cName);
-			CVMTStringNode(const vlChar *cName, const vlChar *cValue);
+			CVMTStringNode(const vlChar *cName, const vlChar *cValue, CVMTArena *Arena = 0);
 			CVMTStringNode(const CVMTStringNode &StringNode);
 			virtual ~CVMTStringNode();
 
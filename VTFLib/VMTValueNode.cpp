@@ -13,7 +13,7 @@
 
 using namespace VTFLib::Nodes;
 
-CVMTValueNode::CVMTValueNode(const vlChar *cName) : CVMTNode(cName)
+CVMTValueNode::CVMTValueNode(const vlChar *cName, CVMTArena *Arena) : CVMTNode(cName, Arena)
 {
 
 }
@@ -22,7 +22,7 @@ namespace VTFLib
 		class VTFLIB_API CVMTValueNode : public CVMTNode
 		{
 		public:
-			CVMTValueNode(const vlChar *cName);
+			CVMTValueNode(const vlChar *cName, CVMTArena *Arena = 0);
 			virtual ~CVMTValueNode();
 
 			virtual vlVoid SetValue(const vlChar *cValue) = 0;
@@ -14,6 +14,9 @@
 #include "VTFLib.h"
 #include "VMTWrapper.h"
 #include "VMTFile.h"
+#include "VMTCache.h"
+#include "VPKFile.h"
+#include "Context.h"
 
 using namespace VTFLib;
 
@@ -227,11 +230,84 @@ VTFLIB_API vlBool vlMaterialSaveProc(vlVoid *pUserData)
 	return Material->Save(pUserData);
 }
 
+VTFLIB_API vlBool vlMaterialLoadBinary(const vlVoid *lpData, vlUInt uiSize)
+{
+	if(Material == 0)
+	{
+		LastError.Set("No material bound.");
+		return vlFalse;
+	}
+
+	CurrentIndex.clear();
+	CurrentNode = 0;
+
+	return Material->LoadBinary(lpData, uiSize);
+}
+
+VTFLIB_API vlBool vlMaterialSaveBinary(vlVoid *lpData, vlUInt uiBufferSize, vlUInt *uiSize)
+{
+	if(Material == 0)
+	{
+		LastError.Set("No material bound.");
+		return vlFalse;
+	}
+
+	return Material->SaveBinary(lpData, uiBufferSize, *uiSize);
+}
+
+//
+// vlMaterialCacheLoad()
+// Loads the bound material through a material cache, see CVMTCache::Load().
+//
+VTFLIB_API vlBool vlMaterialCacheLoad(VLMaterialCache *MaterialCache, const vlChar *cFileName)
+{
+	if(Material == 0)
+	{
+		LastError.Set("No material bound.");
+		return vlFalse;
+	}
+
+	if(MaterialCache == 0)
+	{
+		LastError.Set("Invalid material cache.");
+		return vlFalse;
+	}
+
+	CurrentIndex.clear();
+	CurrentNode = 0;
+
+	return reinterpret_cast<CVMTCache *>(MaterialCache)->Load(cFileName, *Material);
+}
+
+//
+// vlMaterialLoadPackage()
+// Loads the bound material from a package, see CVMTFile::Load(const CVPKFile &, const vlChar *).
+//
+VTFLIB_API vlBool vlMaterialLoadPackage(VLPackage *Package, const vlChar *cPath)
+{
+	if(Material == 0)
+	{
+		LastError.Set("No material bound.");
+		return vlFalse;
+	}
+
+	if(Package == 0)
+	{
+		LastError.Set("Invalid package.");
+		return vlFalse;
+	}
+
+	CurrentIndex.clear();
+	CurrentNode = 0;
+
+	return Material->Load(*reinterpret_cast<CVPKFile *>(Package), cPath);
+}
+
 //
-// vlMaterialGetCurretNode()
+// GetCurrentNode()
 // Gets the current node in the transversal.
 //
-Nodes::CVMTNode *vlMaterialGetCurretNode()
+static Nodes::CVMTNode *GetCurrentNode(CVMTFile *Material, std::deque<vlInt> &CurrentIndex, Nodes::CVMTGroupNode *&CurrentNode)
 {
 	if(Material == 0 || CurrentNode == 0)
 		return 0;
@@ -247,10 +323,10 @@ Nodes::CVMTNode *vlMaterialGetCurretNode()
 }
 
 //
-// vlMaterialGetCurretNode()
+// GetCurrentNodeType()
 // Gets the current node type in the transversal.
 //
-VMTNodeType vlMaterialGetCurretNodeType()
+static VMTNodeType GetCurrentNodeType(CVMTFile *Material, std::deque<vlInt> &CurrentIndex, Nodes::CVMTGroupNode *&CurrentNode)
 {
 	if(Material == 0 || CurrentNode == 0)
 		return NODE_TYPE_COUNT;
@@ -271,10 +347,10 @@ VMTNodeType vlMaterialGetCurretNodeType()
 }
 
 //
-// vlMaterialGetFirstNode()
+// GetFirstNode()
 // Moves the current node to the stat of the root node.
 //
-VTFLIB_API vlBool vlMaterialGetFirstNode()
+static vlBool GetFirstNode(CVMTFile *Material, std::deque<vlInt> &CurrentIndex, Nodes::CVMTGroupNode *&CurrentNode)
 {
 	if(Material == 0 || Material->GetRoot() == 0)
 		return vlFalse;
@@ -285,11 +361,16 @@ VTFLIB_API vlBool vlMaterialGetFirstNode()
 	return vlTrue;
 }
 
+VTFLIB_API vlBool vlMaterialGetFirstNode()
+{
+	return GetFirstNode(Material, CurrentIndex, CurrentNode);
+}
+
 //
-// vlMaterialGetLastNode()
+// GetLastNode()
 // Moves the current node to the end of the root node.
 //
-VTFLIB_API vlBool vlMaterialGetLastNode()
+static vlBool GetLastNode(CVMTFile *Material, std::deque<vlInt> &CurrentIndex, Nodes::CVMTGroupNode *&CurrentNode)
 {
 	if(Material == 0 || Material->GetRoot() == 0)
 		return vlFalse;
@@ -300,11 +381,16 @@ VTFLIB_API vlBool vlMaterialGetLastNode()
 	return vlTrue;
 }
 
+VTFLIB_API vlBool vlMaterialGetLastNode()
+{
+	return GetLastNode(Material, CurrentIndex, CurrentNode);
+}
+
 //
-// vlMaterialGetNextNode()
+// GetNextNode()
 // Moves the current node to the next node depth first style.
 //
-VTFLIB_API vlBool vlMaterialGetNextNode()
+static vlBool GetNextNode(CVMTFile *Material, std::deque<vlInt> &CurrentIndex, Nodes::CVMTGroupNode *&CurrentNode)
 {
 	if(Material == 0 || CurrentNode == 0)
 		return vlFalse;
@@ -346,12 +432,17 @@ VTFLIB_API vlBool vlMaterialGetNextNode()
 	return vlTrue;
 }
 
+VTFLIB_API vlBool vlMaterialGetNextNode()
+{
+	return GetNextNode(Material, CurrentIndex, CurrentNode);
+}
+
 //
-// vlMaterialGetPreviousNode()
+// GetPreviousNode()
 // Moves the current node to the previous node depth first style.  This
 // is the reverse of vlMaterialGetNextNode().
 //
-VTFLIB_API vlBool vlMaterialGetPreviousNode()
+static vlBool GetPreviousNode(CVMTFile *Material, std::deque<vlInt> &CurrentIndex, Nodes::CVMTGroupNode *&CurrentNode)
 {
 	if(Material == 0 || CurrentNode == 0)
 		return vlFalse;
@@ -393,11 +484,16 @@ VTFLIB_API vlBool vlMaterialGetPreviousNode()
 	return vlTrue;
 }
 
+VTFLIB_API vlBool vlMaterialGetPreviousNode()
+{
+	return GetPreviousNode(Material, CurrentIndex, CurrentNode);
+}
+
 //
-// vlMaterialGetParentNode()
+// GetParentNode()
 // Moves the current node to the current node's parent.
 //
-VTFLIB_API vlBool vlMaterialGetParentNode()
+static vlBool GetParentNode(CVMTFile *Material, std::deque<vlInt> &CurrentIndex, Nodes::CVMTGroupNode *&CurrentNode)
 {
 	if(Material == 0 || CurrentNode == 0)
 		return vlFalse;
@@ -414,19 +510,24 @@ VTFLIB_API vlBool vlMaterialGetParentNode()
 	return vlFalse;
 }
 
+VTFLIB_API vlBool vlMaterialGetParentNode()
+{
+	return GetParentNode(Material, CurrentIndex, CurrentNode);
+}
+
 //
 // vlMaterialGetParentNode()
 // Moves the current node to the specified child node of the current node.
 //
-VTFLIB_API vlBool vlMaterialGetChildNode(const vlChar *cName)
+static vlBool GetChildNode(CVMTFile *Material, std::deque<vlInt> &CurrentIndex, Nodes::CVMTGroupNode *&CurrentNode, const vlChar *cName)
 {
 	if(Material == 0 || CurrentNode == 0)
 		return vlFalse;
 
-	Nodes::CVMTNode *VMTNode = vlMaterialGetCurretNode();
+	Nodes::CVMTNode *VMTNode = GetCurrentNode(Material, CurrentIndex, CurrentNode);
 
 	// Only groups have children.
-	if(VMTNode->GetType() != NODE_TYPE_GROUP)
+	if(VMTNode == 0 || VMTNode->GetType() != NODE_TYPE_GROUP)
 		return vlFalse;
 
 	Nodes::CVMTGroupNode *VMTGroupNode = static_cast<Nodes::CVMTGroupNode *>(VMTNode);
@@ -455,13 +556,18 @@ VTFLIB_API vlBool vlMaterialGetChildNode(const vlChar *cName)
 	return vlFalse;
 }
 
+VTFLIB_API vlBool vlMaterialGetChildNode(const vlChar *cName)
+{
+	return GetChildNode(Material, CurrentIndex, CurrentNode, cName);
+}
+
 //
-// vlMaterialGetNodeName()
+// GetNodeName()
 // Gets the current node's name.
 //
-VTFLIB_API const vlChar *vlMaterialGetNodeName()
+static const vlChar *GetNodeName(CVMTFile *Material, std::deque<vlInt> &CurrentIndex, Nodes::CVMTGroupNode *&CurrentNode)
 {
-	Nodes::CVMTNode *VMTNode = vlMaterialGetCurretNode();
+	Nodes::CVMTNode *VMTNode = GetCurrentNode(Material, CurrentIndex, CurrentNode);
 
 	if(VMTNode == 0)
 		return 0;
@@ -469,13 +575,18 @@ VTFLIB_API const vlChar *vlMaterialGetNodeName()
 	return VMTNode->GetName();
 }
 
+VTFLIB_API const vlChar *vlMaterialGetNodeName()
+{
+	return GetNodeName(Material, CurrentIndex, CurrentNode);
+}
+
 //
-// vlMaterialSetNodeName()
+// SetNodeName()
 // Sets the current node's name.
 //
-VTFLIB_API vlVoid vlMaterialSetNodeName(const vlChar *cName)
+static vlVoid SetNodeName(CVMTFile *Material, std::deque<vlInt> &CurrentIndex, Nodes::CVMTGroupNode *&CurrentNode, const vlChar *cName)
 {
-	Nodes::CVMTNode *VMTNode = vlMaterialGetCurretNode();
+	Nodes::CVMTNode *VMTNode = GetCurrentNode(Material, CurrentIndex, CurrentNode);
 
 	if(VMTNode == 0)
 		return;
@@ -483,6 +594,11 @@ VTFLIB_API vlVoid vlMaterialSetNodeName(const vlChar *cName)
 	VMTNode->SetName(cName);
 }
 
+VTFLIB_API vlVoid vlMaterialSetNodeName(const vlChar *cName)
+{
+	SetNodeName(Material, CurrentIndex, CurrentNode, cName);
+}
+
 //
 // GetNodeType()
 // Get the type of node.  Returns VL_NODE_UNKOWN at the end of a group.
@@ -501,147 +617,524 @@ VTFLIB_API vlVoid vlMaterialSetNodeName(const vlChar *cName)
 //   NODE_TYPE_STRING
 // NODE_TYPE_GROUP_END
 //
+static VMTNodeType GetNodeType(CVMTFile *Material, std::deque<vlInt> &CurrentIndex, Nodes::CVMTGroupNode *&CurrentNode)
+{
+	return GetCurrentNodeType(Material, CurrentIndex, CurrentNode);
+}
+
 VTFLIB_API VMTNodeType vlMaterialGetNodeType()
 {
-	return vlMaterialGetCurretNodeType();
+	return GetNodeType(Material, CurrentIndex, CurrentNode);
 }
 
 //
-// vlMaterialGetNodeString()
+// GetNodeString()
 // If the current node is a string node, this gets its value.
 //
-VTFLIB_API const vlChar *vlMaterialGetNodeString()
+static const vlChar *GetNodeString(CVMTFile *Material, std::deque<vlInt> &CurrentIndex, Nodes::CVMTGroupNode *&CurrentNode)
 {
-	Nodes::CVMTNode *VMTNode = vlMaterialGetCurretNode();
+	Nodes::CVMTNode *VMTNode = GetCurrentNode(Material, CurrentIndex, CurrentNode);
 
-	if(VMTNode->GetType() != NODE_TYPE_STRING)
+	if(VMTNode == 0 || VMTNode->GetType() != NODE_TYPE_STRING)
 		return 0;
 
 	return static_cast<Nodes::CVMTStringNode *>(VMTNode)->GetValue();
 }
 
+VTFLIB_API const vlChar *vlMaterialGetNodeString()
+{
+	return GetNodeString(Material, CurrentIndex, CurrentNode);
+}
+
 //
-// vlMaterialSetNodeString()
+// SetNodeString()
 // If the current node is a string node, this sets its value.
 //
-VTFLIB_API vlVoid vlMaterialSetNodeString(const vlChar *cValue)
+static vlVoid SetNodeString(CVMTFile *Material, std::deque<vlInt> &CurrentIndex, Nodes::CVMTGroupNode *&CurrentNode, const vlChar *cValue)
 {
-	Nodes::CVMTNode *VMTNode = vlMaterialGetCurretNode();
+	Nodes::CVMTNode *VMTNode = GetCurrentNode(Material, CurrentIndex, CurrentNode);
 
-	if(VMTNode->GetType() != NODE_TYPE_STRING)
+	if(VMTNode == 0 || VMTNode->GetType() != NODE_TYPE_STRING)
 		return;
 
 	static_cast<Nodes::CVMTStringNode *>(VMTNode)->SetValue(cValue);
 }
 
+VTFLIB_API vlVoid vlMaterialSetNodeString(const vlChar *cValue)
+{
+	SetNodeString(Material, CurrentIndex, CurrentNode, cValue);
+}
+
 //
-// vlMaterialGetNodeInteger()
+// GetNodeInteger()
 // If the current node is a integer node, this gets its value.
 //
-VTFLIB_API vlUInt vlMaterialGetNodeInteger()
+static vlUInt GetNodeInteger(CVMTFile *Material, std::deque<vlInt> &CurrentIndex, Nodes::CVMTGroupNode *&CurrentNode)
 {
-	Nodes::CVMTNode *VMTNode = vlMaterialGetCurretNode();
+	Nodes::CVMTNode *VMTNode = GetCurrentNode(Material, CurrentIndex, CurrentNode);
 
-	if(VMTNode->GetType() != NODE_TYPE_INTEGER)
+	if(VMTNode == 0 || VMTNode->GetType() != NODE_TYPE_INTEGER)
 		return 0;
 
 	return static_cast<Nodes::CVMTIntegerNode *>(VMTNode)->GetValue();
 }
 
+VTFLIB_API vlUInt vlMaterialGetNodeInteger()
+{
+	return GetNodeInteger(Material, CurrentIndex, CurrentNode);
+}
+
 //
-// vlMaterialSetNodeInteger()
+// SetNodeInteger()
 // If the current node is a integer node, this sets its value.
 //
-VTFLIB_API vlVoid vlMaterialSetNodeInteger(vlUInt iValue)
+static vlVoid SetNodeInteger(CVMTFile *Material, std::deque<vlInt> &CurrentIndex, Nodes::CVMTGroupNode *&CurrentNode, vlUInt iValue)
 {
-	Nodes::CVMTNode *VMTNode = vlMaterialGetCurretNode();
+	Nodes::CVMTNode *VMTNode = GetCurrentNode(Material, CurrentIndex, CurrentNode);
 
-	if(VMTNode->GetType() != NODE_TYPE_INTEGER)
+	if(VMTNode == 0 || VMTNode->GetType() != NODE_TYPE_INTEGER)
 		return;
 
 	static_cast<Nodes::CVMTIntegerNode *>(VMTNode)->SetValue(iValue);
 }
 
+VTFLIB_API vlVoid vlMaterialSetNodeInteger(vlUInt iValue)
+{
+	SetNodeInteger(Material, CurrentIndex, CurrentNode, iValue);
+}
+
 //
-// vlMaterialGetNodeSingle()
+// GetNodeSingle()
 // If the current node is a single node, this gets its value.
 //
-VTFLIB_API vlFloat vlMaterialGetNodeSingle()
+static vlFloat GetNodeSingle(CVMTFile *Material, std::deque<vlInt> &CurrentIndex, Nodes::CVMTGroupNode *&CurrentNode)
 {
-	Nodes::CVMTNode *VMTNode = vlMaterialGetCurretNode();
+	Nodes::CVMTNode *VMTNode = GetCurrentNode(Material, CurrentIndex, CurrentNode);
 
-	if(VMTNode->GetType() != NODE_TYPE_SINGLE)
+	if(VMTNode == 0 || VMTNode->GetType() != NODE_TYPE_SINGLE)
 		return 0.0f;
 
 	return static_cast<Nodes::CVMTSingleNode *>(VMTNode)->GetValue();
 }
 
+VTFLIB_API vlFloat vlMaterialGetNodeSingle()
+{
+	return GetNodeSingle(Material, CurrentIndex, CurrentNode);
+}
+
 //
-// vlMaterialSetNodeSingle()
+// SetNodeSingle()
 // If the current node is a single node, this sets its value.
 //
-VTFLIB_API vlVoid vlMaterialSetNodeSingle(vlFloat sValue)
+static vlVoid SetNodeSingle(CVMTFile *Material, std::deque<vlInt> &CurrentIndex, Nodes::CVMTGroupNode *&CurrentNode, vlFloat sValue)
 {
-	Nodes::CVMTNode *VMTNode = vlMaterialGetCurretNode();
+	Nodes::CVMTNode *VMTNode = GetCurrentNode(Material, CurrentIndex, CurrentNode);
 
-	if(VMTNode->GetType() != NODE_TYPE_SINGLE)
+	if(VMTNode == 0 || VMTNode->GetType() != NODE_TYPE_SINGLE)
 		return;
 
 	static_cast<Nodes::CVMTSingleNode *>(VMTNode)->SetValue(sValue);
 }
 
+VTFLIB_API vlVoid vlMaterialSetNodeSingle(vlFloat sValue)
+{
+	SetNodeSingle(Material, CurrentIndex, CurrentNode, sValue);
+}
+
 //
-// vlMaterialAddNodeGroup()
+// AddNodeGroup()
 // If the current node is a group node, this adds a group node to the current node.
 //
-VTFLIB_API vlVoid vlMaterialAddNodeGroup(const vlChar *cName)
+static vlVoid AddNodeGroup(CVMTFile *Material, std::deque<vlInt> &CurrentIndex, Nodes::CVMTGroupNode *&CurrentNode, const vlChar *cName)
 {
-	Nodes::CVMTNode *VMTNode = vlMaterialGetCurretNode();
+	Nodes::CVMTNode *VMTNode = GetCurrentNode(Material, CurrentIndex, CurrentNode);
 
-	if(VMTNode->GetType() != NODE_TYPE_GROUP)
+	if(VMTNode == 0 || VMTNode->GetType() != NODE_TYPE_GROUP)
 		return;
 
 	static_cast<Nodes::CVMTGroupNode *>(VMTNode)->AddGroupNode(cName);
 }
 
+VTFLIB_API vlVoid vlMaterialAddNodeGroup(const vlChar *cName)
+{
+	AddNodeGroup(Material, CurrentIndex, CurrentNode, cName);
+}
+
 //
-// vlMaterialAddNodeString()
+// AddNodeString()
 // If the current node is a group node, this adds a string node to the current node.
 //
-VTFLIB_API vlVoid vlMaterialAddNodeString(const vlChar *cName, const vlChar *cValue)
+static vlVoid AddNodeString(CVMTFile *Material, std::deque<vlInt> &CurrentIndex, Nodes::CVMTGroupNode *&CurrentNode, const vlChar *cName, const vlChar *cValue)
 {
-	Nodes::CVMTNode *VMTNode = vlMaterialGetCurretNode();
+	Nodes::CVMTNode *VMTNode = GetCurrentNode(Material, CurrentIndex, CurrentNode);
 
-	if(VMTNode->GetType() != NODE_TYPE_GROUP)
+	if(VMTNode == 0 || VMTNode->GetType() != NODE_TYPE_GROUP)
 		return;
 
 	static_cast<Nodes::CVMTGroupNode *>(VMTNode)->AddStringNode(cName, cValue);
 }
 
+VTFLIB_API vlVoid vlMaterialAddNodeString(const vlChar *cName, const vlChar *cValue)
+{
+	AddNodeString(Material, CurrentIndex, CurrentNode, cName, cValue);
+}
+
 //
-// vlMaterialAddNodeInteger()
+// AddNodeInteger()
 // If the current node is a group node, this adds a integer node to the current node.
 //
-VTFLIB_API vlVoid vlMaterialAddNodeInteger(const vlChar *cName, vlUInt iValue)
+static vlVoid AddNodeInteger(CVMTFile *Material, std::deque<vlInt> &CurrentIndex, Nodes::CVMTGroupNode *&CurrentNode, const vlChar *cName, vlUInt iValue)
 {
-	Nodes::CVMTNode *VMTNode = vlMaterialGetCurretNode();
+	Nodes::CVMTNode *VMTNode = GetCurrentNode(Material, CurrentIndex, CurrentNode);
 
-	if(VMTNode->GetType() != NODE_TYPE_GROUP)
+	if(VMTNode == 0 || VMTNode->GetType() != NODE_TYPE_GROUP)
 		return;
 
 	static_cast<Nodes::CVMTGroupNode *>(VMTNode)->AddIntegerNode(cName, iValue);
 }
 
+VTFLIB_API vlVoid vlMaterialAddNodeInteger(const vlChar *cName, vlUInt iValue)
+{
+	AddNodeInteger(Material, CurrentIndex, CurrentNode, cName, iValue);
+}
+
 //
-// vlMaterialAddNodeSingle()
+// AddNodeSingle()
 // If the current node is a group node, this adds a single node to the current node.
 //
-VTFLIB_API vlVoid vlMaterialAddNodeSingle(const vlChar *cName, vlFloat sValue)
+static vlVoid AddNodeSingle(CVMTFile *Material, std::deque<vlInt> &CurrentIndex, Nodes::CVMTGroupNode *&CurrentNode, const vlChar *cName, vlFloat sValue)
 {
-	Nodes::CVMTNode *VMTNode = vlMaterialGetCurretNode();
+	Nodes::CVMTNode *VMTNode = GetCurrentNode(Material, CurrentIndex, CurrentNode);
 
-	if(VMTNode->GetType() != NODE_TYPE_GROUP)
+	if(VMTNode == 0 || VMTNode->GetType() != NODE_TYPE_GROUP)
 		return;
 
 	static_cast<Nodes::CVMTGroupNode *>(VMTNode)->AddSingleNode(cName, sValue);
-}
\ No newline at end of file
+}
+
+VTFLIB_API vlVoid vlMaterialAddNodeSingle(const vlChar *cName, vlFloat sValue)
+{
+	AddNodeSingle(Material, CurrentIndex, CurrentNode, cName, sValue);
+}
+
+//
+// Pins a material in a context's table for the length of a call.
+//
+class CContextMaterial : public CHandleRef<CMaterialInstance>
+{
+public:
+	CContextMaterial(VLContext *Context, vlUInt uiMaterial) : CHandleRef<CMaterialInstance>(Context != 0 ? &CContext::FromHandle(Context)->GetMaterials() : 0, uiMaterial, "Invalid material.")
+	{
+
+	}
+};
+
+//
+// vlContextCreateMaterial()
+// Create a material in a context.  The material starts with the context's options.
+// Each material keeps its own position for the node routines.
+//
+VTFLIB_API vlBool vlContextCreateMaterial(VLContext *Context, vlUInt *uiMaterial)
+{
+	CContext *Instance = CContext::FromHandle(Context);
+	if(Instance == 0)
+		return vlFalse;
+
+	SVTFLibOptions Options;
+	Instance->GetOptions(Options);
+
+	CMaterialInstance *MaterialInstance = new CMaterialInstance();
+	MaterialInstance->Material.SetOptions(&Options);
+
+	*uiMaterial = Instance->GetMaterials().Add(MaterialInstance);
+	if(*uiMaterial == 0)
+	{
+		delete MaterialInstance;
+
+		LastError.Set("Too many materials.");
+		return vlFalse;
+	}
+
+	return vlTrue;
+}
+
+//
+// vlContextDeleteMaterial()
+// Delete a material in a context.  If another thread is still using the material
+// it is freed when that call returns.  The handle is invalid from now on.
+//
+VTFLIB_API vlVoid vlContextDeleteMaterial(VLContext *Context, vlUInt uiMaterial)
+{
+	CContext *Instance = CContext::FromHandle(Context);
+	if(Instance == 0)
+		return;
+
+	Instance->GetMaterials().Remove(uiMaterial);
+}
+
+VTFLIB_API vlBool vlContextMaterialCreate(VLContext *Context, vlUInt uiMaterial, const vlChar *cRoot)
+{
+	CContextMaterial Instance(Context, uiMaterial);
+	if(!Instance)
+		return vlFalse;
+
+	Instance->CurrentIndex.clear();
+	Instance->CurrentNode = 0;
+
+	return Instance->Material.Create(cRoot);
+}
+
+VTFLIB_API vlVoid vlContextMaterialDestroy(VLContext *Context, vlUInt uiMaterial)
+{
+	CContextMaterial Instance(Context, uiMaterial);
+	if(!Instance)
+		return;
+
+	Instance->CurrentIndex.clear();
+	Instance->CurrentNode = 0;
+
+	Instance->Material.Destroy();
+}
+
+VTFLIB_API vlBool vlContextMaterialIsLoaded(VLContext *Context, vlUInt uiMaterial)
+{
+	CContextMaterial Instance(Context, uiMaterial);
+	if(!Instance)
+		return vlFalse;
+
+	return Instance->Material.IsLoaded();
+}
+
+VTFLIB_API vlBool vlContextMaterialLoad(VLContext *Context, vlUInt uiMaterial, const vlChar *cFileName)
+{
+	CContextMaterial Instance(Context, uiMaterial);
+	if(!Instance)
+		return vlFalse;
+
+	Instance->CurrentIndex.clear();
+	Instance->CurrentNode = 0;
+
+	return Instance->Material.Load(cFileName);
+}
+
+VTFLIB_API vlBool vlContextMaterialLoadLump(VLContext *Context, vlUInt uiMaterial, const vlVoid *lpData, vlUInt uiBufferSize)
+{
+	CContextMaterial Instance(Context, uiMaterial);
+	if(!Instance)
+		return vlFalse;
+
+	Instance->CurrentIndex.clear();
+	Instance->CurrentNode = 0;
+
+	return Instance->Material.Load(lpData, uiBufferSize);
+}
+
+VTFLIB_API vlBool vlContextMaterialLoadProc(VLContext *Context, vlUInt uiMaterial, vlVoid *pUserData)
+{
+	CContextMaterial Instance(Context, uiMaterial);
+	if(!Instance)
+		return vlFalse;
+
+	Instance->CurrentIndex.clear();
+	Instance->CurrentNode = 0;
+
+	return Instance->Material.Load(pUserData);
+}
+
+VTFLIB_API vlBool vlContextMaterialSave(VLContext *Context, vlUInt uiMaterial, const vlChar *cFileName)
+{
+	CContextMaterial Instance(Context, uiMaterial);
+	if(!Instance)
+		return vlFalse;
+
+	return Instance->Material.Save(cFileName);
+}
+
+VTFLIB_API vlBool vlContextMaterialSaveLump(VLContext *Context, vlUInt uiMaterial, vlVoid *lpData, vlUInt uiBufferSize, vlUInt *uiSize)
+{
+	CContextMaterial Instance(Context, uiMaterial);
+	if(!Instance)
+		return vlFalse;
+
+	return Instance->Material.Save(lpData, uiBufferSize, *uiSize);
+}
+
+VTFLIB_API vlBool vlContextMaterialSaveProc(VLContext *Context, vlUInt uiMaterial, vlVoid *pUserData)
+{
+	CContextMaterial Instance(Context, uiMaterial);
+	if(!Instance)
+		return vlFalse;
+
+	return Instance->Material.Save(pUserData);
+}
+
+VTFLIB_API vlBool vlContextMaterialGetFirstNode(VLContext *Context, vlUInt uiMaterial)
+{
+	CContextMaterial Instance(Context, uiMaterial);
+	if(!Instance)
+		return vlFalse;
+
+	return GetFirstNode(&Instance->Material, Instance->CurrentIndex, Instance->CurrentNode);
+}
+
+VTFLIB_API vlBool vlContextMaterialGetLastNode(VLContext *Context, vlUInt uiMaterial)
+{
+	CContextMaterial Instance(Context, uiMaterial);
+	if(!Instance)
+		return vlFalse;
+
+	return GetLastNode(&Instance->Material, Instance->CurrentIndex, Instance->CurrentNode);
+}
+
+VTFLIB_API vlBool vlContextMaterialGetNextNode(VLContext *Context, vlUInt uiMaterial)
+{
+	CContextMaterial Instance(Context, uiMaterial);
+	if(!Instance)
+		return vlFalse;
+
+	return GetNextNode(&Instance->Material, Instance->CurrentIndex, Instance->CurrentNode);
+}
+
+VTFLIB_API vlBool vlContextMaterialGetPreviousNode(VLContext *Context, vlUInt uiMaterial)
+{
+	CContextMaterial Instance(Context, uiMaterial);
+	if(!Instance)
+		return vlFalse;
+
+	return GetPreviousNode(&Instance->Material, Instance->CurrentIndex, Instance->CurrentNode);
+}
+
+VTFLIB_API vlBool vlContextMaterialGetParentNode(VLContext *Context, vlUInt uiMaterial)
+{
+	CContextMaterial Instance(Context, uiMaterial);
+	if(!Instance)
+		return vlFalse;
+
+	return GetParentNode(&Instance->Material, Instance->CurrentIndex, Instance->CurrentNode);
+}
+
+VTFLIB_API vlBool vlContextMaterialGetChildNode(VLContext *Context, vlUInt uiMaterial, const vlChar *cName)
+{
+	CContextMaterial Instance(Context, uiMaterial);
+	if(!Instance)
+		return vlFalse;
+
+	return GetChildNode(&Instance->Material, Instance->CurrentIndex, Instance->CurrentNode, cName);
+}
+
+VTFLIB_API const vlChar *vlContextMaterialGetNodeName(VLContext *Context, vlUInt uiMaterial)
+{
+	CContextMaterial Instance(Context, uiMaterial);
+	if(!Instance)
+		return 0;
+
+	return GetNodeName(&Instance->Material, Instance->CurrentIndex, Instance->CurrentNode);
+}
+
+VTFLIB_API vlVoid vlContextMaterialSetNodeName(VLContext *Context, vlUInt uiMaterial, const vlChar *cName)
+{
+	CContextMaterial Instance(Context, uiMaterial);
+	if(!Instance)
+		return;
+
+	SetNodeName(&Instance->Material, Instance->CurrentIndex, Instance->CurrentNode, cName);
+}
+
+VTFLIB_API VMTNodeType vlContextMaterialGetNodeType(VLContext *Context, vlUInt uiMaterial)
+{
+	CContextMaterial Instance(Context, uiMaterial);
+	if(!Instance)
+		return NODE_TYPE_COUNT;
+
+	return GetNodeType(&Instance->Material, Instance->CurrentIndex, Instance->CurrentNode);
+}
+
+VTFLIB_API const vlChar *vlContextMaterialGetNodeString(VLContext *Context, vlUInt uiMaterial)
+{
+	CContextMaterial Instance(Context, uiMaterial);
+	if(!Instance)
+		return 0;
+
+	return GetNodeString(&Instance->Material, Instance->CurrentIndex, Instance->CurrentNode);
+}
+
+VTFLIB_API vlVoid vlContextMaterialSetNodeString(VLContext *Context, vlUInt uiMaterial, const vlChar *cValue)
+{
+	CContextMaterial Instance(Context, uiMaterial);
+	if(!Instance)
+		return;
+
+	SetNodeString(&Instance->Material, Instance->CurrentIndex, Instance->CurrentNode, cValue);
+}
+
+VTFLIB_API vlUInt vlContextMaterialGetNodeInteger(VLContext *Context, vlUInt uiMaterial)
+{
+	CContextMaterial Instance(Context, uiMaterial);
+	if(!Instance)
+		return 0;
+
+	return GetNodeInteger(&Instance->Material, Instance->CurrentIndex, Instance->CurrentNode);
+}
+
+VTFLIB_API vlVoid vlContextMaterialSetNodeInteger(VLContext *Context, vlUInt uiMaterial, vlUInt iValue)
+{
+	CContextMaterial Instance(Context, uiMaterial);
+	if(!Instance)
+		return;
+
+	SetNodeInteger(&Instance->Material, Instance->CurrentIndex, Instance->CurrentNode, iValue);
+}
+
+VTFLIB_API vlFloat vlContextMaterialGetNodeSingle(VLContext *Context, vlUInt uiMaterial)
+{
+	CContextMaterial Instance(Context, uiMaterial);
+	if(!Instance)
+		return 0.0f;
+
+	return GetNodeSingle(&Instance->Material, Instance->CurrentIndex, Instance->CurrentNode);
+}
+
+VTFLIB_API vlVoid vlContextMaterialSetNodeSingle(VLContext *Context, vlUInt uiMaterial, vlFloat sValue)
+{
+	CContextMaterial Instance(Context, uiMaterial);
+	if(!Instance)
+		return;
+
+	SetNodeSingle(&Instance->Material, Instance->CurrentIndex, Instance->CurrentNode, sValue);
+}
+
+VTFLIB_API vlVoid vlContextMaterialAddNodeGroup(VLContext *Context, vlUInt uiMaterial, const vlChar *cName)
+{
+	CContextMaterial Instance(Context, uiMaterial);
+	if(!Instance)
+		return;
+
+	AddNodeGroup(&Instance->Material, Instance->CurrentIndex, Instance->CurrentNode, cName);
+}
+
+VTFLIB_API vlVoid vlContextMaterialAddNodeString(VLContext *Context, vlUInt uiMaterial, const vlChar *cName, const vlChar *cValue)
+{
+	CContextMaterial Instance(Context, uiMaterial);
+	if(!Instance)
+		return;
+
+	AddNodeString(&Instance->Material, Instance->CurrentIndex, Instance->CurrentNode, cName, cValue);
+}
+
+VTFLIB_API vlVoid vlContextMaterialAddNodeInteger(VLContext *Context, vlUInt uiMaterial, const vlChar *cName, vlUInt iValue)
+{
+	CContextMaterial Instance(Context, uiMaterial);
+	if(!Instance)
+		return;
+
+	AddNodeInteger(&Instance->Material, Instance->CurrentIndex, Instance->CurrentNode, cName, iValue);
+}
+
+VTFLIB_API vlVoid vlContextMaterialAddNodeSingle(VLContext *Context, vlUInt uiMaterial, const vlChar *cName, vlFloat sValue)
+{
+	CContextMaterial Instance(Context, uiMaterial);
+	if(!Instance)
+		return;
+
+	AddNodeSingle(&Instance->Material, Instance->CurrentIndex, Instance->CurrentNode, cName, sValue);
+}
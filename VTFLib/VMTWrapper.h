@@ -13,6 +13,7 @@
 #define VTFWRAPPER_H
 
 #include "stdafx.h"
+#include "ContextWrapper.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -45,6 +46,9 @@ VTFLIB_API vlBool vlMaterialSave(const vlChar *cFileName);
 VTFLIB_API vlBool vlMaterialSaveLump(vlVoid *lpData, vlUInt uiBufferSize, vlUInt *uiSize);
 VTFLIB_API vlBool vlMaterialSaveProc(vlVoid *pUserData);
 
+VTFLIB_API vlBool vlMaterialLoadBinary(const vlVoid *lpData, vlUInt uiSize);
+VTFLIB_API vlBool vlMaterialSaveBinary(vlVoid *lpData, vlUInt uiBufferSize, vlUInt *uiSize);
+
 //
 // Node routines.
 //
@@ -76,6 +80,61 @@ VTFLIB_API vlVoid vlMaterialAddNodeString(const vlChar *cName, const vlChar *cVa
 VTFLIB_API vlVoid vlMaterialAddNodeInteger(const vlChar *cName, vlUInt iValue);
 VTFLIB_API vlVoid vlMaterialAddNodeSingle(const vlChar *cName, vlFloat sValue);
 
+//
+// Context memory managment routines.
+//
+
+VTFLIB_API vlBool vlContextCreateMaterial(VLContext *Context, vlUInt *uiMaterial);
+VTFLIB_API vlVoid vlContextDeleteMaterial(VLContext *Context, vlUInt uiMaterial);
+
+//
+// Context library routines.
+//
+
+VTFLIB_API vlBool vlContextMaterialCreate(VLContext *Context, vlUInt uiMaterial, const vlChar *cRoot);
+VTFLIB_API vlVoid vlContextMaterialDestroy(VLContext *Context, vlUInt uiMaterial);
+
+VTFLIB_API vlBool vlContextMaterialIsLoaded(VLContext *Context, vlUInt uiMaterial);
+
+VTFLIB_API vlBool vlContextMaterialLoad(VLContext *Context, vlUInt uiMaterial, const vlChar *cFileName);
+VTFLIB_API vlBool vlContextMaterialLoadLump(VLContext *Context, vlUInt uiMaterial, const vlVoid *lpData, vlUInt uiBufferSize);
+VTFLIB_API vlBool vlContextMaterialLoadProc(VLContext *Context, vlUInt uiMaterial, vlVoid *pUserData);
+
+VTFLIB_API vlBool vlContextMaterialSave(VLContext *Context, vlUInt uiMaterial, const vlChar *cFileName);
+VTFLIB_API vlBool vlContextMaterialSaveLump(VLContext *Context, vlUInt uiMaterial, vlVoid *lpData, vlUInt uiBufferSize, vlUInt *uiSize);
+VTFLIB_API vlBool vlContextMaterialSaveProc(VLContext *Context, vlUInt uiMaterial, vlVoid *pUserData);
+
+//
+// Context node routines.
+//
+
+VTFLIB_API vlBool vlContextMaterialGetFirstNode(VLContext *Context, vlUInt uiMaterial);
+VTFLIB_API vlBool vlContextMaterialGetLastNode(VLContext *Context, vlUInt uiMaterial);
+VTFLIB_API vlBool vlContextMaterialGetNextNode(VLContext *Context, vlUInt uiMaterial);
+VTFLIB_API vlBool vlContextMaterialGetPreviousNode(VLContext *Context, vlUInt uiMaterial);
+
+VTFLIB_API vlBool vlContextMaterialGetParentNode(VLContext *Context, vlUInt uiMaterial);
+VTFLIB_API vlBool vlContextMaterialGetChildNode(VLContext *Context, vlUInt uiMaterial, const vlChar *cName);
+
+VTFLIB_API const vlChar *vlContextMaterialGetNodeName(VLContext *Context, vlUInt uiMaterial);
+VTFLIB_API vlVoid vlContextMaterialSetNodeName(VLContext *Context, vlUInt uiMaterial, const vlChar *cName);
+
+VTFLIB_API VMTNodeType vlContextMaterialGetNodeType(VLContext *Context, vlUInt uiMaterial);
+
+VTFLIB_API const vlChar *vlContextMaterialGetNodeString(VLContext *Context, vlUInt uiMaterial);
+VTFLIB_API vlVoid vlContextMaterialSetNodeString(VLContext *Context, vlUInt uiMaterial, const vlChar *cValue);
+
+VTFLIB_API vlUInt vlContextMaterialGetNodeInteger(VLContext *Context, vlUInt uiMaterial);
+VTFLIB_API vlVoid vlContextMaterialSetNodeInteger(VLContext *Context, vlUInt uiMaterial, vlUInt iValue);
+
+VTFLIB_API vlFloat vlContextMaterialGetNodeSingle(VLContext *Context, vlUInt uiMaterial);
+VTFLIB_API vlVoid vlContextMaterialSetNodeSingle(VLContext *Context, vlUInt uiMaterial, vlFloat sValue);
+
+VTFLIB_API vlVoid vlContextMaterialAddNodeGroup(VLContext *Context, vlUInt uiMaterial, const vlChar *cName);
+VTFLIB_API vlVoid vlContextMaterialAddNodeString(VLContext *Context, vlUInt uiMaterial, const vlChar *cName, const vlChar *cValue);
+VTFLIB_API vlVoid vlContextMaterialAddNodeInteger(VLContext *Context, vlUInt uiMaterial, const vlChar *cName, vlUInt iValue);
+VTFLIB_API vlVoid vlContextMaterialAddNodeSingle(VLContext *Context, vlUInt uiMaterial, const vlChar *cName, vlFloat sValue);
+
 #ifdef __cplusplus
 }
 #endif
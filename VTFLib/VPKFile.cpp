@@ -0,0 +1,567 @@
+/*
+ * VTFLib
+ * Copyright (C) 2005-2010 Neil Jedrzejewski & Ryan Gregg
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later
+ * version.
+ */
+
+#include "VTFLib.h"
+#include "VPKFile.h"
+#include "FileMapping.h"
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace VTFLib;
+
+//
+// Package directory layout (name_dir.vpk).
+//
+// SVPKHeader					version 1, or SVPKHeader2 for version 2
+// tree[uiTreeSize]				for each extension, path and file name in turn:
+//									extension\0 path\0 name\0 SVPKDirectoryEntry preload[usPreloadBytes]
+//								an empty string ends a level, " " stands for no extension or path
+// data							entries with archive VPK_DIRECTORY_ARCHIVE, offsets from here
+// (version 2 checksum and signature sections follow, unused)
+//
+
+#pragma pack(1)
+
+struct SVPKHeader
+{
+	vlUInt uiSignature;			// VPK_SIGNATURE
+	vlUInt uiVersion;
+	vlUInt uiTreeSize;
+};
+
+struct SVPKHeader2 : public SVPKHeader
+{
+	vlUInt uiFileDataSectionSize;
+	vlUInt uiArchiveMD5SectionSize;
+	vlUInt uiOtherMD5SectionSize;
+	vlUInt uiSignatureSectionSize;
+};
+
+struct SVPKDirectoryEntry
+{
+	vlUInt uiCRC;
+	vlUShort usPreloadBytes;
+	vlUShort usArchiveIndex;
+	vlUInt uiEntryOffset;		// From the start of the archive, or of the data for VPK_DIRECTORY_ARCHIVE.
+	vlUInt uiEntryLength;
+	vlUShort usTerminator;		// 0xffff
+};
+
+#pragma pack()
+
+namespace VTFLib
+{
+	struct SVPKEntry
+	{
+		vlUInt uiName;				// Offset into the names.
+		vlUInt uiCRC;
+		vlUInt uiPreload;			// Offset into the directory file.
+		vlUShort usPreloadSize;
+		vlUShort usArchive;
+		vlUInt uiOffset;			// Offset into the archive, or the directory file for VPK_DIRECTORY_ARCHIVE.
+		vlUInt uiLength;
+	};
+
+	class CVPKFileState
+	{
+	public:
+		CFileMapping Directory;
+		std::string ArchivePrefix;	// name_ of name_dir.vpk, empty if there are no archives.
+
+		std::vector<SVPKEntry> Entries;
+		std::vector<vlChar> Names;
+		std::vector<vlUInt> Buckets;	// Entry + 1 by hash of name, 0 for empty; open addressing.
+
+		mutable std::mutex ArchiveMutex;
+		mutable std::vector<CFileMapping *> Archives;
+
+	public:
+		~CVPKFileState()
+		{
+			this->Clear();
+		}
+
+		vlVoid Clear()
+		{
+			for(std::vector<CFileMapping *>::iterator i = this->Archives.begin(); i != this->Archives.end(); ++i)
+			{
+				delete *i;
+			}
+
+			this->Archives.clear();
+			this->Entries.clear();
+			this->Names.clear();
+			this->Buckets.clear();
+			this->ArchivePrefix.clear();
+			this->Directory.Unmap();
+		}
+
+		static vlUInt Hash(const vlChar *cName)
+		{
+			// FNV-1a.
+			vlUInt uiHash = 2166136261u;
+			for(; *cName; cName++)
+			{
+				uiHash = (uiHash ^ (vlByte)*cName) * 16777619u;
+			}
+
+			return uiHash;
+		}
+
+		//
+		// Index()
+		// Builds the hash table; the first of any duplicate names wins.
+		//
+		vlVoid Index()
+		{
+			vlUInt uiBuckets = 16;
+			while(uiBuckets < this->Entries.size() * 2)
+			{
+				uiBuckets *= 2;
+			}
+
+			this->Buckets.assign(uiBuckets, 0);
+
+			for(vlUInt i = 0; i < (vlUInt)this->Entries.size(); i++)
+			{
+				const vlChar *cName = &this->Names[this->Entries[i].uiName];
+				if(this->Find(cName) != VPK_INVALID_INDEX)
+				{
+					continue;
+				}
+
+				vlUInt uiBucket = Hash(cName) & (uiBuckets - 1);
+				while(this->Buckets[uiBucket] != 0)
+				{
+					uiBucket = (uiBucket + 1) & (uiBuckets - 1);
+				}
+
+				this->Buckets[uiBucket] = i + 1;
+			}
+		}
+
+		vlUInt Find(const vlChar *cName) const
+		{
+			if(this->Buckets.empty())
+			{
+				return VPK_INVALID_INDEX;
+			}
+
+			vlUInt uiMask = (vlUInt)this->Buckets.size() - 1;
+			for(vlUInt uiBucket = Hash(cName) & uiMask; this->Buckets[uiBucket] != 0; uiBucket = (uiBucket + 1) & uiMask)
+			{
+				vlUInt uiEntry = this->Buckets[uiBucket] - 1;
+				if(strcmp(&this->Names[this->Entries[uiEntry].uiName], cName) == 0)
+				{
+					return uiEntry;
+				}
+			}
+
+			return VPK_INVALID_INDEX;
+		}
+
+		//
+		// GetArchive()
+		// Maps an archive the first time it's needed.
+		//
+		const CFileMapping *GetArchive(vlUInt uiArchive) const
+		{
+			std::lock_guard<std::mutex> Lock(this->ArchiveMutex);
+
+			if(uiArchive < this->Archives.size() && this->Archives[uiArchive] != 0)
+			{
+				return this->Archives[uiArchive];
+			}
+
+			if(this->ArchivePrefix.empty())
+			{
+				LastError.Set("Package has no archives.");
+				return 0;
+			}
+
+			vlChar cArchive[16];
+			sprintf(cArchive, "%03u.vpk", uiArchive);
+
+			CFileMapping *Archive = new CFileMapping();
+			if(!Archive->Map((this->ArchivePrefix + cArchive).c_str()))
+			{
+				delete Archive;
+				return 0;
+			}
+
+			if(uiArchive >= this->Archives.size())
+			{
+				this->Archives.resize(uiArchive + 1, 0);
+			}
+			this->Archives[uiArchive] = Archive;
+
+			return Archive;
+		}
+	};
+}
+
+//
+// NormalizePath()
+// Folds case and slashes the way entry names are stored.
+//
+static std::string NormalizePath(const vlChar *cPath)
+{
+	std::string Path = cPath;
+	for(std::string::iterator i = Path.begin(); i != Path.end(); ++i)
+	{
+		*i = *i == '\\' ? '/' : (vlChar)tolower((vlByte)*i);
+	}
+
+	return Path;
+}
+
+//
+// ReadString()
+// Reads a null terminated string of the tree, or returns null if it runs past
+// the end.
+//
+static const vlChar *ReadString(const vlByte *&lpPointer, const vlByte *lpEnd)
+{
+	const vlByte *lpTerminator = static_cast<const vlByte *>(memchr(lpPointer, '\0', lpEnd - lpPointer));
+	if(lpTerminator == 0)
+	{
+		return 0;
+	}
+
+	const vlChar *cString = reinterpret_cast<const vlChar *>(lpPointer);
+	lpPointer = lpTerminator + 1;
+
+	return cString;
+}
+
+CVPKFile::CVPKFile() : State(new CVPKFileState())
+{
+
+}
+
+CVPKFile::~CVPKFile()
+{
+	delete this->State;
+}
+
+vlBool CVPKFile::Open(const vlChar *cFileName)
+{
+	this->Close();
+
+	CVPKFileState *State = this->State;
+
+	if(!State->Directory.Map(cFileName))
+	{
+		return vlFalse;
+	}
+
+	const vlByte *lpData = State->Directory.lpData;
+	vlUInt uiSize = State->Directory.uiSize;
+
+	const SVPKHeader *Header = reinterpret_cast<const SVPKHeader *>(lpData);
+	if(uiSize < sizeof(SVPKHeader) || Header->uiSignature != VPK_SIGNATURE || (Header->uiVersion != 1 && Header->uiVersion != 2))
+	{
+		this->Close();
+		LastError.Set("Invalid package directory.");
+		return vlFalse;
+	}
+
+	vlUInt uiHeaderSize = Header->uiVersion == 1 ? sizeof(SVPKHeader) : sizeof(SVPKHeader2);
+	if(uiHeaderSize > uiSize || Header->uiTreeSize > uiSize - uiHeaderSize)
+	{
+		this->Close();
+		LastError.Set("Package directory is truncated.");
+		return vlFalse;
+	}
+
+	const vlByte *lpPointer = lpData + uiHeaderSize;
+	const vlByte *lpEnd = lpPointer + Header->uiTreeSize;
+	vlUInt uiDataStart = uiHeaderSize + Header->uiTreeSize;
+
+	std::string Name;
+	vlBool bValid = vlTrue;
+	while(bValid)
+	{
+		const vlChar *cExtension = ReadString(lpPointer, lpEnd);
+		if(cExtension == 0 || *cExtension == '\0')
+		{
+			bValid = cExtension != 0;
+			break;
+		}
+
+		while(bValid)
+		{
+			const vlChar *cPath = ReadString(lpPointer, lpEnd);
+			if(cPath == 0 || *cPath == '\0')
+			{
+				bValid = cPath != 0;
+				break;
+			}
+
+			while(bValid)
+			{
+				const vlChar *cName = ReadString(lpPointer, lpEnd);
+				if(cName == 0 || *cName == '\0')
+				{
+					bValid = cName != 0;
+					break;
+				}
+
+				if((vlUInt)(lpEnd - lpPointer) < sizeof(SVPKDirectoryEntry))
+				{
+					bValid = vlFalse;
+					break;
+				}
+
+				SVPKDirectoryEntry DirectoryEntry;
+				memcpy(&DirectoryEntry, lpPointer, sizeof(SVPKDirectoryEntry));
+				lpPointer += sizeof(SVPKDirectoryEntry);
+
+				if(DirectoryEntry.usTerminator != 0xffff || (vlUInt)(lpEnd - lpPointer) < DirectoryEntry.usPreloadBytes)
+				{
+					bValid = vlFalse;
+					break;
+				}
+
+				SVPKEntry Entry;
+				Entry.uiName = (vlUInt)State->Names.size();
+				Entry.uiCRC = DirectoryEntry.uiCRC;
+				Entry.uiPreload = (vlUInt)(lpPointer - lpData);
+				Entry.usPreloadSize = DirectoryEntry.usPreloadBytes;
+				Entry.usArchive = DirectoryEntry.usArchiveIndex;
+				Entry.uiOffset = DirectoryEntry.uiEntryOffset;
+				Entry.uiLength = DirectoryEntry.uiEntryLength;
+
+				lpPointer += DirectoryEntry.usPreloadBytes;
+
+				// Data kept in the directory is checked now; archives when they're mapped.
+				if(Entry.usArchive == VPK_DIRECTORY_ARCHIVE)
+				{
+					if(Entry.uiOffset > uiSize - uiDataStart || Entry.uiLength > uiSize - uiDataStart - Entry.uiOffset)
+					{
+						bValid = vlFalse;
+						break;
+					}
+
+					Entry.uiOffset += uiDataStart;
+				}
+
+				Name.clear();
+				if(strcmp(cPath, " ") != 0)
+				{
+					Name.append(cPath).append("/");
+				}
+				Name.append(cName);
+				if(strcmp(cExtension, " ") != 0)
+				{
+					Name.append(".").append(cExtension);
+				}
+				Name = NormalizePath(Name.c_str());
+
+				State->Names.insert(State->Names.end(), Name.c_str(), Name.c_str() + Name.size() + 1);
+				State->Entries.push_back(Entry);
+			}
+		}
+	}
+
+	if(!bValid)
+	{
+		this->Close();
+		LastError.Set("Package directory is corrupt.");
+		return vlFalse;
+	}
+
+	// name_dir.vpk has its archives in name_000.vpk and on.
+	vlUInt uiLength = (vlUInt)strlen(cFileName);
+	if(uiLength >= 8 && NormalizePath(cFileName + uiLength - 8) == "_dir.vpk")
+	{
+		State->ArchivePrefix.assign(cFileName, uiLength - 7);
+	}
+
+	State->Index();
+
+	return vlTrue;
+}
+
+vlVoid CVPKFile::Close()
+{
+	this->State->Clear();
+}
+
+vlUInt CVPKFile::GetEntryCount() const
+{
+	return (vlUInt)this->State->Entries.size();
+}
+
+vlUInt CVPKFile::FindEntry(const vlChar *cPath) const
+{
+	return this->State->Find(NormalizePath(cPath).c_str());
+}
+
+const vlChar *CVPKFile::GetEntryName(vlUInt uiEntry) const
+{
+	if(uiEntry >= this->State->Entries.size())
+	{
+		return 0;
+	}
+
+	return &this->State->Names[this->State->Entries[uiEntry].uiName];
+}
+
+vlUInt CVPKFile::GetEntrySize(vlUInt uiEntry) const
+{
+	if(uiEntry >= this->State->Entries.size())
+	{
+		return 0;
+	}
+
+	const SVPKEntry &Entry = this->State->Entries[uiEntry];
+
+	return Entry.usPreloadSize + Entry.uiLength;
+}
+
+vlUInt CVPKFile::GetEntryCRC(vlUInt uiEntry) const
+{
+	if(uiEntry >= this->State->Entries.size())
+	{
+		return 0;
+	}
+
+	return this->State->Entries[uiEntry].uiCRC;
+}
+
+vlBool CVPKFile::GetEntryData(vlUInt uiEntry, const vlVoid *&lpPreload, vlUInt &uiPreloadSize, const vlVoid *&lpData, vlUInt &uiDataSize) const
+{
+	const CVPKFileState *State = this->State;
+
+	lpPreload = lpData = 0;
+	uiPreloadSize = uiDataSize = 0;
+
+	if(uiEntry >= State->Entries.size())
+	{
+		LastError.Set("Package entry not found.");
+		return vlFalse;
+	}
+
+	const SVPKEntry &Entry = State->Entries[uiEntry];
+
+	const CFileMapping *Archive = &State->Directory;
+	if(Entry.uiLength != 0 && Entry.usArchive != VPK_DIRECTORY_ARCHIVE)
+	{
+		Archive = State->GetArchive(Entry.usArchive);
+		if(Archive == 0)
+		{
+			return vlFalse;
+		}
+
+		if(Entry.uiOffset > Archive->uiSize || Entry.uiLength > Archive->uiSize - Entry.uiOffset)
+		{
+			LastError.SetFormatted("%s is past the end of its archive.", &State->Names[Entry.uiName]);
+			return vlFalse;
+		}
+	}
+
+	lpPreload = State->Directory.lpData + Entry.uiPreload;
+	uiPreloadSize = Entry.usPreloadSize;
+	lpData = Entry.uiLength != 0 ? Archive->lpData + Entry.uiOffset : 0;
+	uiDataSize = Entry.uiLength;
+
+	return vlTrue;
+}
+
+//
+// vlCreatePackage()
+// Creates an empty package.  Open a package directory with vlPackageOpen().
+//
+VTFLIB_API vlBool vlCreatePackage(VLPackage **Package)
+{
+	if(!bInitialized)
+	{
+		LastError.Set("VTFLib not initialized.");
+		return vlFalse;
+	}
+
+	*Package = reinterpret_cast<VLPackage *>(new CVPKFile());
+
+	return vlTrue;
+}
+
+VTFLIB_API vlVoid vlDeletePackage(VLPackage *Package)
+{
+	delete reinterpret_cast<CVPKFile *>(Package);
+}
+
+static CVPKFile *FromHandle(VLPackage *Package)
+{
+	if(Package == 0)
+	{
+		LastError.Set("Invalid package.");
+		return 0;
+	}
+
+	return reinterpret_cast<CVPKFile *>(Package);
+}
+
+VTFLIB_API vlBool vlPackageOpen(VLPackage *Package, const vlChar *cFileName)
+{
+	CVPKFile *Instance = FromHandle(Package);
+	if(Instance == 0)
+		return vlFalse;
+
+	return Instance->Open(cFileName);
+}
+
+VTFLIB_API vlVoid vlPackageClose(VLPackage *Package)
+{
+	CVPKFile *Instance = FromHandle(Package);
+	if(Instance == 0)
+		return;
+
+	Instance->Close();
+}
+
+VTFLIB_API vlUInt vlPackageGetEntryCount(VLPackage *Package)
+{
+	CVPKFile *Instance = FromHandle(Package);
+	if(Instance == 0)
+		return 0;
+
+	return Instance->GetEntryCount();
+}
+
+VTFLIB_API vlUInt vlPackageFindEntry(VLPackage *Package, const vlChar *cPath)
+{
+	CVPKFile *Instance = FromHandle(Package);
+	if(Instance == 0)
+		return VPK_INVALID_INDEX;
+
+	return Instance->FindEntry(cPath);
+}
+
+VTFLIB_API const vlChar *vlPackageGetEntryName(VLPackage *Package, vlUInt uiEntry)
+{
+	CVPKFile *Instance = FromHandle(Package);
+	if(Instance == 0)
+		return 0;
+
+	return Instance->GetEntryName(uiEntry);
+}
+
+VTFLIB_API vlUInt vlPackageGetEntrySize(VLPackage *Package, vlUInt uiEntry)
+{
+	CVPKFile *Instance = FromHandle(Package);
+	if(Instance == 0)
+		return 0;
+
+	return Instance->GetEntrySize(uiEntry);
+}
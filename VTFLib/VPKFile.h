@@ -0,0 +1,91 @@
+/*
+ * VTFLib
+ * Copyright (C) 2005-2010 Neil Jedrzejewski & Ryan Gregg
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later
+ * version.
+ */
+
+// ============================================================
+// NOTE: This file is commented for compatibility with Doxygen.
+// ============================================================
+/*!
+	\file VPKFile.h
+	\brief Reads files out of Valve packages without extracting them.
+*/
+
+#ifndef VPKFILE_H
+#define VPKFILE_H
+
+#include "stdafx.h"
+#include "VPKWrapper.h"
+
+#define VPK_SIGNATURE			0x55aa1234	//!< First four bytes of a package directory.
+#define VPK_DIRECTORY_ARCHIVE	0x7fff		//!< Archive index of data stored in the directory file itself.
+
+namespace VTFLib
+{
+	class CVPKFileState;
+
+	//! A version 1 or 2 Valve package, read in place.
+	/*!
+		Open() maps the directory file (name_dir.vpk) and indexes every entry
+		by path.  The numbered archives beside it (name_000.vpk and on) are
+		mapped the first time an entry in them is read and stay mapped until
+		Close(), so entry data is never copied out of the package.
+
+		Paths are matched in any case and with either slash, e.g.
+		"materials/skybox/sky_day01_01ft.vtf".
+
+		Entries may be found and read on several threads at once, but Open()
+		and Close() must not run alongside anything else.
+
+		\see IO::Readers::CVPKReader, CVTFFile::Load(const CVPKFile &, const vlChar *, vlBool),
+		CVMTFile::Load(const CVPKFile &, const vlChar *)
+	*/
+	class VTFLIB_API CVPKFile
+	{
+	private:
+		CVPKFileState *State;
+
+	public:
+		CVPKFile();
+		~CVPKFile();
+
+	private:
+		CVPKFile(const CVPKFile &);
+		CVPKFile &operator=(const CVPKFile &);
+
+	public:
+		//! Maps and indexes a package directory.
+		/*!
+			\return true on success, otherwise false and the package is empty.
+		*/
+		vlBool Open(const vlChar *cFileName);
+		vlVoid Close();		//!< Unmaps the directory and archives.
+
+		vlUInt GetEntryCount() const;
+
+		//! Returns the index of an entry, or VPK_INVALID_INDEX if there is none.
+		vlUInt FindEntry(const vlChar *cPath) const;
+
+		const vlChar *GetEntryName(vlUInt uiEntry) const;	//!< Returns the path, lower case with forward slashes.
+		vlUInt GetEntrySize(vlUInt uiEntry) const;			//!< Returns the preload and archive bytes together.
+		vlUInt GetEntryCRC(vlUInt uiEntry) const;			//!< Returns the CRC32 the package records for the entry.
+
+		//! Gets an entry's bytes, mapping its archive if need be.
+		/*!
+			An entry is its preload bytes, kept in the directory, followed by its
+			bytes in an archive.  Either part may be empty.  The pointers stay
+			valid until Close().
+
+			\return true on success, otherwise false.
+		*/
+		vlBool GetEntryData(vlUInt uiEntry, const vlVoid *&lpPreload, vlUInt &uiPreloadSize, const vlVoid *&lpData, vlUInt &uiDataSize) const;
+	};
+}
+
+#endif
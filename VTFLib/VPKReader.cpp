@@ -0,0 +1,180 @@
+/*
+ * VTFLib
+ * Copyright (C) 2005-2010 Neil Jedrzejewski & Ryan Gregg
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later
+ * version.
+ */
+
+#include "VTFLib.h"
+#include "VPKReader.h"
+#include "VPKFile.h"
+
+using namespace VTFLib;
+using namespace VTFLib::IO::Readers;
+
+CVPKReader::CVPKReader(const CVPKFile &Package, vlUInt uiEntry)
+{
+	this->Package = &Package;
+	this->uiEntry = uiEntry;
+
+	this->bOpened = vlFalse;
+
+	this->lpPreload = 0;
+	this->uiPreloadSize = 0;
+	this->lpData = 0;
+	this->uiDataSize = 0;
+
+	this->uiPointer = 0;
+}
+
+CVPKReader::~CVPKReader()
+{
+
+}
+
+vlBool CVPKReader::Opened() const
+{
+	return this->bOpened;
+}
+
+vlBool CVPKReader::Open()
+{
+	const vlVoid *lpPreload, *lpData;
+	if(!this->Package->GetEntryData(this->uiEntry, lpPreload, this->uiPreloadSize, lpData, this->uiDataSize))
+	{
+		this->bOpened = vlFalse;
+		return vlFalse;
+	}
+
+	this->lpPreload = static_cast<const vlByte *>(lpPreload);
+	this->lpData = static_cast<const vlByte *>(lpData);
+
+	this->uiPointer = 0;
+
+	this->bOpened = vlTrue;
+
+	return vlTrue;
+}
+
+vlVoid CVPKReader::Close()
+{
+	this->bOpened = vlFalse;
+}
+
+vlUInt CVPKReader::GetStreamSize() const
+{
+	if(!this->bOpened)
+	{
+		return 0;
+	}
+
+	return this->uiPreloadSize + this->uiDataSize;
+}
+
+vlUInt CVPKReader::GetStreamPointer() const
+{
+	if(!this->bOpened)
+	{
+		return 0;
+	}
+
+	return this->uiPointer;
+}
+
+vlUInt CVPKReader::Seek(vlLong lOffset, vlUInt uiMode)
+{
+	if(!this->bOpened)
+	{
+		return 0;
+	}
+
+	vlUInt uiSize = this->uiPreloadSize + this->uiDataSize;
+
+	switch(uiMode)
+	{
+		case FILE_BEGIN:
+			this->uiPointer = 0;
+			break;
+		case FILE_CURRENT:
+
+			break;
+		case FILE_END:
+			this->uiPointer = uiSize;
+			break;
+	}
+
+	vlLong lPointer = (vlLong)this->uiPointer + lOffset;
+
+	if(lPointer < 0)
+	{
+		lPointer = 0;
+	}
+
+	if(lPointer > (vlLong)uiSize)
+	{
+		lPointer = (vlLong)uiSize;
+	}
+
+	this->uiPointer = (vlUInt)lPointer;
+
+	return this->uiPointer;
+}
+
+vlBool CVPKReader::Read(vlChar &cChar)
+{
+	return this->Read(&cChar, 1) == 1;
+}
+
+vlUInt CVPKReader::Read(vlVoid *vData, vlUInt uiBytes)
+{
+	if(!this->bOpened)
+	{
+		return 0;
+	}
+
+	vlByte *lpOut = static_cast<vlByte *>(vData);
+	vlUInt uiRead = 0;
+
+	if(this->uiPointer < this->uiPreloadSize)
+	{
+		vlUInt uiCopy = this->uiPreloadSize - this->uiPointer;
+		if(uiCopy > uiBytes)
+		{
+			uiCopy = uiBytes;
+		}
+
+		memcpy(lpOut, this->lpPreload + this->uiPointer, uiCopy);
+
+		this->uiPointer += uiCopy;
+		uiRead += uiCopy;
+	}
+
+	if(uiRead < uiBytes && this->uiPointer >= this->uiPreloadSize)
+	{
+		vlUInt uiOffset = this->uiPointer - this->uiPreloadSize;
+		vlUInt uiCopy = uiOffset < this->uiDataSize ? this->uiDataSize - uiOffset : 0;
+		if(uiCopy > uiBytes - uiRead)
+		{
+			uiCopy = uiBytes - uiRead;
+		}
+
+		if(uiCopy != 0)
+		{
+			memcpy(lpOut + uiRead, this->lpData + uiOffset, uiCopy);
+
+			this->uiPointer += uiCopy;
+			uiRead += uiCopy;
+		}
+	}
+
+	if(uiRead < uiBytes)
+	{
+		LastError.Set("End of package entry.");
+	}
+
+	return uiRead;
+}
@@ -0,0 +1,68 @@
+/*
+ * VTFLib
+ * Copyright (C) 2005-2010 Neil Jedrzejewski & Ryan Gregg
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later
+ * version.
+ */
+
+#ifndef VPKREADER_H
+#define VPKREADER_H
+
+#include "stdafx.h"
+#include "Reader.h"
+
+namespace VTFLib
+{
+	class CVPKFile;
+
+	namespace IO
+	{
+		namespace Readers
+		{
+			//
+			// Reads one entry of a package: its preload bytes then its archive
+			// bytes, both straight from the package's mappings.  Any number of
+			// readers can share a package, on any threads.
+			//
+			class CVPKReader : public IReader
+			{
+			private:
+				const CVPKFile *Package;
+				vlUInt uiEntry;
+
+				vlBool bOpened;
+
+				const vlByte *lpPreload;
+				vlUInt uiPreloadSize;
+				const vlByte *lpData;
+				vlUInt uiDataSize;
+
+				vlUInt uiPointer;
+
+			public:
+				CVPKReader(const CVPKFile &Package, vlUInt uiEntry);
+				~CVPKReader();
+
+			public:
+				virtual vlBool Opened() const;
+
+				virtual vlBool Open();
+				virtual vlVoid Close();
+
+				virtual vlUInt GetStreamSize() const;
+				virtual vlUInt GetStreamPointer() const;
+
+				virtual vlUInt Seek(vlLong lOffset, vlUInt uiMode);
+
+				virtual vlBool Read(vlChar &cChar);
+				virtual vlUInt Read(vlVoid *vData, vlUInt uiBytes);
+			};
+		}
+	}
+}
+
+#endif
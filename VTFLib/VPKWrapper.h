@@ -0,0 +1,50 @@
+/*
+ * VTFLib
+ * Copyright (C) 2005-2010 Neil Jedrzejewski & Ryan Gregg
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later
+ * version.
+ */
+
+#ifndef VPKWRAPPER_H
+#define VPKWRAPPER_H
+
+#include "stdafx.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define VPK_INVALID_INDEX	0xffffffff
+
+//
+// A Valve package (.vpk) read in place.  Open the _dir.vpk; entries are found
+// by their path inside the package, in any case and with either slash.
+// vlImageLoadPackage() and vlMaterialLoadPackage() load the bound image or
+// material straight from the package's mapped archives.
+//
+
+typedef struct tagVLPackage VLPackage;
+
+VTFLIB_API vlBool vlCreatePackage(VLPackage **Package);
+VTFLIB_API vlVoid vlDeletePackage(VLPackage *Package);
+
+VTFLIB_API vlBool vlPackageOpen(VLPackage *Package, const vlChar *cFileName);
+VTFLIB_API vlVoid vlPackageClose(VLPackage *Package);
+
+VTFLIB_API vlUInt vlPackageGetEntryCount(VLPackage *Package);
+VTFLIB_API vlUInt vlPackageFindEntry(VLPackage *Package, const vlChar *cPath);
+VTFLIB_API const vlChar *vlPackageGetEntryName(VLPackage *Package, vlUInt uiEntry);
+VTFLIB_API vlUInt vlPackageGetEntrySize(VLPackage *Package, vlUInt uiEntry);
+
+VTFLIB_API vlBool vlImageLoadPackage(VLPackage *Package, const vlChar *cPath, vlBool bHeaderOnly);
+VTFLIB_API vlBool vlMaterialLoadPackage(VLPackage *Package, const vlChar *cPath);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -14,6 +14,19 @@
 #include "VTFFormat.h"
 #include "VTFDXTn.h"
 #include "VTFMathlib.h"
+#include "CRC32.h"
+#include "StatTimer.h"
+#include "Allocator.h"
+#include "VPKFile.h"
+
+#include <algorithm>
+#include <exception>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 // Note: VTF creation requires nvDXTLib and has been
 //       tested with version 8.31.1127.1645, availible here:
@@ -54,10 +67,84 @@
 #	pragma warning(default: 4267)
 #	pragma warning(default: 4244)
 #	pragma warning(default: 4018)
+
 #endif
 
 using namespace VTFLib;
 
+#define PARALLEL_ROWS_PER_THREAD	16		// Don't bother splitting up smaller images.
+
+//
+// ForEachRow()
+// Runs Proc over the rows [0, uiHeight), split into bands across the available cores.
+//
+static vlVoid ForEachRow(vlUInt uiHeight, const std::function<vlVoid(vlUInt, vlUInt)> &Proc)
+{
+	vlUInt uiThreads = std::thread::hardware_concurrency();
+	if(uiThreads > uiHeight / PARALLEL_ROWS_PER_THREAD)
+		uiThreads = uiHeight / PARALLEL_ROWS_PER_THREAD;
+
+	if(uiThreads <= 1)
+	{
+		Proc(0, uiHeight);
+		return;
+	}
+
+	// An exception must not leave a band's thread, or leave this function with
+	// threads still running, so the first one is kept until every band is done.
+	std::exception_ptr Exception;
+	std::mutex ExceptionMutex;
+
+	auto RunBand = [&](vlUInt uiStart, vlUInt uiEnd)
+	{
+		try
+		{
+			Proc(uiStart, uiEnd);
+		}
+		catch(...)
+		{
+			std::lock_guard<std::mutex> Lock(ExceptionMutex);
+			if(!Exception)
+				Exception = std::current_exception();
+		}
+	};
+
+	std::vector<std::thread> Threads;
+
+	vlUInt uiBand = (uiHeight + uiThreads - 1) / uiThreads;
+	vlUInt uiStart = uiBand;
+	try
+	{
+		Threads.reserve(uiThreads - 1);
+
+		for(; uiStart < uiHeight; uiStart += uiBand)
+		{
+			vlUInt uiEnd = uiStart + uiBand < uiHeight ? uiStart + uiBand : uiHeight;
+			Threads.push_back(std::thread(RunBand, uiStart, uiEnd));
+		}
+	}
+	catch(...)
+	{
+		// Out of threads, the bands not handed out run here.
+	}
+
+	RunBand(0, uiBand < uiHeight ? uiBand : uiHeight);
+	if(uiStart < uiHeight)
+	{
+		RunBand(uiStart, uiHeight);
+	}
+
+	for(std::vector<std::thread>::iterator i = Threads.begin(); i != Threads.end(); ++i)
+	{
+		(*i).join();
+	}
+
+	if(Exception)
+	{
+		std::rethrow_exception(Exception);
+	}
+}
+
 #ifdef USE_NVDXT
 struct SNVCompressionUserData
 {
@@ -73,19 +160,24 @@ public:
 
 public:
 	VTFImageFormat ImageFormat;
+	const SVTFLibOptions *lpOptions;
 
 public:
-	SNVCompressionUserData(vlVoid *lpData, VTFImageFormat ImageFormat) : lpData(lpData), pVTFFile(0), ImageFormat(ImageFormat)
+	SNVCompressionUserData(vlVoid *lpData, VTFImageFormat ImageFormat, const SVTFLibOptions &Options) : lpData(lpData), pVTFFile(0), ImageFormat(ImageFormat), lpOptions(&Options)
 	{
 
 	}
 
-	SNVCompressionUserData(CVTFFile *pVTFFile, vlUInt uiFrame, vlUInt uiFace, vlUInt uiSlice, VTFImageFormat ImageFormat) : lpData(0), pVTFFile(pVTFFile), uiFrame(uiFrame), uiFace(uiFace), uiSlice(uiSlice), ImageFormat(ImageFormat)
+	SNVCompressionUserData(CVTFFile *pVTFFile, vlUInt uiFrame, vlUInt uiFace, vlUInt uiSlice, VTFImageFormat ImageFormat, const SVTFLibOptions &Options) : lpData(0), pVTFFile(pVTFFile), uiFrame(uiFrame), uiFace(uiFace), uiSlice(uiSlice), ImageFormat(ImageFormat), lpOptions(&Options)
 	{
 
 	}
 };
 
+// nvDXTlib keeps internal state and is not reentrant, so only one thread may be
+// inside it at a time.  Recursive because NVWriteCallback() can convert data.
+static std::recursive_mutex NVDXTMutex;
+
 NV_ERROR_CODE NVWriteCallback(const void *buffer, size_t count, const MIPMapData *mipMapData, void *userData)
 {
 	if(!mipMapData)
@@ -110,7 +202,7 @@ NV_ERROR_CODE NVWriteCallback(const void *buffer, size_t count, const MIPMapData
 		{
 			assert(UserData->pVTFFile->GetFormat() != IMAGE_FORMAT_DXT1 && UserData->pVTFFile->GetFormat() != IMAGE_FORMAT_DXT1_ONEBITALPHA && UserData->pVTFFile->GetFormat() != IMAGE_FORMAT_DXT3 && UserData->pVTFFile->GetFormat() != IMAGE_FORMAT_DXT5);
 
-			CVTFFile::ConvertFromRGBA8888((vlByte *)buffer, UserData->pVTFFile->GetData(UserData->uiFrame, UserData->uiFace, UserData->uiSlice, (vlUInt)mipMapData->mipLevel), (vlUInt)mipMapData->width, (vlUInt)mipMapData->height, UserData->pVTFFile->GetFormat());
+			CVTFFile::ConvertFromRGBA8888((vlByte *)buffer, UserData->pVTFFile->GetData(UserData->uiFrame, UserData->uiFace, UserData->uiSlice, (vlUInt)mipMapData->mipLevel), (vlUInt)mipMapData->width, (vlUInt)mipMapData->height, UserData->pVTFFile->GetFormat(), *UserData->lpOptions);
 		}
 	}
 	// Set the image data of a pointer.
@@ -130,6 +222,8 @@ NV_ERROR_CODE NVWriteCallback(const void *buffer, size_t count, const MIPMapData
 
 vlBool nvDXTCompressWrapper(vlByte *lpImageDataRGBA, vlUInt uiWidth, vlUInt uiHeight, nvCompressionOptions *Options, DXTWriteCallback NVWriteCallback)
 {
+	std::lock_guard<std::recursive_mutex> Lock(NVDXTMutex);
+
 	// nvDXTcompressRGBA() seems unstable.  Maybe it is a problem with the options?
 	try
 	{
@@ -161,9 +255,13 @@ CVTFFile::CVTFFile()
 
 	this->uiImageBufferSize = 0;
 	this->lpImageData = 0;
+	this->pImageDataFree = 0;
+	this->pImageDataUserData = 0;
 
 	this->uiThumbnailBufferSize = 0;
 	this->lpThumbnailImageData = 0;
+
+	this->lpOptions = 0;
 }
 
 //
@@ -176,10 +274,15 @@ CVTFFile::CVTFFile(const CVTFFile &VTFFile)
 
 	this->uiImageBufferSize = 0;
 	this->lpImageData = 0;
+	this->pImageDataFree = 0;
+	this->pImageDataUserData = 0;
 
 	this->uiThumbnailBufferSize = 0;
 	this->lpThumbnailImageData = 0;
 
+	this->lpOptions = 0;
+	this->SetOptions(VTFFile.lpOptions);
+
 	if(VTFFile.IsLoaded())
 	{
 		this->Header = new SVTFHeader;
@@ -188,19 +291,50 @@ CVTFFile::CVTFFile(const CVTFFile &VTFFile)
 		if(VTFFile.GetHasImage())
 		{
 			this->uiImageBufferSize = VTFFile.uiImageBufferSize;
-			this->lpImageData = new vlByte[this->uiImageBufferSize];
+			this->lpImageData = Memory::AllocateImage(this->uiImageBufferSize);
 			memcpy(this->lpImageData, VTFFile.lpImageData, this->uiImageBufferSize);
 		}
 
 		if(VTFFile.GetHasThumbnail())
 		{
 			this->uiThumbnailBufferSize = VTFFile.uiThumbnailBufferSize;
-			this->lpThumbnailImageData = new vlByte[this->uiThumbnailBufferSize];
+			this->lpThumbnailImageData = Memory::AllocateImage(this->uiThumbnailBufferSize);
 			memcpy(this->lpThumbnailImageData, VTFFile.lpThumbnailImageData, this->uiThumbnailBufferSize);
 		}
 	}
 }
 
+//
+// CVTFFile()
+// Move constructor.  Takes VTFFile's buffers, leaving it empty.
+//
+CVTFFile::CVTFFile(CVTFFile &&VTFFile)
+{
+	this->Header = VTFFile.Header;
+
+	this->uiImageBufferSize = VTFFile.uiImageBufferSize;
+	this->lpImageData = VTFFile.lpImageData;
+	this->pImageDataFree = VTFFile.pImageDataFree;
+	this->pImageDataUserData = VTFFile.pImageDataUserData;
+
+	this->uiThumbnailBufferSize = VTFFile.uiThumbnailBufferSize;
+	this->lpThumbnailImageData = VTFFile.lpThumbnailImageData;
+
+	this->lpOptions = VTFFile.lpOptions;
+
+	VTFFile.Header = 0;
+
+	VTFFile.uiImageBufferSize = 0;
+	VTFFile.lpImageData = 0;
+	VTFFile.pImageDataFree = 0;
+	VTFFile.pImageDataUserData = 0;
+
+	VTFFile.uiThumbnailBufferSize = 0;
+	VTFFile.lpThumbnailImageData = 0;
+
+	VTFFile.lpOptions = 0;
+}
+
 //
 // CVTFFile()
 // Copy constructor.  Converts VTFFile to ImageFormat.
@@ -211,10 +345,15 @@ CVTFFile::CVTFFile(const CVTFFile &VTFFile, VTFImageFormat ImageFormat)
 
 	this->uiImageBufferSize = 0;
 	this->lpImageData = 0;
+	this->pImageDataFree = 0;
+	this->pImageDataUserData = 0;
 
 	this->uiThumbnailBufferSize = 0;
 	this->lpThumbnailImageData = 0;
 
+	this->lpOptions = 0;
+	this->SetOptions(VTFFile.lpOptions);
+
 	if(VTFFile.IsLoaded())
 	{
 		this->Header = new SVTFHeader;
@@ -263,10 +402,13 @@ CVTFFile::CVTFFile(const CVTFFile &VTFFile, VTFImageFormat ImageFormat)
 			vlUInt uiSlices = VTFFile.GetDepth();
 
 			this->uiImageBufferSize = this->ComputeImageSize(this->Header->Width, this->Header->Height, uiMipmaps, this->Header->ImageFormat) * uiFrames * uiFaces;
-			this->lpImageData = new vlByte[this->uiImageBufferSize];
+			this->lpImageData = Memory::AllocateImage(this->uiImageBufferSize);
 
 			//vlByte *lpImageData = new vlByte[this->ComputeImageSize(this->Header->Width, this->Header->Height, 1, IMAGE_FORMAT_RGBA8888)];
 
+			SVTFLibOptions VTFLibOptions;
+			this->ResolveOptions(VTFLibOptions);
+
 			for(vlUInt i = 0; i < uiFrames; i++)
 			{
 				for(vlUInt j = 0; j < uiFaces; j++)
@@ -280,7 +422,7 @@ CVTFFile::CVTFFile(const CVTFFile &VTFFile, VTFImageFormat ImageFormat)
 
 							//this->ConvertToRGBA8888(VTFFile.GetData(i, j, k, l), lpImageData, uiMipmapWidth, uiMipmapHeight, VTFFile.GetFormat());
 							//this->ConvertFromRGBA8888(lpImageData, this->GetData(i, j, k, l), uiMipmapWidth, uiMipmapHeight, this->GetFormat());
-							this->Convert(VTFFile.GetData(i, j, k, l), this->GetData(i, j, k, l), uiMipmapWidth, uiMipmapHeight, VTFFile.GetFormat(), this->GetFormat());
+							this->Convert(VTFFile.GetData(i, j, k, l), this->GetData(i, j, k, l), uiMipmapWidth, uiMipmapHeight, VTFFile.GetFormat(), this->GetFormat(), VTFLibOptions);
 						}
 					}
 				}
@@ -293,7 +435,7 @@ CVTFFile::CVTFFile(const CVTFFile &VTFFile, VTFImageFormat ImageFormat)
 		if(VTFFile.GetHasThumbnail())
 		{
 			this->uiThumbnailBufferSize = VTFFile.uiThumbnailBufferSize;
-			this->lpThumbnailImageData = new vlByte[this->uiThumbnailBufferSize];
+			this->lpThumbnailImageData = Memory::AllocateImage(this->uiThumbnailBufferSize);
 			memcpy(this->lpThumbnailImageData, VTFFile.lpThumbnailImageData, this->uiThumbnailBufferSize);
 		}
 	}
@@ -304,6 +446,48 @@ CVTFFile::CVTFFile(const CVTFFile &VTFFile, VTFImageFormat ImageFormat)
 CVTFFile::~CVTFFile()
 {
 	this->Destroy();
+
+	delete this->lpOptions;
+}
+
+//
+// operator=()
+// Move assignment.  Frees this file and takes VTFFile's buffers, leaving it empty.
+//
+CVTFFile &CVTFFile::operator=(CVTFFile &&VTFFile)
+{
+	if(this != &VTFFile)
+	{
+		this->Destroy();
+
+		delete this->lpOptions;
+
+		this->Header = VTFFile.Header;
+
+		this->uiImageBufferSize = VTFFile.uiImageBufferSize;
+		this->lpImageData = VTFFile.lpImageData;
+		this->pImageDataFree = VTFFile.pImageDataFree;
+		this->pImageDataUserData = VTFFile.pImageDataUserData;
+
+		this->uiThumbnailBufferSize = VTFFile.uiThumbnailBufferSize;
+		this->lpThumbnailImageData = VTFFile.lpThumbnailImageData;
+
+		this->lpOptions = VTFFile.lpOptions;
+
+		VTFFile.Header = 0;
+
+		VTFFile.uiImageBufferSize = 0;
+		VTFFile.lpImageData = 0;
+		VTFFile.pImageDataFree = 0;
+		VTFFile.pImageDataUserData = 0;
+
+		VTFFile.uiThumbnailBufferSize = 0;
+		VTFFile.lpThumbnailImageData = 0;
+
+		VTFFile.lpOptions = 0;
+	}
+
+	return *this;
 }
 
 //
@@ -313,6 +497,32 @@ CVTFFile::~CVTFFile()
 // generated.
 //
 vlBool CVTFFile::Create(vlUInt uiWidth, vlUInt uiHeight, vlUInt uiFrames, vlUInt uiFaces, vlUInt uiSlices, VTFImageFormat ImageFormat, vlBool bThumbnail, vlBool bMipmaps, vlBool bNullImageData)
+{
+	return this->CreateImage(uiWidth, uiHeight, uiFrames, uiFaces, uiSlices, ImageFormat, bThumbnail, bMipmaps, bNullImageData, 0, 0, 0, 0);
+}
+
+//
+// Create()
+// Creates a VTF file of the specified format and size that takes ownership of
+// image data already in the format and layout of the file.
+//
+vlBool CVTFFile::Create(vlUInt uiWidth, vlUInt uiHeight, vlUInt uiFrames, vlUInt uiFaces, vlUInt uiSlices, VTFImageFormat ImageFormat, vlBool bThumbnail, vlBool bMipmaps, vlByte *lpImageData, vlUInt uiImageDataSize, PFreeProc pFree, vlVoid *pUserData)
+{
+	if(lpImageData == 0 || pFree == 0)
+	{
+		LastError.Set("Image data and free proc must be set.");
+		return vlFalse;
+	}
+
+	return this->CreateImage(uiWidth, uiHeight, uiFrames, uiFaces, uiSlices, ImageFormat, bThumbnail, bMipmaps, vlFalse, lpImageData, uiImageDataSize, pFree, pUserData);
+}
+
+//
+// CreateImage()
+// Creates the header and buffers of a VTF file.  Uses lpImageData as the image
+// data if it is set, otherwise allocates it.
+//
+vlBool CVTFFile::CreateImage(vlUInt uiWidth, vlUInt uiHeight, vlUInt uiFrames, vlUInt uiFaces, vlUInt uiSlices, VTFImageFormat ImageFormat, vlBool bThumbnail, vlBool bMipmaps, vlBool bNullImageData, vlByte *lpImageData, vlUInt uiImageDataSize, PFreeProc pFree, vlVoid *pUserData)
 {
 	this->Destroy();
 
@@ -472,7 +682,7 @@ vlBool CVTFFile::Create(vlUInt uiWidth, vlUInt uiHeight, vlUInt uiFrames, vlUInt
 		this->Header->LowResImageHeight = (vlByte)uiThumbnailHeight;
 
 		this->uiThumbnailBufferSize = this->ComputeImageSize(this->Header->LowResImageWidth, this->Header->LowResImageHeight, 1, this->Header->LowResImageFormat);
-		this->lpThumbnailImageData = new vlByte[this->uiThumbnailBufferSize];
+		this->lpThumbnailImageData = Memory::AllocateImage(this->uiThumbnailBufferSize);
 
 		this->Header->Resources[this->Header->ResourceCount++].Type = VTF_LEGACY_RSRC_LOW_RES_IMAGE;
 	}
@@ -491,7 +701,25 @@ vlBool CVTFFile::Create(vlUInt uiWidth, vlUInt uiHeight, vlUInt uiFrames, vlUInt
 	//
 
 	this->uiImageBufferSize = this->ComputeImageSize(this->Header->Width, this->Header->Height, this->Header->Depth, this->Header->MipCount, this->Header->ImageFormat) * uiFrames * uiFaces;
-	this->lpImageData = new vlByte[this->uiImageBufferSize];
+
+	if(lpImageData != 0)
+	{
+		if(uiImageDataSize != this->uiImageBufferSize)
+		{
+			LastError.SetFormatted("Image data is %u bytes, expected %u.", uiImageDataSize, this->uiImageBufferSize);
+
+			this->Destroy();
+			return vlFalse;
+		}
+
+		this->lpImageData = lpImageData;
+		this->pImageDataFree = pFree;
+		this->pImageDataUserData = pUserData;
+	}
+	else
+	{
+		this->lpImageData = Memory::AllocateImage(this->uiImageBufferSize);
+	}
 
 	this->Header->Resources[this->Header->ResourceCount++].Type = VTF_LEGACY_RSRC_IMAGE;
 
@@ -529,6 +757,63 @@ vlBool CVTFFile::Create(vlUInt uiWidth, vlUInt uiHeight, vlByte *lpImageDataRGBA
 //
 vlBool CVTFFile::Create(vlUInt uiWidth, vlUInt uiHeight, vlUInt uiFrames, vlUInt uiFaces, vlUInt uiSlices, vlByte **lpImageDataRGBA8888, const SVTFCreateOptions &VTFCreateOptions)
 {
+	vlBool bAdopted;
+	return this->CreateImage(uiWidth, uiHeight, uiFrames, uiFaces, uiSlices, lpImageDataRGBA8888, 0, 0, 0, 0, bAdopted, VTFCreateOptions);
+}
+
+//
+// Create()
+// Creates a VTF file from RGBA data stored one image after another in a buffer
+// the file takes ownership of.  The buffer becomes the image data if it needs no
+// conversion, otherwise it is freed once the image is built.
+//
+vlBool CVTFFile::Create(vlUInt uiWidth, vlUInt uiHeight, vlUInt uiFrames, vlUInt uiFaces, vlUInt uiSlices, vlByte *lpImageDataRGBA8888, vlUInt uiImageDataSize, PFreeProc pFree, vlVoid *pUserData, const SVTFCreateOptions &VTFCreateOptions)
+{
+	if(lpImageDataRGBA8888 == 0 || pFree == 0)
+	{
+		LastError.Set("Image data and free proc must be set.");
+		return vlFalse;
+	}
+
+	vlUInt uiCount = uiFrames * uiFaces * uiSlices;
+	vlUInt uiImageSize = this->ComputeImageSize(uiWidth, uiHeight, 1, IMAGE_FORMAT_RGBA8888);
+
+	vlBool bResult = vlFalse;
+	vlBool bAdopted = vlFalse;
+
+	if(uiCount == 0 || uiImageSize == 0 || (vlUInt64)uiImageSize * uiCount > uiImageDataSize)
+	{
+		LastError.SetFormatted("Image data is %u bytes, expected at least %llu.", uiImageDataSize, (vlUInt64)uiImageSize * uiCount);
+	}
+	else
+	{
+		std::vector<vlByte *> ImageDataRGBA8888(uiCount);
+		for(vlUInt i = 0; i < uiCount; i++)
+		{
+			ImageDataRGBA8888[i] = lpImageDataRGBA8888 + (size_t)uiImageSize * i;
+		}
+
+		bResult = this->CreateImage(uiWidth, uiHeight, uiFrames, uiFaces, uiSlices, &ImageDataRGBA8888[0], lpImageDataRGBA8888, uiImageDataSize, pFree, pUserData, bAdopted, VTFCreateOptions);
+	}
+
+	if(!bAdopted)
+	{
+		pFree(lpImageDataRGBA8888, pUserData);
+	}
+
+	return bResult;
+}
+
+//
+// CreateImage()
+// Builds a VTF file from RGBA data.  If lpImageData is set and holds the images
+// in the layout the file needs, it is adopted as the image data and bAdopted is
+// set; the images are then processed in place.
+//
+vlBool CVTFFile::CreateImage(vlUInt uiWidth, vlUInt uiHeight, vlUInt uiFrames, vlUInt uiFaces, vlUInt uiSlices, vlByte **lpImageDataRGBA8888, vlByte *lpImageData, vlUInt uiImageDataSize, PFreeProc pFree, vlVoid *pUserData, vlBool &bAdopted, const SVTFCreateOptions &VTFCreateOptions)
+{
+	bAdopted = vlFalse;
+
 	vlUInt uiCount = 0;
 	if(uiFrames > uiCount)
 		uiCount = uiFrames;
@@ -536,7 +821,10 @@ vlBool CVTFFile::Create(vlUInt uiWidth, vlUInt uiHeight, vlUInt uiFrames, vlUInt
 		uiCount = uiFaces;
 	if(uiSlices > uiCount)
 		uiCount = uiSlices;
-	vlByte **lpNewImageDataRGBA8888 = 0;
+
+	// Resized input, all images in one scratch block.
+	Memory::CScratchBuffer NewImageData;
+	std::vector<vlByte *> NewImageDataRGBA8888;
 
 	if((uiFrames == 1 && uiFaces > 1 && uiSlices > 1) || (uiFrames > 1 && uiFaces == 1 && uiSlices > 1) || (uiFrames > 1 && uiFaces > 1 && uiSlices == 1))
 	{
@@ -568,6 +856,9 @@ vlBool CVTFFile::Create(vlUInt uiWidth, vlUInt uiHeight, vlUInt uiFrames, vlUInt
 		return vlFalse;
 	}
 
+	SVTFLibOptions VTFLibOptions;
+	this->ResolveOptions(VTFLibOptions);
+
 	try
 	{
 		if(VTFCreateOptions.bResize)
@@ -658,14 +949,15 @@ vlBool CVTFFile::Create(vlUInt uiWidth, vlUInt uiHeight, vlUInt uiFrames, vlUInt
 			// Resize the input.
 			if(uiWidth != uiNewWidth || uiHeight != uiNewHeight)
 			{
-				lpNewImageDataRGBA8888 = new vlByte *[uiCount];
-				memset(lpNewImageDataRGBA8888, 0, uiCount * sizeof(vlByte *));
+				vlUInt uiNewSize = this->ComputeImageSize(uiNewWidth, uiNewHeight, 1, IMAGE_FORMAT_RGBA8888);
+				NewImageData.Allocate((vlUInt64)uiNewSize * uiCount);
+				NewImageDataRGBA8888.resize(uiCount);
 
 				for(vlUInt i = 0; i < uiCount; i++)
 				{
-					lpNewImageDataRGBA8888[i] = new vlByte[this->ComputeImageSize(uiNewWidth, uiNewHeight, 1, IMAGE_FORMAT_RGBA8888)];
+					NewImageDataRGBA8888[i] = NewImageData.Get() + (size_t)uiNewSize * i;
 
-					if(!this->Resize(lpImageDataRGBA8888[i], lpNewImageDataRGBA8888[i], uiWidth, uiHeight, uiNewWidth, uiNewHeight, VTFCreateOptions.ResizeFilter, VTFCreateOptions.ResizeSharpenFilter))
+					if(!this->Resize(lpImageDataRGBA8888[i], NewImageDataRGBA8888[i], uiWidth, uiHeight, uiNewWidth, uiNewHeight, VTFCreateOptions.ResizeFilter, VTFCreateOptions.ResizeSharpenFilter, VTFLibOptions))
 					{
 						throw 0;
 					}
@@ -674,12 +966,26 @@ vlBool CVTFFile::Create(vlUInt uiWidth, vlUInt uiHeight, vlUInt uiFrames, vlUInt
 				uiWidth = uiNewWidth;
 				uiHeight = uiNewHeight;
 
-				lpImageDataRGBA8888 = lpNewImageDataRGBA8888;
+				lpImageDataRGBA8888 = &NewImageDataRGBA8888[0];
 			}
 		}
 
+		vlUInt uiCreateFaces = uiFaces + (VTFCreateOptions.bSphereMap && uiFaces == 6 ? 1 : 0);
+
+		// RGBA8888 data that wasn't re-sized and needs no mipmaps is already laid out
+		// as the image data, so the file takes it over instead of copying it.
+		if(lpImageData != 0 && lpImageDataRGBA8888[0] == lpImageData && VTFCreateOptions.ImageFormat == IMAGE_FORMAT_RGBA8888 && !VTFCreateOptions.bMipmaps
+			&& (vlUInt64)uiImageDataSize == (vlUInt64)this->ComputeImageSize(uiWidth, uiHeight, 1, IMAGE_FORMAT_RGBA8888) * uiFrames * uiCreateFaces * uiSlices)
+		{
+			if(!this->CreateImage(uiWidth, uiHeight, uiFrames, uiCreateFaces, uiSlices, VTFCreateOptions.ImageFormat, VTFCreateOptions.bThumbnail, vlFalse, vlFalse, lpImageData, uiImageDataSize, pFree, pUserData))
+			{
+				throw 0;
+			}
+
+			bAdopted = vlTrue;
+		}
 		// Create image (allocate and setup structures).
-		if(!this->Create(uiWidth, uiHeight, uiFrames, uiFaces + (VTFCreateOptions.bSphereMap && uiFaces == 6 ? 1 : 0), uiSlices, VTFCreateOptions.ImageFormat, VTFCreateOptions.bThumbnail, VTFCreateOptions.bMipmaps, vlFalse))
+		else if(!this->Create(uiWidth, uiHeight, uiFrames, uiCreateFaces, uiSlices, VTFCreateOptions.ImageFormat, VTFCreateOptions.bThumbnail, VTFCreateOptions.bMipmaps, vlFalse))
 		{
 			throw 0;
 		}
@@ -746,6 +1052,26 @@ vlBool CVTFFile::Create(vlUInt uiWidth, vlUInt uiHeight, vlUInt uiFrames, vlUInt
 			//delete []lpImageDataNormalMap;
 		}
 
+		// Reflectivity is gathered from each source image as it is encoded, rather
+		// than in a pass over the stored images afterwards.  The statistics are
+		// already spread across the cores by ForEachRow(), so they run on this
+		// thread just before the encode rather than on a thread of their own.
+		vlSingle sReflectivity[3] = { 0.0f, 0.0f, 0.0f };
+
+		auto AnalyseImage = [&](vlByte *lpSource)
+		{
+			if(!VTFCreateOptions.bReflectivity)
+				return;
+
+			SVTFImageStatistics Statistics;
+			if(CVTFFile::ComputeImageStatistics(lpSource, this->Header->Width, this->Header->Height, IMAGE_FORMAT_RGBA8888, Statistics, VTFLibOptions))
+			{
+				sReflectivity[0] += Statistics.sReflectivity[0];
+				sReflectivity[1] += Statistics.sReflectivity[1];
+				sReflectivity[2] += Statistics.sReflectivity[2];
+			}
+		};
+
 		// Generate mipmaps off source image.
 		if(VTFCreateOptions.bMipmaps && this->Header->MipCount != 1)
 		{
@@ -781,7 +1107,7 @@ vlBool CVTFFile::Create(vlUInt uiWidth, vlUInt uiHeight, vlUInt uiFrames, vlUInt
 					{
 						nvCompressionOptions Options = nvCompressionOptions();
 
-						SNVCompressionUserData UserData = SNVCompressionUserData(this, i, j, k, MipmapImageFormat);
+						SNVCompressionUserData UserData = SNVCompressionUserData(this, i, j, k, MipmapImageFormat, VTFLibOptions);
 
 						// Don't generate mipmaps.
 						Options.mipMapGeneration = kGenerateMipMaps;
@@ -797,15 +1123,15 @@ vlBool CVTFFile::Create(vlUInt uiWidth, vlUInt uiHeight, vlUInt uiFrames, vlUInt
 							{
 								Options.sharpening_passes_per_mip_level[l] = 1;
 							}
-							Options.unsharp_data.radius32F = sUnsharpenRadius;
-							Options.unsharp_data.amount32F = sUnsharpenAmount;
-							Options.unsharp_data.threshold32F = sUnsharpenThreshold;
-							Options.xsharp_data.strength32F = sXSharpenStrength;
-							Options.xsharp_data.threshold32F = sXSharpenThreshold;
+							Options.unsharp_data.radius32F = VTFLibOptions.sUnsharpenRadius;
+							Options.unsharp_data.amount32F = VTFLibOptions.sUnsharpenAmount;
+							Options.unsharp_data.threshold32F = VTFLibOptions.sUnsharpenThreshold;
+							Options.xsharp_data.strength32F = VTFLibOptions.sXSharpenStrength;
+							Options.xsharp_data.threshold32F = VTFLibOptions.sXSharpenThreshold;
 						}
 
 						// Set the format.
-						switch(uiDXTQuality)
+						switch(VTFLibOptions.uiDXTQuality)
 						{
 						case DXT_QUALITY_LOW:
 							Options.quality = kQualityFastest;
@@ -865,7 +1191,11 @@ vlBool CVTFFile::Create(vlUInt uiWidth, vlUInt uiHeight, vlUInt uiFrames, vlUInt
 						// The UserData struct gets passed to our callback.
 						Options.user_data = &UserData;
 
-						if(!nvDXTCompressWrapper(lpImageDataRGBA8888[i + j + k], this->Header->Width, this->Header->Height, &Options, NVWriteCallback))
+						AnalyseImage(lpImageDataRGBA8888[i + j + k]);
+
+						vlBool bResult = nvDXTCompressWrapper(lpImageDataRGBA8888[i + j + k], this->Header->Width, this->Header->Height, &Options, NVWriteCallback);
+
+						if(!bResult)
 						{
 							throw 0;
 						}
@@ -885,7 +1215,12 @@ vlBool CVTFFile::Create(vlUInt uiWidth, vlUInt uiHeight, vlUInt uiFrames, vlUInt
 				{
 					for(vlUInt k = 0; k < uiSlices; k++)
 					{
-						if(!this->ConvertFromRGBA8888(lpImageDataRGBA8888[i + j + k], this->GetData(i, j, k, 0), this->Header->Width, this->Header->Height, this->Header->ImageFormat))
+						AnalyseImage(lpImageDataRGBA8888[i + j + k]);
+
+						// Adopted data is already in place.
+						vlBool bResult = lpImageDataRGBA8888[i + j + k] == this->GetData(i, j, k, 0) || this->ConvertFromRGBA8888(lpImageDataRGBA8888[i + j + k], this->GetData(i, j, k, 0), this->Header->Width, this->Header->Height, this->Header->ImageFormat, VTFLibOptions);
+
+						if(!bResult)
 						{
 							throw 0;
 						}
@@ -913,31 +1248,11 @@ vlBool CVTFFile::Create(vlUInt uiWidth, vlUInt uiHeight, vlUInt uiFrames, vlUInt
 
 		if(VTFCreateOptions.bReflectivity)
 		{
-			this->Header->Reflectivity[0] = 0.0f;
-			this->Header->Reflectivity[1] = 0.0f;
-			this->Header->Reflectivity[2] = 0.0f;
-
-			for(vlUInt i = 0; i < uiFrames; i++)
-			{
-				for(vlUInt j = 0; j < uiFaces; j++)
-				{
-					for(vlUInt k = 0; k < uiSlices; k++)
-					{
-						vlSingle sX, sY, sZ;
-						this->ComputeImageReflectivity(lpImageDataRGBA8888[i + j + k], uiWidth, uiHeight, sX, sY, sZ);
-
-						this->Header->Reflectivity[0] += sX;
-						this->Header->Reflectivity[1] += sY;
-						this->Header->Reflectivity[2] += sZ;
-					}
-				}
-			}
-
 			vlSingle sInverse = 1.0f / (vlSingle)(uiFrames * uiFaces * uiSlices);
 
-			this->Header->Reflectivity[0] *= sInverse;
-			this->Header->Reflectivity[1] *= sInverse;
-			this->Header->Reflectivity[2] *= sInverse;
+			this->Header->Reflectivity[0] = sReflectivity[0] * sInverse;
+			this->Header->Reflectivity[1] = sReflectivity[1] * sInverse;
+			this->Header->Reflectivity[2] = sReflectivity[2] * sInverse;
 		}
 		else
 		{
@@ -959,15 +1274,6 @@ vlBool CVTFFile::Create(vlUInt uiWidth, vlUInt uiHeight, vlUInt uiFrames, vlUInt
 	}
 	catch(...)
 	{
-		if(lpNewImageDataRGBA8888 != 0)
-		{
-			for(vlUInt i = 0; i < uiCount; i++)
-			{
-				delete []lpNewImageDataRGBA8888[i];
-			}
-			delete []lpNewImageDataRGBA8888;
-		}
-
 		this->Destroy();
 
 		return vlFalse;
@@ -991,15 +1297,82 @@ vlVoid CVTFFile::Destroy()
 	delete this->Header;
 	this->Header = 0;
 
-	this->uiImageBufferSize = 0;
-	delete []this->lpImageData;
-	this->lpImageData= 0;
+	this->FreeImageData();
 
 	this->uiThumbnailBufferSize = 0;
-	delete []this->lpThumbnailImageData;
+	Memory::FreeImage(this->lpThumbnailImageData);
 	this->lpThumbnailImageData = 0;
 }
 
+//
+// FreeImageData()
+// Frees the image data with the caller's free proc if it was adopted.
+//
+vlVoid CVTFFile::FreeImageData()
+{
+	if(this->pImageDataFree != 0)
+	{
+		this->pImageDataFree(this->lpImageData, this->pImageDataUserData);
+	}
+	else
+	{
+		Memory::FreeImage(this->lpImageData);
+	}
+
+	this->uiImageBufferSize = 0;
+	this->lpImageData = 0;
+	this->pImageDataFree = 0;
+	this->pImageDataUserData = 0;
+}
+
+//
+// GetOptions()
+// Gets the image's own options, null if it uses the process wide options.
+//
+const SVTFLibOptions *CVTFFile::GetOptions() const
+{
+	return this->lpOptions;
+}
+
+//
+// SetOptions()
+// Gives the image its own copy of the options, or pass null to use the process
+// wide options again.
+//
+vlVoid CVTFFile::SetOptions(const SVTFLibOptions *Options)
+{
+	if(Options == 0)
+	{
+		delete this->lpOptions;
+		this->lpOptions = 0;
+		return;
+	}
+
+	if(this->lpOptions == 0)
+	{
+		this->lpOptions = new SVTFLibOptions;
+	}
+
+	*this->lpOptions = *Options;
+}
+
+//
+// ResolveOptions()
+// Copies the options in effect for this image.  Processing functions take a copy up
+// front so other threads changing the process wide options can't affect them midway.
+//
+vlVoid CVTFFile::ResolveOptions(SVTFLibOptions &Options) const
+{
+	if(this->lpOptions != 0)
+	{
+		Options = *this->lpOptions;
+	}
+	else
+	{
+		VTFLib::GetOptions(Options);
+	}
+}
+
 vlBool CVTFFile::IsPowerOfTwo(vlUInt uiSize)
 {
 	return uiSize > 0 && (uiSize & (uiSize - 1)) == 0;
@@ -1040,30 +1413,93 @@ vlBool CVTFFile::IsLoaded() const
 
 vlBool CVTFFile::Load(const vlChar *cFileName, vlBool bHeaderOnly)
 {
-	auto r = IO::Readers::CFileReader(cFileName);
-	return this->Load(&r, bHeaderOnly);
+	Diagnostics::CStatTimer Timer(VTFLIB_STAT_LOAD_FILE);
+
+	IO::Readers::CFileReader FileReader(cFileName);
+
+	// A header only load reads a few hundred bytes; don't read ahead for it.
+	vlBool bResult;
+	if(bHeaderOnly)
+	{
+		bResult = this->Load(&FileReader, bHeaderOnly);
+	}
+	else
+	{
+		IO::Readers::CBufferedReader Reader(&FileReader);
+		bResult = this->Load(&Reader, bHeaderOnly);
+	}
+
+	if(bResult && !bHeaderOnly && Timer.Active())
+		Timer.SetBytes(this->GetSize());
+
+	return bResult;
 }
 
 vlBool CVTFFile::Load(const vlVoid *lpData, vlUInt uiBufferSize, vlBool bHeaderOnly)
 {
+	Diagnostics::CStatTimer Timer(VTFLIB_STAT_LOAD_MEMORY, bHeaderOnly ? 0 : uiBufferSize);
+
 	auto r = IO::Readers::CMemoryReader(lpData, uiBufferSize);
 	return this->Load(&r, bHeaderOnly);
 }
 
 vlBool CVTFFile::Load(vlVoid *pUserData, vlBool bHeaderOnly)
 {
+	Diagnostics::CStatTimer Timer(VTFLIB_STAT_LOAD_PROC);
+
 	auto r = IO::Readers::CProcReader(pUserData);
-	return this->Load(&r, bHeaderOnly);
+	vlBool bResult = this->Load(&r, bHeaderOnly);
+
+	if(bResult && !bHeaderOnly && Timer.Active())
+		Timer.SetBytes(this->GetSize());
+
+	return bResult;
+}
+
+vlBool CVTFFile::Load(const CVPKFile &Package, const vlChar *cPath, vlBool bHeaderOnly)
+{
+	Diagnostics::CStatTimer Timer(VTFLIB_STAT_LOAD_PACKAGE);
+
+	vlUInt uiEntry = Package.FindEntry(cPath);
+	if(uiEntry == VPK_INVALID_INDEX)
+	{
+		this->Destroy();
+
+		LastError.SetFormatted("%s is not in the package.", cPath);
+		return vlFalse;
+	}
+
+	auto r = IO::Readers::CVPKReader(Package, uiEntry);
+	vlBool bResult = this->Load(&r, bHeaderOnly);
+
+	if(bResult && !bHeaderOnly && Timer.Active())
+		Timer.SetBytes(this->GetSize());
+
+	return bResult;
 }
 
 vlBool CVTFFile::Save(const vlChar *cFileName) const
 {
-	auto r = IO::Writers::CFileWriter(cFileName);
-	return this->Save(&r);
+	Diagnostics::CStatTimer Timer(VTFLIB_STAT_SAVE_FILE);
+
+	// The header, thumbnail and image are known up front; resources come on top.
+	vlUInt uiSizeHint = this->IsLoaded() ? this->Header->HeaderSize + this->uiThumbnailBufferSize + this->uiImageBufferSize : 0;
+
+	IO::Writers::CFileWriter FileWriter(cFileName, uiSizeHint);
+	IO::Writers::CBufferedWriter Writer(&FileWriter);
+
+	vlBool bResult = this->Save(&Writer) && Writer.Flush();
+
+	if(bResult && Timer.Active())
+		Timer.SetBytes(this->GetSize());
+
+	return bResult;
 }
 
 vlBool CVTFFile::Save(vlVoid *lpData, vlUInt uiBufferSize, vlUInt &uiSize) const
 {
+	Diagnostics::CStatTimer Timer(VTFLIB_STAT_SAVE_MEMORY);
+
 	uiSize = 0;
 
 	IO::Writers::CMemoryWriter MemoryWriter = IO::Writers::CMemoryWriter(lpData, uiBufferSize);
@@ -1071,202 +1507,403 @@ vlBool CVTFFile::Save(vlVoid *lpData, vlUInt uiBufferSize, vlUInt &uiSize) const
 	vlBool bResult = this->Save(&MemoryWriter);
 
 	uiSize = MemoryWriter.GetStreamSize();
+	Timer.SetBytes(uiSize);
 
 	return bResult;
 }
 
 vlBool CVTFFile::Save(vlVoid *pUserData) const
 {
+	Diagnostics::CStatTimer Timer(VTFLIB_STAT_SAVE_PROC);
+
 	auto r = IO::Writers::CProcWriter(pUserData);
-	return this->Save(&r);
+	vlBool bResult = this->Save(&r);
+
+	if(bResult && Timer.Active())
+		Timer.SetBytes(this->GetSize());
+
+	return bResult;
 }
 
-// -----------------------------------------------------------------------------------
-// vlBool Load(IO::Readers::IReader *Reader, vlBool bHeaderOnly)
 //
-// Loads a VTF file from a stream into memory.
-// Reader - The stream to read from.
-// bHeaderOnly - only read in the header if true (dont allocate and read image data in)
-// ------------------------------------------------------------------------------------
-vlBool CVTFFile::Load(IO::Readers::IReader *Reader, vlBool bHeaderOnly)
+// ReadHeader()
+// Reads and validates the header and resource directory of an open stream.
+// Resource data chunks are not read.
+//
+vlBool CVTFFile::ReadHeader(IO::Readers::IReader *Reader, SVTFHeader &Header)
 {
-	this->Destroy();
+	memset(&Header, 0, sizeof(SVTFHeader));
 
-	try
-	{
-		if(!Reader->Open())
-			throw 0;
+	// Get the size of the .vtf file.
+	vlUInt uiFileSize = Reader->GetStreamSize();
 
-		// Get the size of the .vtf file.
-		vlUInt uiFileSize = Reader->GetStreamSize();
+	// Check we at least have enough bytes for a header.
+	if(uiFileSize < sizeof(SVTFFileHeader))
+	{
+		LastError.Set("File is corrupt; file to small for it's header.");
+		return vlFalse;
+	}
 
-		// Check we at least have enough bytes for a header.
-		if(uiFileSize < sizeof(SVTFFileHeader))
-		{
-			LastError.Set("File is corrupt; file to small for it's header.");
-			throw 0;
-		}
+	SVTFFileHeader FileHeader;
 
-		SVTFFileHeader FileHeader;
+	// read the file header
+	memset(&FileHeader, 0, sizeof(SVTFFileHeader));
+	if(Reader->Read(&FileHeader, sizeof(SVTFFileHeader)) != sizeof(SVTFFileHeader))
+	{
+		return vlFalse;
+	}
 
-		// read the file header
-		memset(&FileHeader, 0, sizeof(SVTFFileHeader));
-		if(Reader->Read(&FileHeader, sizeof(SVTFFileHeader)) != sizeof(SVTFFileHeader))
-		{
-			throw 0;
-		}
+	if(memcmp(FileHeader.TypeString, "VTF\0", 4) != 0)
+	{
+		LastError.Set("File signature does not match 'VTF'.");
+		return vlFalse;
+	}
 
-		if(memcmp(FileHeader.TypeString, "VTF\0", 4) != 0)
-		{
-			LastError.Set("File signature does not match 'VTF'.");
-			throw 0;
-		}
+	if(FileHeader.Version[0] != VTF_MAJOR_VERSION || (FileHeader.Version[1] < 0 || FileHeader.Version[1] > VTF_MINOR_VERSION))
+	{
+		LastError.SetFormatted("File version %u.%u does not match %d.%d to %d.%d.", FileHeader.Version[0], FileHeader.Version[1], VTF_MAJOR_VERSION, 0, VTF_MAJOR_VERSION, VTF_MINOR_VERSION);
+		return vlFalse;
+	}
 
-		if(FileHeader.Version[0] != VTF_MAJOR_VERSION || (FileHeader.Version[1] < 0 || FileHeader.Version[1] > VTF_MINOR_VERSION))
-		{
-			LastError.SetFormatted("File version %u.%u does not match %d.%d to %d.%d.", FileHeader.Version[0], FileHeader.Version[1], VTF_MAJOR_VERSION, 0, VTF_MAJOR_VERSION, VTF_MINOR_VERSION);
-			throw 0;
-		}
+	if(FileHeader.HeaderSize > sizeof(SVTFHeader))
+	{
+		LastError.SetFormatted("File header size %d B is larger than the %d B maximum expected.", FileHeader.HeaderSize, sizeof(SVTFHeader));
+		return vlFalse;
+	}
 
-		if(FileHeader.HeaderSize > sizeof(SVTFHeader))
-		{
-			LastError.SetFormatted("File header size %d B is larger than the %d B maximum expected.", FileHeader.HeaderSize, sizeof(SVTFHeader));
-			throw 0;
-		}
+	Reader->Seek(0, FILE_BEGIN);
 
-		Reader->Seek(0, FILE_BEGIN);
+	// read the header
+	if(Reader->Read(&Header, FileHeader.HeaderSize) != FileHeader.HeaderSize)
+	{
+		return vlFalse;
+	}
 
-		this->Header = new SVTFHeader;
-		memset(this->Header, 0, sizeof(SVTFHeader));
+	if(Header.Version[0] < VTF_MAJOR_VERSION || (Header.Version[0] == VTF_MAJOR_VERSION && Header.Version[1] < VTF_MINOR_VERSION_MIN_VOLUME))
+	{
+		// set depth if version is lower than 7.2
+		Header.Depth = 1;
+	}
 
-		// read the header
-		if(Reader->Read(this->Header, FileHeader.HeaderSize) != FileHeader.HeaderSize)
-		{
-			throw 0;
-		}
+	if(!(Header.Version[0] > VTF_MAJOR_VERSION || (Header.Version[0] == VTF_MAJOR_VERSION && Header.Version[1] >= VTF_MINOR_VERSION_MIN_RESOURCE)))
+	{
+		// set resource count if version is lower than 7.3
+		Header.ResourceCount = 0;
+	}
 
-		if(this->Header->Version[0] < VTF_MAJOR_VERSION || (this->Header->Version[0] == VTF_MAJOR_VERSION && this->Header->Version[1] < VTF_MINOR_VERSION_MIN_VOLUME))
-		{
-			// set depth if version is lower than 7.2
-			this->Header->Depth = 1;
-		}
+	if(Header.ResourceCount > VTF_RSRC_MAX_DICTIONARY_ENTRIES)
+	{
+		LastError.SetFormatted("File may be corrupt; directory length %u exceeds maximum dictionary length of %u.", Header.ResourceCount, VTF_RSRC_MAX_DICTIONARY_ENTRIES);
+		return vlFalse;
+	}
 
-		if(!this->GetSupportsResources())
-		{
-			// set resource count if version is lower than 7.3
-			this->Header->ResourceCount = 0;
-		}
+	return vlTrue;
+}
 
-		// if we just want the header loaded, bail here
-		if(bHeaderOnly)
-		{
-			Reader->Close();
-			return vlTrue;
-		}
+//
+// ReadLayout()
+// Finds and checks the size and position of the thumbnail, image and resource data
+// of a header read by ReadHeader().  The sizes of resource data chunks are read into
+// the header but not the data itself.
+//
+vlBool CVTFFile::ReadLayout(IO::Readers::IReader *Reader, SVTFHeader &Header, vlUInt &uiThumbnailOffset, vlUInt &uiThumbnailSize, vlUInt &uiImageOffset, vlUInt &uiImageSize)
+{
+	vlUInt uiFileSize = Reader->GetStreamSize();
 
-		// work out how big out buffers need to be
-		this->uiImageBufferSize = this->ComputeImageSize(this->Header->Width, this->Header->Height, this->Header->Depth, this->Header->MipCount, this->Header->ImageFormat) * this->GetFaceCount() * this->GetFrameCount();
+	// work out how big out buffers need to be
+	uiImageSize = ComputeImageSize(Header.Width, Header.Height, Header.Depth, Header.MipCount, Header.ImageFormat) * ComputeFaceCount(Header) * Header.Frames;
 
-		if(this->Header->LowResImageFormat != IMAGE_FORMAT_NONE)
-		{
-			this->uiThumbnailBufferSize = this->ComputeImageSize(this->Header->LowResImageWidth, this->Header->LowResImageHeight, 1, this->Header->LowResImageFormat);
-		}
-		else
-		{
-			this->uiThumbnailBufferSize = 0;
-		}
+	if(Header.LowResImageFormat != IMAGE_FORMAT_NONE)
+	{
+		uiThumbnailSize = ComputeImageSize(Header.LowResImageWidth, Header.LowResImageHeight, 1, Header.LowResImageFormat);
+	}
+	else
+	{
+		uiThumbnailSize = 0;
+	}
 
-		// read the resource directory if version > 7.3
-		vlUInt uiThumbnailBufferOffset = 0, uiImageDataOffset = 0;
-		if(this->Header->ResourceCount)
+	// read the resource directory if version > 7.3
+	uiThumbnailOffset = 0;
+	uiImageOffset = 0;
+	if(Header.ResourceCount)
+	{
+		for(vlUInt i = 0; i < Header.ResourceCount; i++)
 		{
-			if(this->Header->ResourceCount > VTF_RSRC_MAX_DICTIONARY_ENTRIES)
-			{
-				LastError.SetFormatted("File may be corrupt; directory length %u exceeds maximum dictionary length of %u.", this->Header->ResourceCount, VTF_RSRC_MAX_DICTIONARY_ENTRIES);
-				throw 0;
-			}
-
-			for(vlUInt i = 0; i < this->Header->ResourceCount; i++)
+			switch(Header.Resources[i].Type)
 			{
-				switch(this->Header->Resources[i].Type)
+			case VTF_LEGACY_RSRC_LOW_RES_IMAGE:
+				if(Header.LowResImageFormat == IMAGE_FORMAT_NONE)
 				{
-				case VTF_LEGACY_RSRC_LOW_RES_IMAGE:
-					if(this->Header->LowResImageFormat == IMAGE_FORMAT_NONE)
+					LastError.Set("File may be corrupt; unexpected low resolution image directory entry.");
+					return vlFalse;
+				}
+				if(uiThumbnailOffset != 0)
+				{
+					LastError.Set("File may be corrupt; multiple low resolution image directory entries.");
+					return vlFalse;
+				}
+				uiThumbnailOffset = Header.Resources[i].Data;
+				break;
+			case VTF_LEGACY_RSRC_IMAGE:
+				if(uiImageOffset != 0)
+				{
+					LastError.Set("File may be corrupt; multiple image directory entries.");
+					return vlFalse;
+				}
+				uiImageOffset = Header.Resources[i].Data;
+				break;
+			default:
+				if((Header.Resources[i].Flags & RSRCF_HAS_NO_DATA_CHUNK) == 0)
+				{
+					if(Header.Resources[i].Data + sizeof(vlUInt) > uiFileSize)
 					{
-						LastError.Set("File may be corrupt; unexpected low resolution image directory entry.");
-						throw 0;
+						LastError.Set("File may be corrupt; file to small for it's resource data.");
+						return vlFalse;
 					}
-					if(uiThumbnailBufferOffset != 0)
+
+					vlUInt uiSize = 0;
+					Reader->Seek(Header.Resources[i].Data, FILE_BEGIN);
+					if(Reader->Read(&uiSize, sizeof(vlUInt)) != sizeof(vlUInt))
 					{
-						LastError.Set("File may be corrupt; multiple low resolution image directory entries.");
-						throw 0;
+						return vlFalse;
 					}
-					uiThumbnailBufferOffset = this->Header->Resources[i].Data;
-					break;
-				case VTF_LEGACY_RSRC_IMAGE:
-					if(uiImageDataOffset != 0)
+
+					if(Header.Resources[i].Data + sizeof(vlUInt) + uiSize > uiFileSize)
 					{
-						LastError.Set("File may be corrupt; multiple image directory entries.");
-						throw 0;
+						LastError.Set("File may be corrupt; file to small for it's resource data.");
+						return vlFalse;
 					}
-					uiImageDataOffset = this->Header->Resources[i].Data;
-					break;
-				default:
-					if((this->Header->Resources[i].Flags & RSRCF_HAS_NO_DATA_CHUNK) == 0)
-					{
-						if(this->Header->Resources[i].Data + sizeof(vlUInt) > uiFileSize)
-						{
-							LastError.Set("File may be corrupt; file to small for it's resource data.");
-							throw 0;
-						}
 
-						vlUInt uiSize = 0;
-						Reader->Seek(this->Header->Resources[i].Data, FILE_BEGIN);
-						if(Reader->Read(&uiSize, sizeof(vlUInt)) != sizeof(vlUInt))
-						{
-							throw 0;
-						}
+					Header.Data[i].Size = uiSize;
+				}
+				break;
+			}
+		}
+	}
+	else
+	{
+		uiThumbnailOffset = Header.HeaderSize;
+		uiImageOffset = uiThumbnailOffset + uiThumbnailSize;
+	}
 
-						if(this->Header->Resources[i].Data + sizeof(vlUInt) + uiSize > uiFileSize)
-						{
-							LastError.Set("File may be corrupt; file to small for it's resource data.");
-							throw 0;
-						}
+	// sanity check
+	// headersize + lowbuffersize + buffersize *should* equal the filesize
+	if(Header.HeaderSize > uiFileSize || uiThumbnailOffset + uiThumbnailSize > uiFileSize || uiImageOffset + uiImageSize > uiFileSize)
+	{
+		LastError.Set("File may be corrupt; file to small for it's image data.");
+		return vlFalse;
+	}
 
-						this->Header->Data[i].Size = uiSize;
-						this->Header->Data[i].Data = new vlByte[uiSize];
-						if(Reader->Read(this->Header->Data[i].Data, uiSize) != uiSize)
-						{
-							throw 0;
-						}
-					}
+	if(uiThumbnailOffset == 0)
+	{
+		Header.LowResImageFormat = IMAGE_FORMAT_NONE;
+	}
+
+	if(uiImageOffset == 0)
+	{
+		Header.ImageFormat = IMAGE_FORMAT_NONE;
+	}
+
+	return vlTrue;
+}
+
+vlBool CVTFFile::LoadHeaderInfo(const vlChar *cFileName, SVTFHeaderInfo &HeaderInfo)
+{
+	auto r = IO::Readers::CFileReader(cFileName);
+	return LoadHeaderInfo(&r, HeaderInfo);
+}
+
+vlBool CVTFFile::LoadHeaderInfo(const vlVoid *lpData, vlUInt uiBufferSize, SVTFHeaderInfo &HeaderInfo)
+{
+	auto r = IO::Readers::CMemoryReader(lpData, uiBufferSize);
+	return LoadHeaderInfo(&r, HeaderInfo);
+}
+
+//
+// LoadHeaderInfo()
+// Reads just the header and resource directory of a VTF file into a flat struct.
+// Nothing is allocated so this can be run over many files at once.
+//
+vlBool CVTFFile::LoadHeaderInfo(IO::Readers::IReader *Reader, SVTFHeaderInfo &HeaderInfo)
+{
+	memset(&HeaderInfo, 0, sizeof(SVTFHeaderInfo));
+
+	if(!Reader->Open())
+		return vlFalse;
+
+	SVTFHeader Header;
+	vlBool bResult = ReadHeader(Reader, Header);
+
+	HeaderInfo.uiFileSize = Reader->GetStreamSize();
+
+	Reader->Close();
+
+	if(!bResult)
+		return vlFalse;
+
+	HeaderInfo.uiVersion[0] = Header.Version[0];
+	HeaderInfo.uiVersion[1] = Header.Version[1];
+	HeaderInfo.uiHeaderSize = Header.HeaderSize;
+
+	HeaderInfo.uiWidth = Header.Width;
+	HeaderInfo.uiHeight = Header.Height;
+	HeaderInfo.uiDepth = Header.Depth;
+	HeaderInfo.uiFrameCount = Header.Frames;
+	HeaderInfo.uiStartFrame = Header.StartFrame;
+	HeaderInfo.uiFaceCount = ComputeFaceCount(Header);
+	HeaderInfo.uiMipmapCount = Header.MipCount;
+	HeaderInfo.uiFlags = Header.Flags;
+	HeaderInfo.ImageFormat = Header.ImageFormat;
+
+	HeaderInfo.ThumbnailFormat = Header.LowResImageFormat;
+	HeaderInfo.uiThumbnailWidth = Header.LowResImageWidth;
+	HeaderInfo.uiThumbnailHeight = Header.LowResImageHeight;
+
+	HeaderInfo.sReflectivity[0] = Header.Reflectivity[0];
+	HeaderInfo.sReflectivity[1] = Header.Reflectivity[1];
+	HeaderInfo.sReflectivity[2] = Header.Reflectivity[2];
+	HeaderInfo.sBumpScale = Header.BumpScale;
+
+	HeaderInfo.uiResourceCount = Header.ResourceCount;
+	for(vlUInt i = 0; i < Header.ResourceCount; i++)
+	{
+		HeaderInfo.uiResourceTypes[i] = Header.Resources[i].Type;
+		HeaderInfo.uiResourceData[i] = Header.Resources[i].Data;
+	}
+
+	return vlTrue;
+}
+
+vlBool CVTFFile::Verify(const vlChar *cFileName, vlBool &bHasCRC)
+{
+	auto r = IO::Readers::CFileReader(cFileName);
+	return Verify(&r, bHasCRC);
+}
+
+vlBool CVTFFile::Verify(const vlVoid *lpData, vlUInt uiBufferSize, vlBool &bHasCRC)
+{
+	auto r = IO::Readers::CMemoryReader(lpData, uiBufferSize);
+	return Verify(&r, bHasCRC);
+}
+
+#define VERIFY_BUFFER_SIZE	(1024 * 1024)
+
+//
+// Verify()
+// Runs the checks Load() does and checks the image data against its CRC resource,
+// streaming the image data through a small buffer instead of loading it.
+//
+vlBool CVTFFile::Verify(IO::Readers::IReader *Reader, vlBool &bHasCRC)
+{
+	bHasCRC = vlFalse;
+
+	if(!Reader->Open())
+		return vlFalse;
+
+	vlBool bResult = vlFalse;
+	SVTFHeader Header;
+	vlUInt uiThumbnailOffset, uiThumbnailSize, uiImageOffset, uiImageSize;
+	if(ReadHeader(Reader, Header) && ReadLayout(Reader, Header, uiThumbnailOffset, uiThumbnailSize, uiImageOffset, uiImageSize))
+	{
+		bResult = vlTrue;
+
+		for(vlUInt i = 0; i < Header.ResourceCount; i++)
+		{
+			if(Header.Resources[i].Type != VTF_RSRC_IMAGE_CRC)
+				continue;
+
+			bHasCRC = vlTrue;
+
+			std::vector<vlByte> Buffer(VERIFY_BUFFER_SIZE);
+
+			vlUInt uiCRC = 0;
+			Reader->Seek(uiImageOffset, FILE_BEGIN);
+			for(vlUInt uiDone = 0; uiDone < uiImageSize && bResult; )
+			{
+				vlUInt uiBytes = uiImageSize - uiDone < VERIFY_BUFFER_SIZE ? uiImageSize - uiDone : VERIFY_BUFFER_SIZE;
+				if(Reader->Read(&Buffer[0], uiBytes) != uiBytes)
+				{
+					bResult = vlFalse;
 					break;
 				}
+
+				uiCRC = Checksum::CRC32(&Buffer[0], uiBytes, uiCRC);
+				uiDone += uiBytes;
+			}
+
+			if(bResult && uiCRC != Header.Resources[i].Data)
+			{
+				LastError.SetFormatted("File is corrupt; image data CRC %.8x does not match %.8x.", uiCRC, Header.Resources[i].Data);
+				bResult = vlFalse;
 			}
+			break;
 		}
-		else
+	}
+
+	Reader->Close();
+
+	return bResult;
+}
+
+// -----------------------------------------------------------------------------------
+// vlBool Load(IO::Readers::IReader *Reader, vlBool bHeaderOnly)
+//
+// Loads a VTF file from a stream into memory.
+// Reader - The stream to read from.
+// bHeaderOnly - only read in the header if true (dont allocate and read image data in)
+// ------------------------------------------------------------------------------------
+vlBool CVTFFile::Load(IO::Readers::IReader *Reader, vlBool bHeaderOnly)
+{
+	this->Destroy();
+
+	try
+	{
+		if(!Reader->Open())
+			throw 0;
+
+		this->Header = new SVTFHeader;
+
+		if(!ReadHeader(Reader, *this->Header))
+			throw 0;
+
+		// if we just want the header loaded, bail here
+		if(bHeaderOnly)
 		{
-			uiThumbnailBufferOffset = this->Header->HeaderSize;
-			uiImageDataOffset = uiThumbnailBufferOffset + this->uiThumbnailBufferSize;
+			Reader->Close();
+			return vlTrue;
 		}
-		
-		// sanity check
-		// headersize + lowbuffersize + buffersize *should* equal the filesize
-		if(this->Header->HeaderSize > uiFileSize || uiThumbnailBufferOffset + this->uiThumbnailBufferSize > uiFileSize || uiImageDataOffset + this->uiImageBufferSize > uiFileSize)
-		{
-			LastError.Set("File may be corrupt; file to small for it's image data.");
+
+		vlUInt uiThumbnailBufferOffset, uiImageDataOffset;
+		if(!ReadLayout(Reader, *this->Header, uiThumbnailBufferOffset, this->uiThumbnailBufferSize, uiImageDataOffset, this->uiImageBufferSize))
 			throw 0;
-		}
 
-		if(uiThumbnailBufferOffset == 0)
+		// read the resource data chunks
+		for(vlUInt i = 0; i < this->Header->ResourceCount; i++)
 		{
-			this->Header->LowResImageFormat = IMAGE_FORMAT_NONE;
+			switch(this->Header->Resources[i].Type)
+			{
+			case VTF_LEGACY_RSRC_LOW_RES_IMAGE:
+			case VTF_LEGACY_RSRC_IMAGE:
+				break;
+			default:
+				if((this->Header->Resources[i].Flags & RSRCF_HAS_NO_DATA_CHUNK) == 0)
+				{
+					this->Header->Data[i].Data = new vlByte[this->Header->Data[i].Size];
+
+					Reader->Seek(this->Header->Resources[i].Data + sizeof(vlUInt), FILE_BEGIN);
+					if(Reader->Read(this->Header->Data[i].Data, this->Header->Data[i].Size) != this->Header->Data[i].Size)
+					{
+						throw 0;
+					}
+				}
+				break;
+			}
 		}
 
 		// assuming all is well, size our data buffers
 		if(this->Header->LowResImageFormat != IMAGE_FORMAT_NONE)
 		{
-			this->lpThumbnailImageData = new vlByte[this->uiThumbnailBufferSize];
+			this->lpThumbnailImageData = Memory::AllocateImage(this->uiThumbnailBufferSize);
 
 			// load the low res data
 			Reader->Seek(uiThumbnailBufferOffset, FILE_BEGIN);
@@ -1276,14 +1913,9 @@ vlBool CVTFFile::Load(IO::Readers::IReader *Reader, vlBool bHeaderOnly)
 			}
 		}
 
-		if(uiImageDataOffset == 0)
-		{
-			this->Header->ImageFormat = IMAGE_FORMAT_NONE;
-		}
-
 		if(this->Header->ImageFormat != IMAGE_FORMAT_NONE)
 		{
-			this->lpImageData = new vlByte[this->uiImageBufferSize];
+			this->lpImageData = Memory::AllocateImage(this->uiImageBufferSize);
 
 			// load the high-res data
 			Reader->Seek(uiImageDataOffset, FILE_BEGIN);
@@ -1325,22 +1957,61 @@ vlBool CVTFFile::Save(IO::Writers::IWriter *Writer) const
 	// ToDo: Check if the image buffer is ok.
 	//       Check flags and other header values.
 
-	try
+	// An image CRC is kept up to date if the file has one and added if asked for.
+	// It goes on a copy of the header so saving leaves the image untouched.
+	SVTFHeader *Header = this->Header;
+	SVTFHeader CRCHeader;
+	if(this->GetSupportsResources())
 	{
-		if(!Writer->Open())
-			throw 0;
+		SVTFLibOptions Options;
+		this->ResolveOptions(Options);
+
+		vlUInt uiIndex = 0;
+		while(uiIndex < this->Header->ResourceCount && this->Header->Resources[uiIndex].Type != VTF_RSRC_IMAGE_CRC)
+			uiIndex++;
+
+		if((uiIndex < this->Header->ResourceCount || Options.bWriteCRC) && uiIndex < VTF_RSRC_MAX_DICTIONARY_ENTRIES)
+		{
+			memcpy(&CRCHeader, this->Header, sizeof(SVTFHeader));
+
+			if(uiIndex == CRCHeader.ResourceCount)
+			{
+				// The directory grows by one entry which moves all the data down.
+				for(vlUInt i = 0; i < CRCHeader.ResourceCount; i++)
+				{
+					if(CRCHeader.Resources[i].Type == VTF_LEGACY_RSRC_LOW_RES_IMAGE || CRCHeader.Resources[i].Type == VTF_LEGACY_RSRC_IMAGE || (CRCHeader.Resources[i].Flags & RSRCF_HAS_NO_DATA_CHUNK) == 0)
+					{
+						CRCHeader.Resources[i].Data += sizeof(SVTFResource);
+					}
+				}
+
+				CRCHeader.Resources[uiIndex].Type = VTF_RSRC_IMAGE_CRC;
+				CRCHeader.ResourceCount++;
+				CRCHeader.HeaderSize += sizeof(SVTFResource);
+			}
+
+			this->ComputeCRC(CRCHeader.Resources[uiIndex].Data);
+
+			Header = &CRCHeader;
+		}
+	}
+
+	try
+	{
+		if(!Writer->Open())
+			throw 0;
 
 		// Write the header.
-		if(Writer->Write(this->Header, this->Header->HeaderSize) != this->Header->HeaderSize)
+		if(Writer->Write(Header, Header->HeaderSize) != Header->HeaderSize)
 		{
 			throw 0;
 		}
 
 		if(this->GetSupportsResources())
 		{
-			for(vlUInt i = 0; i < this->Header->ResourceCount; i++)
+			for(vlUInt i = 0; i < Header->ResourceCount; i++)
 			{
-				switch(this->Header->Resources[i].Type)
+				switch(Header->Resources[i].Type)
 				{
 				case VTF_LEGACY_RSRC_LOW_RES_IMAGE:
 					if(Writer->Write(this->lpThumbnailImageData, this->uiThumbnailBufferSize) != this->uiThumbnailBufferSize)
@@ -1355,14 +2026,14 @@ vlBool CVTFFile::Save(IO::Writers::IWriter *Writer) const
 					}
 					break;
 				default:
-					if((this->Header->Resources[i].Flags & RSRCF_HAS_NO_DATA_CHUNK) == 0)
+					if((Header->Resources[i].Flags & RSRCF_HAS_NO_DATA_CHUNK) == 0)
 					{
-						if(Writer->Write(&this->Header->Data[i].Size, sizeof(vlUInt)) != sizeof(vlUInt))
+						if(Writer->Write(&Header->Data[i].Size, sizeof(vlUInt)) != sizeof(vlUInt))
 						{
 							throw 0;
 						}
 
-						if(Writer->Write(this->Header->Data[i].Data, this->Header->Data[i].Size) != this->Header->Data[i].Size)
+						if(Writer->Write(Header->Data[i].Data, Header->Data[i].Size) != Header->Data[i].Size)
 						{
 							throw 0;
 						}
@@ -1398,2855 +2069,4914 @@ vlBool CVTFFile::Save(IO::Writers::IWriter *Writer) const
 		return vlFalse;
 	}
 
-	Writer->Close();
-
-	return vlTrue;
+	return Writer->Close();
 }
 
 //
-// GetHasImage()
-// A image can be loaded as header only, this function indicates weather
-// image data was loaded or not.
+// DDS (DirectDraw Surface) files.
 //
-vlBool CVTFFile::GetHasImage() const
+
+#define DDS_MAGIC						0x20534444	// "DDS "
+#define DDS_FOURCC(a, b, c, d)			((vlUInt)(vlByte)(a) | ((vlUInt)(vlByte)(b) << 8) | ((vlUInt)(vlByte)(c) << 16) | ((vlUInt)(vlByte)(d) << 24))
+#define DDS_FOURCC_DX10					DDS_FOURCC('D', 'X', '1', '0')
+
+#define DDSD_CAPS						0x00000001
+#define DDSD_HEIGHT						0x00000002
+#define DDSD_WIDTH						0x00000004
+#define DDSD_PITCH						0x00000008
+#define DDSD_PIXELFORMAT				0x00001000
+#define DDSD_MIPMAPCOUNT				0x00020000
+#define DDSD_LINEARSIZE					0x00080000
+#define DDSD_DEPTH						0x00800000
+
+#define DDPF_ALPHAPIXELS				0x00000001
+#define DDPF_ALPHA						0x00000002
+#define DDPF_FOURCC						0x00000004
+#define DDPF_RGB						0x00000040
+#define DDPF_LUMINANCE					0x00020000
+#define DDPF_BUMPLUMINANCE				0x00040000
+#define DDPF_BUMPDUDV					0x00080000
+#define DDPF_TYPE						(DDPF_ALPHA | DDPF_FOURCC | DDPF_RGB | DDPF_LUMINANCE | DDPF_BUMPLUMINANCE | DDPF_BUMPDUDV)
+
+#define DDSCAPS_COMPLEX					0x00000008
+#define DDSCAPS_TEXTURE					0x00001000
+#define DDSCAPS_MIPMAP					0x00400000
+
+#define DDSCAPS2_CUBEMAP				0x00000200
+#define DDSCAPS2_CUBEMAP_ALLFACES		0x0000fc00
+#define DDSCAPS2_VOLUME					0x00200000
+
+#define DDS_DIMENSION_TEXTURE1D			2
+#define DDS_DIMENSION_TEXTURE2D			3
+#define DDS_DIMENSION_TEXTURE3D			4
+#define DDS_RESOURCE_MISC_TEXTURECUBE	0x00000004
+
+#pragma pack(1)
+
+struct SDDSPixelFormat
 {
-	if(!this->IsLoaded())
-		return vlFalse;
+	vlUInt Size;
+	vlUInt Flags;
+	vlUInt FourCC;
+	vlUInt RGBBitCount;
+	vlUInt BitMask[4];		// Red, green, blue and alpha.
+};
 
-	return this->lpImageData != 0;
-}
+struct SDDSHeader
+{
+	vlUInt Size;
+	vlUInt Flags;
+	vlUInt Height;
+	vlUInt Width;
+	vlUInt PitchOrLinearSize;
+	vlUInt Depth;
+	vlUInt MipMapCount;
+	vlUInt Reserved1[11];
+	SDDSPixelFormat PixelFormat;
+	vlUInt Caps;
+	vlUInt Caps2;
+	vlUInt Caps3;
+	vlUInt Caps4;
+	vlUInt Reserved2;
+};
+
+struct SDDSHeaderDX10
+{
+	vlUInt DXGIFormat;
+	vlUInt ResourceDimension;
+	vlUInt MiscFlag;
+	vlUInt ArraySize;
+	vlUInt MiscFlags2;
+};
+
+#pragma pack()
 
 //
-// GetMajorVersion()
-// Returns the size of the VTF file major version number.
+// The formats a DDS file holds byte for byte as VTF does.  A format without a
+// legacy pixel format (uiFlags 0) needs the DX10 header, one without a DXGI
+// format can't be an array, so can't have more than one frame.
 //
-vlUInt CVTFFile::GetMajorVersion() const
+struct SDDSFormat
 {
-	if(!this->IsLoaded())
-		return 0;
+	VTFImageFormat ImageFormat;
+	vlUInt uiFlags;
+	vlUInt uiFourCC;
+	vlUInt uiBitCount;
+	vlUInt uiBitMask[4];
+	vlUInt uiDXGIFormat;
+	vlUInt uiDXGIFormatSRGB;
+};
 
-	return this->Header->Version[0];
-}
+static const SDDSFormat DDSFormats[] =
+{
+	{ IMAGE_FORMAT_DXT1,				DDPF_FOURCC,						DDS_FOURCC('D', 'X', 'T', '1'),	0,	{ 0, 0, 0, 0 },										71,		72 },
+	{ IMAGE_FORMAT_DXT1_ONEBITALPHA,	DDPF_FOURCC,						DDS_FOURCC('D', 'X', 'T', '1'),	0,	{ 0, 0, 0, 0 },										71,		72 },
+	{ IMAGE_FORMAT_DXT3,				DDPF_FOURCC,						DDS_FOURCC('D', 'X', 'T', '3'),	0,	{ 0, 0, 0, 0 },										74,		75 },
+	{ IMAGE_FORMAT_DXT5,				DDPF_FOURCC,						DDS_FOURCC('D', 'X', 'T', '5'),	0,	{ 0, 0, 0, 0 },										77,		78 },
+	{ IMAGE_FORMAT_BGRA8888,			DDPF_RGB | DDPF_ALPHAPIXELS,		0,								32,	{ 0x00ff0000, 0x0000ff00, 0x000000ff, 0xff000000 },	87,		91 },
+	{ IMAGE_FORMAT_BGRX8888,			DDPF_RGB,							0,								32,	{ 0x00ff0000, 0x0000ff00, 0x000000ff, 0 },			88,		93 },
+	{ IMAGE_FORMAT_RGBA8888,			DDPF_RGB | DDPF_ALPHAPIXELS,		0,								32,	{ 0x000000ff, 0x0000ff00, 0x00ff0000, 0xff000000 },	28,		29 },
+	{ IMAGE_FORMAT_ABGR8888,			DDPF_RGB | DDPF_ALPHAPIXELS,		0,								32,	{ 0xff000000, 0x00ff0000, 0x0000ff00, 0x000000ff },	0,		0 },
+	{ IMAGE_FORMAT_BGR888,				DDPF_RGB,							0,								24,	{ 0x00ff0000, 0x0000ff00, 0x000000ff, 0 },			0,		0 },
+	{ IMAGE_FORMAT_RGB888,				DDPF_RGB,							0,								24,	{ 0x000000ff, 0x0000ff00, 0x00ff0000, 0 },			0,		0 },
+	{ IMAGE_FORMAT_BGR565,				DDPF_RGB,							0,								16,	{ 0xf800, 0x07e0, 0x001f, 0 },						85,		0 },
+	{ IMAGE_FORMAT_RGB565,				DDPF_RGB,							0,								16,	{ 0x001f, 0x07e0, 0xf800, 0 },						0,		0 },
+	{ IMAGE_FORMAT_BGRA4444,			DDPF_RGB | DDPF_ALPHAPIXELS,		0,								16,	{ 0x0f00, 0x00f0, 0x000f, 0xf000 },					115,	0 },
+	{ IMAGE_FORMAT_BGRA5551,			DDPF_RGB | DDPF_ALPHAPIXELS,		0,								16,	{ 0x7c00, 0x03e0, 0x001f, 0x8000 },					86,		0 },
+	{ IMAGE_FORMAT_BGRX5551,			DDPF_RGB,							0,								16,	{ 0x7c00, 0x03e0, 0x001f, 0 },						0,		0 },
+	{ IMAGE_FORMAT_I8,					DDPF_LUMINANCE,						0,								8,	{ 0xff, 0, 0, 0 },									0,		0 },
+	{ IMAGE_FORMAT_IA88,				DDPF_LUMINANCE | DDPF_ALPHAPIXELS,	0,								16,	{ 0x00ff, 0, 0, 0xff00 },							0,		0 },
+	{ IMAGE_FORMAT_A8,					DDPF_ALPHA,							0,								8,	{ 0, 0, 0, 0xff },									65,		0 },
+	{ IMAGE_FORMAT_UV88,				DDPF_BUMPDUDV,						0,								16,	{ 0x00ff, 0xff00, 0, 0 },							51,		0 },
+	{ IMAGE_FORMAT_UVWQ8888,			DDPF_BUMPDUDV,						0,								32,	{ 0x000000ff, 0x0000ff00, 0x00ff0000, 0xff000000 },	31,		0 },
+	{ IMAGE_FORMAT_UVLX8888,			DDPF_BUMPLUMINANCE,					0,								32,	{ 0x000000ff, 0x0000ff00, 0x00ff0000, 0 },			0,		0 },
+	{ IMAGE_FORMAT_RGBA16161616F,		DDPF_FOURCC,						113,							0,	{ 0, 0, 0, 0 },										10,		0 },
+	{ IMAGE_FORMAT_RGBA16161616,		DDPF_FOURCC,						36,								0,	{ 0, 0, 0, 0 },										11,		0 },
+	{ IMAGE_FORMAT_R32F,				DDPF_FOURCC,						114,							0,	{ 0, 0, 0, 0 },										41,		0 },
+	{ IMAGE_FORMAT_RGB323232F,			0,									0,								0,	{ 0, 0, 0, 0 },										6,		0 },
+	{ IMAGE_FORMAT_RGBA32323232F,		DDPF_FOURCC,						116,							0,	{ 0, 0, 0, 0 },										2,		0 }
+};
+
+#define DDS_FORMAT_COUNT	(sizeof(DDSFormats) / sizeof(DDSFormats[0]))
 
 //
-// GetMinorVersion()
-// Returns the size of the VTF file minor version number.
+// FindDDSFormat()
+// Finds the DDS form of a VTF format, or null if it has none.
 //
-vlUInt CVTFFile::GetMinorVersion() const
+static const SDDSFormat *FindDDSFormat(VTFImageFormat ImageFormat)
 {
-	if(!this->IsLoaded())
-		return 0;
+	for(vlUInt i = 0; i < DDS_FORMAT_COUNT; i++)
+	{
+		if(DDSFormats[i].ImageFormat == ImageFormat)
+		{
+			return &DDSFormats[i];
+		}
+	}
 
-	return this->Header->Version[1];
+	return 0;
 }
 
 //
-// ComputeResources()
-// Computes header VTF directory resources.
+// FindDDSFormat()
+// Finds the VTF format matching a legacy DDS pixel format.
 //
-vlVoid CVTFFile::ComputeResources()
+static const SDDSFormat *FindDDSFormat(const SDDSPixelFormat &PixelFormat)
 {
-	if(!this->IsLoaded())
-		return;
-
-	// Correct resource count.
-	if(!this->GetSupportsResources())
+	for(vlUInt i = 0; i < DDS_FORMAT_COUNT; i++)
 	{
-		this->Header->ResourceCount = 0;
-	}
+		const SDDSFormat &Format = DDSFormats[i];
 
-	// Correct header size.
-	STATIC_ASSERT(VTF_MAJOR_VERSION == 7, "HeaderSize needs calculation for new major version.");
-	STATIC_ASSERT(VTF_MINOR_VERSION == 5, "HeaderSize needs calculation for new minor version.");
-	switch(this->Header->Version[0])
-	{
-	case 7:
-		switch(this->Header->Version[1])
+		if((Format.uiFlags & DDPF_TYPE) == 0 || (Format.uiFlags & DDPF_TYPE) != (PixelFormat.Flags & DDPF_TYPE))
+			continue;
+
+		if(Format.uiFlags & DDPF_FOURCC)
 		{
-		case 0:
-			this->Header->HeaderSize = sizeof(SVTFHeader_70_A);
-			break;
-		case 1:
-			this->Header->HeaderSize = sizeof(SVTFHeader_71_A);
-			break;
-		case 2:
-			this->Header->HeaderSize = sizeof(SVTFHeader_72_A);
-			break;
-		case 3:
-			this->Header->HeaderSize = sizeof(SVTFHeader_73_A) + this->Header->ResourceCount * sizeof(SVTFResource);
-			break;
-		case 4:
-			this->Header->HeaderSize = sizeof(SVTFHeader_74_A) + this->Header->ResourceCount * sizeof(SVTFResource);
-			break;
-		case 5:
-			this->Header->HeaderSize = sizeof(SVTFHeader_75_A) + this->Header->ResourceCount * sizeof(SVTFResource);
-			break;
+			if(Format.uiFourCC == PixelFormat.FourCC)
+				return &Format;
+
+			continue;
 		}
-		break;
-	}
 
-	// Correct resource offsets.
-	vlUInt uiOffset = this->Header->HeaderSize;
-	for(vlUInt i = 0; i < this->Header->ResourceCount; i++)
-	{
-		switch(this->Header->Resources[i].Type)
+		// Writers leave junk in the alpha mask of formats without alpha.
+		vlUInt uiAlphaMask = PixelFormat.Flags & (DDPF_ALPHAPIXELS | DDPF_ALPHA) ? PixelFormat.BitMask[3] : 0;
+
+		if(Format.uiBitCount == PixelFormat.RGBBitCount && Format.uiBitMask[0] == PixelFormat.BitMask[0] && Format.uiBitMask[1] == PixelFormat.BitMask[1] && Format.uiBitMask[2] == PixelFormat.BitMask[2] && Format.uiBitMask[3] == uiAlphaMask)
 		{
-		case VTF_LEGACY_RSRC_LOW_RES_IMAGE:
-			this->Header->Resources[i].Data = uiOffset;
-			uiOffset += this->uiThumbnailBufferSize;
-			break;
-		case VTF_LEGACY_RSRC_IMAGE:
-			this->Header->Resources[i].Data = uiOffset;
-			uiOffset += this->uiImageBufferSize;
-			break;
-		default:
-			if((this->Header->Resources[i].Flags & RSRCF_HAS_NO_DATA_CHUNK) == 0)
-			{
-				this->Header->Resources[i].Data = uiOffset;
-				uiOffset += sizeof(vlUInt) + this->Header->Data[i].Size;
-			}
-			break;
+			return &Format;
 		}
 	}
+
+	return 0;
 }
 
 //
-// GetSize()
-// Returns the size of the VTF file in bytes.
+// FindDDSFormat()
+// Finds the VTF format matching a DXGI format.  bSRGB is set for the sRGB variants.
 //
-vlUInt CVTFFile::GetSize() const
+static const SDDSFormat *FindDDSFormat(vlUInt uiDXGIFormat, vlBool &bSRGB)
 {
-	if(!this->IsLoaded())
-		return 0;
-
-	vlUInt uiResourceSize = 0;
-	if(this->GetSupportsResources())
+	for(vlUInt i = 0; i < DDS_FORMAT_COUNT; i++)
 	{
-		for(vlUInt i = 0; i < this->Header->ResourceCount; i++)
+		if(uiDXGIFormat == 0)
+			break;
+
+		if(DDSFormats[i].uiDXGIFormat == uiDXGIFormat || DDSFormats[i].uiDXGIFormatSRGB == uiDXGIFormat)
 		{
-			switch(this->Header->Resources[i].Type)
-			{
-			case VTF_LEGACY_RSRC_LOW_RES_IMAGE:
-			case VTF_LEGACY_RSRC_IMAGE:
-				break;
-			default:
-				if((this->Header->Resources[i].Flags & RSRCF_HAS_NO_DATA_CHUNK) == 0)
-				{
-					uiResourceSize += sizeof(vlUInt) + this->Header->Data[i].Size;
-				}
-				break;
-			}
+			bSRGB = DDSFormats[i].uiDXGIFormatSRGB == uiDXGIFormat;
+			return &DDSFormats[i];
 		}
 	}
 
-	return this->Header->HeaderSize + this->uiThumbnailBufferSize + this->uiImageBufferSize + uiResourceSize;
+	return 0;
 }
 
 //
-// GetWidth()
-// Gets the width of the largest level mipmap.
+// ComputeSurfaceSize()
+// Gets the size of one mipmap of one face of one frame as ComputeMipmapSize() does,
+// but in 64 bits so sizes from a file's header can't wrap.
 //
-vlUInt CVTFFile::GetWidth() const
+static vlUInt64 ComputeSurfaceSize(vlUInt uiWidth, vlUInt uiHeight, vlUInt uiDepth, vlUInt uiMipmap, VTFImageFormat ImageFormat)
 {
-	if(!this->IsLoaded())
-		return 0;
+	vlUInt uiMipmapWidth, uiMipmapHeight, uiMipmapDepth;
+	CVTFFile::ComputeMipmapDimensions(uiWidth, uiHeight, uiDepth, uiMipmap, uiMipmapWidth, uiMipmapHeight, uiMipmapDepth);
 
-	return this->Header->Width;
+	switch(ImageFormat)
+	{
+	case IMAGE_FORMAT_DXT1:
+	case IMAGE_FORMAT_DXT1_ONEBITALPHA:
+		return (((vlUInt64)uiMipmapWidth + 3) / 4) * (((vlUInt64)uiMipmapHeight + 3) / 4) * 8 * uiMipmapDepth;
+	case IMAGE_FORMAT_DXT3:
+	case IMAGE_FORMAT_DXT5:
+		return (((vlUInt64)uiMipmapWidth + 3) / 4) * (((vlUInt64)uiMipmapHeight + 3) / 4) * 16 * uiMipmapDepth;
+	default:
+		return (vlUInt64)uiMipmapWidth * uiMipmapHeight * uiMipmapDepth * CVTFFile::GetImageFormatInfo(ImageFormat).uiBytesPerPixel;
+	}
 }
 
 //
-// GetHeight()
-// Gets the height of the largest level mipmap.
+// ComputeImageDataSize()
+// Gets the size of the image data for the given dimensions and counts, which must
+// each be at most 0xffff.  Stops adding once the size is over 0xffffffff.
 //
-vlUInt CVTFFile::GetHeight() const
+static vlUInt64 ComputeImageDataSize(vlUInt uiWidth, vlUInt uiHeight, vlUInt uiDepth, vlUInt uiMipmaps, vlUInt uiFrames, vlUInt uiFaces, VTFImageFormat ImageFormat)
 {
-	if(!this->IsLoaded())
-		return 0;
+	vlUInt64 uiSize = 0;
 
-	return this->Header->Height;
+	for(vlUInt i = 0; i < uiMipmaps && uiSize <= 0xffffffff; i++)
+	{
+		vlUInt64 uiSurfaceSize = ComputeSurfaceSize(uiWidth, uiHeight, uiDepth, i, ImageFormat);
+		uiSize += uiSurfaceSize > 0xffffffff ? uiSurfaceSize : uiSurfaceSize * uiFrames * uiFaces;
+	}
+
+	return uiSize;
 }
 
 //
-// GetDepth()
-// Gets the depth of the largest level mipmap.
+// ComputeSurfaceOffset()
+// Gets the offset of one face of one frame of one mipmap in VTF image data, which
+// stores the smallest mipmap first and the faces of a frame together.  DDS stores
+// the largest mipmap first and each face's mipmaps together.
 //
-vlUInt CVTFFile::GetDepth() const
+static vlUInt64 ComputeSurfaceOffset(const SVTFHeader &Header, vlUInt uiFaces, vlUInt uiFrame, vlUInt uiFace, vlUInt uiMipmap)
 {
-	if(!this->IsLoaded())
-		return 0;
+	vlUInt64 uiOffset = 0;
 
-	return this->Header->Depth;
+	for(vlUInt i = Header.MipCount - 1; i > uiMipmap; i--)
+	{
+		uiOffset += ComputeSurfaceSize(Header.Width, Header.Height, Header.Depth, i, Header.ImageFormat) * Header.Frames * uiFaces;
+	}
+
+	return uiOffset + ComputeSurfaceSize(Header.Width, Header.Height, Header.Depth, uiMipmap, Header.ImageFormat) * ((vlUInt64)uiFrame * uiFaces + uiFace);
 }
 
-//
-// GetFrameCount()
-// Gets the number of frames the image has.  All images have at least 1 frame.
-//
-vlUInt CVTFFile::GetFrameCount() const
+vlBool CVTFFile::LoadDDS(const vlChar *cFileName)
 {
-	if(!this->IsLoaded())
-		return 0;
+	Diagnostics::CStatTimer Timer(VTFLIB_STAT_LOAD_DDS);
 
-	return this->Header->Frames;
-}
+	IO::Readers::CFileReader FileReader(cFileName);
+	IO::Readers::CBufferedReader Reader(&FileReader);
 
-//---------------------------------------------------------------------------------
-// GetFaceCount()
-//
-// Returns the number of faces in the texture based on the status of the header
-// flags. Cubemaps have 6 or 7 faces, others just 1.
-//---------------------------------------------------------------------------------
-vlUInt CVTFFile::GetFaceCount() const
-{
-	if(!this->IsLoaded())
-		return 0;
+	vlBool bResult = this->LoadDDS(&Reader);
+
+	if(bResult && Timer.Active())
+		Timer.SetBytes(this->uiImageBufferSize);
 
-	return this->Header->Flags & TEXTUREFLAGS_ENVMAP ? (this->Header->StartFrame != 0xffff && this->Header->Version[1] < VTF_MINOR_VERSION_MIN_NO_SPHERE_MAP ? CUBEMAP_FACE_COUNT : CUBEMAP_FACE_COUNT - 1) : 1;
+	return bResult;
 }
 
-//
-// GetMipmapCount()
-// Gets the number of mipmaps the image has.
-//
-vlUInt CVTFFile::GetMipmapCount() const
+vlBool CVTFFile::LoadDDS(const vlVoid *lpData, vlUInt uiBufferSize)
 {
-	if(!this->IsLoaded())
-		return 0;
+	Diagnostics::CStatTimer Timer(VTFLIB_STAT_LOAD_DDS, uiBufferSize);
 
-	return this->Header->MipCount;
+	auto r = IO::Readers::CMemoryReader(lpData, uiBufferSize);
+	return this->LoadDDS(&r);
 }
 
-//
-// GetStartFrame()
-// Gets the first frame in the animation sequence.  If the image is
-// an enviroment map and 0xffff is returned, the enviroment map has
-// no sphere map.
-//
-vlUInt CVTFFile::GetStartFrame() const
+vlBool CVTFFile::SaveDDS(const vlChar *cFileName) const
 {
-	if(!this->IsLoaded())
-		return 0;
+	Diagnostics::CStatTimer Timer(VTFLIB_STAT_SAVE_DDS);
 
-	return this->Header->StartFrame;
+	vlUInt uiSizeHint = this->IsLoaded() ? sizeof(vlUInt) + sizeof(SDDSHeader) + sizeof(SDDSHeaderDX10) + this->uiImageBufferSize : 0;
+
+	IO::Writers::CFileWriter FileWriter(cFileName, uiSizeHint);
+	IO::Writers::CBufferedWriter Writer(&FileWriter);
+
+	vlBool bResult = this->SaveDDS(&Writer) && Writer.Flush();
+
+	if(bResult && Timer.Active())
+		Timer.SetBytes(this->uiImageBufferSize);
+
+	return bResult;
 }
 
-//
-// SetStartFrame()
-// Sets the first frame in the animation sequence.
-//
-vlVoid CVTFFile::SetStartFrame(vlUInt uiStartFrame)
+vlBool CVTFFile::SaveDDS(vlVoid *lpData, vlUInt uiBufferSize, vlUInt &uiSize) const
 {
-	if(!this->IsLoaded())
-		return;
+	Diagnostics::CStatTimer Timer(VTFLIB_STAT_SAVE_DDS);
 
-	// Note: Valve informs us that animated enviroment maps ARE possible.
-	// The StartFrame MAY be valid but there is the issue of the enviroment
-	// maps without sphere maps.  This is trivial...
+	uiSize = 0;
 
-	// Don't let the user set the start frame of an enviroment map.
-	if(this->Header->Flags & TEXTUREFLAGS_ENVMAP)
-	{
-		return;
-	}
+	IO::Writers::CMemoryWriter MemoryWriter = IO::Writers::CMemoryWriter(lpData, uiBufferSize);
 
-	if(uiStartFrame >= (vlUInt)this->Header->Frames)
-	{
-		uiStartFrame = (vlUInt)this->Header->Frames - 1;
-	}
+	vlBool bResult = this->SaveDDS(&MemoryWriter);
 
-	this->Header->StartFrame = (vlUShort)uiStartFrame;
+	uiSize = MemoryWriter.GetStreamSize();
+	Timer.SetBytes(uiSize);
+
+	return bResult;
 }
 
 //
-// GetFlags()
-// Gets the flags associated with the image.  These flags
-// are stored in the VTFImageFlag enumeration.
+// LoadDDS()
+// Loads a DDS file without decoding it.  Each surface is read straight into its
+// place in the VTF image data.
 //
-vlUInt CVTFFile::GetFlags() const
+vlBool CVTFFile::LoadDDS(IO::Readers::IReader *Reader)
 {
-	if(!this->IsLoaded())
-		return 0;
+	this->Destroy();
 
-	return this->Header->Flags;
-}
+	try
+	{
+		if(!Reader->Open())
+			throw 0;
 
-// SetFlags()
-// Sets the flags associated with the image.  These flags
-// are stored in the VTFImageFlag enumeration.
-//
-vlVoid CVTFFile::SetFlags(vlUInt uiFlags)
-{
-	if(!this->IsLoaded())
-		return;
+		vlUInt uiMagic;
+		SDDSHeader DDSHeader;
+		if(Reader->Read(&uiMagic, sizeof(vlUInt)) != sizeof(vlUInt) || uiMagic != DDS_MAGIC || Reader->Read(&DDSHeader, sizeof(SDDSHeader)) != sizeof(SDDSHeader) || DDSHeader.Size != sizeof(SDDSHeader))
+		{
+			LastError.Set("File is not a DDS file.");
+			throw 0;
+		}
 
-	// Don't let the user set flags critical to the image's format.
-	//if(this->Header->Version[0] < VTF_MAJOR_VERSION || (this->Header->Version[0] == VTF_MAJOR_VERSION && this->Header->Version[1] <= VTF_MINOR_VERSION_MIN_RESOURCE))
-	//{
-	//	if(this->Header->Flags & TEXTUREFLAGS_DEPRECATED_NOCOMPRESS)
-	//		uiFlags |= TEXTUREFLAGS_DEPRECATED_NOCOMPRESS;
-	//	else
-	//		uiFlags &= ~TEXTUREFLAGS_DEPRECATED_NOCOMPRESS;
-	//}
+		const SDDSFormat *Format;
+		vlBool bSRGB = vlFalse;
+		vlUInt uiFrames = 1, uiFaces = 1, uiDepth = 1;
 
-	if(this->Header->Flags & TEXTUREFLAGS_EIGHTBITALPHA)
-		uiFlags |= TEXTUREFLAGS_EIGHTBITALPHA;
-	else
-		uiFlags &= ~TEXTUREFLAGS_EIGHTBITALPHA;
+		if((DDSHeader.PixelFormat.Flags & DDPF_FOURCC) && DDSHeader.PixelFormat.FourCC == DDS_FOURCC_DX10)
+		{
+			SDDSHeaderDX10 DX10Header;
+			if(Reader->Read(&DX10Header, sizeof(SDDSHeaderDX10)) != sizeof(SDDSHeaderDX10))
+			{
+				LastError.Set("File is not a DDS file.");
+				throw 0;
+			}
 
-	if(this->Header->Flags & TEXTUREFLAGS_ENVMAP)
-		uiFlags |= TEXTUREFLAGS_ENVMAP;
-	else
-		uiFlags &= ~TEXTUREFLAGS_ENVMAP;
+			Format = FindDDSFormat(DX10Header.DXGIFormat, bSRGB);
+			if(Format == 0)
+			{
+				LastError.SetFormatted("DXGI format %u has no VTF equivalent.", DX10Header.DXGIFormat);
+				throw 0;
+			}
 
-	if(this->Header->Flags & TEXTUREFLAGS_ENVMAP)
-		uiFlags |= TEXTUREFLAGS_ENVMAP;
-	else
-		uiFlags &= ~TEXTUREFLAGS_ENVMAP;
+			switch(DX10Header.ResourceDimension)
+			{
+			case DDS_DIMENSION_TEXTURE1D:
+			case DDS_DIMENSION_TEXTURE2D:
+				break;
+			case DDS_DIMENSION_TEXTURE3D:
+				uiDepth = DDSHeader.Depth;
+				break;
+			default:
+				LastError.SetFormatted("Invalid DDS resource dimension %u.", DX10Header.ResourceDimension);
+				throw 0;
+			}
 
-	this->Header->Flags = uiFlags;
-}
+			uiFrames = DX10Header.ArraySize;
+			if(DX10Header.MiscFlag & DDS_RESOURCE_MISC_TEXTURECUBE)
+			{
+				uiFaces = 6;
+			}
+		}
+		else
+		{
+			Format = FindDDSFormat(DDSHeader.PixelFormat);
+			if(Format == 0)
+			{
+				LastError.Set("DDS pixel format has no VTF equivalent.");
+				throw 0;
+			}
+
+			if(DDSHeader.Caps2 & DDSCAPS2_CUBEMAP)
+			{
+				if((DDSHeader.Caps2 & DDSCAPS2_CUBEMAP_ALLFACES) != DDSCAPS2_CUBEMAP_ALLFACES)
+				{
+					LastError.Set("DDS cubemaps without all six faces are not supported.");
+					throw 0;
+				}
+
+				uiFaces = 6;
+			}
+
+			if(DDSHeader.Caps2 & DDSCAPS2_VOLUME)
+			{
+				uiDepth = DDSHeader.Depth;
+			}
+		}
+
+		if(uiDepth == 0)
+		{
+			uiDepth = 1;
+		}
+
+		if(uiFaces != 1 && uiDepth != 1)
+		{
+			LastError.Set("Volume cubemaps are not supported.");
+			throw 0;
+		}
+
+		vlUInt uiMipmaps = DDSHeader.MipMapCount != 0 ? DDSHeader.MipMapCount : 1;
+
+		// Image data sizes are 32 bit, so check the size the header describes before
+		// creating the image.  CreateImage() rejects dimensions and counts over 0xffff.
+		if(DDSHeader.Width <= 0xffff && DDSHeader.Height <= 0xffff && uiDepth <= 0xffff && uiFrames <= 0xffff)
+		{
+			vlUInt uiCreateMipmaps = uiMipmaps > 1 && DDSHeader.Width != 0 && DDSHeader.Height != 0 ? CVTFFile::ComputeMipmapCount(DDSHeader.Width, DDSHeader.Height, uiDepth) : 1;
+
+			if(ComputeImageDataSize(DDSHeader.Width, DDSHeader.Height, uiDepth, uiCreateMipmaps, uiFrames, uiFaces, Format->ImageFormat) > 0xffffffff)
+			{
+				LastError.SetFormatted("DDS image data is over 4 GB (%ux%ux%u, %u frames of %u faces).", DDSHeader.Width, DDSHeader.Height, uiDepth, uiFrames, uiFaces);
+				throw 0;
+			}
+		}
+
+		if(!this->CreateImage(DDSHeader.Width, DDSHeader.Height, uiFrames, uiFaces, uiDepth, Format->ImageFormat, vlFalse, uiMipmaps > 1, vlFalse, 0, 0, 0, 0))
+			throw 0;
+
+		if(uiMipmaps > this->Header->MipCount)
+		{
+			LastError.SetFormatted("DDS file has %u mipmaps, a %ux%ux%u image can only have %u.", uiMipmaps, DDSHeader.Width, DDSHeader.Height, uiDepth, (vlUInt)this->Header->MipCount);
+			throw 0;
+		}
+
+		// A DDS file may stop short of 1x1; resize the image data to the mipmaps it has.
+		if(uiMipmaps != this->Header->MipCount)
+		{
+			this->Header->MipCount = (vlByte)uiMipmaps;
+
+			this->FreeImageData();
+			this->uiImageBufferSize = this->ComputeImageSize(this->Header->Width, this->Header->Height, this->Header->Depth, this->Header->MipCount, this->Header->ImageFormat) * uiFrames * uiFaces;
+			this->lpImageData = Memory::AllocateImage(this->uiImageBufferSize);
+
+			this->ComputeResources();
+		}
+
+		if(bSRGB)
+		{
+			this->Header->Flags |= TEXTUREFLAGS_SRGB;
+		}
+
+		if(Reader->GetStreamSize() - Reader->GetStreamPointer() < this->uiImageBufferSize)
+		{
+			LastError.Set("DDS file is truncated.");
+			throw 0;
+		}
+
+		for(vlUInt uiFrame = 0; uiFrame < uiFrames; uiFrame++)
+		{
+			for(vlUInt uiFace = 0; uiFace < uiFaces; uiFace++)
+			{
+				for(vlUInt uiMipmap = 0; uiMipmap < uiMipmaps; uiMipmap++)
+				{
+					vlUInt64 uiOffset = ComputeSurfaceOffset(*this->Header, uiFaces, uiFrame, uiFace, uiMipmap);
+					vlUInt64 uiSize = ComputeSurfaceSize(this->Header->Width, this->Header->Height, this->Header->Depth, uiMipmap, this->Header->ImageFormat);
+
+					if(uiOffset > this->uiImageBufferSize || uiSize > this->uiImageBufferSize - uiOffset)
+					{
+						LastError.Set("DDS surface is outside the image data.");
+						throw 0;
+					}
+
+					if(Reader->Read(this->lpImageData + uiOffset, (vlUInt)uiSize) != uiSize)
+					{
+						throw 0;
+					}
+				}
+			}
+		}
+	}
+	catch(...)
+	{
+		Reader->Close();
+
+		this->Destroy();
 
-//
-// GetFlag()
-// Gets the status of the specified flag in the image.
-//
-vlBool CVTFFile::GetFlag(VTFImageFlag ImageFlag) const
-{
-	if(!this->IsLoaded())
 		return vlFalse;
+	}
 
-	return (this->Header->Flags & ImageFlag) != 0;
+	Reader->Close();
+
+	return vlTrue;
 }
 
 //
-// SetFlag()
-// Sets the flag ImageFlag to bState (set or not set).  Flags critical
-// to the image's format cannot be set.
+// SaveDDS()
+// Saves the image as a DDS file without decoding it.  Frames become an array,
+// which needs the DX10 header; single frame images get the legacy header where
+// the format has one so older tools can read them.  Valve's cubemap faces are
+// in Direct3D's order, so they're written as they are, less any sphere map.
 //
-vlVoid CVTFFile::SetFlag(VTFImageFlag ImageFlag, vlBool bState)
+vlBool CVTFFile::SaveDDS(IO::Writers::IWriter *Writer) const
 {
-	if(!this->IsLoaded())
-		return;
+	if(!this->IsLoaded() || !this->GetHasImage())
+	{
+		LastError.Set("No image to save.");
+		return vlFalse;
+	}
 
-	//if(this->Header->Version[0] < VTF_MAJOR_VERSION || (this->Header->Version[0] == VTF_MAJOR_VERSION && this->Header->Version[1] <= VTF_MINOR_VERSION_MIN_RESOURCE))
-	//{
-	//	if(ImageFlag == TEXTUREFLAGS_DEPRECATED_NOCOMPRESS)
-	//	{
-	//		return;
-	//	}
-	//}
+	const SDDSFormat *Format = FindDDSFormat(this->Header->ImageFormat);
+	if(Format == 0)
+	{
+		LastError.SetFormatted("%s images can't be saved as DDS files.", this->GetImageFormatInfo(this->Header->ImageFormat).lpName);
+		return vlFalse;
+	}
 
-	// Don't let the user set flags critical to the image's format.
-	if(ImageFlag == TEXTUREFLAGS_ONEBITALPHA || ImageFlag == TEXTUREFLAGS_EIGHTBITALPHA || ImageFlag == TEXTUREFLAGS_ENVMAP)
+	vlUInt uiFrames = this->GetFrameCount();
+	vlUInt uiFaces = this->GetFaceCount();
+	vlUInt uiDepth = this->GetDepth();
+	vlUInt uiMipmaps = this->Header->MipCount;
+
+	vlBool bDX10 = uiFrames > 1 || (Format->uiFlags & DDPF_TYPE) == 0;
+	if(bDX10 && Format->uiDXGIFormat == 0)
 	{
-		return;
+		LastError.SetFormatted("%s images with more than one frame can't be saved as DDS files.", this->GetImageFormatInfo(this->Header->ImageFormat).lpName);
+		return vlFalse;
 	}
 
-	if(bState)
+	if(bDX10 && uiFrames > 1 && uiDepth > 1)
 	{
-		this->Header->Flags |= ImageFlag;
+		LastError.Set("Volume textures with more than one frame can't be saved as DDS files.");
+		return vlFalse;
+	}
+
+	SDDSHeader DDSHeader;
+	memset(&DDSHeader, 0, sizeof(SDDSHeader));
+
+	const SVTFImageFormatInfo &FormatInfo = this->GetImageFormatInfo(this->Header->ImageFormat);
+
+	DDSHeader.Size = sizeof(SDDSHeader);
+	DDSHeader.Flags = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT
+					| (FormatInfo.bIsCompressed ? DDSD_LINEARSIZE : DDSD_PITCH)
+					| (uiMipmaps > 1 ? DDSD_MIPMAPCOUNT : 0)
+					| (uiDepth > 1 ? DDSD_DEPTH : 0);
+	DDSHeader.Height = this->Header->Height;
+	DDSHeader.Width = this->Header->Width;
+	DDSHeader.PitchOrLinearSize = FormatInfo.bIsCompressed ? this->ComputeImageSize(this->Header->Width, this->Header->Height, 1, this->Header->ImageFormat) : (this->Header->Width * FormatInfo.uiBitsPerPixel + 7) / 8;
+	DDSHeader.Depth = uiDepth > 1 ? uiDepth : 0;
+	DDSHeader.MipMapCount = uiMipmaps;
+	DDSHeader.PixelFormat.Size = sizeof(SDDSPixelFormat);
+	DDSHeader.Caps = DDSCAPS_TEXTURE
+					| (uiMipmaps > 1 || uiFaces > 1 || uiDepth > 1 ? DDSCAPS_COMPLEX : 0)
+					| (uiMipmaps > 1 ? DDSCAPS_MIPMAP : 0);
+	DDSHeader.Caps2 = (uiFaces > 1 ? DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_ALLFACES : 0)
+					| (uiDepth > 1 ? DDSCAPS2_VOLUME : 0);
+
+	SDDSHeaderDX10 DX10Header;
+	memset(&DX10Header, 0, sizeof(SDDSHeaderDX10));
+
+	if(bDX10)
+	{
+		DDSHeader.PixelFormat.Flags = DDPF_FOURCC;
+		DDSHeader.PixelFormat.FourCC = DDS_FOURCC_DX10;
+
+		DX10Header.DXGIFormat = (this->Header->Flags & TEXTUREFLAGS_SRGB) && Format->uiDXGIFormatSRGB != 0 ? Format->uiDXGIFormatSRGB : Format->uiDXGIFormat;
+		DX10Header.ResourceDimension = uiDepth > 1 ? DDS_DIMENSION_TEXTURE3D : DDS_DIMENSION_TEXTURE2D;
+		DX10Header.MiscFlag = uiFaces > 1 ? DDS_RESOURCE_MISC_TEXTURECUBE : 0;
+		DX10Header.ArraySize = uiFrames;
 	}
 	else
 	{
-		this->Header->Flags &= ~ImageFlag;
+		DDSHeader.PixelFormat.Flags = Format->uiFlags;
+		DDSHeader.PixelFormat.FourCC = Format->uiFourCC;
+		DDSHeader.PixelFormat.RGBBitCount = Format->uiBitCount;
+		memcpy(DDSHeader.PixelFormat.BitMask, Format->uiBitMask, sizeof(DDSHeader.PixelFormat.BitMask));
 	}
-}
 
-//
-// GetBumpmapScale()
-// Gets the bumpmap scale of the image.
-//
-vlSingle CVTFFile::GetBumpmapScale() const
-{
-	if(!this->IsLoaded())
-		return 0.0f;
+	try
+	{
+		if(!Writer->Open())
+			throw 0;
 
-	return this->Header->BumpScale;
+		vlUInt uiMagic = DDS_MAGIC;
+		if(Writer->Write(&uiMagic, sizeof(vlUInt)) != sizeof(vlUInt) || Writer->Write(&DDSHeader, sizeof(SDDSHeader)) != sizeof(SDDSHeader))
+		{
+			throw 0;
+		}
+
+		if(bDX10 && Writer->Write(&DX10Header, sizeof(SDDSHeaderDX10)) != sizeof(SDDSHeaderDX10))
+		{
+			throw 0;
+		}
+
+		for(vlUInt uiFrame = 0; uiFrame < uiFrames; uiFrame++)
+		{
+			for(vlUInt uiFace = 0; uiFace < uiFaces && uiFace < 6; uiFace++)
+			{
+				for(vlUInt uiMipmap = 0; uiMipmap < uiMipmaps; uiMipmap++)
+				{
+					vlUInt uiSize = this->ComputeMipmapSize(this->Header->Width, this->Header->Height, this->Header->Depth, uiMipmap, this->Header->ImageFormat);
+
+					if(Writer->Write(this->lpImageData + ComputeSurfaceOffset(*this->Header, uiFaces, uiFrame, uiFace, uiMipmap), uiSize) != uiSize)
+					{
+						throw 0;
+					}
+				}
+			}
+		}
+	}
+	catch(...)
+	{
+		Writer->Close();
+
+		return vlFalse;
+	}
+
+	return Writer->Close();
 }
 
 //
-// SetBumpmapScale()
-// Sets the bumpmap scale of the image.
+// GetHasImage()
+// A image can be loaded as header only, this function indicates weather
+// image data was loaded or not.
 //
-vlVoid CVTFFile::SetBumpmapScale(vlSingle sBumpmapScale)
+vlBool CVTFFile::GetHasImage() const
 {
 	if(!this->IsLoaded())
-		return;
+		return vlFalse;
 
-	this->Header->BumpScale = sBumpmapScale;
+	return this->lpImageData != 0;
 }
 
 //
-// GetReflectivity()
-// Gets the reflectivity of the image.
+// GetMajorVersion()
+// Returns the size of the VTF file major version number.
 //
-vlVoid CVTFFile::GetReflectivity(vlSingle &sX, vlSingle &sY, vlSingle &sZ) const
+vlUInt CVTFFile::GetMajorVersion() const
 {
 	if(!this->IsLoaded())
-		return;
+		return 0;
 
-	sX = this->Header->Reflectivity[0];
-	sY = this->Header->Reflectivity[1];
-	sZ = this->Header->Reflectivity[2];
+	return this->Header->Version[0];
 }
 
 //
-// SetReflectivity()
-// Sets the reflectivity of the image.
+// GetMinorVersion()
+// Returns the size of the VTF file minor version number.
 //
-vlVoid CVTFFile::SetReflectivity(vlSingle sX, vlSingle sY, vlSingle sZ)
+vlUInt CVTFFile::GetMinorVersion() const
 {
 	if(!this->IsLoaded())
-		return;
+		return 0;
 
-	this->Header->Reflectivity[0] = sX;
-	this->Header->Reflectivity[1] = sY;
-	this->Header->Reflectivity[2] = sZ;
+	return this->Header->Version[1];
 }
 
 //
-// GetFormat()
-// Gets the format of the image.
+// SetVersion()
+// Sets the version the image is saved as, adding or dropping the resource
+// dictionary as the version needs.
 //
-VTFImageFormat CVTFFile::GetFormat() const
+vlBool CVTFFile::SetVersion(vlUInt uiMajorVersion, vlUInt uiMinorVersion)
 {
 	if(!this->IsLoaded())
-		return IMAGE_FORMAT_NONE;
-
-	return this->Header->ImageFormat;
+	{
+		LastError.Set("No image loaded.");
+		return vlFalse;
+	}
+
+	if(uiMajorVersion != VTF_MAJOR_VERSION || uiMinorVersion > VTF_MINOR_VERSION)
+	{
+		LastError.SetFormatted("File version %u.%u does not match %d.%d to %d.%d.", uiMajorVersion, uiMinorVersion, VTF_MAJOR_VERSION, 0, VTF_MAJOR_VERSION, VTF_MINOR_VERSION);
+		return vlFalse;
+	}
+
+	if(uiMinorVersion < VTF_MINOR_VERSION_MIN_VOLUME && this->Header->Depth > 1)
+	{
+		LastError.SetFormatted("Volume textures are only supported in version %d.%d and up.", VTF_MAJOR_VERSION, VTF_MINOR_VERSION_MIN_VOLUME);
+		return vlFalse;
+	}
+
+	// Whether an environment map has a sphere map depends on the version, so
+	// don't let the image data change meaning.
+	SVTFHeader NewHeader = *this->Header;
+	NewHeader.Version[0] = uiMajorVersion;
+	NewHeader.Version[1] = uiMinorVersion;
+	if(ComputeFaceCount(NewHeader) != ComputeFaceCount(*this->Header))
+	{
+		LastError.SetFormatted("Version %u.%u would change the image's face count.", uiMajorVersion, uiMinorVersion);
+		return vlFalse;
+	}
+
+	vlBool bHadResources = this->GetSupportsResources();
+
+	this->Header->Version[0] = uiMajorVersion;
+	this->Header->Version[1] = uiMinorVersion;
+
+	if(bHadResources && !this->GetSupportsResources())
+	{
+		for(vlUInt i = 0; i < this->Header->ResourceCount; i++)
+		{
+			delete []this->Header->Data[i].Data;
+			this->Header->Data[i].Size = 0;
+			this->Header->Data[i].Data = 0;
+		}
+	}
+	else if(!bHadResources && this->GetSupportsResources())
+	{
+		this->Header->ResourceCount = 0;
+
+		if(this->lpThumbnailImageData != 0)
+		{
+			this->Header->Resources[this->Header->ResourceCount++].Type = VTF_LEGACY_RSRC_LOW_RES_IMAGE;
+		}
+
+		this->Header->Resources[this->Header->ResourceCount++].Type = VTF_LEGACY_RSRC_IMAGE;
+	}
+
+	this->ComputeResources();
+
+	return vlTrue;
 }
 
 //
-// GetData()
-// Gets the image data of the specified frame, face and mipmap in the format
-// of the image.
+// ComputeResources()
+// Computes header VTF directory resources.
 //
-vlByte *CVTFFile::GetData(vlUInt uiFrame, vlUInt uiFace, vlUInt uiSlice, vlUInt uiMipmapLevel) const
+vlVoid CVTFFile::ComputeResources()
 {
 	if(!this->IsLoaded())
-		return 0;
+		return;
 
-	return this->lpImageData + this->ComputeDataOffset(uiFrame, uiFace, uiSlice, uiMipmapLevel, this->Header->ImageFormat);
+	// Correct resource count.
+	if(!this->GetSupportsResources())
+	{
+		this->Header->ResourceCount = 0;
+	}
+
+	// Correct header size.
+	STATIC_ASSERT(VTF_MAJOR_VERSION == 7, "HeaderSize needs calculation for new major version.");
+	STATIC_ASSERT(VTF_MINOR_VERSION == 5, "HeaderSize needs calculation for new minor version.");
+	switch(this->Header->Version[0])
+	{
+	case 7:
+		switch(this->Header->Version[1])
+		{
+		case 0:
+			this->Header->HeaderSize = sizeof(SVTFHeader_70_A);
+			break;
+		case 1:
+			this->Header->HeaderSize = sizeof(SVTFHeader_71_A);
+			break;
+		case 2:
+			this->Header->HeaderSize = sizeof(SVTFHeader_72_A);
+			break;
+		case 3:
+			this->Header->HeaderSize = sizeof(SVTFHeader_73_A) + this->Header->ResourceCount * sizeof(SVTFResource);
+			break;
+		case 4:
+			this->Header->HeaderSize = sizeof(SVTFHeader_74_A) + this->Header->ResourceCount * sizeof(SVTFResource);
+			break;
+		case 5:
+			this->Header->HeaderSize = sizeof(SVTFHeader_75_A) + this->Header->ResourceCount * sizeof(SVTFResource);
+			break;
+		}
+		break;
+	}
+
+	// Correct resource offsets.
+	vlUInt uiOffset = this->Header->HeaderSize;
+	for(vlUInt i = 0; i < this->Header->ResourceCount; i++)
+	{
+		switch(this->Header->Resources[i].Type)
+		{
+		case VTF_LEGACY_RSRC_LOW_RES_IMAGE:
+			this->Header->Resources[i].Data = uiOffset;
+			uiOffset += this->uiThumbnailBufferSize;
+			break;
+		case VTF_LEGACY_RSRC_IMAGE:
+			this->Header->Resources[i].Data = uiOffset;
+			uiOffset += this->uiImageBufferSize;
+			break;
+		default:
+			if((this->Header->Resources[i].Flags & RSRCF_HAS_NO_DATA_CHUNK) == 0)
+			{
+				this->Header->Resources[i].Data = uiOffset;
+				uiOffset += sizeof(vlUInt) + this->Header->Data[i].Size;
+			}
+			break;
+		}
+	}
 }
 
 //
-// SetData()
-// Sets the image data of the specified frame, face and mipmap.  Image data
-// must be in the format of the image.
+// GetSize()
+// Returns the size of the VTF file in bytes.
 //
-vlVoid CVTFFile::SetData(vlUInt uiFrame, vlUInt uiFace, vlUInt uiSlice, vlUInt uiMipmapLevel, vlByte *lpData)
+vlUInt CVTFFile::GetSize() const
 {
-	if(!this->IsLoaded() || this->lpImageData == 0)
-		return;
+	if(!this->IsLoaded())
+		return 0;
 
-	memcpy(this->lpImageData + this->ComputeDataOffset(uiFrame, uiFace, uiSlice, uiMipmapLevel, this->Header->ImageFormat), lpData, CVTFFile::ComputeMipmapSize(this->Header->Width, this->Header->Height, 1, uiMipmapLevel, this->Header->ImageFormat));
+	vlUInt uiResourceSize = 0;
+	if(this->GetSupportsResources())
+	{
+		for(vlUInt i = 0; i < this->Header->ResourceCount; i++)
+		{
+			switch(this->Header->Resources[i].Type)
+			{
+			case VTF_LEGACY_RSRC_LOW_RES_IMAGE:
+			case VTF_LEGACY_RSRC_IMAGE:
+				break;
+			default:
+				if((this->Header->Resources[i].Flags & RSRCF_HAS_NO_DATA_CHUNK) == 0)
+				{
+					uiResourceSize += sizeof(vlUInt) + this->Header->Data[i].Size;
+				}
+				break;
+			}
+		}
+	}
+
+	return this->Header->HeaderSize + this->uiThumbnailBufferSize + this->uiImageBufferSize + uiResourceSize;
 }
 
 //
-// GetHasThumbnail()
-// A image does not need a thumbnail, this function returns wheather
-// the image has a thumbnail or not.
+// GetWidth()
+// Gets the width of the largest level mipmap.
 //
-vlBool CVTFFile::GetHasThumbnail() const
+vlUInt CVTFFile::GetWidth() const
 {
 	if(!this->IsLoaded())
-		return vlFalse;
+		return 0;
 
-	return this->Header->LowResImageFormat != IMAGE_FORMAT_NONE;
+	return this->Header->Width;
 }
 
 //
-// GetThumbnailWidth()
-// Gets the width of the thumbnail image.
+// GetHeight()
+// Gets the height of the largest level mipmap.
 //
-vlUInt CVTFFile::GetThumbnailWidth() const
+vlUInt CVTFFile::GetHeight() const
 {
 	if(!this->IsLoaded())
 		return 0;
 
-	return this->Header->LowResImageWidth;
+	return this->Header->Height;
 }
 
 //
-// GetThumbnailHeight()
-// Sets the height of the thumbnail image.
+// GetDepth()
+// Gets the depth of the largest level mipmap.
 //
-vlUInt CVTFFile::GetThumbnailHeight() const
+vlUInt CVTFFile::GetDepth() const
 {
 	if(!this->IsLoaded())
 		return 0;
 
-	return this->Header->LowResImageHeight;
+	return this->Header->Depth;
 }
 
 //
-// GetThumbnailFormat()
-// Gets the format of the thumbnail image.
+// GetFrameCount()
+// Gets the number of frames the image has.  All images have at least 1 frame.
 //
-VTFImageFormat CVTFFile::GetThumbnailFormat() const
+vlUInt CVTFFile::GetFrameCount() const
 {
 	if(!this->IsLoaded())
-		return IMAGE_FORMAT_NONE;
+		return 0;
 
-	return this->Header->LowResImageFormat;
+	return this->Header->Frames;
 }
 
+//---------------------------------------------------------------------------------
+// GetFaceCount()
 //
-// GetThumbnailData()
-// Gets the thumbnail image data in the format of the image.  This "thumbnail"
-// image is a small same of the original image used by the engine for color sampling
-// when you hit the wall with a crowbar etc.
-//
-vlByte *CVTFFile::GetThumbnailData() const
+// Returns the number of faces in the texture based on the status of the header
+// flags. Cubemaps have 6 or 7 faces, others just 1.
+//---------------------------------------------------------------------------------
+vlUInt CVTFFile::GetFaceCount() const
 {
 	if(!this->IsLoaded())
 		return 0;
 
-	return this->lpThumbnailImageData;
+	return ComputeFaceCount(*this->Header);
 }
 
 //
-// SetThumbnailData()
-// Sets the thumbnail image data.  Image data must be in the format of the image.
+// ComputeFaceCount()
+// Gets the number of faces a header describes.
 //
-vlVoid CVTFFile::SetThumbnailData(vlByte *lpData)
+vlUInt CVTFFile::ComputeFaceCount(const SVTFHeader &Header)
 {
-	if(!this->IsLoaded() || this->lpThumbnailImageData == 0)
-		return;
-
-	memcpy(this->lpThumbnailImageData, lpData, this->uiThumbnailBufferSize/*CVTFFile::ComputeImageSize(this->Header->LowResImageWidth, this->Header->LowResImageHeight, this->Header->LowResImageFormat)*/);
+	return Header.Flags & TEXTUREFLAGS_ENVMAP ? (Header.StartFrame != 0xffff && Header.Version[1] < VTF_MINOR_VERSION_MIN_NO_SPHERE_MAP ? CUBEMAP_FACE_COUNT : CUBEMAP_FACE_COUNT - 1) : 1;
 }
 
-vlBool CVTFFile::GetSupportsResources() const
+//
+// GetMipmapCount()
+// Gets the number of mipmaps the image has.
+//
+vlUInt CVTFFile::GetMipmapCount() const
 {
 	if(!this->IsLoaded())
-		return vlFalse;
+		return 0;
 
-	return this->Header->Version[0] > VTF_MAJOR_VERSION || (this->Header->Version[0] == VTF_MAJOR_VERSION && this->Header->Version[1] >= VTF_MINOR_VERSION_MIN_RESOURCE);
+	return this->Header->MipCount;
 }
 
-vlUInt CVTFFile::GetResourceCount() const
+//
+// GetStartFrame()
+// Gets the first frame in the animation sequence.  If the image is
+// an enviroment map and 0xffff is returned, the enviroment map has
+// no sphere map.
+//
+vlUInt CVTFFile::GetStartFrame() const
 {
-	if(!this->GetSupportsResources())
+	if(!this->IsLoaded())
 		return 0;
 
-	return this->Header->ResourceCount;
+	return this->Header->StartFrame;
 }
 
-vlUInt CVTFFile::GetResourceType(vlUInt uiIndex) const
+//
+// SetStartFrame()
+// Sets the first frame in the animation sequence.
+//
+vlVoid CVTFFile::SetStartFrame(vlUInt uiStartFrame)
 {
-	if(!this->GetSupportsResources())
-		return 0;
-
-	if(uiIndex >= this->Header->ResourceCount)
-		return 0;
+	if(!this->IsLoaded())
+		return;
 
-	return this->Header->Resources[uiIndex].Type;
-}
+	// Note: Valve informs us that animated enviroment maps ARE possible.
+	// The StartFrame MAY be valid but there is the issue of the enviroment
+	// maps without sphere maps.  This is trivial...
 
-vlBool CVTFFile::GetHasResource(vlUInt uiType) const
-{
-	if(!this->GetSupportsResources())
-		return vlFalse;
+	// Don't let the user set the start frame of an enviroment map.
+	if(this->Header->Flags & TEXTUREFLAGS_ENVMAP)
+	{
+		return;
+	}
 
-	for(vlUInt i = 0; i < this->Header->ResourceCount; i++)
+	if(uiStartFrame >= (vlUInt)this->Header->Frames)
 	{
-		if(this->Header->Resources[i].Type == uiType)
-		{
-			return vlTrue;
-		}
+		uiStartFrame = (vlUInt)this->Header->Frames - 1;
 	}
 
-	return vlFalse;
+	this->Header->StartFrame = (vlUShort)uiStartFrame;
 }
 
-vlVoid *CVTFFile::GetResourceData(vlUInt uiType, vlUInt &uiSize) const
-{
-	if(this->IsLoaded())
+//
+// GetFlags()
+// Gets the flags associated with the image.  These flags
+// are stored in the VTFImageFlag enumeration.
+//
+vlUInt CVTFFile::GetFlags() const
+{
+	if(!this->IsLoaded())
+		return 0;
+
+	return this->Header->Flags;
+}
+
+// SetFlags()
+// Sets the flags associated with the image.  These flags
+// are stored in the VTFImageFlag enumeration.
+//
+vlVoid CVTFFile::SetFlags(vlUInt uiFlags)
+{
+	if(!this->IsLoaded())
+		return;
+
+	// Don't let the user set flags critical to the image's format.
+	//if(this->Header->Version[0] < VTF_MAJOR_VERSION || (this->Header->Version[0] == VTF_MAJOR_VERSION && this->Header->Version[1] <= VTF_MINOR_VERSION_MIN_RESOURCE))
+	//{
+	//	if(this->Header->Flags & TEXTUREFLAGS_DEPRECATED_NOCOMPRESS)
+	//		uiFlags |= TEXTUREFLAGS_DEPRECATED_NOCOMPRESS;
+	//	else
+	//		uiFlags &= ~TEXTUREFLAGS_DEPRECATED_NOCOMPRESS;
+	//}
+
+	if(this->Header->Flags & TEXTUREFLAGS_EIGHTBITALPHA)
+		uiFlags |= TEXTUREFLAGS_EIGHTBITALPHA;
+	else
+		uiFlags &= ~TEXTUREFLAGS_EIGHTBITALPHA;
+
+	if(this->Header->Flags & TEXTUREFLAGS_ENVMAP)
+		uiFlags |= TEXTUREFLAGS_ENVMAP;
+	else
+		uiFlags &= ~TEXTUREFLAGS_ENVMAP;
+
+	if(this->Header->Flags & TEXTUREFLAGS_ENVMAP)
+		uiFlags |= TEXTUREFLAGS_ENVMAP;
+	else
+		uiFlags &= ~TEXTUREFLAGS_ENVMAP;
+
+	this->Header->Flags = uiFlags;
+}
+
+//
+// GetFlag()
+// Gets the status of the specified flag in the image.
+//
+vlBool CVTFFile::GetFlag(VTFImageFlag ImageFlag) const
+{
+	if(!this->IsLoaded())
+		return vlFalse;
+
+	return (this->Header->Flags & ImageFlag) != 0;
+}
+
+//
+// SetFlag()
+// Sets the flag ImageFlag to bState (set or not set).  Flags critical
+// to the image's format cannot be set.
+//
+vlVoid CVTFFile::SetFlag(VTFImageFlag ImageFlag, vlBool bState)
+{
+	if(!this->IsLoaded())
+		return;
+
+	//if(this->Header->Version[0] < VTF_MAJOR_VERSION || (this->Header->Version[0] == VTF_MAJOR_VERSION && this->Header->Version[1] <= VTF_MINOR_VERSION_MIN_RESOURCE))
+	//{
+	//	if(ImageFlag == TEXTUREFLAGS_DEPRECATED_NOCOMPRESS)
+	//	{
+	//		return;
+	//	}
+	//}
+
+	// Don't let the user set flags critical to the image's format.
+	if(ImageFlag == TEXTUREFLAGS_ONEBITALPHA || ImageFlag == TEXTUREFLAGS_EIGHTBITALPHA || ImageFlag == TEXTUREFLAGS_ENVMAP)
+	{
+		return;
+	}
+
+	if(bState)
+	{
+		this->Header->Flags |= ImageFlag;
+	}
+	else
+	{
+		this->Header->Flags &= ~ImageFlag;
+	}
+}
+
+//
+// GetBumpmapScale()
+// Gets the bumpmap scale of the image.
+//
+vlSingle CVTFFile::GetBumpmapScale() const
+{
+	if(!this->IsLoaded())
+		return 0.0f;
+
+	return this->Header->BumpScale;
+}
+
+//
+// SetBumpmapScale()
+// Sets the bumpmap scale of the image.
+//
+vlVoid CVTFFile::SetBumpmapScale(vlSingle sBumpmapScale)
+{
+	if(!this->IsLoaded())
+		return;
+
+	this->Header->BumpScale = sBumpmapScale;
+}
+
+//
+// GetReflectivity()
+// Gets the reflectivity of the image.
+//
+vlVoid CVTFFile::GetReflectivity(vlSingle &sX, vlSingle &sY, vlSingle &sZ) const
+{
+	if(!this->IsLoaded())
+		return;
+
+	sX = this->Header->Reflectivity[0];
+	sY = this->Header->Reflectivity[1];
+	sZ = this->Header->Reflectivity[2];
+}
+
+//
+// SetReflectivity()
+// Sets the reflectivity of the image.
+//
+vlVoid CVTFFile::SetReflectivity(vlSingle sX, vlSingle sY, vlSingle sZ)
+{
+	if(!this->IsLoaded())
+		return;
+
+	this->Header->Reflectivity[0] = sX;
+	this->Header->Reflectivity[1] = sY;
+	this->Header->Reflectivity[2] = sZ;
+}
+
+//
+// GetFormat()
+// Gets the format of the image.
+//
+VTFImageFormat CVTFFile::GetFormat() const
+{
+	if(!this->IsLoaded())
+		return IMAGE_FORMAT_NONE;
+
+	return this->Header->ImageFormat;
+}
+
+//
+// GetData()
+// Gets the image data of the specified frame, face and mipmap in the format
+// of the image.
+//
+vlByte *CVTFFile::GetData(vlUInt uiFrame, vlUInt uiFace, vlUInt uiSlice, vlUInt uiMipmapLevel) const
+{
+	if(!this->IsLoaded())
+		return 0;
+
+	return this->lpImageData + this->ComputeDataOffset(uiFrame, uiFace, uiSlice, uiMipmapLevel, this->Header->ImageFormat);
+}
+
+//
+// SetData()
+// Sets the image data of the specified frame, face and mipmap.  Image data
+// must be in the format of the image.
+//
+vlVoid CVTFFile::SetData(vlUInt uiFrame, vlUInt uiFace, vlUInt uiSlice, vlUInt uiMipmapLevel, vlByte *lpData)
+{
+	if(!this->IsLoaded() || this->lpImageData == 0)
+		return;
+
+	memcpy(this->lpImageData + this->ComputeDataOffset(uiFrame, uiFace, uiSlice, uiMipmapLevel, this->Header->ImageFormat), lpData, CVTFFile::ComputeMipmapSize(this->Header->Width, this->Header->Height, 1, uiMipmapLevel, this->Header->ImageFormat));
+}
+
+//
+// SetData()
+// Replaces all the image data with a buffer of the same size and layout,
+// taking ownership of it.
+//
+vlBool CVTFFile::SetData(vlByte *lpImageData, vlUInt uiImageDataSize, PFreeProc pFree, vlVoid *pUserData)
+{
+	if(!this->IsLoaded() || this->lpImageData == 0)
+	{
+		LastError.Set("No image data loaded.");
+		return vlFalse;
+	}
+
+	if(lpImageData == 0 || pFree == 0)
+	{
+		LastError.Set("Image data and free proc must be set.");
+		return vlFalse;
+	}
+
+	if(uiImageDataSize != this->uiImageBufferSize)
+	{
+		LastError.SetFormatted("Image data is %u bytes, expected %u.", uiImageDataSize, this->uiImageBufferSize);
+		return vlFalse;
+	}
+
+	if(lpImageData != this->lpImageData)
+	{
+		this->FreeImageData();
+
+		this->uiImageBufferSize = uiImageDataSize;
+		this->lpImageData = lpImageData;
+		this->pImageDataFree = pFree;
+		this->pImageDataUserData = pUserData;
+	}
+
+	return vlTrue;
+}
+
+//
+// GetHasThumbnail()
+// A image does not need a thumbnail, this function returns wheather
+// the image has a thumbnail or not.
+//
+vlBool CVTFFile::GetHasThumbnail() const
+{
+	if(!this->IsLoaded())
+		return vlFalse;
+
+	return this->Header->LowResImageFormat != IMAGE_FORMAT_NONE;
+}
+
+//
+// GetThumbnailWidth()
+// Gets the width of the thumbnail image.
+//
+vlUInt CVTFFile::GetThumbnailWidth() const
+{
+	if(!this->IsLoaded())
+		return 0;
+
+	return this->Header->LowResImageWidth;
+}
+
+//
+// GetThumbnailHeight()
+// Sets the height of the thumbnail image.
+//
+vlUInt CVTFFile::GetThumbnailHeight() const
+{
+	if(!this->IsLoaded())
+		return 0;
+
+	return this->Header->LowResImageHeight;
+}
+
+//
+// GetThumbnailFormat()
+// Gets the format of the thumbnail image.
+//
+VTFImageFormat CVTFFile::GetThumbnailFormat() const
+{
+	if(!this->IsLoaded())
+		return IMAGE_FORMAT_NONE;
+
+	return this->Header->LowResImageFormat;
+}
+
+//
+// GetThumbnailData()
+// Gets the thumbnail image data in the format of the image.  This "thumbnail"
+// image is a small same of the original image used by the engine for color sampling
+// when you hit the wall with a crowbar etc.
+//
+vlByte *CVTFFile::GetThumbnailData() const
+{
+	if(!this->IsLoaded())
+		return 0;
+
+	return this->lpThumbnailImageData;
+}
+
+//
+// SetThumbnailData()
+// Sets the thumbnail image data.  Image data must be in the format of the image.
+//
+vlVoid CVTFFile::SetThumbnailData(vlByte *lpData)
+{
+	if(!this->IsLoaded() || this->lpThumbnailImageData == 0)
+		return;
+
+	memcpy(this->lpThumbnailImageData, lpData, this->uiThumbnailBufferSize/*CVTFFile::ComputeImageSize(this->Header->LowResImageWidth, this->Header->LowResImageHeight, this->Header->LowResImageFormat)*/);
+}
+
+vlBool CVTFFile::GetSupportsResources() const
+{
+	if(!this->IsLoaded())
+		return vlFalse;
+
+	return this->Header->Version[0] > VTF_MAJOR_VERSION || (this->Header->Version[0] == VTF_MAJOR_VERSION && this->Header->Version[1] >= VTF_MINOR_VERSION_MIN_RESOURCE);
+}
+
+vlUInt CVTFFile::GetResourceCount() const
+{
+	if(!this->GetSupportsResources())
+		return 0;
+
+	return this->Header->ResourceCount;
+}
+
+vlUInt CVTFFile::GetResourceType(vlUInt uiIndex) const
+{
+	if(!this->GetSupportsResources())
+		return 0;
+
+	if(uiIndex >= this->Header->ResourceCount)
+		return 0;
+
+	return this->Header->Resources[uiIndex].Type;
+}
+
+vlBool CVTFFile::GetHasResource(vlUInt uiType) const
+{
+	if(!this->GetSupportsResources())
+		return vlFalse;
+
+	for(vlUInt i = 0; i < this->Header->ResourceCount; i++)
+	{
+		if(this->Header->Resources[i].Type == uiType)
+		{
+			return vlTrue;
+		}
+	}
+
+	return vlFalse;
+}
+
+vlVoid *CVTFFile::GetResourceData(vlUInt uiType, vlUInt &uiSize) const
+{
+	if(this->IsLoaded())
+	{
+		if(this->GetSupportsResources())
+		{
+			switch(uiType)
+			{
+			case VTF_LEGACY_RSRC_LOW_RES_IMAGE:
+				uiSize = this->uiThumbnailBufferSize;
+				return this->lpThumbnailImageData;
+				break;
+			case VTF_LEGACY_RSRC_IMAGE:
+				uiSize = this->uiImageBufferSize;
+				return this->lpImageData;
+				break;
+			default:
+				for(vlUInt i = 0; i < this->Header->ResourceCount; i++)
+				{
+					if(this->Header->Resources[i].Type == uiType)
+					{
+						if(this->Header->Resources[i].Flags & RSRCF_HAS_NO_DATA_CHUNK)
+						{
+							uiSize = sizeof(vlUInt);
+							return &this->Header->Resources[i].Data;
+						}
+						else
+						{
+							uiSize = this->Header->Data[i].Size;
+							return this->Header->Data[i].Data;
+						}
+					}
+				}
+				break;
+			}
+		}
+		else
+		{
+			LastError.Set("Resources require VTF file version v7.3 and up.");
+		}
+	}
+
+	uiSize = 0;
+	return 0;
+}
+
+vlVoid *CVTFFile::SetResourceData(vlUInt uiType, vlUInt uiSize, vlVoid *lpData)
+{
+	if(this->IsLoaded())
+	{
+		if(this->GetSupportsResources())
+		{
+			switch(uiType)
+			{
+			case VTF_LEGACY_RSRC_LOW_RES_IMAGE:
+				LastError.Set("Low resolution image resource cannot be modified through resource interface.");
+				break;
+			case VTF_LEGACY_RSRC_IMAGE:
+				LastError.Set("Image resource cannot be modified through resource interface.");
+				break;
+			default:
+				for(vlUInt i = 0; i < this->Header->ResourceCount; i++)
+				{
+					if(this->Header->Resources[i].Type == uiType)
+					{
+						if(uiSize == 0)
+						{
+							delete []this->Header->Data[i].Data;
+							for(vlUInt j = i + 1; j < this->Header->ResourceCount; j++)
+							{
+								this->Header->Resources[j - 1] = this->Header->Resources[j];
+								this->Header->Data[j - 1] = this->Header->Data[j];
+							}
+							this->Header->ResourceCount--;
+							this->ComputeResources();
+							return 0;
+						}
+						else
+						{
+							if(this->Header->Resources[i].Flags & RSRCF_HAS_NO_DATA_CHUNK)
+							{
+								if(uiSize != sizeof(vlUInt))
+								{
+									LastError.Set("Resources with no data chunk must have size 4.");
+									return 0;
+								}
+								if(lpData == 0)
+								{
+									this->Header->Resources[i].Data= 0;
+								}
+								else if(&this->Header->Resources[i].Data != lpData)
+								{
+									this->Header->Resources[i].Data = *(vlUInt *)lpData;
+								}
+								return &this->Header->Resources[i].Data;
+							}
+							else
+							{
+								if(this->Header->Data[i].Size != uiSize)
+								{
+									delete []this->Header->Data[i].Data;
+									this->Header->Data[i].Size = uiSize;
+									this->Header->Data[i].Data = new vlByte[uiSize];
+									this->ComputeResources();
+								}
+								if(lpData == 0)
+								{
+									memset(this->Header->Data[i].Data, 0, this->Header->Data[i].Size);
+								}
+								else if(this->Header->Data[i].Data != lpData)
+								{
+									memcpy(this->Header->Data[i].Data, lpData, this->Header->Data[i].Size);
+								}
+								return this->Header->Data[i].Data;
+							}
+						}
+					}
+				}
+
+				// Resource not found.
+				if(uiSize != 0)
+				{
+					if(this->Header->ResourceCount == VTF_RSRC_MAX_DICTIONARY_ENTRIES)
+					{
+						LastError.SetFormatted("Maximum directory entry count %u reached.", VTF_RSRC_MAX_DICTIONARY_ENTRIES);
+						return 0;
+					}
+
+					vlUInt uiIndex = this->Header->ResourceCount;
+
+					this->Header->Resources[uiIndex].Type = uiType;
+					this->Header->Resources[uiIndex].Data = 0;
+
+					this->Header->Data[uiIndex].Size = 0;
+					this->Header->Data[uiIndex].Data = 0;
+
+					if(this->Header->Resources[uiIndex].Flags & RSRCF_HAS_NO_DATA_CHUNK)
+					{
+						if(uiSize != sizeof(vlUInt))
+						{
+							LastError.Set("Resources with no data chunk must have size 4.");
+							return 0;
+						}
+						if(lpData != 0)
+						{
+							this->Header->Resources[uiIndex].Data = *(vlUInt *)lpData;
+						}
+						else
+						{
+							this->Header->Resources[uiIndex].Data = 0;
+						}
+						this->Header->ResourceCount++;
+						this->ComputeResources();
+						return &this->Header->Resources[uiIndex].Data;
+					}
+					else
+					{
+						this->Header->Data[uiIndex].Size = uiSize;
+						this->Header->Data[uiIndex].Data = new vlByte[uiSize];
+						if(lpData != 0)
+						{
+							memcpy(this->Header->Data[uiIndex].Data, lpData, this->Header->Data[uiIndex].Size);
+						}
+						else
+						{
+							memset(this->Header->Data[uiIndex].Data, 0, this->Header->Data[uiIndex].Size);
+						}
+						this->Header->ResourceCount++;
+						this->ComputeResources();
+						return this->Header->Data[uiIndex].Data;
+					}
+				}
+				break;
+			}
+		}
+		else
+		{
+			LastError.Set("Resources require VTF file version v7.3 and up.");
+		}
+	}
+
+	return 0;
+}
+
+//
+// GenerateMipmaps()
+// Generate mipmaps from the first mipmap level.
+//
+vlBool CVTFFile::GenerateMipmaps(VTFMipmapFilter MipmapFilter, VTFSharpenFilter SharpenFilter)
+{
+	if(!this->IsLoaded())
+		return vlFalse;
+
+	if(this->Header->MipCount == 0)
+		return vlTrue;
+
+	vlUInt uiFrameCount = this->GetFrameCount();
+	vlUInt uiFaceCount = this->GetFaceCount();
+
+	for(vlUInt i = 0; i < uiFrameCount; i++)
+	{
+		for(vlUInt j = 0; j < uiFaceCount; j++)
+		{
+			if(!this->GenerateMipmaps(i, j, MipmapFilter, SharpenFilter))
+			{
+				return vlFalse;
+			}
+		}
+	}
+
+	return vlTrue;
+}
+
+//
+// GenerateMipmaps()
+// Generate mipmaps from the first mipmap level of the specified frame and face.
+//
+vlBool CVTFFile::GenerateMipmaps(vlUInt uiFace, vlUInt uiFrame, VTFMipmapFilter MipmapFilter, VTFSharpenFilter SharpenFilter)
+{
+	if(!this->IsLoaded())
+		return vlFalse;
+
+#ifdef USE_NVDXT
+	if(this->lpImageData == 0)
+	{
+		LastError.Set("No image data to generate mipmaps from.");
+		return vlFalse;
+	}
+
+	if(this->Header->Depth > 1)
+	{
+		LastError.Set("Mipmap generation for depth textures is not supported.");
+		return vlFalse;
+	}
+
+	assert(MipmapFilter >= 0 && MipmapFilter < MIPMAP_FILTER_COUNT);
+
+	assert(SharpenFilter >= 0 && SharpenFilter < SHARPEN_FILTER_COUNT);
+
+	if(this->Header->MipCount == 1)
+	{
+		return vlTrue;
+	}
+
+	// The mipmap callback NVMipmapCallback() will call ConvertFromRGBA8888() which will use the
+	// NVDXT lib to compress the image data if it is in a DXT format.  This is bad!!!  The
+	// nvDXTcompressRGBA() function only seems to be able to handle one call at a time and since
+	// we made a call for the mipmap generation the thing will crash.  Hence all this DXT nonsense.
+	// This took me a LONG time to figure out!  Go NVidia docs...
+	// Sidenote: this could very well cause problems in multithreaded applications!
+
+	// Get the format to generate mipmaps to.
+	VTFImageFormat MipmapImageFormat;
+	switch(this->Header->ImageFormat)
+	{
+	case IMAGE_FORMAT_DXT1:
+	case IMAGE_FORMAT_DXT1_ONEBITALPHA:
+	case IMAGE_FORMAT_DXT3:
+	case IMAGE_FORMAT_DXT5:
+		MipmapImageFormat = this->Header->ImageFormat;
+		break;
+	default:
+		MipmapImageFormat = IMAGE_FORMAT_RGBA8888;
+		break;
+	}
+
+	SVTFLibOptions VTFLibOptions;
+	this->ResolveOptions(VTFLibOptions);
+
+	nvCompressionOptions Options = nvCompressionOptions();
+
+	SNVCompressionUserData UserData = SNVCompressionUserData(this, uiFace, uiFrame, 0, MipmapImageFormat, VTFLibOptions);
+
+	// Don't generate mipmaps.
+	Options.mipMapGeneration = kGenerateMipMaps;
+
+	Options.mipFilterType = (nvMipFilterTypes)MipmapFilter;
+
+	// Setup sharpen filter.
+	if(SharpenFilter != MAX_MIP_MAPS)
+	{
+		Options.sharpenFilterType = (nvSharpenFilterTypes)SharpenFilter;
+		Options.sharpening_passes_per_mip_level[0] = 0;
+		for(vlUInt k = 1; k < MAX_MIP_MAPS; k++)
+		{
+			Options.sharpening_passes_per_mip_level[k] = 1;
+		}
+		Options.unsharp_data.radius32F = VTFLibOptions.sUnsharpenRadius;
+		Options.unsharp_data.amount32F = VTFLibOptions.sUnsharpenAmount;
+		Options.unsharp_data.threshold32F = VTFLibOptions.sUnsharpenThreshold;
+		Options.xsharp_data.strength32F = VTFLibOptions.sXSharpenStrength;
+		Options.xsharp_data.threshold32F = VTFLibOptions.sXSharpenThreshold;
+	}
+
+	// Set the format.
+	switch(VTFLibOptions.uiDXTQuality)
+	{
+	case DXT_QUALITY_LOW:
+		Options.quality = kQualityFastest;
+		break;
+	case DXT_QUALITY_MEDIUM:
+		Options.quality = kQualityNormal;
+		break;
+	case DXT_QUALITY_HIGH:
+		Options.quality = kQualityProduction;
+		break;
+	case DXT_QUALITY_HIGHEST:
+		Options.quality = kQualityHighest;
+		break;
+	}
+	switch(MipmapImageFormat)
+	{
+	case IMAGE_FORMAT_DXT1:
+		Options.textureFormat = kDXT1;
+		Options.bForceDXT1FourColors = true;
+		break;
+	case IMAGE_FORMAT_DXT1_ONEBITALPHA:
+		Options.bBinaryAlpha = true;
+		Options.bForceDXT1FourColors = true;
+		Options.textureFormat = kDXT1a;
+		break;
+	case IMAGE_FORMAT_DXT3:
+		Options.textureFormat = kDXT3;
+		break;
+	case IMAGE_FORMAT_DXT5:
+		Options.textureFormat = kDXT5;
+		break;
+	case IMAGE_FORMAT_RGBA8888:
+		Options.textureFormat = k8888;
+		Options.bSwapRB = true;
+		break;
+	}
+
+	if(MipmapImageFormat != IMAGE_FORMAT_RGBA8888)
+	{
+		// nvDXTcompressRGBA() fails on widths or heights of 1 or 2 so rescale those images.
+		if(this->Header->Width < 4)
+		{
+			Options.rescaleImageType = kRescalePreScale;
+			Options.rescaleImageFilter = kMipFilterPoint;
+			Options.scaleX = 4.0f;
+		}
+
+		if(this->Header->Height < 4)
+		{
+			Options.rescaleImageType = kRescalePreScale;
+			Options.rescaleImageFilter = kMipFilterPoint;
+			Options.scaleY = 4.0f;
+		}
+	}
+
+	// The UserData struct gets passed to our callback.
+	Options.user_data = &UserData;
+
+	Memory::CScratchBuffer ImageData(this->ComputeImageSize(this->Header->Width, this->Header->Height, 1, IMAGE_FORMAT_RGBA8888));
+	vlByte *lpImageData = ImageData.Get();
+	
+	if(!this->ConvertToRGBA8888(this->GetData(uiFace, uiFrame, 0, 0), lpImageData, this->Header->Width, this->Header->Height, this->Header->ImageFormat, VTFLibOptions))
+	{
+		return vlFalse;
+	}
+
+	if(!nvDXTCompressWrapper(lpImageData, this->Header->Width, this->Header->Height, &Options, NVWriteCallback))
+	{
+		return vlFalse;
+	}
+
+	return vlTrue;
+#else
+	LastError.Set("NVDXT support required for CVTFFile::GenerateMipmaps().");
+	return vlFalse;
+#endif
+}
+
+//
+// GenerateThumbnail()
+// We should have a mipmap that matches the thumbnail size.  This function finds it and
+// copies it over to the mipmap data, converting it if need be.
+//
+vlBool CVTFFile::GenerateThumbnail()
+{
+	if(!this->IsLoaded())
+		return vlFalse;
+
+	if(!this->GetHasThumbnail())
+	{
+		LastError.Set("VTF file does not have a thumbnail.");
+		return vlFalse;
+	}
+
+	if(this->lpImageData == 0)
+	{
+		LastError.Set("No image data to generate thumbnail from.");
+		return vlFalse;
+	}
+
+	SVTFLibOptions VTFLibOptions;
+	this->ResolveOptions(VTFLibOptions);
+
+	// Find a mipmap that matches the size of the thumbnail.
+	for(vlUInt i = 0; i < this->Header->MipCount; i++)
+	{
+		vlUInt uiMipmapWidth, uiMipmapHeight, uiMipmapDepth;
+		CVTFFile::ComputeMipmapDimensions(this->Header->Width, this->Header->Height, 1, i, uiMipmapWidth, uiMipmapHeight, uiMipmapDepth);
+
+		if(uiMipmapWidth == (vlUInt)this->Header->LowResImageWidth && uiMipmapHeight == (vlUInt)this->Header->LowResImageHeight)
+		{
+			// Check if it is the same format (in which case copy it) otherwise convert
+			// it to the right format and copy it.
+			if(this->Header->ImageFormat == this->Header->LowResImageFormat)
+			{
+				this->SetThumbnailData(this->GetData(0, 0, 0, i));
+			}
+			else
+			{
+				if(!CVTFFile::Convert(this->GetData(0, 0, 0, i), this->GetThumbnailData(), uiMipmapWidth, uiMipmapHeight, this->Header->ImageFormat, this->Header->LowResImageFormat, VTFLibOptions))
+				{
+					return vlFalse;
+				}
+			}
+			return vlTrue;
+		}
+	}
+
+	// We don't have a matching mipmap (maybe we have no mipmaps) so box filter one down
+	// from the stored data, no full size decode or NVDXT re-size needed.
+	Memory::CScratchBuffer ThumbnailImageData(CVTFFile::ComputeImageSize(this->Header->LowResImageWidth, this->Header->LowResImageHeight, 1, IMAGE_FORMAT_RGBA8888));
+	vlByte *lpThumbnailImageData = ThumbnailImageData.Get();
+
+	if(!this->ComputePreview(0, 0, 0, lpThumbnailImageData, this->Header->LowResImageWidth, this->Header->LowResImageHeight))
+	{
+		return vlFalse;
+	}
+
+	if(!CVTFFile::ConvertFromRGBA8888(lpThumbnailImageData, this->GetThumbnailData(), this->Header->LowResImageWidth, this->Header->LowResImageHeight, this->Header->LowResImageFormat, VTFLibOptions))
+	{
+		return vlFalse;
+	}
+
+	//LastError.Set("VTF file does not have a mipmap that matches the thumbnail size.");
+	return vlTrue;
+}
+
+//
+// GenerateNormalMap()
+// Convert the first level mipmap of each frame to a normal map.
+//
+vlBool CVTFFile::GenerateNormalMap(VTFKernelFilter KernelFilter, VTFHeightConversionMethod HeightConversionMethod, VTFNormalAlphaResult NormalAlphaResult)
+{
+	if(!this->IsLoaded())
+		return vlFalse;
+
+	vlUInt uiFrameCount = this->GetFrameCount();
+
+	for(vlUInt i = 0; i < uiFrameCount; i++)
+	{
+		if(!this->GenerateNormalMap(i, KernelFilter, HeightConversionMethod, NormalAlphaResult))
+		{
+			return vlFalse;
+		}
+	}
+
+	return vlTrue;
+}
+
+//
+// GenerateNormalMap()
+// Convert the first level mipmap of the specified frame to a normal map.
+//
+vlBool CVTFFile::GenerateNormalMap(vlUInt uiFrame, VTFKernelFilter KernelFilter, VTFHeightConversionMethod HeightConversionMethod, VTFNormalAlphaResult NormalAlphaResult)
+{
+	if(!this->IsLoaded())
+		return vlFalse;
+
+	if(this->Header->Flags & TEXTUREFLAGS_ENVMAP)
+	{
+		LastError.Set("Image is an enviroment map.");
+		return vlFalse;
+	}
+
+	if(this->lpImageData == 0)
+	{
+		LastError.Set("No image data to generate normal map from.");
+		return vlFalse;
+	}
+
+	SVTFLibOptions VTFLibOptions;
+	this->ResolveOptions(VTFLibOptions);
+
+	vlByte *lpData = this->GetData(0, uiFrame, 0, 0);
+
+	// Will hold frame's converted image data.
+	Memory::CScratchBuffer Source(this->ComputeImageSize(this->Header->Width, this->Header->Height, 1, IMAGE_FORMAT_RGBA8888));
+	vlByte *lpSource = Source.Get();
+
+	// Get the frame's image data.
+	if(!this->ConvertToRGBA8888(lpData, lpSource, this->Header->Width, this->Header->Height, this->Header->ImageFormat, VTFLibOptions))
+	{
+		return vlFalse;
+	}
+
+	// Convert it to a normal map (in place).
+	if(!this->ConvertToNormalMap(lpSource, 0, this->Header->Width, this->Header->Height, KernelFilter, HeightConversionMethod, NormalAlphaResult))
+	{
+		return vlFalse;
+	}
+
+	// Set the frame's image data.
+	if(!this->ConvertFromRGBA8888(lpSource, lpData, this->Header->Width, this->Header->Height, this->Header->ImageFormat, VTFLibOptions))
+	{
+		return vlFalse;
+	}
+
+	return vlTrue;
+}
+
+// Simple struct for holding face data for SphereMap rendering
+// -----------------------------------------------------------
+struct SphereMapFace
+{
+	Vector u, v, n, o;		// vectors for plane equations
+	vlBool bMirror;			// face is stored mirrored (horizontal) in Valve's orientation
+	vlBool bFlip;			// face is stored flipped (vertical) in Valve's orientation
+};
+
+// Define our faces and vectors (don't moan about the order!)
+// Valve's orientation of up, rt and lf is mirrored and of ft and bk is flipped
+// compared to what the rendering code needs, the sample table corrects for that
+// so the faces can be read in place.
+// ----------------------------------------------------------
+static const SphereMapFace SphereMapFaces[6] =
+{
+	{{0, 0, -1}, {0, 1, 0}, {-1, 0, 0}, {-0.5, -0.5, 0.5}, vlTrue, vlFalse},	// left (lf)
+	{{1, 0, 0}, {0, 1, 0}, {0, 0, -1}, {-0.5, -0.5, -0.5}, vlFalse, vlFalse},	// down (dn) 
+	{{0, 0, 1}, {0, 1, 0}, {1, 0, 0}, {0.5, -0.5, -0.5}, vlTrue, vlFalse}, 	// right (rt)
+	{{-1, 0, 0}, {0, 1, 0}, {0, 0, 1}, {0.5, -0.5, 0.5}, vlTrue, vlFalse},		// up (up)
+	{{1, 0, 0}, {0, 0, 1}, {0, 1, 0}, {-0.5, 0.5, -0.5}, vlFalse, vlTrue},		// front (ft)
+	{{1, 0, 0}, {0, 0, -1}, {0, -1, 0}, {-0.5, -0.5, 0.5}, vlFalse, vlTrue}	// back (bk)
+};
+
+#define SPHERE_MAP_SAMPLES			4		// Samples per pixel, on a fixed 2x2 grid.
+#define SPHERE_MAP_FACE_NONE		6		// Sample misses the sphere, use the average colour.
+#define SPHERE_MAP_CACHE_SIZE		4		// Sample tables kept for reuse.
+
+// One bilinear tap into a cube face.  The weights are 8 bit fixed point.
+// ----------------------------------------------------------------------
+struct SphereMapSample
+{
+	vlUInt16 uiX0, uiY0, uiX1, uiY1;		// texels, already corrected for face orientation
+	vlByte uiFace;							// my face order or SPHERE_MAP_FACE_NONE
+	vlByte uiFX, uiFY;						// weight of x1 and y1 out of 256
+	vlByte uiPadding;
+};
+
+// The samples for every pixel of a sphere map of a given size.  Only depends on the
+// size, so one table serves every sphere map of that size.
+// ---------------------------------------------------------------------------------
+struct SphereMapTable
+{
+	vlUInt uiWidth, uiHeight;
+	std::vector<SphereMapSample> Samples;	// uiWidth * uiHeight * SPHERE_MAP_SAMPLES
+};
+
+typedef std::shared_ptr<const SphereMapTable> SphereMapTablePtr;
+
+//
+// BuildSphereMapTable()
+// Traces the samples of each pixel against a perfectly reflective sphere and records
+// which face texels they land on.
+//
+static SphereMapTablePtr BuildSphereMapTable(vlUInt uiWidth, vlUInt uiHeight)
+{
+	SphereMapTable *Table = new SphereMapTable;
+	Table->uiWidth = uiWidth;
+	Table->uiHeight = uiHeight;
+	Table->Samples.resize((size_t)uiWidth * (size_t)uiHeight * SPHERE_MAP_SAMPLES);
+
+	ForEachRow(uiHeight, [Table, uiWidth, uiHeight](vlUInt uiStart, vlUInt uiEnd)
+	{
+		// Stratified sample positions inside the pixel.
+		static const vlSingle sOffsets[SPHERE_MAP_SAMPLES][2] = { { 0.25f, 0.25f }, { 0.75f, 0.25f }, { 0.25f, 0.75f }, { 0.75f, 0.75f } };
+
+		SphereMapSample *pSample = &Table->Samples[(size_t)uiStart * uiWidth * SPHERE_MAP_SAMPLES];
+
+		for(vlUInt y = uiStart; y < uiEnd; y++)
+		{
+			for(vlUInt x = 0; x < uiWidth; x++)
+			{
+				for(vlUInt j = 0; j < SPHERE_MAP_SAMPLES; j++, pSample++)
+				{
+					memset(pSample, 0, sizeof(SphereMapSample));
+
+					vlSingle s = ((vlSingle)x + sOffsets[j][0]) / (vlSingle)uiWidth - 0.5f;
+					vlSingle t = ((vlSingle)y + sOffsets[j][1]) / (vlSingle)uiHeight - 0.5f;
+					vlSingle temp = s * s + t * t;
+
+					//point not on sphere so use the average colour
+					if(temp >= 0.25f)
+					{
+						pSample->uiFace = SPHERE_MAP_FACE_NONE;
+						continue;
+					}
+
+					//get point on sphere
+					Vector p, v, r;
+					p.x = s;
+					p.y = t;
+					p.z = sqrt(0.25f - temp);
+					VecScale(&p, 2.0f);
+
+					//ray from infinity (eyepoint) to surface
+					v.x = 0.0f;
+					v.y = 0.0f;
+					v.z = 1.0f;
+
+					//get reflected ray
+					VecReflect(&p, &v, &r);
+
+					//Intersect reflected ray with cube
+					vlUInt f = (vlUInt)Intersect(&r);
+					const SphereMapFace &Face = SphereMapFaces[f];
+
+					Vector o = Face.o, n = Face.n, u = Face.u, w = Face.v;
+					vlSingle k = VecDot(&o, &n) / VecDot(&r, &n);
+					VecScale(&r, k);
+					VecSub(&r, &o, &v);
+
+					//Get texture coordinates (texel centres at .5)
+					vlSingle sX = VecDot(&v, &u) * (vlSingle)uiWidth - 0.5f;
+					vlSingle sY = VecDot(&v, &w) * (vlSingle)uiHeight - 0.5f;
+
+					vlInt iX0 = (vlInt)floor(sX), iY0 = (vlInt)floor(sY);
+					vlSingle sFX = sX - (vlSingle)iX0, sFY = sY - (vlSingle)iY0;
+					vlInt iX1 = iX0 + 1, iY1 = iY0 + 1;
+
+					iX0 = iX0 < 0 ? 0 : (iX0 >= (vlInt)uiWidth ? (vlInt)uiWidth - 1 : iX0);
+					iX1 = iX1 < 0 ? 0 : (iX1 >= (vlInt)uiWidth ? (vlInt)uiWidth - 1 : iX1);
+					iY0 = iY0 < 0 ? 0 : (iY0 >= (vlInt)uiHeight ? (vlInt)uiHeight - 1 : iY0);
+					iY1 = iY1 < 0 ? 0 : (iY1 >= (vlInt)uiHeight ? (vlInt)uiHeight - 1 : iY1);
+
+					// Read the face in Valve's orientation.
+					if(Face.bMirror)
+					{
+						iX0 = (vlInt)uiWidth - 1 - iX0;
+						iX1 = (vlInt)uiWidth - 1 - iX1;
+					}
+					if(Face.bFlip)
+					{
+						iY0 = (vlInt)uiHeight - 1 - iY0;
+						iY1 = (vlInt)uiHeight - 1 - iY1;
+					}
+
+					pSample->uiX0 = (vlUInt16)iX0;
+					pSample->uiY0 = (vlUInt16)iY0;
+					pSample->uiX1 = (vlUInt16)iX1;
+					pSample->uiY1 = (vlUInt16)iY1;
+					pSample->uiFace = (vlByte)f;
+					pSample->uiFX = (vlByte)(sFX * 255.0f + 0.5f);
+					pSample->uiFY = (vlByte)(sFY * 255.0f + 0.5f);
+				}
+			}
+		}
+	});
+
+	return SphereMapTablePtr(Table);
+}
+
+//
+// GetSphereMapTable()
+// Gets the sample table for the given size, building it if it isn't cached.  A batch
+// of same sized environment maps (the common case for cubemaker) builds it once.
+//
+static SphereMapTablePtr GetSphereMapTable(vlUInt uiWidth, vlUInt uiHeight)
+{
+	static std::mutex Mutex;
+	static std::list<SphereMapTablePtr> Cache;	// Most recently used first.
+
+	{
+		std::lock_guard<std::mutex> Lock(Mutex);
+		for(std::list<SphereMapTablePtr>::iterator i = Cache.begin(); i != Cache.end(); ++i)
+		{
+			if((*i)->uiWidth == uiWidth && (*i)->uiHeight == uiHeight)
+			{
+				SphereMapTablePtr Table = *i;
+				Cache.erase(i);
+				Cache.push_front(Table);
+				return Table;
+			}
+		}
+	}
+
+	// Build outside the lock, if two threads race the second table is simply dropped.
+	SphereMapTablePtr Table = BuildSphereMapTable(uiWidth, uiHeight);
+
+	std::lock_guard<std::mutex> Lock(Mutex);
+	Cache.push_front(Table);
+	if(Cache.size() > SPHERE_MAP_CACHE_SIZE)
+	{
+		Cache.pop_back();
+	}
+
+	return Table;
+}
+
+//
+// SampleSphereMapFace()
+// Bilinear tap on an RGBA8888 face.  Works on two channels per 32 bit multiply
+// (red/blue and green/alpha), the 8 bit weights always sum to 256 so no lane overflows.
+// Returns the red/blue and green/alpha lanes, scaled by 256.
+//
+static inline vlVoid SampleSphereMapFace(const vlUInt *lpFace, vlUInt uiWidth, const SphereMapSample &Sample, vlUInt &uiRB, vlUInt &uiGA)
+{
+	vlUInt uiFX = Sample.uiFX + (Sample.uiFX >> 7), uiFY = Sample.uiFY + (Sample.uiFY >> 7);	// 255 -> 256
+
+	vlUInt uiW11 = (uiFX * uiFY + 128) >> 8;
+	vlUInt uiW10 = uiFX - uiW11;
+	vlUInt uiW01 = uiFY - uiW11;
+	vlUInt uiW00 = 256 - uiW10 - uiW01 - uiW11;
+
+	vlUInt uiP00 = lpFace[(vlUInt)Sample.uiY0 * uiWidth + Sample.uiX0];
+	vlUInt uiP10 = lpFace[(vlUInt)Sample.uiY0 * uiWidth + Sample.uiX1];
+	vlUInt uiP01 = lpFace[(vlUInt)Sample.uiY1 * uiWidth + Sample.uiX0];
+	vlUInt uiP11 = lpFace[(vlUInt)Sample.uiY1 * uiWidth + Sample.uiX1];
+
+	uiRB = (uiP00 & 0x00ff00ff) * uiW00 + (uiP10 & 0x00ff00ff) * uiW10 + (uiP01 & 0x00ff00ff) * uiW01 + (uiP11 & 0x00ff00ff) * uiW11;
+	uiGA = ((uiP00 >> 8) & 0x00ff00ff) * uiW00 + ((uiP10 >> 8) & 0x00ff00ff) * uiW10 + ((uiP01 >> 8) & 0x00ff00ff) * uiW01 + ((uiP11 >> 8) & 0x00ff00ff) * uiW11;
+}
+
+//
+// GenerateSphereMap()
+// Generate a sphere map from the first six faces (the cube map) of an enviroment map.
+// The output only depends on the input, so it is safe to hash and cache.
+//
+vlBool CVTFFile::GenerateSphereMap()
+{
+	if(!this->IsLoaded())
+		return vlFalse;
+
+	if(!(this->Header->Flags & TEXTUREFLAGS_ENVMAP))
+	{
+		LastError.Set("Image is not an enviroment map.");
+		return vlFalse;
+	}
+
+	if(this->Header->StartFrame == 0xffff)
+	{
+		LastError.Set("Enviroment map does not have a sphere map.");
+		return vlFalse;
+	}
+
+	if(this->lpImageData == 0)
+	{
+		LastError.Set("No image data to generate sphere map from.");
+		return vlFalse;
+	}
+
+	vlUInt uiWidth = (vlUInt)this->Header->Width;
+	vlUInt uiHeight = (vlUInt)this->Header->Height;
+
+	// lets go!
+	// One scratch block holds our 6 faces followed by the SphereMap.
+	vlUInt uiFaceSize = this->ComputeImageSize(uiWidth, uiHeight, 1, IMAGE_FORMAT_RGBA8888);
+	Memory::CScratchBuffer Buffers((vlUInt64)uiFaceSize * 7);
+
+	vlByte *lpImageData[6];  					// 6 pointers to memory for our faces.
+	vlByte *lpSphereMapData = Buffers.Get() + (size_t)uiFaceSize * 6;	// SphereMap buffer 
+	vlUInt map[6] = {2, 0, 5, 4, 3, 1};		// used to remap valves face order to my face order.
+
+	vlUInt i;
+
+	SVTFLibOptions VTFLibOptions;
+	this->ResolveOptions(VTFLibOptions);
+
+	// Start on the sample table, it's usually cached.
+	SphereMapTablePtr Table = GetSphereMapTable(uiWidth, uiHeight);
+	 
+	// load the faces into the buffers and convert as needed
+	for( i = 0; i < 6; i ++)
+	{ 
+		vlUInt j = map[i];		// Valve face order to my face order map.
+
+		lpImageData[j] = Buffers.Get() + (size_t)uiFaceSize * j; 
+		
+		if(!this->ConvertToRGBA8888(this->GetData(0, i, 0, 0), lpImageData[j], uiWidth, uiHeight, this->Header->ImageFormat, VTFLibOptions)) 
+		{ 
+			LastError.Set("Could not convert source to RGBA8888 format");
+			return vlFalse; 
+		} 
+	}
+
+	// calculate the average colour for the forward face
+	// using just the forward face is quicker and seems fairly
+	// consistent with what Valves own SphereMaps look like.
+	vlUInt uiAvgR = 0, uiAvgG = 0, uiAvgB = 0;
+	vlUInt uiPixelCount = uiWidth * uiHeight;
+	
+	vlByte *src = lpImageData[3];	// 3 = up or forward face
+	vlByte *lpSourceEnd = src + (uiWidth * uiHeight * 4);
+	
+	for( ; src < lpSourceEnd; src += 4)
+	{
+		uiAvgR += src[0];
+		uiAvgG += src[1];
+		uiAvgB += src[2];
+	}
+
+	uiAvgR /= uiPixelCount; 
+	uiAvgG /= uiPixelCount;
+	uiAvgB /= uiPixelCount;
+
+	// Same lanes as SampleSphereMapFace() returns, alpha is always opaque.
+	vlUInt uiAverageRB = ((uiAvgB << 16) | uiAvgR) << 8;
+	vlUInt uiAverageGA = ((0xff << 16) | uiAvgG) << 8;
+
+	// Render the sphere map a band of rows per thread.
+	const SphereMapTable *pTable = Table.get();
+	vlUInt *lpFaces[6];
+	for(i = 0; i < 6; i++)
+	{
+		lpFaces[i] = (vlUInt *)lpImageData[i];
+	}
+
+	ForEachRow(uiHeight, [&](vlUInt uiStart, vlUInt uiEnd)
+	{
+		const SphereMapSample *pSample = &pTable->Samples[(size_t)uiStart * uiWidth * SPHERE_MAP_SAMPLES];
+		vlByte *lpSphereMapDataPointer = lpSphereMapData + (size_t)uiStart * uiWidth * 4;
+
+		for(vlUInt y = uiStart; y < uiEnd; y++)
+		{
+			for(vlUInt x = 0; x < uiWidth; x++)
+			{
+				vlUInt uiRB = 0, uiGA = 0;
+				for(vlUInt j = 0; j < SPHERE_MAP_SAMPLES; j++, pSample++)
+				{
+					vlUInt uiSampleRB, uiSampleGA;
+					if(pSample->uiFace == SPHERE_MAP_FACE_NONE)
+					{
+						uiSampleRB = uiAverageRB;
+						uiSampleGA = uiAverageGA;
+					}
+					else
+					{
+						SampleSphereMapFace(lpFaces[pSample->uiFace], uiWidth, *pSample, uiSampleRB, uiSampleGA);
+					}
+
+					// Drop the weight scale before summing so four samples fit a 16 bit lane.
+					uiRB += (uiSampleRB >> 8) & 0x00ff00ff;
+					uiGA += (uiSampleGA >> 8) & 0x00ff00ff;
+				}
+
+				// punch the pixel into our SphereMap image buffer
+				lpSphereMapDataPointer[0] = (vlByte)((uiRB & 0xffff) / SPHERE_MAP_SAMPLES);
+				lpSphereMapDataPointer[1] = (vlByte)((uiGA & 0xffff) / SPHERE_MAP_SAMPLES);
+				lpSphereMapDataPointer[2] = (vlByte)((uiRB >> 16) / SPHERE_MAP_SAMPLES);
+				lpSphereMapDataPointer[3] = 0xff;
+				lpSphereMapDataPointer += 4;
+			}
+		}
+	});
+
+	if (!this->ConvertFromRGBA8888(lpSphereMapData,
+									this->GetData(0, CUBEMAP_FACE_SphereMap, 0, 0),
+									this->Header->Width,
+									this->Header->Height,
+									this->Header->ImageFormat,
+									VTFLibOptions) )
+	{
+		return vlFalse; 
+	};
+
+	return vlTrue;
+}
+
+//
+// ComputeReflectivity()
+// Compute the reflectivity value of the texture using all faces and frames.
+//
+vlBool CVTFFile::ComputeReflectivity()
+{
+	if(!this->IsLoaded())
+		return vlFalse;
+
+	if(this->lpImageData == 0)
+	{
+		LastError.Set("No image data to compute reflectivity from.");
+
+		return vlFalse;
+	}
+
+	SVTFLibOptions VTFLibOptions;
+	this->ResolveOptions(VTFLibOptions);
+
+	vlUInt uiFrameCount = this->GetFrameCount();
+	vlUInt uiFaceCount = this->GetFaceCount();
+	vlUInt uiSliceCount = this->GetDepth();
+
+	vlSingle sReflectivity[3] = { 0.0f, 0.0f, 0.0f };
+
+	// Analysed straight from the stored data, no RGBA8888 copy needed.
+	for(vlUInt uiFrame = 0; uiFrame < uiFrameCount; uiFrame++)
 	{
-		if(this->GetSupportsResources())
+		for(vlUInt uiFace = 0; uiFace < uiFaceCount; uiFace++)
 		{
-			switch(uiType)
+			for(vlUInt uiSlice = 0; uiSlice < uiSliceCount; uiSlice++)
 			{
-			case VTF_LEGACY_RSRC_LOW_RES_IMAGE:
-				uiSize = this->uiThumbnailBufferSize;
-				return this->lpThumbnailImageData;
-				break;
-			case VTF_LEGACY_RSRC_IMAGE:
-				uiSize = this->uiImageBufferSize;
-				return this->lpImageData;
-				break;
-			default:
-				for(vlUInt i = 0; i < this->Header->ResourceCount; i++)
+				SVTFImageStatistics Statistics;
+				if(!this->ComputeImageStatistics(this->GetData(uiFrame, uiFace, uiSlice, 0), this->Header->Width, this->Header->Height, this->Header->ImageFormat, Statistics, VTFLibOptions))
 				{
-					if(this->Header->Resources[i].Type == uiType)
-					{
-						if(this->Header->Resources[i].Flags & RSRCF_HAS_NO_DATA_CHUNK)
-						{
-							uiSize = sizeof(vlUInt);
-							return &this->Header->Resources[i].Data;
-						}
-						else
-						{
-							uiSize = this->Header->Data[i].Size;
-							return this->Header->Data[i].Data;
-						}
-					}
+					return vlFalse;
 				}
-				break;
+
+				sReflectivity[0] += Statistics.sReflectivity[0];
+				sReflectivity[1] += Statistics.sReflectivity[1];
+				sReflectivity[2] += Statistics.sReflectivity[2];
 			}
 		}
-		else
-		{
-			LastError.Set("Resources require VTF file version v7.3 and up.");
-		}
 	}
 
-	uiSize = 0;
-	return 0;
+	vlSingle sInverse = 1.0f / (vlSingle)(uiFrameCount * uiFaceCount * uiSliceCount);
+
+	this->Header->Reflectivity[0] = sReflectivity[0] * sInverse;
+	this->Header->Reflectivity[1] = sReflectivity[1] * sInverse;
+	this->Header->Reflectivity[2] = sReflectivity[2] * sInverse;
+
+	return vlTrue;
+}
+
+//
+// ComputeStatistics()
+// Analyses the image data of the specified frame, face, slice and mipmap.
+//
+vlBool CVTFFile::ComputeStatistics(vlUInt uiFrame, vlUInt uiFace, vlUInt uiSlice, vlUInt uiMipmapLevel, SVTFImageStatistics &Statistics) const
+{
+	if(!this->IsLoaded())
+		return vlFalse;
+
+	if(this->lpImageData == 0)
+	{
+		LastError.Set("No image data to analyse.");
+
+		return vlFalse;
+	}
+
+	vlUInt uiWidth, uiHeight, uiDepth;
+	CVTFFile::ComputeMipmapDimensions(this->Header->Width, this->Header->Height, this->Header->Depth, uiMipmapLevel, uiWidth, uiHeight, uiDepth);
+
+	if(uiFrame >= this->GetFrameCount() || uiFace >= this->GetFaceCount() || uiSlice >= uiDepth || uiMipmapLevel >= this->GetMipmapCount())
+	{
+		LastError.Set("Invalid image frame, face, slice or mipmap.");
+
+		return vlFalse;
+	}
+
+	SVTFLibOptions VTFLibOptions;
+	this->ResolveOptions(VTFLibOptions);
+
+	return CVTFFile::ComputeImageStatistics(this->GetData(uiFrame, uiFace, uiSlice, uiMipmapLevel), uiWidth, uiHeight, this->Header->ImageFormat, Statistics, VTFLibOptions);
+}
+
+//
+// ComputePreview()
+// Box filters the image data of the specified frame, face and slice down to a preview,
+// starting from the smallest mipmap that is still at least as big as the preview.
+//
+vlBool CVTFFile::ComputePreview(vlUInt uiFrame, vlUInt uiFace, vlUInt uiSlice, vlByte *lpDestRGBA8888, vlUInt uiDestWidth, vlUInt uiDestHeight) const
+{
+	if(!this->IsLoaded())
+		return vlFalse;
+
+	if(this->lpImageData == 0)
+	{
+		LastError.Set("No image data to generate preview from.");
+
+		return vlFalse;
+	}
+
+	if(uiFrame >= this->GetFrameCount() || uiFace >= this->GetFaceCount() || uiSlice >= this->GetDepth())
+	{
+		LastError.Set("Invalid image frame, face, slice or mipmap.");
+
+		return vlFalse;
+	}
+
+	vlUInt uiMipmap = 0, uiWidth = this->Header->Width, uiHeight = this->Header->Height;
+	for(vlUInt i = 1; i < this->Header->MipCount; i++)
+	{
+		vlUInt uiMipmapWidth, uiMipmapHeight, uiMipmapDepth;
+		CVTFFile::ComputeMipmapDimensions(this->Header->Width, this->Header->Height, this->Header->Depth, i, uiMipmapWidth, uiMipmapHeight, uiMipmapDepth);
+
+		if(uiMipmapWidth < uiDestWidth || uiMipmapHeight < uiDestHeight || uiSlice >= uiMipmapDepth)
+			break;
+
+		uiMipmap = i;
+		uiWidth = uiMipmapWidth;
+		uiHeight = uiMipmapHeight;
+	}
+
+	SVTFLibOptions VTFLibOptions;
+	this->ResolveOptions(VTFLibOptions);
+
+	return CVTFFile::ComputeImagePreview(this->GetData(uiFrame, uiFace, uiSlice, uiMipmap), uiWidth, uiHeight, this->Header->ImageFormat, lpDestRGBA8888, uiDestWidth, uiDestHeight, VTFLibOptions);
+}
+
+#define CRC_BLOCK_SIZE	(64 * 1024)
+
+//
+// ComputeCRC()
+// Computes the CRC-32 of the high resolution image data, as stored in the image
+// CRC resource.  Large images are split across threads and the parts combined.
+//
+vlBool CVTFFile::ComputeCRC(vlUInt &uiCRC) const
+{
+	uiCRC = 0;
+
+	if(!this->IsLoaded() || !this->GetHasImage())
+	{
+		LastError.Set("No image to compute CRC for.");
+		return vlFalse;
+	}
+
+	const vlByte *lpData = this->lpImageData;
+	const vlUInt uiSize = this->uiImageBufferSize;
+	const vlUInt uiBlocks = (uiSize + CRC_BLOCK_SIZE - 1) / CRC_BLOCK_SIZE;
+
+	std::mutex Mutex;
+	std::vector<std::pair<vlUInt, vlUInt>> Bands;	// First block and CRC of each band.
+
+	ForEachRow(uiBlocks, [&](vlUInt uiFirst, vlUInt uiLast)
+	{
+		vlUInt uiStart = uiFirst * CRC_BLOCK_SIZE;
+		vlUInt uiEnd = uiLast * CRC_BLOCK_SIZE < uiSize ? uiLast * CRC_BLOCK_SIZE : uiSize;
+		vlUInt uiBandCRC = Checksum::CRC32(lpData + uiStart, uiEnd - uiStart);
+
+		std::lock_guard<std::mutex> Lock(Mutex);
+		Bands.push_back(std::make_pair(uiFirst, uiBandCRC));
+	});
+
+	std::sort(Bands.begin(), Bands.end());
+
+	for(vlUInt i = 0; i < (vlUInt)Bands.size(); i++)
+	{
+		vlUInt uiStart = Bands[i].first * CRC_BLOCK_SIZE;
+		vlUInt uiEnd = i + 1 < (vlUInt)Bands.size() ? Bands[i + 1].first * CRC_BLOCK_SIZE : uiSize;
+		uiCRC = Checksum::CRC32Combine(uiCRC, Bands[i].second, uiEnd - uiStart);
+	}
+
+	return vlTrue;
+}
+
+// Array which holds information about our image format
+// (taken from imageloader.cpp, Valve Source SDK)
+//------------------------------------------------------
+static SVTFImageFormatInfo VTFImageFormatInfo[] =
+{
+	{ "RGBA8888",			 32,  4,  8,  8,  8,  8, vlFalse,  vlTrue },		// IMAGE_FORMAT_RGBA8888,
+	{ "ABGR8888",			 32,  4,  8,  8,  8,  8, vlFalse,  vlTrue },		// IMAGE_FORMAT_ABGR8888, 
+	{ "RGB888",				 24,  3,  8,  8,  8,  0, vlFalse,  vlTrue },		// IMAGE_FORMAT_RGB888,
+	{ "BGR888",				 24,  3,  8,  8,  8,  0, vlFalse,  vlTrue },		// IMAGE_FORMAT_BGR888,
+	{ "RGB565",				 16,  2,  5,  6,  5,  0, vlFalse,  vlTrue },		// IMAGE_FORMAT_RGB565, 
+	{ "I8",					  8,  1,  0,  0,  0,  0, vlFalse,  vlTrue },		// IMAGE_FORMAT_I8,
+	{ "IA88",				 16,  2,  0,  0,  0,  8, vlFalse,  vlTrue },		// IMAGE_FORMAT_IA88
+	{ "P8",					  8,  1,  0,  0,  0,  0, vlFalse, vlFalse },		// IMAGE_FORMAT_P8
+	{ "A8",					  8,  1,  0,  0,  0,  8, vlFalse,  vlTrue },		// IMAGE_FORMAT_A8
+	{ "RGB888 Bluescreen",	 24,  3,  8,  8,  8,  0, vlFalse,  vlTrue },		// IMAGE_FORMAT_RGB888_BLUESCREEN
+	{ "BGR888 Bluescreen",	 24,  3,  8,  8,  8,  0, vlFalse,  vlTrue },		// IMAGE_FORMAT_BGR888_BLUESCREEN
+	{ "ARGB8888",			 32,  4,  8,  8,  8,  8, vlFalse,  vlTrue },		// IMAGE_FORMAT_ARGB8888
+	{ "BGRA8888",			 32,  4,  8,  8,  8,  8, vlFalse,  vlTrue },		// IMAGE_FORMAT_BGRA8888
+	{ "DXT1",				  4,  0,  0,  0,  0,  0,  vlTrue,  vlTrue },		// IMAGE_FORMAT_DXT1
+	{ "DXT3",				  8,  0,  0,  0,  0,  8,  vlTrue,  vlTrue },		// IMAGE_FORMAT_DXT3
+	{ "DXT5",				  8,  0,  0,  0,  0,  8,  vlTrue,  vlTrue },		// IMAGE_FORMAT_DXT5
+	{ "BGRX8888",			 32,  4,  8,  8,  8,  0, vlFalse,  vlTrue },		// IMAGE_FORMAT_BGRX8888
+	{ "BGR565",				 16,  2,  5,  6,  5,  0, vlFalse,  vlTrue },		// IMAGE_FORMAT_BGR565
+	{ "BGRX5551",			 16,  2,  5,  5,  5,  0, vlFalse,  vlTrue },		// IMAGE_FORMAT_BGRX5551
+	{ "BGRA4444",			 16,  2,  4,  4,  4,  4, vlFalse,  vlTrue },		// IMAGE_FORMAT_BGRA4444
+	{ "DXT1 One Bit Alpha",	  4,  0,  0,  0,  0,  1,  vlTrue,  vlTrue },		// IMAGE_FORMAT_DXT1_ONEBITALPHA
+	{ "BGRA5551",			 16,  2,  5,  5,  5,  1, vlFalse,  vlTrue },		// IMAGE_FORMAT_BGRA5551
+	{ "UV88",				 16,  2,  8,  8,  0,  0, vlFalse,  vlTrue },		// IMAGE_FORMAT_UV88
+	{ "UVWQ8888",			 32,  4,  8,  8,  8,  8, vlFalse,  vlTrue },		// IMAGE_FORMAT_UVWQ8899
+	{ "RGBA16161616F",	     64,  8, 16, 16, 16, 16, vlFalse,  vlTrue },		// IMAGE_FORMAT_RGBA16161616F
+	{ "RGBA16161616",	     64,  8, 16, 16, 16, 16, vlFalse,  vlTrue },		// IMAGE_FORMAT_RGBA16161616
+	{ "UVLX8888",			 32,  4,  8,  8,  8,  8, vlFalse,  vlTrue },		// IMAGE_FORMAT_UVLX8888
+	{ "R32F",				 32,  4, 32,  0,  0,  0, vlFalse,  vlTrue },		// IMAGE_FORMAT_R32F
+	{ "RGB323232F",			 96, 12, 32, 32, 32,  0, vlFalse,  vlTrue },		// IMAGE_FORMAT_RGB323232F
+	{ "RGBA32323232F",		128, 16, 32, 32, 32, 32, vlFalse,  vlTrue },		// IMAGE_FORMAT_RGBA32323232F
+	{ "nVidia DST16",		 16,  2,  0,  0,  0,  0, vlFalse,  vlTrue },		// IMAGE_FORMAT_NV_DST16
+	{ "nVidia DST24",		 24,  3,  0,  0,  0,  0, vlFalse,  vlTrue },		// IMAGE_FORMAT_NV_DST24
+	{ "nVidia INTZ",		 32,  4,  0,  0,  0,  0, vlFalse,  vlTrue },		// IMAGE_FORMAT_NV_INTZ
+	{ "nVidia RAWZ",		 32,  4,  0,  0,  0,  0, vlFalse,  vlTrue },		// IMAGE_FORMAT_NV_RAWZ
+	{ "ATI DST16",			 16,  2,  0,  0,  0,  0, vlFalse,  vlTrue },		// IMAGE_FORMAT_ATI_DST16
+	{ "ATI DST24",			 24,  3,  0,  0,  0,  0, vlFalse,  vlTrue },		// IMAGE_FORMAT_ATI_DST24
+	{ "nVidia NULL",		 32,  4,  0,  0,  0,  0, vlFalse,  vlTrue },		// IMAGE_FORMAT_NV_NULL
+	{ "ATI1N",				  4,  0,  0,  0,  0,  0,  vlTrue,  vlTrue },		// IMAGE_FORMAT_ATI1N
+	{ "ATI2N",				  8,  0,  0,  0,  0,  0,  vlTrue,  vlTrue }/*,		// IMAGE_FORMAT_ATI2N
+	{ "Xbox360 DST16",		 16,  0,  0,  0,  0,  0, vlFalse,  vlTrue },		// IMAGE_FORMAT_X360_DST16
+	{ "Xbox360 DST24",		 24,  0,  0,  0,  0,  0, vlFalse,  vlTrue },		// IMAGE_FORMAT_X360_DST24
+	{ "Xbox360 DST24F",		 24,  0,  0,  0,  0,  0, vlFalse , vlTrue },		// IMAGE_FORMAT_X360_DST24F
+	{ "Linear BGRX8888",	 32,  4,  8,  8,  8,  0, vlFalse,  vlTrue },		// IMAGE_FORMAT_LINEAR_BGRX8888
+	{ "Linear RGBA8888",     32,  4,  8,  8,  8,  8, vlFalse,  vlTrue },		// IMAGE_FORMAT_LINEAR_RGBA8888
+	{ "Linear ABGR8888",	 32,  4,  8,  8,  8,  8, vlFalse,  vlTrue },		// IMAGE_FORMAT_LINEAR_ABGR8888
+	{ "Linear ARGB8888",	 32,  4,  8,  8,  8,  8, vlFalse,  vlTrue },		// IMAGE_FORMAT_LINEAR_ARGB8888
+	{ "Linear BGRA8888",	 32,  4,  8,  8,  8,  8, vlFalse,  vlTrue },		// IMAGE_FORMAT_LINEAR_BGRA8888
+	{ "Linear RGB888",		 24,  3,  8,  8,  8,  0, vlFalse,  vlTrue },		// IMAGE_FORMAT_LINEAR_RGB888
+	{ "Linear BGR888",		 24,  3,  8,  8,  8,  0, vlFalse,  vlTrue },		// IMAGE_FORMAT_LINEAR_BGR888
+	{ "Linear BGRX5551",	 16,  2,  5,  5,  5,  0, vlFalse,  vlTrue },		// IMAGE_FORMAT_LINEAR_BGRX5551
+	{ "Linear I8",			  8,  1,  0,  0,  0,  0, vlFalse,  vlTrue },		// IMAGE_FORMAT_LINEAR_I8
+	{ "Linear RGBA16161616", 64,  8, 16, 16, 16, 16, vlFalse,  vlTrue },		// IMAGE_FORMAT_LINEAR_RGBA16161616
+	{ "LE BGRX8888",         32,  4,  8,  8,  8,  0, vlFalse,  vlTrue },		// IMAGE_FORMAT_LE_BGRX8888
+	{ "LE BGRA8888",		 32,  4,  8,  8,  8,  8, vlFalse,  vlTrue }*/		// IMAGE_FORMAT_LE_BGRA8888
+};
+
+SVTFImageFormatInfo const &CVTFFile::GetImageFormatInfo(VTFImageFormat ImageFormat)
+{
+	assert(ImageFormat >= 0 && ImageFormat < IMAGE_FORMAT_COUNT);
+
+	return VTFImageFormatInfo[ImageFormat];
+}
+
+//------------------------------------------------------------------------------------
+// ComputeImageSize(vlUInt uiWidth, vlUInt uiHeight, VTFImageFormat ImageFormat)
+// 
+// Returns how many bytes are needed to store an image of width * height in the chosen
+// image format. If bMipMaps is true, the total will reflect the space needed to store
+// the original image plus all the mipmaps down to a size of 1 x 1
+//------------------------------------------------------------------------------------
+vlUInt CVTFFile::ComputeImageSize(vlUInt uiWidth, vlUInt uiHeight, vlUInt uiDepth, VTFImageFormat ImageFormat)
+{
+	switch(ImageFormat)
+	{
+	case IMAGE_FORMAT_DXT1:
+	case IMAGE_FORMAT_DXT1_ONEBITALPHA:
+		if(uiWidth < 4 && uiWidth > 0)
+			uiWidth = 4;
+
+		if(uiHeight < 4 && uiHeight > 0)
+			uiHeight = 4;
+
+		return ((uiWidth + 3) / 4) * ((uiHeight + 3) / 4) * 8 * uiDepth;
+	case IMAGE_FORMAT_DXT3:
+	case IMAGE_FORMAT_DXT5:
+		if(uiWidth < 4 && uiWidth > 0)
+			uiWidth = 4;
+
+		if(uiHeight < 4 && uiHeight > 0)
+			uiHeight = 4;
+
+		return ((uiWidth + 3) / 4) * ((uiHeight + 3) / 4) * 16 * uiDepth;
+	default:
+		return uiWidth * uiHeight * uiDepth * CVTFFile::GetImageFormatInfo(ImageFormat).uiBytesPerPixel;
+	}
+}
+
+//
+// ComputeImageSize();
+// Gets the size in bytes of the data needed to store an image of size uiWidth x uiHeight
+// with uiMipmaps mipmap levels and ImageFormat format.
+//
+vlUInt CVTFFile::ComputeImageSize(vlUInt uiWidth, vlUInt uiHeight, vlUInt uiDepth, vlUInt uiMipmaps, VTFImageFormat ImageFormat)
+{
+	vlUInt uiImageSize = 0;
+
+	assert(uiWidth != 0 && uiHeight != 0 && uiDepth != 0);
+
+	for(vlUInt i = 0; i < uiMipmaps; i++)
+	{
+		uiImageSize += CVTFFile::ComputeImageSize(uiWidth, uiHeight, uiDepth, ImageFormat);
+		
+		uiWidth >>= 1;
+		uiHeight >>= 1;
+		uiDepth >>= 1;
+
+		if(uiWidth < 1)
+			uiWidth = 1;
+
+		if(uiHeight < 1)
+			uiHeight = 1;
+
+		if(uiDepth < 1)
+			uiDepth = 1;
+	}
+
+	return uiImageSize;
+}
+
+//
+// ComputeMipmapCount();
+// Gets the number of mipmaps an image of size uiWidth x uiHeight will have including
+// the mipmap of size uiWidth x uiHeight.
+//
+vlUInt CVTFFile::ComputeMipmapCount(vlUInt uiWidth, vlUInt uiHeight, vlUInt uiDepth)
+{
+	vlUInt uiCount = 0;
+
+	assert(uiWidth != 0 && uiHeight != 0 && uiDepth != 0);
+
+	while(vlTrue)
+	{
+		uiCount++;
+		
+		uiWidth >>= 1;
+		uiHeight >>= 1;
+		uiDepth >>= 1;
+
+		if(uiWidth == 0 && uiHeight == 0 && uiDepth == 0)
+			break;
+
+		/*if(uiWidth < 1)
+			uiWidth = 1;
+
+		if(uiHeight < 1)
+			uiHeight = 1;
+
+		if(uiDepth < 1)
+			uiDepth = 1;*/
+	}
+
+	return uiCount;
 }
 
-vlVoid *CVTFFile::SetResourceData(vlUInt uiType, vlUInt uiSize, vlVoid *lpData)
+//-----------------------------------------------------------------------------
+// ComputeMIPMapDimensions( vlInt iMipLevel, vlInt *pMipWidth, vlInt *pMipHeight )
+//
+// Computes the dimensions of a particular mip level
+//-----------------------------------------------------------------------------
+vlVoid CVTFFile::ComputeMipmapDimensions(vlUInt uiWidth, vlUInt uiHeight, vlUInt uiDepth, vlUInt uiMipmapLevel, vlUInt &uiMipmapWidth, vlUInt &uiMipmapHeight, vlUInt &uiMipmapDepth)
 {
-	if(this->IsLoaded())
+	// work out the width/height by taking the orignal dimension
+	// and bit shifting them down uiMipmapLevel times
+	uiMipmapWidth = uiWidth >> uiMipmapLevel;
+	uiMipmapHeight = uiHeight >> uiMipmapLevel;
+	uiMipmapDepth = uiDepth >> uiMipmapLevel;
+	
+	// stop the dimension being less than 1 x 1
+	if(uiMipmapWidth < 1)
+		uiMipmapWidth = 1;
+
+	if(uiMipmapHeight < 1)
+		uiMipmapHeight = 1;
+
+	if(uiMipmapDepth < 1)
+		uiMipmapDepth = 1;
+}
+
+//-----------------------------------------------------------------------------
+// ComputeMIPSize( vlInt iMipLevel, VTFImageFormat fmt )
+//
+// Computes the size (in bytes) of a single mipmap of a single face of a single frame 
+//-----------------------------------------------------------------------------
+vlUInt CVTFFile::ComputeMipmapSize(vlUInt uiWidth, vlUInt uiHeight, vlUInt uiDepth, vlUInt uiMipmapLevel, VTFImageFormat ImageFormat)
+{
+	// figure out the width/height of this MIP level
+	vlUInt uiMipmapWidth, uiMipmapHeight, uiMipmapDepth;
+	CVTFFile::ComputeMipmapDimensions(uiWidth, uiHeight, uiDepth, uiMipmapLevel, uiMipmapWidth, uiMipmapHeight, uiMipmapDepth);
+	
+	// return the memory requirements
+	return CVTFFile::ComputeImageSize(uiMipmapWidth, uiMipmapHeight, uiMipmapDepth, ImageFormat);
+}
+
+//---------------------------------------------------------------------------------
+// ComputeDataOffset(vlUInt uiFrame, vlUInt uiFace, vlUInt uiMipLevel, VTFImageFormat ImageFormat)
+//
+// Returns the offset in our HiResDataBuffer of the data for an image at the 
+// chose frame, face, and mip level. Frame number starts at 0, Face starts at 0
+// MIP level 0 is the largest moving up to MIP count-1 for the smallest
+// To get the first, and largest image, you would use 0, 0, 0
+//---------------------------------------------------------------------------------
+vlUInt CVTFFile::ComputeDataOffset(vlUInt uiFrame, vlUInt uiFace, vlUInt uiSlice, vlUInt uiMipLevel, VTFImageFormat ImageFormat) const
+{
+	vlUInt uiOffset = 0;
+
+	vlUInt uiFrameCount = this->GetFrameCount();
+	vlUInt uiFaceCount = this->GetFaceCount();
+	vlUInt uiSliceCount = this->GetDepth();
+	vlUInt uiMipCount = this->GetMipmapCount();
+
+	if(uiFrame >= uiFrameCount)
 	{
-		if(this->GetSupportsResources())
-		{
-			switch(uiType)
-			{
-			case VTF_LEGACY_RSRC_LOW_RES_IMAGE:
-				LastError.Set("Low resolution image resource cannot be modified through resource interface.");
-				break;
-			case VTF_LEGACY_RSRC_IMAGE:
-				LastError.Set("Image resource cannot be modified through resource interface.");
-				break;
-			default:
-				for(vlUInt i = 0; i < this->Header->ResourceCount; i++)
-				{
-					if(this->Header->Resources[i].Type == uiType)
-					{
-						if(uiSize == 0)
-						{
-							delete []this->Header->Data[i].Data;
-							for(vlUInt j = i + 1; j < this->Header->ResourceCount; j++)
-							{
-								this->Header->Resources[j - 1] = this->Header->Resources[j];
-								this->Header->Data[j - 1] = this->Header->Data[j];
-							}
-							this->Header->ResourceCount--;
-							this->ComputeResources();
-							return 0;
-						}
-						else
-						{
-							if(this->Header->Resources[i].Flags & RSRCF_HAS_NO_DATA_CHUNK)
-							{
-								if(uiSize != sizeof(vlUInt))
-								{
-									LastError.Set("Resources with no data chunk must have size 4.");
-									return 0;
-								}
-								if(lpData == 0)
-								{
-									this->Header->Resources[i].Data= 0;
-								}
-								else if(&this->Header->Resources[i].Data != lpData)
-								{
-									this->Header->Resources[i].Data = *(vlUInt *)lpData;
-								}
-								return &this->Header->Resources[i].Data;
-							}
-							else
-							{
-								if(this->Header->Data[i].Size != uiSize)
-								{
-									delete []this->Header->Data[i].Data;
-									this->Header->Data[i].Size = uiSize;
-									this->Header->Data[i].Data = new vlByte[uiSize];
-									this->ComputeResources();
-								}
-								if(lpData == 0)
-								{
-									memset(this->Header->Data[i].Data, 0, this->Header->Data[i].Size);
-								}
-								else if(this->Header->Data[i].Data != lpData)
-								{
-									memcpy(this->Header->Data[i].Data, lpData, this->Header->Data[i].Size);
-								}
-								return this->Header->Data[i].Data;
-							}
-						}
-					}
-				}
+		uiFrame = uiFrameCount - 1;
+	}
+	
+	if(uiFace >= uiFaceCount)
+	{
+		uiFace = uiFaceCount - 1;
+	}
 
-				// Resource not found.
-				if(uiSize != 0)
-				{
-					if(this->Header->ResourceCount == VTF_RSRC_MAX_DICTIONARY_ENTRIES)
-					{
-						LastError.SetFormatted("Maximum directory entry count %u reached.", VTF_RSRC_MAX_DICTIONARY_ENTRIES);
-						return 0;
-					}
+	if(uiSlice >= uiSliceCount)
+	{
+		uiSlice = uiSliceCount - 1;
+	}
 
-					vlUInt uiIndex = this->Header->ResourceCount;
+	if(uiMipLevel >= uiMipCount)
+	{
+		uiMipLevel = uiMipCount - 1;
+	}
 
-					this->Header->Resources[uiIndex].Type = uiType;
-					this->Header->Resources[uiIndex].Data = 0;
+	// Transverse past all frames and faces of each mipmap (up to the requested one).
+	for(vlInt i = (vlInt)uiMipCount - 1; i > (vlInt)uiMipLevel; i--)
+	{
+		uiOffset += this->ComputeMipmapSize(this->Header->Width, this->Header->Height, this->Header->Depth, i, ImageFormat) * uiFrameCount * uiFaceCount;
+	}
 
-					this->Header->Data[uiIndex].Size = 0;
-					this->Header->Data[uiIndex].Data = 0;
+	vlUInt uiTemp1 = this->ComputeMipmapSize(this->Header->Width, this->Header->Height, this->Header->Depth, uiMipLevel, ImageFormat);
+	vlUInt uiTemp2 = this->ComputeMipmapSize(this->Header->Width, this->Header->Height, 1, uiMipLevel, ImageFormat);
 
-					if(this->Header->Resources[uiIndex].Flags & RSRCF_HAS_NO_DATA_CHUNK)
-					{
-						if(uiSize != sizeof(vlUInt))
-						{
-							LastError.Set("Resources with no data chunk must have size 4.");
-							return 0;
-						}
-						if(lpData != 0)
-						{
-							this->Header->Resources[uiIndex].Data = *(vlUInt *)lpData;
-						}
-						else
-						{
-							this->Header->Resources[uiIndex].Data = 0;
-						}
-						this->Header->ResourceCount++;
-						this->ComputeResources();
-						return &this->Header->Resources[uiIndex].Data;
-					}
-					else
-					{
-						this->Header->Data[uiIndex].Size = uiSize;
-						this->Header->Data[uiIndex].Data = new vlByte[uiSize];
-						if(lpData != 0)
-						{
-							memcpy(this->Header->Data[uiIndex].Data, lpData, this->Header->Data[uiIndex].Size);
-						}
-						else
-						{
-							memset(this->Header->Data[uiIndex].Data, 0, this->Header->Data[uiIndex].Size);
-						}
-						this->Header->ResourceCount++;
-						this->ComputeResources();
-						return this->Header->Data[uiIndex].Data;
-					}
-				}
-				break;
-			}
-		}
-		else
-		{
-			LastError.Set("Resources require VTF file version v7.3 and up.");
-		}
+	// Transverse past requested frames and faces of requested mipmap.
+	uiOffset += uiTemp1 * uiFrame * uiFaceCount * uiSliceCount;
+	uiOffset += uiTemp1 * uiFace * uiSliceCount;
+	uiOffset += uiTemp2 * uiSlice;
+
+	assert(uiOffset < this->uiImageBufferSize);
+	
+	return uiOffset;
+}
+
+//-----------------------------------------------------------------------------------------------------
+// ConvertToRGBA8888( vlByte *src, vlByte *dst, vlUInt uiWidth, vlUInt uiHeight, VTFImageFormat SourceFormat )
+//
+// Converts data from the source format to RGBA8888 format. Data is read from *src
+// and written to *dst. Width and height are needed to it knows how much data to process
+//-----------------------------------------------------------------------------------------------------
+vlBool CVTFFile::ConvertToRGBA8888(vlByte *lpSource, vlByte *lpDest, vlUInt uiWidth, vlUInt uiHeight, VTFImageFormat SourceFormat)
+{
+	return CVTFFile::Convert(lpSource, lpDest, uiWidth, uiHeight, SourceFormat, IMAGE_FORMAT_RGBA8888);
+}
+
+vlBool CVTFFile::ConvertToRGBA8888(vlByte *lpSource, vlByte *lpDest, vlUInt uiWidth, vlUInt uiHeight, VTFImageFormat SourceFormat, const SVTFLibOptions &Options)
+{
+	return CVTFFile::Convert(lpSource, lpDest, uiWidth, uiHeight, SourceFormat, IMAGE_FORMAT_RGBA8888, Options);
+}
+
+vlBool CVTFFile::ConvertToRGBA8888(const CImageView &Source, const CImageView &Dest)
+{
+	SVTFLibOptions Options;
+	VTFLib::GetOptions(Options);
+
+	return CVTFFile::ConvertToRGBA8888(Source, Dest, Options);
+}
+
+vlBool CVTFFile::ConvertToRGBA8888(const CImageView &Source, const CImageView &Dest, const SVTFLibOptions &Options)
+{
+	if(Dest.GetFormat() != IMAGE_FORMAT_RGBA8888)
+	{
+		LastError.Set("Destination image view must be RGBA8888.");
+		return vlFalse;
 	}
 
-	return 0;
+	return CVTFFile::Convert(Source, Dest, Options);
 }
 
+//-----------------------------------------------------------------------------------------------------
+// DXTn decompression code is based on examples on Microsofts website and from the
+// Developers Image Library (http://www.imagelib.org) (c) Denton Woods.
 //
-// GenerateMipmaps()
-// Generate mipmaps from the first mipmap level.
+//-----------------------------------------------------------------------------------------------------
+// DecompressDXT1(vlByte *src, vlByte *dst, vlUInt uiWidth, vlUInt uiHeight)
 //
-vlBool CVTFFile::GenerateMipmaps(VTFMipmapFilter MipmapFilter, VTFSharpenFilter SharpenFilter)
+// Converts data from the DXT1 to RGBA8888 format. Data is read from *src
+// and written to *dst. Width and height are needed to it knows how much data to process
+//-----------------------------------------------------------------------------------------------------
+vlBool CVTFFile::DecompressDXT1(vlByte *src, vlByte *dst, vlUInt uiWidth, vlUInt uiHeight)
 {
-	if(!this->IsLoaded())
-		return vlFalse;
+	vlUInt		x, y, i, j, k, Select;
+	vlByte		*Temp;
+	Colour565	*color_0, *color_1;
+	Colour8888	colours[4], *col;
+	vlUInt		bitmask, Offset;
 
-	if(this->Header->MipCount == 0)
-		return vlTrue;
+	vlByte nBpp = 4;						// bytes per pixel (4 channels (RGBA))
+	vlByte nBpc = 1;						// bytes per channel (1 byte per channel)
+	vlUInt iBps = nBpp * nBpc * uiWidth;		// bytes per scanline
 
-	vlUInt uiFrameCount = this->GetFrameCount();
-	vlUInt uiFaceCount = this->GetFaceCount();
+	Temp = src;
 
-	for(vlUInt i = 0; i < uiFrameCount; i++)
+	for (y = 0; y < uiHeight; y += 4)
 	{
-		for(vlUInt j = 0; j < uiFaceCount; j++)
+		for (x = 0; x < uiWidth; x += 4)
 		{
-			if(!this->GenerateMipmaps(i, j, MipmapFilter, SharpenFilter))
+			color_0 = ((Colour565*)Temp);
+			color_1 = ((Colour565*)(Temp+2));
+			bitmask = ((vlUInt*)Temp)[1];
+			Temp += 8;
+
+			colours[0].r = color_0->nRed << 3;
+			colours[0].g = color_0->nGreen << 2;
+			colours[0].b = color_0->nBlue << 3;
+			colours[0].a = 0xFF;
+
+			colours[1].r = color_1->nRed << 3;
+			colours[1].g = color_1->nGreen << 2;
+			colours[1].b = color_1->nBlue << 3;
+			colours[1].a = 0xFF;
+
+			if (*((vlUShort*)color_0) > *((vlUShort*)color_1))
 			{
-				return vlFalse;
+				// Four-color block: derive the other two colors.    
+				// 00 = color_0, 01 = color_1, 10 = color_2, 11 = color_3
+				// These 2-bit codes correspond to the 2-bit fields 
+				// stored in the 64-bit block.
+				colours[2].b = (2 * colours[0].b + colours[1].b + 1) / 3;
+				colours[2].g = (2 * colours[0].g + colours[1].g + 1) / 3;
+				colours[2].r = (2 * colours[0].r + colours[1].r + 1) / 3;
+				colours[2].a = 0xFF;
+
+				colours[3].b = (colours[0].b + 2 * colours[1].b + 1) / 3;
+				colours[3].g = (colours[0].g + 2 * colours[1].g + 1) / 3;
+				colours[3].r = (colours[0].r + 2 * colours[1].r + 1) / 3;
+				colours[3].a = 0xFF;
+			}
+			else
+			{
+				// Three-color block: derive the other color.
+				// 00 = color_0,  01 = color_1,  10 = color_2,
+				// 11 = transparent.
+				// These 2-bit codes correspond to the 2-bit fields 
+				// stored in the 64-bit block. 
+				colours[2].b = (colours[0].b + colours[1].b) / 2;
+				colours[2].g = (colours[0].g + colours[1].g) / 2;
+				colours[2].r = (colours[0].r + colours[1].r) / 2;
+				colours[2].a = 0xFF;
+
+				colours[3].b = (colours[0].b + 2 * colours[1].b + 1) / 3;
+				colours[3].g = (colours[0].g + 2 * colours[1].g + 1) / 3;
+				colours[3].r = (colours[0].r + 2 * colours[1].r + 1) / 3;
+				colours[3].a = 0x00;
+			}
+
+			for (j = 0, k = 0; j < 4; j++)
+			{
+				for (i = 0; i < 4; i++, k++)
+				{
+					Select = (bitmask & (0x03 << k*2)) >> k*2;
+					col = &colours[Select];
+
+					if (((x + i) < uiWidth) && ((y + j) < uiHeight))
+					{
+						Offset = (y + j) * iBps + (x + i) * nBpp;
+						dst[Offset + 0] = col->r;
+						dst[Offset + 1] = col->g;
+						dst[Offset + 2] = col->b;
+						dst[Offset + 3] = col->a;
+					}
+				}
 			}
 		}
 	}
-
 	return vlTrue;
 }
 
+//-----------------------------------------------------------------------------------------------------
+// DecompressDXT3(vlByte *src, vlByte *dst, vlUInt uiWidth, vlUInt uiHeight)
 //
-// GenerateMipmaps()
-// Generate mipmaps from the first mipmap level of the specified frame and face.
-//
-vlBool CVTFFile::GenerateMipmaps(vlUInt uiFace, vlUInt uiFrame, VTFMipmapFilter MipmapFilter, VTFSharpenFilter SharpenFilter)
+// Converts data from the DXT3 to RGBA8888 format. Data is read from *src
+// and written to *dst. Width and height are needed to it knows how much data to process
+//-----------------------------------------------------------------------------------------------------
+vlBool CVTFFile::DecompressDXT3(vlByte *src, vlByte *dst, vlUInt uiWidth, vlUInt uiHeight)
 {
-	if(!this->IsLoaded())
-		return vlFalse;
-
-#ifdef USE_NVDXT
-	if(this->lpImageData == 0)
-	{
-		LastError.Set("No image data to generate mipmaps from.");
-		return vlFalse;
-	}
-
-	if(this->Header->Depth > 1)
-	{
-		LastError.Set("Mipmap generation for depth textures is not supported.");
-		return vlFalse;
-	}
-
-	assert(MipmapFilter >= 0 && MipmapFilter < MIPMAP_FILTER_COUNT);
-
-	assert(SharpenFilter >= 0 && SharpenFilter < SHARPEN_FILTER_COUNT);
+	vlUInt		x, y, i, j, k, Select;
+	vlByte		*Temp;
+	Colour565	*color_0, *color_1;
+	Colour8888	colours[4], *col;
+	vlUInt		bitmask, Offset;
+	vlUShort	word;
+	DXTAlphaBlockExplicit *alpha;
 
-	if(this->Header->MipCount == 1)
-	{
-		return vlTrue;
-	}
+	vlByte nBpp = 4;						// bytes per pixel (4 channels (RGBA))
+	vlByte nBpc = 1;						// bytes per channel (1 byte per channel)
+	vlUInt iBps = nBpp * nBpc * uiWidth;		// bytes per scanline
 
-	// The mipmap callback NVMipmapCallback() will call ConvertFromRGBA8888() which will use the
-	// NVDXT lib to compress the image data if it is in a DXT format.  This is bad!!!  The
-	// nvDXTcompressRGBA() function only seems to be able to handle one call at a time and since
-	// we made a call for the mipmap generation the thing will crash.  Hence all this DXT nonsense.
-	// This took me a LONG time to figure out!  Go NVidia docs...
-	// Sidenote: this could very well cause problems in multithreaded applications!
+	Temp = src;
 
-	// Get the format to generate mipmaps to.
-	VTFImageFormat MipmapImageFormat;
-	switch(this->Header->ImageFormat)
+	for (y = 0; y < uiHeight; y += 4)
 	{
-	case IMAGE_FORMAT_DXT1:
-	case IMAGE_FORMAT_DXT1_ONEBITALPHA:
-	case IMAGE_FORMAT_DXT3:
-	case IMAGE_FORMAT_DXT5:
-		MipmapImageFormat = this->Header->ImageFormat;
-		break;
-	default:
-		MipmapImageFormat = IMAGE_FORMAT_RGBA8888;
-		break;
-	}
-
-	nvCompressionOptions Options = nvCompressionOptions();
+		for (x = 0; x < uiWidth; x += 4)
+		{
+			alpha = (DXTAlphaBlockExplicit*)Temp;
+			Temp += 8;
+			color_0 = ((Colour565*)Temp);
+			color_1 = ((Colour565*)(Temp+2));
+			bitmask = ((vlUInt*)Temp)[1];
+			Temp += 8;
 
-	SNVCompressionUserData UserData = SNVCompressionUserData(this, uiFace, uiFrame, 0, MipmapImageFormat);
+			colours[0].r = color_0->nRed << 3;
+			colours[0].g = color_0->nGreen << 2;
+			colours[0].b = color_0->nBlue << 3;
+			colours[0].a = 0xFF;
 
-	// Don't generate mipmaps.
-	Options.mipMapGeneration = kGenerateMipMaps;
+			colours[1].r = color_1->nRed << 3;
+			colours[1].g = color_1->nGreen << 2;
+			colours[1].b = color_1->nBlue << 3;
+			colours[1].a = 0xFF;
 
-	Options.mipFilterType = (nvMipFilterTypes)MipmapFilter;
+			// Four-color block: derive the other two colors.    
+			// 00 = color_0, 01 = color_1, 10 = color_2, 11 = color_3
+			// These 2-bit codes correspond to the 2-bit fields 
+			// stored in the 64-bit block.
+			colours[2].b = (2 * colours[0].b + colours[1].b + 1) / 3;
+			colours[2].g = (2 * colours[0].g + colours[1].g + 1) / 3;
+			colours[2].r = (2 * colours[0].r + colours[1].r + 1) / 3;
+			colours[2].a = 0xFF;
 
-	// Setup sharpen filter.
-	if(SharpenFilter != MAX_MIP_MAPS)
-	{
-		Options.sharpenFilterType = (nvSharpenFilterTypes)SharpenFilter;
-		Options.sharpening_passes_per_mip_level[0] = 0;
-		for(vlUInt k = 1; k < MAX_MIP_MAPS; k++)
-		{
-			Options.sharpening_passes_per_mip_level[k] = 1;
-		}
-		Options.unsharp_data.radius32F = sUnsharpenRadius;
-		Options.unsharp_data.amount32F = sUnsharpenAmount;
-		Options.unsharp_data.threshold32F = sUnsharpenThreshold;
-		Options.xsharp_data.strength32F = sXSharpenStrength;
-		Options.xsharp_data.threshold32F = sXSharpenThreshold;
-	}
+			colours[3].b = (colours[0].b + 2 * colours[1].b + 1) / 3;
+			colours[3].g = (colours[0].g + 2 * colours[1].g + 1) / 3;
+			colours[3].r = (colours[0].r + 2 * colours[1].r + 1) / 3;
+			colours[3].a = 0xFF;
 
-	// Set the format.
-	switch(uiDXTQuality)
-	{
-	case DXT_QUALITY_LOW:
-		Options.quality = kQualityFastest;
-		break;
-	case DXT_QUALITY_MEDIUM:
-		Options.quality = kQualityNormal;
-		break;
-	case DXT_QUALITY_HIGH:
-		Options.quality = kQualityProduction;
-		break;
-	case DXT_QUALITY_HIGHEST:
-		Options.quality = kQualityHighest;
-		break;
-	}
-	switch(MipmapImageFormat)
-	{
-	case IMAGE_FORMAT_DXT1:
-		Options.textureFormat = kDXT1;
-		Options.bForceDXT1FourColors = true;
-		break;
-	case IMAGE_FORMAT_DXT1_ONEBITALPHA:
-		Options.bBinaryAlpha = true;
-		Options.bForceDXT1FourColors = true;
-		Options.textureFormat = kDXT1a;
-		break;
-	case IMAGE_FORMAT_DXT3:
-		Options.textureFormat = kDXT3;
-		break;
-	case IMAGE_FORMAT_DXT5:
-		Options.textureFormat = kDXT5;
-		break;
-	case IMAGE_FORMAT_RGBA8888:
-		Options.textureFormat = k8888;
-		Options.bSwapRB = true;
-		break;
-	}
+			k = 0;
+			for (j = 0; j < 4; j++)
+			{
+				for (i = 0; i < 4; i++, k++)
+				{
+					Select = (bitmask & (0x03 << k*2)) >> k*2;
+					col = &colours[Select];
 
-	if(MipmapImageFormat != IMAGE_FORMAT_RGBA8888)
-	{
-		// nvDXTcompressRGBA() fails on widths or heights of 1 or 2 so rescale those images.
-		if(this->Header->Width < 4)
-		{
-			Options.rescaleImageType = kRescalePreScale;
-			Options.rescaleImageFilter = kMipFilterPoint;
-			Options.scaleX = 4.0f;
-		}
+					if (((x + i) < uiWidth) && ((y + j) < uiHeight))
+					{
+						Offset = (y + j) * iBps + (x + i) * nBpp;
+						dst[Offset + 0] = col->r;
+						dst[Offset + 1] = col->g;
+						dst[Offset + 2] = col->b;
+					}
+				}
+			}
 
-		if(this->Header->Height < 4)
-		{
-			Options.rescaleImageType = kRescalePreScale;
-			Options.rescaleImageFilter = kMipFilterPoint;
-			Options.scaleY = 4.0f;
+			for (j = 0; j < 4; j++)
+			{
+				word = alpha->row[j];
+				for (i = 0; i < 4; i++)
+				{
+					if (((x + i) < uiWidth) && ((y + j) < uiHeight))
+					{
+						Offset = (y + j) * iBps + (x + i) * nBpp + 3;
+						dst[Offset] = word & 0x0F;
+						dst[Offset] = dst[Offset] | (dst[Offset] << 4);
+					}
+					
+					word >>= 4;
+				}
+			}
 		}
 	}
+	return vlTrue;
+}
 
-	// The UserData struct gets passed to our callback.
-	Options.user_data = &UserData;
+//-----------------------------------------------------------------------------------------------------
+// DecompressDXT5(vlByte *src, vlByte *dst, vlUInt uiWidth, vlUInt uiHeight)
+//
+// Converts data from the DXT5 to RGBA8888 format. Data is read from *src
+// and written to *dst. Width and height are needed to it knows how much data to process
+//-----------------------------------------------------------------------------------------------------
+vlBool CVTFFile::DecompressDXT5(vlByte *src, vlByte *dst, vlUInt uiWidth, vlUInt uiHeight)
+{
+	vlUInt		x, y, i, j, k, Select;
+	vlByte		*Temp;
+	Colour565	*color_0, *color_1;
+	Colour8888	colours[4], *col;
+	vlUInt		bitmask, Offset;
+	vlByte		alphas[8], *alphamask;
+	vlUInt		bits;
 
-	vlByte *lpImageData = new vlByte[this->ComputeImageSize(this->Header->Width, this->Header->Height, 1, IMAGE_FORMAT_RGBA8888)];
-	
-	if(!this->ConvertToRGBA8888(this->GetData(uiFace, uiFrame, 0, 0), lpImageData, this->Header->Width, this->Header->Height, this->Header->ImageFormat))
-	{
-		delete []lpImageData;
+	vlByte nBpp = 4;						// bytes per pixel (4 channels (RGBA))
+	vlByte nBpc = 1;						// bytes per channel (1 byte per channel)
+	vlUInt iBps = nBpp * nBpc * uiWidth;		// bytes per scanline
 
-		return vlFalse;
-	}
+	Temp = src;
 
-	if(!nvDXTCompressWrapper(lpImageData, this->Header->Width, this->Header->Height, &Options, NVWriteCallback))
+	for (y = 0; y < uiHeight; y += 4)
 	{
-		delete []lpImageData;
+		for (x = 0; x < uiWidth; x += 4)
+		{
+			//if (y >= uiHeight || x >= uiWidth)
+			//		break;
 
-		return vlFalse;
-	}
+			alphas[0] = Temp[0];
+			alphas[1] = Temp[1];
+			alphamask = Temp + 2;
+			Temp += 8;
+			color_0 = ((Colour565*)Temp);
+			color_1 = ((Colour565*)(Temp+2));
+			bitmask = ((vlUInt*)Temp)[1];
+			Temp += 8;
 
-	delete []lpImageData;
+			colours[0].r = color_0->nRed << 3;
+			colours[0].g = color_0->nGreen << 2;
+			colours[0].b = color_0->nBlue << 3;
+			colours[0].a = 0xFF;
 
-	return vlTrue;
-#else
-	LastError.Set("NVDXT support required for CVTFFile::GenerateMipmaps().");
-	return vlFalse;
-#endif
-}
+			colours[1].r = color_1->nRed << 3;
+			colours[1].g = color_1->nGreen << 2;
+			colours[1].b = color_1->nBlue << 3;
+			colours[1].a = 0xFF;
 
-//
-// GenerateThumbnail()
-// We should have a mipmap that matches the thumbnail size.  This function finds it and
-// copies it over to the mipmap data, converting it if need be.
-//
-vlBool CVTFFile::GenerateThumbnail()
-{
-	if(!this->IsLoaded())
-		return vlFalse;
+			// Four-color block: derive the other two colors.    
+			// 00 = color_0, 01 = color_1, 10 = color_2, 11 = color_3
+			// These 2-bit codes correspond to the 2-bit fields 
+			// stored in the 64-bit block.
+			colours[2].b = (2 * colours[0].b + colours[1].b + 1) / 3;
+			colours[2].g = (2 * colours[0].g + colours[1].g + 1) / 3;
+			colours[2].r = (2 * colours[0].r + colours[1].r + 1) / 3;
+			colours[2].a = 0xFF;
 
-	if(!this->GetHasThumbnail())
-	{
-		LastError.Set("VTF file does not have a thumbnail.");
-		return vlFalse;
-	}
+			colours[3].b = (colours[0].b + 2 * colours[1].b + 1) / 3;
+			colours[3].g = (colours[0].g + 2 * colours[1].g + 1) / 3;
+			colours[3].r = (colours[0].r + 2 * colours[1].r + 1) / 3;
+			colours[3].a = 0xFF;
 
-	if(this->lpImageData == 0)
-	{
-		LastError.Set("No image data to generate thumbnail from.");
-		return vlFalse;
-	}
+			k = 0;
+			for (j = 0; j < 4; j++)
+			{
+				for (i = 0; i < 4; i++, k++)
+				{
+					Select = (bitmask & (0x03 << k*2)) >> k*2;
+					col = &colours[Select];
 
-	// Find a mipmap that matches the size of the thumbnail.
-	for(vlUInt i = 0; i < this->Header->MipCount; i++)
-	{
-		vlUInt uiMipmapWidth, uiMipmapHeight, uiMipmapDepth;
-		CVTFFile::ComputeMipmapDimensions(this->Header->Width, this->Header->Height, 1, i, uiMipmapWidth, uiMipmapHeight, uiMipmapDepth);
+					// only put pixels out < width or height
+					if (((x + i) < uiWidth) && ((y + j) < uiHeight)) {
+						Offset = (y + j) * iBps + (x + i) * nBpp;
+						dst[Offset + 0] = col->r;
+						dst[Offset + 1] = col->g;
+						dst[Offset + 2] = col->b;
+					}
+				}
+			}
 
-		if(uiMipmapWidth == (vlUInt)this->Header->LowResImageWidth && uiMipmapHeight == (vlUInt)this->Header->LowResImageHeight)
-		{
-			// Check if it is the same format (in which case copy it) otherwise convert
-			// it to the right format and copy it.
-			if(this->Header->ImageFormat == this->Header->LowResImageFormat)
+			// 8-alpha or 6-alpha block?    
+			if (alphas[0] > alphas[1])
+			{ 
+				// 8-alpha block:  derive the other six alphas.    
+				// Bit code 000 = alpha_0, 001 = alpha_1, others are interpolated.
+				alphas[2] = (6 * alphas[0] + 1 * alphas[1] + 3) / 7;	// bit code 010
+				alphas[3] = (5 * alphas[0] + 2 * alphas[1] + 3) / 7;	// bit code 011
+				alphas[4] = (4 * alphas[0] + 3 * alphas[1] + 3) / 7;	// bit code 100
+				alphas[5] = (3 * alphas[0] + 4 * alphas[1] + 3) / 7;	// bit code 101
+				alphas[6] = (2 * alphas[0] + 5 * alphas[1] + 3) / 7;	// bit code 110
+				alphas[7] = (1 * alphas[0] + 6 * alphas[1] + 3) / 7;	// bit code 111  
+			}    
+			else
+			{  
+				// 6-alpha block.    
+				// Bit code 000 = alpha_0, 001 = alpha_1, others are interpolated.
+				alphas[2] = (4 * alphas[0] + 1 * alphas[1] + 2) / 5;	// Bit code 010
+				alphas[3] = (3 * alphas[0] + 2 * alphas[1] + 2) / 5;	// Bit code 011
+				alphas[4] = (2 * alphas[0] + 3 * alphas[1] + 2) / 5;	// Bit code 100
+				alphas[5] = (1 * alphas[0] + 4 * alphas[1] + 2) / 5;	// Bit code 101
+				alphas[6] = 0x00;										// Bit code 110
+				alphas[7] = 0xFF;										// Bit code 111
+			}
+
+			// Note: Have to separate the next two loops,
+			//	it operates on a 6-byte system.
+
+			// First three bytes
+			bits = *((int*)alphamask);
+			for (j = 0; j < 2; j++)
 			{
-				this->SetThumbnailData(this->GetData(0, 0, 0, i));
+				for (i = 0; i < 4; i++)
+				{
+					// only put pixels out < width or height
+					if (((x + i) < uiWidth) && ((y + j) < uiHeight)) {
+						Offset = (y + j) * iBps + (x + i) * nBpp + 3;
+							dst[Offset] = alphas[bits & 0x07];
+					}
+					bits >>= 3;
+				}
 			}
-			else
+
+			// Last three bytes
+			bits = *((int*)&alphamask[3]);
+			for (j = 2; j < 4; j++)
 			{
-				if(!CVTFFile::Convert(this->GetData(0, 0, 0, i), this->GetThumbnailData(), uiMipmapWidth, uiMipmapHeight, this->Header->ImageFormat, this->Header->LowResImageFormat))
+				for (i = 0; i < 4; i++)
 				{
-					return vlFalse;
+					// only put pixels out < width or height
+					if (((x + i) < uiWidth) && ((y + j) < uiHeight)) {
+						Offset = (y + j) * iBps + (x + i) * nBpp + 3;
+							dst[Offset] = alphas[bits & 0x07];
+					}
+					bits >>= 3;
 				}
 			}
-			return vlTrue;
 		}
 	}
-
-	// We don't have a matching mipmap (maybe we have no mipmaps) so generate one.
-	vlByte *lpImageData = new vlByte[CVTFFile::ComputeImageSize(this->Header->Width, this->Header->Height, 1, IMAGE_FORMAT_RGBA8888)];
-	vlByte *lpThumbnailImageData = new vlByte[CVTFFile::ComputeImageSize(this->Header->LowResImageWidth, this->Header->LowResImageHeight, 1, IMAGE_FORMAT_RGBA8888)];
-
-	if(!CVTFFile::ConvertToRGBA8888(this->GetData(0, 0, 0, 0), lpImageData, this->Header->Width, this->Header->Height, this->Header->ImageFormat))
-	{
-		delete []lpImageData;
-		delete []lpThumbnailImageData;
-
-		return vlFalse;
-	}
-
-	if(!CVTFFile::Resize(lpImageData, lpThumbnailImageData, this->Header->Width, this->Header->Height, this->Header->LowResImageWidth, this->Header->LowResImageHeight))
-	{
-		delete []lpImageData;
-		delete []lpThumbnailImageData;
-
-		return vlFalse;
-	}
-
-	if(!CVTFFile::ConvertFromRGBA8888(lpThumbnailImageData, this->GetThumbnailData(), this->Header->LowResImageWidth, this->Header->LowResImageHeight, this->Header->LowResImageFormat))
-	{
-		delete []lpImageData;
-		delete []lpThumbnailImageData;
-
-		return vlFalse;
-	}
-
-	delete []lpImageData;
-	delete []lpThumbnailImageData;
-
-	//LastError.Set("VTF file does not have a mipmap that matches the thumbnail size.");
 	return vlTrue;
 }
 
 //
-// GenerateNormalMap()
-// Convert the first level mipmap of each frame to a normal map.
+// ConvertFromRGBA8888()
+// Convert input image data (lpSource) to output image data (lpDest) of format DestFormat.
 //
-vlBool CVTFFile::GenerateNormalMap(VTFKernelFilter KernelFilter, VTFHeightConversionMethod HeightConversionMethod, VTFNormalAlphaResult NormalAlphaResult)
+vlBool CVTFFile::ConvertFromRGBA8888(vlByte *lpSource, vlByte *lpDest, vlUInt uiWidth, vlUInt uiHeight, VTFImageFormat DestFormat)
 {
-	if(!this->IsLoaded())
-		return vlFalse;
-
-	vlUInt uiFrameCount = this->GetFrameCount();
-
-	for(vlUInt i = 0; i < uiFrameCount; i++)
-	{
-		if(!this->GenerateNormalMap(i, KernelFilter, HeightConversionMethod, NormalAlphaResult))
-		{
-			return vlFalse;
-		}
-	}
+	return CVTFFile::Convert(lpSource, lpDest, uiWidth, uiHeight, IMAGE_FORMAT_RGBA8888, DestFormat);
+}
 
-	return vlTrue;
+vlBool CVTFFile::ConvertFromRGBA8888(vlByte *lpSource, vlByte *lpDest, vlUInt uiWidth, vlUInt uiHeight, VTFImageFormat DestFormat, const SVTFLibOptions &Options)
+{
+	return CVTFFile::Convert(lpSource, lpDest, uiWidth, uiHeight, IMAGE_FORMAT_RGBA8888, DestFormat, Options);
 }
 
-//
-// GenerateNormalMap()
-// Convert the first level mipmap of the specified frame to a normal map.
-//
-vlBool CVTFFile::GenerateNormalMap(vlUInt uiFrame, VTFKernelFilter KernelFilter, VTFHeightConversionMethod HeightConversionMethod, VTFNormalAlphaResult NormalAlphaResult)
+vlBool CVTFFile::ConvertFromRGBA8888(const CImageView &Source, const CImageView &Dest)
 {
-	if(!this->IsLoaded())
-		return vlFalse;
+	SVTFLibOptions Options;
+	VTFLib::GetOptions(Options);
+
+	return CVTFFile::ConvertFromRGBA8888(Source, Dest, Options);
+}
 
-	if(this->Header->Flags & TEXTUREFLAGS_ENVMAP)
+vlBool CVTFFile::ConvertFromRGBA8888(const CImageView &Source, const CImageView &Dest, const SVTFLibOptions &Options)
+{
+	if(Source.GetFormat() != IMAGE_FORMAT_RGBA8888)
 	{
-		LastError.Set("Image is an enviroment map.");
+		LastError.Set("Source image view must be RGBA8888.");
 		return vlFalse;
 	}
 
-	if(this->lpImageData == 0)
-	{
-		LastError.Set("No image data to generate normal map from.");
-		return vlFalse;
-	}
+	return CVTFFile::Convert(Source, Dest, Options);
+}
 
-	vlByte *lpData = this->GetData(0, uiFrame, 0, 0);
+//
+// CompressDXTn()
+// Compress input image data (lpSource) to output image data (lpDest) of format DestFormat
+// where DestFormat is of format DXTn.  Uses NVidia DXT library.
+//
+vlBool CVTFFile::CompressDXTn(vlByte *lpSource, vlByte *lpDest, vlUInt uiWidth, vlUInt uiHeight, VTFImageFormat DestFormat, const SVTFLibOptions &VTFLibOptions)
+{
+#ifdef USE_NVDXT
+	nvCompressionOptions Options = nvCompressionOptions();
 
-	// Will hold frame's converted image data.
-	vlByte *lpSource = new vlByte[this->ComputeImageSize(this->Header->Width, this->Header->Height, 1, IMAGE_FORMAT_RGBA8888)];
+	SNVCompressionUserData UserData = SNVCompressionUserData(lpDest, DestFormat, VTFLibOptions);
 
-	// Get the frame's image data.
-	if(!this->ConvertToRGBA8888(lpData, lpSource, this->Header->Width, this->Header->Height, this->Header->ImageFormat))
-	{
-		delete []lpSource;
+	// Don't generate mipmaps.
+	Options.mipMapGeneration = kNoMipMaps;
 
-		return vlFalse;
+	// Set the format.
+	switch(VTFLibOptions.uiDXTQuality)
+	{
+	case DXT_QUALITY_LOW:
+		Options.quality = kQualityFastest;
+		break;
+	case DXT_QUALITY_MEDIUM:
+		Options.quality = kQualityNormal;
+		break;
+	case DXT_QUALITY_HIGH:
+		Options.quality = kQualityProduction;
+		break;
+	case DXT_QUALITY_HIGHEST:
+		Options.quality = kQualityHighest;
+		break;
 	}
-
-	// Will hold normal image data.
-	//vlByte *lpDest = new vlByte[this->ComputeImageSize(this->Header->Width, this->Header->Height, IMAGE_FORMAT_RGBA8888)];
-
-	// Convert it to a normal map.
-	if(!this->ConvertToNormalMap(lpSource, 0/*lpDest*/, this->Header->Width, this->Header->Height, KernelFilter, HeightConversionMethod, NormalAlphaResult))
+	switch(DestFormat)
 	{
-		delete []lpSource;
-		//delete []lpDest;
-
+	case IMAGE_FORMAT_DXT1:
+		Options.textureFormat = kDXT1;
+		Options.bForceDXT1FourColors = true;
+		break;
+	case IMAGE_FORMAT_DXT1_ONEBITALPHA:
+		Options.bBinaryAlpha = true;
+		Options.bForceDXT1FourColors = true;
+		Options.textureFormat = kDXT1a;
+		/*for(vlUInt i = 3; i < uiWidth * uiHeight * 4; i += 4)
+		{
+			lpSource[i] = lpSource[i] >= 128 ? 255 : 0;
+		}*/
+		break;
+	case IMAGE_FORMAT_DXT3:
+		Options.textureFormat = kDXT3;
+		break;
+	case IMAGE_FORMAT_DXT5:
+		Options.textureFormat = kDXT5;
+		break;
+	default:
+		LastError.Set("Destination image format not supported.");
 		return vlFalse;
 	}
 
-	//delete []lpSource;
-
-	// Set the frame's image data.
-	if(!this->ConvertFromRGBA8888(lpSource/*lpDest*/, lpData, this->Header->Width, this->Header->Height, this->Header->ImageFormat))
+	// nvDXTcompressRGBA() fails on widths or heights of 1 or 2 so rescale those images.
+	if(uiWidth < 4)
 	{
-		delete []lpSource;	// Moved from above.
-		//delete []lpDest;
+		Options.rescaleImageType = kRescalePreScale;
+		Options.rescaleImageFilter = kMipFilterPoint;
+		Options.scaleX = 4.0f;
+	}
 
-		return vlFalse;
+	if(uiHeight < 4)
+	{
+		Options.rescaleImageType = kRescalePreScale;
+		Options.rescaleImageFilter = kMipFilterPoint;
+		Options.scaleY = 4.0f;
 	}
 
-	delete []lpSource;	// Moved from above.
-	//delete []lpDest;
+	// The UserData struct gets passed to our callback.
+	Options.user_data = &UserData;
 
-	return vlTrue;
+	return nvDXTCompressWrapper(lpSource, uiWidth, uiHeight, &Options, NVWriteCallback);
+#else
+	LastError.Set("NVDXT support required for DXTn compression).");
+	return vlFalse;
+#endif
 }
 
-// Simple struct for holding face data for SphereMap rendering
-// -----------------------------------------------------------
-struct SphereMapFace
+// State passed to the transform functions for one conversion.
+struct SVTFTransformState
 {
-	vlUInt *buf;			// pointer to the address where the image data is.
-	Vector u, v, n, o;		// vectors for plane equations
+	const SVTFLibOptions *lpOptions;		// Luminance, blue screen and HDR settings.
+	vlSingle sHDRLogAverageLuminance;		// Log average luminance of an FP16 HDR source.
 };
 
-// Define our faces and vectors (don't moan about the order!)
-// ----------------------------------------------------------
-SphereMapFace SFace[6] =
-{
-	{0, {0, 0, -1}, {0, 1, 0}, {-1, 0, 0}, {-0.5, -0.5, 0.5}},	// left (lf)
-	{0, {1, 0, 0}, {0, 1, 0}, {0, 0, -1}, {-0.5, -0.5, -0.5}},	// down (dn) 
-	{0, {0, 0, 1}, {0, 1, 0}, {1, 0, 0}, {0.5, -0.5, -0.5}}, 	// right (rt)
-	{0, {-1, 0, 0}, {0, 1, 0}, {0, 0, 1}, {0.5, -0.5, 0.5}},	// up (up)
-	{0, {1, 0, 0}, {0, 0, 1}, {0, 1, 0}, {-0.5, 0.5, -0.5}},	// front (ft)
-	{0,	{1, 0, 0}, {0, 0, -1}, {0, -1, 0}, {-0.5, -0.5, 0.5}}	// back (bk)
-};
+typedef vlVoid (*TransformProc)(vlUInt16& R, vlUInt16& G, vlUInt16& B, vlUInt16& A, const SVTFTransformState &State);
 
-// Normalised pixel colour struct
-// ------------------------------
-struct NColour
+vlVoid ToLuminance(vlUInt16& R, vlUInt16& G, vlUInt16& B, vlUInt16& A, const SVTFTransformState &State)
 {
-	vlSingle r, g, b;
-};
+	const SVTFLibOptions &Options = *State.lpOptions;
 
-//
-// GenerateSphereMap()
-// Generate a sphere map from the first six faces (the cube map) of an enviroment map.
-//
-vlBool CVTFFile::GenerateSphereMap()
+	R = G = B = (vlUInt16)(Options.sLuminanceWeightR * (vlSingle)R + Options.sLuminanceWeightG * (vlSingle)G + Options.sLuminanceWeightB * (vlSingle)B);
+}
+
+vlVoid FromLuminance(vlUInt16& R, vlUInt16& G, vlUInt16& B, vlUInt16& A, const SVTFTransformState &State)
 {
-	if(!this->IsLoaded())
-		return vlFalse;
+	B = G = R;
+}
 
-	if(!(this->Header->Flags & TEXTUREFLAGS_ENVMAP))
+vlVoid ToBlueScreen(vlUInt16& R, vlUInt16& G, vlUInt16& B, vlUInt16& A, const SVTFTransformState &State)
+{
+	const SVTFLibOptions &Options = *State.lpOptions;
+
+	if(A == 0x0000)
 	{
-		LastError.Set("Image is not an enviroment map.");
-		return vlFalse;
+		R = Options.uiBlueScreenMaskR;
+		G = Options.uiBlueScreenMaskG;
+		B = Options.uiBlueScreenMaskB;
 	}
+	A = 0xffff;
+}
 
-	if(this->Header->StartFrame == 0xffff)
+vlVoid FromBlueScreen(vlUInt16& R, vlUInt16& G, vlUInt16& B, vlUInt16& A, const SVTFTransformState &State)
+{
+	const SVTFLibOptions &Options = *State.lpOptions;
+
+	if(R == Options.uiBlueScreenMaskR && G == Options.uiBlueScreenMaskG && B == Options.uiBlueScreenMaskB)
 	{
-		LastError.Set("Enviroment map does not have a sphere map.");
-		return vlFalse;
+		R = Options.uiBlueScreenClearR;
+		G = Options.uiBlueScreenClearG;
+		B = Options.uiBlueScreenClearB;
+		A = 0x0000;
 	}
-
-	if(this->lpImageData == 0)
+	else
 	{
-		LastError.Set("No image data to generate sphere map from.");
-		return vlFalse;
+		A = 0xffff;
 	}
+}
 
-	vlUInt uiWidth = (vlUInt)this->Header->Width;
-	vlUInt uiHeight = (vlUInt)this->Header->Height;
+vlVoid ToFP16(vlUInt16& R, vlUInt16& G, vlUInt16& B, vlUInt16& A, const SVTFTransformState &State)
+{
 
-	// lets go!
-	vlByte *lpImageData[6] = { 0, 0, 0, 0, 0, 0 };  					// 6 pointers to memory for our faces.
-	vlByte *lpSphereMapData = 0;					// SphereMap buffer 
-	vlUInt map[6] = {2, 0, 5, 4, 3, 1};		// used to remap valves face order to my face order.
-	vlUInt samples = 4;							// pixel samples for rendering
+}
 
-	vlUInt i, j, x, y, f;
-	NColour c, texel, average;
-	Vector v, r, p;
-	vlSingle s, t, temp, k;
-	 
-	// load the faces into the buffers and convert as needed
-	for( i = 0; i < 6; i ++)
-	{ 
-		vlUInt j = map[i];		// Valve face order to my face order map.
+vlSingle ClampFP16(vlSingle sValue)
+{
+	if(sValue < 0.0f)
+		sValue = 0.0f;
+	if(sValue > 65335.0f)
+		sValue = 65335.0f;
+	return sValue;
+}
 
-		lpImageData[j] = new vlByte[this->ComputeImageSize(uiWidth, uiHeight, 1, IMAGE_FORMAT_RGBA8888)]; 
-		
-		if(!this->ConvertToRGBA8888(this->GetData(0, i, 0, 0), lpImageData[j], uiWidth, uiHeight, this->Header->ImageFormat)) 
-		{ 
-			for(vlUInt l = 0; l < 6; l++)  
-				delete[] lpImageData[l];  
-			
-			LastError.Set("Could not convert source to RGBA8888 format");
-			return vlFalse; 
-		} 
-		SFace[j].buf = (vlUInt *)lpImageData[j];	// save the address
-	}
+// Reference:
+// http://msdn.microsoft.com/library/default.asp?url=/library/en-us/directx9_c/directx/graphics/programmingguide/advancedtopics/HDRLighting/HDRLighting.asp
+vlVoid FromFP16(vlUInt16& R, vlUInt16& G, vlUInt16& B, vlUInt16& A, const SVTFTransformState &State)
+{
+	const SVTFLibOptions &Options = *State.lpOptions;
 
-	// Assuming at this point our faces have loaded fine, create a buffer for the SphereMap
-	lpSphereMapData = new vlByte[this->ComputeImageSize(uiWidth, uiHeight, 1, IMAGE_FORMAT_RGBA8888)]; 
+	vlSingle sR = (vlSingle)R, sG = (vlSingle)G, sB = (vlSingle)B;//, sA = (vlSingle)A;
 
-	// At this point we need to flip 4 of the faces as follows as their "Valve" orientation
-	// is different to what the SphereMap rendering code needs.
-	// up - flip horizontal
-	// rt - flip horizontal
-	// ft - flip vertical
-	// bk - flip vertical
+	vlSingle sY = sR * 0.299f + sG * 0.587f + sB * 0.114f;
 
-	this->MirrorImage(lpImageData[0], this->Header->Width, this->Header->Height);
-	this->MirrorImage(lpImageData[2], this->Header->Width, this->Header->Height);
-	this->MirrorImage(lpImageData[3], this->Header->Width, this->Header->Height);
-	this->FlipImage(lpImageData[4], this->Header->Width, this->Header->Height);
-	this->FlipImage(lpImageData[5], this->Header->Width, this->Header->Height);
-	
-	// disable conversion warning
-	//#pragma warning(disable: 4244)
+	vlSingle sU = (sB - sY) * 0.565f;
+	vlSingle sV = (sR - sY) * 0.713f;
 
-	// calculate the average colour for the forward face
-	// using just the forward face is quicker and seems fairly
-	// consistent with what Valves own SphereMaps look like.
-	vlUInt uiAvgR = 0, uiAvgG = 0, uiAvgB = 0;
-	vlUInt uiPixelCount = uiWidth * uiHeight;
-	
-	vlByte *src = lpImageData[3];	// 3 = up or forward face
-	vlByte *lpSourceEnd = src + (uiWidth * uiHeight * 4);
-	
-	for( ; src < lpSourceEnd; src += 4)
-	{
-		uiAvgR += src[0];
-		uiAvgG += src[1];
-		uiAvgB += src[2];
-	}
+	vlSingle sTemp = sY;
 
-	uiAvgR /= uiPixelCount; 
-	uiAvgG /= uiPixelCount;
-	uiAvgB /= uiPixelCount;
+	sTemp = Options.sFP16HDRKey * sTemp / State.sHDRLogAverageLuminance;
+	sTemp = sTemp / (1.0f + sTemp);
+
+	sTemp = sTemp / sY;
+
+	R = (vlUInt16)ClampFP16(pow((sY + 1.403f * sV) * sTemp + Options.sFP16HDRShift, Options.sFP16HDRGamma) * 65535.0f);
+	G = (vlUInt16)ClampFP16(pow((sY - 0.344f * sU - 0.714f * sV) * sTemp + Options.sFP16HDRShift, Options.sFP16HDRGamma) * 65535.0f);
+	B = (vlUInt16)ClampFP16(pow((sY + 1.770f * sU) * sTemp + Options.sFP16HDRShift, Options.sFP16HDRGamma) * 65535.0f);
+}
 
-	// the value here is 1/255 - we're normalising the RGBs.
-	average.r = 0.003921f * (vlSingle)uiAvgR;
-	average.g = 0.003921f * (vlSingle)uiAvgG;
-	average.b = 0.003921f * (vlSingle)uiAvgB;
+typedef struct tagSVTFImageConvertInfo
+{
+	vlUInt	uiBitsPerPixel;			// Format bytes per pixel.
+	vlUInt	uiBytesPerPixel;		// Format bytes per pixel.
+	vlUInt	uiRBitsPerPixel;		// Format conversion red bits per pixel.  0 for N/A.
+	vlUInt	uiGBitsPerPixel;		// Format conversion green bits per pixel.  0 for N/A.
+	vlUInt	uiBBitsPerPixel;		// Format conversion blue bits per pixel.  0 for N/A.
+	vlUInt	uiABitsPerPixel;		// Format conversion alpha bits per pixel.  0 for N/A.
+	vlInt	iR;						// "Red" index.
+	vlInt	iG;						// "Green" index.
+	vlInt	iB;						// "Blue" index.
+	vlInt	iA;						// "Alpha" index.
+	vlBool	bIsCompressed;			// Format is compressed (DXT).
+	vlBool	bIsSupported;			// Format is supported by VTFLib.
+	TransformProc pToTransform;		// Custom transform to function.
+	TransformProc pFromTransform;	// Custom transform from function.
+	VTFImageFormat Format;
+} SVTFImageConvertInfo;
 
-	vlByte *lpSphereMapDataPointer = lpSphereMapData;
+static SVTFImageConvertInfo VTFImageConvertInfo[] =
+{
+	{	 32,  4,  8,  8,  8,  8,	 0,	 1,	 2,	 3,	vlFalse,  vlTrue,	NULL,	NULL,		IMAGE_FORMAT_RGBA8888},
+	{	 32,  4,  8,  8,  8,  8,	 3,	 2,	 1,	 0, vlFalse,  vlTrue,	NULL,	NULL,		IMAGE_FORMAT_ABGR8888},
+	{	 24,  3,  8,  8,  8,  0,	 0,	 1,	 2,	-1, vlFalse,  vlTrue,	NULL,	NULL,		IMAGE_FORMAT_RGB888},
+	{	 24,  3,  8,  8,  8,  0,	 2,	 1,	 0,	-1, vlFalse,  vlTrue,	NULL,	NULL,		IMAGE_FORMAT_BGR888},
+	{	 16,  2,  5,  6,  5,  0,	 0,	 1,	 2,	-1, vlFalse,  vlTrue,	NULL,	NULL,		IMAGE_FORMAT_RGB565},
+	{	  8,  1,  8,  8,  8,  0,	 0,	-1,	-1,	-1, vlFalse,  vlTrue,	ToLuminance,	FromLuminance,	IMAGE_FORMAT_I8},
+	{	 16,  2,  8,  8,  8,  8,	 0,	-1,	-1,	 1, vlFalse,  vlTrue,	ToLuminance,	FromLuminance,	IMAGE_FORMAT_IA88},
+	{	  8,  1,  0,  0,  0,  0,	-1,	-1,	-1,	-1, vlFalse, vlFalse,	NULL,	NULL,		IMAGE_FORMAT_P8},
+	{ 	  8,  1,  0,  0,  0,  8,	-1,	-1,	-1,	 0, vlFalse,  vlTrue,	NULL,	NULL,		IMAGE_FORMAT_A8},
+	{ 	 24,  3,  8,  8,  8,  8,	 0,	 1,	 2,	-1, vlFalse,  vlTrue,	ToBlueScreen,	FromBlueScreen,	IMAGE_FORMAT_RGB888_BLUESCREEN},
+	{ 	 24,  3,  8,  8,  8,  8,	 2,	 1,	 0,	-1, vlFalse,  vlTrue,	ToBlueScreen,	FromBlueScreen,	IMAGE_FORMAT_BGR888_BLUESCREEN},
+	{ 	 32,  4,  8,  8,  8,  8,	 3,	 0,	 1,	 2, vlFalse,  vlTrue,	NULL,	NULL,		IMAGE_FORMAT_ARGB8888},
+	{ 	 32,  4,  8,  8,  8,  8,	 2,	 1,	 0,	 3, vlFalse,  vlTrue,	NULL,	NULL,		IMAGE_FORMAT_BGRA8888},
+	{ 	  4,  0,  0,  0,  0,  0,	-1,	-1,	-1,	-1,  vlTrue,  vlTrue,	NULL,	NULL,		IMAGE_FORMAT_DXT1},
+	{ 	  8,  0,  0,  0,  0,  8,	-1,	-1,	-1,	-1,  vlTrue,  vlTrue,	NULL,	NULL,		IMAGE_FORMAT_DXT3},
+	{ 	  8,  0,  0,  0,  0,  8,	-1,	-1,	-1,	-1,  vlTrue,  vlTrue,	NULL,	NULL,		IMAGE_FORMAT_DXT5},
+	{ 	 32,  4,  8,  8,  8,  0,	 2,	 1,	 0,	-1, vlFalse,  vlTrue,	NULL,	NULL,		IMAGE_FORMAT_BGRX8888},
+	{ 	 16,  2,  5,  6,  5,  0,	 2,	 1,	 0,	-1, vlFalse,  vlTrue,	NULL,	NULL,		IMAGE_FORMAT_BGR565},
+	{ 	 16,  2,  5,  5,  5,  0,	 2,	 1,	 0,	-1, vlFalse,  vlTrue,	NULL,	NULL,		IMAGE_FORMAT_BGRX5551},
+	{ 	 16,  2,  4,  4,  4,  4,	 2,	 1,	 0,	 3, vlFalse,  vlTrue,	NULL,	NULL,		IMAGE_FORMAT_BGRA4444},
+	{ 	  4,  0,  0,  0,  0,  1,	-1,	-1,	-1,	-1,  vlTrue,  vlTrue,	NULL,	NULL,		IMAGE_FORMAT_DXT1_ONEBITALPHA},
+	{ 	 16,  2,  5,  5,  5,  1,	 2,	 1,	 0,	 3, vlFalse,  vlTrue,	NULL,	NULL,		IMAGE_FORMAT_BGRA5551},
+	{ 	 16,  2,  8,  8,  0,  0,	 0,	 1,	-1,	-1, vlFalse,  vlTrue,	NULL,	NULL,		IMAGE_FORMAT_UV88},
+	{ 	 32,  4,  8,  8,  8,  8,	 0,	 1,	 2,	 3, vlFalse,  vlTrue,	NULL,	NULL,		IMAGE_FORMAT_UVWQ8888},
+	{    64,  8, 16, 16, 16, 16,	 0,	 1,	 2,	 3, vlFalse,  vlTrue,	ToFP16,	FromFP16,	IMAGE_FORMAT_RGBA16161616F},
+	{	 64,  8, 16, 16, 16, 16,	 0,	 1,	 2,	 3, vlFalse,  vlTrue,	NULL,	NULL,		IMAGE_FORMAT_RGBA16161616},
+	{ 	 32,  4,  8,  8,  8,  8,	 0,	 1,	 2,	 3, vlFalse,  vlTrue,	NULL,	NULL,		IMAGE_FORMAT_UVLX8888},
+	{ 	 32,  4, 32,  0,  0,  0,	 0,	-1,	-1,	-1, vlFalse, vlFalse,	NULL,	NULL,		IMAGE_FORMAT_R32F},
+	{ 	 96, 12, 32, 32, 32,  0,	 0,	 1,	 2,	-1, vlFalse, vlFalse,	NULL,	NULL,		IMAGE_FORMAT_RGB323232F},
+	{	128, 16, 32, 32, 32, 32,	 0,	 1,	 2,	 3, vlFalse, vlFalse,	NULL,	NULL,		IMAGE_FORMAT_RGBA32323232F},
+	{    16,  2, 16,  0,  0,  0,	 0,	-1,	-1,	-1, vlFalse,  vlTrue,	NULL,	NULL,		IMAGE_FORMAT_NV_DST16},
+	{	 24,  3, 24,  0,  0,  0,	 0,	-1,	-1,	-1, vlFalse,  vlTrue,	NULL,	NULL,		IMAGE_FORMAT_NV_DST24},
+	{	 32,  4,  0,  0,  0,  0,	-1,	-1,	-1,	-1, vlFalse, vlFalse,	NULL,	NULL,		IMAGE_FORMAT_NV_INTZ},
+	{	 24,  3,  0,  0,  0,  0,    -1,	-1,	-1,	-1, vlFalse, vlFalse,	NULL,	NULL,		IMAGE_FORMAT_NV_RAWZ},
+	{	 16,  2, 16,  0,  0,  0,	 0,	-1,	-1,	-1, vlFalse,  vlTrue,	NULL,	NULL,		IMAGE_FORMAT_ATI_DST16},
+	{	 24,  3, 24,  0,  0,  0,	 0,	-1,	-1,	-1, vlFalse,  vlTrue,	NULL,	NULL,		IMAGE_FORMAT_ATI_DST24},
+	{	 32,  4,  0,  0,  0,  0,	-1,	-1,	-1,	-1, vlFalse, vlFalse,	NULL,	NULL,		IMAGE_FORMAT_NV_NULL},
+	{	  4,  0,  0,  0,  0,  0,	-1, -1, -1, -1,  vlTrue, vlFalse,	NULL,	NULL,		IMAGE_FORMAT_ATI1N},
+	{     8,  0,  0,  0,  0,  0,	-1, -1, -1, -1,  vlTrue, vlFalse,	NULL,	NULL,		IMAGE_FORMAT_ATI2N}/*,
+	{	 16,  2, 16,  0,  0,  0,	 0, -1, -1, -1, vlFalse,  vlTrue,	NULL,	NULL,		IMAGE_FORMAT_X360_DST16},
+	{	 24,  3, 24,  0,  0,  0,	 0, -1, -1, -1, vlFalse,  vlTrue,	NULL,	NULL,		IMAGE_FORMAT_X360_DST24},
+	{	 24,  3,  0,  0,  0,  0,	-1, -1, -1, -1, vlFalse, vlFalse,	NULL,	NULL,		IMAGE_FORMAT_X360_DST24F},
+	{ 	 32,  4,  8,  8,  8,  0,	 2,	 1,	 0,	-1, vlFalse,  vlTrue,	NULL,	NULL,		IMAGE_FORMAT_LINEAR_BGRX8888},
+	{	 32,  4,  8,  8,  8,  8,	 0,	 1,	 2,	 3,	vlFalse,  vlTrue,	NULL,	NULL,		IMAGE_FORMAT_LINEAR_RGBA8888},
+	{	 32,  4,  8,  8,  8,  8,	 3,	 2,	 1,	 0, vlFalse,  vlTrue,	NULL,	NULL,		IMAGE_FORMAT_LINEAR_ABGR8888},
+	{ 	 32,  4,  8,  8,  8,  8,	 3,	 0,	 1,	 2, vlFalse,  vlTrue,	NULL,	NULL,		IMAGE_FORMAT_LINEAR_ARGB8888},
+	{ 	 32,  4,  8,  8,  8,  8,	 2,	 1,	 0,	 3, vlFalse,  vlTrue,	NULL,	NULL,		IMAGE_FORMAT_LINEAR_BGRA8888},
+	{	 32,  4,  8,  8,  8,  8,	 0,	 1,	 2,	-1,	vlFalse,  vlTrue,	NULL,	NULL,		IMAGE_FORMAT_LINEAR_RGB888},
+	{	 32,  4,  8,  8,  8,  8,	 2,	 1,	 0,	-1,	vlFalse,  vlTrue,	NULL,	NULL,		IMAGE_FORMAT_LINEAR_BGR888},
+	{ 	 16,  2,  5,  5,  5,  0,	 2,	 1,	 0,	-1, vlFalse,  vlTrue,	NULL,	NULL,		IMAGE_FORMAT_LINEAR_BGRX5551},
+	{	  8,  1,  8,  8,  8,  0,	 0,	-1,	-1,	-1, vlFalse,  vlTrue,	ToLuminance,	FromLuminance,	IMAGE_FORMAT_LINEAR_I8},	
+	{	 64,  8, 16, 16, 16, 16,	 0,	 1,	 2,	 3, vlFalse,  vlTrue,	NULL,	NULL,		IMAGE_FORMAT_LINEAR_RGBA16161616}*/
+};
 
-	// Calculate sphere-map by rendering a perfectly reflective solid sphere.
-	for (y = 0; y < uiHeight; y++)
+// Get each channels shift and mask (for encoding and decoding).
+template<typename T>
+vlVoid GetShiftAndMask(const SVTFImageConvertInfo& Info, T &uiRShift, T &uiGShift, T &uiBShift, T &uiAShift, T &uiRMask, T &uiGMask, T &uiBMask, T &uiAMask)
+{
+	if(Info.iR >= 0)
 	{
-		for (x = 0; x < uiWidth; x++)
-		{
-			texel.r = texel.g = texel.b = 0.0f;
-		
-			for (j = 0; j < samples; j++)
-			{
-				s = ((vlSingle)x + (vlSingle)drand48()) / (vlSingle)uiWidth - 0.5f;
-				t = ((vlSingle)y + (vlSingle)drand48()) / (vlSingle)uiHeight - 0.5f;
-				temp = s * s + t * t;
+		if(Info.iG >= 0 && Info.iG < Info.iR)
+			uiRShift += (T)Info.uiGBitsPerPixel;
 
-				//point not on sphere so use the average colour
-				if (temp >= 0.25f)
-				{
-					texel.r += average.r;		
-					texel.g += average.g;		
-					texel.b += average.b;		
-					continue;
-				}
+		if(Info.iB >= 0 && Info.iB < Info.iR)
+			uiRShift += (T)Info.uiBBitsPerPixel;
 
-				//get point on sphere
-				p.x = s;
-				p.y = t;
-				p.z = sqrt(0.25f - temp);
-				VecScale(&p, 2.0f);
-
-				//ray from infinity (eyepoint) to surface
-				v.x = 0.0f;
-				v.y = 0.0f;
-				v.z = 1.0f;
-
-				//get reflected ray
-				VecReflect(&p, &v, &r);
-
-				//Intersect reflected ray with cube
-				f = Intersect(&r);
-				k = VecDot(&SFace[f].o, &SFace[f].n) / VecDot(&r, &SFace[f].n);
-				VecScale(&r, k);
-				VecSub(&r, &SFace[f].o, &v);
-
-				//Get texture map-indices
-				s = VecDot(&v, &SFace[f].u);
-				t = VecDot(&v, &SFace[f].v);
-
-				//Sample to get color
-				SphereMapFace *pf = &SFace[f];
-				vlUInt xpos, ypos;
-				vlByte *p;
-  
-				xpos = (vlUInt)(s * (vlSingle)uiWidth);
-				ypos = (vlUInt)(t * (vlSingle)uiHeight);
-
-				p = (vlByte *)&pf->buf[ypos * uiWidth + xpos];
-				c.r = (vlSingle)p[0] / 255.0f;
-				c.g = (vlSingle)p[1] / 255.0f;
-				c.b = (vlSingle)p[2] / 255.0f;
-
-				texel.r += c.r;
-				texel.g += c.g;
-				texel.b += c.b;
-			}
-	
-			// punch the pixel into our SphereMap image buffer
-			lpSphereMapDataPointer[0] = (vlByte)(255.0f * texel.r / (vlSingle)samples);
-			lpSphereMapDataPointer[1] = (vlByte)(255.0f * texel.g / (vlSingle)samples);
-			lpSphereMapDataPointer[2] = (vlByte)(255.0f * texel.b / (vlSingle)samples);
-			lpSphereMapDataPointer[3] = 0xff;
-			lpSphereMapDataPointer += 4;
-		}
-	}
+		if(Info.iA >= 0 && Info.iA < Info.iR)
+			uiRShift += (T)Info.uiABitsPerPixel;
 
-	//#pragma warning(default: 4244)
+		uiRMask = (T)(~0) >> (T)((sizeof(T) * 8) - Info.uiRBitsPerPixel); // Mask is for down shifted values.
+	}
 
-	if (!this->ConvertFromRGBA8888(lpSphereMapData,
-									this->GetData(0, CUBEMAP_FACE_SphereMap, 0, 0),
-									this->Header->Width,
-									this->Header->Height,
-									this->Header->ImageFormat) )
+	if(Info.iG >= 0)
 	{
-		for(i = 0; i < 6; i++)
-		{
-			delete[] lpImageData[i];
-		}
-		delete[] lpSphereMapData;
+		if(Info.iR >= 0 && Info.iR < Info.iG)
+			uiGShift += (T)Info.uiRBitsPerPixel;
 
-		return vlFalse; 
-	};
+		if(Info.iB >= 0 && Info.iB < Info.iG)
+			uiGShift += (T)Info.uiBBitsPerPixel;
 
-	// delete the memory buffers
-	for(i = 0; i < 6; i++)
-	{
-		delete[] lpImageData[i];
+		if(Info.iA >= 0 && Info.iA < Info.iG)
+			uiGShift += (T)Info.uiABitsPerPixel;
+
+		uiGMask = (T)(~0) >> (T)((sizeof(T) * 8) - Info.uiGBitsPerPixel);
 	}
-	delete[] lpSphereMapData;
 
-	return vlTrue;
-}
+	if(Info.iB >= 0)
+	{
+		if(Info.iR >= 0 && Info.iR < Info.iB)
+			uiBShift += (T)Info.uiRBitsPerPixel;
 
-//
-// ComputeReflectivity()
-// Compute the reflectivity value of the texture using all faces and frames.
-//
-vlBool CVTFFile::ComputeReflectivity()
-{
-	if(!this->IsLoaded())
-		return vlFalse;
+		if(Info.iG >= 0 && Info.iG < Info.iB)
+			uiBShift += (T)Info.uiGBitsPerPixel;
 
-	if(this->lpImageData == 0)
-	{
-		LastError.Set("No image data to compute reflectivity from.");
+		if(Info.iA >= 0 && Info.iA < Info.iB)
+			uiBShift += (T)Info.uiABitsPerPixel;
 
-		return vlFalse;
+		uiBMask = (T)(~0) >> (T)((sizeof(T) * 8) - Info.uiBBitsPerPixel);
 	}
 
-	this->Header->Reflectivity[0] = 0.0f;
-	this->Header->Reflectivity[1] = 0.0f;
-	this->Header->Reflectivity[2] = 0.0f;
+	if(Info.iA >= 0)
+	{
+		if(Info.iR >= 0 && Info.iR < Info.iA)
+			uiAShift += (T)Info.uiRBitsPerPixel;
 
-    vlByte *lpImageData = new vlByte[this->ComputeImageSize(this->Header->Width, this->Header->Height, 1, IMAGE_FORMAT_RGBA8888)];
+		if(Info.iG >= 0 && Info.iG < Info.iA)
+			uiAShift += (T)Info.uiGBitsPerPixel;
 
-	vlUInt uiFrameCount = this->GetFrameCount();
-	vlUInt uiFaceCount = this->GetFaceCount();
-	vlUInt uiSliceCount = this->GetDepth();
+		if(Info.iB >= 0 && Info.iB < Info.iA)
+			uiAShift += (T)Info.uiBBitsPerPixel;
 
-    for(vlUInt uiFrame = 0; uiFrame < uiFrameCount; uiFrame++)
-    {
-        for(vlUInt uiFace = 0; uiFace < uiFaceCount; uiFace++)
-        {
-			for(vlUInt uiSlice = 0; uiSlice < uiSliceCount; uiSlice++)
-			{
-				if(!this->ConvertToRGBA8888(this->GetData(uiFrame, uiFace, uiSlice, 0), lpImageData, this->Header->Width, this->Header->Height, this->Header->ImageFormat))
-				{
-					delete []lpImageData;
+		uiAMask = (T)(~0) >> (T)((sizeof(T) * 8) - Info.uiABitsPerPixel);
+	}
+}
 
-					return vlFalse;
-				}
+// Downsample a channel.
+template<typename T>
+T Shrink(T S, T SourceBits, T DestBits)
+{
+	if(SourceBits == 0 || DestBits == 0)
+		return 0;
 
-				vlSingle sX, sY, sZ;
-				this->ComputeImageReflectivity(lpImageData, this->Header->Width, this->Header->Height, sX, sY, sZ);
+	return S >> (SourceBits - DestBits);
+}
 
-				this->Header->Reflectivity[0] += sX;
-				this->Header->Reflectivity[1] += sY;
-				this->Header->Reflectivity[2] += sZ;
-			}
-        }
-    }
+// Upsample a channel.
+template<typename T>
+T Expand(T S, T SourceBits, T DestBits)
+{
+	if(SourceBits == 0 || DestBits == 0)
+		return 0;
 
-	vlSingle sInverse = 1.0f / (vlSingle)(uiFrameCount * uiFaceCount * uiSliceCount);
+	T D = 0;
 
-	this->Header->Reflectivity[0] *= sInverse;
-	this->Header->Reflectivity[1] *= sInverse;
-	this->Header->Reflectivity[2] *= sInverse;
+	// Repeat source bit pattern as much as possible.
+	while(DestBits >= SourceBits)
+	{
+		D <<= SourceBits;
+		D |= S;
+		DestBits -= SourceBits;
+	}
 
-	delete []lpImageData;
+	// Add most significant part of source bit pattern to least significant part of dest bit pattern.
+	if(DestBits)
+	{
+		S >>= SourceBits - DestBits;
+		D <<= DestBits;
+		D |= S;
+	}
 
-	return vlTrue;
+	return D;
 }
 
-// Array which holds information about our image format
-// (taken from imageloader.cpp, Valve Source SDK)
-//------------------------------------------------------
-static SVTFImageFormatInfo VTFImageFormatInfo[] =
+// Run custom transformation functions.
+template<typename T, typename U>
+vlVoid Transform(TransformProc pTransform1, TransformProc pTransform2, const SVTFTransformState &State, T SR, T SG, T SB, T SA, T SRBits, T SGBits, T SBBits, T SABits, U& DR, U& DG, U& DB, U& DA, U DRBits, U DGBits, U DBBits, U DABits)
 {
-	{ "RGBA8888",			 32,  4,  8,  8,  8,  8, vlFalse,  vlTrue },		// IMAGE_FORMAT_RGBA8888,
-	{ "ABGR8888",			 32,  4,  8,  8,  8,  8, vlFalse,  vlTrue },		// IMAGE_FORMAT_ABGR8888, 
-	{ "RGB888",				 24,  3,  8,  8,  8,  0, vlFalse,  vlTrue },		// IMAGE_FORMAT_RGB888,
-	{ "BGR888",				 24,  3,  8,  8,  8,  0, vlFalse,  vlTrue },		// IMAGE_FORMAT_BGR888,
-	{ "RGB565",				 16,  2,  5,  6,  5,  0, vlFalse,  vlTrue },		// IMAGE_FORMAT_RGB565, 
-	{ "I8",					  8,  1,  0,  0,  0,  0, vlFalse,  vlTrue },		// IMAGE_FORMAT_I8,
-	{ "IA88",				 16,  2,  0,  0,  0,  8, vlFalse,  vlTrue },		// IMAGE_FORMAT_IA88
-	{ "P8",					  8,  1,  0,  0,  0,  0, vlFalse, vlFalse },		// IMAGE_FORMAT_P8
-	{ "A8",					  8,  1,  0,  0,  0,  8, vlFalse,  vlTrue },		// IMAGE_FORMAT_A8
-	{ "RGB888 Bluescreen",	 24,  3,  8,  8,  8,  0, vlFalse,  vlTrue },		// IMAGE_FORMAT_RGB888_BLUESCREEN
-	{ "BGR888 Bluescreen",	 24,  3,  8,  8,  8,  0, vlFalse,  vlTrue },		// IMAGE_FORMAT_BGR888_BLUESCREEN
-	{ "ARGB8888",			 32,  4,  8,  8,  8,  8, vlFalse,  vlTrue },		// IMAGE_FORMAT_ARGB8888
-	{ "BGRA8888",			 32,  4,  8,  8,  8,  8, vlFalse,  vlTrue },		// IMAGE_FORMAT_BGRA8888
-	{ "DXT1",				  4,  0,  0,  0,  0,  0,  vlTrue,  vlTrue },		// IMAGE_FORMAT_DXT1
-	{ "DXT3",				  8,  0,  0,  0,  0,  8,  vlTrue,  vlTrue },		// IMAGE_FORMAT_DXT3
-	{ "DXT5",				  8,  0,  0,  0,  0,  8,  vlTrue,  vlTrue },		// IMAGE_FORMAT_DXT5
-	{ "BGRX8888",			 32,  4,  8,  8,  8,  0, vlFalse,  vlTrue },		// IMAGE_FORMAT_BGRX8888
-	{ "BGR565",				 16,  2,  5,  6,  5,  0, vlFalse,  vlTrue },		// IMAGE_FORMAT_BGR565
-	{ "BGRX5551",			 16,  2,  5,  5,  5,  0, vlFalse,  vlTrue },		// IMAGE_FORMAT_BGRX5551
-	{ "BGRA4444",			 16,  2,  4,  4,  4,  4, vlFalse,  vlTrue },		// IMAGE_FORMAT_BGRA4444
-	{ "DXT1 One Bit Alpha",	  4,  0,  0,  0,  0,  1,  vlTrue,  vlTrue },		// IMAGE_FORMAT_DXT1_ONEBITALPHA
-	{ "BGRA5551",			 16,  2,  5,  5,  5,  1, vlFalse,  vlTrue },		// IMAGE_FORMAT_BGRA5551
-	{ "UV88",				 16,  2,  8,  8,  0,  0, vlFalse,  vlTrue },		// IMAGE_FORMAT_UV88
-	{ "UVWQ8888",			 32,  4,  8,  8,  8,  8, vlFalse,  vlTrue },		// IMAGE_FORMAT_UVWQ8899
-	{ "RGBA16161616F",	     64,  8, 16, 16, 16, 16, vlFalse,  vlTrue },		// IMAGE_FORMAT_RGBA16161616F
-	{ "RGBA16161616",	     64,  8, 16, 16, 16, 16, vlFalse,  vlTrue },		// IMAGE_FORMAT_RGBA16161616
-	{ "UVLX8888",			 32,  4,  8,  8,  8,  8, vlFalse,  vlTrue },		// IMAGE_FORMAT_UVLX8888
-	{ "R32F",				 32,  4, 32,  0,  0,  0, vlFalse,  vlTrue },		// IMAGE_FORMAT_R32F
-	{ "RGB323232F",			 96, 12, 32, 32, 32,  0, vlFalse,  vlTrue },		// IMAGE_FORMAT_RGB323232F
-	{ "RGBA32323232F",		128, 16, 32, 32, 32, 32, vlFalse,  vlTrue },		// IMAGE_FORMAT_RGBA32323232F
-	{ "nVidia DST16",		 16,  2,  0,  0,  0,  0, vlFalse,  vlTrue },		// IMAGE_FORMAT_NV_DST16
-	{ "nVidia DST24",		 24,  3,  0,  0,  0,  0, vlFalse,  vlTrue },		// IMAGE_FORMAT_NV_DST24
-	{ "nVidia INTZ",		 32,  4,  0,  0,  0,  0, vlFalse,  vlTrue },		// IMAGE_FORMAT_NV_INTZ
-	{ "nVidia RAWZ",		 32,  4,  0,  0,  0,  0, vlFalse,  vlTrue },		// IMAGE_FORMAT_NV_RAWZ
-	{ "ATI DST16",			 16,  2,  0,  0,  0,  0, vlFalse,  vlTrue },		// IMAGE_FORMAT_ATI_DST16
-	{ "ATI DST24",			 24,  3,  0,  0,  0,  0, vlFalse,  vlTrue },		// IMAGE_FORMAT_ATI_DST24
-	{ "nVidia NULL",		 32,  4,  0,  0,  0,  0, vlFalse,  vlTrue },		// IMAGE_FORMAT_NV_NULL
-	{ "ATI1N",				  4,  0,  0,  0,  0,  0,  vlTrue,  vlTrue },		// IMAGE_FORMAT_ATI1N
-	{ "ATI2N",				  8,  0,  0,  0,  0,  0,  vlTrue,  vlTrue }/*,		// IMAGE_FORMAT_ATI2N
-	{ "Xbox360 DST16",		 16,  0,  0,  0,  0,  0, vlFalse,  vlTrue },		// IMAGE_FORMAT_X360_DST16
-	{ "Xbox360 DST24",		 24,  0,  0,  0,  0,  0, vlFalse,  vlTrue },		// IMAGE_FORMAT_X360_DST24
-	{ "Xbox360 DST24F",		 24,  0,  0,  0,  0,  0, vlFalse , vlTrue },		// IMAGE_FORMAT_X360_DST24F
-	{ "Linear BGRX8888",	 32,  4,  8,  8,  8,  0, vlFalse,  vlTrue },		// IMAGE_FORMAT_LINEAR_BGRX8888
-	{ "Linear RGBA8888",     32,  4,  8,  8,  8,  8, vlFalse,  vlTrue },		// IMAGE_FORMAT_LINEAR_RGBA8888
-	{ "Linear ABGR8888",	 32,  4,  8,  8,  8,  8, vlFalse,  vlTrue },		// IMAGE_FORMAT_LINEAR_ABGR8888
-	{ "Linear ARGB8888",	 32,  4,  8,  8,  8,  8, vlFalse,  vlTrue },		// IMAGE_FORMAT_LINEAR_ARGB8888
-	{ "Linear BGRA8888",	 32,  4,  8,  8,  8,  8, vlFalse,  vlTrue },		// IMAGE_FORMAT_LINEAR_BGRA8888
-	{ "Linear RGB888",		 24,  3,  8,  8,  8,  0, vlFalse,  vlTrue },		// IMAGE_FORMAT_LINEAR_RGB888
-	{ "Linear BGR888",		 24,  3,  8,  8,  8,  0, vlFalse,  vlTrue },		// IMAGE_FORMAT_LINEAR_BGR888
-	{ "Linear BGRX5551",	 16,  2,  5,  5,  5,  0, vlFalse,  vlTrue },		// IMAGE_FORMAT_LINEAR_BGRX5551
-	{ "Linear I8",			  8,  1,  0,  0,  0,  0, vlFalse,  vlTrue },		// IMAGE_FORMAT_LINEAR_I8
-	{ "Linear RGBA16161616", 64,  8, 16, 16, 16, 16, vlFalse,  vlTrue },		// IMAGE_FORMAT_LINEAR_RGBA16161616
-	{ "LE BGRX8888",         32,  4,  8,  8,  8,  0, vlFalse,  vlTrue },		// IMAGE_FORMAT_LE_BGRX8888
-	{ "LE BGRA8888",		 32,  4,  8,  8,  8,  8, vlFalse,  vlTrue }*/		// IMAGE_FORMAT_LE_BGRA8888
-};
+	vlUInt16 TR, TG, TB, TA;
 
-SVTFImageFormatInfo const &CVTFFile::GetImageFormatInfo(VTFImageFormat ImageFormat)
-{
-	assert(ImageFormat >= 0 && ImageFormat < IMAGE_FORMAT_COUNT);
+	// Expand from source to 16 bits for transform functions.
+	SRBits && SRBits < 16 ? TR = (vlUInt16)Expand<T>(SR, SRBits, 16) : TR = (vlUInt16)SR;
+	SGBits && SGBits < 16 ? TG = (vlUInt16)Expand<T>(SG, SGBits, 16) : TG = (vlUInt16)SG;
+	SBBits && SBBits < 16 ? TB = (vlUInt16)Expand<T>(SB, SBBits, 16) : TB = (vlUInt16)SB;
+	SABits && SABits < 16 ? TA = (vlUInt16)Expand<T>(SA, SABits, 16) : TA = (vlUInt16)SA;
 
-	return VTFImageFormatInfo[ImageFormat];
+	// Source transform then dest transform.
+	if(pTransform1)
+		pTransform1(TR, TG, TB, TA, State);
+	if(pTransform2)
+		pTransform2(TR, TG, TB, TA, State);
+
+	// Shrink to dest from 16 bits.
+	DRBits && DRBits < 16 ? DR = (U)Shrink<vlUInt16>(TR, 16, (vlUInt16)DRBits) : DR = (U)TR;
+	DGBits && DGBits < 16 ? DG = (U)Shrink<vlUInt16>(TG, 16, (vlUInt16)DGBits) : DG = (U)TG;
+	DBBits && DBBits < 16 ? DB = (U)Shrink<vlUInt16>(TB, 16, (vlUInt16)DBBits) : DB = (U)TB;
+	DABits && DABits < 16 ? DA = (U)Shrink<vlUInt16>(TA, 16, (vlUInt16)DABits) : DA = (U)TA;
 }
 
-//------------------------------------------------------------------------------------
-// ComputeImageSize(vlUInt uiWidth, vlUInt uiHeight, VTFImageFormat ImageFormat)
-// 
-// Returns how many bytes are needed to store an image of width * height in the chosen
-// image format. If bMipMaps is true, the total will reflect the space needed to store
-// the original image plus all the mipmaps down to a size of 1 x 1
-//------------------------------------------------------------------------------------
-vlUInt CVTFFile::ComputeImageSize(vlUInt uiWidth, vlUInt uiHeight, vlUInt uiDepth, VTFImageFormat ImageFormat)
+//
+// ComputeHDRLogAverageLuminance()
+// Computes the log average luminance of FP16 HDR data, the key it is tone mapped with.
+// Each row is summed on its own and the rows are then added in order, so the result
+// doesn't depend on how the rows were split between threads.  uiPitch is the number of
+// bytes between rows, 0 if they are packed.
+//
+static vlSingle ComputeHDRLogAverageLuminance(const vlByte *lpSource, vlUInt uiWidth, vlUInt uiHeight, vlUInt uiBytesPerPixel, vlUInt uiPitch = 0)
 {
-	switch(ImageFormat)
+	if(uiPitch == 0)
 	{
-	case IMAGE_FORMAT_DXT1:
-	case IMAGE_FORMAT_DXT1_ONEBITALPHA:
-		if(uiWidth < 4 && uiWidth > 0)
-			uiWidth = 4;
+		uiPitch = uiWidth * uiBytesPerPixel;
+	}
 
-		if(uiHeight < 4 && uiHeight > 0)
-			uiHeight = 4;
+	Memory::CScratchBuffer RowSumBuffer((vlUInt64)uiHeight * sizeof(vlDouble));
+	vlDouble *RowSums = reinterpret_cast<vlDouble *>(RowSumBuffer.Get());
 
-		return ((uiWidth + 3) / 4) * ((uiHeight + 3) / 4) * 8 * uiDepth;
-	case IMAGE_FORMAT_DXT3:
-	case IMAGE_FORMAT_DXT5:
-		if(uiWidth < 4 && uiWidth > 0)
-			uiWidth = 4;
+	ForEachRow(uiHeight, [&](vlUInt uiStart, vlUInt uiEnd)
+	{
+		for(vlUInt y = uiStart; y < uiEnd; y++)
+		{
+			const vlByte *lpRow = lpSource + (size_t)y * uiPitch;
 
-		if(uiHeight < 4 && uiHeight > 0)
-			uiHeight = 4;
+			vlDouble dSum = 0.0;
+			for(vlUInt x = 0; x < uiWidth; x++, lpRow += uiBytesPerPixel)
+			{
+				const vlUInt16 *p = (const vlUInt16 *)lpRow;
 
-		return ((uiWidth + 3) / 4) * ((uiHeight + 3) / 4) * 16 * uiDepth;
-	default:
-		return uiWidth * uiHeight * uiDepth * CVTFFile::GetImageFormatInfo(ImageFormat).uiBytesPerPixel;
+				vlSingle sLuminance = (vlSingle)p[0] * 0.299f + (vlSingle)p[1] * 0.587f + (vlSingle)p[2] * 0.114f;
+
+				dSum += log(0.0000000001f + sLuminance);
+			}
+			RowSums[y] = dSum;
+		}
+	});
+
+	vlDouble dSum = 0.0;
+	for(vlUInt y = 0; y < uiHeight; y++)
+	{
+		dSum += RowSums[y];
 	}
+
+	return (vlSingle)exp(dSum / ((vlDouble)uiWidth * (vlDouble)uiHeight));
 }
 
-//
-// ComputeImageSize();
-// Gets the size in bytes of the data needed to store an image of size uiWidth x uiHeight
-// with uiMipmaps mipmap levels and ImageFormat format.
-//
-vlUInt CVTFFile::ComputeImageSize(vlUInt uiWidth, vlUInt uiHeight, vlUInt uiDepth, vlUInt uiMipmaps, VTFImageFormat ImageFormat)
+// Convert source to dest using required storage requirments (hence the template).
+// sHDRLogAverageLuminance is computed from the source if negative; pass it in when
+// converting part of an FP16 image so it is tone mapped the same as the whole.
+template<typename T, typename U>
+vlBool ConvertTemplated(vlByte *lpSource, vlByte *lpDest, vlUInt uiWidth, vlUInt uiHeight, const SVTFImageConvertInfo& SourceInfo, const SVTFImageConvertInfo& DestInfo, const SVTFLibOptions &Options, vlSingle sHDRLogAverageLuminance = -1.0f)
 {
-	vlUInt uiImageSize = 0;
-
-	assert(uiWidth != 0 && uiHeight != 0 && uiDepth != 0);
+	SVTFTransformState State;
+	State.lpOptions = &Options;
+	State.sHDRLogAverageLuminance = sHDRLogAverageLuminance;
 
-	for(vlUInt i = 0; i < uiMipmaps; i++)
-	{
-		uiImageSize += CVTFFile::ComputeImageSize(uiWidth, uiHeight, uiDepth, ImageFormat);
-		
-		uiWidth >>= 1;
-		uiHeight >>= 1;
-		uiDepth >>= 1;
+	vlUInt16 uiSourceRShift = 0, uiSourceGShift = 0, uiSourceBShift = 0, uiSourceAShift = 0;
+	vlUInt16 uiSourceRMask = 0, uiSourceGMask = 0, uiSourceBMask = 0, uiSourceAMask = 0;
 
-		if(uiWidth < 1)
-			uiWidth = 1;
+	vlUInt16 uiDestRShift = 0, uiDestGShift = 0, uiDestBShift = 0, uiDestAShift = 0;
+	vlUInt16 uiDestRMask = 0, uiDestGMask = 0, uiDestBMask = 0, uiDestAMask = 0;
 
-		if(uiHeight < 1)
-			uiHeight = 1;
+	GetShiftAndMask<vlUInt16>(SourceInfo, uiSourceRShift, uiSourceGShift, uiSourceBShift, uiSourceAShift, uiSourceRMask, uiSourceGMask, uiSourceBMask, uiSourceAMask);
+	GetShiftAndMask<vlUInt16>(DestInfo, uiDestRShift, uiDestGShift, uiDestBShift, uiDestAShift, uiDestRMask, uiDestGMask, uiDestBMask, uiDestAMask);
 
-		if(uiDepth < 1)
-			uiDepth = 1;
+	// If we are in the FP16 HDR format we will need a log average.
+	if(SourceInfo.Format == IMAGE_FORMAT_RGBA16161616F && State.sHDRLogAverageLuminance < 0.0f)
+	{
+		State.sHDRLogAverageLuminance = ComputeHDRLogAverageLuminance(lpSource, uiWidth, uiHeight, SourceInfo.uiBytesPerPixel);
 	}
 
-	return uiImageSize;
-}
+	vlByte *lpSourceEnd = lpSource + (uiWidth * uiHeight * SourceInfo.uiBytesPerPixel);
+	for(; lpSource < lpSourceEnd; lpSource += SourceInfo.uiBytesPerPixel, lpDest += DestInfo.uiBytesPerPixel)
+	{
+		// read source into single variable
+		vlUInt i;
+		T Source = 0;
+		for(i = 0; i < SourceInfo.uiBytesPerPixel; i++)
+		{
+			Source |= (T)lpSource[i] << ((T)i * 8);
+		}
 
-//
-// ComputeMipmapCount();
-// Gets the number of mipmaps an image of size uiWidth x uiHeight will have including
-// the mipmap of size uiWidth x uiHeight.
-//
-vlUInt CVTFFile::ComputeMipmapCount(vlUInt uiWidth, vlUInt uiHeight, vlUInt uiDepth)
-{
-	vlUInt uiCount = 0;
+		vlUInt16 SR = 0, SG = 0, SB = 0, SA = ~0;
+		vlUInt16 DR = 0, DG = 0, DB = 0, DA = ~0;	// default values
 
-	assert(uiWidth != 0 && uiHeight != 0 && uiDepth != 0);
+		// read source values
+		if(uiSourceRMask)
+			SR = (vlUInt16)(Source >> (T)uiSourceRShift) & uiSourceRMask;	// isolate R channel
 
-	while(vlTrue)
-	{
-		uiCount++;
-		
-		uiWidth >>= 1;
-		uiHeight >>= 1;
-		uiDepth >>= 1;
+		if(uiSourceGMask)
+			SG = (vlUInt16)(Source >> (T)uiSourceGShift) & uiSourceGMask;	// isolate G channel
 
-		if(uiWidth == 0 && uiHeight == 0 && uiDepth == 0)
-			break;
+		if(uiSourceBMask)
+			SB = (vlUInt16)(Source >> (T)uiSourceBShift) & uiSourceBMask;	// isolate B channel
 
-		/*if(uiWidth < 1)
-			uiWidth = 1;
+		if(uiSourceAMask)
+			SA = (vlUInt16)(Source >> (T)uiSourceAShift) & uiSourceAMask;	// isolate A channel
 
-		if(uiHeight < 1)
-			uiHeight = 1;
+		if(SourceInfo.pFromTransform || DestInfo.pToTransform)
+		{
+			// transform values
+			Transform<vlUInt16, vlUInt16>(SourceInfo.pFromTransform, DestInfo.pToTransform, State, SR, SG, SB, SA, SourceInfo.uiRBitsPerPixel, SourceInfo.uiGBitsPerPixel, SourceInfo.uiBBitsPerPixel, SourceInfo.uiABitsPerPixel, DR, DG, DB, DA, DestInfo.uiRBitsPerPixel, DestInfo.uiGBitsPerPixel, DestInfo.uiBBitsPerPixel, DestInfo.uiABitsPerPixel);
+		}
+		else
+		{
+			// default value transform
+			if(uiSourceRMask && uiDestRMask)
+			{
+				if(DestInfo.uiRBitsPerPixel < SourceInfo.uiRBitsPerPixel)	// downsample
+					DR = Shrink<vlUInt16>(SR, SourceInfo.uiRBitsPerPixel, DestInfo.uiRBitsPerPixel);
+				else if(DestInfo.uiRBitsPerPixel > SourceInfo.uiRBitsPerPixel)	// upsample
+					DR = Expand<vlUInt16>(SR, SourceInfo.uiRBitsPerPixel, DestInfo.uiRBitsPerPixel);
+				else
+					DR = SR;
+			}
 
-		if(uiDepth < 1)
-			uiDepth = 1;*/
-	}
+			if(uiSourceGMask && uiDestGMask)
+			{
+				if(DestInfo.uiGBitsPerPixel < SourceInfo.uiGBitsPerPixel)	// downsample
+					DG = Shrink<vlUInt16>(SG, SourceInfo.uiGBitsPerPixel, DestInfo.uiGBitsPerPixel);
+				else if(DestInfo.uiGBitsPerPixel > SourceInfo.uiGBitsPerPixel)	// upsample
+					DG = Expand<vlUInt16>(SG, SourceInfo.uiGBitsPerPixel, DestInfo.uiGBitsPerPixel);
+				else
+					DG = SG;
+			}
 
-	return uiCount;
-}
+			if(uiSourceBMask && uiDestBMask)
+			{
+				if(DestInfo.uiBBitsPerPixel < SourceInfo.uiBBitsPerPixel)	// downsample
+					DB = Shrink<vlUInt16>(SB, SourceInfo.uiBBitsPerPixel, DestInfo.uiBBitsPerPixel);
+				else if(DestInfo.uiBBitsPerPixel > SourceInfo.uiBBitsPerPixel)	// upsample
+					DB = Expand<vlUInt16>(SB, SourceInfo.uiBBitsPerPixel, DestInfo.uiBBitsPerPixel);
+				else
+					DB = SB;
+			}
 
-//-----------------------------------------------------------------------------
-// ComputeMIPMapDimensions( vlInt iMipLevel, vlInt *pMipWidth, vlInt *pMipHeight )
-//
-// Computes the dimensions of a particular mip level
-//-----------------------------------------------------------------------------
-vlVoid CVTFFile::ComputeMipmapDimensions(vlUInt uiWidth, vlUInt uiHeight, vlUInt uiDepth, vlUInt uiMipmapLevel, vlUInt &uiMipmapWidth, vlUInt &uiMipmapHeight, vlUInt &uiMipmapDepth)
-{
-	// work out the width/height by taking the orignal dimension
-	// and bit shifting them down uiMipmapLevel times
-	uiMipmapWidth = uiWidth >> uiMipmapLevel;
-	uiMipmapHeight = uiHeight >> uiMipmapLevel;
-	uiMipmapDepth = uiDepth >> uiMipmapLevel;
-	
-	// stop the dimension being less than 1 x 1
-	if(uiMipmapWidth < 1)
-		uiMipmapWidth = 1;
+			if(uiSourceAMask && uiDestAMask)
+			{
+				if(DestInfo.uiABitsPerPixel < SourceInfo.uiABitsPerPixel)	// downsample
+					DA = Shrink<vlUInt16>(SA, SourceInfo.uiABitsPerPixel, DestInfo.uiABitsPerPixel);
+				else if(DestInfo.uiABitsPerPixel > SourceInfo.uiABitsPerPixel)	// upsample
+					DA = Expand<vlUInt16>(SA, SourceInfo.uiABitsPerPixel, DestInfo.uiABitsPerPixel);
+				else
+					DA = SA;
+			}
+		}
 
-	if(uiMipmapHeight < 1)
-		uiMipmapHeight = 1;
+		// write source to single variable
+		U Dest = ((U)(DR & uiDestRMask) << (U)uiDestRShift) | ((U)(DG & uiDestGMask) << (U)uiDestGShift) | ((U)(DB & uiDestBMask) << (U)uiDestBShift) | ((U)(DA & uiDestAMask) << (U)uiDestAShift);
+		for(i = 0; i < DestInfo.uiBytesPerPixel; i++)
+		{
+			lpDest[i] = (vlByte)((Dest >> ((T)i * 8)) & 0xff);
+		}
+	}
 
-	if(uiMipmapDepth < 1)
-		uiMipmapDepth = 1;
+	return vlTrue;
 }
 
-//-----------------------------------------------------------------------------
-// ComputeMIPSize( vlInt iMipLevel, VTFImageFormat fmt )
 //
-// Computes the size (in bytes) of a single mipmap of a single face of a single frame 
-//-----------------------------------------------------------------------------
-vlUInt CVTFFile::ComputeMipmapSize(vlUInt uiWidth, vlUInt uiHeight, vlUInt uiDepth, vlUInt uiMipmapLevel, VTFImageFormat ImageFormat)
-{
-	// figure out the width/height of this MIP level
-	vlUInt uiMipmapWidth, uiMipmapHeight, uiMipmapDepth;
-	CVTFFile::ComputeMipmapDimensions(uiWidth, uiHeight, uiDepth, uiMipmapLevel, uiMipmapWidth, uiMipmapHeight, uiMipmapDepth);
-	
-	// return the memory requirements
-	return CVTFFile::ComputeImageSize(uiMipmapWidth, uiMipmapHeight, uiMipmapDepth, ImageFormat);
-}
-
-//---------------------------------------------------------------------------------
-// ComputeDataOffset(vlUInt uiFrame, vlUInt uiFace, vlUInt uiMipLevel, VTFImageFormat ImageFormat)
+// ConvertPixels()
+// Converts uncompressed data from one variable order and bit format to another.
 //
-// Returns the offset in our HiResDataBuffer of the data for an image at the 
-// chose frame, face, and mip level. Frame number starts at 0, Face starts at 0
-// MIP level 0 is the largest moving up to MIP count-1 for the smallest
-// To get the first, and largest image, you would use 0, 0, 0
-//---------------------------------------------------------------------------------
-vlUInt CVTFFile::ComputeDataOffset(vlUInt uiFrame, vlUInt uiFace, vlUInt uiSlice, vlUInt uiMipLevel, VTFImageFormat ImageFormat) const
+static vlBool ConvertPixels(vlByte *lpSource, vlByte *lpDest, vlUInt uiWidth, vlUInt uiHeight, const SVTFImageConvertInfo& SourceInfo, const SVTFImageConvertInfo& DestInfo, const SVTFLibOptions &Options, vlSingle sHDRLogAverageLuminance = -1.0f)
 {
-	vlUInt uiOffset = 0;
-
-	vlUInt uiFrameCount = this->GetFrameCount();
-	vlUInt uiFaceCount = this->GetFaceCount();
-	vlUInt uiSliceCount = this->GetDepth();
-	vlUInt uiMipCount = this->GetMipmapCount();
-
-	if(uiFrame >= uiFrameCount)
-	{
-		uiFrame = uiFrameCount - 1;
-	}
-	
-	if(uiFace >= uiFaceCount)
+	if(SourceInfo.uiBytesPerPixel <= 1)
 	{
-		uiFace = uiFaceCount - 1;
+		if(DestInfo.uiBytesPerPixel <= 1)
+			return ConvertTemplated<vlUInt8, vlUInt8>(lpSource, lpDest, uiWidth, uiHeight, SourceInfo, DestInfo, Options, sHDRLogAverageLuminance);
+		else if(DestInfo.uiBytesPerPixel <= 2)
+			return ConvertTemplated<vlUInt8, vlUInt16>(lpSource, lpDest, uiWidth, uiHeight, SourceInfo, DestInfo, Options, sHDRLogAverageLuminance);
+		else if(DestInfo.uiBytesPerPixel <= 4)
+			return ConvertTemplated<vlUInt8, vlUInt32>(lpSource, lpDest, uiWidth, uiHeight, SourceInfo, DestInfo, Options, sHDRLogAverageLuminance);
+		else if(DestInfo.uiBytesPerPixel <= 8)
+			return ConvertTemplated<vlUInt8, vlUInt64>(lpSource, lpDest, uiWidth, uiHeight, SourceInfo, DestInfo, Options, sHDRLogAverageLuminance);
 	}
-
-	if(uiSlice >= uiSliceCount)
+	else if(SourceInfo.uiBytesPerPixel <= 2)
 	{
-		uiSlice = uiSliceCount - 1;
+		if(DestInfo.uiBytesPerPixel <= 1)
+			return ConvertTemplated<vlUInt16, vlUInt8>(lpSource, lpDest, uiWidth, uiHeight, SourceInfo, DestInfo, Options, sHDRLogAverageLuminance);
+		else if(DestInfo.uiBytesPerPixel <= 2)
+			return ConvertTemplated<vlUInt16, vlUInt16>(lpSource, lpDest, uiWidth, uiHeight, SourceInfo, DestInfo, Options, sHDRLogAverageLuminance);
+		else if(DestInfo.uiBytesPerPixel <= 4)
+			return ConvertTemplated<vlUInt16, vlUInt32>(lpSource, lpDest, uiWidth, uiHeight, SourceInfo, DestInfo, Options, sHDRLogAverageLuminance);
+		else if(DestInfo.uiBytesPerPixel <= 8)
+			return ConvertTemplated<vlUInt16, vlUInt64>(lpSource, lpDest, uiWidth, uiHeight, SourceInfo, DestInfo, Options, sHDRLogAverageLuminance);
 	}
-
-	if(uiMipLevel >= uiMipCount)
+	else if(SourceInfo.uiBytesPerPixel <= 4)
 	{
-		uiMipLevel = uiMipCount - 1;
+		if(DestInfo.uiBytesPerPixel <= 1)
+			return ConvertTemplated<vlUInt32, vlUInt8>(lpSource, lpDest, uiWidth, uiHeight, SourceInfo, DestInfo, Options, sHDRLogAverageLuminance);
+		else if(DestInfo.uiBytesPerPixel <= 2)
+			return ConvertTemplated<vlUInt32, vlUInt16>(lpSource, lpDest, uiWidth, uiHeight, SourceInfo, DestInfo, Options, sHDRLogAverageLuminance);
+		else if(DestInfo.uiBytesPerPixel <= 4)
+			return ConvertTemplated<vlUInt32, vlUInt32>(lpSource, lpDest, uiWidth, uiHeight, SourceInfo, DestInfo, Options, sHDRLogAverageLuminance);
+		else if(DestInfo.uiBytesPerPixel <= 8)
+			return ConvertTemplated<vlUInt32, vlUInt64>(lpSource, lpDest, uiWidth, uiHeight, SourceInfo, DestInfo, Options, sHDRLogAverageLuminance);
 	}
-
-	// Transverse past all frames and faces of each mipmap (up to the requested one).
-	for(vlInt i = (vlInt)uiMipCount - 1; i > (vlInt)uiMipLevel; i--)
+	else if(SourceInfo.uiBytesPerPixel <= 8)
 	{
-		uiOffset += this->ComputeMipmapSize(this->Header->Width, this->Header->Height, this->Header->Depth, i, ImageFormat) * uiFrameCount * uiFaceCount;
+		if(DestInfo.uiBytesPerPixel <= 1)
+			return ConvertTemplated<vlUInt64, vlUInt8>(lpSource, lpDest, uiWidth, uiHeight, SourceInfo, DestInfo, Options, sHDRLogAverageLuminance);
+		else if(DestInfo.uiBytesPerPixel <= 2)
+			return ConvertTemplated<vlUInt64, vlUInt16>(lpSource, lpDest, uiWidth, uiHeight, SourceInfo, DestInfo, Options, sHDRLogAverageLuminance);
+		else if(DestInfo.uiBytesPerPixel <= 4)
+			return ConvertTemplated<vlUInt64, vlUInt32>(lpSource, lpDest, uiWidth, uiHeight, SourceInfo, DestInfo, Options, sHDRLogAverageLuminance);
+		else if(DestInfo.uiBytesPerPixel <= 8)
+			return ConvertTemplated<vlUInt64, vlUInt64>(lpSource, lpDest, uiWidth, uiHeight, SourceInfo, DestInfo, Options, sHDRLogAverageLuminance);
 	}
-
-	vlUInt uiTemp1 = this->ComputeMipmapSize(this->Header->Width, this->Header->Height, this->Header->Depth, uiMipLevel, ImageFormat);
-	vlUInt uiTemp2 = this->ComputeMipmapSize(this->Header->Width, this->Header->Height, 1, uiMipLevel, ImageFormat);
-
-	// Transverse past requested frames and faces of requested mipmap.
-	uiOffset += uiTemp1 * uiFrame * uiFaceCount * uiSliceCount;
-	uiOffset += uiTemp1 * uiFace * uiSliceCount;
-	uiOffset += uiTemp2 * uiSlice;
-
-	assert(uiOffset < this->uiImageBufferSize);
-	
-	return uiOffset;
+	return vlFalse;
 }
 
-//-----------------------------------------------------------------------------------------------------
-// ConvertToRGBA8888( vlByte *src, vlByte *dst, vlUInt uiWidth, vlUInt uiHeight, VTFImageFormat SourceFormat )
-//
-// Converts data from the source format to RGBA8888 format. Data is read from *src
-// and written to *dst. Width and height are needed to it knows how much data to process
-//-----------------------------------------------------------------------------------------------------
-vlBool CVTFFile::ConvertToRGBA8888(vlByte *lpSource, vlByte *lpDest, vlUInt uiWidth, vlUInt uiHeight, VTFImageFormat SourceFormat)
+vlBool CVTFFile::Convert(vlByte *lpSource, vlByte *lpDest, vlUInt uiWidth, vlUInt uiHeight, VTFImageFormat SourceFormat, VTFImageFormat DestFormat)
 {
-	return CVTFFile::Convert(lpSource, lpDest, uiWidth, uiHeight, SourceFormat, IMAGE_FORMAT_RGBA8888);
+	SVTFLibOptions Options;
+	VTFLib::GetOptions(Options);
+
+	return CVTFFile::Convert(lpSource, lpDest, uiWidth, uiHeight, SourceFormat, DestFormat, Options);
 }
 
-//-----------------------------------------------------------------------------------------------------
-// DXTn decompression code is based on examples on Microsofts website and from the
-// Developers Image Library (http://www.imagelib.org) (c) Denton Woods.
-//
-//-----------------------------------------------------------------------------------------------------
-// DecompressDXT1(vlByte *src, vlByte *dst, vlUInt uiWidth, vlUInt uiHeight)
-//
-// Converts data from the DXT1 to RGBA8888 format. Data is read from *src
-// and written to *dst. Width and height are needed to it knows how much data to process
-//-----------------------------------------------------------------------------------------------------
-vlBool CVTFFile::DecompressDXT1(vlByte *src, vlByte *dst, vlUInt uiWidth, vlUInt uiHeight)
+vlBool CVTFFile::Convert(vlByte *lpSource, vlByte *lpDest, vlUInt uiWidth, vlUInt uiHeight, VTFImageFormat SourceFormat, VTFImageFormat DestFormat, const SVTFLibOptions &Options)
 {
-	vlUInt		x, y, i, j, k, Select;
-	vlByte		*Temp;
-	Colour565	*color_0, *color_1;
-	Colour8888	colours[4], *col;
-	vlUInt		bitmask, Offset;
+	assert(lpSource != 0);
+	assert(lpDest != 0);
 
-	vlByte nBpp = 4;						// bytes per pixel (4 channels (RGBA))
-	vlByte nBpc = 1;						// bytes per channel (1 byte per channel)
-	vlUInt iBps = nBpp * nBpc * uiWidth;		// bytes per scanline
+	assert(SourceFormat >= 0 && SourceFormat < IMAGE_FORMAT_COUNT);
+	assert(DestFormat >= 0 && DestFormat < IMAGE_FORMAT_COUNT);
 
-	Temp = src;
+	// DXTn work is timed here rather than in the codecs, which are called for each
+	// strip when converting views.  These come before the conversion timer, which
+	// marks the thread as converting.
+	Diagnostics::CStatTimer DecodeTimer(VTFLIB_STAT_DXT_DECODE, SourceFormat != DestFormat ? SourceFormat : IMAGE_FORMAT_NONE, uiWidth, uiHeight);
+	Diagnostics::CStatTimer EncodeTimer(VTFLIB_STAT_DXT_ENCODE, SourceFormat != DestFormat ? DestFormat : IMAGE_FORMAT_NONE, uiWidth, uiHeight);
+	Diagnostics::CStatTimer Timer(SourceFormat, DestFormat, uiWidth, uiHeight);
 
-	for (y = 0; y < uiHeight; y += 4)
+	const SVTFImageConvertInfo& SourceInfo = VTFImageConvertInfo[SourceFormat];
+	const SVTFImageConvertInfo& DestInfo = VTFImageConvertInfo[DestFormat];
+
+	if(!SourceInfo.bIsSupported || !DestInfo.bIsSupported)
 	{
-		for (x = 0; x < uiWidth; x += 4)
-		{
-			color_0 = ((Colour565*)Temp);
-			color_1 = ((Colour565*)(Temp+2));
-			bitmask = ((vlUInt*)Temp)[1];
-			Temp += 8;
+		LastError.Set("Image format conversion not supported.");
 
-			colours[0].r = color_0->nRed << 3;
-			colours[0].g = color_0->nGreen << 2;
-			colours[0].b = color_0->nBlue << 3;
-			colours[0].a = 0xFF;
+		return vlFalse;
+	}
+
+	// Optimize common convertions.
+	if(SourceFormat == DestFormat)
+	{
+		memcpy( lpDest, lpSource, CVTFFile::ComputeImageSize(uiWidth, uiHeight, 1, DestFormat));
+		return vlTrue;
+	}
+
+	if(SourceFormat == IMAGE_FORMAT_RGB888 && DestFormat == IMAGE_FORMAT_RGBA8888)
+	{
+		vlByte *lpLast = lpSource + CVTFFile::ComputeImageSize(uiWidth, uiHeight, 1, SourceFormat);
+		for(; lpSource < lpLast; lpSource += 3, lpDest += 4)
+		{
+			lpDest[0] = lpSource[0];
+			lpDest[1] = lpSource[1];
+			lpDest[2] = lpSource[2];
+			lpDest[3] = 255;
+		}
+		return vlTrue;
+	}
 
-			colours[1].r = color_1->nRed << 3;
-			colours[1].g = color_1->nGreen << 2;
-			colours[1].b = color_1->nBlue << 3;
-			colours[1].a = 0xFF;
+	if(SourceFormat == IMAGE_FORMAT_RGBA8888 && DestFormat == IMAGE_FORMAT_RGB888)
+	{
+		vlByte *lpLast = lpSource + CVTFFile::ComputeImageSize(uiWidth, uiHeight, 1, SourceFormat);
+		for(; lpSource < lpLast; lpSource += 4, lpDest += 3)
+		{
+			lpDest[0] = lpSource[0];
+			lpDest[1] = lpSource[1];
+			lpDest[2] = lpSource[2];
+		}
+		return vlTrue;
+	}
 
-			if (*((vlUShort*)color_0) > *((vlUShort*)color_1))
-			{
-				// Four-color block: derive the other two colors.    
-				// 00 = color_0, 01 = color_1, 10 = color_2, 11 = color_3
-				// These 2-bit codes correspond to the 2-bit fields 
-				// stored in the 64-bit block.
-				colours[2].b = (2 * colours[0].b + colours[1].b + 1) / 3;
-				colours[2].g = (2 * colours[0].g + colours[1].g + 1) / 3;
-				colours[2].r = (2 * colours[0].r + colours[1].r + 1) / 3;
-				colours[2].a = 0xFF;
+	// Do general convertions.
+	if(SourceInfo.bIsCompressed || DestInfo.bIsCompressed)
+	{
+		vlByte *lpSourceRGBA = lpSource;
+		vlBool bResult = vlTrue;
 
-				colours[3].b = (colours[0].b + 2 * colours[1].b + 1) / 3;
-				colours[3].g = (colours[0].g + 2 * colours[1].g + 1) / 3;
-				colours[3].r = (colours[0].r + 2 * colours[1].r + 1) / 3;
-				colours[3].a = 0xFF;
-			}
-			else
-			{
-				// Three-color block: derive the other color.
-				// 00 = color_0,  01 = color_1,  10 = color_2,
-				// 11 = transparent.
-				// These 2-bit codes correspond to the 2-bit fields 
-				// stored in the 64-bit block. 
-				colours[2].b = (colours[0].b + colours[1].b) / 2;
-				colours[2].g = (colours[0].g + colours[1].g) / 2;
-				colours[2].r = (colours[0].r + colours[1].r) / 2;
-				colours[2].a = 0xFF;
+		// temp data for intermittent conversions, reused between calls
+		Memory::CScratchBuffer SourceRGBA;
+		if(SourceFormat != IMAGE_FORMAT_RGBA8888)
+		{
+			lpSourceRGBA = SourceRGBA.Allocate(CVTFFile::ComputeImageSize(uiWidth, uiHeight, 1, IMAGE_FORMAT_RGBA8888));
+		}
 
-				colours[3].b = (colours[0].b + 2 * colours[1].b + 1) / 3;
-				colours[3].g = (colours[0].g + 2 * colours[1].g + 1) / 3;
-				colours[3].r = (colours[0].r + 2 * colours[1].r + 1) / 3;
-				colours[3].a = 0x00;
-			}
+		// decompress the source or convert it to RGBA for compressing
+		switch(SourceFormat)
+		{
+		case IMAGE_FORMAT_RGBA8888:
+			break;
+		case IMAGE_FORMAT_DXT1:
+		case IMAGE_FORMAT_DXT1_ONEBITALPHA:
+			bResult = CVTFFile::DecompressDXT1(lpSource, lpSourceRGBA, uiWidth, uiHeight);
+			break;
+		case IMAGE_FORMAT_DXT3:
+			bResult = CVTFFile::DecompressDXT3(lpSource, lpSourceRGBA, uiWidth, uiHeight);
+			break;
+		case IMAGE_FORMAT_DXT5:
+			bResult = CVTFFile::DecompressDXT5(lpSource, lpSourceRGBA, uiWidth, uiHeight);
+			break;
+		default:
+			bResult = CVTFFile::Convert(lpSource, lpSourceRGBA, uiWidth, uiHeight, SourceFormat, IMAGE_FORMAT_RGBA8888, Options);
+			break;
+		}
 
-			for (j = 0, k = 0; j < 4; j++)
+		if(bResult)
+		{
+			// compress the source or convert it to the dest format if it is not compressed
+			switch(DestFormat)
 			{
-				for (i = 0; i < 4; i++, k++)
-				{
-					Select = (bitmask & (0x03 << k*2)) >> k*2;
-					col = &colours[Select];
-
-					if (((x + i) < uiWidth) && ((y + j) < uiHeight))
-					{
-						Offset = (y + j) * iBps + (x + i) * nBpp;
-						dst[Offset + 0] = col->r;
-						dst[Offset + 1] = col->g;
-						dst[Offset + 2] = col->b;
-						dst[Offset + 3] = col->a;
-					}
-				}
+			case IMAGE_FORMAT_DXT1:
+			case IMAGE_FORMAT_DXT1_ONEBITALPHA:
+			case IMAGE_FORMAT_DXT3:
+			case IMAGE_FORMAT_DXT5:
+				bResult = CVTFFile::CompressDXTn(lpSourceRGBA, lpDest, uiWidth, uiHeight, DestFormat, Options);
+				break;
+			default:
+				bResult = CVTFFile::Convert(lpSourceRGBA, lpDest, uiWidth, uiHeight, IMAGE_FORMAT_RGBA8888, DestFormat, Options);
+				break;
 			}
 		}
+
+		return bResult;
 	}
-	return vlTrue;
+
+	return ConvertPixels(lpSource, lpDest, uiWidth, uiHeight, SourceInfo, DestInfo, Options);
 }
 
-//-----------------------------------------------------------------------------------------------------
-// DecompressDXT3(vlByte *src, vlByte *dst, vlUInt uiWidth, vlUInt uiHeight)
 //
-// Converts data from the DXT3 to RGBA8888 format. Data is read from *src
-// and written to *dst. Width and height are needed to it knows how much data to process
-//-----------------------------------------------------------------------------------------------------
-vlBool CVTFFile::DecompressDXT3(vlByte *src, vlByte *dst, vlUInt uiWidth, vlUInt uiHeight)
+// GetViewRows()
+// Gets uiRows packed pixel rows of a view starting at uiRow, which must start a row
+// of blocks for DXTn formats.  Returns the rows in place if they are already packed,
+// otherwise a buffer the rows are copied into if bRead is set.
+//
+static vlByte *GetViewRows(const CImageView &View, vlUInt uiRow, vlUInt uiRows, Memory::CScratchBuffer &Buffer, vlBool bRead)
 {
-	vlUInt		x, y, i, j, k, Select;
-	vlByte		*Temp;
-	Colour565	*color_0, *color_1;
-	Colour8888	colours[4], *col;
-	vlUInt		bitmask, Offset;
-	vlUShort	word;
-	DXTAlphaBlockExplicit *alpha;
+	vlUInt uiRowHeight = CVTFFile::GetImageFormatInfo(View.GetFormat()).bIsCompressed ? 4 : 1;
+	vlUInt uiDataRows = (uiRows + uiRowHeight - 1) / uiRowHeight;
 
-	vlByte nBpp = 4;						// bytes per pixel (4 channels (RGBA))
-	vlByte nBpc = 1;						// bytes per channel (1 byte per channel)
-	vlUInt iBps = nBpp * nBpc * uiWidth;		// bytes per scanline
+	if(uiDataRows <= 1 || View.IsPacked())
+	{
+		return View.GetRow(uiRow);
+	}
 
-	Temp = src;
+	vlUInt uiRowSize = View.GetRowSize();
+	vlByte *lpBuffer = Buffer.Allocate((vlUInt64)uiRowSize * uiDataRows);
 
-	for (y = 0; y < uiHeight; y += 4)
+	if(bRead)
 	{
-		for (x = 0; x < uiWidth; x += 4)
+		for(vlUInt i = 0; i < uiDataRows; i++)
 		{
-			alpha = (DXTAlphaBlockExplicit*)Temp;
-			Temp += 8;
-			color_0 = ((Colour565*)Temp);
-			color_1 = ((Colour565*)(Temp+2));
-			bitmask = ((vlUInt*)Temp)[1];
-			Temp += 8;
-
-			colours[0].r = color_0->nRed << 3;
-			colours[0].g = color_0->nGreen << 2;
-			colours[0].b = color_0->nBlue << 3;
-			colours[0].a = 0xFF;
+			memcpy(lpBuffer + (size_t)i * uiRowSize, View.GetRow(uiRow) + (size_t)i * View.GetPitch(), uiRowSize);
+		}
+	}
 
-			colours[1].r = color_1->nRed << 3;
-			colours[1].g = color_1->nGreen << 2;
-			colours[1].b = color_1->nBlue << 3;
-			colours[1].a = 0xFF;
+	return lpBuffer;
+}
 
-			// Four-color block: derive the other two colors.    
-			// 00 = color_0, 01 = color_1, 10 = color_2, 11 = color_3
-			// These 2-bit codes correspond to the 2-bit fields 
-			// stored in the 64-bit block.
-			colours[2].b = (2 * colours[0].b + colours[1].b + 1) / 3;
-			colours[2].g = (2 * colours[0].g + colours[1].g + 1) / 3;
-			colours[2].r = (2 * colours[0].r + colours[1].r + 1) / 3;
-			colours[2].a = 0xFF;
+//
+// PutViewRows()
+// Copies rows from GetViewRows() back into the view if they weren't in place.
+//
+static vlVoid PutViewRows(const CImageView &View, vlUInt uiRow, vlUInt uiRows, const vlByte *lpRows)
+{
+	if(lpRows == View.GetRow(uiRow))
+	{
+		return;
+	}
 
-			colours[3].b = (colours[0].b + 2 * colours[1].b + 1) / 3;
-			colours[3].g = (colours[0].g + 2 * colours[1].g + 1) / 3;
-			colours[3].r = (colours[0].r + 2 * colours[1].r + 1) / 3;
-			colours[3].a = 0xFF;
+	vlUInt uiRowHeight = CVTFFile::GetImageFormatInfo(View.GetFormat()).bIsCompressed ? 4 : 1;
+	vlUInt uiDataRows = (uiRows + uiRowHeight - 1) / uiRowHeight;
+	vlUInt uiRowSize = View.GetRowSize();
 
-			k = 0;
-			for (j = 0; j < 4; j++)
-			{
-				for (i = 0; i < 4; i++, k++)
-				{
-					Select = (bitmask & (0x03 << k*2)) >> k*2;
-					col = &colours[Select];
+	for(vlUInt i = 0; i < uiDataRows; i++)
+	{
+		memcpy(View.GetRow(uiRow) + (size_t)i * View.GetPitch(), lpRows + (size_t)i * uiRowSize, uiRowSize);
+	}
+}
 
-					if (((x + i) < uiWidth) && ((y + j) < uiHeight))
-					{
-						Offset = (y + j) * iBps + (x + i) * nBpp;
-						dst[Offset + 0] = col->r;
-						dst[Offset + 1] = col->g;
-						dst[Offset + 2] = col->b;
-					}
-				}
-			}
+vlBool CVTFFile::Convert(const CImageView &Source, const CImageView &Dest)
+{
+	SVTFLibOptions Options;
+	VTFLib::GetOptions(Options);
 
-			for (j = 0; j < 4; j++)
-			{
-				word = alpha->row[j];
-				for (i = 0; i < 4; i++)
-				{
-					if (((x + i) < uiWidth) && ((y + j) < uiHeight))
-					{
-						Offset = (y + j) * iBps + (x + i) * nBpp + 3;
-						dst[Offset] = word & 0x0F;
-						dst[Offset] = dst[Offset] | (dst[Offset] << 4);
-					}
-					
-					word >>= 4;
-				}
-			}
-		}
-	}
-	return vlTrue;
+	return CVTFFile::Convert(Source, Dest, Options);
 }
 
-//-----------------------------------------------------------------------------------------------------
-// DecompressDXT5(vlByte *src, vlByte *dst, vlUInt uiWidth, vlUInt uiHeight)
 //
-// Converts data from the DXT5 to RGBA8888 format. Data is read from *src
-// and written to *dst. Width and height are needed to it knows how much data to process
-//-----------------------------------------------------------------------------------------------------
-vlBool CVTFFile::DecompressDXT5(vlByte *src, vlByte *dst, vlUInt uiWidth, vlUInt uiHeight)
+// Convert()
+// Converts between image views.  Packed views are converted in one go, otherwise
+// the image is converted a row at a time (a row of blocks if either side is DXTn)
+// straight between the views, copying only rows that aren't laid out as needed.
+//
+vlBool CVTFFile::Convert(const CImageView &Source, const CImageView &Dest, const SVTFLibOptions &Options)
 {
-	vlUInt		x, y, i, j, k, Select;
-	vlByte		*Temp;
-	Colour565	*color_0, *color_1;
-	Colour8888	colours[4], *col;
-	vlUInt		bitmask, Offset;
-	vlByte		alphas[8], *alphamask;
-	vlUInt		bits;
+	if(Source.IsEmpty() || Dest.IsEmpty())
+	{
+		LastError.Set("Image view is empty.");
+		return vlFalse;
+	}
 
-	vlByte nBpp = 4;						// bytes per pixel (4 channels (RGBA))
-	vlByte nBpc = 1;						// bytes per channel (1 byte per channel)
-	vlUInt iBps = nBpp * nBpc * uiWidth;		// bytes per scanline
+	if(Source.GetWidth() != Dest.GetWidth() || Source.GetHeight() != Dest.GetHeight())
+	{
+		LastError.Set("Source and destination image views are different sizes.");
+		return vlFalse;
+	}
 
-	Temp = src;
+	vlUInt uiWidth = Source.GetWidth();
+	vlUInt uiHeight = Source.GetHeight();
+	VTFImageFormat SourceFormat = Source.GetFormat();
+	VTFImageFormat DestFormat = Dest.GetFormat();
 
-	for (y = 0; y < uiHeight; y += 4)
+	if(Source.IsPacked() && Dest.IsPacked())
 	{
-		for (x = 0; x < uiWidth; x += 4)
-		{
-			//if (y >= uiHeight || x >= uiWidth)
-			//		break;
+		return CVTFFile::Convert(Source.GetData(), Dest.GetData(), uiWidth, uiHeight, SourceFormat, DestFormat, Options);
+	}
 
-			alphas[0] = Temp[0];
-			alphas[1] = Temp[1];
-			alphamask = Temp + 2;
-			Temp += 8;
-			color_0 = ((Colour565*)Temp);
-			color_1 = ((Colour565*)(Temp+2));
-			bitmask = ((vlUInt*)Temp)[1];
-			Temp += 8;
+	const SVTFImageConvertInfo& SourceInfo = VTFImageConvertInfo[SourceFormat];
+	const SVTFImageConvertInfo& DestInfo = VTFImageConvertInfo[DestFormat];
 
-			colours[0].r = color_0->nRed << 3;
-			colours[0].g = color_0->nGreen << 2;
-			colours[0].b = color_0->nBlue << 3;
-			colours[0].a = 0xFF;
+	if(!SourceInfo.bIsSupported || !DestInfo.bIsSupported)
+	{
+		LastError.Set("Image format conversion not supported.");
 
-			colours[1].r = color_1->nRed << 3;
-			colours[1].g = color_1->nGreen << 2;
-			colours[1].b = color_1->nBlue << 3;
-			colours[1].a = 0xFF;
+		return vlFalse;
+	}
 
-			// Four-color block: derive the other two colors.    
-			// 00 = color_0, 01 = color_1, 10 = color_2, 11 = color_3
-			// These 2-bit codes correspond to the 2-bit fields 
-			// stored in the 64-bit block.
-			colours[2].b = (2 * colours[0].b + colours[1].b + 1) / 3;
-			colours[2].g = (2 * colours[0].g + colours[1].g + 1) / 3;
-			colours[2].r = (2 * colours[0].r + colours[1].r + 1) / 3;
-			colours[2].a = 0xFF;
+	// Counts the whole image once, the conversions of each row are nested in it.
+	Diagnostics::CStatTimer DecodeTimer(VTFLIB_STAT_DXT_DECODE, SourceFormat != DestFormat ? SourceFormat : IMAGE_FORMAT_NONE, uiWidth, uiHeight);
+	Diagnostics::CStatTimer EncodeTimer(VTFLIB_STAT_DXT_ENCODE, SourceFormat != DestFormat ? DestFormat : IMAGE_FORMAT_NONE, uiWidth, uiHeight);
+	Diagnostics::CStatTimer Timer(SourceFormat, DestFormat, uiWidth, uiHeight);
 
-			colours[3].b = (colours[0].b + 2 * colours[1].b + 1) / 3;
-			colours[3].g = (colours[0].g + 2 * colours[1].g + 1) / 3;
-			colours[3].r = (colours[0].r + 2 * colours[1].r + 1) / 3;
-			colours[3].a = 0xFF;
+	// FP16 data is tone mapped with the log average luminance of the whole image.
+	vlSingle sHDRLogAverageLuminance = -1.0f;
+	if(SourceFormat == IMAGE_FORMAT_RGBA16161616F && DestFormat != IMAGE_FORMAT_RGBA16161616F)
+	{
+		sHDRLogAverageLuminance = ComputeHDRLogAverageLuminance(Source.GetData(), uiWidth, uiHeight, SourceInfo.uiBytesPerPixel, Source.GetPitch());
+	}
 
-			k = 0;
-			for (j = 0; j < 4; j++)
-			{
-				for (i = 0; i < 4; i++, k++)
-				{
-					Select = (bitmask & (0x03 << k*2)) >> k*2;
-					col = &colours[Select];
+	vlUInt uiStripHeight = SourceInfo.bIsCompressed || DestInfo.bIsCompressed ? 4 : 1;
 
-					// only put pixels out < width or height
-					if (((x + i) < uiWidth) && ((y + j) < uiHeight)) {
-						Offset = (y + j) * iBps + (x + i) * nBpp;
-						dst[Offset + 0] = col->r;
-						dst[Offset + 1] = col->g;
-						dst[Offset + 2] = col->b;
-					}
-				}
-			}
+	Memory::CScratchBuffer SourceStrip, DestStrip, RGBAStrip;
+	for(vlUInt y = 0; y < uiHeight; y += uiStripHeight)
+	{
+		vlUInt uiRows = std::min(uiStripHeight, uiHeight - y);
 
-			// 8-alpha or 6-alpha block?    
-			if (alphas[0] > alphas[1])
-			{ 
-				// 8-alpha block:  derive the other six alphas.    
-				// Bit code 000 = alpha_0, 001 = alpha_1, others are interpolated.
-				alphas[2] = (6 * alphas[0] + 1 * alphas[1] + 3) / 7;	// bit code 010
-				alphas[3] = (5 * alphas[0] + 2 * alphas[1] + 3) / 7;	// bit code 011
-				alphas[4] = (4 * alphas[0] + 3 * alphas[1] + 3) / 7;	// bit code 100
-				alphas[5] = (3 * alphas[0] + 4 * alphas[1] + 3) / 7;	// bit code 101
-				alphas[6] = (2 * alphas[0] + 5 * alphas[1] + 3) / 7;	// bit code 110
-				alphas[7] = (1 * alphas[0] + 6 * alphas[1] + 3) / 7;	// bit code 111  
-			}    
-			else
-			{  
-				// 6-alpha block.    
-				// Bit code 000 = alpha_0, 001 = alpha_1, others are interpolated.
-				alphas[2] = (4 * alphas[0] + 1 * alphas[1] + 2) / 5;	// Bit code 010
-				alphas[3] = (3 * alphas[0] + 2 * alphas[1] + 2) / 5;	// Bit code 011
-				alphas[4] = (2 * alphas[0] + 3 * alphas[1] + 2) / 5;	// Bit code 100
-				alphas[5] = (1 * alphas[0] + 4 * alphas[1] + 2) / 5;	// Bit code 101
-				alphas[6] = 0x00;										// Bit code 110
-				alphas[7] = 0xFF;										// Bit code 111
-			}
+		vlByte *lpSource = GetViewRows(Source, y, uiRows, SourceStrip, vlTrue);
+		vlByte *lpDest = GetViewRows(Dest, y, uiRows, DestStrip, vlFalse);
 
-			// Note: Have to separate the next two loops,
-			//	it operates on a 6-byte system.
+		vlBool bResult;
+		if(sHDRLogAverageLuminance >= 0.0f && DestInfo.bIsCompressed)
+		{
+			vlByte *lpRGBA = RGBAStrip.Allocate(CVTFFile::ComputeImageSize(uiWidth, uiRows, 1, IMAGE_FORMAT_RGBA8888));
 
-			// First three bytes
-			bits = *((int*)alphamask);
-			for (j = 0; j < 2; j++)
-			{
-				for (i = 0; i < 4; i++)
-				{
-					// only put pixels out < width or height
-					if (((x + i) < uiWidth) && ((y + j) < uiHeight)) {
-						Offset = (y + j) * iBps + (x + i) * nBpp + 3;
-							dst[Offset] = alphas[bits & 0x07];
-					}
-					bits >>= 3;
-				}
-			}
+			bResult = CVTFFile::DecodeRows(lpSource, lpRGBA, uiWidth, uiRows, SourceFormat, sHDRLogAverageLuminance, Options) && CVTFFile::Convert(lpRGBA, lpDest, uiWidth, uiRows, IMAGE_FORMAT_RGBA8888, DestFormat, Options);
+		}
+		else if(sHDRLogAverageLuminance >= 0.0f)
+		{
+			bResult = ConvertPixels(lpSource, lpDest, uiWidth, uiRows, SourceInfo, DestInfo, Options, sHDRLogAverageLuminance);
+		}
+		else
+		{
+			bResult = CVTFFile::Convert(lpSource, lpDest, uiWidth, uiRows, SourceFormat, DestFormat, Options);
+		}
 
-			// Last three bytes
-			bits = *((int*)&alphamask[3]);
-			for (j = 2; j < 4; j++)
-			{
-				for (i = 0; i < 4; i++)
-				{
-					// only put pixels out < width or height
-					if (((x + i) < uiWidth) && ((y + j) < uiHeight)) {
-						Offset = (y + j) * iBps + (x + i) * nBpp + 3;
-							dst[Offset] = alphas[bits & 0x07];
-					}
-					bits >>= 3;
-				}
-			}
+		if(!bResult)
+		{
+			return vlFalse;
 		}
+
+		PutViewRows(Dest, y, uiRows, lpDest);
 	}
+
 	return vlTrue;
 }
 
 //
-// ConvertFromRGBA8888()
-// Convert input image data (lpSource) to output image data (lpDest) of format DestFormat.
+// ConvertToNormalMap()
+// Convert source data (in format RGBA8888) to a normal map.  If dest data is null then the
+// result is copied back into the source data.
 //
-vlBool CVTFFile::ConvertFromRGBA8888(vlByte *lpSource, vlByte *lpDest, vlUInt uiWidth, vlUInt uiHeight, VTFImageFormat DestFormat)
+vlBool CVTFFile::ConvertToNormalMap(vlByte *lpSourceRGBA8888, vlByte *lpDestRGBA8888, vlUInt uiWidth, vlUInt uiHeight, VTFKernelFilter KernelFilter, VTFHeightConversionMethod HeightConversionMethod, VTFNormalAlphaResult NormalAlphaResult, vlByte bMinimumZ, vlSingle sScale, vlBool bWrap, vlBool bInvertX, vlBool bInvertY, vlBool bInvertZ)
 {
-	return CVTFFile::Convert(lpSource, lpDest, uiWidth, uiHeight, IMAGE_FORMAT_RGBA8888, DestFormat);
+	assert(KernelFilter >= 0 && KernelFilter < KERNEL_FILTER_COUNT);
+	assert(HeightConversionMethod >= 0 && HeightConversionMethod < HEIGHT_CONVERSION_METHOD_COUNT);
+	assert(NormalAlphaResult >= 0 && NormalAlphaResult < NORMAL_ALPHA_RESULT_COUNT);
+
+#ifdef USE_NVDXT
+	nvCompressionOptions Options = nvCompressionOptions();
+
+	SVTFLibOptions VTFLibOptions;
+	VTFLib::GetOptions(VTFLibOptions);
+
+	SNVCompressionUserData UserData = SNVCompressionUserData(lpDestRGBA8888 != 0 ? lpDestRGBA8888 : lpSourceRGBA8888, IMAGE_FORMAT_RGBA8888, VTFLibOptions);
+
+	// Don't generate mipmaps.
+	Options.mipMapGeneration = kNoMipMaps;
+
+	// Set normal map options.
+	Options.normalMap.bEnableNormalMapConversion = true;
+	Options.normalMap.filterKernel = (nvNormalMapFilters)(KERNEL_FILTER_BASE + (vlInt)KernelFilter);
+	Options.normalMap.heightConversionMethod = (nvHeightConversionMethods)(HEIGHT_CONVERSION_METHOD_BASE + (vlInt)HeightConversionMethod);
+	Options.normalMap.alphaResult = (nvAlphaResult)(NORMAL_ALPHA_RESULT_BASE + (vlInt)NormalAlphaResult);
+	Options.normalMap.minz = bMinimumZ;
+	Options.normalMap.scale = sScale;
+	Options.normalMap.bWrap = bWrap;
+	Options.normalMap.bInvertX = bInvertX;
+	Options.normalMap.bInvertY = bInvertY;
+	Options.normalMap.bInvertZ = bInvertZ;
+//	Options.normalMap.bSignedOutput = KernelFilter == KERNEL_FILTER_DUDV;	// Normal maps seem to be signed in Source, DuDv maps don't.
+	Options.normalMap.bNormalMapSwapRGB = true;	// Our input is RGB but the output is still BGR unless we set this.
+
+	// Set the format.
+	Options.textureFormat = k8888;
+	Options.bSwapRB = true;
+
+	// The UserData struct gets passed to our callback.
+	Options.user_data = &UserData;
+
+	return nvDXTCompressWrapper(lpSourceRGBA8888, uiWidth, uiHeight, &Options, NVWriteCallback);
+#else
+	LastError.Set("NVDXT support required for CVTFFile::ConvertToNormalMap().");
+	return vlFalse;
+#endif
 }
 
-//
-// CompressDXTn()
-// Compress input image data (lpSource) to output image data (lpDest) of format DestFormat
-// where DestFormat is of format DXTn.  Uses NVidia DXT library.
-//
-vlBool CVTFFile::CompressDXTn(vlByte *lpSource, vlByte *lpDest, vlUInt uiWidth, vlUInt uiHeight, VTFImageFormat DestFormat)
+vlBool CVTFFile::Resize(vlByte *lpSourceRGBA8888, vlByte *lpDestRGBA8888, vlUInt uiSourceWidth, vlUInt uiSourceHeight, vlUInt uiDestWidth, vlUInt uiDestHeight, VTFMipmapFilter ResizeFilter, VTFSharpenFilter SharpenFilter)
+{
+	SVTFLibOptions VTFLibOptions;
+	VTFLib::GetOptions(VTFLibOptions);
+
+	return CVTFFile::Resize(lpSourceRGBA8888, lpDestRGBA8888, uiSourceWidth, uiSourceHeight, uiDestWidth, uiDestHeight, ResizeFilter, SharpenFilter, VTFLibOptions);
+}
+
+vlBool CVTFFile::Resize(vlByte *lpSourceRGBA8888, vlByte *lpDestRGBA8888, vlUInt uiSourceWidth, vlUInt uiSourceHeight, vlUInt uiDestWidth, vlUInt uiDestHeight, VTFMipmapFilter ResizeFilter, VTFSharpenFilter SharpenFilter, const SVTFLibOptions &VTFLibOptions)
 {
+	assert(ResizeFilter >= 0 && ResizeFilter < MIPMAP_FILTER_COUNT);
+	assert(SharpenFilter >= 0 && SharpenFilter < SHARPEN_FILTER_COUNT);
+
 #ifdef USE_NVDXT
+	Diagnostics::CStatTimer Timer(VTFLIB_STAT_RESIZE, (vlUInt64)uiSourceWidth * uiSourceHeight * 4);
+
 	nvCompressionOptions Options = nvCompressionOptions();
 
-	SNVCompressionUserData UserData = SNVCompressionUserData(lpDest, DestFormat);
+	SNVCompressionUserData UserData = SNVCompressionUserData(lpDestRGBA8888, IMAGE_FORMAT_RGBA8888, VTFLibOptions);
 
 	// Don't generate mipmaps.
 	Options.mipMapGeneration = kNoMipMaps;
 
+	// Set new image size.
+	Options.rescaleImageType = kRescalePreScale;
+	Options.scaleX = (vlSingle)uiDestWidth;
+	Options.scaleY = (vlSingle)uiDestHeight;
+
+	// Set resize filter.
+	Options.rescaleImageFilter = (nvMipFilterTypes)ResizeFilter;
+
+	// Setup sharpen filter.
+	if(SharpenFilter != SHARPEN_FILTER_NONE)
+	{
+		Options.sharpenFilterType = (nvSharpenFilterTypes)SharpenFilter;
+		Options.sharpening_passes_per_mip_level[0] = 1;
+		Options.unsharp_data.radius32F = VTFLibOptions.sUnsharpenRadius;
+		Options.unsharp_data.amount32F = VTFLibOptions.sUnsharpenAmount;
+		Options.unsharp_data.threshold32F = VTFLibOptions.sUnsharpenThreshold;
+		Options.xsharp_data.strength32F = VTFLibOptions.sXSharpenStrength;
+		Options.xsharp_data.threshold32F = VTFLibOptions.sXSharpenThreshold;
+	}
+
 	// Set the format.
-	switch(uiDXTQuality)
+	Options.textureFormat = k8888;
+	Options.bSwapRB = true;
+
+	// The UserData struct gets passed to our callback.
+	Options.user_data = &UserData;
+
+	return nvDXTCompressWrapper(lpSourceRGBA8888, uiSourceWidth, uiSourceHeight, &Options, NVWriteCallback);
+#else
+	LastError.Set("NVDXT support required for CVTFFile::Resize().");
+	return vlFalse;
+#endif
+}
+
+vlBool CVTFFile::Resize(const CImageView &Source, const CImageView &Dest, VTFMipmapFilter ResizeFilter, VTFSharpenFilter SharpenFilter)
+{
+	SVTFLibOptions VTFLibOptions;
+	VTFLib::GetOptions(VTFLibOptions);
+
+	return CVTFFile::Resize(Source, Dest, ResizeFilter, SharpenFilter, VTFLibOptions);
+}
+
+//
+// Resize()
+// Resizes between RGBA8888 image views.  NVDXT only takes packed images, so
+// views that aren't are copied through scratch memory.
+//
+vlBool CVTFFile::Resize(const CImageView &Source, const CImageView &Dest, VTFMipmapFilter ResizeFilter, VTFSharpenFilter SharpenFilter, const SVTFLibOptions &VTFLibOptions)
+{
+	if(Source.IsEmpty() || Dest.IsEmpty())
 	{
-	case DXT_QUALITY_LOW:
-		Options.quality = kQualityFastest;
-		break;
-	case DXT_QUALITY_MEDIUM:
-		Options.quality = kQualityNormal;
-		break;
-	case DXT_QUALITY_HIGH:
-		Options.quality = kQualityProduction;
-		break;
-	case DXT_QUALITY_HIGHEST:
-		Options.quality = kQualityHighest;
-		break;
+		LastError.Set("Image view is empty.");
+		return vlFalse;
 	}
-	switch(DestFormat)
+
+	if(Source.GetFormat() != IMAGE_FORMAT_RGBA8888 || Dest.GetFormat() != IMAGE_FORMAT_RGBA8888)
 	{
-	case IMAGE_FORMAT_DXT1:
-		Options.textureFormat = kDXT1;
-		Options.bForceDXT1FourColors = true;
-		break;
-	case IMAGE_FORMAT_DXT1_ONEBITALPHA:
-		Options.bBinaryAlpha = true;
-		Options.bForceDXT1FourColors = true;
-		Options.textureFormat = kDXT1a;
-		/*for(vlUInt i = 3; i < uiWidth * uiHeight * 4; i += 4)
-		{
-			lpSource[i] = lpSource[i] >= 128 ? 255 : 0;
-		}*/
-		break;
-	case IMAGE_FORMAT_DXT3:
-		Options.textureFormat = kDXT3;
-		break;
-	case IMAGE_FORMAT_DXT5:
-		Options.textureFormat = kDXT5;
-		break;
-	default:
-		LastError.Set("Destination image format not supported.");
+		LastError.Set("Image views must be RGBA8888.");
 		return vlFalse;
 	}
 
-	// nvDXTcompressRGBA() fails on widths or heights of 1 or 2 so rescale those images.
-	if(uiWidth < 4)
+	Memory::CScratchBuffer SourceBuffer, DestBuffer;
+
+	vlByte *lpSource = GetViewRows(Source, 0, Source.GetHeight(), SourceBuffer, vlTrue);
+	vlByte *lpDest = GetViewRows(Dest, 0, Dest.GetHeight(), DestBuffer, vlFalse);
+
+	if(!CVTFFile::Resize(lpSource, lpDest, Source.GetWidth(), Source.GetHeight(), Dest.GetWidth(), Dest.GetHeight(), ResizeFilter, SharpenFilter, VTFLibOptions))
 	{
-		Options.rescaleImageType = kRescalePreScale;
-		Options.rescaleImageFilter = kMipFilterPoint;
-		Options.scaleX = 4.0f;
+		return vlFalse;
 	}
 
-	if(uiHeight < 4)
+	PutViewRows(Dest, 0, Dest.GetHeight(), lpDest);
+
+	return vlTrue;
+}
+
+//
+// CorrectImageGamma()
+// Do gamma correction on the image data.
+//
+vlVoid CVTFFile::CorrectImageGamma(vlByte *lpImageDataRGBA8888, vlUInt uiWidth, vlUInt uiHeight, vlSingle sGammaCorrection)
+{
+	if(sGammaCorrection == 1.0f)
+	{
+		return;
+	}
+
+	vlByte bTable[256];
+
+	sGammaCorrection = 1.0f / sGammaCorrection;
+
+	// Precalculate all possible gamma correction values.
+	for(vlUInt i = 0; i < 256; i++)
 	{
-		Options.rescaleImageType = kRescalePreScale;
-		Options.rescaleImageFilter = kMipFilterPoint;
-		Options.scaleY = 4.0f;
+		bTable[i] = (vlByte)(pow((vlSingle)i / 255.0f, sGammaCorrection) * 255.0f);
 	}
 
-	// The UserData struct gets passed to our callback.
-	Options.user_data = &UserData;
+	vlByte *lpImageDataRGBA8888End = lpImageDataRGBA8888 + uiWidth * uiHeight * 4;
 
-	return nvDXTCompressWrapper(lpSource, uiWidth, uiHeight, &Options, NVWriteCallback);
-#else
-	LastError.Set("NVDXT support required for DXTn compression).");
-	return vlFalse;
-#endif
+	// Do gamma correction on RGB channels.
+	for(; lpImageDataRGBA8888 < lpImageDataRGBA8888End; lpImageDataRGBA8888 += 4)
+	{
+		lpImageDataRGBA8888[0] = bTable[lpImageDataRGBA8888[0]];
+		lpImageDataRGBA8888[1] = bTable[lpImageDataRGBA8888[1]];
+		lpImageDataRGBA8888[2] = bTable[lpImageDataRGBA8888[2]];
+	}
 }
 
-typedef vlVoid (*TransformProc)(vlUInt16& R, vlUInt16& G, vlUInt16& B, vlUInt16& A);
-
-vlVoid ToLuminance(vlUInt16& R, vlUInt16& G, vlUInt16& B, vlUInt16& A)
+//
+// ComputeImageReflectivity()
+// Compute the image data reflectivity value.
+//
+vlVoid CVTFFile::ComputeImageReflectivity(vlByte *lpImageDataRGBA8888, vlUInt uiWidth, vlUInt uiHeight, vlSingle &sX, vlSingle &sY, vlSingle &sZ)
 {
-	R = G = B = (vlUInt16)(sLuminanceWeightR * (vlSingle)R + sLuminanceWeightG * (vlSingle)G + sLuminanceWeightB * (vlSingle)B);
+	SVTFImageStatistics Statistics;
+	CVTFFile::ComputeImageStatistics(lpImageDataRGBA8888, uiWidth, uiHeight, IMAGE_FORMAT_RGBA8888, Statistics);
+
+	sX = Statistics.sReflectivity[0];
+	sY = Statistics.sReflectivity[1];
+	sZ = Statistics.sReflectivity[2];
 }
 
-vlVoid FromLuminance(vlUInt16& R, vlUInt16& G, vlUInt16& B, vlUInt16& A)
+#define STATISTICS_STRIP_ROWS		4			// Rows decoded at a time, one row of DXTn blocks.
+#define STATISTICS_LUMINANCE_MAX	65280		// (77 + 150 + 29) * 255
+#define STATISTICS_LOG_SCALE		65536.0		// Log luminance fixed point scale.
+
+// Partial statistics for a band of rows.  Everything is an integer so the bands
+// can be added in any order and still give the same result.
+// -------------------------------------------------------------------------------
+struct SImageStatisticsBand
 {
-	B = G = R;
-}
+	vlUInt uiHistogram[4][256];
+	vlUInt64 uiLogLuminance;				// sum of -log(luminance) in fixed point
+};
 
-vlVoid ToBlueScreen(vlUInt16& R, vlUInt16& G, vlUInt16& B, vlUInt16& A)
+//
+// GetLogLuminanceTable()
+// Gets -log(luminance) in fixed point for every value 77 * R + 150 * G + 29 * B can take.
+//
+static const vlUInt *GetLogLuminanceTable()
 {
-	if(A == 0x0000)
+	struct SLogLuminanceTable
 	{
-		R = uiBlueScreenMaskR;
-		G = uiBlueScreenMaskG;
-		B = uiBlueScreenMaskB;
-	}
-	A = 0xffff;
+		vlUInt uiValues[STATISTICS_LUMINANCE_MAX + 1];
+
+		SLogLuminanceTable()
+		{
+			for(vlUInt i = 0; i <= STATISTICS_LUMINANCE_MAX; i++)
+			{
+				this->uiValues[i] = (vlUInt)(-log(0.0000000001 + (vlDouble)i / (vlDouble)STATISTICS_LUMINANCE_MAX) * STATISTICS_LOG_SCALE + 0.5);
+			}
+		}
+	};
+
+	static const SLogLuminanceTable Table;
+
+	return Table.uiValues;
 }
 
-vlVoid FromBlueScreen(vlUInt16& R, vlUInt16& G, vlUInt16& B, vlUInt16& A)
+//
+// DecodeRows()
+// Decodes a strip of rows to RGBA8888.  lpSource points at the first row, which must
+// start a row of blocks for DXTn formats.  FP16 data is tone mapped with the given key
+// so strips come out the same as if the whole image had been converted.
+//
+vlBool CVTFFile::DecodeRows(vlByte *lpSource, vlByte *lpDest, vlUInt uiWidth, vlUInt uiRows, VTFImageFormat SourceFormat, vlSingle sHDRLogAverageLuminance, const SVTFLibOptions &Options)
 {
-	if(R == uiBlueScreenMaskR && G == uiBlueScreenMaskG && B == uiBlueScreenMaskB)
-	{
-		R = uiBlueScreenClearR;
-		G = uiBlueScreenClearG;
-		B = uiBlueScreenClearB;
-		A = 0x0000;
-	}
-	else
+	switch(SourceFormat)
 	{
-		A = 0xffff;
+	case IMAGE_FORMAT_DXT1:
+	case IMAGE_FORMAT_DXT1_ONEBITALPHA:
+		return CVTFFile::DecompressDXT1(lpSource, lpDest, uiWidth, uiRows);
+	case IMAGE_FORMAT_DXT3:
+		return CVTFFile::DecompressDXT3(lpSource, lpDest, uiWidth, uiRows);
+	case IMAGE_FORMAT_DXT5:
+		return CVTFFile::DecompressDXT5(lpSource, lpDest, uiWidth, uiRows);
+	case IMAGE_FORMAT_RGBA16161616F:
+		return ConvertTemplated<vlUInt64, vlUInt32>(lpSource, lpDest, uiWidth, uiRows, VTFImageConvertInfo[SourceFormat], VTFImageConvertInfo[IMAGE_FORMAT_RGBA8888], Options, sHDRLogAverageLuminance);
+	default:
+		return CVTFFile::Convert(lpSource, lpDest, uiWidth, uiRows, SourceFormat, IMAGE_FORMAT_RGBA8888, Options);
 	}
 }
 
-vlSingle sHDRLogAverageLuminance;
-
-vlVoid ToFP16(vlUInt16& R, vlUInt16& G, vlUInt16& B, vlUInt16& A)
+//
+// ComputeImageStatistics()
+// Analyses image data in one pass.  Rows are decoded a strip at a time (RGBA8888 is
+// read in place) and only histograms and the luminance sum are gathered per pixel;
+// everything else is worked out from the histograms afterwards.
+//
+vlBool CVTFFile::ComputeImageStatistics(vlByte *lpSource, vlUInt uiWidth, vlUInt uiHeight, VTFImageFormat SourceFormat, SVTFImageStatistics &Statistics)
 {
+	SVTFLibOptions Options;
+	VTFLib::GetOptions(Options);
 
+	return CVTFFile::ComputeImageStatistics(lpSource, uiWidth, uiHeight, SourceFormat, Statistics, Options);
 }
 
-vlSingle ClampFP16(vlSingle sValue)
-{
-	if(sValue < 0.0f)
-		sValue = 0.0f;
-	if(sValue > 65335.0f)
-		sValue = 65335.0f;
-	return sValue;
-}
-
-// Reference:
-// http://msdn.microsoft.com/library/default.asp?url=/library/en-us/directx9_c/directx/graphics/programmingguide/advancedtopics/HDRLighting/HDRLighting.asp
-vlVoid FromFP16(vlUInt16& R, vlUInt16& G, vlUInt16& B, vlUInt16& A)
+vlBool CVTFFile::ComputeImageStatistics(vlByte *lpSource, vlUInt uiWidth, vlUInt uiHeight, VTFImageFormat SourceFormat, SVTFImageStatistics &Statistics, const SVTFLibOptions &Options)
 {
-	vlSingle sR = (vlSingle)R, sG = (vlSingle)G, sB = (vlSingle)B;//, sA = (vlSingle)A;
+	memset(&Statistics, 0, sizeof(SVTFImageStatistics));
 
-	vlSingle sY = sR * 0.299f + sG * 0.587f + sB * 0.114f;
+	if(lpSource == 0 || uiWidth == 0 || uiHeight == 0)
+	{
+		LastError.Set("No image data to analyse.");
 
-	vlSingle sU = (sB - sY) * 0.565f;
-	vlSingle sV = (sR - sY) * 0.713f;
+		return vlFalse;
+	}
 
-	vlSingle sTemp = sY;
+	if(SourceFormat < 0 || SourceFormat >= IMAGE_FORMAT_COUNT || !VTFImageConvertInfo[SourceFormat].bIsSupported)
+	{
+		LastError.Set("Image format conversion not supported.");
 
-	sTemp = sFP16HDRKey * sTemp / sHDRLogAverageLuminance;
-	sTemp = sTemp / (1.0f + sTemp);
+		return vlFalse;
+	}
 
-	sTemp = sTemp / sY;
+	// FP16 strips must be tone mapped with the key of the whole image, which is also
+	// the log average luminance we report for it.
+	vlBool bHDR = SourceFormat == IMAGE_FORMAT_RGBA16161616F;
+	vlSingle sHDRLogAverageLuminance = bHDR ? ComputeHDRLogAverageLuminance(lpSource, uiWidth, uiHeight, VTFImageConvertInfo[SourceFormat].uiBytesPerPixel) : 0.0f;
+	const vlUInt *lpLogLuminance = bHDR ? 0 : GetLogLuminanceTable();
 
-	R = (vlUInt16)ClampFP16(pow((sY + 1.403f * sV) * sTemp + sFP16HDRShift, sFP16HDRGamma) * 65535.0f);
-	G = (vlUInt16)ClampFP16(pow((sY - 0.344f * sU - 0.714f * sV) * sTemp + sFP16HDRShift, sFP16HDRGamma) * 65535.0f);
-	B = (vlUInt16)ClampFP16(pow((sY + 1.770f * sU) * sTemp + sFP16HDRShift, sFP16HDRGamma) * 65535.0f);
-}
+	SImageStatisticsBand Total;
+	memset(&Total, 0, sizeof(SImageStatisticsBand));
 
-typedef struct tagSVTFImageConvertInfo
-{
-	vlUInt	uiBitsPerPixel;			// Format bytes per pixel.
-	vlUInt	uiBytesPerPixel;		// Format bytes per pixel.
-	vlUInt	uiRBitsPerPixel;		// Format conversion red bits per pixel.  0 for N/A.
-	vlUInt	uiGBitsPerPixel;		// Format conversion green bits per pixel.  0 for N/A.
-	vlUInt	uiBBitsPerPixel;		// Format conversion blue bits per pixel.  0 for N/A.
-	vlUInt	uiABitsPerPixel;		// Format conversion alpha bits per pixel.  0 for N/A.
-	vlInt	iR;						// "Red" index.
-	vlInt	iG;						// "Green" index.
-	vlInt	iB;						// "Blue" index.
-	vlInt	iA;						// "Alpha" index.
-	vlBool	bIsCompressed;			// Format is compressed (DXT).
-	vlBool	bIsSupported;			// Format is supported by VTFLib.
-	TransformProc pToTransform;		// Custom transform to function.
-	TransformProc pFromTransform;	// Custom transform from function.
-	VTFImageFormat Format;
-} SVTFImageConvertInfo;
+	vlBool bError = vlFalse;
+	std::mutex Mutex;
 
-static SVTFImageConvertInfo VTFImageConvertInfo[] =
-{
-	{	 32,  4,  8,  8,  8,  8,	 0,	 1,	 2,	 3,	vlFalse,  vlTrue,	NULL,	NULL,		IMAGE_FORMAT_RGBA8888},
-	{	 32,  4,  8,  8,  8,  8,	 3,	 2,	 1,	 0, vlFalse,  vlTrue,	NULL,	NULL,		IMAGE_FORMAT_ABGR8888},
-	{	 24,  3,  8,  8,  8,  0,	 0,	 1,	 2,	-1, vlFalse,  vlTrue,	NULL,	NULL,		IMAGE_FORMAT_RGB888},
-	{	 24,  3,  8,  8,  8,  0,	 2,	 1,	 0,	-1, vlFalse,  vlTrue,	NULL,	NULL,		IMAGE_FORMAT_BGR888},
-	{	 16,  2,  5,  6,  5,  0,	 0,	 1,	 2,	-1, vlFalse,  vlTrue,	NULL,	NULL,		IMAGE_FORMAT_RGB565},
-	{	  8,  1,  8,  8,  8,  0,	 0,	-1,	-1,	-1, vlFalse,  vlTrue,	ToLuminance,	FromLuminance,	IMAGE_FORMAT_I8},
-	{	 16,  2,  8,  8,  8,  8,	 0,	-1,	-1,	 1, vlFalse,  vlTrue,	ToLuminance,	FromLuminance,	IMAGE_FORMAT_IA88},
-	{	  8,  1,  0,  0,  0,  0,	-1,	-1,	-1,	-1, vlFalse, vlFalse,	NULL,	NULL,		IMAGE_FORMAT_P8},
-	{ 	  8,  1,  0,  0,  0,  8,	-1,	-1,	-1,	 0, vlFalse,  vlTrue,	NULL,	NULL,		IMAGE_FORMAT_A8},
-	{ 	 24,  3,  8,  8,  8,  8,	 0,	 1,	 2,	-1, vlFalse,  vlTrue,	ToBlueScreen,	FromBlueScreen,	IMAGE_FORMAT_RGB888_BLUESCREEN},
-	{ 	 24,  3,  8,  8,  8,  8,	 2,	 1,	 0,	-1, vlFalse,  vlTrue,	ToBlueScreen,	FromBlueScreen,	IMAGE_FORMAT_BGR888_BLUESCREEN},
-	{ 	 32,  4,  8,  8,  8,  8,	 3,	 0,	 1,	 2, vlFalse,  vlTrue,	NULL,	NULL,		IMAGE_FORMAT_ARGB8888},
-	{ 	 32,  4,  8,  8,  8,  8,	 2,	 1,	 0,	 3, vlFalse,  vlTrue,	NULL,	NULL,		IMAGE_FORMAT_BGRA8888},
-	{ 	  4,  0,  0,  0,  0,  0,	-1,	-1,	-1,	-1,  vlTrue,  vlTrue,	NULL,	NULL,		IMAGE_FORMAT_DXT1},
-	{ 	  8,  0,  0,  0,  0,  8,	-1,	-1,	-1,	-1,  vlTrue,  vlTrue,	NULL,	NULL,		IMAGE_FORMAT_DXT3},
-	{ 	  8,  0,  0,  0,  0,  8,	-1,	-1,	-1,	-1,  vlTrue,  vlTrue,	NULL,	NULL,		IMAGE_FORMAT_DXT5},
-	{ 	 32,  4,  8,  8,  8,  0,	 2,	 1,	 0,	-1, vlFalse,  vlTrue,	NULL,	NULL,		IMAGE_FORMAT_BGRX8888},
-	{ 	 16,  2,  5,  6,  5,  0,	 2,	 1,	 0,	-1, vlFalse,  vlTrue,	NULL,	NULL,		IMAGE_FORMAT_BGR565},
-	{ 	 16,  2,  5,  5,  5,  0,	 2,	 1,	 0,	-1, vlFalse,  vlTrue,	NULL,	NULL,		IMAGE_FORMAT_BGRX5551},
-	{ 	 16,  2,  4,  4,  4,  4,	 2,	 1,	 0,	 3, vlFalse,  vlTrue,	NULL,	NULL,		IMAGE_FORMAT_BGRA4444},
-	{ 	  4,  0,  0,  0,  0,  1,	-1,	-1,	-1,	-1,  vlTrue,  vlTrue,	NULL,	NULL,		IMAGE_FORMAT_DXT1_ONEBITALPHA},
-	{ 	 16,  2,  5,  5,  5,  1,	 2,	 1,	 0,	 3, vlFalse,  vlTrue,	NULL,	NULL,		IMAGE_FORMAT_BGRA5551},
-	{ 	 16,  2,  8,  8,  0,  0,	 0,	 1,	-1,	-1, vlFalse,  vlTrue,	NULL,	NULL,		IMAGE_FORMAT_UV88},
-	{ 	 32,  4,  8,  8,  8,  8,	 0,	 1,	 2,	 3, vlFalse,  vlTrue,	NULL,	NULL,		IMAGE_FORMAT_UVWQ8888},
-	{    64,  8, 16, 16, 16, 16,	 0,	 1,	 2,	 3, vlFalse,  vlTrue,	ToFP16,	FromFP16,	IMAGE_FORMAT_RGBA16161616F},
-	{	 64,  8, 16, 16, 16, 16,	 0,	 1,	 2,	 3, vlFalse,  vlTrue,	NULL,	NULL,		IMAGE_FORMAT_RGBA16161616},
-	{ 	 32,  4,  8,  8,  8,  8,	 0,	 1,	 2,	 3, vlFalse,  vlTrue,	NULL,	NULL,		IMAGE_FORMAT_UVLX8888},
-	{ 	 32,  4, 32,  0,  0,  0,	 0,	-1,	-1,	-1, vlFalse, vlFalse,	NULL,	NULL,		IMAGE_FORMAT_R32F},
-	{ 	 96, 12, 32, 32, 32,  0,	 0,	 1,	 2,	-1, vlFalse, vlFalse,	NULL,	NULL,		IMAGE_FORMAT_RGB323232F},
-	{	128, 16, 32, 32, 32, 32,	 0,	 1,	 2,	 3, vlFalse, vlFalse,	NULL,	NULL,		IMAGE_FORMAT_RGBA32323232F},
-	{    16,  2, 16,  0,  0,  0,	 0,	-1,	-1,	-1, vlFalse,  vlTrue,	NULL,	NULL,		IMAGE_FORMAT_NV_DST16},
-	{	 24,  3, 24,  0,  0,  0,	 0,	-1,	-1,	-1, vlFalse,  vlTrue,	NULL,	NULL,		IMAGE_FORMAT_NV_DST24},
-	{	 32,  4,  0,  0,  0,  0,	-1,	-1,	-1,	-1, vlFalse, vlFalse,	NULL,	NULL,		IMAGE_FORMAT_NV_INTZ},
-	{	 24,  3,  0,  0,  0,  0,    -1,	-1,	-1,	-1, vlFalse, vlFalse,	NULL,	NULL,		IMAGE_FORMAT_NV_RAWZ},
-	{	 16,  2, 16,  0,  0,  0,	 0,	-1,	-1,	-1, vlFalse,  vlTrue,	NULL,	NULL,		IMAGE_FORMAT_ATI_DST16},
-	{	 24,  3, 24,  0,  0,  0,	 0,	-1,	-1,	-1, vlFalse,  vlTrue,	NULL,	NULL,		IMAGE_FORMAT_ATI_DST24},
-	{	 32,  4,  0,  0,  0,  0,	-1,	-1,	-1,	-1, vlFalse, vlFalse,	NULL,	NULL,		IMAGE_FORMAT_NV_NULL},
-	{	  4,  0,  0,  0,  0,  0,	-1, -1, -1, -1,  vlTrue, vlFalse,	NULL,	NULL,		IMAGE_FORMAT_ATI1N},
-	{     8,  0,  0,  0,  0,  0,	-1, -1, -1, -1,  vlTrue, vlFalse,	NULL,	NULL,		IMAGE_FORMAT_ATI2N}/*,
-	{	 16,  2, 16,  0,  0,  0,	 0, -1, -1, -1, vlFalse,  vlTrue,	NULL,	NULL,		IMAGE_FORMAT_X360_DST16},
-	{	 24,  3, 24,  0,  0,  0,	 0, -1, -1, -1, vlFalse,  vlTrue,	NULL,	NULL,		IMAGE_FORMAT_X360_DST24},
-	{	 24,  3,  0,  0,  0,  0,	-1, -1, -1, -1, vlFalse, vlFalse,	NULL,	NULL,		IMAGE_FORMAT_X360_DST24F},
-	{ 	 32,  4,  8,  8,  8,  0,	 2,	 1,	 0,	-1, vlFalse,  vlTrue,	NULL,	NULL,		IMAGE_FORMAT_LINEAR_BGRX8888},
-	{	 32,  4,  8,  8,  8,  8,	 0,	 1,	 2,	 3,	vlFalse,  vlTrue,	NULL,	NULL,		IMAGE_FORMAT_LINEAR_RGBA8888},
-	{	 32,  4,  8,  8,  8,  8,	 3,	 2,	 1,	 0, vlFalse,  vlTrue,	NULL,	NULL,		IMAGE_FORMAT_LINEAR_ABGR8888},
-	{ 	 32,  4,  8,  8,  8,  8,	 3,	 0,	 1,	 2, vlFalse,  vlTrue,	NULL,	NULL,		IMAGE_FORMAT_LINEAR_ARGB8888},
-	{ 	 32,  4,  8,  8,  8,  8,	 2,	 1,	 0,	 3, vlFalse,  vlTrue,	NULL,	NULL,		IMAGE_FORMAT_LINEAR_BGRA8888},
-	{	 32,  4,  8,  8,  8,  8,	 0,	 1,	 2,	-1,	vlFalse,  vlTrue,	NULL,	NULL,		IMAGE_FORMAT_LINEAR_RGB888},
-	{	 32,  4,  8,  8,  8,  8,	 2,	 1,	 0,	-1,	vlFalse,  vlTrue,	NULL,	NULL,		IMAGE_FORMAT_LINEAR_BGR888},
-	{ 	 16,  2,  5,  5,  5,  0,	 2,	 1,	 0,	-1, vlFalse,  vlTrue,	NULL,	NULL,		IMAGE_FORMAT_LINEAR_BGRX5551},
-	{	  8,  1,  8,  8,  8,  0,	 0,	-1,	-1,	-1, vlFalse,  vlTrue,	ToLuminance,	FromLuminance,	IMAGE_FORMAT_LINEAR_I8},	
-	{	 64,  8, 16, 16, 16, 16,	 0,	 1,	 2,	 3, vlFalse,  vlTrue,	NULL,	NULL,		IMAGE_FORMAT_LINEAR_RGBA16161616}*/
-};
+	vlUInt uiStrips = (uiHeight + STATISTICS_STRIP_ROWS - 1) / STATISTICS_STRIP_ROWS;
 
-// Get each channels shift and mask (for encoding and decoding).
-template<typename T>
-vlVoid GetShiftAndMask(const SVTFImageConvertInfo& Info, T &uiRShift, T &uiGShift, T &uiBShift, T &uiAShift, T &uiRMask, T &uiGMask, T &uiBMask, T &uiAMask)
-{
-	if(Info.iR >= 0)
+	ForEachRow(uiStrips, [&](vlUInt uiStart, vlUInt uiEnd)
 	{
-		if(Info.iG >= 0 && Info.iG < Info.iR)
-			uiRShift += (T)Info.uiGBitsPerPixel;
+		SImageStatisticsBand Band;
+		memset(&Band, 0, sizeof(SImageStatisticsBand));
 
-		if(Info.iB >= 0 && Info.iB < Info.iR)
-			uiRShift += (T)Info.uiBBitsPerPixel;
+		std::vector<vlByte> Strip;
+		if(SourceFormat != IMAGE_FORMAT_RGBA8888)
+		{
+			Strip.resize((size_t)uiWidth * STATISTICS_STRIP_ROWS * 4);
+		}
 
-		if(Info.iA >= 0 && Info.iA < Info.iR)
-			uiRShift += (T)Info.uiABitsPerPixel;
+		vlBool bResult = vlTrue;
+		for(vlUInt uiStrip = uiStart; uiStrip < uiEnd && bResult; uiStrip++)
+		{
+			vlUInt uiY = uiStrip * STATISTICS_STRIP_ROWS;
+			vlUInt uiRows = uiHeight - uiY < STATISTICS_STRIP_ROWS ? uiHeight - uiY : STATISTICS_STRIP_ROWS;
 
-		uiRMask = (T)(~0) >> (T)((sizeof(T) * 8) - Info.uiRBitsPerPixel); // Mask is for down shifted values.
-	}
+			vlByte *lpStrip = lpSource + CVTFFile::ComputeImageSize(uiWidth, uiY, 1, SourceFormat);
 
-	if(Info.iG >= 0)
-	{
-		if(Info.iR >= 0 && Info.iR < Info.iG)
-			uiGShift += (T)Info.uiRBitsPerPixel;
+			if(SourceFormat != IMAGE_FORMAT_RGBA8888)
+			{
+				bResult = CVTFFile::DecodeRows(lpStrip, &Strip[0], uiWidth, uiRows, SourceFormat, sHDRLogAverageLuminance, Options);
+				lpStrip = &Strip[0];
+			}
 
-		if(Info.iB >= 0 && Info.iB < Info.iG)
-			uiGShift += (T)Info.uiBBitsPerPixel;
+			const vlByte *lpPixel = lpStrip;
+			const vlByte *lpPixelEnd = lpStrip + (size_t)uiWidth * uiRows * 4;
 
-		if(Info.iA >= 0 && Info.iA < Info.iG)
-			uiGShift += (T)Info.uiABitsPerPixel;
+			for(; lpPixel < lpPixelEnd; lpPixel += 4)
+			{
+				Band.uiHistogram[0][lpPixel[0]]++;
+				Band.uiHistogram[1][lpPixel[1]]++;
+				Band.uiHistogram[2][lpPixel[2]]++;
+				Band.uiHistogram[3][lpPixel[3]]++;
+			}
 
-		uiGMask = (T)(~0) >> (T)((sizeof(T) * 8) - Info.uiGBitsPerPixel);
-	}
+			// Second pass while the strip is still in cache.
+			if(lpLogLuminance != 0)
+			{
+				vlUInt64 uiSum = 0;
+				for(lpPixel = lpStrip; lpPixel < lpPixelEnd; lpPixel += 4)
+				{
+					uiSum += lpLogLuminance[77 * lpPixel[0] + 150 * lpPixel[1] + 29 * lpPixel[2]];
+				}
+				Band.uiLogLuminance += uiSum;
+			}
+		}
 
-	if(Info.iB >= 0)
-	{
-		if(Info.iR >= 0 && Info.iR < Info.iB)
-			uiBShift += (T)Info.uiRBitsPerPixel;
+		std::lock_guard<std::mutex> Lock(Mutex);
 
-		if(Info.iG >= 0 && Info.iG < Info.iB)
-			uiBShift += (T)Info.uiGBitsPerPixel;
+		for(vlUInt i = 0; i < 4; i++)
+		{
+			for(vlUInt j = 0; j < 256; j++)
+			{
+				Total.uiHistogram[i][j] += Band.uiHistogram[i][j];
+			}
+		}
+		Total.uiLogLuminance += Band.uiLogLuminance;
 
-		if(Info.iA >= 0 && Info.iA < Info.iB)
-			uiBShift += (T)Info.uiABitsPerPixel;
+		if(!bResult)
+		{
+			bError = vlTrue;
+		}
+	});
 
-		uiBMask = (T)(~0) >> (T)((sizeof(T) * 8) - Info.uiBBitsPerPixel);
+	if(bError)
+	{
+		LastError.Set("Error decoding image data.");
+
+		return vlFalse;
 	}
 
-	if(Info.iA >= 0)
+	vlSingle sTable[256];
+	for(vlUInt i = 0; i < 256; i++)
 	{
-		if(Info.iR >= 0 && Info.iR < Info.iA)
-			uiAShift += (T)Info.uiRBitsPerPixel;
+		sTable[i] = pow((vlSingle)i / 255.0f, 2.2f);
+	}
 
-		if(Info.iG >= 0 && Info.iG < Info.iA)
-			uiAShift += (T)Info.uiGBitsPerPixel;
+	Statistics.uiPixelCount = uiWidth * uiHeight;
+	memcpy(Statistics.uiHistogram, Total.uiHistogram, sizeof(Total.uiHistogram));
 
-		if(Info.iB >= 0 && Info.iB < Info.iA)
-			uiAShift += (T)Info.uiBBitsPerPixel;
+	vlDouble dInverse = 1.0 / ((vlDouble)uiWidth * (vlDouble)uiHeight);
 
-		uiAMask = (T)(~0) >> (T)((sizeof(T) * 8) - Info.uiABitsPerPixel);
-	}
-}
+	Statistics.bConstant = vlTrue;
+	for(vlUInt i = 0; i < 4; i++)
+	{
+		vlUInt uiMinimum = 255, uiMaximum = 0, uiLevels = 0;
+		vlDouble dSum = 0.0, dLinearSum = 0.0;
 
-// Downsample a channel.
-template<typename T>
-T Shrink(T S, T SourceBits, T DestBits)
-{
-	if(SourceBits == 0 || DestBits == 0)
-		return 0;
+		for(vlUInt j = 0; j < 256; j++)
+		{
+			vlUInt uiCount = Total.uiHistogram[i][j];
+			if(uiCount == 0)
+				continue;
 
-	return S >> (SourceBits - DestBits);
-}
+			if(j < uiMinimum)
+				uiMinimum = j;
+			uiMaximum = j;
+			uiLevels++;
 
-// Upsample a channel.
-template<typename T>
-T Expand(T S, T SourceBits, T DestBits)
-{
-	if(SourceBits == 0 || DestBits == 0)
-		return 0;
+			dSum += (vlDouble)j * (vlDouble)uiCount;
+			dLinearSum += (vlDouble)sTable[j] * (vlDouble)uiCount;
+		}
 
-	T D = 0;
+		Statistics.bMinimum[i] = (vlByte)uiMinimum;
+		Statistics.bMaximum[i] = (vlByte)uiMaximum;
+		Statistics.sMean[i] = (vlSingle)(dSum * dInverse);
 
-	// Repeat source bit pattern as much as possible.
-	while(DestBits >= SourceBits)
+		if(i < 3)
+		{
+			Statistics.sReflectivity[i] = (vlSingle)(dLinearSum * dInverse);
+		}
+
+		// One level in every channel means one colour.
+		if(uiLevels != 1)
+		{
+			Statistics.bConstant = vlFalse;
+		}
+	}
+
+	const vlUInt *lpAlpha = Total.uiHistogram[3];
+	if(lpAlpha[255] == Statistics.uiPixelCount)
+	{
+		Statistics.AlphaUsage = ALPHA_USAGE_NONE;
+	}
+	else if(lpAlpha[0] + lpAlpha[255] == Statistics.uiPixelCount)
 	{
-		D <<= SourceBits;
-		D |= S;
-		DestBits -= SourceBits;
+		Statistics.AlphaUsage = ALPHA_USAGE_ONEBIT;
+	}
+	else
+	{
+		Statistics.AlphaUsage = ALPHA_USAGE_EIGHTBIT;
 	}
 
-	// Add most significant part of source bit pattern to least significant part of dest bit pattern.
-	if(DestBits)
+	if(bHDR)
 	{
-		S >>= SourceBits - DestBits;
-		D <<= DestBits;
-		D |= S;
+		Statistics.sLogAverageLuminance = sHDRLogAverageLuminance;
+	}
+	else
+	{
+		Statistics.sLogAverageLuminance = (vlSingle)exp(-(vlDouble)Total.uiLogLuminance / STATISTICS_LOG_SCALE * dInverse);
 	}
 
-	return D;
+	return vlTrue;
 }
 
-// Run custom transformation functions.
-template<typename T, typename U>
-vlVoid Transform(TransformProc pTransform1, TransformProc pTransform2, T SR, T SG, T SB, T SA, T SRBits, T SGBits, T SBBits, T SABits, U& DR, U& DG, U& DB, U& DA, U DRBits, U DGBits, U DBBits, U DABits)
+// Running totals for one preview texel.
+// -------------------------------------
+struct SPreviewBin
 {
-	vlUInt16 TR, TG, TB, TA;
-
-	// Expand from source to 16 bits for transform functions.
-	SRBits && SRBits < 16 ? TR = (vlUInt16)Expand<T>(SR, SRBits, 16) : TR = (vlUInt16)SR;
-	SGBits && SGBits < 16 ? TG = (vlUInt16)Expand<T>(SG, SGBits, 16) : TG = (vlUInt16)SG;
-	SBBits && SBBits < 16 ? TB = (vlUInt16)Expand<T>(SB, SBBits, 16) : TB = (vlUInt16)SB;
-	SABits && SABits < 16 ? TA = (vlUInt16)Expand<T>(SA, SABits, 16) : TA = (vlUInt16)SA;
-
-	// Source transform then dest transform.
-	if(pTransform1)
-		pTransform1(TR, TG, TB, TA);
-	if(pTransform2)
-		pTransform2(TR, TG, TB, TA);
+	vlUInt64 uiSums[4];
+	vlUInt64 uiCount;
+};
 
-	// Shrink to dest from 16 bits.
-	DRBits && DRBits < 16 ? DR = (U)Shrink<vlUInt16>(TR, 16, (vlUInt16)DRBits) : DR = (U)TR;
-	DGBits && DGBits < 16 ? DG = (U)Shrink<vlUInt16>(TG, 16, (vlUInt16)DGBits) : DG = (U)TG;
-	DBBits && DBBits < 16 ? DB = (U)Shrink<vlUInt16>(TB, 16, (vlUInt16)DBBits) : DB = (U)TB;
-	DABits && DABits < 16 ? DA = (U)Shrink<vlUInt16>(TA, 16, (vlUInt16)DABits) : DA = (U)TA;
+//
+// CountBits()
+// Counts the set bits in a 32 bit value.
+//
+static inline vlUInt CountBits(vlUInt uiValue)
+{
+	uiValue = uiValue - ((uiValue >> 1) & 0x55555555);
+	uiValue = (uiValue & 0x33333333) + ((uiValue >> 2) & 0x33333333);
+	return (((uiValue + (uiValue >> 4)) & 0x0F0F0F0F) * 0x01010101) >> 24;
 }
 
-// Convert source to dest using required storage requirments (hence the template).
-template<typename T, typename U>
-vlBool ConvertTemplated(vlByte *lpSource, vlByte *lpDest, vlUInt uiWidth, vlUInt uiHeight, const SVTFImageConvertInfo& SourceInfo, const SVTFImageConvertInfo& DestInfo)
+//
+// SumDXTnBlock()
+// Adds up the texels of a DXTn block straight from its end points and indices, giving
+// the same totals as decoding it would.  uiMask has a bit set for each texel that lies
+// inside the image.
+//
+static vlVoid SumDXTnBlock(const vlByte *lpBlock, VTFImageFormat Format, vlUInt uiMask, SPreviewBin &Bin)
 {
-	vlUInt16 uiSourceRShift = 0, uiSourceGShift = 0, uiSourceBShift = 0, uiSourceAShift = 0;
-	vlUInt16 uiSourceRMask = 0, uiSourceGMask = 0, uiSourceBMask = 0, uiSourceAMask = 0;
+	vlBool bDXT1 = Format == IMAGE_FORMAT_DXT1 || Format == IMAGE_FORMAT_DXT1_ONEBITALPHA;
+	const vlByte *lpColour = bDXT1 ? lpBlock : lpBlock + 8;
 
-	vlUInt16 uiDestRShift = 0, uiDestGShift = 0, uiDestBShift = 0, uiDestAShift = 0;
-	vlUInt16 uiDestRMask = 0, uiDestGMask = 0, uiDestBMask = 0, uiDestAMask = 0;
-
-	GetShiftAndMask<vlUInt16>(SourceInfo, uiSourceRShift, uiSourceGShift, uiSourceBShift, uiSourceAShift, uiSourceRMask, uiSourceGMask, uiSourceBMask, uiSourceAMask);
-	GetShiftAndMask<vlUInt16>(DestInfo, uiDestRShift, uiDestGShift, uiDestBShift, uiDestAShift, uiDestRMask, uiDestGMask, uiDestBMask, uiDestAMask);
+	vlUInt uiColour0 = (vlUInt)lpColour[0] | ((vlUInt)lpColour[1] << 8);
+	vlUInt uiColour1 = (vlUInt)lpColour[2] | ((vlUInt)lpColour[3] << 8);
+	vlUInt uiIndices = (vlUInt)lpColour[4] | ((vlUInt)lpColour[5] << 8) | ((vlUInt)lpColour[6] << 16) | ((vlUInt)lpColour[7] << 24);
 
-	// If we are in the FP16 HDR format we will need a log average.
-	if(SourceInfo.Format == IMAGE_FORMAT_RGBA16161616F)
+	// How many texels use each palette entry, counted on the low and high bits of all
+	// the 2 bit indices at once.
+	vlUInt uiFieldMask = 0x55555555;
+	if(uiMask != 0xFFFF)
 	{
-		vlByte* lpFPSource = lpSource;
-
-		sHDRLogAverageLuminance = 0.0f;
-
-		vlByte *lpFPSourceEnd = lpFPSource + (uiWidth * uiHeight * SourceInfo.uiBytesPerPixel);
-		for(; lpFPSource < lpFPSourceEnd; lpFPSource += SourceInfo.uiBytesPerPixel)
+		uiFieldMask = 0;
+		for(vlUInt k = 0; k < 16; k++)
 		{
-			vlUInt16* p = (vlUInt16*)lpFPSource;
-
-			vlSingle sLuminance = (vlSingle)p[0] * 0.299f + (vlSingle)p[1] * 0.587f + (vlSingle)p[2] * 0.114f;
-
-			sHDRLogAverageLuminance += log(0.0000000001f + sLuminance);
+			if(uiMask & (1 << k))
+				uiFieldMask |= 1 << (k * 2);
 		}
-
-		sHDRLogAverageLuminance = exp(sHDRLogAverageLuminance / (vlSingle)(uiWidth * uiHeight));
 	}
 
-	vlByte *lpSourceEnd = lpSource + (uiWidth * uiHeight * SourceInfo.uiBytesPerPixel);
-	for(; lpSource < lpSourceEnd; lpSource += SourceInfo.uiBytesPerPixel, lpDest += DestInfo.uiBytesPerPixel)
+	vlUInt uiLow = uiIndices & uiFieldMask;
+	vlUInt uiHigh = (uiIndices >> 1) & uiFieldMask;
+
+	vlUInt uiCounts[4];
+	uiCounts[1] = CountBits(uiLow & ~uiHigh);
+	uiCounts[2] = CountBits(uiHigh & ~uiLow);
+	uiCounts[3] = CountBits(uiLow & uiHigh);
+	uiCounts[0] = CountBits(uiFieldMask) - uiCounts[1] - uiCounts[2] - uiCounts[3];
+
+	// Build the palette the same way DecompressDXTn() does.
+	vlUInt uiPalette[4][4];
+	uiPalette[0][0] = ((uiColour0 >> 11) & 0x1F) << 3;
+	uiPalette[0][1] = ((uiColour0 >> 5) & 0x3F) << 2;
+	uiPalette[0][2] = (uiColour0 & 0x1F) << 3;
+	uiPalette[1][0] = ((uiColour1 >> 11) & 0x1F) << 3;
+	uiPalette[1][1] = ((uiColour1 >> 5) & 0x3F) << 2;
+	uiPalette[1][2] = (uiColour1 & 0x1F) << 3;
+	uiPalette[0][3] = uiPalette[1][3] = uiPalette[2][3] = uiPalette[3][3] = 0xFF;
+
+	for(vlUInt i = 0; i < 3; i++)
 	{
-		// read source into single variable
-		vlUInt i;
-		T Source = 0;
-		for(i = 0; i < SourceInfo.uiBytesPerPixel; i++)
+		if(!bDXT1 || uiColour0 > uiColour1)
 		{
-			Source |= (T)lpSource[i] << ((T)i * 8);
+			uiPalette[2][i] = (2 * uiPalette[0][i] + uiPalette[1][i] + 1) / 3;
 		}
+		else
+		{
+			uiPalette[2][i] = (uiPalette[0][i] + uiPalette[1][i]) / 2;
+		}
+		uiPalette[3][i] = (uiPalette[0][i] + 2 * uiPalette[1][i] + 1) / 3;
+	}
 
-		vlUInt16 SR = 0, SG = 0, SB = 0, SA = ~0;
-		vlUInt16 DR = 0, DG = 0, DB = 0, DA = ~0;	// default values
-
-		// read source values
-		if(uiSourceRMask)
-			SR = (vlUInt16)(Source >> (T)uiSourceRShift) & uiSourceRMask;	// isolate R channel
-
-		if(uiSourceGMask)
-			SG = (vlUInt16)(Source >> (T)uiSourceGShift) & uiSourceGMask;	// isolate G channel
-
-		if(uiSourceBMask)
-			SB = (vlUInt16)(Source >> (T)uiSourceBShift) & uiSourceBMask;	// isolate B channel
+	if(bDXT1 && uiColour0 <= uiColour1)
+	{
+		uiPalette[3][3] = 0x00;
+	}
 
-		if(uiSourceAMask)
-			SA = (vlUInt16)(Source >> (T)uiSourceAShift) & uiSourceAMask;	// isolate A channel
+	for(vlUInt i = 0; i < 4; i++)
+	{
+		Bin.uiSums[0] += uiCounts[i] * uiPalette[i][0];
+		Bin.uiSums[1] += uiCounts[i] * uiPalette[i][1];
+		Bin.uiSums[2] += uiCounts[i] * uiPalette[i][2];
+		Bin.uiCount += uiCounts[i];
 
-		if(SourceInfo.pFromTransform || DestInfo.pToTransform)
+		if(bDXT1)
 		{
-			// transform values
-			Transform<vlUInt16, vlUInt16>(SourceInfo.pFromTransform, DestInfo.pToTransform, SR, SG, SB, SA, SourceInfo.uiRBitsPerPixel, SourceInfo.uiGBitsPerPixel, SourceInfo.uiBBitsPerPixel, SourceInfo.uiABitsPerPixel, DR, DG, DB, DA, DestInfo.uiRBitsPerPixel, DestInfo.uiGBitsPerPixel, DestInfo.uiBBitsPerPixel, DestInfo.uiABitsPerPixel);
+			Bin.uiSums[3] += uiCounts[i] * uiPalette[i][3];
 		}
-		else
+	}
+
+	if(Format == IMAGE_FORMAT_DXT3)
+	{
+		// Explicit 4 bit alpha.
+		for(vlUInt k = 0; k < 16; k++)
 		{
-			// default value transform
-			if(uiSourceRMask && uiDestRMask)
+			if(uiMask & (1 << k))
 			{
-				if(DestInfo.uiRBitsPerPixel < SourceInfo.uiRBitsPerPixel)	// downsample
-					DR = Shrink<vlUInt16>(SR, SourceInfo.uiRBitsPerPixel, DestInfo.uiRBitsPerPixel);
-				else if(DestInfo.uiRBitsPerPixel > SourceInfo.uiRBitsPerPixel)	// upsample
-					DR = Expand<vlUInt16>(SR, SourceInfo.uiRBitsPerPixel, DestInfo.uiRBitsPerPixel);
-				else
-					DR = SR;
+				vlUInt uiAlpha = (lpBlock[k / 2] >> ((k & 1) * 4)) & 0x0F;
+				Bin.uiSums[3] += uiAlpha | (uiAlpha << 4);
 			}
-
-			if(uiSourceGMask && uiDestGMask)
+		}
+	}
+	else if(Format == IMAGE_FORMAT_DXT5)
+	{
+		// Interpolated alpha with 3 bit indices.
+		vlUInt uiAlphas[8];
+		uiAlphas[0] = lpBlock[0];
+		uiAlphas[1] = lpBlock[1];
+		if(uiAlphas[0] > uiAlphas[1])
+		{
+			for(vlUInt i = 2; i < 8; i++)
 			{
-				if(DestInfo.uiGBitsPerPixel < SourceInfo.uiGBitsPerPixel)	// downsample
-					DG = Shrink<vlUInt16>(SG, SourceInfo.uiGBitsPerPixel, DestInfo.uiGBitsPerPixel);
-				else if(DestInfo.uiGBitsPerPixel > SourceInfo.uiGBitsPerPixel)	// upsample
-					DG = Expand<vlUInt16>(SG, SourceInfo.uiGBitsPerPixel, DestInfo.uiGBitsPerPixel);
-				else
-					DG = SG;
+				uiAlphas[i] = ((8 - i) * uiAlphas[0] + (i - 1) * uiAlphas[1] + 3) / 7;
 			}
-
-			if(uiSourceBMask && uiDestBMask)
+		}
+		else
+		{
+			for(vlUInt i = 2; i < 6; i++)
 			{
-				if(DestInfo.uiBBitsPerPixel < SourceInfo.uiBBitsPerPixel)	// downsample
-					DB = Shrink<vlUInt16>(SB, SourceInfo.uiBBitsPerPixel, DestInfo.uiBBitsPerPixel);
-				else if(DestInfo.uiBBitsPerPixel > SourceInfo.uiBBitsPerPixel)	// upsample
-					DB = Expand<vlUInt16>(SB, SourceInfo.uiBBitsPerPixel, DestInfo.uiBBitsPerPixel);
-				else
-					DB = SB;
+				uiAlphas[i] = ((6 - i) * uiAlphas[0] + (i - 1) * uiAlphas[1] + 2) / 5;
 			}
+			uiAlphas[6] = 0x00;
+			uiAlphas[7] = 0xFF;
+		}
 
-			if(uiSourceAMask && uiDestAMask)
+		vlUInt64 uiAlphaIndices = 0;
+		for(vlUInt i = 0; i < 6; i++)
+		{
+			uiAlphaIndices |= (vlUInt64)lpBlock[2 + i] << (i * 8);
+		}
+
+		for(vlUInt k = 0; k < 16; k++)
+		{
+			if(uiMask & (1 << k))
 			{
-				if(DestInfo.uiABitsPerPixel < SourceInfo.uiABitsPerPixel)	// downsample
-					DA = Shrink<vlUInt16>(SA, SourceInfo.uiABitsPerPixel, DestInfo.uiABitsPerPixel);
-				else if(DestInfo.uiABitsPerPixel > SourceInfo.uiABitsPerPixel)	// upsample
-					DA = Expand<vlUInt16>(SA, SourceInfo.uiABitsPerPixel, DestInfo.uiABitsPerPixel);
-				else
-					DA = SA;
+				Bin.uiSums[3] += uiAlphas[(uiAlphaIndices >> (k * 3)) & 0x07];
 			}
 		}
+	}
+}
 
-		// write source to single variable
-		U Dest = ((U)(DR & uiDestRMask) << (U)uiDestRShift) | ((U)(DG & uiDestGMask) << (U)uiDestGShift) | ((U)(DB & uiDestBMask) << (U)uiDestBShift) | ((U)(DA & uiDestAMask) << (U)uiDestAShift);
-		for(i = 0; i < DestInfo.uiBytesPerPixel; i++)
+//
+// ComputePreviewBins()
+// Works out which preview texels each uiCellSize wide cell overlaps along one axis.
+// When shrinking this is usually one texel, when enlarging it is several.
+//
+static vlVoid ComputePreviewBins(vlUInt uiSize, vlUInt uiCellSize, vlUInt uiDestSize, std::vector<vlUInt> &First, std::vector<vlUInt> &Last)
+{
+	vlUInt uiCells = (uiSize + uiCellSize - 1) / uiCellSize;
+
+	First.resize(uiCells);
+	Last.resize(uiCells);
+
+	for(vlUInt i = 0; i < uiCells; i++)
+	{
+		vlUInt64 uiStart = (vlUInt64)i * uiCellSize;
+		vlUInt64 uiEnd = uiStart + uiCellSize < uiSize ? uiStart + uiCellSize : uiSize;
+
+		First[i] = (vlUInt)(uiStart * uiDestSize / uiSize);
+		Last[i] = (vlUInt)((uiEnd * uiDestSize + uiSize - 1) / uiSize) - 1;
+		if(Last[i] < First[i])
 		{
-			lpDest[i] = (vlByte)((Dest >> ((T)i * 8)) & 0xff);
+			Last[i] = First[i];
 		}
 	}
-
-	return vlTrue;
 }
 
-vlBool CVTFFile::Convert(vlByte *lpSource, vlByte *lpDest, vlUInt uiWidth, vlUInt uiHeight, VTFImageFormat SourceFormat, VTFImageFormat DestFormat)
+vlBool CVTFFile::ComputeImagePreview(vlByte *lpSource, vlUInt uiWidth, vlUInt uiHeight, VTFImageFormat SourceFormat, vlByte *lpDestRGBA8888, vlUInt uiDestWidth, vlUInt uiDestHeight)
 {
-	assert(lpSource != 0);
-	assert(lpDest != 0);
-
-	assert(SourceFormat >= 0 && SourceFormat < IMAGE_FORMAT_COUNT);
-	assert(DestFormat >= 0 && DestFormat < IMAGE_FORMAT_COUNT);
+	SVTFLibOptions Options;
+	VTFLib::GetOptions(Options);
 
-	const SVTFImageConvertInfo& SourceInfo = VTFImageConvertInfo[SourceFormat];
-	const SVTFImageConvertInfo& DestInfo = VTFImageConvertInfo[DestFormat];
+	return CVTFFile::ComputeImagePreview(lpSource, uiWidth, uiHeight, SourceFormat, lpDestRGBA8888, uiDestWidth, uiDestHeight, Options);
+}
 
-	if(!SourceInfo.bIsSupported || !DestInfo.bIsSupported)
+//
+// ComputeImagePreview()
+// Box filters an image down to a preview.  DXTn images are reduced a block at a time
+// straight from the compressed data when there are at least as many blocks as preview
+// texels.  Anything else is decoded a strip of rows at a time, so there is never a
+// full size RGBA8888 copy of the image.
+//
+vlBool CVTFFile::ComputeImagePreview(vlByte *lpSource, vlUInt uiWidth, vlUInt uiHeight, VTFImageFormat SourceFormat, vlByte *lpDestRGBA8888, vlUInt uiDestWidth, vlUInt uiDestHeight, const SVTFLibOptions &Options)
+{
+	if(lpSource == 0 || uiWidth == 0 || uiHeight == 0)
 	{
-		LastError.Set("Image format conversion not supported.");
+		LastError.Set("No image data to generate preview from.");
 
 		return vlFalse;
 	}
 
-	// Optimize common convertions.
-	if(SourceFormat == DestFormat)
+	if(lpDestRGBA8888 == 0 || uiDestWidth == 0 || uiDestHeight == 0)
 	{
-		memcpy( lpDest, lpSource, CVTFFile::ComputeImageSize(uiWidth, uiHeight, 1, DestFormat));
-		return vlTrue;
+		LastError.Set("Invalid preview size.");
+
+		return vlFalse;
 	}
 
-	if(SourceFormat == IMAGE_FORMAT_RGB888 && DestFormat == IMAGE_FORMAT_RGBA8888)
+	if(SourceFormat < 0 || SourceFormat >= IMAGE_FORMAT_COUNT || !VTFImageConvertInfo[SourceFormat].bIsSupported)
 	{
-		vlByte *lpLast = lpSource + CVTFFile::ComputeImageSize(uiWidth, uiHeight, 1, SourceFormat);
-		for(; lpSource < lpLast; lpSource += 3, lpDest += 4)
-		{
-			lpDest[0] = lpSource[0];
-			lpDest[1] = lpSource[1];
-			lpDest[2] = lpSource[2];
-			lpDest[3] = 255;
-		}
-		return vlTrue;
+		LastError.Set("Image format conversion not supported.");
+
+		return vlFalse;
 	}
 
-	if(SourceFormat == IMAGE_FORMAT_RGBA8888 && DestFormat == IMAGE_FORMAT_RGB888)
+	vlBool bBlocks = vlFalse;
+	switch(SourceFormat)
 	{
-		vlByte *lpLast = lpSource + CVTFFile::ComputeImageSize(uiWidth, uiHeight, 1, SourceFormat);
-		for(; lpSource < lpLast; lpSource += 4, lpDest += 3)
-		{
-			lpDest[0] = lpSource[0];
-			lpDest[1] = lpSource[1];
-			lpDest[2] = lpSource[2];
-		}
-		return vlTrue;
+	case IMAGE_FORMAT_DXT1:
+	case IMAGE_FORMAT_DXT1_ONEBITALPHA:
+	case IMAGE_FORMAT_DXT3:
+	case IMAGE_FORMAT_DXT5:
+		bBlocks = (uiWidth + 3) / 4 >= uiDestWidth && (uiHeight + 3) / 4 >= uiDestHeight;
+		break;
+	default:
+		break;
 	}
 
-	// Do general convertions.
-	if(SourceInfo.bIsCompressed || DestInfo.bIsCompressed)
+	// A cell is a block or a texel.
+	vlUInt uiCellSize = bBlocks ? 4 : 1;
+
+	std::vector<vlUInt> FirstX, LastX, FirstY, LastY;
+	ComputePreviewBins(uiWidth, uiCellSize, uiDestWidth, FirstX, LastX);
+	ComputePreviewBins(uiHeight, uiCellSize, uiDestHeight, FirstY, LastY);
+
+	vlSingle sHDRLogAverageLuminance = SourceFormat == IMAGE_FORMAT_RGBA16161616F ? ComputeHDRLogAverageLuminance(lpSource, uiWidth, uiHeight, VTFImageConvertInfo[SourceFormat].uiBytesPerPixel) : 0.0f;
+
+	SPreviewBin Empty = { { 0, 0, 0, 0 }, 0 };
+	std::vector<SPreviewBin> Total((size_t)uiDestWidth * uiDestHeight, Empty);
+
+	vlBool bError = vlFalse;
+	std::mutex Mutex;
+
+	// Work in strips of 4 rows, one row of blocks.
+	vlUInt uiStrips = (uiHeight + 3) / 4;
+
+	ForEachRow(uiStrips, [&](vlUInt uiStart, vlUInt uiEnd)
 	{
-		vlByte *lpSourceRGBA = lpSource;
-		vlBool bResult = vlTrue;
+		std::vector<SPreviewBin> Bins((size_t)uiDestWidth * uiDestHeight, Empty);
 
-		// allocate temp data for intermittent conversions
-		if(SourceFormat != IMAGE_FORMAT_RGBA8888)
+		std::vector<vlByte> Strip;
+		if(!bBlocks && SourceFormat != IMAGE_FORMAT_RGBA8888)
 		{
-			lpSourceRGBA = new vlByte[CVTFFile::ComputeImageSize(uiWidth, uiHeight, 1, IMAGE_FORMAT_RGBA8888)];
+			Strip.resize((size_t)uiWidth * 4 * 4);
 		}
 
-		// decompress the source or convert it to RGBA for compressing
-		switch(SourceFormat)
+		vlBool bResult = vlTrue;
+		for(vlUInt uiStrip = uiStart; uiStrip < uiEnd && bResult; uiStrip++)
 		{
-		case IMAGE_FORMAT_RGBA8888:
-			break;
-		case IMAGE_FORMAT_DXT1:
-		case IMAGE_FORMAT_DXT1_ONEBITALPHA:
-			bResult = CVTFFile::DecompressDXT1(lpSource, lpSourceRGBA, uiWidth, uiHeight);
-			break;
-		case IMAGE_FORMAT_DXT3:
-			bResult = CVTFFile::DecompressDXT3(lpSource, lpSourceRGBA, uiWidth, uiHeight);
-			break;
-		case IMAGE_FORMAT_DXT5:
-			bResult = CVTFFile::DecompressDXT5(lpSource, lpSourceRGBA, uiWidth, uiHeight);
-			break;
-		default:
-			bResult = CVTFFile::Convert(lpSource, lpSourceRGBA, uiWidth, uiHeight, SourceFormat, IMAGE_FORMAT_RGBA8888);
-			break;
-		}
+			vlUInt uiY = uiStrip * 4;
+			vlUInt uiRows = uiHeight - uiY < 4 ? uiHeight - uiY : 4;
 
-		if(bResult)
-		{
-			// compress the source or convert it to the dest format if it is not compressed
-			switch(DestFormat)
+			vlByte *lpStrip = lpSource + CVTFFile::ComputeImageSize(uiWidth, uiY, 1, SourceFormat);
+
+			if(bBlocks)
 			{
-			case IMAGE_FORMAT_DXT1:
-			case IMAGE_FORMAT_DXT1_ONEBITALPHA:
-			case IMAGE_FORMAT_DXT3:
-			case IMAGE_FORMAT_DXT5:
-				bResult = CVTFFile::CompressDXTn(lpSourceRGBA, lpDest, uiWidth, uiHeight, DestFormat);
-				break;
-			default:
-				bResult = CVTFFile::Convert(lpSourceRGBA, lpDest, uiWidth, uiHeight, IMAGE_FORMAT_RGBA8888, DestFormat);
-				break;
+				vlUInt uiBlockSize = SourceFormat == IMAGE_FORMAT_DXT1 || SourceFormat == IMAGE_FORMAT_DXT1_ONEBITALPHA ? 8 : 16;
+				vlUInt uiRowMask = uiRows == 4 ? 0xFFFF : (1 << (uiRows * 4)) - 1;
+
+				for(vlUInt uiBlock = 0; uiBlock < (uiWidth + 3) / 4; uiBlock++, lpStrip += uiBlockSize)
+				{
+					vlUInt uiColumns = uiWidth - uiBlock * 4 < 4 ? uiWidth - uiBlock * 4 : 4;
+					vlUInt uiMask = uiRowMask & (0x1111 * ((1 << uiColumns) - 1));
+
+					SPreviewBin Block = Empty;
+					SumDXTnBlock(lpStrip, SourceFormat, uiMask, Block);
+
+					for(vlUInt y = FirstY[uiStrip]; y <= LastY[uiStrip]; y++)
+					{
+						for(vlUInt x = FirstX[uiBlock]; x <= LastX[uiBlock]; x++)
+						{
+							SPreviewBin &Bin = Bins[(size_t)y * uiDestWidth + x];
+							Bin.uiSums[0] += Block.uiSums[0];
+							Bin.uiSums[1] += Block.uiSums[1];
+							Bin.uiSums[2] += Block.uiSums[2];
+							Bin.uiSums[3] += Block.uiSums[3];
+							Bin.uiCount += Block.uiCount;
+						}
+					}
+				}
+			}
+			else
+			{
+				if(SourceFormat != IMAGE_FORMAT_RGBA8888)
+				{
+					bResult = CVTFFile::DecodeRows(lpStrip, &Strip[0], uiWidth, uiRows, SourceFormat, sHDRLogAverageLuminance, Options);
+					lpStrip = &Strip[0];
+				}
+
+				for(vlUInt j = 0; j < uiRows; j++)
+				{
+					const vlByte *lpPixel = lpStrip + (size_t)j * uiWidth * 4;
+					for(vlUInt i = 0; i < uiWidth; i++, lpPixel += 4)
+					{
+						for(vlUInt y = FirstY[uiY + j]; y <= LastY[uiY + j]; y++)
+						{
+							for(vlUInt x = FirstX[i]; x <= LastX[i]; x++)
+							{
+								SPreviewBin &Bin = Bins[(size_t)y * uiDestWidth + x];
+								Bin.uiSums[0] += lpPixel[0];
+								Bin.uiSums[1] += lpPixel[1];
+								Bin.uiSums[2] += lpPixel[2];
+								Bin.uiSums[3] += lpPixel[3];
+								Bin.uiCount++;
+							}
+						}
+					}
+				}
 			}
 		}
 
-		// free temp data
-		if(lpSourceRGBA != lpSource)
+		std::lock_guard<std::mutex> Lock(Mutex);
+
+		for(size_t i = 0; i < Total.size(); i++)
 		{
-			delete []lpSourceRGBA;
+			Total[i].uiSums[0] += Bins[i].uiSums[0];
+			Total[i].uiSums[1] += Bins[i].uiSums[1];
+			Total[i].uiSums[2] += Bins[i].uiSums[2];
+			Total[i].uiSums[3] += Bins[i].uiSums[3];
+			Total[i].uiCount += Bins[i].uiCount;
 		}
 
-		return bResult;
-	}
-	else
-	{
-		// convert from one variable order and bit format to another
-		if(SourceInfo.uiBytesPerPixel <= 1)
-		{
-			if(DestInfo.uiBytesPerPixel <= 1)
-				return ConvertTemplated<vlUInt8, vlUInt8>(lpSource, lpDest, uiWidth, uiHeight, SourceInfo, DestInfo);
-			else if(DestInfo.uiBytesPerPixel <= 2)
-				return ConvertTemplated<vlUInt8, vlUInt16>(lpSource, lpDest, uiWidth, uiHeight, SourceInfo, DestInfo);
-			else if(DestInfo.uiBytesPerPixel <= 4)
-				return ConvertTemplated<vlUInt8, vlUInt32>(lpSource, lpDest, uiWidth, uiHeight, SourceInfo, DestInfo);
-			else if(DestInfo.uiBytesPerPixel <= 8)
-				return ConvertTemplated<vlUInt8, vlUInt64>(lpSource, lpDest, uiWidth, uiHeight, SourceInfo, DestInfo);
-		}
-		else if(SourceInfo.uiBytesPerPixel <= 2)
-		{
-			if(DestInfo.uiBytesPerPixel <= 1)
-				return ConvertTemplated<vlUInt16, vlUInt8>(lpSource, lpDest, uiWidth, uiHeight, SourceInfo, DestInfo);
-			else if(DestInfo.uiBytesPerPixel <= 2)
-				return ConvertTemplated<vlUInt16, vlUInt16>(lpSource, lpDest, uiWidth, uiHeight, SourceInfo, DestInfo);
-			else if(DestInfo.uiBytesPerPixel <= 4)
-				return ConvertTemplated<vlUInt16, vlUInt32>(lpSource, lpDest, uiWidth, uiHeight, SourceInfo, DestInfo);
-			else if(DestInfo.uiBytesPerPixel <= 8)
-				return ConvertTemplated<vlUInt16, vlUInt64>(lpSource, lpDest, uiWidth, uiHeight, SourceInfo, DestInfo);
-		}
-		else if(SourceInfo.uiBytesPerPixel <= 4)
-		{
-			if(DestInfo.uiBytesPerPixel <= 1)
-				return ConvertTemplated<vlUInt32, vlUInt8>(lpSource, lpDest, uiWidth, uiHeight, SourceInfo, DestInfo);
-			else if(DestInfo.uiBytesPerPixel <= 2)
-				return ConvertTemplated<vlUInt32, vlUInt16>(lpSource, lpDest, uiWidth, uiHeight, SourceInfo, DestInfo);
-			else if(DestInfo.uiBytesPerPixel <= 4)
-				return ConvertTemplated<vlUInt32, vlUInt32>(lpSource, lpDest, uiWidth, uiHeight, SourceInfo, DestInfo);
-			else if(DestInfo.uiBytesPerPixel <= 8)
-				return ConvertTemplated<vlUInt32, vlUInt64>(lpSource, lpDest, uiWidth, uiHeight, SourceInfo, DestInfo);
-		}
-		else if(SourceInfo.uiBytesPerPixel <= 8)
-		{
-			if(DestInfo.uiBytesPerPixel <= 1)
-				return ConvertTemplated<vlUInt64, vlUInt8>(lpSource, lpDest, uiWidth, uiHeight, SourceInfo, DestInfo);
-			else if(DestInfo.uiBytesPerPixel <= 2)
-				return ConvertTemplated<vlUInt64, vlUInt16>(lpSource, lpDest, uiWidth, uiHeight, SourceInfo, DestInfo);
-			else if(DestInfo.uiBytesPerPixel <= 4)
-				return ConvertTemplated<vlUInt64, vlUInt32>(lpSource, lpDest, uiWidth, uiHeight, SourceInfo, DestInfo);
-			else if(DestInfo.uiBytesPerPixel <= 8)
-				return ConvertTemplated<vlUInt64, vlUInt64>(lpSource, lpDest, uiWidth, uiHeight, SourceInfo, DestInfo);
+		if(!bResult)
+		{
+			bError = vlTrue;
 		}
-		return vlFalse;
-	}
+	});
 
-	return vlFalse;
-}
-
-//
-// ConvertToNormalMap()
-// Convert source data (in format RGBA8888) to a normal map.  If dest data is null then the
-// result is copied back into the source data.
-//
-vlBool CVTFFile::ConvertToNormalMap(vlByte *lpSourceRGBA8888, vlByte *lpDestRGBA8888, vlUInt uiWidth, vlUInt uiHeight, VTFKernelFilter KernelFilter, VTFHeightConversionMethod HeightConversionMethod, VTFNormalAlphaResult NormalAlphaResult, vlByte bMinimumZ, vlSingle sScale, vlBool bWrap, vlBool bInvertX, vlBool bInvertY, vlBool bInvertZ)
-{
-	assert(KernelFilter >= 0 && KernelFilter < KERNEL_FILTER_COUNT);
-	assert(HeightConversionMethod >= 0 && HeightConversionMethod < HEIGHT_CONVERSION_METHOD_COUNT);
-	assert(NormalAlphaResult >= 0 && NormalAlphaResult < NORMAL_ALPHA_RESULT_COUNT);
+	if(bError)
+	{
+		LastError.Set("Error decoding image data.");
 
-#ifdef USE_NVDXT
-	nvCompressionOptions Options = nvCompressionOptions();
+		return vlFalse;
+	}
 
-	SNVCompressionUserData UserData = SNVCompressionUserData(lpDestRGBA8888 != 0 ? lpDestRGBA8888 : lpSourceRGBA8888, IMAGE_FORMAT_RGBA8888);
+	for(size_t i = 0; i < Total.size(); i++, lpDestRGBA8888 += 4)
+	{
+		vlUInt64 uiCount = Total[i].uiCount != 0 ? Total[i].uiCount : 1;
 
-	// Don't generate mipmaps.
-	Options.mipMapGeneration = kNoMipMaps;
+		lpDestRGBA8888[0] = (vlByte)((Total[i].uiSums[0] + uiCount / 2) / uiCount);
+		lpDestRGBA8888[1] = (vlByte)((Total[i].uiSums[1] + uiCount / 2) / uiCount);
+		lpDestRGBA8888[2] = (vlByte)((Total[i].uiSums[2] + uiCount / 2) / uiCount);
+		lpDestRGBA8888[3] = (vlByte)((Total[i].uiSums[3] + uiCount / 2) / uiCount);
+	}
 
-	// Set normal map options.
-	Options.normalMap.bEnableNormalMapConversion = true;
-	Options.normalMap.filterKernel = (nvNormalMapFilters)(KERNEL_FILTER_BASE + (vlInt)KernelFilter);
-	Options.normalMap.heightConversionMethod = (nvHeightConversionMethods)(HEIGHT_CONVERSION_METHOD_BASE + (vlInt)HeightConversionMethod);
-	Options.normalMap.alphaResult = (nvAlphaResult)(NORMAL_ALPHA_RESULT_BASE + (vlInt)NormalAlphaResult);
-	Options.normalMap.minz = bMinimumZ;
-	Options.normalMap.scale = sScale;
-	Options.normalMap.bWrap = bWrap;
-	Options.normalMap.bInvertX = bInvertX;
-	Options.normalMap.bInvertY = bInvertY;
-	Options.normalMap.bInvertZ = bInvertZ;
-//	Options.normalMap.bSignedOutput = KernelFilter == KERNEL_FILTER_DUDV;	// Normal maps seem to be signed in Source, DuDv maps don't.
-	Options.normalMap.bNormalMapSwapRGB = true;	// Our input is RGB but the output is still BGR unless we set this.
+	return vlTrue;
+}
 
-	// Set the format.
-	Options.textureFormat = k8888;
-	Options.bSwapRB = true;
+// Where each pixel of a transformed image comes from.  The source pixel of
+// destination pixel (x, y) is (X + XX * x + XY * y, Y + YX * x + YY * y), where X
+// is 0 or the source width - 1 and Y is 0 or the source height - 1.
+// -------------------------------------------------------------------------------
+struct STransformMap
+{
+	vlBool bRight;
+	vlInt iXX, iXY;
+	vlBool bBottom;
+	vlInt iYX, iYY;
+	vlBool bSwapAxes;
+};
 
-	// The UserData struct gets passed to our callback.
-	Options.user_data = &UserData;
+static const STransformMap TransformMaps[IMAGE_TRANSFORM_COUNT] =
+{
+	{ vlFalse,  1,  0, vlFalse,  0,  1, vlFalse },	// IMAGE_TRANSFORM_NONE
+	{ vlFalse,  0,  1, vlTrue,  -1,  0, vlTrue },	// IMAGE_TRANSFORM_ROTATE_90
+	{ vlTrue,  -1,  0, vlTrue,   0, -1, vlFalse },	// IMAGE_TRANSFORM_ROTATE_180
+	{ vlTrue,   0, -1, vlFalse,  1,  0, vlTrue },	// IMAGE_TRANSFORM_ROTATE_270
+	{ vlFalse,  1,  0, vlTrue,   0, -1, vlFalse },	// IMAGE_TRANSFORM_FLIP
+	{ vlTrue,  -1,  0, vlFalse,  0,  1, vlFalse },	// IMAGE_TRANSFORM_MIRROR
+	{ vlFalse,  0,  1, vlFalse,  1,  0, vlTrue },	// IMAGE_TRANSFORM_TRANSPOSE
+	{ vlTrue,   0, -1, vlTrue,  -1,  0, vlTrue }	// IMAGE_TRANSFORM_TRANSVERSE
+};
 
-	return nvDXTCompressWrapper(lpSourceRGBA8888, uiWidth, uiHeight, &Options, NVWriteCallback);
-#else
-	LastError.Set("NVDXT support required for CVTFFile::ConvertToNormalMap().");
-	return vlFalse;
-#endif
+//
+// GetBlockSize()
+// Returns the size of a 4x4 block of a DXTn format that can be transformed
+// without decoding it, or 0 for anything else.
+//
+static vlUInt GetBlockSize(VTFImageFormat ImageFormat)
+{
+	switch(ImageFormat)
+	{
+	case IMAGE_FORMAT_DXT1:
+	case IMAGE_FORMAT_DXT1_ONEBITALPHA:
+		return 8;
+	case IMAGE_FORMAT_DXT3:
+	case IMAGE_FORMAT_DXT5:
+		return 16;
+	default:
+		return 0;
+	}
 }
 
-vlBool CVTFFile::Resize(vlByte *lpSourceRGBA8888, vlByte *lpDestRGBA8888, vlUInt uiSourceWidth, vlUInt uiSourceHeight, vlUInt uiDestWidth, vlUInt uiDestHeight, VTFMipmapFilter ResizeFilter, VTFSharpenFilter SharpenFilter)
+//
+// GetBlockTransform()
+// Gets the pixel of a 4x4 block each pixel of the transformed block comes from.
+//
+static vlVoid GetBlockTransform(VTFImageTransform Transform, vlByte *lpSource)
 {
-	assert(ResizeFilter >= 0 && ResizeFilter < MIPMAP_FILTER_COUNT);
-	assert(SharpenFilter >= 0 && SharpenFilter < SHARPEN_FILTER_COUNT);
+	const STransformMap &Map = TransformMaps[Transform];
 
-#ifdef USE_NVDXT
-	nvCompressionOptions Options = nvCompressionOptions();
-
-	SNVCompressionUserData UserData = SNVCompressionUserData(lpDestRGBA8888, IMAGE_FORMAT_RGBA8888);
-
-	// Don't generate mipmaps.
-	Options.mipMapGeneration = kNoMipMaps;
+	for(vlInt y = 0; y < 4; y++)
+	{
+		for(vlInt x = 0; x < 4; x++)
+		{
+			vlInt iX = (Map.bRight ? 3 : 0) + Map.iXX * x + Map.iXY * y;
+			vlInt iY = (Map.bBottom ? 3 : 0) + Map.iYX * x + Map.iYY * y;
 
-	// Set new image size.
-	Options.rescaleImageType = kRescalePreScale;
-	Options.scaleX = (vlSingle)uiDestWidth;
-	Options.scaleY = (vlSingle)uiDestHeight;
+			lpSource[y * 4 + x] = (vlByte)(iY * 4 + iX);
+		}
+	}
+}
 
-	// Set resize filter.
-	Options.rescaleImageFilter = (nvMipFilterTypes)ResizeFilter;
+//
+// TransformIndices()
+// Reorders the 16 packed indices of a block, stored little endian with the top
+// left pixel in the lowest bits, uiBits bits each.
+//
+static vlVoid TransformIndices(vlByte *lpIndices, vlUInt uiBits, const vlByte *lpSource)
+{
+	vlUInt uiBytes = uiBits * 2;
+	vlUInt64 uiMask = ((vlUInt64)1 << uiBits) - 1;
 
-	// Setup sharpen filter.
-	if(SharpenFilter != SHARPEN_FILTER_NONE)
+	vlUInt64 uiIndices = 0;
+	for(vlUInt i = 0; i < uiBytes; i++)
 	{
-		Options.sharpenFilterType = (nvSharpenFilterTypes)SharpenFilter;
-		Options.sharpening_passes_per_mip_level[0] = 1;
-		Options.unsharp_data.radius32F = sUnsharpenRadius;
-		Options.unsharp_data.amount32F = sUnsharpenAmount;
-		Options.unsharp_data.threshold32F = sUnsharpenThreshold;
-		Options.xsharp_data.strength32F = sXSharpenStrength;
-		Options.xsharp_data.threshold32F = sXSharpenThreshold;
+		uiIndices |= (vlUInt64)lpIndices[i] << (i * 8);
 	}
 
-	// Set the format.
-	Options.textureFormat = k8888;
-	Options.bSwapRB = true;
-
-	// The UserData struct gets passed to our callback.
-	Options.user_data = &UserData;
+	vlUInt64 uiResult = 0;
+	for(vlUInt i = 0; i < 16; i++)
+	{
+		uiResult |= ((uiIndices >> (lpSource[i] * uiBits)) & uiMask) << (i * uiBits);
+	}
 
-	return nvDXTCompressWrapper(lpSourceRGBA8888, uiSourceWidth, uiSourceHeight, &Options, NVWriteCallback);
-#else
-	LastError.Set("NVDXT support required for CVTFFile::Resize().");
-	return vlFalse;
-#endif
+	for(vlUInt i = 0; i < uiBytes; i++)
+	{
+		lpIndices[i] = (vlByte)(uiResult >> (i * 8));
+	}
 }
 
 //
-// CorrectImageGamma()
-// Do gamma correction on the image data.
+// TransformBlock()
+// Transforms the pixels of a DXTn block in place.  Only the indices move, the
+// end points stay as they are, so the block decodes to exactly the transformed
+// pixels of the original.
 //
-vlVoid CVTFFile::CorrectImageGamma(vlByte *lpImageDataRGBA8888, vlUInt uiWidth, vlUInt uiHeight, vlSingle sGammaCorrection)
+static vlVoid TransformBlock(vlByte *lpBlock, VTFImageFormat ImageFormat, const vlByte *lpSource)
 {
-	if(sGammaCorrection == 1.0f)
+	switch(ImageFormat)
 	{
-		return;
+	case IMAGE_FORMAT_DXT3:
+		// 4 bit explicit alpha for each pixel, then a DXT1 block.
+		TransformIndices(lpBlock, 4, lpSource);
+		lpBlock += 8;
+		break;
+	case IMAGE_FORMAT_DXT5:
+		// Two alpha end points and 3 bit alpha indices, then a DXT1 block.
+		TransformIndices(lpBlock + 2, 3, lpSource);
+		lpBlock += 8;
+		break;
+	default:
+		break;
 	}
 
-	vlByte bTable[256];
-
-	sGammaCorrection = 1.0f / sGammaCorrection;
+	// Two colour end points and 2 bit colour indices.
+	TransformIndices(lpBlock + 4, 2, lpSource);
+}
 
-	// Precalculate all possible gamma correction values.
-	for(vlUInt i = 0; i < 256; i++)
+//
+// TransformImage()
+// Copies image data to a buffer of the transformed size, rotating and flipping it.
+//
+vlBool CVTFFile::TransformImage(vlByte *lpSource, vlByte *lpDest, vlUInt uiWidth, vlUInt uiHeight, VTFImageFormat ImageFormat, VTFImageTransform Transform)
+{
+	if(Transform < 0 || Transform >= IMAGE_TRANSFORM_COUNT)
 	{
-		bTable[i] = (vlByte)(pow((vlSingle)i / 255.0f, sGammaCorrection) * 255.0f);
+		LastError.Set("Invalid image transform.");
+		return vlFalse;
 	}
 
-	vlByte *lpImageDataRGBA8888End = lpImageDataRGBA8888 + uiWidth * uiHeight * 4;
+	vlBool bSwapAxes = TransformMaps[Transform].bSwapAxes;
 
-	// Do gamma correction on RGB channels.
-	for(; lpImageDataRGBA8888 < lpImageDataRGBA8888End; lpImageDataRGBA8888 += 4)
-	{
-		lpImageDataRGBA8888[0] = bTable[lpImageDataRGBA8888[0]];
-		lpImageDataRGBA8888[1] = bTable[lpImageDataRGBA8888[1]];
-		lpImageDataRGBA8888[2] = bTable[lpImageDataRGBA8888[2]];
-	}
+	return CVTFFile::TransformImage(CImageView(lpSource, uiWidth, uiHeight, ImageFormat), CImageView(lpDest, bSwapAxes ? uiHeight : uiWidth, bSwapAxes ? uiWidth : uiHeight, ImageFormat), Transform);
 }
 
 //
-// ComputeImageReflectivity()
-// Compute the image data reflectivity value.
+// TransformImage()
+// Copies an image view to another, rotating and flipping it.  Uncompressed pixels
+// are copied as they are.  DXTn blocks are moved to their new place and their
+// indices reordered, which is lossless and needs no decoding or encoding.
 //
-vlVoid CVTFFile::ComputeImageReflectivity(vlByte *lpImageDataRGBA8888, vlUInt uiWidth, vlUInt uiHeight, vlSingle &sX, vlSingle &sY, vlSingle &sZ)
+vlBool CVTFFile::TransformImage(const CImageView &Source, const CImageView &Dest, VTFImageTransform Transform)
 {
-	sX = sY = sZ = 0.0f;
+	if(Transform < 0 || Transform >= IMAGE_TRANSFORM_COUNT)
+	{
+		LastError.Set("Invalid image transform.");
+		return vlFalse;
+	}
 
-	vlSingle sTable[256];
+	const STransformMap &Map = TransformMaps[Transform];
 
-	//
-	// Precalculate all possible reflectivity values.
-	//
+	if(Source.GetFormat() != Dest.GetFormat())
+	{
+		LastError.Set("Source and destination image formats must match.");
+		return vlFalse;
+	}
 
-	for(vlUInt i = 0; i < 256; i++)
+	if(Dest.GetWidth() != (Map.bSwapAxes ? Source.GetHeight() : Source.GetWidth()) || Dest.GetHeight() != (Map.bSwapAxes ? Source.GetWidth() : Source.GetHeight()))
 	{
-		sTable[i] = pow((vlSingle)i / 255.0f, 2.2f);
+		LastError.Set("Destination image size does not match the transformed source.");
+		return vlFalse;
 	}
 
-	//
-	// Compute reflectivity on RGB channels.
-	//
+	if(Source.IsEmpty() || Dest.IsEmpty())
+	{
+		return vlTrue;
+	}
+
+	if(Source.GetData() == Dest.GetData())
+	{
+		LastError.Set("Source and destination images must be different buffers.");
+		return vlFalse;
+	}
 
-	// This is the method Valve uses.
+	VTFImageFormat ImageFormat = Source.GetFormat();
 
-	/*vlByte *lpImageDataRGBA8888End = lpImageDataRGBA8888 + uiWidth * uiHeight * 4;
+	// Work in pixels, or in 4x4 blocks for DXTn.
+	vlUInt uiElementSize, uiWidth, uiHeight, uiDestWidth, uiDestHeight;
+	vlByte lpBlockSource[16];
 
-	for(; lpImageDataRGBA8888 < lpImageDataRGBA8888End; lpImageDataRGBA8888 += 4)
+	vlBool bCompressed = CVTFFile::GetImageFormatInfo(ImageFormat).bIsCompressed;
+	if(bCompressed)
 	{
-		sX += sTable[lpImageDataRGBA8888[0]];
-		sY += sTable[lpImageDataRGBA8888[1]];
-		sZ += sTable[lpImageDataRGBA8888[2]];
-	}
+		uiElementSize = GetBlockSize(ImageFormat);
+		if(uiElementSize == 0)
+		{
+			LastError.Set("Transforming this compressed format not supported.");
+			return vlFalse;
+		}
+
+		if(Source.GetWidth() % 4 != 0 || Source.GetHeight() % 4 != 0)
+		{
+			LastError.Set("DXTn image size must be a multiple of 4 to transform.");
+			return vlFalse;
+		}
 
-	vlSingle sInverse = 1.0f / (vlSingle)(uiWidth * uiHeight);
+		uiWidth = Source.GetWidth() / 4;
+		uiHeight = Source.GetHeight() / 4;
 
-	sX *= sInverse;
-	sY *= sInverse;
-	sZ *= sInverse;*/
+		GetBlockTransform(Transform, lpBlockSource);
+	}
+	else
+	{
+		uiElementSize = CVTFFile::GetImageFormatInfo(ImageFormat).uiBytesPerPixel;
+		uiWidth = Source.GetWidth();
+		uiHeight = Source.GetHeight();
+	}
 
-	// This method is better on floating point limitations for large images then the above.
+	uiDestWidth = Map.bSwapAxes ? uiHeight : uiWidth;
+	uiDestHeight = Map.bSwapAxes ? uiWidth : uiHeight;
 
-	vlSingle sTempX, sTempY, sTempZ, sInverse;
+	// Walk the destination a row at a time; along a row the source pointer moves
+	// by a fixed step, across or down the source.
+	ptrdiff_t iSourcePitch = (ptrdiff_t)Source.GetPitch();
+	ptrdiff_t iStep = (ptrdiff_t)Map.iXX * (ptrdiff_t)uiElementSize + (ptrdiff_t)Map.iYX * iSourcePitch;
 
-	for(vlUInt j = 0; j < uiHeight; j++)
+	for(vlUInt y = 0; y < uiDestHeight; y++)
 	{
-		sTempX = sTempY = sTempZ = 0.0f;
+		ptrdiff_t iX = (Map.bRight ? (ptrdiff_t)uiWidth - 1 : 0) + (ptrdiff_t)Map.iXY * (ptrdiff_t)y;
+		ptrdiff_t iY = (Map.bBottom ? (ptrdiff_t)uiHeight - 1 : 0) + (ptrdiff_t)Map.iYY * (ptrdiff_t)y;
 
-		for(vlUInt i = 0; i < uiWidth; i++)
-		{
-			vlUInt uiIndex = (i + j * uiWidth) * 4;
+		const vlByte *lpSourceElement = Source.GetData() + iY * iSourcePitch + iX * (ptrdiff_t)uiElementSize;
+		vlByte *lpDestElement = Dest.GetData() + (size_t)y * Dest.GetPitch();
 
-			sTempX += sTable[lpImageDataRGBA8888[uiIndex + 0]];
-			sTempY += sTable[lpImageDataRGBA8888[uiIndex + 1]];
-			sTempZ += sTable[lpImageDataRGBA8888[uiIndex + 2]];
+		if(Map.iXX == 1 && !bCompressed)
+		{
+			memcpy(lpDestElement, lpSourceElement, (size_t)uiDestWidth * uiElementSize);
+			continue;
 		}
 
-		sInverse = 1.0f / (vlSingle)uiWidth;
+		for(vlUInt x = 0; x < uiDestWidth; x++, lpSourceElement += iStep, lpDestElement += uiElementSize)
+		{
+			memcpy(lpDestElement, lpSourceElement, uiElementSize);
 
-		sX += sTempX * sInverse;
-		sY += sTempY * sInverse;
-		sZ += sTempZ * sInverse;
+			if(bCompressed)
+			{
+				TransformBlock(lpDestElement, ImageFormat, lpBlockSource);
+			}
+		}
 	}
 
-	sInverse = 1.0f / (vlSingle)uiHeight;
-
-	sX *= sInverse;
-	sY *= sInverse;
-	sZ *= sInverse;
+	return vlTrue;
 }
 
 //
@@ -4255,20 +6985,71 @@ vlVoid CVTFFile::ComputeImageReflectivity(vlByte *lpImageDataRGBA8888, vlUInt ui
 //
 vlVoid CVTFFile::FlipImage(vlByte *lpImageDataRGBA8888, vlUInt uiWidth, vlUInt uiHeight)
 {
-	vlUInt *lpImageData = (vlUInt *)lpImageDataRGBA8888;
+	CVTFFile::FlipImage(CImageView(lpImageDataRGBA8888, uiWidth, uiHeight, IMAGE_FORMAT_RGBA8888));
+}
 
-	for(vlUInt i = 0; i < uiWidth; i++)
+//
+// FlipImage()
+// Flips an image view over the X axis by swapping whole rows.  DXTn blocks are
+// flipped by reordering their indices.
+//
+vlBool CVTFFile::FlipImage(const CImageView &Image)
+{
+	vlBool bCompressed = CVTFFile::GetImageFormatInfo(Image.GetFormat()).bIsCompressed;
+	if(bCompressed)
 	{
-		for(vlUInt j = 0; j < uiHeight / 2; j++)
+		if(GetBlockSize(Image.GetFormat()) == 0)
 		{
-			vlUInt *pOne = lpImageData + (i + j * uiWidth);
-			vlUInt *pTwo = lpImageData + (i + (uiHeight - j - 1) * uiWidth);
+			LastError.Set("Flipping this compressed format not supported.");
+			return vlFalse;
+		}
+
+		if(Image.GetWidth() % 4 != 0 || Image.GetHeight() % 4 != 0)
+		{
+			LastError.Set("DXTn image size must be a multiple of 4 to flip.");
+			return vlFalse;
+		}
+	}
+
+	if(Image.IsEmpty())
+	{
+		return vlTrue;
+	}
+
+	vlUInt uiRowSize = Image.GetRowSize();
+	Memory::CScratchBuffer Row(uiRowSize);
+	vlByte *lpTemp = Row.Get();
 
-			vlUInt uiTemp = *pOne;
-			*pOne = *pTwo;
-			*pTwo = uiTemp;
+	// DXTn rows are rows of blocks; flip each block, then swap them like pixels.
+	vlUInt uiRows = Image.GetHeight();
+	if(bCompressed)
+	{
+		vlUInt uiBlockSize = GetBlockSize(Image.GetFormat());
+		vlByte lpBlockSource[16];
+		GetBlockTransform(IMAGE_TRANSFORM_FLIP, lpBlockSource);
+
+		uiRows /= 4;
+		for(vlUInt i = 0; i < uiRows; i++)
+		{
+			vlByte *lpRow = Image.GetData() + (size_t)i * Image.GetPitch();
+			for(vlUInt j = 0; j < uiRowSize; j += uiBlockSize)
+			{
+				TransformBlock(lpRow + j, Image.GetFormat(), lpBlockSource);
+			}
 		}
 	}
+
+	for(vlUInt i = 0; i < uiRows / 2; i++)
+	{
+		vlByte *pOne = Image.GetData() + (size_t)i * Image.GetPitch();
+		vlByte *pTwo = Image.GetData() + (size_t)(uiRows - i - 1) * Image.GetPitch();
+
+		memcpy(lpTemp, pOne, uiRowSize);
+		memcpy(pOne, pTwo, uiRowSize);
+		memcpy(pTwo, lpTemp, uiRowSize);
+	}
+
+	return vlTrue;
 }
 
 //
@@ -4277,18 +7058,77 @@ vlVoid CVTFFile::FlipImage(vlByte *lpImageDataRGBA8888, vlUInt uiWidth, vlUInt u
 //
 vlVoid CVTFFile::MirrorImage(vlByte *lpImageDataRGBA8888, vlUInt uiWidth, vlUInt uiHeight)
 {
-	vlUInt *lpImageData = (vlUInt *)lpImageDataRGBA8888;
+	CVTFFile::MirrorImage(CImageView(lpImageDataRGBA8888, uiWidth, uiHeight, IMAGE_FORMAT_RGBA8888));
+}
+
+//
+// MirrorImage()
+// Flips an image view over the Y axis by swapping pixels within each row.  DXTn
+// blocks are swapped and mirrored by reordering their indices.
+//
+vlBool CVTFFile::MirrorImage(const CImageView &Image)
+{
+	vlBool bCompressed = CVTFFile::GetImageFormatInfo(Image.GetFormat()).bIsCompressed;
+	if(bCompressed)
+	{
+		if(GetBlockSize(Image.GetFormat()) == 0)
+		{
+			LastError.Set("Mirroring this compressed format not supported.");
+			return vlFalse;
+		}
+
+		if(Image.GetWidth() % 4 != 0 || Image.GetHeight() % 4 != 0)
+		{
+			LastError.Set("DXTn image size must be a multiple of 4 to mirror.");
+			return vlFalse;
+		}
+	}
+
+	if(Image.IsEmpty())
+	{
+		return vlTrue;
+	}
+
+	// DXTn rows are rows of blocks, each mirrored and swapped like a pixel.
+	vlUInt uiBytesPerPixel = CVTFFile::GetImageFormatInfo(Image.GetFormat()).uiBytesPerPixel;
+	vlUInt uiWidth = Image.GetWidth();
+	vlUInt uiRows = Image.GetHeight();
+	vlByte lpBlockSource[16];
+
+	if(bCompressed)
+	{
+		uiBytesPerPixel = GetBlockSize(Image.GetFormat());
+		uiWidth /= 4;
+		uiRows /= 4;
+		GetBlockTransform(IMAGE_TRANSFORM_MIRROR, lpBlockSource);
+	}
+
+	vlByte lpTemp[16];
+
+	assert(uiBytesPerPixel <= sizeof(lpTemp));
 
-	for(vlUInt i = 0; i < uiWidth / 2; i++)
+	for(vlUInt j = 0; j < uiRows; j++)
 	{
-		for(vlUInt j = 0; j < uiHeight; j++)
+		vlByte *lpRow = Image.GetData() + (size_t)j * Image.GetPitch();
+
+		if(bCompressed)
+		{
+			for(vlUInt i = 0; i < uiWidth; i++)
+			{
+				TransformBlock(lpRow + i * uiBytesPerPixel, Image.GetFormat(), lpBlockSource);
+			}
+		}
+
+		for(vlUInt i = 0; i < uiWidth / 2; i++)
 		{
-			vlUInt *pOne = lpImageData + (i + j * uiWidth);
-			vlUInt *pTwo = lpImageData + ((uiWidth - i - 1) + j * uiWidth);
+			vlByte *pOne = lpRow + i * uiBytesPerPixel;
+			vlByte *pTwo = lpRow + (uiWidth - i - 1) * uiBytesPerPixel;
 
-			vlUInt uiTemp = *pOne;
-			*pOne = *pTwo;
-			*pTwo = uiTemp;
+			memcpy(lpTemp, pOne, uiBytesPerPixel);
+			memcpy(pOne, pTwo, uiBytesPerPixel);
+			memcpy(pTwo, lpTemp, uiBytesPerPixel);
 		}
 	}
+
+	return vlTrue;
 }
@@ -24,6 +24,9 @@
 #include "Readers.h"
 #include "Writers.h"
 #include "VTFFormat.h"
+#include "Options.h"
+#include "Allocator.h"
+#include "Image.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -104,6 +107,70 @@ typedef struct tagSVTFCreateOptions
 } SVTFCreateOptions;
 #pragma pack()
 
+//! VTF image statistics struct.
+/*!
+	The SVTFImageStatistics struct holds the results of a single analysis pass
+	over an image with methods such as CVTFFile::ComputeImageStatistics().
+	Channel values are those the image decodes to in RGBA8888.
+
+	\see CVTFFile::ComputeImageStatistics()
+*/
+#pragma pack(1)
+typedef struct tagSVTFImageStatistics
+{
+	vlUInt uiPixelCount;								//!< Number of pixels analysed.
+
+	vlByte bMinimum[4];									//!< RGBA channel minimums.
+	vlByte bMaximum[4];									//!< RGBA channel maximums.
+	vlSingle sMean[4];									//!< RGBA channel means (0 to 255).
+	vlUInt uiHistogram[4][256];							//!< RGBA channel histograms.
+
+	vlSingle sReflectivity[3];							//!< Linear light (gamma 2.2) RGB average, as stored in the header.
+	vlSingle sLogAverageLuminance;						//!< Log average luminance (0 to 1).  For FP16 sources this is the tone mapping key input.
+
+	VTFAlphaUsage AlphaUsage;							//!< How the alpha channel is used.
+	vlBool bConstant;									//!< Every pixel is the same colour.
+} SVTFImageStatistics;
+#pragma pack()
+
+//! VTF header info struct.
+/*!
+	The SVTFHeaderInfo struct holds what can be learnt about a VTF file from
+	its header and resource directory alone.  It is filled by
+	CVTFFile::LoadHeaderInfo() which reads only the start of the file.
+
+	\see CVTFFile::LoadHeaderInfo()
+*/
+#pragma pack(1)
+typedef struct tagSVTFHeaderInfo
+{
+	vlUInt uiFileSize;									//!< Size of the file in bytes.
+	vlUInt uiVersion[2];								//!< File version.
+	vlUInt uiHeaderSize;								//!< Size of the header in bytes.
+
+	vlUInt uiWidth;										//!< Width of the largest mipmap.
+	vlUInt uiHeight;									//!< Height of the largest mipmap.
+	vlUInt uiDepth;										//!< Depth of the largest mipmap.
+	vlUInt uiFrameCount;								//!< Number of frames.
+	vlUInt uiStartFrame;								//!< First frame of the animation.
+	vlUInt uiFaceCount;									//!< Number of faces.
+	vlUInt uiMipmapCount;								//!< Number of mipmaps.
+	vlUInt uiFlags;										//!< Image flags (see VTFImageFlag).
+	VTFImageFormat ImageFormat;							//!< Image format.
+
+	VTFImageFormat ThumbnailFormat;						//!< Thumbnail format or IMAGE_FORMAT_NONE.
+	vlUInt uiThumbnailWidth;							//!< Thumbnail width.
+	vlUInt uiThumbnailHeight;							//!< Thumbnail height.
+
+	vlSingle sReflectivity[3];							//!< Reflectivity vector.
+	vlSingle sBumpScale;								//!< Bump map scale.
+
+	vlUInt uiResourceCount;								//!< Number of resource directory entries.
+	vlUInt uiResourceTypes[VTF_RSRC_MAX_DICTIONARY_ENTRIES];	//!< Resource types (see VTFResourceEntryType).
+	vlUInt uiResourceData[VTF_RSRC_MAX_DICTIONARY_ENTRIES];	//!< Resource data; the value itself or the offset of its data chunk.
+} SVTFHeaderInfo;
+#pragma pack()
+
 #ifdef __cplusplus
 }
 #endif
@@ -137,10 +204,14 @@ namespace VTFLib
 	
 		vlUInt uiImageBufferSize;				// Size of VTF image data buffer
 		vlByte *lpImageData;					// VTF image buffer
+		PFreeProc pImageDataFree;				// Frees an image buffer adopted from the caller, null if VTFLib allocated it
+		vlVoid *pImageDataUserData;				// User data for pImageDataFree
 
 		vlUInt uiThumbnailBufferSize;			// Size of VTF thumbnail image data buffer
 		vlByte *lpThumbnailImageData;			// VTF thumbnail image buffer
 
+		SVTFLibOptions *lpOptions;				// Image options, null to use the process wide options
+
 	public:
 
 		CVTFFile();		//!< Default constructor
@@ -164,8 +235,17 @@ namespace VTFLib
 		*/
 		CVTFFile(const CVTFFile &VTFFile, VTFImageFormat ImageFormat);
 
+		//! Create a new VTFFile class from another, taking its data without copying it.
+		/*!
+			\param VTFFile is the CVTFFile class to move from.  It is left empty.
+		*/
+		CVTFFile(CVTFFile &&VTFFile);
+
 		~CVTFFile();	//!< Deconstructor
 
+		//! Replaces this VTF file with another, taking its data without copying it.
+		CVTFFile &operator=(CVTFFile &&VTFFile);
+
 	public:
 		
 		//! Creates a new empty VTF image..
@@ -217,6 +297,43 @@ namespace VTFLib
 			\see tagSVTFCreateOptions
 		*/
 		vlBool Create(vlUInt uiWidth, vlUInt uiHeight, vlUInt uiFrames, vlUInt uiFaces, vlUInt vlSlices, vlByte **lpImageDataRGBA8888, const SVTFCreateOptions &VTFCreateOptions);
+
+		//! Create a new VTF image that takes ownership of existing image data.
+		/*!
+			Same as the first Create() but uses lpImageData as the image data instead of
+			allocating and filling a new buffer.  The data must already be in ImageFormat
+			and laid out as the VTF stores it: smallest MIP level first and, within each
+			level, frames, then faces, then slices.  Its size must be exactly what
+			ComputeImageSize() gives times the frame and face counts.
+
+			\param lpImageData is the image data to take ownership of.
+			\param uiImageDataSize is the size of lpImageData in bytes.
+			\param pFree is called to free lpImageData when the image is destroyed.
+			\param pUserData is passed to pFree.
+			
+eturn true on successful creation, otherwise false.  On failure lpImageData
+			is not taken and the caller must still free it.
+		*/
+		vlBool Create(vlUInt uiWidth, vlUInt uiHeight, vlUInt uiFrames, vlUInt uiFaces, vlUInt uiSlices, VTFImageFormat ImageFormat, vlBool bThumbnail, vlBool bMipmaps, vlByte *lpImageData, vlUInt uiImageDataSize, PFreeProc pFree, vlVoid *pUserData);
+
+		//! Create a new VTF image from existing RGBA8888 data, taking ownership of it.
+		/*!
+			Same as the multi-frame Create() but the images are stored one after the other in
+			lpImageDataRGBA8888, which the VTF image takes ownership of.  When the image is
+			created as RGBA8888 without MIP maps or re-sizing, and uiImageDataSize also has
+			room for the sphere map if one is generated, the data is processed in place and
+			becomes the image data without being copied.  Otherwise it is used as the source
+			and freed once the image is built.
+
+			\param lpImageDataRGBA8888 is the RGBA8888 data of each frame, face or slice.
+			\param uiImageDataSize is the size of lpImageDataRGBA8888 in bytes.
+			\param pFree is called to free lpImageDataRGBA8888.
+			\param pUserData is passed to pFree.
+			\param VTFCreateOptions contains the options for image creation.
+			
+eturn true on successful creation, otherwise false.  The data is freed either way.
+		*/
+		vlBool Create(vlUInt uiWidth, vlUInt uiHeight, vlUInt uiFrames, vlUInt uiFaces, vlUInt uiSlices, vlByte *lpImageDataRGBA8888, vlUInt uiImageDataSize, PFreeProc pFree, vlVoid *pUserData, const SVTFCreateOptions &VTFCreateOptions);
 		
 		//! Destroys the current VTF image by setting the header, thumbnail and image data to zero.
 		vlVoid Destroy();
@@ -267,6 +384,20 @@ namespace VTFLib
 		*/
 		vlBool Load(vlVoid *pUserData, vlBool bHeaderOnly = vlFalse);
 
+		//! Load a VTF image from a package.
+		/*!
+			Loads a VTF image file straight out of a package's mapped archives into
+			the current VTFFile class.  You may choose to load just the header only
+			if you want to get info about the file and save memory.
+
+			\param Package is an open package.
+			\param cPath is the path of the file in the package.
+			\param bHeaderOnly sets whether to load just the VTF header or not (default false).
+			
+eturn true on sucessful load, otherwise false.
+		*/
+		vlBool Load(const CVPKFile &Package, const vlChar *cPath, vlBool bHeaderOnly = vlFalse);
+
 		//! Save a VTF image from disk.
 		/*!
 			Saves a VTF format image file to disk from the current VTFFile class.
@@ -295,7 +426,125 @@ namespace VTFLib
 		*/
 		vlBool Save(vlVoid *pUserData) const;
 
+		//! Loads a DDS image from disk.
+		/*!
+			Loads a DirectDraw Surface file into the current VTFFile class without
+			decoding it.  Each surface is read straight into place, so DXTn, the 8888,
+			888, 565, 5551 and 4444 layouts, luminance, alpha, DuDv and the float
+			formats come across unchanged, with their mipmaps, cubemap faces, volume
+			slices and array slices (as frames).  The image has no thumbnail.
+
+			\param cFileName is the path and filename of the file to load.
+			\return true on sucessful load, otherwise false.
+			\see SaveDDS()
+		*/
+		vlBool LoadDDS(const vlChar *cFileName);
+
+		//! Loads a DDS image from memory.
+		/*!
+			\param lpData is a pointer to the DDS file in memory.
+			\param uiBufferSize is the size of the DDS file in bytes.
+			\return true on sucessful load, otherwise false.
+			\see LoadDDS()
+		*/
+		vlBool LoadDDS(const vlVoid *lpData, vlUInt uiBufferSize);
+
+		//! Saves the image as a DDS file on disk.
+		/*!
+			Saves the image data as it is, reordered from VTF's smallest mipmap first
+			to DDS's largest first.  Fails if the format has no DDS equivalent, in
+			which case convert it first.  Images with more than one frame are saved
+			as arrays with the DX10 header; the sphere map face of old cubemaps and
+			the thumbnail are dropped.
+
+			\param cFileName is the path and filename of the file to save.
+			\return true on sucessful save, otherwise false.
+		*/
+		vlBool SaveDDS(const vlChar *cFileName) const;
+
+		//! Saves the image as a DDS file in memory.
+		/*!
+			\param lpData is a pointer to save the image to.
+			\param uiBufferSize is the size of the buffer in bytes.
+			\param uiSize is set to the number of bytes written.
+			\return true on sucessful save, otherwise false.
+			\see SaveDDS()
+		*/
+		vlBool SaveDDS(vlVoid *lpData, vlUInt uiBufferSize, vlUInt &uiSize) const;
+
+		//! Reads the header of a VTF image from disk.
+		/*!
+			Reads just the header and resource directory of a VTF file without creating an image.
+			Only the start of the file is read and nothing is allocated, so this is the fast way
+			to gather information about many files.
+
+			\param cFileName is the path and filename of the file to read.
+			\param HeaderInfo receives the header information.
+			\return true on sucessful read, otherwise false.
+		*/
+		static vlBool LoadHeaderInfo(const vlChar *cFileName, SVTFHeaderInfo &HeaderInfo);
+
+		//! Reads the header of a VTF image from memory.
+		/*!
+			\param lpData is a pointer to the VTF file in memory.
+			\param uiBufferSize is the size of the VTF file in bytes.
+			\param HeaderInfo receives the header information.
+			\return true on sucessful read, otherwise false.
+			\see LoadHeaderInfo()
+		*/
+		static vlBool LoadHeaderInfo(const vlVoid *lpData, vlUInt uiBufferSize, SVTFHeaderInfo &HeaderInfo);
+
+		//! Checks a VTF image on disk for corruption.
+		/*!
+			Runs the same header and size checks as Load() and, if the file has an image
+			CRC resource (VTF_RSRC_IMAGE_CRC), checks the image data against it.  The image
+			data is streamed rather than loaded.
+
+			\param cFileName is the path and filename of the file to check.
+			\param bHasCRC is set if the file has an image CRC resource and it was checked.
+			\return true if no problem was found, otherwise false.
+			\see ComputeCRC()
+		*/
+		static vlBool Verify(const vlChar *cFileName, vlBool &bHasCRC);
+
+		//! Checks a VTF image in memory for corruption.
+		/*!
+			\param lpData is a pointer to the VTF file in memory.
+			\param uiBufferSize is the size of the VTF file in bytes.
+			\param bHasCRC is set if the file has an image CRC resource and it was checked.
+			\return true if no problem was found, otherwise false.
+			\see Verify()
+		*/
+		static vlBool Verify(const vlVoid *lpData, vlUInt uiBufferSize, vlBool &bHasCRC);
+
+	public:
+
+		//! Get the options used by this image.
+		/*!
+			Returns the options this image uses when converting, compressing and re-sizing.
+
+			\return a pointer to the image's options or null if the process wide options are used.
+			\see SetOptions()
+		*/
+		const SVTFLibOptions *GetOptions() const;
+
+		//! Set the options used by this image.
+		/*!
+			Gives the image its own copy of the options so it can be processed on one thread
+			while other threads use different settings.
+
+			\param Options is the options to use or null to use the process wide options.
+			\see vlGetOptions()
+		*/
+		vlVoid SetOptions(const SVTFLibOptions *Options);
+
 	private:
+		vlVoid ResolveOptions(SVTFLibOptions &Options) const;	//!< Copies the options in effect for this image.
+
+		vlBool CreateImage(vlUInt uiWidth, vlUInt uiHeight, vlUInt uiFrames, vlUInt uiFaces, vlUInt uiSlices, VTFImageFormat ImageFormat, vlBool bThumbnail, vlBool bMipmaps, vlBool bNullImageData, vlByte *lpImageData, vlUInt uiImageDataSize, PFreeProc pFree, vlVoid *pUserData);
+		vlBool CreateImage(vlUInt uiWidth, vlUInt uiHeight, vlUInt uiFrames, vlUInt uiFaces, vlUInt uiSlices, vlByte **lpImageDataRGBA8888, vlByte *lpImageData, vlUInt uiImageDataSize, PFreeProc pFree, vlVoid *pUserData, vlBool &bAdopted, const SVTFCreateOptions &VTFCreateOptions);
+		vlVoid FreeImageData();	//!< Frees the image buffer with whatever allocated it.
+
 		vlBool IsPowerOfTwo(vlUInt uiSize);
 		vlUInt NextPowerOfTwo(vlUInt uiSize);
 
@@ -304,6 +553,15 @@ namespace VTFLib
 		// Interface with out reader/writer classes
 		vlBool Load(IO::Readers::IReader *Reader, vlBool bHeaderOnly);
 		vlBool Save(IO::Writers::IWriter *Writer) const;
+		vlBool LoadDDS(IO::Readers::IReader *Reader);
+		vlBool SaveDDS(IO::Writers::IWriter *Writer) const;
+
+		static vlBool ReadHeader(IO::Readers::IReader *Reader, SVTFHeader &Header);
+		static vlBool ReadLayout(IO::Readers::IReader *Reader, SVTFHeader &Header, vlUInt &uiThumbnailOffset, vlUInt &uiThumbnailSize, vlUInt &uiImageOffset, vlUInt &uiImageSize);
+		static vlBool LoadHeaderInfo(IO::Readers::IReader *Reader, SVTFHeaderInfo &HeaderInfo);
+		static vlBool Verify(IO::Readers::IReader *Reader, vlBool &bHasCRC);
+
+		static vlUInt ComputeFaceCount(const SVTFHeader &Header);
 
 	public:
 
@@ -318,6 +576,19 @@ namespace VTFLib
 
 		vlUInt GetMajorVersion() const;	 //!< Returns the VTF file major version number.
 		vlUInt GetMinorVersion() const;	 //!< Returns the VTF file minor version number.
+
+		//! Sets the VTF file version the image is saved as.
+		/*!
+			Fails if the version is out of range, can't hold the image or would change
+			its face count.  Resources other than the image and thumbnail are dropped
+			when going to a version without resources.
+
+			\param uiMajorVersion is the major version, which must be VTF_MAJOR_VERSION.
+			\param uiMinorVersion is the minor version, from 0 to VTF_MINOR_VERSION.
+			eturn true on success, otherwise false.
+		*/
+		vlBool SetVersion(vlUInt uiMajorVersion, vlUInt uiMinorVersion);
+
 		vlUInt GetSize() const;			 //!< Returns the VTF file size in bytes.
 
 		vlUInt GetWidth() const;	//!< Returns the width of the image in pixels from the VTF header.
@@ -412,6 +683,20 @@ namespace VTFLib
 		*/
 		vlVoid SetData(vlUInt uiFrame, vlUInt uiFace, vlUInt uiSlice, vlUInt uiMipmapLevel, vlByte *lpData);
 
+		//! Replace all the image data, taking ownership of the new data.
+		/*!
+			lpImageData must be laid out as the current image data, in the format specified
+			in the VTF header, and be the same size.  The old data is freed.
+
+			\param lpImageData is the image data to take ownership of.
+			\param uiImageDataSize is the size of lpImageData in bytes.
+			\param pFree is called to free lpImageData when it is no longer needed.
+			\param pUserData is passed to pFree.
+			
+eturn true on success, otherwise false.  On failure lpImageData is not taken.
+		*/
+		vlBool SetData(vlByte *lpImageData, vlUInt uiImageDataSize, PFreeProc pFree, vlVoid *pUserData);
+
 	public:
 		
 		vlBool GetHasThumbnail() const;		//!< Returns if a the current VTF image image contains a thumbnail version.
@@ -541,6 +826,49 @@ namespace VTFLib
 	public:
 
 		vlBool ComputeReflectivity();	//!< Calculates and sets the reflectivity vector values for the VTF image based on the colour averages of each pixel.
+
+		//! Analyses an image.
+		/*!
+			Computes the statistics of the image data for the given frame, face, slice
+			and MIP level in a single pass over the stored data.
+
+			\param uiFrame is the frame index.
+			\param uiFace is the face index.
+			\param uiSlice is the z slice index.
+			\param uiMipmapLevel is the MIP level.
+			\param Statistics is the struct to hold the results.
+			\return true on sucess, otherwise false.
+			\see ComputeImageStatistics()
+		*/
+		vlBool ComputeStatistics(vlUInt uiFrame, vlUInt uiFace, vlUInt uiSlice, vlUInt uiMipmapLevel, SVTFImageStatistics &Statistics) const;
+
+		//! Creates a preview of an image.
+		/*!
+			Box filters the image data for the given frame, face and slice down to
+			the given size, starting from the smallest MIP level that is big enough.
+
+			\param uiFrame is the frame index.
+			\param uiFace is the face index.
+			\param uiSlice is the z slice index.
+			\param lpDestRGBA8888 is a pointer to the buffer for the preview in RGBA8888 format.
+			\param uiDestWidth is the width of the preview in pixels.
+			\param uiDestHeight is the height of the preview in pixels.
+			\return true on sucess, otherwise false.
+			\see ComputeImagePreview()
+		*/
+		vlBool ComputePreview(vlUInt uiFrame, vlUInt uiFace, vlUInt uiSlice, vlByte *lpDestRGBA8888, vlUInt uiDestWidth, vlUInt uiDestHeight) const;
+
+		//! Computes the CRC of the image data.
+		/*!
+			Computes the CRC-32 of all the high resolution image data as stored in the
+			image CRC resource.  Save() keeps that resource up to date and adds it when
+			the VTFLIB_WRITE_CRC option is set.
+
+			\param uiCRC receives the CRC.
+			\return true on sucess, otherwise false.
+			\see Verify()
+		*/
+		vlBool ComputeCRC(vlUInt &uiCRC) const;
 	
 	public:
 
@@ -643,6 +971,13 @@ namespace VTFLib
 		*/
 		static vlBool ConvertToRGBA8888(vlByte *lpSource, vlByte *lpDest, vlUInt uiWidth, vlUInt uiHeight, VTFImageFormat SourceFormat);
 
+		//! Convert an image to RGBA8888 format using the given options.
+		static vlBool ConvertToRGBA8888(vlByte *lpSource, vlByte *lpDest, vlUInt uiWidth, vlUInt uiHeight, VTFImageFormat SourceFormat, const SVTFLibOptions &Options);
+
+		//! Convert an image view to an RGBA8888 image view of the same size.
+		static vlBool ConvertToRGBA8888(const CImageView &Source, const CImageView &Dest);
+		static vlBool ConvertToRGBA8888(const CImageView &Source, const CImageView &Dest, const SVTFLibOptions &Options);	//!< As above, using the given options.
+
 		//! Convert an image from RGBA8888 format.
 		/*!
 			Converts image data stored in RGBA8888 format to the the specified storage format.
@@ -656,6 +991,13 @@ namespace VTFLib
 		*/
 		static vlBool ConvertFromRGBA8888(vlByte *lpSource, vlByte *lpDest, vlUInt uiWidth, vlUInt uiHeight, VTFImageFormat DestFormat);
 
+		//! Convert an image from RGBA8888 format using the given options.
+		static vlBool ConvertFromRGBA8888(vlByte *lpSource, vlByte *lpDest, vlUInt uiWidth, vlUInt uiHeight, VTFImageFormat DestFormat, const SVTFLibOptions &Options);
+
+		//! Convert an RGBA8888 image view to an image view of the same size.
+		static vlBool ConvertFromRGBA8888(const CImageView &Source, const CImageView &Dest);
+		static vlBool ConvertFromRGBA8888(const CImageView &Source, const CImageView &Dest, const SVTFLibOptions &Options);	//!< As above, using the given options.
+
 		//! Convert an image from any format to any format.
 		/*!
 			Converts image data stored in any format to the the specified storage format.
@@ -670,6 +1012,27 @@ namespace VTFLib
 		*/
 		static vlBool Convert(vlByte *lpSource, vlByte *lpDest, vlUInt uiWidth, vlUInt uiHeight, VTFImageFormat SourceFormat, VTFImageFormat DestFormat);
 
+		//! Convert an image from any format to any format using the given options.
+		/*!
+			Same as Convert() but reads DXT quality, luminance weights, blue screen and FP16 HDR
+			settings from Options instead of the process wide options.  Safe to call from
+			several threads at once.
+		*/
+		static vlBool Convert(vlByte *lpSource, vlByte *lpDest, vlUInt uiWidth, vlUInt uiHeight, VTFImageFormat SourceFormat, VTFImageFormat DestFormat, const SVTFLibOptions &Options);
+
+		//! Convert an image view to another image view of the same size.
+		/*!
+			Converts from the format of Source to the format of Dest.  The views may have
+			any pitch, so parts of larger images and buffers owned by other libraries can
+			be converted in place without copying them first.
+
+			\param Source is the view of the source image data.
+			\param Dest is the view to write the converted data to.
+			\return true on sucessful conversion, otherwise false.
+		*/
+		static vlBool Convert(const CImageView &Source, const CImageView &Dest);
+		static vlBool Convert(const CImageView &Source, const CImageView &Dest, const SVTFLibOptions &Options);	//!< As above, using the given options.
+
 		//! Convert an image to a normal map.
 		/*!
 			Converts image data stored in RGBA8888 format to a normal map.
@@ -706,6 +1069,13 @@ namespace VTFLib
 		*/
 		static vlBool Resize(vlByte *lpSourceRGBA8888, vlByte *lpDestRGBA8888, vlUInt uiSourceWidth, vlUInt uiSourceHeight, vlUInt uiDestWidth, vlUInt uiDestHeight, VTFMipmapFilter ResizeFilter = MIPMAP_FILTER_TRIANGLE, VTFSharpenFilter SharpenFilter = SHARPEN_FILTER_NONE);
 
+		//! Re-sizes an image using the sharpen settings from the given options.
+		static vlBool Resize(vlByte *lpSourceRGBA8888, vlByte *lpDestRGBA8888, vlUInt uiSourceWidth, vlUInt uiSourceHeight, vlUInt uiDestWidth, vlUInt uiDestHeight, VTFMipmapFilter ResizeFilter, VTFSharpenFilter SharpenFilter, const SVTFLibOptions &Options);
+
+		//! Re-sizes an RGBA8888 image view to the size of another RGBA8888 image view.
+		static vlBool Resize(const CImageView &Source, const CImageView &Dest, VTFMipmapFilter ResizeFilter = MIPMAP_FILTER_TRIANGLE, VTFSharpenFilter SharpenFilter = SHARPEN_FILTER_NONE);
+		static vlBool Resize(const CImageView &Source, const CImageView &Dest, VTFMipmapFilter ResizeFilter, VTFSharpenFilter SharpenFilter, const SVTFLibOptions &Options);	//!< As above, using the given options.
+
 	private:
 		
 		// DXTn format decompression functions
@@ -714,7 +1084,10 @@ namespace VTFLib
 		static vlBool DecompressDXT5(vlByte *src, vlByte *dst, vlUInt uiWidth, vlUInt uiHeight);
 
 		// DXTn format compression function
-		static vlBool CompressDXTn(vlByte *lpSource, vlByte *lpDest, vlUInt uiWidth, vlUInt uiHeight, VTFImageFormat DestFormat);
+		static vlBool CompressDXTn(vlByte *lpSource, vlByte *lpDest, vlUInt uiWidth, vlUInt uiHeight, VTFImageFormat DestFormat, const SVTFLibOptions &Options);
+
+		// Decodes part of an image for the statistics and preview functions
+		static vlBool DecodeRows(vlByte *lpSource, vlByte *lpDest, vlUInt uiWidth, vlUInt uiRows, VTFImageFormat SourceFormat, vlSingle sHDRLogAverageLuminance, const SVTFLibOptions &Options);
 
 	public:
 
@@ -744,8 +1117,66 @@ namespace VTFLib
 		*/
 		static vlVoid ComputeImageReflectivity(vlByte *lpImageDataRGBA8888, vlUInt uiWidth, vlUInt uiHeight, vlSingle &sX, vlSingle &sY, vlSingle &sZ);
 
+		//! Analyses image data.
+		/*!
+			Computes channel ranges, means and histograms, reflectivity, log average
+			luminance, alpha usage and whether the image is a single colour.  The data
+			is decoded a few rows at a time straight from its stored format and the
+			rows are split across the available cores.
+
+			\param lpSource is a pointer to the image data.
+			\param uiWidth is the width of the source image in pixels.
+			\param uiHeight is the height of the source image in pixels.
+			\param SourceFormat is the format of the image data.
+			\param Statistics is the struct to hold the results.
+			\return true on sucess, otherwise false.
+			\see ComputeStatistics()
+		*/
+		static vlBool ComputeImageStatistics(vlByte *lpSource, vlUInt uiWidth, vlUInt uiHeight, VTFImageFormat SourceFormat, SVTFImageStatistics &Statistics);
+		static vlBool ComputeImageStatistics(vlByte *lpSource, vlUInt uiWidth, vlUInt uiHeight, VTFImageFormat SourceFormat, SVTFImageStatistics &Statistics, const SVTFLibOptions &Options);	//!< As above, using the given options to decode the data.
+
+		//! Creates a preview of image data.
+		/*!
+			Box filters image data down to a preview.  DXTn data is reduced a block
+			at a time from the block end points and indices, without decoding it,
+			when it has at least as many blocks as the preview has pixels.  Other
+			data is decoded a few rows at a time.
+
+			\param lpSource is a pointer to the image data.
+			\param uiWidth is the width of the source image in pixels.
+			\param uiHeight is the height of the source image in pixels.
+			\param SourceFormat is the format of the image data.
+			\param lpDestRGBA8888 is a pointer to the buffer for the preview in RGBA8888 format.
+			\param uiDestWidth is the width of the preview in pixels.
+			\param uiDestHeight is the height of the preview in pixels.
+			\return true on sucess, otherwise false.
+			\see ComputePreview()
+		*/
+		static vlBool ComputeImagePreview(vlByte *lpSource, vlUInt uiWidth, vlUInt uiHeight, VTFImageFormat SourceFormat, vlByte *lpDestRGBA8888, vlUInt uiDestWidth, vlUInt uiDestHeight);
+		static vlBool ComputeImagePreview(vlByte *lpSource, vlUInt uiWidth, vlUInt uiHeight, VTFImageFormat SourceFormat, vlByte *lpDestRGBA8888, vlUInt uiDestWidth, vlUInt uiDestHeight, const SVTFLibOptions &Options);	//!< As above, using the given options to decode the data.
+
 		static vlVoid FlipImage(vlByte *lpImageDataRGBA8888, vlUInt uiWidth, vlUInt uiHeight);		//!< Flips an image vertically along its X-axis.
 		static vlVoid MirrorImage(vlByte *lpImageDataRGBA8888, vlUInt uiWidth, vlUInt uiHeight);	//!< Flips an image horizontally along its Y-axis.
+
+		static vlBool FlipImage(const CImageView &Image);		//!< Flips an image view of any uncompressed or DXTn format vertically along its X-axis.
+		static vlBool MirrorImage(const CImageView &Image);		//!< Flips an image view of any uncompressed or DXTn format horizontally along its Y-axis.
+
+		//! Rotates and flips an image into another buffer.
+		/*!
+			Copies the image to a buffer of the transformed size, which is the
+			source size with the width and height swapped for 90 degree rotations
+			and diagonal flips.  DXT1, DXT3 and DXT5 data is transformed a block at
+			a time by moving the blocks and reordering the indices within them,
+			which is lossless and much faster than decoding and encoding; their
+			width and height must be multiples of 4.
+
+			\param Source is the image to transform.
+			\param Dest is the image to write, which must be a different buffer of the same format.
+			\param Transform is the rotation or flip to apply.
+			\return true on sucess, otherwise false.
+		*/
+		static vlBool TransformImage(const CImageView &Source, const CImageView &Dest, VTFImageTransform Transform);
+		static vlBool TransformImage(vlByte *lpSource, vlByte *lpDest, vlUInt uiWidth, vlUInt uiHeight, VTFImageFormat ImageFormat, VTFImageTransform Transform);	//!< As above, for packed image data uiWidth by uiHeight pixels.
 	};
 }
 
@@ -289,6 +289,29 @@ typedef enum tagVTFResizeMethod
 	RESIZE_COUNT
 } VTFResizeMethod;
 
+//! Image alpha channel usage indices.
+typedef enum tagVTFAlphaUsage
+{
+	ALPHA_USAGE_NONE = 0,		//!< Every pixel is opaque.
+	ALPHA_USAGE_ONEBIT,			//!< Pixels are either opaque or fully transparent.
+	ALPHA_USAGE_EIGHTBIT,		//!< Pixels use partial transparency.
+	ALPHA_USAGE_COUNT
+} VTFAlphaUsage;
+
+//! Image transform indices, the eight ways a square can be rotated and flipped.
+typedef enum tagVTFImageTransform
+{
+	IMAGE_TRANSFORM_NONE = 0,		//!< Leaves the image as it is.
+	IMAGE_TRANSFORM_ROTATE_90,		//!< Rotates 90 degrees clockwise.
+	IMAGE_TRANSFORM_ROTATE_180,		//!< Rotates 180 degrees.
+	IMAGE_TRANSFORM_ROTATE_270,		//!< Rotates 90 degrees anticlockwise.
+	IMAGE_TRANSFORM_FLIP,			//!< Flips vertically along the X axis.
+	IMAGE_TRANSFORM_MIRROR,			//!< Flips horizontally along the Y axis.
+	IMAGE_TRANSFORM_TRANSPOSE,		//!< Swaps X and Y, flipping along the top left to bottom right diagonal.
+	IMAGE_TRANSFORM_TRANSVERSE,		//!< Flips along the top right to bottom left diagonal.
+	IMAGE_TRANSFORM_COUNT
+} VTFImageTransform;
+
 //! Spheremap creation look direction indices.
 //--------------------------------------------
 typedef enum tagVTFLookDir
@@ -322,6 +345,7 @@ typedef enum tagVTFResourceEntryType
 	VTF_RSRC_TEXTURE_LOD_SETTINGS = MAKE_VTF_RSRC_IDF('L', 'O', 'D', RSRCF_HAS_NO_DATA_CHUNK),
 	VTF_RSRC_TEXTURE_SETTINGS_EX = MAKE_VTF_RSRC_IDF('T', 'S', 'O', RSRCF_HAS_NO_DATA_CHUNK),
 	VTF_RSRC_KEY_VALUE_DATA = MAKE_VTF_RSRC_ID('K', 'V', 'D'),
+	VTF_RSRC_IMAGE_CRC = MAKE_VTF_RSRC_IDF('I', 'C', 'R', RSRCF_HAS_NO_DATA_CHUNK),	//!< CRC-32 of the high resolution image data, written by VTFLib.
 	VTF_RSRC_MAX_DICTIONARY_ENTRIES = 32
 } VTFResourceEntryType;
 
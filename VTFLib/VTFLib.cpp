@@ -12,13 +12,16 @@
 #include "VTFLib.h"
 #include "VTFFile.h"
 #include "VMTFile.h"
+#include "StatTimer.h"
+
+#include <mutex>
 
 using namespace VTFLib;
 
 namespace VTFLib
 {
 	vlBool bInitialized = vlFalse;
-	Diagnostics::CError LastError;
+	thread_local Diagnostics::CError LastError;
 
 	CVTFFile *Image = 0;
 	CImageVector *ImageVector = 0;
@@ -26,32 +29,88 @@ namespace VTFLib
 	CVMTFile *Material = 0;
 	CMaterialVector *MaterialVector = 0;
 
-	vlUInt uiDXTQuality = DXT_QUALITY_HIGH;
+	static const SVTFLibOptions DefaultOptions =
+	{
+		DXT_QUALITY_HIGH,				// uiDXTQuality
+
+		0.299f,							// sLuminanceWeightR
+		0.587f,							// sLuminanceWeightG
+		0.114f,							// sLuminanceWeightB
+
+		0x0000,							// uiBlueScreenMaskR
+		0x0000,							// uiBlueScreenMaskG
+		0xffff,							// uiBlueScreenMaskB
+
+		0x0000,							// uiBlueScreenClearR
+		0x0000,							// uiBlueScreenClearG
+		0x0000,							// uiBlueScreenClearB
+
+		4.0f,							// sFP16HDRKey
+		0.0f,							// sFP16HDRShift
+		2.25f,							// sFP16HDRGamma
+
+		2.0f,							// sUnsharpenRadius
+		0.5f,							// sUnsharpenAmount
+		0.0f,							// sUnsharpenThreshold
+
+		255.0f,							// sXSharpenStrength
+		255.0f,							// sXSharpenThreshold
+
+		PARSE_MODE_LOOSE,				// uiVMTParseMode
+
+		vlFalse							// bWriteCRC
+	};
+
+	static SVTFLibOptions GlobalOptions = DefaultOptions;
+	static std::mutex GlobalOptionsMutex;
+
+	//
+	// GetOptions()
+	// Takes a consistent copy of the process wide options.
+	//
+	vlVoid GetOptions(SVTFLibOptions &Options)
+	{
+		std::lock_guard<std::mutex> Lock(GlobalOptionsMutex);
+		Options = GlobalOptions;
+	}
+
+	//
+	// ValidateOptions()
+	// Applies the rules of the single option setters to a whole options struct.
+	//
+	vlVoid ValidateOptions(SVTFLibOptions &Options, const SVTFLibOptions &Requested)
+	{
+		if(Requested.uiDXTQuality < DXT_QUALITY_COUNT)
+			Options.uiDXTQuality = Requested.uiDXTQuality;
+
+		Options.sLuminanceWeightR = Requested.sLuminanceWeightR < 0.0f ? 0.0f : Requested.sLuminanceWeightR;
+		Options.sLuminanceWeightG = Requested.sLuminanceWeightG < 0.0f ? 0.0f : Requested.sLuminanceWeightG;
+		Options.sLuminanceWeightB = Requested.sLuminanceWeightB < 0.0f ? 0.0f : Requested.sLuminanceWeightB;
 
-	vlSingle sLuminanceWeightR = 0.299f;
-	vlSingle sLuminanceWeightG = 0.587f;
-	vlSingle sLuminanceWeightB = 0.114f;
+		Options.uiBlueScreenMaskR = Requested.uiBlueScreenMaskR;
+		Options.uiBlueScreenMaskG = Requested.uiBlueScreenMaskG;
+		Options.uiBlueScreenMaskB = Requested.uiBlueScreenMaskB;
 
-	vlUShort uiBlueScreenMaskR = 0x0000;
-	vlUShort uiBlueScreenMaskG = 0x0000;
-	vlUShort uiBlueScreenMaskB = 0xffff;
+		Options.uiBlueScreenClearR = Requested.uiBlueScreenClearR;
+		Options.uiBlueScreenClearG = Requested.uiBlueScreenClearG;
+		Options.uiBlueScreenClearB = Requested.uiBlueScreenClearB;
 
-	vlUShort uiBlueScreenClearR = 0x0000;
-	vlUShort uiBlueScreenClearG = 0x0000;
-	vlUShort uiBlueScreenClearB = 0x0000;
+		Options.sFP16HDRKey = Requested.sFP16HDRKey;
+		Options.sFP16HDRShift = Requested.sFP16HDRShift;
+		Options.sFP16HDRGamma = Requested.sFP16HDRGamma;
 
-	vlSingle sFP16HDRKey = 4.0f;
-	vlSingle sFP16HDRShift = 0.0f;
-	vlSingle sFP16HDRGamma = 2.25f;
+		Options.sUnsharpenRadius = Requested.sUnsharpenRadius <= 0.0f ? 2.0f : Requested.sUnsharpenRadius;
+		Options.sUnsharpenAmount = Requested.sUnsharpenAmount <= 0.0f ? 0.5f : Requested.sUnsharpenAmount;
+		Options.sUnsharpenThreshold = Requested.sUnsharpenThreshold < 0.0f ? 0.0f : Requested.sUnsharpenThreshold;
 
-	vlSingle sUnsharpenRadius = 2.0f;
-	vlSingle sUnsharpenAmount = 0.5f;
-	vlSingle sUnsharpenThreshold = 0.0f;
+		Options.sXSharpenStrength = Requested.sXSharpenStrength < 0.0f ? 0.0f : (Requested.sXSharpenStrength > 255.0f ? 255.0f : Requested.sXSharpenStrength);
+		Options.sXSharpenThreshold = Requested.sXSharpenThreshold < 0.0f ? 0.0f : (Requested.sXSharpenThreshold > 255.0f ? 255.0f : Requested.sXSharpenThreshold);
 
-	vlSingle sXSharpenStrength = 255.0f;
-	vlSingle sXSharpenThreshold = 255.0f;
+		if(Requested.uiVMTParseMode < PARSE_MODE_COUNT)
+			Options.uiVMTParseMode = Requested.uiVMTParseMode;
 
-	vlUInt uiVMTParseMode = PARSE_MODE_LOOSE;
+		Options.bWriteCRC = Requested.bWriteCRC;
+	}
 }
 
 //
@@ -136,129 +195,168 @@ VTFLIB_API vlVoid vlShutdown()
 
 VTFLIB_API vlBool vlGetBoolean(VTFLibOption Option)
 {
+	std::lock_guard<std::mutex> Lock(GlobalOptionsMutex);
+
+	switch(Option)
+	{
+	case VTFLIB_WRITE_CRC:
+		return GlobalOptions.bWriteCRC;
+
+	case VTFLIB_STATS:
+		return Diagnostics::GetStatFlag(STAT_FLAG_COUNT);
+	case VTFLIB_TRACE:
+		return Diagnostics::GetStatFlag(STAT_FLAG_TRACE);
+
+	case VTFLIB_LARGE_PAGES:
+		return Memory::GetLargePages();
+	default:
+		break;
+	}
+
 	return vlFalse;
 }
 
 VTFLIB_API vlVoid vlSetBoolean(VTFLibOption Option, vlBool bValue)
 {
+	std::lock_guard<std::mutex> Lock(GlobalOptionsMutex);
+
+	switch(Option)
+	{
+	case VTFLIB_WRITE_CRC:
+		GlobalOptions.bWriteCRC = bValue;
+		break;
+
+	case VTFLIB_STATS:
+		Diagnostics::SetStatFlag(STAT_FLAG_COUNT, bValue);
+		break;
+	case VTFLIB_TRACE:
+		Diagnostics::SetStatFlag(STAT_FLAG_TRACE, bValue);
+		break;
 
+	case VTFLIB_LARGE_PAGES:
+		Memory::SetLargePages(bValue);
+		break;
+	default:
+		break;
+	}
 }
 
 VTFLIB_API vlInt vlGetInteger(VTFLibOption Option)
 {
+	std::lock_guard<std::mutex> Lock(GlobalOptionsMutex);
+
 	switch(Option)
 	{
 	case VTFLIB_DXT_QUALITY:
-		return (vlInt)uiDXTQuality;
+		return (vlInt)GlobalOptions.uiDXTQuality;
 
 	case VTFLIB_BLUESCREEN_MASK_R:
-		return (vlInt)uiBlueScreenMaskR;
+		return (vlInt)GlobalOptions.uiBlueScreenMaskR;
 	case VTFLIB_BLUESCREEN_MASK_G:
-		return (vlInt)uiBlueScreenMaskG;
+		return (vlInt)GlobalOptions.uiBlueScreenMaskG;
 	case VTFLIB_BLUESCREEN_MASK_B:
-		return (vlInt)uiBlueScreenMaskB;
+		return (vlInt)GlobalOptions.uiBlueScreenMaskB;
 
 	case VTFLIB_BLUESCREEN_CLEAR_R:
-		return (vlInt)uiBlueScreenClearR;
+		return (vlInt)GlobalOptions.uiBlueScreenClearR;
 	case VTFLIB_BLUESCREEN_CLEAR_G:
-		return (vlInt)uiBlueScreenClearG;
+		return (vlInt)GlobalOptions.uiBlueScreenClearG;
 	case VTFLIB_BLUESCREEN_CLEAR_B:
-		return (vlInt)uiBlueScreenClearB;
+		return (vlInt)GlobalOptions.uiBlueScreenClearB;
 
 	case VTFLIB_VMT_PARSE_MODE:
-		return (vlInt)uiVMTParseMode;
+		return (vlInt)GlobalOptions.uiVMTParseMode;
+	default:
+		break;
 	}
 
 	return 0;
 }
 
+static vlUShort ClampUShort(vlInt iValue)
+{
+	if(iValue < 0)
+		iValue = 0;
+	else if(iValue > 65535)
+		iValue = 65535;
+	return (vlUShort)iValue;
+}
+
 VTFLIB_API vlVoid vlSetInteger(VTFLibOption Option, vlInt iValue)
 {
+	std::lock_guard<std::mutex> Lock(GlobalOptionsMutex);
+
 	switch(Option)
 	{
 	case VTFLIB_DXT_QUALITY:
 		if(iValue < 0 || iValue >= DXT_QUALITY_COUNT)
 			return;
-		uiDXTQuality = (vlUInt)iValue;
+		GlobalOptions.uiDXTQuality = (vlUInt)iValue;
 		break;
 
 	case VTFLIB_BLUESCREEN_MASK_R:
-		if(iValue < 0)
-			iValue = 0;
-		else if(iValue > 65535)
-			iValue = 65535;
-		uiBlueScreenMaskR = (vlUShort)iValue;
+		GlobalOptions.uiBlueScreenMaskR = ClampUShort(iValue);
 		break;
 	case VTFLIB_BLUESCREEN_MASK_G:
-		if(iValue < 0)
-			iValue = 0;
-		else if(iValue > 65535)
-			iValue = 65535;
-		uiBlueScreenMaskG = (vlUShort)iValue;
+		GlobalOptions.uiBlueScreenMaskG = ClampUShort(iValue);
 		break;
 	case VTFLIB_BLUESCREEN_MASK_B:
-		if(iValue < 0)
-			iValue = 0;
-		else if(iValue > 65535)
-			iValue = 65535;
-		uiBlueScreenMaskB = (vlUShort)iValue;
+		GlobalOptions.uiBlueScreenMaskB = ClampUShort(iValue);
 		break;
 
 	case VTFLIB_BLUESCREEN_CLEAR_R:
-		if(iValue < 0)
-			iValue = 0;
-		else if(iValue > 65535)
-			iValue = 65535;
-		uiBlueScreenClearR = (vlUShort)iValue;
+		GlobalOptions.uiBlueScreenClearR = ClampUShort(iValue);
 		break;
 	case VTFLIB_BLUESCREEN_CLEAR_G:
-		if(iValue < 0)
-			iValue = 0;
-		else if(iValue > 65535)
-			iValue = 65535;
-		uiBlueScreenClearG = (vlUShort)iValue;
+		GlobalOptions.uiBlueScreenClearG = ClampUShort(iValue);
 		break;
 	case VTFLIB_BLUESCREEN_CLEAR_B:
-		if(iValue < 0)
-			iValue = 0;
-		else if(iValue > 65535)
-			iValue = 65535;
-		uiBlueScreenClearB = (vlUShort)iValue;
+		GlobalOptions.uiBlueScreenClearB = ClampUShort(iValue);
 		break;
 
 	case VTFLIB_VMT_PARSE_MODE:
 		if(iValue < 0 || iValue >= PARSE_MODE_COUNT)
 			return;
-		uiVMTParseMode = (vlUInt)iValue;
+		GlobalOptions.uiVMTParseMode = (vlUInt)iValue;
+		break;
+	default:
 		break;
 	}
 }
 
 VTFLIB_API vlSingle vlGetFloat(VTFLibOption Option)
 {
+	std::lock_guard<std::mutex> Lock(GlobalOptionsMutex);
+
 	switch(Option)
 	{
 	case VTFLIB_LUMINANCE_WEIGHT_R:
-		return sLuminanceWeightR;
+		return GlobalOptions.sLuminanceWeightR;
 	case VTFLIB_LUMINANCE_WEIGHT_G:
-		return sLuminanceWeightG;
+		return GlobalOptions.sLuminanceWeightG;
 	case VTFLIB_LUMINANCE_WEIGHT_B:
-		return sLuminanceWeightB;
+		return GlobalOptions.sLuminanceWeightB;
 
 	case VTFLIB_FP16_HDR_KEY:
-		return sFP16HDRKey;
+		return GlobalOptions.sFP16HDRKey;
+	case VTFLIB_FP16_HDR_SHIFT:
+		return GlobalOptions.sFP16HDRShift;
+	case VTFLIB_FP16_HDR_GAMMA:
+		return GlobalOptions.sFP16HDRGamma;
 
 	case VTFLIB_UNSHARPEN_RADIUS:
-		return sUnsharpenRadius;
+		return GlobalOptions.sUnsharpenRadius;
 	case VTFLIB_UNSHARPEN_AMOUNT:
-		return sUnsharpenAmount;
+		return GlobalOptions.sUnsharpenAmount;
 	case VTFLIB_UNSHARPEN_THRESHOLD:
-		return sUnsharpenThreshold;
+		return GlobalOptions.sUnsharpenThreshold;
 
 	case VTFLIB_XSHARPEN_STRENGTH:
-		return sXSharpenStrength;
+		return GlobalOptions.sXSharpenStrength;
 	case VTFLIB_XSHARPEN_THRESHOLD:
-		return sXSharpenThreshold;
+		return GlobalOptions.sXSharpenThreshold;
+	default:
+		break;
 	}
 
 	return 0.0f;
@@ -266,48 +364,50 @@ VTFLIB_API vlSingle vlGetFloat(VTFLibOption Option)
 
 VTFLIB_API vlVoid vlSetFloat(VTFLibOption Option, vlSingle sValue)
 {
+	std::lock_guard<std::mutex> Lock(GlobalOptionsMutex);
+
 	switch(Option)
 	{
 	case VTFLIB_LUMINANCE_WEIGHT_R:
 		if(sValue < 0.0f)
 			sValue = 0.0f;
-		sLuminanceWeightR = sValue;
+		GlobalOptions.sLuminanceWeightR = sValue;
 		break;
 	case VTFLIB_LUMINANCE_WEIGHT_G:
 		if(sValue < 0.0f)
 			sValue = 0.0f;
-		sLuminanceWeightG = sValue;
+		GlobalOptions.sLuminanceWeightG = sValue;
 		break;
 	case VTFLIB_LUMINANCE_WEIGHT_B:
 		if(sValue < 0.0f)
 			sValue = 0.0f;
-		sLuminanceWeightB = sValue;
+		GlobalOptions.sLuminanceWeightB = sValue;
 		break;
 
 	case VTFLIB_FP16_HDR_KEY:
-		sFP16HDRKey = sValue;
+		GlobalOptions.sFP16HDRKey = sValue;
 		break;
 	case VTFLIB_FP16_HDR_SHIFT:
-		sFP16HDRShift = sValue;
+		GlobalOptions.sFP16HDRShift = sValue;
 		break;
 	case VTFLIB_FP16_HDR_GAMMA:
-		sFP16HDRGamma = sValue;
+		GlobalOptions.sFP16HDRGamma = sValue;
 		break;
 
 	case VTFLIB_UNSHARPEN_RADIUS:
 		if(sValue <= 0.0f)
 			sValue = 2.0f;
-		sUnsharpenRadius = sValue;
+		GlobalOptions.sUnsharpenRadius = sValue;
 		break;
 	case VTFLIB_UNSHARPEN_AMOUNT:
 		if(sValue <= 0.0f)
 			sValue = 0.5f;
-		sUnsharpenAmount = sValue;
+		GlobalOptions.sUnsharpenAmount = sValue;
 		break;
 	case VTFLIB_UNSHARPEN_THRESHOLD:
 		if(sValue < 0.0f)
 			sValue = 0.0f;
-		sUnsharpenThreshold = sValue;
+		GlobalOptions.sUnsharpenThreshold = sValue;
 		break;
 
 	case VTFLIB_XSHARPEN_STRENGTH:
@@ -315,18 +415,53 @@ VTFLIB_API vlVoid vlSetFloat(VTFLibOption Option, vlSingle sValue)
 			sValue = 0.0f;
 		if(sValue > 255.0f)
 			sValue = 255.0f;
-		sXSharpenStrength = sValue;
+		GlobalOptions.sXSharpenStrength = sValue;
 		break;
 	case VTFLIB_XSHARPEN_THRESHOLD:
 		if(sValue < 0.0f)
 			sValue = 0.0f;
 		if(sValue > 255.0f)
 			sValue = 255.0f;
-		sXSharpenThreshold = sValue;
+		GlobalOptions.sXSharpenThreshold = sValue;
+		break;
+	default:
 		break;
 	}
 }
 
+//
+// vlGetDefaultOptions()
+// Gets the options VTFLib starts up with.
+//
+VTFLIB_API vlVoid vlGetDefaultOptions(SVTFLibOptions *Options)
+{
+	*Options = DefaultOptions;
+}
+
+//
+// vlGetOptions()
+// Gets a copy of the process wide options.
+//
+VTFLIB_API vlVoid vlGetOptions(SVTFLibOptions *Options)
+{
+	GetOptions(*Options);
+}
+
+//
+// vlSetOptions()
+// Sets all process wide options, validating each one.
+//
+VTFLIB_API vlVoid vlSetOptions(const SVTFLibOptions *Options)
+{
+	std::lock_guard<std::mutex> Lock(GlobalOptionsMutex);
+
+	// Validate a copy so other threads never see half the new options.
+	SVTFLibOptions Valid = GlobalOptions;
+	ValidateOptions(Valid, *Options);
+
+	GlobalOptions = Valid;
+}
+
 //
 // DllMain()
 // DLL entry point.
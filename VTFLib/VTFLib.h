@@ -101,6 +101,9 @@
 
 #include "stdafx.h"
 #include "Error.h"
+#include "Options.h"
+#include "Stats.h"
+#include "Allocator.h"
 #include "VTFFile.h"
 #include "VMTFile.h"
 
@@ -112,7 +115,7 @@ namespace VTFLib
 	typedef std::vector<VTFLib::CVMTFile *> CMaterialVector;
 
 	extern vlBool bInitialized;
-	extern Diagnostics::CError LastError;
+	extern thread_local Diagnostics::CError LastError;
 
 	extern CVTFFile *Image;
 	extern CImageVector *ImageVector;
@@ -120,32 +123,13 @@ namespace VTFLib
 	extern CVMTFile *Material;
 	extern CMaterialVector *MaterialVector;
 
-	extern vlUInt uiDXTQuality;
+	// Process wide options, used when an object or call has no options of its own.
+	// Always access through GetOptions() as other threads may be changing them.
+	vlVoid GetOptions(SVTFLibOptions &Options);
 
-	extern vlSingle sLuminanceWeightR;
-	extern vlSingle sLuminanceWeightG;
-	extern vlSingle sLuminanceWeightB;
-
-	extern vlUShort uiBlueScreenMaskR;
-	extern vlUShort uiBlueScreenMaskG;
-	extern vlUShort uiBlueScreenMaskB;
-
-	extern vlUShort uiBlueScreenClearR;
-	extern vlUShort uiBlueScreenClearG;
-	extern vlUShort uiBlueScreenClearB;
-
-	extern vlSingle sFP16HDRKey;
-	extern vlSingle sFP16HDRShift;
-	extern vlSingle sFP16HDRGamma;
-
-	extern vlSingle sUnsharpenRadius;
-	extern vlSingle sUnsharpenAmount;
-	extern vlSingle sUnsharpenThreshold;
-
-	extern vlSingle sXSharpenStrength;
-	extern vlSingle sXSharpenThreshold;
-
-	extern vlUInt uiVMTParseMode;
+	// Copies the valid fields of Requested into Options, clamping as vlSetInteger()
+	// and vlSetFloat() do.  Fields that can't be clamped keep their value in Options.
+	vlVoid ValidateOptions(SVTFLibOptions &Options, const SVTFLibOptions &Requested);
 }
 
 #define VL_VERSION			132			//!< VTFLib version as integer
@@ -182,7 +166,14 @@ typedef enum tagVTFLibOption
 	VTFLIB_XSHARPEN_STRENGTH,
 	VTFLIB_XSHARPEN_THRESHOLD,
 
-	VTFLIB_VMT_PARSE_MODE
+	VTFLIB_VMT_PARSE_MODE,
+
+	VTFLIB_WRITE_CRC,
+
+	VTFLIB_STATS,
+	VTFLIB_TRACE,
+
+	VTFLIB_LARGE_PAGES
 } VTFLibOption;
 
 //! Return the VTFLib version as an integer.
@@ -215,6 +206,13 @@ VTFLIB_API vlSingle vlGetFloat(VTFLibOption Option);
 //! Set the specified option.
 VTFLIB_API vlVoid vlSetFloat(VTFLibOption Option, vlSingle sValue);
 
+//! Fill the options struct with the library defaults.
+VTFLIB_API vlVoid vlGetDefaultOptions(SVTFLibOptions *Options);
+//! Fill the options struct with the current process wide options.
+VTFLIB_API vlVoid vlGetOptions(SVTFLibOptions *Options);
+//! Set all process wide options at once.  Values are validated as with vlSetInteger() and vlSetFloat().
+VTFLIB_API vlVoid vlSetOptions(const SVTFLibOptions *Options);
+
 #ifdef __cplusplus
 }
 #endif
@@ -29,10 +29,6 @@
 #define CACHE_LINE  16								//!< Alignment size.
 #define CACHE_ALIGN __declspec(align(CACHE_LINE))	//!< Storage-class information alignment.
 
-// Macros
-//-------
-#define drand48() (((vlSingle) rand())/((vlSingle) RAND_MAX))		//!< Random number generator for the spheremap generation function.
-
 // Vector class
 //-------------
 //! Simple 3D Vector class
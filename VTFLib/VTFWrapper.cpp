@@ -12,6 +12,8 @@
 #include "VTFLib.h"
 #include "VTFWrapper.h"
 #include "VTFFile.h"
+#include "VPKFile.h"
+#include "Context.h"
 
 using namespace VTFLib;
 
@@ -181,6 +183,34 @@ VTFLIB_API vlBool vlImageCreateMultiple(vlUInt uiWidth, vlUInt uiHeight, vlUInt
 	return Image->Create(uiWidth, uiHeight, uiFrames, uiFaces, uiSlices, lpImageDataRGBA8888, *VTFCreateOptions);
 }
 
+VTFLIB_API vlBool vlImageCreateFromData(vlUInt uiWidth, vlUInt uiHeight, vlUInt uiFrames, vlUInt uiFaces, vlUInt uiSlices, VTFImageFormat ImageFormat, vlBool bThumbnail, vlBool bMipmaps, vlByte *lpImageData, vlUInt uiImageDataSize, PFreeProc pFree, vlVoid *pUserData)
+{
+	if(Image == 0)
+	{
+		LastError.Set("No image bound.");
+		return vlFalse;
+	}
+
+	return Image->Create(uiWidth, uiHeight, uiFrames, uiFaces, uiSlices, ImageFormat, bThumbnail, bMipmaps, lpImageData, uiImageDataSize, pFree, pUserData);
+}
+
+VTFLIB_API vlBool vlImageCreateMultipleFromData(vlUInt uiWidth, vlUInt uiHeight, vlUInt uiFrames, vlUInt uiFaces, vlUInt uiSlices, vlByte *lpImageDataRGBA8888, vlUInt uiImageDataSize, PFreeProc pFree, vlVoid *pUserData, SVTFCreateOptions *VTFCreateOptions)
+{
+	if(Image == 0)
+	{
+		// The data is always taken.
+		if(lpImageDataRGBA8888 != 0 && pFree != 0)
+		{
+			pFree(lpImageDataRGBA8888, pUserData);
+		}
+
+		LastError.Set("No image bound.");
+		return vlFalse;
+	}
+
+	return Image->Create(uiWidth, uiHeight, uiFrames, uiFaces, uiSlices, lpImageDataRGBA8888, uiImageDataSize, pFree, pUserData, *VTFCreateOptions);
+}
+
 VTFLIB_API vlVoid vlImageDestroy()
 {
 	if(Image == 0)
@@ -233,6 +263,47 @@ VTFLIB_API vlBool vlImageLoadProc(vlVoid *pUserData, vlBool bHeaderOnly)
 	return Image->Load(pUserData, bHeaderOnly);
 }
 
+//
+// vlImageLoadPackage()
+// Loads the bound image from a package, see CVTFFile::Load(const CVPKFile &, const vlChar *, vlBool).
+//
+VTFLIB_API vlBool vlImageLoadPackage(VLPackage *Package, const vlChar *cPath, vlBool bHeaderOnly)
+{
+	if(Image == 0)
+	{
+		LastError.Set("No image bound.");
+		return vlFalse;
+	}
+
+	if(Package == 0)
+	{
+		LastError.Set("Invalid package.");
+		return vlFalse;
+	}
+
+	return Image->Load(*reinterpret_cast<CVPKFile *>(Package), cPath, bHeaderOnly);
+}
+
+VTFLIB_API vlBool vlImageLoadHeaderInfo(const vlChar *cFileName, SVTFHeaderInfo *HeaderInfo)
+{
+	return CVTFFile::LoadHeaderInfo(cFileName, *HeaderInfo);
+}
+
+VTFLIB_API vlBool vlImageLoadHeaderInfoLump(const vlVoid *lpData, vlUInt uiBufferSize, SVTFHeaderInfo *HeaderInfo)
+{
+	return CVTFFile::LoadHeaderInfo(lpData, uiBufferSize, *HeaderInfo);
+}
+
+VTFLIB_API vlBool vlImageVerify(const vlChar *cFileName, vlBool *bHasCRC)
+{
+	return CVTFFile::Verify(cFileName, *bHasCRC);
+}
+
+VTFLIB_API vlBool vlImageVerifyLump(const vlVoid *lpData, vlUInt uiBufferSize, vlBool *bHasCRC)
+{
+	return CVTFFile::Verify(lpData, uiBufferSize, *bHasCRC);
+}
+
 VTFLIB_API vlBool vlImageSave(const vlChar *cFileName)
 {
 	if(Image == 0)
@@ -266,6 +337,58 @@ VTFLIB_API vlBool vlImageSaveProc(vlVoid *pUserData)
 	return Image->Save(pUserData);
 }
 
+//
+// vlImageLoadDDS()
+// Loads a DDS file into the bound image without decoding it, see CVTFFile::LoadDDS().
+//
+VTFLIB_API vlBool vlImageLoadDDS(const vlChar *cFileName)
+{
+	if(Image == 0)
+	{
+		LastError.Set("No image bound.");
+		return vlFalse;
+	}
+
+	return Image->LoadDDS(cFileName);
+}
+
+VTFLIB_API vlBool vlImageLoadDDSLump(const vlVoid *lpData, vlUInt uiBufferSize)
+{
+	if(Image == 0)
+	{
+		LastError.Set("No image bound.");
+		return vlFalse;
+	}
+
+	return Image->LoadDDS(lpData, uiBufferSize);
+}
+
+//
+// vlImageSaveDDS()
+// Saves the bound image as a DDS file without decoding it, see CVTFFile::SaveDDS().
+//
+VTFLIB_API vlBool vlImageSaveDDS(const vlChar *cFileName)
+{
+	if(Image == 0)
+	{
+		LastError.Set("No image bound.");
+		return vlFalse;
+	}
+
+	return Image->SaveDDS(cFileName);
+}
+
+VTFLIB_API vlBool vlImageSaveDDSLump(vlVoid *lpData, vlUInt uiBufferSize, vlUInt *uiSize)
+{
+	if(Image == 0)
+	{
+		LastError.Set("No image bound.");
+		return vlFalse;
+	}
+
+	return Image->SaveDDS(lpData, uiBufferSize, *uiSize);
+}
+
 VTFLIB_API vlUInt vlImageGetMajorVersion()
 {
 	if(Image == 0)
@@ -450,6 +573,17 @@ VTFLIB_API vlVoid vlImageSetData(vlUInt uiFrame, vlUInt uiFace, vlUInt uiSlice,
 	Image->SetData(uiFrame, uiFace, uiSlice, uiMipmapLevel, lpData);
 }
 
+VTFLIB_API vlBool vlImageAdoptData(vlByte *lpImageData, vlUInt uiImageDataSize, PFreeProc pFree, vlVoid *pUserData)
+{
+	if(Image == 0)
+	{
+		LastError.Set("No image bound.");
+		return vlFalse;
+	}
+
+	return Image->SetData(lpImageData, uiImageDataSize, pFree, pUserData);
+}
+
 VTFLIB_API vlBool vlImageGetHasThumbnail()
 {
 	if(Image == 0)
@@ -602,6 +736,30 @@ VTFLIB_API vlBool vlImageComputeReflectivity()
 	return Image->ComputeReflectivity();
 }
 
+VTFLIB_API vlBool vlImageComputeStatistics(vlUInt uiFrame, vlUInt uiFace, vlUInt uiSlice, vlUInt uiMipmapLevel, SVTFImageStatistics *Statistics)
+{
+	if(Image == 0)
+		return vlFalse;
+
+	return Image->ComputeStatistics(uiFrame, uiFace, uiSlice, uiMipmapLevel, *Statistics);
+}
+
+VTFLIB_API vlBool vlImageComputePreview(vlUInt uiFrame, vlUInt uiFace, vlUInt uiSlice, vlByte *lpDestRGBA8888, vlUInt uiDestWidth, vlUInt uiDestHeight)
+{
+	if(Image == 0)
+		return vlFalse;
+
+	return Image->ComputePreview(uiFrame, uiFace, uiSlice, lpDestRGBA8888, uiDestWidth, uiDestHeight);
+}
+
+VTFLIB_API vlBool vlImageComputeCRC(vlUInt *uiCRC)
+{
+	if(Image == 0)
+		return vlFalse;
+
+	return Image->ComputeCRC(*uiCRC);
+}
+
 VTFLIB_API SVTFImageFormatInfo const *vlImageGetImageFormatInfo(VTFImageFormat ImageFormat)
 {
 	return &CVTFFile::GetImageFormatInfo(ImageFormat);
@@ -673,6 +831,16 @@ VTFLIB_API vlVoid vlImageComputeImageReflectivity(vlByte *lpImageDataRGBA8888, v
 	CVTFFile::ComputeImageReflectivity(lpImageDataRGBA8888, uiWidth, uiHeight, *sX, *sY, *sZ);
 }
 
+VTFLIB_API vlBool vlImageComputeImageStatistics(vlByte *lpSource, vlUInt uiWidth, vlUInt uiHeight, VTFImageFormat SourceFormat, SVTFImageStatistics *Statistics)
+{
+	return CVTFFile::ComputeImageStatistics(lpSource, uiWidth, uiHeight, SourceFormat, *Statistics);
+}
+
+VTFLIB_API vlBool vlImageComputeImagePreview(vlByte *lpSource, vlUInt uiWidth, vlUInt uiHeight, VTFImageFormat SourceFormat, vlByte *lpDestRGBA8888, vlUInt uiDestWidth, vlUInt uiDestHeight)
+{
+	return CVTFFile::ComputeImagePreview(lpSource, uiWidth, uiHeight, SourceFormat, lpDestRGBA8888, uiDestWidth, uiDestHeight);
+}
+
 VTFLIB_API vlVoid vlImageFlipImage(vlByte *lpImageDataRGBA8888, vlUInt uiWidth, vlUInt uiHeight)
 {
 	CVTFFile::FlipImage(lpImageDataRGBA8888, uiWidth, uiHeight);
@@ -680,5 +848,687 @@ VTFLIB_API vlVoid vlImageFlipImage(vlByte *lpImageDataRGBA8888, vlUInt uiWidth,
 
 VTFLIB_API vlVoid vlImageMirrorImage(vlByte *lpImageDataRGBA8888, vlUInt uiWidth, vlUInt uiHeight)
 {
-	CVTFFile::FlipImage(lpImageDataRGBA8888, uiWidth, uiHeight);
-}
\ No newline at end of file
+	CVTFFile::MirrorImage(lpImageDataRGBA8888, uiWidth, uiHeight);
+}
+
+VTFLIB_API vlBool vlImageTransformImage(vlByte *lpSource, vlByte *lpDest, vlUInt uiWidth, vlUInt uiHeight, VTFImageFormat ImageFormat, VTFImageTransform Transform)
+{
+	return CVTFFile::TransformImage(lpSource, lpDest, uiWidth, uiHeight, ImageFormat, Transform);
+}
+
+//
+// Pins an image in a context's table for the length of a call.
+//
+class CContextImage : public CHandleRef<CVTFFile>
+{
+public:
+	CContextImage(VLContext *Context, vlUInt uiImage) : CHandleRef<CVTFFile>(Context != 0 ? &CContext::FromHandle(Context)->GetImages() : 0, uiImage, "Invalid image.")
+	{
+
+	}
+};
+
+//
+// vlContextCreateImage()
+// Create an image in a context.  The image starts with the context's options.
+//
+VTFLIB_API vlBool vlContextCreateImage(VLContext *Context, vlUInt *uiImage)
+{
+	CContext *Instance = CContext::FromHandle(Context);
+	if(Instance == 0)
+		return vlFalse;
+
+	SVTFLibOptions Options;
+	Instance->GetOptions(Options);
+
+	CVTFFile *VTFFile = new CVTFFile();
+	VTFFile->SetOptions(&Options);
+
+	*uiImage = Instance->GetImages().Add(VTFFile);
+	if(*uiImage == 0)
+	{
+		delete VTFFile;
+
+		LastError.Set("Too many images.");
+		return vlFalse;
+	}
+
+	return vlTrue;
+}
+
+//
+// vlContextDeleteImage()
+// Delete an image in a context.  If another thread is still using the image
+// it is freed when that call returns.  The handle is invalid from now on.
+//
+VTFLIB_API vlVoid vlContextDeleteImage(VLContext *Context, vlUInt uiImage)
+{
+	CContext *Instance = CContext::FromHandle(Context);
+	if(Instance == 0)
+		return;
+
+	Instance->GetImages().Remove(uiImage);
+}
+
+VTFLIB_API vlBool vlContextImageCreate(VLContext *Context, vlUInt uiImage, vlUInt uiWidth, vlUInt uiHeight, vlUInt uiFrames, vlUInt uiFaces, vlUInt uiSlices, VTFImageFormat ImageFormat, vlBool bThumbnail, vlBool bMipmaps, vlBool bNullImageData)
+{
+	CContextImage Image(Context, uiImage);
+	if(!Image)
+		return vlFalse;
+
+	return Image->Create(uiWidth, uiHeight, uiFrames, uiFaces, uiSlices, ImageFormat, bThumbnail, bMipmaps, bNullImageData);
+}
+
+VTFLIB_API vlBool vlContextImageCreateSingle(VLContext *Context, vlUInt uiImage, vlUInt uiWidth, vlUInt uiHeight, vlByte *lpImageDataRGBA8888, SVTFCreateOptions *VTFCreateOptions)
+{
+	CContextImage Image(Context, uiImage);
+	if(!Image)
+		return vlFalse;
+
+	return Image->Create(uiWidth, uiHeight, lpImageDataRGBA8888, *VTFCreateOptions);
+}
+
+VTFLIB_API vlBool vlContextImageCreateMultiple(VLContext *Context, vlUInt uiImage, vlUInt uiWidth, vlUInt uiHeight, vlUInt uiFrames, vlUInt uiFaces, vlUInt uiSlices, vlByte **lpImageDataRGBA8888, SVTFCreateOptions *VTFCreateOptions)
+{
+	CContextImage Image(Context, uiImage);
+	if(!Image)
+		return vlFalse;
+
+	return Image->Create(uiWidth, uiHeight, uiFrames, uiFaces, uiSlices, lpImageDataRGBA8888, *VTFCreateOptions);
+}
+
+VTFLIB_API vlBool vlContextImageCreateFromData(VLContext *Context, vlUInt uiImage, vlUInt uiWidth, vlUInt uiHeight, vlUInt uiFrames, vlUInt uiFaces, vlUInt uiSlices, VTFImageFormat ImageFormat, vlBool bThumbnail, vlBool bMipmaps, vlByte *lpImageData, vlUInt uiImageDataSize, PFreeProc pFree, vlVoid *pUserData)
+{
+	CContextImage Image(Context, uiImage);
+	if(!Image)
+		return vlFalse;
+
+	return Image->Create(uiWidth, uiHeight, uiFrames, uiFaces, uiSlices, ImageFormat, bThumbnail, bMipmaps, lpImageData, uiImageDataSize, pFree, pUserData);
+}
+
+VTFLIB_API vlBool vlContextImageCreateMultipleFromData(VLContext *Context, vlUInt uiImage, vlUInt uiWidth, vlUInt uiHeight, vlUInt uiFrames, vlUInt uiFaces, vlUInt uiSlices, vlByte *lpImageDataRGBA8888, vlUInt uiImageDataSize, PFreeProc pFree, vlVoid *pUserData, SVTFCreateOptions *VTFCreateOptions)
+{
+	CContextImage Image(Context, uiImage);
+	if(!Image)
+	{
+		// The data is always taken.
+		if(lpImageDataRGBA8888 != 0 && pFree != 0)
+		{
+			pFree(lpImageDataRGBA8888, pUserData);
+		}
+
+		return vlFalse;
+	}
+
+	return Image->Create(uiWidth, uiHeight, uiFrames, uiFaces, uiSlices, lpImageDataRGBA8888, uiImageDataSize, pFree, pUserData, *VTFCreateOptions);
+}
+
+VTFLIB_API vlVoid vlContextImageDestroy(VLContext *Context, vlUInt uiImage)
+{
+	CContextImage Image(Context, uiImage);
+	if(!Image)
+		return;
+
+	Image->Destroy();
+}
+
+VTFLIB_API vlBool vlContextImageIsLoaded(VLContext *Context, vlUInt uiImage)
+{
+	CContextImage Image(Context, uiImage);
+	if(!Image)
+		return vlFalse;
+
+	return Image->IsLoaded();
+}
+
+VTFLIB_API vlBool vlContextImageLoad(VLContext *Context, vlUInt uiImage, const vlChar *cFileName, vlBool bHeaderOnly)
+{
+	CContextImage Image(Context, uiImage);
+	if(!Image)
+		return vlFalse;
+
+	return Image->Load(cFileName, bHeaderOnly);
+}
+
+VTFLIB_API vlBool vlContextImageLoadLump(VLContext *Context, vlUInt uiImage, const vlVoid *lpData, vlUInt uiBufferSize, vlBool bHeaderOnly)
+{
+	CContextImage Image(Context, uiImage);
+	if(!Image)
+		return vlFalse;
+
+	return Image->Load(lpData, uiBufferSize, bHeaderOnly);
+}
+
+VTFLIB_API vlBool vlContextImageLoadProc(VLContext *Context, vlUInt uiImage, vlVoid *pUserData, vlBool bHeaderOnly)
+{
+	CContextImage Image(Context, uiImage);
+	if(!Image)
+		return vlFalse;
+
+	return Image->Load(pUserData, bHeaderOnly);
+}
+
+VTFLIB_API vlBool vlContextImageSave(VLContext *Context, vlUInt uiImage, const vlChar *cFileName)
+{
+	CContextImage Image(Context, uiImage);
+	if(!Image)
+		return vlFalse;
+
+	return Image->Save(cFileName);
+}
+
+VTFLIB_API vlBool vlContextImageSaveLump(VLContext *Context, vlUInt uiImage, vlVoid *lpData, vlUInt uiBufferSize, vlUInt *uiSize)
+{
+	CContextImage Image(Context, uiImage);
+	if(!Image)
+		return vlFalse;
+
+	return Image->Save(lpData, uiBufferSize, *uiSize);
+}
+
+VTFLIB_API vlBool vlContextImageSaveProc(VLContext *Context, vlUInt uiImage, vlVoid *pUserData)
+{
+	CContextImage Image(Context, uiImage);
+	if(!Image)
+		return vlFalse;
+
+	return Image->Save(pUserData);
+}
+
+VTFLIB_API vlBool vlContextImageLoadDDS(VLContext *Context, vlUInt uiImage, const vlChar *cFileName)
+{
+	CContextImage Image(Context, uiImage);
+	if(!Image)
+		return vlFalse;
+
+	return Image->LoadDDS(cFileName);
+}
+
+VTFLIB_API vlBool vlContextImageLoadDDSLump(VLContext *Context, vlUInt uiImage, const vlVoid *lpData, vlUInt uiBufferSize)
+{
+	CContextImage Image(Context, uiImage);
+	if(!Image)
+		return vlFalse;
+
+	return Image->LoadDDS(lpData, uiBufferSize);
+}
+
+VTFLIB_API vlBool vlContextImageSaveDDS(VLContext *Context, vlUInt uiImage, const vlChar *cFileName)
+{
+	CContextImage Image(Context, uiImage);
+	if(!Image)
+		return vlFalse;
+
+	return Image->SaveDDS(cFileName);
+}
+
+VTFLIB_API vlBool vlContextImageSaveDDSLump(VLContext *Context, vlUInt uiImage, vlVoid *lpData, vlUInt uiBufferSize, vlUInt *uiSize)
+{
+	CContextImage Image(Context, uiImage);
+	if(!Image)
+		return vlFalse;
+
+	return Image->SaveDDS(lpData, uiBufferSize, *uiSize);
+}
+
+VTFLIB_API vlUInt vlContextImageGetMajorVersion(VLContext *Context, vlUInt uiImage)
+{
+	CContextImage Image(Context, uiImage);
+	if(!Image)
+		return 0;
+
+	return Image->GetMajorVersion();
+}
+
+VTFLIB_API vlUInt vlContextImageGetMinorVersion(VLContext *Context, vlUInt uiImage)
+{
+	CContextImage Image(Context, uiImage);
+	if(!Image)
+		return 0;
+
+	return Image->GetMinorVersion();
+}
+
+VTFLIB_API vlUInt vlContextImageGetSize(VLContext *Context, vlUInt uiImage)
+{
+	CContextImage Image(Context, uiImage);
+	if(!Image)
+		return 0;
+
+	return Image->GetSize();
+}
+
+VTFLIB_API vlUInt vlContextImageGetHasImage(VLContext *Context, vlUInt uiImage)
+{
+	CContextImage Image(Context, uiImage);
+	if(!Image)
+		return vlFalse;
+
+	return Image->GetHasImage();
+}
+
+VTFLIB_API vlUInt vlContextImageGetWidth(VLContext *Context, vlUInt uiImage)
+{
+	CContextImage Image(Context, uiImage);
+	if(!Image)
+		return 0;
+
+	return Image->GetWidth();
+}
+
+VTFLIB_API vlUInt vlContextImageGetHeight(VLContext *Context, vlUInt uiImage)
+{
+	CContextImage Image(Context, uiImage);
+	if(!Image)
+		return 0;
+
+	return Image->GetHeight();
+}
+
+VTFLIB_API vlUInt vlContextImageGetDepth(VLContext *Context, vlUInt uiImage)
+{
+	CContextImage Image(Context, uiImage);
+	if(!Image)
+		return 0;
+
+	return Image->GetDepth();
+}
+
+VTFLIB_API vlUInt vlContextImageGetFrameCount(VLContext *Context, vlUInt uiImage)
+{
+	CContextImage Image(Context, uiImage);
+	if(!Image)
+		return 0;
+
+	return Image->GetFrameCount();
+}
+
+VTFLIB_API vlUInt vlContextImageGetFaceCount(VLContext *Context, vlUInt uiImage)
+{
+	CContextImage Image(Context, uiImage);
+	if(!Image)
+		return 0;
+
+	return Image->GetFaceCount();
+}
+
+VTFLIB_API vlUInt vlContextImageGetMipmapCount(VLContext *Context, vlUInt uiImage)
+{
+	CContextImage Image(Context, uiImage);
+	if(!Image)
+		return 0;
+
+	return Image->GetMipmapCount();
+}
+
+VTFLIB_API vlUInt vlContextImageGetStartFrame(VLContext *Context, vlUInt uiImage)
+{
+	CContextImage Image(Context, uiImage);
+	if(!Image)
+		return 0;
+
+	return Image->GetStartFrame();
+}
+
+VTFLIB_API vlVoid vlContextImageSetStartFrame(VLContext *Context, vlUInt uiImage, vlUInt uiStartFrame)
+{
+	CContextImage Image(Context, uiImage);
+	if(!Image)
+		return;
+
+	Image->SetStartFrame(uiStartFrame);
+}
+
+VTFLIB_API vlUInt vlContextImageGetFlags(VLContext *Context, vlUInt uiImage)
+{
+	CContextImage Image(Context, uiImage);
+	if(!Image)
+		return 0;
+
+	return Image->GetFlags();
+}
+
+VTFLIB_API vlVoid vlContextImageSetFlags(VLContext *Context, vlUInt uiImage, vlUInt uiFlags)
+{
+	CContextImage Image(Context, uiImage);
+	if(!Image)
+		return;
+
+	Image->SetFlags(uiFlags);
+}
+
+VTFLIB_API vlBool vlContextImageGetFlag(VLContext *Context, vlUInt uiImage, VTFImageFlag ImageFlag)
+{
+	CContextImage Image(Context, uiImage);
+	if(!Image)
+		return vlFalse;
+
+	return Image->GetFlag(ImageFlag);
+}
+
+VTFLIB_API vlVoid vlContextImageSetFlag(VLContext *Context, vlUInt uiImage, VTFImageFlag ImageFlag, vlBool bState)
+{
+	CContextImage Image(Context, uiImage);
+	if(!Image)
+		return;
+
+	Image->SetFlag(ImageFlag, bState);
+}
+
+VTFLIB_API vlSingle vlContextImageGetBumpmapScale(VLContext *Context, vlUInt uiImage)
+{
+	CContextImage Image(Context, uiImage);
+	if(!Image)
+		return 0.0f;
+
+	return Image->GetBumpmapScale();
+}
+
+VTFLIB_API vlVoid vlContextImageSetBumpmapScale(VLContext *Context, vlUInt uiImage, vlSingle sBumpmapScale)
+{
+	CContextImage Image(Context, uiImage);
+	if(!Image)
+		return;
+
+	Image->SetBumpmapScale(sBumpmapScale);
+}
+
+VTFLIB_API vlVoid vlContextImageGetReflectivity(VLContext *Context, vlUInt uiImage, vlSingle *sX, vlSingle *sY, vlSingle *sZ)
+{
+	CContextImage Image(Context, uiImage);
+	if(!Image)
+		return;
+
+	Image->GetReflectivity(*sX, *sY, *sZ);
+}
+
+VTFLIB_API vlVoid vlContextImageSetReflectivity(VLContext *Context, vlUInt uiImage, vlSingle sX, vlSingle sY, vlSingle sZ)
+{
+	CContextImage Image(Context, uiImage);
+	if(!Image)
+		return;
+
+	Image->SetReflectivity(sX, sY, sZ);
+}
+
+VTFLIB_API VTFImageFormat vlContextImageGetFormat(VLContext *Context, vlUInt uiImage)
+{
+	CContextImage Image(Context, uiImage);
+	if(!Image)
+		return IMAGE_FORMAT_NONE;
+
+	return Image->GetFormat();
+}
+
+VTFLIB_API vlByte *vlContextImageGetData(VLContext *Context, vlUInt uiImage, vlUInt uiFrame, vlUInt uiFace, vlUInt uiSlice, vlUInt uiMipmapLevel)
+{
+	CContextImage Image(Context, uiImage);
+	if(!Image)
+		return 0;
+
+	return Image->GetData(uiFrame, uiFace, uiSlice, uiMipmapLevel);
+}
+
+VTFLIB_API vlVoid vlContextImageSetData(VLContext *Context, vlUInt uiImage, vlUInt uiFrame, vlUInt uiFace, vlUInt uiSlice, vlUInt uiMipmapLevel, vlByte *lpData)
+{
+	CContextImage Image(Context, uiImage);
+	if(!Image)
+		return;
+
+	Image->SetData(uiFrame, uiFace, uiSlice, uiMipmapLevel, lpData);
+}
+
+VTFLIB_API vlBool vlContextImageAdoptData(VLContext *Context, vlUInt uiImage, vlByte *lpImageData, vlUInt uiImageDataSize, PFreeProc pFree, vlVoid *pUserData)
+{
+	CContextImage Image(Context, uiImage);
+	if(!Image)
+		return vlFalse;
+
+	return Image->SetData(lpImageData, uiImageDataSize, pFree, pUserData);
+}
+
+VTFLIB_API vlBool vlContextImageGetHasThumbnail(VLContext *Context, vlUInt uiImage)
+{
+	CContextImage Image(Context, uiImage);
+	if(!Image)
+		return vlFalse;
+
+	return Image->GetHasThumbnail();
+}
+
+VTFLIB_API vlUInt vlContextImageGetThumbnailWidth(VLContext *Context, vlUInt uiImage)
+{
+	CContextImage Image(Context, uiImage);
+	if(!Image)
+		return 0;
+
+	return Image->GetThumbnailWidth();
+}
+
+VTFLIB_API vlUInt vlContextImageGetThumbnailHeight(VLContext *Context, vlUInt uiImage)
+{
+	CContextImage Image(Context, uiImage);
+	if(!Image)
+		return 0;
+
+	return Image->GetThumbnailHeight();
+}
+
+VTFLIB_API VTFImageFormat vlContextImageGetThumbnailFormat(VLContext *Context, vlUInt uiImage)
+{
+	CContextImage Image(Context, uiImage);
+	if(!Image)
+		return IMAGE_FORMAT_NONE;
+
+	return Image->GetThumbnailFormat();
+}
+
+VTFLIB_API vlByte *vlContextImageGetThumbnailData(VLContext *Context, vlUInt uiImage)
+{
+	CContextImage Image(Context, uiImage);
+	if(!Image)
+		return 0;
+
+	return Image->GetThumbnailData();
+}
+
+VTFLIB_API vlVoid vlContextImageSetThumbnailData(VLContext *Context, vlUInt uiImage, vlByte *lpData)
+{
+	CContextImage Image(Context, uiImage);
+	if(!Image)
+		return;
+
+	Image->SetThumbnailData(lpData);
+}
+
+VTFLIB_API vlBool vlContextImageGetSupportsResources(VLContext *Context, vlUInt uiImage)
+{
+	CContextImage Image(Context, uiImage);
+	if(!Image)
+		return vlFalse;
+
+	return Image->GetSupportsResources();
+}
+
+VTFLIB_API vlUInt vlContextImageGetResourceCount(VLContext *Context, vlUInt uiImage)
+{
+	CContextImage Image(Context, uiImage);
+	if(!Image)
+		return 0;
+
+	return Image->GetResourceCount();
+}
+
+VTFLIB_API vlUInt vlContextImageGetResourceType(VLContext *Context, vlUInt uiImage, vlUInt uiIndex)
+{
+	CContextImage Image(Context, uiImage);
+	if(!Image)
+		return 0;
+
+	return Image->GetResourceType(uiIndex);
+}
+
+VTFLIB_API vlBool vlContextImageGetHasResource(VLContext *Context, vlUInt uiImage, vlUInt uiType)
+{
+	CContextImage Image(Context, uiImage);
+	if(!Image)
+		return vlFalse;
+
+	return Image->GetHasResource(uiType);
+}
+
+VTFLIB_API vlVoid *vlContextImageGetResourceData(VLContext *Context, vlUInt uiImage, vlUInt uiType, vlUInt *uiSize)
+{
+	CContextImage Image(Context, uiImage);
+	if(!Image)
+		return 0;
+
+	return Image->GetResourceData(uiType, *uiSize);
+}
+
+VTFLIB_API vlVoid *vlContextImageSetResourceData(VLContext *Context, vlUInt uiImage, vlUInt uiType, vlUInt uiSize, vlVoid *lpData)
+{
+	CContextImage Image(Context, uiImage);
+	if(!Image)
+		return 0;
+
+	return Image->SetResourceData(uiType, uiSize, lpData);
+}
+
+VTFLIB_API vlBool vlContextImageGenerateMipmaps(VLContext *Context, vlUInt uiImage, vlUInt uiFace, vlUInt uiFrame, VTFMipmapFilter MipmapFilter, VTFSharpenFilter SharpenFilter)
+{
+	CContextImage Image(Context, uiImage);
+	if(!Image)
+		return vlFalse;
+
+	return Image->GenerateMipmaps(uiFace, uiFrame, MipmapFilter, SharpenFilter);
+}
+
+VTFLIB_API vlBool vlContextImageGenerateAllMipmaps(VLContext *Context, vlUInt uiImage, VTFMipmapFilter MipmapFilter, VTFSharpenFilter SharpenFilter)
+{
+	CContextImage Image(Context, uiImage);
+	if(!Image)
+		return vlFalse;
+
+	return Image->GenerateMipmaps(MipmapFilter, SharpenFilter);
+}
+
+VTFLIB_API vlBool vlContextImageGenerateThumbnail(VLContext *Context, vlUInt uiImage)
+{
+	CContextImage Image(Context, uiImage);
+	if(!Image)
+		return vlFalse;
+
+	return Image->GenerateThumbnail();
+}
+
+VTFLIB_API vlBool vlContextImageGenerateNormalMap(VLContext *Context, vlUInt uiImage, vlUInt uiFrame, VTFKernelFilter KernelFilter, VTFHeightConversionMethod HeightConversionMethod, VTFNormalAlphaResult NormalAlphaResult)
+{
+	CContextImage Image(Context, uiImage);
+	if(!Image)
+		return vlFalse;
+
+	return Image->GenerateNormalMap(uiFrame, KernelFilter, HeightConversionMethod, NormalAlphaResult);
+}
+
+VTFLIB_API vlBool vlContextImageGenerateAllNormalMaps(VLContext *Context, vlUInt uiImage, VTFKernelFilter KernelFilter, VTFHeightConversionMethod HeightConversionMethod, VTFNormalAlphaResult NormalAlphaResult)
+{
+	CContextImage Image(Context, uiImage);
+	if(!Image)
+		return vlFalse;
+
+	return Image->GenerateNormalMap(KernelFilter, HeightConversionMethod, NormalAlphaResult);
+}
+
+VTFLIB_API vlBool vlContextImageGenerateSphereMap(VLContext *Context, vlUInt uiImage)
+{
+	CContextImage Image(Context, uiImage);
+	if(!Image)
+		return vlFalse;
+
+	return Image->GenerateSphereMap();
+}
+
+VTFLIB_API vlBool vlContextImageComputeReflectivity(VLContext *Context, vlUInt uiImage)
+{
+	CContextImage Image(Context, uiImage);
+	if(!Image)
+		return vlFalse;
+
+	return Image->ComputeReflectivity();
+}
+
+VTFLIB_API vlBool vlContextImageComputeStatistics(VLContext *Context, vlUInt uiImage, vlUInt uiFrame, vlUInt uiFace, vlUInt uiSlice, vlUInt uiMipmapLevel, SVTFImageStatistics *Statistics)
+{
+	CContextImage Image(Context, uiImage);
+	if(!Image)
+		return vlFalse;
+
+	return Image->ComputeStatistics(uiFrame, uiFace, uiSlice, uiMipmapLevel, *Statistics);
+}
+
+VTFLIB_API vlBool vlContextImageComputePreview(VLContext *Context, vlUInt uiImage, vlUInt uiFrame, vlUInt uiFace, vlUInt uiSlice, vlByte *lpDestRGBA8888, vlUInt uiDestWidth, vlUInt uiDestHeight)
+{
+	CContextImage Image(Context, uiImage);
+	if(!Image)
+		return vlFalse;
+
+	return Image->ComputePreview(uiFrame, uiFace, uiSlice, lpDestRGBA8888, uiDestWidth, uiDestHeight);
+}
+
+VTFLIB_API vlBool vlContextImageComputeCRC(VLContext *Context, vlUInt uiImage, vlUInt *uiCRC)
+{
+	CContextImage Image(Context, uiImage);
+	if(!Image)
+		return vlFalse;
+
+	return Image->ComputeCRC(*uiCRC);
+}
+
+VTFLIB_API vlBool vlContextImageConvertToRGBA8888(VLContext *Context, vlByte *lpSource, vlByte *lpDest, vlUInt uiWidth, vlUInt uiHeight, VTFImageFormat SourceFormat)
+{
+	CContext *Instance = CContext::FromHandle(Context);
+	if(Instance == 0)
+		return vlFalse;
+
+	SVTFLibOptions Options;
+	Instance->GetOptions(Options);
+
+	return CVTFFile::ConvertToRGBA8888(lpSource, lpDest, uiWidth, uiHeight, SourceFormat, Options);
+}
+
+VTFLIB_API vlBool vlContextImageConvertFromRGBA8888(VLContext *Context, vlByte *lpSource, vlByte *lpDest, vlUInt uiWidth, vlUInt uiHeight, VTFImageFormat DestFormat)
+{
+	CContext *Instance = CContext::FromHandle(Context);
+	if(Instance == 0)
+		return vlFalse;
+
+	SVTFLibOptions Options;
+	Instance->GetOptions(Options);
+
+	return CVTFFile::ConvertFromRGBA8888(lpSource, lpDest, uiWidth, uiHeight, DestFormat, Options);
+}
+
+VTFLIB_API vlBool vlContextImageConvert(VLContext *Context, vlByte *lpSource, vlByte *lpDest, vlUInt uiWidth, vlUInt uiHeight, VTFImageFormat SourceFormat, VTFImageFormat DestFormat)
+{
+	CContext *Instance = CContext::FromHandle(Context);
+	if(Instance == 0)
+		return vlFalse;
+
+	SVTFLibOptions Options;
+	Instance->GetOptions(Options);
+
+	return CVTFFile::Convert(lpSource, lpDest, uiWidth, uiHeight, SourceFormat, DestFormat, Options);
+}
+
+VTFLIB_API vlBool vlContextImageResize(VLContext *Context, vlByte *lpSourceRGBA8888, vlByte *lpDestRGBA8888, vlUInt uiSourceWidth, vlUInt uiSourceHeight, vlUInt uiDestWidth, vlUInt uiDestHeight, VTFMipmapFilter ResizeFilter, VTFSharpenFilter SharpenFilter)
+{
+	CContext *Instance = CContext::FromHandle(Context);
+	if(Instance == 0)
+		return vlFalse;
+
+	SVTFLibOptions Options;
+	Instance->GetOptions(Options);
+
+	return CVTFFile::Resize(lpSourceRGBA8888, lpDestRGBA8888, uiSourceWidth, uiSourceHeight, uiDestWidth, uiDestHeight, ResizeFilter, SharpenFilter, Options);
+}
@@ -13,6 +13,7 @@
 #define VTFWRAPPER_H
 
 #include "stdafx.h"
+#include "ContextWrapper.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -37,6 +38,8 @@ VTFLIB_API vlVoid vlImageCreateDefaultCreateStructure(SVTFCreateOptions *VTFCrea
 VTFLIB_API vlBool vlImageCreate(vlUInt uiWidth, vlUInt uiHeight, vlUInt uiFrames, vlUInt uiFaces, vlUInt uiSlices, VTFImageFormat ImageFormat, vlBool bThumbnail, vlBool bMipmaps, vlBool bNullImageData);
 VTFLIB_API vlBool vlImageCreateSingle(vlUInt uiWidth, vlUInt uiHeight, vlByte *lpImageDataRGBA8888, SVTFCreateOptions *VTFCreateOptions);
 VTFLIB_API vlBool vlImageCreateMultiple(vlUInt uiWidth, vlUInt uiHeight, vlUInt uiFrames, vlUInt uiFaces, vlUInt uiSlices, vlByte **lpImageDataRGBA8888, SVTFCreateOptions *VTFCreateOptions);
+VTFLIB_API vlBool vlImageCreateFromData(vlUInt uiWidth, vlUInt uiHeight, vlUInt uiFrames, vlUInt uiFaces, vlUInt uiSlices, VTFImageFormat ImageFormat, vlBool bThumbnail, vlBool bMipmaps, vlByte *lpImageData, vlUInt uiImageDataSize, PFreeProc pFree, vlVoid *pUserData);
+VTFLIB_API vlBool vlImageCreateMultipleFromData(vlUInt uiWidth, vlUInt uiHeight, vlUInt uiFrames, vlUInt uiFaces, vlUInt uiSlices, vlByte *lpImageDataRGBA8888, vlUInt uiImageDataSize, PFreeProc pFree, vlVoid *pUserData, SVTFCreateOptions *VTFCreateOptions);
 VTFLIB_API vlVoid vlImageDestroy();
 
 VTFLIB_API vlBool vlImageIsLoaded();
@@ -44,11 +47,20 @@ VTFLIB_API vlBool vlImageIsLoaded();
 VTFLIB_API vlBool vlImageLoad(const vlChar *cFileName, vlBool bHeaderOnly);
 VTFLIB_API vlBool vlImageLoadLump(const vlVoid *lpData, vlUInt uiBufferSize, vlBool bHeaderOnly);
 VTFLIB_API vlBool vlImageLoadProc(vlVoid *pUserData, vlBool bHeaderOnly);
+VTFLIB_API vlBool vlImageLoadHeaderInfo(const vlChar *cFileName, SVTFHeaderInfo *HeaderInfo);
+VTFLIB_API vlBool vlImageLoadHeaderInfoLump(const vlVoid *lpData, vlUInt uiBufferSize, SVTFHeaderInfo *HeaderInfo);
+VTFLIB_API vlBool vlImageVerify(const vlChar *cFileName, vlBool *bHasCRC);
+VTFLIB_API vlBool vlImageVerifyLump(const vlVoid *lpData, vlUInt uiBufferSize, vlBool *bHasCRC);
 
 VTFLIB_API vlBool vlImageSave(const vlChar *cFileName);
 VTFLIB_API vlBool vlImageSaveLump(vlVoid *lpData, vlUInt uiBufferSize, vlUInt *uiSize);
 VTFLIB_API vlBool vlImageSaveProc(vlVoid *pUserData);
 
+VTFLIB_API vlBool vlImageLoadDDS(const vlChar *cFileName);
+VTFLIB_API vlBool vlImageLoadDDSLump(const vlVoid *lpData, vlUInt uiBufferSize);
+VTFLIB_API vlBool vlImageSaveDDS(const vlChar *cFileName);
+VTFLIB_API vlBool vlImageSaveDDSLump(vlVoid *lpData, vlUInt uiBufferSize, vlUInt *uiSize);
+
 //
 // Image routines.
 //
@@ -86,6 +98,7 @@ VTFLIB_API VTFImageFormat vlImageGetFormat();
 
 VTFLIB_API vlByte *vlImageGetData(vlUInt uiFrame, vlUInt uiFace, vlUInt uiSlice, vlUInt uiMipmapLevel);
 VTFLIB_API vlVoid vlImageSetData(vlUInt uiFrame, vlUInt uiFace, vlUInt uiSlice, vlUInt uiMipmapLevel, vlByte *lpData);
+VTFLIB_API vlBool vlImageAdoptData(vlByte *lpImageData, vlUInt uiImageDataSize, PFreeProc pFree, vlVoid *pUserData);
 
 //
 // Thumbnail routines.
@@ -129,6 +142,9 @@ VTFLIB_API vlBool vlImageGenerateAllNormalMaps(VTFKernelFilter KernelFilter, VTF
 VTFLIB_API vlBool vlImageGenerateSphereMap();
 
 VTFLIB_API vlBool vlImageComputeReflectivity();
+VTFLIB_API vlBool vlImageComputeStatistics(vlUInt uiFrame, vlUInt uiFace, vlUInt uiSlice, vlUInt uiMipmapLevel, SVTFImageStatistics *Statistics);
+VTFLIB_API vlBool vlImageComputePreview(vlUInt uiFrame, vlUInt uiFace, vlUInt uiSlice, vlByte *lpDestRGBA8888, vlUInt uiDestWidth, vlUInt uiDestHeight);
+VTFLIB_API vlBool vlImageComputeCRC(vlUInt *uiCRC);
 
 //
 // Conversion routines.
@@ -154,9 +170,141 @@ VTFLIB_API vlBool vlImageResize(vlByte *lpSourceRGBA8888, vlByte *lpDestRGBA8888
 
 VTFLIB_API vlVoid vlImageCorrectImageGamma(vlByte *lpImageDataRGBA8888, vlUInt uiWidth, vlUInt uiHeight, vlSingle sGammaCorrection);
 VTFLIB_API vlVoid vlImageComputeImageReflectivity(vlByte *lpImageDataRGBA8888, vlUInt uiWidth, vlUInt uiHeight, vlSingle *sX, vlSingle *sY, vlSingle *sZ);
+VTFLIB_API vlBool vlImageComputeImageStatistics(vlByte *lpSource, vlUInt uiWidth, vlUInt uiHeight, VTFImageFormat SourceFormat, SVTFImageStatistics *Statistics);
+VTFLIB_API vlBool vlImageComputeImagePreview(vlByte *lpSource, vlUInt uiWidth, vlUInt uiHeight, VTFImageFormat SourceFormat, vlByte *lpDestRGBA8888, vlUInt uiDestWidth, vlUInt uiDestHeight);
 
 VTFLIB_API vlVoid vlImageFlipImage(vlByte *lpImageDataRGBA8888, vlUInt uiWidth, vlUInt uiHeight);
 VTFLIB_API vlVoid vlImageMirrorImage(vlByte *lpImageDataRGBA8888, vlUInt uiWidth, vlUInt uiHeight);
+VTFLIB_API vlBool vlImageTransformImage(vlByte *lpSource, vlByte *lpDest, vlUInt uiWidth, vlUInt uiHeight, VTFImageFormat ImageFormat, VTFImageTransform Transform);
+
+//
+// Context memory managment routines.
+//
+
+VTFLIB_API vlBool vlContextCreateImage(VLContext *Context, vlUInt *uiImage);
+VTFLIB_API vlVoid vlContextDeleteImage(VLContext *Context, vlUInt uiImage);
+
+//
+// Context library routines.
+//
+
+VTFLIB_API vlBool vlContextImageCreate(VLContext *Context, vlUInt uiImage, vlUInt uiWidth, vlUInt uiHeight, vlUInt uiFrames, vlUInt uiFaces, vlUInt uiSlices, VTFImageFormat ImageFormat, vlBool bThumbnail, vlBool bMipmaps, vlBool bNullImageData);
+VTFLIB_API vlBool vlContextImageCreateSingle(VLContext *Context, vlUInt uiImage, vlUInt uiWidth, vlUInt uiHeight, vlByte *lpImageDataRGBA8888, SVTFCreateOptions *VTFCreateOptions);
+VTFLIB_API vlBool vlContextImageCreateMultiple(VLContext *Context, vlUInt uiImage, vlUInt uiWidth, vlUInt uiHeight, vlUInt uiFrames, vlUInt uiFaces, vlUInt uiSlices, vlByte **lpImageDataRGBA8888, SVTFCreateOptions *VTFCreateOptions);
+VTFLIB_API vlBool vlContextImageCreateFromData(VLContext *Context, vlUInt uiImage, vlUInt uiWidth, vlUInt uiHeight, vlUInt uiFrames, vlUInt uiFaces, vlUInt uiSlices, VTFImageFormat ImageFormat, vlBool bThumbnail, vlBool bMipmaps, vlByte *lpImageData, vlUInt uiImageDataSize, PFreeProc pFree, vlVoid *pUserData);
+VTFLIB_API vlBool vlContextImageCreateMultipleFromData(VLContext *Context, vlUInt uiImage, vlUInt uiWidth, vlUInt uiHeight, vlUInt uiFrames, vlUInt uiFaces, vlUInt uiSlices, vlByte *lpImageDataRGBA8888, vlUInt uiImageDataSize, PFreeProc pFree, vlVoid *pUserData, SVTFCreateOptions *VTFCreateOptions);
+VTFLIB_API vlVoid vlContextImageDestroy(VLContext *Context, vlUInt uiImage);
+
+VTFLIB_API vlBool vlContextImageIsLoaded(VLContext *Context, vlUInt uiImage);
+
+VTFLIB_API vlBool vlContextImageLoad(VLContext *Context, vlUInt uiImage, const vlChar *cFileName, vlBool bHeaderOnly);
+VTFLIB_API vlBool vlContextImageLoadLump(VLContext *Context, vlUInt uiImage, const vlVoid *lpData, vlUInt uiBufferSize, vlBool bHeaderOnly);
+VTFLIB_API vlBool vlContextImageLoadProc(VLContext *Context, vlUInt uiImage, vlVoid *pUserData, vlBool bHeaderOnly);
+
+VTFLIB_API vlBool vlContextImageSave(VLContext *Context, vlUInt uiImage, const vlChar *cFileName);
+VTFLIB_API vlBool vlContextImageSaveLump(VLContext *Context, vlUInt uiImage, vlVoid *lpData, vlUInt uiBufferSize, vlUInt *uiSize);
+VTFLIB_API vlBool vlContextImageSaveProc(VLContext *Context, vlUInt uiImage, vlVoid *pUserData);
+
+VTFLIB_API vlBool vlContextImageLoadDDS(VLContext *Context, vlUInt uiImage, const vlChar *cFileName);
+VTFLIB_API vlBool vlContextImageLoadDDSLump(VLContext *Context, vlUInt uiImage, const vlVoid *lpData, vlUInt uiBufferSize);
+VTFLIB_API vlBool vlContextImageSaveDDS(VLContext *Context, vlUInt uiImage, const vlChar *cFileName);
+VTFLIB_API vlBool vlContextImageSaveDDSLump(VLContext *Context, vlUInt uiImage, vlVoid *lpData, vlUInt uiBufferSize, vlUInt *uiSize);
+
+//
+// Context image routines.
+//
+
+VTFLIB_API vlUInt vlContextImageGetHasImage(VLContext *Context, vlUInt uiImage);
+
+VTFLIB_API vlUInt vlContextImageGetMajorVersion(VLContext *Context, vlUInt uiImage);
+VTFLIB_API vlUInt vlContextImageGetMinorVersion(VLContext *Context, vlUInt uiImage);
+VTFLIB_API vlUInt vlContextImageGetSize(VLContext *Context, vlUInt uiImage);
+
+VTFLIB_API vlUInt vlContextImageGetWidth(VLContext *Context, vlUInt uiImage);
+VTFLIB_API vlUInt vlContextImageGetHeight(VLContext *Context, vlUInt uiImage);
+VTFLIB_API vlUInt vlContextImageGetDepth(VLContext *Context, vlUInt uiImage);
+
+VTFLIB_API vlUInt vlContextImageGetFrameCount(VLContext *Context, vlUInt uiImage);
+VTFLIB_API vlUInt vlContextImageGetFaceCount(VLContext *Context, vlUInt uiImage);
+VTFLIB_API vlUInt vlContextImageGetMipmapCount(VLContext *Context, vlUInt uiImage);
+
+VTFLIB_API vlUInt vlContextImageGetStartFrame(VLContext *Context, vlUInt uiImage);
+VTFLIB_API vlVoid vlContextImageSetStartFrame(VLContext *Context, vlUInt uiImage, vlUInt uiStartFrame);
+
+VTFLIB_API vlUInt vlContextImageGetFlags(VLContext *Context, vlUInt uiImage);
+VTFLIB_API vlVoid vlContextImageSetFlags(VLContext *Context, vlUInt uiImage, vlUInt uiFlags);
+
+VTFLIB_API vlBool vlContextImageGetFlag(VLContext *Context, vlUInt uiImage, VTFImageFlag ImageFlag);
+VTFLIB_API vlVoid vlContextImageSetFlag(VLContext *Context, vlUInt uiImage, VTFImageFlag ImageFlag, vlBool bState);
+
+VTFLIB_API vlSingle vlContextImageGetBumpmapScale(VLContext *Context, vlUInt uiImage);
+VTFLIB_API vlVoid vlContextImageSetBumpmapScale(VLContext *Context, vlUInt uiImage, vlSingle sBumpmapScale);
+
+VTFLIB_API vlVoid vlContextImageGetReflectivity(VLContext *Context, vlUInt uiImage, vlSingle *sX, vlSingle *sY, vlSingle *sZ);
+VTFLIB_API vlVoid vlContextImageSetReflectivity(VLContext *Context, vlUInt uiImage, vlSingle sX, vlSingle sY, vlSingle sZ);
+
+VTFLIB_API VTFImageFormat vlContextImageGetFormat(VLContext *Context, vlUInt uiImage);
+
+VTFLIB_API vlByte *vlContextImageGetData(VLContext *Context, vlUInt uiImage, vlUInt uiFrame, vlUInt uiFace, vlUInt uiSlice, vlUInt uiMipmapLevel);
+VTFLIB_API vlVoid vlContextImageSetData(VLContext *Context, vlUInt uiImage, vlUInt uiFrame, vlUInt uiFace, vlUInt uiSlice, vlUInt uiMipmapLevel, vlByte *lpData);
+VTFLIB_API vlBool vlContextImageAdoptData(VLContext *Context, vlUInt uiImage, vlByte *lpImageData, vlUInt uiImageDataSize, PFreeProc pFree, vlVoid *pUserData);
+
+//
+// Context thumbnail routines.
+//
+
+VTFLIB_API vlBool vlContextImageGetHasThumbnail(VLContext *Context, vlUInt uiImage);
+
+VTFLIB_API vlUInt vlContextImageGetThumbnailWidth(VLContext *Context, vlUInt uiImage);
+VTFLIB_API vlUInt vlContextImageGetThumbnailHeight(VLContext *Context, vlUInt uiImage);
+
+VTFLIB_API VTFImageFormat vlContextImageGetThumbnailFormat(VLContext *Context, vlUInt uiImage);
+
+VTFLIB_API vlByte *vlContextImageGetThumbnailData(VLContext *Context, vlUInt uiImage);
+VTFLIB_API vlVoid vlContextImageSetThumbnailData(VLContext *Context, vlUInt uiImage, vlByte *lpData);
+
+//
+// Context resource routines.
+//
+
+VTFLIB_API vlBool vlContextImageGetSupportsResources(VLContext *Context, vlUInt uiImage);
+
+VTFLIB_API vlUInt vlContextImageGetResourceCount(VLContext *Context, vlUInt uiImage);
+VTFLIB_API vlUInt vlContextImageGetResourceType(VLContext *Context, vlUInt uiImage, vlUInt uiIndex);
+VTFLIB_API vlBool vlContextImageGetHasResource(VLContext *Context, vlUInt uiImage, vlUInt uiType);
+
+VTFLIB_API vlVoid *vlContextImageGetResourceData(VLContext *Context, vlUInt uiImage, vlUInt uiType, vlUInt *uiSize);
+VTFLIB_API vlVoid *vlContextImageSetResourceData(VLContext *Context, vlUInt uiImage, vlUInt uiType, vlUInt uiSize, vlVoid *lpData);
+
+//
+// Context helper routines.
+//
+
+VTFLIB_API vlBool vlContextImageGenerateMipmaps(VLContext *Context, vlUInt uiImage, vlUInt uiFace, vlUInt uiFrame, VTFMipmapFilter MipmapFilter, VTFSharpenFilter SharpenFilter);
+VTFLIB_API vlBool vlContextImageGenerateAllMipmaps(VLContext *Context, vlUInt uiImage, VTFMipmapFilter MipmapFilter, VTFSharpenFilter SharpenFilter);
+
+VTFLIB_API vlBool vlContextImageGenerateThumbnail(VLContext *Context, vlUInt uiImage);
+
+VTFLIB_API vlBool vlContextImageGenerateNormalMap(VLContext *Context, vlUInt uiImage, vlUInt uiFrame, VTFKernelFilter KernelFilter, VTFHeightConversionMethod HeightConversionMethod, VTFNormalAlphaResult NormalAlphaResult);
+VTFLIB_API vlBool vlContextImageGenerateAllNormalMaps(VLContext *Context, vlUInt uiImage, VTFKernelFilter KernelFilter, VTFHeightConversionMethod HeightConversionMethod, VTFNormalAlphaResult NormalAlphaResult);
+
+VTFLIB_API vlBool vlContextImageGenerateSphereMap(VLContext *Context, vlUInt uiImage);
+
+VTFLIB_API vlBool vlContextImageComputeReflectivity(VLContext *Context, vlUInt uiImage);
+VTFLIB_API vlBool vlContextImageComputeStatistics(VLContext *Context, vlUInt uiImage, vlUInt uiFrame, vlUInt uiFace, vlUInt uiSlice, vlUInt uiMipmapLevel, SVTFImageStatistics *Statistics);
+VTFLIB_API vlBool vlContextImageComputePreview(VLContext *Context, vlUInt uiImage, vlUInt uiFrame, vlUInt uiFace, vlUInt uiSlice, vlByte *lpDestRGBA8888, vlUInt uiDestWidth, vlUInt uiDestHeight);
+VTFLIB_API vlBool vlContextImageComputeCRC(VLContext *Context, vlUInt uiImage, vlUInt *uiCRC);
+
+//
+// Context conversion routines.  (Use the context's options.)
+//
+
+VTFLIB_API vlBool vlContextImageConvertToRGBA8888(VLContext *Context, vlByte *lpSource, vlByte *lpDest, vlUInt uiWidth, vlUInt uiHeight, VTFImageFormat SourceFormat);
+VTFLIB_API vlBool vlContextImageConvertFromRGBA8888(VLContext *Context, vlByte *lpSource, vlByte *lpDest, vlUInt uiWidth, vlUInt uiHeight, VTFImageFormat DestFormat);
+
+VTFLIB_API vlBool vlContextImageConvert(VLContext *Context, vlByte *lpSource, vlByte *lpDest, vlUInt uiWidth, vlUInt uiHeight, VTFImageFormat SourceFormat, VTFImageFormat DestFormat);
+
+VTFLIB_API vlBool vlContextImageResize(VLContext *Context, vlByte *lpSourceRGBA8888, vlByte *lpDestRGBA8888, vlUInt uiSourceWidth, vlUInt uiSourceHeight, vlUInt uiDestWidth, vlUInt uiDestHeight, VTFMipmapFilter ResizeFilter, VTFSharpenFilter SharpenFilter);
 
 #ifdef __cplusplus
 }
@@ -26,7 +26,7 @@ namespace VTFLib
 				virtual vlBool Opened() const = 0;
 
 				virtual vlBool Open() = 0;
-				virtual vlVoid Close() = 0;
+				virtual vlBool Close() = 0;
 
 				virtual vlUInt GetStreamSize() const = 0;
 				virtual vlUInt GetStreamPointer() const = 0;
@@ -7,6 +7,7 @@
  */
 
 #include "Writer.h"
+#include "BufferedWriter.h"
 #include "FileWriter.h"
 #include "MemoryWriter.h"
 #include "ProcWriter.h"
\ No newline at end of file
@@ -20,10 +20,14 @@
 #ifndef STDAFX_H
 #define STDAFX_H
 
-#ifdef VTFLIB_EXPORTS
-#	define VTFLIB_API __declspec(dllexport)
+#ifdef _WIN32
+#	ifdef VTFLIB_EXPORTS
+#		define VTFLIB_API __declspec(dllexport)
+#	else
+#		define VTFLIB_API __declspec(dllimport)
+#	endif
 #else
-#	define VTFLIB_API __declspec(dllimport)
+#	define VTFLIB_API __attribute__((visibility("default")))
 #endif
 
 // Custom data types
@@ -40,10 +44,18 @@ typedef float			vlSingle;			//!< Floating point number
 typedef double			vlDouble;			//!< Double number
 typedef void			vlVoid;				//!< Void value.
 
+#ifdef _MSC_VER
 typedef unsigned __int8		vlUInt8;
 typedef unsigned __int16	vlUInt16;
 typedef unsigned __int32	vlUInt32;
 typedef unsigned __int64	vlUInt64;
+#else
+#	include <stdint.h>
+typedef uint8_t				vlUInt8;
+typedef uint16_t			vlUInt16;
+typedef uint32_t			vlUInt32;
+typedef uint64_t			vlUInt64;
+#endif
 
 typedef vlSingle		vlFloat;			//!< Floating point number (same as vlSingled).
 
@@ -55,8 +67,16 @@ typedef vlSingle		vlFloat;			//!< Floating point number (same as vlSingled).
 #	define _CRT_NONSTDC_NO_DEPRECATE
 #endif
 
-#define WIN32_LEAN_AND_MEAN
-#include <windows.h>
+#ifdef _WIN32
+#	define WIN32_LEAN_AND_MEAN
+#	include <windows.h>
+#else
+// Seek origins, as the Win32 API numbers them.
+#	define FILE_BEGIN	0
+#	define FILE_CURRENT	1
+#	define FILE_END		2
+#endif
+#include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <assert.h>
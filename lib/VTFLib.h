@@ -12,11 +12,17 @@
 #ifndef VTFLIB_H
 #define VTFLIB_H
 
+#ifdef _WIN32
 #ifdef VTFLIB_EXPORTS
 #define VTFLIB_API __declspec(dllexport)
 #else
 #define VTFLIB_API __declspec(dllimport)
 #endif
+#else
+#define VTFLIB_API __attribute__((visibility("default")))
+#endif
+
+#include <stddef.h>
 
 typedef unsigned char	vlBool;
 typedef char			vlChar;
@@ -31,6 +37,19 @@ typedef float			vlSingle;
 typedef double			vlDouble;
 typedef void			vlVoid;
 
+#ifdef _MSC_VER
+typedef unsigned __int8		vlUInt8;
+typedef unsigned __int16	vlUInt16;
+typedef unsigned __int32	vlUInt32;
+typedef unsigned __int64	vlUInt64;
+#else
+#include <stdint.h>
+typedef uint8_t				vlUInt8;
+typedef uint16_t			vlUInt16;
+typedef uint32_t			vlUInt32;
+typedef uint64_t			vlUInt64;
+#endif
+
 typedef vlSingle		vlFloat;
 
 #define vlFalse			0
@@ -80,7 +99,14 @@ typedef enum tagVTFLibOption
 	VTFLIB_XSHARPEN_STRENGTH,
 	VTFLIB_XSHARPEN_THRESHOLD,
 
-	VTFLIB_VMT_PARSE_MODE
+	VTFLIB_VMT_PARSE_MODE,
+
+	VTFLIB_WRITE_CRC,
+
+	VTFLIB_STATS,
+	VTFLIB_TRACE,
+
+	VTFLIB_LARGE_PAGES
 } VTFLibOption;
 
 typedef enum tagVTFImageFormat
@@ -282,6 +308,27 @@ typedef enum tagVTFResizeMethod
 	RESIZE_COUNT
 } VTFResizeMethod;
 
+typedef enum tagVTFAlphaUsage
+{
+	ALPHA_USAGE_NONE = 0,
+	ALPHA_USAGE_ONEBIT,
+	ALPHA_USAGE_EIGHTBIT,
+	ALPHA_USAGE_COUNT
+} VTFAlphaUsage;
+
+typedef enum tagVTFImageTransform
+{
+	IMAGE_TRANSFORM_NONE = 0,
+	IMAGE_TRANSFORM_ROTATE_90,
+	IMAGE_TRANSFORM_ROTATE_180,
+	IMAGE_TRANSFORM_ROTATE_270,
+	IMAGE_TRANSFORM_FLIP,
+	IMAGE_TRANSFORM_MIRROR,
+	IMAGE_TRANSFORM_TRANSPOSE,
+	IMAGE_TRANSFORM_TRANSVERSE,
+	IMAGE_TRANSFORM_COUNT
+} VTFImageTransform;
+
 #define MAKE_VTF_RSRC_ID(a, b, c) ((vlUInt)(((vlByte)a) | ((vlByte)b << 8) | ((vlByte)c << 16)))
 #define MAKE_VTF_RSRC_IDF(a, b, c, d) ((vlUInt)(((vlByte)a) | ((vlByte)b << 8) | ((vlByte)c << 16) | ((vlByte)d << 24)))
 
@@ -299,6 +346,7 @@ typedef enum tagVTFResourceEntryType
 	VTF_RSRC_TEXTURE_LOD_SETTINGS = MAKE_VTF_RSRC_IDF('L', 'O', 'D', RSRCF_HAS_NO_DATA_CHUNK),
 	VTF_RSRC_TEXTURE_SETTINGS_EX = MAKE_VTF_RSRC_IDF('T', 'S', 'O', RSRCF_HAS_NO_DATA_CHUNK),
 	VTF_RSRC_KEY_VALUE_DATA = MAKE_VTF_RSRC_ID('K', 'V', 'D'),
+	VTF_RSRC_IMAGE_CRC = MAKE_VTF_RSRC_IDF('I', 'C', 'R', RSRCF_HAS_NO_DATA_CHUNK),
 	VTF_RSRC_MAX_DICTIONARY_ENTRIES = 32
 } VTFResourceEntryType;
 
@@ -380,6 +428,50 @@ typedef struct tagSVTFCreateOptions
 	vlBool bSphereMap;									//!< Generate a sphere map for six faced environment maps.
 } SVTFCreateOptions;
 
+typedef struct tagSVTFImageStatistics
+{
+	vlUInt uiPixelCount;								//!< Number of pixels analysed.
+
+	vlByte bMinimum[4];									//!< RGBA channel minimums.
+	vlByte bMaximum[4];									//!< RGBA channel maximums.
+	vlSingle sMean[4];									//!< RGBA channel means (0 to 255).
+	vlUInt uiHistogram[4][256];							//!< RGBA channel histograms.
+
+	vlSingle sReflectivity[3];							//!< Linear light (gamma 2.2) RGB average, as stored in the header.
+	vlSingle sLogAverageLuminance;						//!< Log average luminance (0 to 1).  For FP16 sources this is the tone mapping key input.
+
+	VTFAlphaUsage AlphaUsage;							//!< How the alpha channel is used.
+	vlBool bConstant;									//!< Every pixel is the same colour.
+} SVTFImageStatistics;
+
+typedef struct tagSVTFHeaderInfo
+{
+	vlUInt uiFileSize;									//!< Size of the file in bytes.
+	vlUInt uiVersion[2];								//!< File version.
+	vlUInt uiHeaderSize;								//!< Size of the header in bytes.
+
+	vlUInt uiWidth;										//!< Width of the largest mipmap.
+	vlUInt uiHeight;									//!< Height of the largest mipmap.
+	vlUInt uiDepth;										//!< Depth of the largest mipmap.
+	vlUInt uiFrameCount;								//!< Number of frames.
+	vlUInt uiStartFrame;								//!< First frame of the animation.
+	vlUInt uiFaceCount;									//!< Number of faces.
+	vlUInt uiMipmapCount;								//!< Number of mipmaps.
+	vlUInt uiFlags;										//!< Image flags (see VTFImageFlag).
+	VTFImageFormat ImageFormat;							//!< Image format.
+
+	VTFImageFormat ThumbnailFormat;						//!< Thumbnail format or IMAGE_FORMAT_NONE.
+	vlUInt uiThumbnailWidth;							//!< Thumbnail width.
+	vlUInt uiThumbnailHeight;							//!< Thumbnail height.
+
+	vlSingle sReflectivity[3];							//!< Reflectivity vector.
+	vlSingle sBumpScale;								//!< Bump map scale.
+
+	vlUInt uiResourceCount;								//!< Number of resource directory entries.
+	vlUInt uiResourceTypes[VTF_RSRC_MAX_DICTIONARY_ENTRIES];	//!< Resource types (see VTFResourceEntryType).
+	vlUInt uiResourceData[VTF_RSRC_MAX_DICTIONARY_ENTRIES];	//!< Resource data; the value itself or the offset of its data chunk.
+} SVTFHeaderInfo;
+
 typedef struct tagSVTFTextureLODControlResource
 {
 	vlByte ResolutionClampU;
@@ -388,6 +480,88 @@ typedef struct tagSVTFTextureLODControlResource
 } SVTFTextureLODControlResource;
 #pragma pack()
 
+//! VTFLib processing options struct.
+/*!
+	The SVTFLibOptions struct holds every tunable used while converting,
+	compressing, re-sizing and parsing.  The library keeps one process wide
+	copy (set with vlSetInteger() and friends) which is used when no other
+	options are given.  Objects and functions that take an SVTFLibOptions
+	use it instead, so several threads can process images at the same time
+	with different settings.
+
+	\see vlGetOptions()
+	\see CVTFFile::SetOptions()
+*/
+#pragma pack(1)
+typedef struct tagSVTFLibOptions
+{
+	vlUInt uiDXTQuality;				//!< DXT compression quality (see VTFDXTQuality).
+
+	vlSingle sLuminanceWeightR;			//!< Red weight used when converting to luminance formats.
+	vlSingle sLuminanceWeightG;			//!< Green weight used when converting to luminance formats.
+	vlSingle sLuminanceWeightB;			//!< Blue weight used when converting to luminance formats.
+
+	vlUShort uiBlueScreenMaskR;			//!< Blue screen mask red value.
+	vlUShort uiBlueScreenMaskG;			//!< Blue screen mask green value.
+	vlUShort uiBlueScreenMaskB;			//!< Blue screen mask blue value.
+
+	vlUShort uiBlueScreenClearR;		//!< Blue screen clear red value.
+	vlUShort uiBlueScreenClearG;		//!< Blue screen clear green value.
+	vlUShort uiBlueScreenClearB;		//!< Blue screen clear blue value.
+
+	vlSingle sFP16HDRKey;				//!< FP16 HDR tone mapping key.
+	vlSingle sFP16HDRShift;				//!< FP16 HDR tone mapping shift.
+	vlSingle sFP16HDRGamma;				//!< FP16 HDR tone mapping gamma.
+
+	vlSingle sUnsharpenRadius;			//!< Unsharpen mask radius.
+	vlSingle sUnsharpenAmount;			//!< Unsharpen mask amount.
+	vlSingle sUnsharpenThreshold;		//!< Unsharpen mask threshold.
+
+	vlSingle sXSharpenStrength;			//!< XSharpen strength.
+	vlSingle sXSharpenThreshold;		//!< XSharpen threshold.
+
+	vlUInt uiVMTParseMode;				//!< VMT parsing mode (see VMTParseMode).
+
+	vlBool bWriteCRC;					//!< Add an image data CRC resource when saving v7.3+ images.
+} SVTFLibOptions;
+#pragma pack()
+
+typedef enum tagVTFLibStat
+{
+	VTFLIB_STAT_CONVERT = 0,
+	VTFLIB_STAT_DXT_DECODE,
+	VTFLIB_STAT_DXT_ENCODE,
+	VTFLIB_STAT_RESIZE,
+	VTFLIB_STAT_LOAD_FILE,
+	VTFLIB_STAT_LOAD_MEMORY,
+	VTFLIB_STAT_LOAD_PROC,
+	VTFLIB_STAT_SAVE_FILE,
+	VTFLIB_STAT_SAVE_MEMORY,
+	VTFLIB_STAT_SAVE_PROC,
+	VTFLIB_STAT_VMT_PARSE,
+	VTFLIB_STAT_VMT_LOAD_BINARY,
+	VTFLIB_STAT_LOAD_PACKAGE,
+	VTFLIB_STAT_LOAD_DDS,
+	VTFLIB_STAT_SAVE_DDS,
+	VTFLIB_STAT_COUNT
+} VTFLibStat;
+
+#pragma pack(1)
+typedef struct tagSVTFLibStat
+{
+	vlUInt64 uiCalls;
+	vlUInt64 uiBytes;
+	vlUInt64 uiNanoseconds;
+} SVTFLibStat;
+
+typedef struct tagSVTFLibAllocationStats
+{
+	vlUInt64 uiAllocations;
+	vlUInt64 uiBytes;
+	vlUInt64 uiPeakBytes;
+} SVTFLibAllocationStats;
+#pragma pack()
+
 typedef enum tagVLProc
 {
 	PROC_READ_CLOSE = 0,
@@ -412,6 +586,19 @@ typedef enum tagVLSeekMode
 	SEEK_MODE_END
 } VLSeekMode;
 
+#define MATERIAL_GRAPH_INVALID_INDEX	0xffffffff
+
+typedef enum tagMaterialReferenceType
+{
+	MATERIAL_REFERENCE_BASETEXTURE = 0,
+	MATERIAL_REFERENCE_BASETEXTURE2,
+	MATERIAL_REFERENCE_BUMPMAP,
+	MATERIAL_REFERENCE_BUMPMAP2,
+	MATERIAL_REFERENCE_ENVMAP,
+	MATERIAL_REFERENCE_INCLUDE,
+	MATERIAL_REFERENCE_COUNT
+} MaterialReferenceType;
+
 typedef vlVoid (*PReadCloseProc)(vlVoid *);
 typedef vlBool (*PReadOpenProc)(vlVoid *);
 typedef vlUInt (*PReadReadProc)(vlVoid *, vlUInt, vlVoid *);
@@ -426,6 +613,9 @@ typedef vlUInt (*PWriteSeekProc)(vlLong, VLSeekMode, vlVoid *);
 typedef vlUInt (*PWriteSizeProc)(vlVoid *);
 typedef vlUInt (*PWriteTellProc)(vlVoid *);
 
+typedef vlVoid *(*PAllocateProc)(vlUInt64 uiSize, vlUInt uiAlignment, vlVoid *pUserData);
+typedef vlVoid (*PFreeProc)(vlVoid *lpData, vlVoid *pUserData);
+
 #ifdef __cplusplus
 }
 #endif
@@ -459,6 +649,27 @@ VTFLIB_API vlVoid vlSetInteger(VTFLibOption Option, vlInt iValue);
 VTFLIB_API vlSingle vlGetFloat(VTFLibOption Option);
 VTFLIB_API vlVoid vlSetFloat(VTFLibOption Option, vlSingle sValue);
 
+VTFLIB_API vlVoid vlGetDefaultOptions(SVTFLibOptions *Options);
+VTFLIB_API vlVoid vlGetOptions(SVTFLibOptions *Options);
+VTFLIB_API vlVoid vlSetOptions(const SVTFLibOptions *Options);
+
+//
+// Stats
+//
+
+VTFLIB_API vlBool vlGetStats(VTFLibStat Stat, SVTFLibStat *Stats);
+VTFLIB_API vlBool vlGetConvertStats(VTFImageFormat SourceFormat, VTFImageFormat DestFormat, SVTFLibStat *Stats);
+VTFLIB_API vlVoid vlGetAllocationStats(SVTFLibAllocationStats *Stats);
+VTFLIB_API vlVoid vlResetStats();
+VTFLIB_API vlBool vlWriteTrace(const vlChar *cFileName);
+
+//
+// Memory
+//
+
+VTFLIB_API vlBool vlSetAllocator(PAllocateProc pAllocate, PFreeProc pFree, vlVoid *pUserData);
+VTFLIB_API vlVoid vlFreeScratch();
+
 //
 // Proc
 //
@@ -466,6 +677,21 @@ VTFLIB_API vlVoid vlSetFloat(VTFLibOption Option, vlSingle sValue);
 VTFLIB_API vlVoid vlSetProc(VLProc Proc, vlVoid *pProc);
 VTFLIB_API vlVoid *vlGetProc(VLProc Proc);
 
+//
+// Contexts own their own images, materials and options.  Unlike the bound
+// image API, different threads may use different images of the same context
+// at the same time, and create or delete handles concurrently.  A single
+// image or material must still only be used by one thread at a time.
+//
+
+typedef struct tagVLContext VLContext;
+
+VTFLIB_API vlBool vlCreateContext(VLContext **Context);
+VTFLIB_API vlVoid vlDeleteContext(VLContext *Context);
+
+VTFLIB_API vlBool vlContextGetOptions(VLContext *Context, SVTFLibOptions *Options);
+VTFLIB_API vlBool vlContextSetOptions(VLContext *Context, const SVTFLibOptions *Options);
+
 //
 // Memory managment routines.
 //
@@ -485,6 +711,8 @@ VTFLIB_API vlVoid vlImageCreateDefaultCreateStructure(SVTFCreateOptions *VTFCrea
 VTFLIB_API vlBool vlImageCreate(vlUInt uiWidth, vlUInt uiHeight, vlUInt uiFrames, vlUInt uiFaces, vlUInt uiSlices, VTFImageFormat ImageFormat, vlBool bThumbnail, vlBool bMipmaps, vlBool bNullImageData);
 VTFLIB_API vlBool vlImageCreateSingle(vlUInt uiWidth, vlUInt uiHeight, vlByte *lpImageDataRGBA8888, SVTFCreateOptions *VTFCreateOptions);
 VTFLIB_API vlBool vlImageCreateMultiple(vlUInt uiWidth, vlUInt uiHeight, vlUInt uiFrames, vlUInt uiFaces, vlUInt uiSlices, vlByte **lpImageDataRGBA8888, SVTFCreateOptions *VTFCreateOptions);
+VTFLIB_API vlBool vlImageCreateFromData(vlUInt uiWidth, vlUInt uiHeight, vlUInt uiFrames, vlUInt uiFaces, vlUInt uiSlices, VTFImageFormat ImageFormat, vlBool bThumbnail, vlBool bMipmaps, vlByte *lpImageData, vlUInt uiImageDataSize, PFreeProc pFree, vlVoid *pUserData);
+VTFLIB_API vlBool vlImageCreateMultipleFromData(vlUInt uiWidth, vlUInt uiHeight, vlUInt uiFrames, vlUInt uiFaces, vlUInt uiSlices, vlByte *lpImageDataRGBA8888, vlUInt uiImageDataSize, PFreeProc pFree, vlVoid *pUserData, SVTFCreateOptions *VTFCreateOptions);
 VTFLIB_API vlVoid vlImageDestroy();
 
 VTFLIB_API vlBool vlImageIsLoaded();
@@ -492,11 +720,20 @@ VTFLIB_API vlBool vlImageIsLoaded();
 VTFLIB_API vlBool vlImageLoad(const vlChar *cFileName, vlBool bHeaderOnly);
 VTFLIB_API vlBool vlImageLoadLump(const vlVoid *lpData, vlUInt uiBufferSize, vlBool bHeaderOnly);
 VTFLIB_API vlBool vlImageLoadProc(vlVoid *pUserData, vlBool bHeaderOnly);
+VTFLIB_API vlBool vlImageLoadHeaderInfo(const vlChar *cFileName, SVTFHeaderInfo *HeaderInfo);
+VTFLIB_API vlBool vlImageLoadHeaderInfoLump(const vlVoid *lpData, vlUInt uiBufferSize, SVTFHeaderInfo *HeaderInfo);
+VTFLIB_API vlBool vlImageVerify(const vlChar *cFileName, vlBool *bHasCRC);
+VTFLIB_API vlBool vlImageVerifyLump(const vlVoid *lpData, vlUInt uiBufferSize, vlBool *bHasCRC);
 
 VTFLIB_API vlBool vlImageSave(const vlChar *cFileName);
 VTFLIB_API vlBool vlImageSaveLump(vlVoid *lpData, vlUInt uiBufferSize, vlUInt *uiSize);
 VTFLIB_API vlBool vlImageSaveProc(vlVoid *pUserData);
 
+VTFLIB_API vlBool vlImageLoadDDS(const vlChar *cFileName);
+VTFLIB_API vlBool vlImageLoadDDSLump(const vlVoid *lpData, vlUInt uiBufferSize);
+VTFLIB_API vlBool vlImageSaveDDS(const vlChar *cFileName);
+VTFLIB_API vlBool vlImageSaveDDSLump(vlVoid *lpData, vlUInt uiBufferSize, vlUInt *uiSize);
+
 //
 // Image routines.
 //
@@ -534,6 +771,7 @@ VTFLIB_API VTFImageFormat vlImageGetFormat();
 
 VTFLIB_API vlByte *vlImageGetData(vlUInt uiFrame, vlUInt uiFace, vlUInt uiSlice, vlUInt uiMipmapLevel);
 VTFLIB_API vlVoid vlImageSetData(vlUInt uiFrame, vlUInt uiFace, vlUInt uiSlice, vlUInt uiMipmapLevel, vlByte *lpData);
+VTFLIB_API vlBool vlImageAdoptData(vlByte *lpImageData, vlUInt uiImageDataSize, PFreeProc pFree, vlVoid *pUserData);
 
 //
 // Thumbnail routines.
@@ -577,6 +815,9 @@ VTFLIB_API vlBool vlImageGenerateAllNormalMaps(VTFKernelFilter KernelFilter, VTF
 VTFLIB_API vlBool vlImageGenerateSphereMap();
 
 VTFLIB_API vlBool vlImageComputeReflectivity();
+VTFLIB_API vlBool vlImageComputeStatistics(vlUInt uiFrame, vlUInt uiFace, vlUInt uiSlice, vlUInt uiMipmapLevel, SVTFImageStatistics *Statistics);
+VTFLIB_API vlBool vlImageComputePreview(vlUInt uiFrame, vlUInt uiFace, vlUInt uiSlice, vlByte *lpDestRGBA8888, vlUInt uiDestWidth, vlUInt uiDestHeight);
+VTFLIB_API vlBool vlImageComputeCRC(vlUInt *uiCRC);
 
 //
 // Conversion routines.
@@ -602,9 +843,141 @@ VTFLIB_API vlBool vlImageResize(vlByte *lpSourceRGBA8888, vlByte *lpDestRGBA8888
 
 VTFLIB_API vlVoid vlImageCorrectImageGamma(vlByte *lpImageDataRGBA8888, vlUInt uiWidth, vlUInt uiHeight, vlSingle sGammaCorrection);
 VTFLIB_API vlVoid vlImageComputeImageReflectivity(vlByte *lpImageDataRGBA8888, vlUInt uiWidth, vlUInt uiHeight, vlSingle *sX, vlSingle *sY, vlSingle *sZ);
+VTFLIB_API vlBool vlImageComputeImageStatistics(vlByte *lpSource, vlUInt uiWidth, vlUInt uiHeight, VTFImageFormat SourceFormat, SVTFImageStatistics *Statistics);
+VTFLIB_API vlBool vlImageComputeImagePreview(vlByte *lpSource, vlUInt uiWidth, vlUInt uiHeight, VTFImageFormat SourceFormat, vlByte *lpDestRGBA8888, vlUInt uiDestWidth, vlUInt uiDestHeight);
 
 VTFLIB_API vlVoid vlImageFlipImage(vlByte *lpImageDataRGBA8888, vlUInt uiWidth, vlUInt uiHeight);
 VTFLIB_API vlVoid vlImageMirrorImage(vlByte *lpImageDataRGBA8888, vlUInt uiWidth, vlUInt uiHeight);
+VTFLIB_API vlBool vlImageTransformImage(vlByte *lpSource, vlByte *lpDest, vlUInt uiWidth, vlUInt uiHeight, VTFImageFormat ImageFormat, VTFImageTransform Transform);
+
+//
+// Context memory managment routines.
+//
+
+VTFLIB_API vlBool vlContextCreateImage(VLContext *Context, vlUInt *uiImage);
+VTFLIB_API vlVoid vlContextDeleteImage(VLContext *Context, vlUInt uiImage);
+
+//
+// Context library routines.
+//
+
+VTFLIB_API vlBool vlContextImageCreate(VLContext *Context, vlUInt uiImage, vlUInt uiWidth, vlUInt uiHeight, vlUInt uiFrames, vlUInt uiFaces, vlUInt uiSlices, VTFImageFormat ImageFormat, vlBool bThumbnail, vlBool bMipmaps, vlBool bNullImageData);
+VTFLIB_API vlBool vlContextImageCreateSingle(VLContext *Context, vlUInt uiImage, vlUInt uiWidth, vlUInt uiHeight, vlByte *lpImageDataRGBA8888, SVTFCreateOptions *VTFCreateOptions);
+VTFLIB_API vlBool vlContextImageCreateMultiple(VLContext *Context, vlUInt uiImage, vlUInt uiWidth, vlUInt uiHeight, vlUInt uiFrames, vlUInt uiFaces, vlUInt uiSlices, vlByte **lpImageDataRGBA8888, SVTFCreateOptions *VTFCreateOptions);
+VTFLIB_API vlBool vlContextImageCreateFromData(VLContext *Context, vlUInt uiImage, vlUInt uiWidth, vlUInt uiHeight, vlUInt uiFrames, vlUInt uiFaces, vlUInt uiSlices, VTFImageFormat ImageFormat, vlBool bThumbnail, vlBool bMipmaps, vlByte *lpImageData, vlUInt uiImageDataSize, PFreeProc pFree, vlVoid *pUserData);
+VTFLIB_API vlBool vlContextImageCreateMultipleFromData(VLContext *Context, vlUInt uiImage, vlUInt uiWidth, vlUInt uiHeight, vlUInt uiFrames, vlUInt uiFaces, vlUInt uiSlices, vlByte *lpImageDataRGBA8888, vlUInt uiImageDataSize, PFreeProc pFree, vlVoid *pUserData, SVTFCreateOptions *VTFCreateOptions);
+VTFLIB_API vlVoid vlContextImageDestroy(VLContext *Context, vlUInt uiImage);
+
+VTFLIB_API vlBool vlContextImageIsLoaded(VLContext *Context, vlUInt uiImage);
+
+VTFLIB_API vlBool vlContextImageLoad(VLContext *Context, vlUInt uiImage, const vlChar *cFileName, vlBool bHeaderOnly);
+VTFLIB_API vlBool vlContextImageLoadLump(VLContext *Context, vlUInt uiImage, const vlVoid *lpData, vlUInt uiBufferSize, vlBool bHeaderOnly);
+VTFLIB_API vlBool vlContextImageLoadProc(VLContext *Context, vlUInt uiImage, vlVoid *pUserData, vlBool bHeaderOnly);
+
+VTFLIB_API vlBool vlContextImageSave(VLContext *Context, vlUInt uiImage, const vlChar *cFileName);
+VTFLIB_API vlBool vlContextImageSaveLump(VLContext *Context, vlUInt uiImage, vlVoid *lpData, vlUInt uiBufferSize, vlUInt *uiSize);
+VTFLIB_API vlBool vlContextImageSaveProc(VLContext *Context, vlUInt uiImage, vlVoid *pUserData);
+
+VTFLIB_API vlBool vlContextImageLoadDDS(VLContext *Context, vlUInt uiImage, const vlChar *cFileName);
+VTFLIB_API vlBool vlContextImageLoadDDSLump(VLContext *Context, vlUInt uiImage, const vlVoid *lpData, vlUInt uiBufferSize);
+VTFLIB_API vlBool vlContextImageSaveDDS(VLContext *Context, vlUInt uiImage, const vlChar *cFileName);
+VTFLIB_API vlBool vlContextImageSaveDDSLump(VLContext *Context, vlUInt uiImage, vlVoid *lpData, vlUInt uiBufferSize, vlUInt *uiSize);
+
+//
+// Context image routines.
+//
+
+VTFLIB_API vlUInt vlContextImageGetHasImage(VLContext *Context, vlUInt uiImage);
+
+VTFLIB_API vlUInt vlContextImageGetMajorVersion(VLContext *Context, vlUInt uiImage);
+VTFLIB_API vlUInt vlContextImageGetMinorVersion(VLContext *Context, vlUInt uiImage);
+VTFLIB_API vlUInt vlContextImageGetSize(VLContext *Context, vlUInt uiImage);
+
+VTFLIB_API vlUInt vlContextImageGetWidth(VLContext *Context, vlUInt uiImage);
+VTFLIB_API vlUInt vlContextImageGetHeight(VLContext *Context, vlUInt uiImage);
+VTFLIB_API vlUInt vlContextImageGetDepth(VLContext *Context, vlUInt uiImage);
+
+VTFLIB_API vlUInt vlContextImageGetFrameCount(VLContext *Context, vlUInt uiImage);
+VTFLIB_API vlUInt vlContextImageGetFaceCount(VLContext *Context, vlUInt uiImage);
+VTFLIB_API vlUInt vlContextImageGetMipmapCount(VLContext *Context, vlUInt uiImage);
+
+VTFLIB_API vlUInt vlContextImageGetStartFrame(VLContext *Context, vlUInt uiImage);
+VTFLIB_API vlVoid vlContextImageSetStartFrame(VLContext *Context, vlUInt uiImage, vlUInt uiStartFrame);
+
+VTFLIB_API vlUInt vlContextImageGetFlags(VLContext *Context, vlUInt uiImage);
+VTFLIB_API vlVoid vlContextImageSetFlags(VLContext *Context, vlUInt uiImage, vlUInt uiFlags);
+
+VTFLIB_API vlBool vlContextImageGetFlag(VLContext *Context, vlUInt uiImage, VTFImageFlag ImageFlag);
+VTFLIB_API vlVoid vlContextImageSetFlag(VLContext *Context, vlUInt uiImage, VTFImageFlag ImageFlag, vlBool bState);
+
+VTFLIB_API vlSingle vlContextImageGetBumpmapScale(VLContext *Context, vlUInt uiImage);
+VTFLIB_API vlVoid vlContextImageSetBumpmapScale(VLContext *Context, vlUInt uiImage, vlSingle sBumpmapScale);
+
+VTFLIB_API vlVoid vlContextImageGetReflectivity(VLContext *Context, vlUInt uiImage, vlSingle *sX, vlSingle *sY, vlSingle *sZ);
+VTFLIB_API vlVoid vlContextImageSetReflectivity(VLContext *Context, vlUInt uiImage, vlSingle sX, vlSingle sY, vlSingle sZ);
+
+VTFLIB_API VTFImageFormat vlContextImageGetFormat(VLContext *Context, vlUInt uiImage);
+
+VTFLIB_API vlByte *vlContextImageGetData(VLContext *Context, vlUInt uiImage, vlUInt uiFrame, vlUInt uiFace, vlUInt uiSlice, vlUInt uiMipmapLevel);
+VTFLIB_API vlVoid vlContextImageSetData(VLContext *Context, vlUInt uiImage, vlUInt uiFrame, vlUInt uiFace, vlUInt uiSlice, vlUInt uiMipmapLevel, vlByte *lpData);
+VTFLIB_API vlBool vlContextImageAdoptData(VLContext *Context, vlUInt uiImage, vlByte *lpImageData, vlUInt uiImageDataSize, PFreeProc pFree, vlVoid *pUserData);
+
+//
+// Context thumbnail routines.
+//
+
+VTFLIB_API vlBool vlContextImageGetHasThumbnail(VLContext *Context, vlUInt uiImage);
+
+VTFLIB_API vlUInt vlContextImageGetThumbnailWidth(VLContext *Context, vlUInt uiImage);
+VTFLIB_API vlUInt vlContextImageGetThumbnailHeight(VLContext *Context, vlUInt uiImage);
+
+VTFLIB_API VTFImageFormat vlContextImageGetThumbnailFormat(VLContext *Context, vlUInt uiImage);
+
+VTFLIB_API vlByte *vlContextImageGetThumbnailData(VLContext *Context, vlUInt uiImage);
+VTFLIB_API vlVoid vlContextImageSetThumbnailData(VLContext *Context, vlUInt uiImage, vlByte *lpData);
+
+//
+// Context resource routines.
+//
+
+VTFLIB_API vlBool vlContextImageGetSupportsResources(VLContext *Context, vlUInt uiImage);
+
+VTFLIB_API vlUInt vlContextImageGetResourceCount(VLContext *Context, vlUInt uiImage);
+VTFLIB_API vlUInt vlContextImageGetResourceType(VLContext *Context, vlUInt uiImage, vlUInt uiIndex);
+VTFLIB_API vlBool vlContextImageGetHasResource(VLContext *Context, vlUInt uiImage, vlUInt uiType);
+
+VTFLIB_API vlVoid *vlContextImageGetResourceData(VLContext *Context, vlUInt uiImage, vlUInt uiType, vlUInt *uiSize);
+VTFLIB_API vlVoid *vlContextImageSetResourceData(VLContext *Context, vlUInt uiImage, vlUInt uiType, vlUInt uiSize, vlVoid *lpData);
+
+//
+// Context helper routines.
+//
+
+VTFLIB_API vlBool vlContextImageGenerateMipmaps(VLContext *Context, vlUInt uiImage, vlUInt uiFace, vlUInt uiFrame, VTFMipmapFilter MipmapFilter, VTFSharpenFilter SharpenFilter);
+VTFLIB_API vlBool vlContextImageGenerateAllMipmaps(VLContext *Context, vlUInt uiImage, VTFMipmapFilter MipmapFilter, VTFSharpenFilter SharpenFilter);
+
+VTFLIB_API vlBool vlContextImageGenerateThumbnail(VLContext *Context, vlUInt uiImage);
+
+VTFLIB_API vlBool vlContextImageGenerateNormalMap(VLContext *Context, vlUInt uiImage, vlUInt uiFrame, VTFKernelFilter KernelFilter, VTFHeightConversionMethod HeightConversionMethod, VTFNormalAlphaResult NormalAlphaResult);
+VTFLIB_API vlBool vlContextImageGenerateAllNormalMaps(VLContext *Context, vlUInt uiImage, VTFKernelFilter KernelFilter, VTFHeightConversionMethod HeightConversionMethod, VTFNormalAlphaResult NormalAlphaResult);
+
+VTFLIB_API vlBool vlContextImageGenerateSphereMap(VLContext *Context, vlUInt uiImage);
+
+VTFLIB_API vlBool vlContextImageComputeReflectivity(VLContext *Context, vlUInt uiImage);
+VTFLIB_API vlBool vlContextImageComputeStatistics(VLContext *Context, vlUInt uiImage, vlUInt uiFrame, vlUInt uiFace, vlUInt uiSlice, vlUInt uiMipmapLevel, SVTFImageStatistics *Statistics);
+VTFLIB_API vlBool vlContextImageComputePreview(VLContext *Context, vlUInt uiImage, vlUInt uiFrame, vlUInt uiFace, vlUInt uiSlice, vlByte *lpDestRGBA8888, vlUInt uiDestWidth, vlUInt uiDestHeight);
+VTFLIB_API vlBool vlContextImageComputeCRC(VLContext *Context, vlUInt uiImage, vlUInt *uiCRC);
+
+//
+// Context conversion routines.  (Use the context's options.)
+//
+
+VTFLIB_API vlBool vlContextImageConvertToRGBA8888(VLContext *Context, vlByte *lpSource, vlByte *lpDest, vlUInt uiWidth, vlUInt uiHeight, VTFImageFormat SourceFormat);
+VTFLIB_API vlBool vlContextImageConvertFromRGBA8888(VLContext *Context, vlByte *lpSource, vlByte *lpDest, vlUInt uiWidth, vlUInt uiHeight, VTFImageFormat DestFormat);
+
+VTFLIB_API vlBool vlContextImageConvert(VLContext *Context, vlByte *lpSource, vlByte *lpDest, vlUInt uiWidth, vlUInt uiHeight, VTFImageFormat SourceFormat, VTFImageFormat DestFormat);
+
+VTFLIB_API vlBool vlContextImageResize(VLContext *Context, vlByte *lpSourceRGBA8888, vlByte *lpDestRGBA8888, vlUInt uiSourceWidth, vlUInt uiSourceHeight, vlUInt uiDestWidth, vlUInt uiDestHeight, VTFMipmapFilter ResizeFilter, VTFSharpenFilter SharpenFilter);
 
 //
 // Memory managment routines.
@@ -632,6 +1005,9 @@ VTFLIB_API vlBool vlMaterialSave(const vlChar *cFileName);
 VTFLIB_API vlBool vlMaterialSaveLump(vlVoid *lpData, vlUInt uiBufferSize, vlUInt *uiSize);
 VTFLIB_API vlBool vlMaterialSaveProc(vlVoid *pUserData);
 
+VTFLIB_API vlBool vlMaterialLoadBinary(const vlVoid *lpData, vlUInt uiSize);
+VTFLIB_API vlBool vlMaterialSaveBinary(vlVoid *lpData, vlUInt uiBufferSize, vlUInt *uiSize);
+
 //
 // Node routines.
 //
@@ -663,6 +1039,173 @@ VTFLIB_API vlVoid vlMaterialAddNodeString(const vlChar *cName, const vlChar *cVa
 VTFLIB_API vlVoid vlMaterialAddNodeInteger(const vlChar *cName, vlUInt iValue);
 VTFLIB_API vlVoid vlMaterialAddNodeSingle(const vlChar *cName, vlFloat sValue);
 
+//
+// Context memory managment routines.
+//
+
+VTFLIB_API vlBool vlContextCreateMaterial(VLContext *Context, vlUInt *uiMaterial);
+VTFLIB_API vlVoid vlContextDeleteMaterial(VLContext *Context, vlUInt uiMaterial);
+
+//
+// Context library routines.
+//
+
+VTFLIB_API vlBool vlContextMaterialCreate(VLContext *Context, vlUInt uiMaterial, const vlChar *cRoot);
+VTFLIB_API vlVoid vlContextMaterialDestroy(VLContext *Context, vlUInt uiMaterial);
+
+VTFLIB_API vlBool vlContextMaterialIsLoaded(VLContext *Context, vlUInt uiMaterial);
+
+VTFLIB_API vlBool vlContextMaterialLoad(VLContext *Context, vlUInt uiMaterial, const vlChar *cFileName);
+VTFLIB_API vlBool vlContextMaterialLoadLump(VLContext *Context, vlUInt uiMaterial, const vlVoid *lpData, vlUInt uiBufferSize);
+VTFLIB_API vlBool vlContextMaterialLoadProc(VLContext *Context, vlUInt uiMaterial, vlVoid *pUserData);
+
+VTFLIB_API vlBool vlContextMaterialSave(VLContext *Context, vlUInt uiMaterial, const vlChar *cFileName);
+VTFLIB_API vlBool vlContextMaterialSaveLump(VLContext *Context, vlUInt uiMaterial, vlVoid *lpData, vlUInt uiBufferSize, vlUInt *uiSize);
+VTFLIB_API vlBool vlContextMaterialSaveProc(VLContext *Context, vlUInt uiMaterial, vlVoid *pUserData);
+
+//
+// Context node routines.
+//
+
+VTFLIB_API vlBool vlContextMaterialGetFirstNode(VLContext *Context, vlUInt uiMaterial);
+VTFLIB_API vlBool vlContextMaterialGetLastNode(VLContext *Context, vlUInt uiMaterial);
+VTFLIB_API vlBool vlContextMaterialGetNextNode(VLContext *Context, vlUInt uiMaterial);
+VTFLIB_API vlBool vlContextMaterialGetPreviousNode(VLContext *Context, vlUInt uiMaterial);
+
+VTFLIB_API vlBool vlContextMaterialGetParentNode(VLContext *Context, vlUInt uiMaterial);
+VTFLIB_API vlBool vlContextMaterialGetChildNode(VLContext *Context, vlUInt uiMaterial, const vlChar *cName);
+
+VTFLIB_API const vlChar *vlContextMaterialGetNodeName(VLContext *Context, vlUInt uiMaterial);
+VTFLIB_API vlVoid vlContextMaterialSetNodeName(VLContext *Context, vlUInt uiMaterial, const vlChar *cName);
+
+VTFLIB_API VMTNodeType vlContextMaterialGetNodeType(VLContext *Context, vlUInt uiMaterial);
+
+VTFLIB_API const vlChar *vlContextMaterialGetNodeString(VLContext *Context, vlUInt uiMaterial);
+VTFLIB_API vlVoid vlContextMaterialSetNodeString(VLContext *Context, vlUInt uiMaterial, const vlChar *cValue);
+
+VTFLIB_API vlUInt vlContextMaterialGetNodeInteger(VLContext *Context, vlUInt uiMaterial);
+VTFLIB_API vlVoid vlContextMaterialSetNodeInteger(VLContext *Context, vlUInt uiMaterial, vlUInt iValue);
+
+VTFLIB_API vlFloat vlContextMaterialGetNodeSingle(VLContext *Context, vlUInt uiMaterial);
+VTFLIB_API vlVoid vlContextMaterialSetNodeSingle(VLContext *Context, vlUInt uiMaterial, vlFloat sValue);
+
+VTFLIB_API vlVoid vlContextMaterialAddNodeGroup(VLContext *Context, vlUInt uiMaterial, const vlChar *cName);
+VTFLIB_API vlVoid vlContextMaterialAddNodeString(VLContext *Context, vlUInt uiMaterial, const vlChar *cName, const vlChar *cValue);
+VTFLIB_API vlVoid vlContextMaterialAddNodeInteger(VLContext *Context, vlUInt uiMaterial, const vlChar *cName, vlUInt iValue);
+VTFLIB_API vlVoid vlContextMaterialAddNodeSingle(VLContext *Context, vlUInt uiMaterial, const vlChar *cName, vlFloat sValue);
+
+//
+// Background reads and writes for batch tools.  Queue every input with
+// vlAsyncIOQueueRead() and take them back in order with vlAsyncIOReadNext();
+// later files are read while the current one is converted.  Finished files
+// are queued with vlAsyncIOWrite() and written while the next is converted.
+// One thread may use a VLAsyncIO at a time.
+//
+
+typedef struct tagVLAsyncIO VLAsyncIO;
+
+VTFLIB_API vlBool vlCreateAsyncIO(vlUInt uiThreads, vlUInt uiMemoryLimit, VLAsyncIO **AsyncIO);
+VTFLIB_API vlVoid vlDeleteAsyncIO(VLAsyncIO *AsyncIO);
+
+VTFLIB_API vlVoid vlAsyncIOQueueRead(VLAsyncIO *AsyncIO, const vlChar *cFileName);
+VTFLIB_API vlBool vlAsyncIOHasNext(VLAsyncIO *AsyncIO);
+VTFLIB_API vlBool vlAsyncIOReadNext(VLAsyncIO *AsyncIO, const vlChar **cFileName, const vlVoid **lpData, vlUInt *uiSize);
+
+VTFLIB_API vlBool vlAsyncIOWrite(VLAsyncIO *AsyncIO, const vlChar *cFileName, const vlVoid *lpData, vlUInt uiSize);
+VTFLIB_API vlBool vlAsyncIOWriteImage(VLAsyncIO *AsyncIO, const vlChar *cFileName);
+VTFLIB_API vlBool vlContextAsyncIOWriteImage(VLAsyncIO *AsyncIO, VLContext *Context, vlUInt uiImage, const vlChar *cFileName);
+VTFLIB_API vlBool vlAsyncIOFlush(VLAsyncIO *AsyncIO);
+
+//
+// What every .vmt under a materials folder refers to, scanned in parallel and
+// cached in a file so later scans only parse materials that changed.  Names
+// are the way materials refer to each other: relative to the materials
+// folder, lower case, forward slashes and no extension.
+//
+
+typedef struct tagVLMaterialGraph VLMaterialGraph;
+
+VTFLIB_API vlBool vlCreateMaterialGraph(VLMaterialGraph **MaterialGraph);
+VTFLIB_API vlVoid vlDeleteMaterialGraph(VLMaterialGraph *MaterialGraph);
+
+VTFLIB_API vlBool vlMaterialGraphLoad(VLMaterialGraph *MaterialGraph, const vlChar *cFileName);
+VTFLIB_API vlBool vlMaterialGraphSave(VLMaterialGraph *MaterialGraph, const vlChar *cFileName);
+VTFLIB_API vlBool vlMaterialGraphScan(VLMaterialGraph *MaterialGraph, const vlChar *cRoot, vlUInt uiThreads);
+
+VTFLIB_API vlUInt vlMaterialGraphGetMaterialCount(VLMaterialGraph *MaterialGraph);
+VTFLIB_API vlUInt vlMaterialGraphFindMaterial(VLMaterialGraph *MaterialGraph, const vlChar *cName);
+VTFLIB_API const vlChar *vlMaterialGraphGetMaterialName(VLMaterialGraph *MaterialGraph, vlUInt uiMaterial);
+
+VTFLIB_API const vlChar *vlMaterialGraphResolve(VLMaterialGraph *MaterialGraph, const vlChar *cName, MaterialReferenceType ReferenceType);
+
+//
+// Parsed materials kept in one mapped file, keyed by path and modified time.
+// vlMaterialCacheLoad() loads the bound material from the cache if the file
+// hasn't changed, otherwise parses it and adds it to the cache.  Call
+// vlMaterialCacheSave() to write new materials out for the next run.
+//
+
+typedef struct tagVLMaterialCache VLMaterialCache;
+
+VTFLIB_API vlBool vlCreateMaterialCache(VLMaterialCache **MaterialCache);
+VTFLIB_API vlVoid vlDeleteMaterialCache(VLMaterialCache *MaterialCache);
+
+VTFLIB_API vlBool vlMaterialCacheOpen(VLMaterialCache *MaterialCache, const vlChar *cFileName);
+VTFLIB_API vlBool vlMaterialCacheSave(VLMaterialCache *MaterialCache, const vlChar *cFileName);
+
+VTFLIB_API vlBool vlMaterialCacheLoad(VLMaterialCache *MaterialCache, const vlChar *cFileName);
+
+//
+// A Valve package (.vpk) read in place.  Open the _dir.vpk; entries are found
+// by their path inside the package, in any case and with either slash.
+// vlImageLoadPackage() and vlMaterialLoadPackage() load the bound image or
+// material straight from the package's mapped archives.
+//
+
+#define VPK_INVALID_INDEX	0xffffffff
+
+typedef struct tagVLPackage VLPackage;
+
+VTFLIB_API vlBool vlCreatePackage(VLPackage **Package);
+VTFLIB_API vlVoid vlDeletePackage(VLPackage *Package);
+
+VTFLIB_API vlBool vlPackageOpen(VLPackage *Package, const vlChar *cFileName);
+VTFLIB_API vlVoid vlPackageClose(VLPackage *Package);
+
+VTFLIB_API vlUInt vlPackageGetEntryCount(VLPackage *Package);
+VTFLIB_API vlUInt vlPackageFindEntry(VLPackage *Package, const vlChar *cPath);
+VTFLIB_API const vlChar *vlPackageGetEntryName(VLPackage *Package, vlUInt uiEntry);
+VTFLIB_API vlUInt vlPackageGetEntrySize(VLPackage *Package, vlUInt uiEntry);
+
+VTFLIB_API vlBool vlImageLoadPackage(VLPackage *Package, const vlChar *cPath, vlBool bHeaderOnly);
+VTFLIB_API vlBool vlMaterialLoadPackage(VLPackage *Package, const vlChar *cPath);
+
+//
+// The files packed into a compiled map (.bsp).  Open the map, add or replace
+// files with vlMapAddFile() or vlMapAddFileData(), then vlMapSave() writes
+// the map again with only its pakfile lump rebuilt.  Paths are the ones the
+// game would open, e.g. "materials/cubemap_skyboxes/sky_cubemap.vtf".
+//
+
+#define BSP_INVALID_INDEX	0xffffffff
+
+typedef struct tagVLMap VLMap;
+
+VTFLIB_API vlBool vlCreateMap(VLMap **Map);
+VTFLIB_API vlVoid vlDeleteMap(VLMap *Map);
+
+VTFLIB_API vlBool vlMapOpen(VLMap *Map, const vlChar *cFileName);
+VTFLIB_API vlBool vlMapSave(VLMap *Map, const vlChar *cFileName);
+VTFLIB_API vlVoid vlMapClose(VLMap *Map);
+
+VTFLIB_API vlUInt vlMapGetEntryCount(VLMap *Map);
+VTFLIB_API vlUInt vlMapFindEntry(VLMap *Map, const vlChar *cPath);
+VTFLIB_API const vlChar *vlMapGetEntryName(VLMap *Map, vlUInt uiEntry);
+VTFLIB_API vlUInt vlMapGetEntrySize(VLMap *Map, vlUInt uiEntry);
+
+VTFLIB_API vlBool vlMapAddFile(VLMap *Map, const vlChar *cPath, const vlChar *cFileName);
+VTFLIB_API vlBool vlMapAddFileData(VLMap *Map, const vlChar *cPath, const vlVoid *lpData, vlUInt uiSize);
+
 #ifdef __cplusplus
 }
 #endif
@@ -674,6 +1217,8 @@ VTFLIB_API vlVoid vlMaterialAddNodeSingle(const vlChar *cName, vlFloat sValue);
 #ifdef __cplusplus
 namespace VTFLib
 {
+	class CVPKFile;
+
 	namespace IO
 	{
 		namespace Readers
@@ -689,26 +1234,105 @@ namespace VTFLib
 	{
 		class CVMTGroupNode;
 
+		//
+		// SVMTKey
+		//
+		struct SVMTKey
+		{
+			vlUInt uiHash;
+			vlUInt uiLength;
+			vlChar cKey[1];
+		};
+
+		//
+		// CVMTArena
+		//
+		class VTFLIB_API CVMTArena
+		{
+		private:
+			struct SBlock
+			{
+				SBlock *lpNext;
+				vlUInt uiSize;
+			};
+
+			SBlock *lpBlocks;
+			vlByte *lpPosition;
+			vlByte *lpEnd;
+			vlUInt uiNextBlockSize;
+
+			const SVMTKey **lpKeys;
+			vlUInt uiKeyCount;
+			vlUInt uiKeyTableSize;
+
+		public:
+			CVMTArena();
+			~CVMTArena();
+
+		private:
+			CVMTArena(const CVMTArena &);
+			CVMTArena &operator=(const CVMTArena &);
+
+		public:
+			vlVoid *Allocate(vlUInt uiSize);
+			vlChar *AddString(const vlChar *cString);
+
+			const SVMTKey *AddKey(const vlChar *cName);
+			const SVMTKey *FindKey(const vlChar *cName, vlUInt uiHash, vlUInt uiLength) const;
+
+			vlVoid Reset();
+
+		private:
+			vlByte *AddBlock(vlUInt uiSize);
+			vlVoid GrowKeyTable();
+
+		public:
+			static vlUInt Hash(const vlChar *cName, vlUInt &uiLength);
+			static vlUInt GetKeySize(vlUInt uiLength);
+			static vlVoid InitializeKey(SVMTKey *Key, const vlChar *cName, vlUInt uiHash, vlUInt uiLength);
+			static vlBool CompareKey(const SVMTKey *Key, const vlChar *cName, vlUInt uiHash, vlUInt uiLength);
+		};
+
 		//
 		// CVMTNode
 		//
 		class VTFLIB_API CVMTNode
 		{
 		private:
-			vlChar *cName;
+			const vlChar *cName;
+			const SVMTKey *Key;
 			CVMTGroupNode *Parent;
+			CVMTArena *Arena;
 
 		public:
-			CVMTNode(const vlChar *cName);
+			CVMTNode(const vlChar *cName, CVMTArena *Arena = 0);
 			virtual ~CVMTNode();
 
 			const vlChar *GetName() const;
 			vlVoid SetName(const vlChar *cName);
 
 			CVMTGroupNode *GetParent();
+			CVMTArena *GetArena() const;
+			const SVMTKey *GetKey() const;
 
 			virtual VMTNodeType GetType() const = 0;
 			virtual CVMTNode *Clone() const = 0;
+
+		public:
+			static vlVoid *operator new(size_t uiSize);
+			static vlVoid *operator new(size_t uiSize, CVMTArena *Arena);
+			static vlVoid operator delete(vlVoid *lpNode);
+			static vlVoid operator delete(vlVoid *lpNode, CVMTArena *Arena);
+
+			static CVMTNode *Copy(const CVMTNode *Node, CVMTArena *Arena);
+
+		protected:
+			vlVoid *Allocate(vlUInt uiSize) const;
+			vlVoid Free(vlVoid *lpData) const;
+			vlChar *CopyString(const vlChar *cString) const;
+
+		private:
+			vlVoid SetKey(const vlChar *cName);
 		};
 
 		//
@@ -717,7 +1341,7 @@ namespace VTFLib
 		class VTFLIB_API CVMTValueNode : public CVMTNode
 		{
 		public:
-			CVMTValueNode(const vlChar *cName);
+			CVMTValueNode(const vlChar *cName, CVMTArena *Arena = 0);
 			virtual ~CVMTValueNode();
 
 			virtual vlVoid SetValue(const vlChar *cValue) = 0;
@@ -733,7 +1357,7 @@ namespace VTFLib
 
 		public:
 			CVMTStringNode(const vlChar *cName);
-			CVMTStringNode(const vlChar *cName, const vlChar *cValue);
+			CVMTStringNode(const vlChar *cName, const vlChar *cValue, CVMTArena *Arena = 0);
 			CVMTStringNode(const CVMTStringNode &StringNode);
 			virtual ~CVMTStringNode();
 
@@ -755,8 +1379,8 @@ namespace VTFLib
 
 		public:
 			CVMTIntegerNode(const vlChar *cName);
-			CVMTIntegerNode(const vlChar *cName, const vlChar *cValue);
-			CVMTIntegerNode(const vlChar *cName, vlInt iValue);
+			CVMTIntegerNode(const vlChar *cName, const vlChar *cValue, CVMTArena *Arena = 0);
+			CVMTIntegerNode(const vlChar *cName, vlInt iValue, CVMTArena *Arena = 0);
 			CVMTIntegerNode(const CVMTIntegerNode &IntegerNode);
 			virtual ~CVMTIntegerNode();
 
@@ -779,8 +1403,8 @@ namespace VTFLib
 
 		public:
 			CVMTSingleNode(const vlChar *cName);
-			CVMTSingleNode(const vlChar *cName, const vlChar *cValue);
-			CVMTSingleNode(const vlChar *cName, vlFloat fValue);
+			CVMTSingleNode(const vlChar *cName, const vlChar *cValue, CVMTArena *Arena = 0);
+			CVMTSingleNode(const vlChar *cName, vlFloat fValue, CVMTArena *Arena = 0);
 			CVMTSingleNode(const CVMTSingleNode &SingleNode);
 			virtual ~CVMTSingleNode();
 
@@ -799,13 +1423,15 @@ namespace VTFLib
 		class VTFLIB_API CVMTGroupNode : public CVMTNode
 		{
 		private:
-			class CVMTNodeList;
+			CVMTNode **lpNodes;
+			vlUInt uiNodeCount;
+			vlUInt uiNodeCapacity;
 
-		private:
-			CVMTNodeList *VMTNodeList;
+			vlUInt *lpIndex;
+			vlUInt uiIndexSize;
 
 		public:
-			CVMTGroupNode(const vlChar *cName);
+			CVMTGroupNode(const vlChar *cName, CVMTArena *Arena = 0);
 			CVMTGroupNode(const CVMTGroupNode &GroupNode);
 			virtual ~CVMTGroupNode();
 
@@ -826,9 +1452,85 @@ namespace VTFLib
 
 			CVMTNode *GetNode(vlUInt uiIndex) const;
 			CVMTNode *GetNode(const vlChar *cName) const;
+
+		private:
+			vlVoid BuildIndex();
+			vlVoid InsertIndex(vlUInt uiNode);
 		};
 	}
 
+	//
+	// CImageView
+	//
+	class VTFLIB_API CImageView
+	{
+	private:
+		vlByte *lpData;
+		vlUInt uiWidth;
+		vlUInt uiHeight;
+		vlUInt uiPitch;
+		VTFImageFormat ImageFormat;
+
+	public:
+		CImageView();
+		CImageView(vlByte *lpData, vlUInt uiWidth, vlUInt uiHeight, VTFImageFormat ImageFormat, vlUInt uiPitch = 0);
+
+	public:
+		vlBool IsEmpty() const;
+		vlBool IsPacked() const;
+
+		vlByte *GetData() const;
+		vlUInt GetWidth() const;
+		vlUInt GetHeight() const;
+		vlUInt GetPitch() const;
+		VTFImageFormat GetFormat() const;
+
+		vlUInt GetRowSize() const;
+		vlByte *GetRow(vlUInt uiRow) const;
+
+		vlBool GetSubView(vlUInt uiX, vlUInt uiY, vlUInt uiWidth, vlUInt uiHeight, CImageView &View) const;
+
+	public:
+		static vlUInt ComputePitch(vlUInt uiWidth, VTFImageFormat ImageFormat);
+	};
+
+	//
+	// CImage
+	//
+	class VTFLIB_API CImage
+	{
+	private:
+		vlByte *lpData;
+		vlUInt uiWidth;
+		vlUInt uiHeight;
+		VTFImageFormat ImageFormat;
+
+	public:
+		CImage();
+		CImage(CImage &&Image);
+		~CImage();
+
+		CImage &operator=(CImage &&Image);
+
+	private:
+		CImage(const CImage &);
+		CImage &operator=(const CImage &);
+
+	public:
+		vlBool Create(vlUInt uiWidth, vlUInt uiHeight, VTFImageFormat ImageFormat);
+		vlVoid Destroy();
+
+		vlBool IsLoaded() const;
+
+		vlByte *GetData() const;
+		vlUInt GetWidth() const;
+		vlUInt GetHeight() const;
+		VTFImageFormat GetFormat() const;
+		vlUInt GetSize() const;
+
+		CImageView GetView() const;
+	};
+
 	//
 	// CVTFFile
 	//
@@ -840,21 +1542,30 @@ namespace VTFLib
 
 		vlUInt uiImageBufferSize;
 		vlByte *lpImageData;
+		PFreeProc pImageDataFree;
+		vlVoid *pImageDataUserData;
 
 		vlUInt uiThumbnailBufferSize;
 		vlByte *lpThumbnailImageData;
 
+		SVTFLibOptions *lpOptions;
+
 	public:
 		CVTFFile();
 		CVTFFile(const CVTFFile &VTFFile);
 		CVTFFile(const CVTFFile &VTFFile, VTFImageFormat ImageFormat);
+		CVTFFile(CVTFFile &&VTFFile);
 
 		~CVTFFile();
 
+		CVTFFile &operator=(CVTFFile &&VTFFile);
+
 	public:
 		vlBool Create(vlUInt uiWidth, vlUInt uiHeight, vlUInt uiFrames = 1, vlUInt uiFaces = 1, vlUInt uiSlices = 1, VTFImageFormat ImageFormat = IMAGE_FORMAT_RGBA8888, vlBool bThumbnail = vlTrue, vlBool bMipmaps = vlTrue, vlBool bNullImageData = vlFalse);
 		vlBool Create(vlUInt uiWidth, vlUInt uiHeight, vlByte *lpImageDataRGBA8888, const SVTFCreateOptions &VTFCreateOptions);
 		vlBool Create(vlUInt uiWidth, vlUInt uiHeight, vlUInt uiFrames, vlUInt uiFaces, vlUInt uiSlices, vlByte **lpImageDataRGBA8888, const SVTFCreateOptions &VTFCreateOptions);
+		vlBool Create(vlUInt uiWidth, vlUInt uiHeight, vlUInt uiFrames, vlUInt uiFaces, vlUInt uiSlices, VTFImageFormat ImageFormat, vlBool bThumbnail, vlBool bMipmaps, vlByte *lpImageData, vlUInt uiImageDataSize, PFreeProc pFree, vlVoid *pUserData);
+		vlBool Create(vlUInt uiWidth, vlUInt uiHeight, vlUInt uiFrames, vlUInt uiFaces, vlUInt uiSlices, vlByte *lpImageDataRGBA8888, vlUInt uiImageDataSize, PFreeProc pFree, vlVoid *pUserData, const SVTFCreateOptions &VTFCreateOptions);
 		vlVoid Destroy();
 
 		vlBool IsLoaded() const;
@@ -862,12 +1573,30 @@ namespace VTFLib
 		vlBool Load(const vlChar *cFileName, vlBool bHeaderOnly = vlFalse);
 		vlBool Load(const vlVoid *lpData, vlUInt uiBufferSize, vlBool bHeaderOnly = vlFalse);
 		vlBool Load(vlVoid *pUserData, vlBool bHeaderOnly = vlFalse);
+		vlBool Load(const CVPKFile &Package, const vlChar *cPath, vlBool bHeaderOnly = vlFalse);
 
 		vlBool Save(const vlChar *cFileName) const;
 		vlBool Save(vlVoid *lpData, vlUInt uiBufferSize, vlUInt &uiSize) const;
 		vlBool Save(vlVoid *pUserData) const;
 
+		vlBool LoadDDS(const vlChar *cFileName);
+		vlBool LoadDDS(const vlVoid *lpData, vlUInt uiBufferSize);
+		vlBool SaveDDS(const vlChar *cFileName) const;
+		vlBool SaveDDS(vlVoid *lpData, vlUInt uiBufferSize, vlUInt &uiSize) const;
+
+		static vlBool LoadHeaderInfo(const vlChar *cFileName, SVTFHeaderInfo &HeaderInfo);
+		static vlBool LoadHeaderInfo(const vlVoid *lpData, vlUInt uiBufferSize, SVTFHeaderInfo &HeaderInfo);
+
+		static vlBool Verify(const vlChar *cFileName, vlBool &bHasCRC);
+		static vlBool Verify(const vlVoid *lpData, vlUInt uiBufferSize, vlBool &bHasCRC);
+
+	public:
+		const SVTFLibOptions *GetOptions() const;
+		vlVoid SetOptions(const SVTFLibOptions *Options);
+
 	private:
+		vlVoid ResolveOptions(SVTFLibOptions &Options) const;
+
 		vlBool IsPowerOfTwo(vlUInt uiSize);
 		vlUInt NextPowerOfTwo(vlUInt uiSize);
 
@@ -875,6 +1604,15 @@ namespace VTFLib
 
 		vlBool Load(IO::Readers::IReader *Reader, vlBool bHeaderOnly);
 		vlBool Save(IO::Writers::IWriter *Writer) const;
+		vlBool LoadDDS(IO::Readers::IReader *Reader);
+		vlBool SaveDDS(IO::Writers::IWriter *Writer) const;
+
+		static vlBool ReadHeader(IO::Readers::IReader *Reader, SVTFHeader &Header);
+		static vlBool ReadLayout(IO::Readers::IReader *Reader, SVTFHeader &Header, vlUInt &uiThumbnailOffset, vlUInt &uiThumbnailSize, vlUInt &uiImageOffset, vlUInt &uiImageSize);
+		static vlBool LoadHeaderInfo(IO::Readers::IReader *Reader, SVTFHeaderInfo &HeaderInfo);
+		static vlBool Verify(IO::Readers::IReader *Reader, vlBool &bHasCRC);
+
+		static vlUInt ComputeFaceCount(const SVTFHeader &Header);
 
 	public:
 		vlBool GetHasImage() const;
@@ -910,6 +1648,7 @@ namespace VTFLib
 		
 		vlByte *GetData(vlUInt uiFrame, vlUInt uiFace, vlUInt uiSlice, vlUInt uiMipmapLevel) const;
 		vlVoid SetData(vlUInt uiFrame, vlUInt uiFace, vlUInt uiSlice, vlUInt uiMipmapLevel, vlByte *lpData);
+		vlBool SetData(vlByte *lpImageData, vlUInt uiImageDataSize, PFreeProc pFree, vlVoid *pUserData);
 
 	public:
 		vlBool GetHasThumbnail() const;
@@ -945,6 +1684,9 @@ namespace VTFLib
 
 	public:
 		vlBool ComputeReflectivity();
+		vlBool ComputeStatistics(vlUInt uiFrame, vlUInt uiFace, vlUInt uiSlice, vlUInt uiMipmapLevel, SVTFImageStatistics &Statistics) const;
+		vlBool ComputePreview(vlUInt uiFrame, vlUInt uiFace, vlUInt uiSlice, vlByte *lpDestRGBA8888, vlUInt uiDestWidth, vlUInt uiDestHeight) const;
+		vlBool ComputeCRC(vlUInt &uiCRC) const;
 	
 	public:
 		static SVTFImageFormatInfo const &GetImageFormatInfo(VTFImageFormat ImageFormat);
@@ -961,27 +1703,48 @@ namespace VTFLib
 
 	public:
 		static vlBool ConvertToRGBA8888(vlByte *lpSource, vlByte *lpDest, vlUInt uiWidth, vlUInt uiHeight, VTFImageFormat SourceFormat);
+		static vlBool ConvertToRGBA8888(vlByte *lpSource, vlByte *lpDest, vlUInt uiWidth, vlUInt uiHeight, VTFImageFormat SourceFormat, const SVTFLibOptions &Options);
 		static vlBool ConvertFromRGBA8888(vlByte *lpSource, vlByte *lpDest, vlUInt uiWidth, vlUInt uiHeight, VTFImageFormat DestFormat);
+		static vlBool ConvertFromRGBA8888(vlByte *lpSource, vlByte *lpDest, vlUInt uiWidth, vlUInt uiHeight, VTFImageFormat DestFormat, const SVTFLibOptions &Options);
 		static vlBool Convert(vlByte *lpSource, vlByte *lpDest, vlUInt uiWidth, vlUInt uiHeight, VTFImageFormat SourceFormat, VTFImageFormat DestFormat);
+		static vlBool Convert(vlByte *lpSource, vlByte *lpDest, vlUInt uiWidth, vlUInt uiHeight, VTFImageFormat SourceFormat, VTFImageFormat DestFormat, const SVTFLibOptions &Options);
+		static vlBool ConvertToRGBA8888(const CImageView &Source, const CImageView &Dest);
+		static vlBool ConvertToRGBA8888(const CImageView &Source, const CImageView &Dest, const SVTFLibOptions &Options);
+		static vlBool ConvertFromRGBA8888(const CImageView &Source, const CImageView &Dest);
+		static vlBool ConvertFromRGBA8888(const CImageView &Source, const CImageView &Dest, const SVTFLibOptions &Options);
+		static vlBool Convert(const CImageView &Source, const CImageView &Dest);
+		static vlBool Convert(const CImageView &Source, const CImageView &Dest, const SVTFLibOptions &Options);
 
 		static vlBool ConvertToNormalMap(vlByte *lpSourceRGBA8888, vlByte *lpDestRGBA8888, vlUInt uiWidth, vlUInt uiHeight, VTFKernelFilter KernelFilter = KERNEL_FILTER_3X3, VTFHeightConversionMethod HeightConversionMethod = HEIGHT_CONVERSION_METHOD_AVERAGE_RGB, VTFNormalAlphaResult NormalAlphaResult = NORMAL_ALPHA_RESULT_WHITE, vlByte bMinimumZ = 0, vlSingle sScale = 2.0f, vlBool bWrap = vlFalse, vlBool bInvertX = vlFalse, vlBool bInvertY = vlFalse);
 
 		static vlBool Resize(vlByte *lpSourceRGBA8888, vlByte *lpDestRGBA8888, vlUInt uiSourceWidth, vlUInt uiSourceHeight, vlUInt uiDestWidth, vlUInt uiDestHeight, VTFMipmapFilter ResizeFilter = MIPMAP_FILTER_TRIANGLE, VTFSharpenFilter SharpenFilter = SHARPEN_FILTER_NONE);
+		static vlBool Resize(vlByte *lpSourceRGBA8888, vlByte *lpDestRGBA8888, vlUInt uiSourceWidth, vlUInt uiSourceHeight, vlUInt uiDestWidth, vlUInt uiDestHeight, VTFMipmapFilter ResizeFilter, VTFSharpenFilter SharpenFilter, const SVTFLibOptions &Options);
+		static vlBool Resize(const CImageView &Source, const CImageView &Dest, VTFMipmapFilter ResizeFilter = MIPMAP_FILTER_TRIANGLE, VTFSharpenFilter SharpenFilter = SHARPEN_FILTER_NONE);
+		static vlBool Resize(const CImageView &Source, const CImageView &Dest, VTFMipmapFilter ResizeFilter, VTFSharpenFilter SharpenFilter, const SVTFLibOptions &Options);
 
 	private:
 		static vlBool DecompressDXT1(vlByte *src, vlByte *dst, vlUInt uiWidth, vlUInt uiHeight);
 		static vlBool DecompressDXT3(vlByte *src, vlByte *dst, vlUInt uiWidth, vlUInt uiHeight);
 		static vlBool DecompressDXT5(vlByte *src, vlByte *dst, vlUInt uiWidth, vlUInt uiHeight);
 
-		static vlBool CompressDXTn(vlByte *lpSource, vlByte *lpDest, vlUInt uiWidth, vlUInt uiHeight, VTFImageFormat DestFormat);
+		static vlBool CompressDXTn(vlByte *lpSource, vlByte *lpDest, vlUInt uiWidth, vlUInt uiHeight, VTFImageFormat DestFormat, const SVTFLibOptions &Options);
 
 	public:
 		static vlVoid CorrectImageGamma(vlByte *lpImageDataRGBA8888, vlUInt uiWidth, vlUInt uiHeight, vlSingle sGammaCorrection);
 
 		static vlVoid ComputeImageReflectivity(vlByte *lpImageDataRGBA8888, vlUInt uiWidth, vlUInt uiHeight, vlSingle &sX, vlSingle &sY, vlSingle &sZ);
+		static vlBool ComputeImageStatistics(vlByte *lpSource, vlUInt uiWidth, vlUInt uiHeight, VTFImageFormat SourceFormat, SVTFImageStatistics &Statistics);
+		static vlBool ComputeImageStatistics(vlByte *lpSource, vlUInt uiWidth, vlUInt uiHeight, VTFImageFormat SourceFormat, SVTFImageStatistics &Statistics, const SVTFLibOptions &Options);
+		static vlBool ComputeImagePreview(vlByte *lpSource, vlUInt uiWidth, vlUInt uiHeight, VTFImageFormat SourceFormat, vlByte *lpDestRGBA8888, vlUInt uiDestWidth, vlUInt uiDestHeight);
+		static vlBool ComputeImagePreview(vlByte *lpSource, vlUInt uiWidth, vlUInt uiHeight, VTFImageFormat SourceFormat, vlByte *lpDestRGBA8888, vlUInt uiDestWidth, vlUInt uiDestHeight, const SVTFLibOptions &Options);
 
 		static vlVoid FlipImage(vlByte *lpImageDataRGBA8888, vlUInt uiWidth, vlUInt uiHeight);
 		static vlVoid MirrorImage(vlByte *lpImageDataRGBA8888, vlUInt uiWidth, vlUInt uiHeight);
+		static vlBool FlipImage(const CImageView &Image);
+		static vlBool MirrorImage(const CImageView &Image);
+
+		static vlBool TransformImage(const CImageView &Source, const CImageView &Dest, VTFImageTransform Transform);
+		static vlBool TransformImage(vlByte *lpSource, vlByte *lpDest, vlUInt uiWidth, vlUInt uiHeight, VTFImageFormat ImageFormat, VTFImageTransform Transform);
 	};
 
 	//
@@ -991,6 +1754,8 @@ namespace VTFLib
 	{
 	private:
 		Nodes::CVMTGroupNode *Root;
+		Nodes::CVMTArena *Arena;
+		SVTFLibOptions *lpOptions;
 
 	public:
 		CVMTFile();
@@ -1006,15 +1771,22 @@ namespace VTFLib
 		vlBool Load(const vlChar *cFileName);
 		vlBool Load(const vlVoid *lpData, vlUInt uiBufferSize);
 		vlBool Load(vlVoid *pUserData);
+		vlBool Load(const CVPKFile &Package, const vlChar *cPath);
 
 		vlBool Save(const vlChar *cFileName) const;
 		vlBool Save(vlVoid *lpData, vlUInt uiBufferSize, vlUInt &uiSize) const;
 		vlBool Save(vlVoid *pUserData) const;
 
+		vlBool LoadBinary(const vlVoid *lpData, vlUInt uiSize);
+		vlBool SaveBinary(vlVoid *lpData, vlUInt uiBufferSize, vlUInt &uiSize) const;
+
 	private:
 		vlBool Load(IO::Readers::IReader *Reader);
+		vlBool Parse(const vlChar *lpText, vlUInt uiTextSize);
 		vlBool Save(IO::Writers::IWriter *Writer) const;
 
+		Nodes::CVMTArena *GetArena();
+
 		//Nodes::CVMTNode *Load(IO::Readers::IReader *Reader, vlBool bInGroup);
 
 		vlVoid Indent(IO::Writers::IWriter *Writer, vlUInt uiLevel) const;
@@ -1022,6 +1794,187 @@ namespace VTFLib
 
 	public:
 		Nodes::CVMTGroupNode *GetRoot() const;
+
+		const SVTFLibOptions *GetOptions() const;
+		vlVoid SetOptions(const SVTFLibOptions *Options);
+	};
+
+	namespace IO
+	{
+		//
+		// CAsyncIO
+		//
+		class CAsyncIOState;
+		class VTFLIB_API CAsyncIO
+		{
+		private:
+			CAsyncIOState *State;
+
+		public:
+			CAsyncIO(vlUInt uiThreads = 0, vlUInt uiMemoryLimit = 0);
+			~CAsyncIO();
+
+		private:
+			CAsyncIO(const CAsyncIO &);
+			CAsyncIO &operator=(const CAsyncIO &);
+
+		public:
+			vlVoid QueueRead(const vlChar *cFileName);
+			vlBool HasNext() const;
+			vlBool ReadNext(const vlChar *&cFileName, const vlByte *&lpData, vlUInt &uiSize);
+
+			vlBool Write(const vlChar *cFileName, const vlVoid *lpData, vlUInt uiSize);
+			vlBool Write(const vlChar *cFileName, const CVTFFile &Image);
+			vlBool Flush();
+
+		private:
+			vlBool Queue(const vlChar *cFileName, vlByte *lpData, vlUInt uiSize);
+		};
+	}
+
+	//
+	// CVMTCache
+	//
+	class CVMTCacheState;
+	class VTFLIB_API CVMTCache
+	{
+	private:
+		CVMTCacheState *State;
+
+	public:
+		CVMTCache();
+		~CVMTCache();
+
+	private:
+		CVMTCache(const CVMTCache &);
+		CVMTCache &operator=(const CVMTCache &);
+
+	public:
+		vlBool Open(const vlChar *cFileName);
+		vlVoid Close();
+
+		vlBool Save(const vlChar *cFileName);
+
+		vlUInt GetMaterialCount() const;
+
+	public:
+		vlBool Load(const vlChar *cPath, vlUInt64 uiModified, CVMTFile &File) const;
+		vlBool Add(const vlChar *cPath, vlUInt64 uiModified, const CVMTFile &File);
+		vlBool Load(const vlChar *cFileName, CVMTFile &File);
+
+		vlUInt GetHitCount() const;
+		vlUInt GetMissCount() const;
+	};
+
+	//
+	// CMaterialGraph
+	//
+	class CMaterialGraphState;
+	class VTFLIB_API CMaterialGraph
+	{
+	private:
+		CMaterialGraphState *State;
+
+	public:
+		CMaterialGraph();
+		~CMaterialGraph();
+
+	private:
+		CMaterialGraph(const CMaterialGraph &);
+		CMaterialGraph &operator=(const CMaterialGraph &);
+
+	public:
+		vlVoid Destroy();
+
+		vlBool Load(const vlChar *cFileName);
+		vlBool Save(const vlChar *cFileName) const;
+		vlBool Scan(const vlChar *cRoot, vlUInt uiThreads = 0);
+
+		const vlChar *GetRoot() const;
+
+		vlUInt GetParsedCount() const;
+		vlUInt GetReusedCount() const;
+
+	public:
+		vlUInt GetMaterialCount() const;
+		vlUInt FindMaterial(const vlChar *cName) const;
+
+		const vlChar *GetMaterialName(vlUInt uiMaterial) const;
+		const vlChar *GetMaterialShader(vlUInt uiMaterial) const;
+		const vlChar *GetMaterialError(vlUInt uiMaterial) const;
+
+		vlUInt GetReferenceCount(vlUInt uiMaterial) const;
+		MaterialReferenceType GetReferenceType(vlUInt uiMaterial, vlUInt uiReference) const;
+		const vlChar *GetReferenceName(vlUInt uiMaterial, vlUInt uiReference) const;
+
+		const vlChar *Resolve(const vlChar *cName, MaterialReferenceType ReferenceType) const;
+
+	public:
+		static vlVoid NormalizeName(const vlChar *cPath, vlChar *cName, vlUInt uiNameSize);
+	};
+
+	//
+	// CVPKFile
+	//
+	class CVPKFileState;
+	class VTFLIB_API CVPKFile
+	{
+	private:
+		CVPKFileState *State;
+
+	public:
+		CVPKFile();
+		~CVPKFile();
+
+	private:
+		CVPKFile(const CVPKFile &);
+		CVPKFile &operator=(const CVPKFile &);
+
+	public:
+		vlBool Open(const vlChar *cFileName);
+		vlVoid Close();
+
+		vlUInt GetEntryCount() const;
+		vlUInt FindEntry(const vlChar *cPath) const;
+
+		const vlChar *GetEntryName(vlUInt uiEntry) const;
+		vlUInt GetEntrySize(vlUInt uiEntry) const;
+		vlUInt GetEntryCRC(vlUInt uiEntry) const;
+
+		vlBool GetEntryData(vlUInt uiEntry, const vlVoid *&lpPreload, vlUInt &uiPreloadSize, const vlVoid *&lpData, vlUInt &uiDataSize) const;
+	};
+
+	//
+	// CBSPFile
+	//
+	class CBSPFileState;
+	class VTFLIB_API CBSPFile
+	{
+	private:
+		CBSPFileState *State;
+
+	public:
+		CBSPFile();
+		~CBSPFile();
+
+	private:
+		CBSPFile(const CBSPFile &);
+		CBSPFile &operator=(const CBSPFile &);
+
+	public:
+		vlBool Open(const vlChar *cFileName);
+		vlBool Save(const vlChar *cFileName);
+		vlVoid Close();
+
+		vlUInt GetEntryCount() const;
+		vlUInt FindEntry(const vlChar *cPath) const;
+
+		const vlChar *GetEntryName(vlUInt uiEntry) const;
+		vlUInt GetEntrySize(vlUInt uiEntry) const;
+
+	public:
+		vlBool Add(const vlChar *cPath, const vlVoid *lpData, vlUInt uiSize);
+		vlBool AddFile(const vlChar *cPath, const vlChar *cFileName);
 	};
 }
 #endif
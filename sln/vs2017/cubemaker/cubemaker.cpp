@@ -1,5 +1,12 @@
+#include <algorithm>
 #include <iostream>
+#include <string>
+#include <vector>
 
+#include <AsyncIO.h>
+#include <BSPFile.h>
+#include <MaterialGraph.h>
+#include <VPKFile.h>
 #include <VTFFile.h>
 #include <VTFLib.h>
 #include <fp16.h>
@@ -13,9 +20,19 @@ you can hide and show at any time.
 
 Drag one of the files ending in ft,bk,rt,lf,up,dn onto the program. 
 
-All 6 of these VTF files must be in the same directory. Sometimes the dn VTF is missing. Open the VMT 
-file with the same name, find the VTF it points to, copy and paste it into the same folder as the VMT 
-and give it the same name except with the extension VTF.
+All 6 of these VTF files should be in the same directory. Sometimes a face like the dn VTF is missing
+and its VMT points at another texture instead. If the skybox is inside a materials folder, the VMTs are
+followed to the real VTF automatically. The references of every material are cached in a .vmtgraph
+file next to the materials folder so later runs only read the materials that changed.
+
+Faces that aren't on disk at all can be read from the game's packages. Pass the _dir.vpk files
+after the skybox file, or drop them onto the program together with it:
+
+    cubemaker sky_day01_01ft.vtf "...\Team Fortress 2\hl2\hl2_textures_dir.vpk"
+
+To pack the cubemap into a compiled map instead of running bspzip, pass the .bsp the same way. The
+files are added to the map's pakfile under materials/cubemap_skyboxes/, replacing ones packed before,
+and only the pakfile is rewritten.
 
 4 files will be created: theskybox_cubemap.vtf, theskybox_cubemap.vtf.hq, theskybox_cubemap.vmt, theskybox_cubemap.hdr.vmt
 
@@ -186,10 +203,10 @@ void PressKeyToContinue()
     int junk = getchar();
 }
 
-VTFLib::CVTFFile* LoadVTF(const char* filename)
+VTFLib::CVTFFile* LoadVTF(const vlByte* data, vlUInt size)
 {
     auto f = new VTFLib::CVTFFile();
-    f->Load(filename, false);
+    f->Load(data, size, false);
     if (f->IsLoaded() == false)
     {
         delete f;
@@ -198,6 +215,11 @@ VTFLib::CVTFFile* LoadVTF(const char* filename)
     return f;
 }
 
+void FreeCubeData(vlVoid* data, vlVoid* user_data)
+{
+    free(data);
+}
+
 void Rotate90CW(vlByte* p, vlUInt width, vlUInt height)
 {
     vlUInt* image = (vlUInt*)p;
@@ -229,6 +251,158 @@ const char* g_faceorder[] = {
     "dn"
 };
 
+// the flips and rotations of the switch in main as single transforms, for faces kept compressed
+const VTFImageTransform g_facetransform[] = {
+    VTFImageTransform::IMAGE_TRANSFORM_TRANSPOSE,  // flip, rotate 3 times
+    VTFImageTransform::IMAGE_TRANSFORM_TRANSVERSE, // flip, rotate
+    VTFImageTransform::IMAGE_TRANSFORM_FLIP,
+    VTFImageTransform::IMAGE_TRANSFORM_MIRROR,
+    VTFImageTransform::IMAGE_TRANSFORM_FLIP,
+    VTFImageTransform::IMAGE_TRANSFORM_MIRROR
+};
+
+// returns the length of the materials folder in path, including the folder name, or 0 if it isn't in one
+size_t FindMaterialsRoot(const char* path)
+{
+    size_t root = 0;
+    for (const char* p = path; *p; p++)
+    {
+        if ((*p == '\\' || *p == '/') && _strnicmp(p + 1, "materials", 9) == 0 && (p[10] == '\\' || p[10] == '/'))
+        {
+            root = p + 10 - path;
+        }
+    }
+    return root;
+}
+
+// finds the VTF a face's material really uses when it isn't next to the VMT.
+// the graph is loaded and refreshed on the first call.
+bool ResolveFace(VTFLib::CMaterialGraph& graph, bool& scanned, const char* base, const char* face, char* out, size_t out_size)
+{
+    size_t root_length = FindMaterialsRoot(base);
+    if (root_length == 0)
+    {
+        return false;
+    }
+
+    std::string root(base, root_length);
+    if (!scanned)
+    {
+        scanned = true;
+        std::string cache = root + ".vmtgraph";
+        graph.Load(cache.c_str());
+        if (!graph.Scan(root.c_str()))
+        {
+            printf("failed to scan %s: %s\n", root.c_str(), vlGetLastError());
+            return false;
+        }
+        printf("scanned %s: %u materials, %u parsed, %u cached\n", root.c_str(), graph.GetMaterialCount(), graph.GetParsedCount(), graph.GetReusedCount());
+        if (!graph.Save(cache.c_str()))
+        {
+            printf("failed to save %s: %s\n", cache.c_str(), vlGetLastError());
+        }
+    }
+
+    std::string material = std::string(base + root_length + 1) + face;
+    const char* texture = graph.Resolve(material.c_str(), MATERIAL_REFERENCE_BASETEXTURE);
+    if (texture == NULL)
+    {
+        printf("%s\n", vlGetLastError());
+        return false;
+    }
+
+    std::string path = root + "\\" + texture + ".vtf";
+    std::replace(path.begin(), path.end(), '/', '\\');
+    snprintf(out, out_size, "%s", path.c_str());
+    return true;
+}
+
+// adds the cubemap files to the map's pakfile at the default path, replacing any packed before.
+// only the pakfile is rewritten, the rest of the map is copied across as is.
+bool PackIntoMap(const char* map_name, const char* base, const char* base_nopath)
+{
+    const char* suffixes[] = { "_cubemap.vtf", "_cubemap.hdr.vtf", "_cubemap.vmt" };
+
+    VTFLib::CBSPFile map;
+    if (!map.Open(map_name))
+    {
+        printf("failed to open %s: %s\n", map_name, vlGetLastError());
+        return false;
+    }
+
+    for (auto suffix : suffixes)
+    {
+        std::string file = std::string(base) + suffix;
+        std::string path = std::string("materials/cubemap_skyboxes/") + base_nopath + suffix;
+        if (!map.AddFile(path.c_str(), file.c_str()))
+        {
+            printf("failed to add %s to %s: %s\n", file.c_str(), map_name, vlGetLastError());
+            return false;
+        }
+    }
+
+    if (!map.Save(map_name))
+    {
+        printf("failed to save %s: %s\n", map_name, vlGetLastError());
+        return false;
+    }
+
+    printf("packed into %s: %u files\n", map_name, map.GetEntryCount());
+    return true;
+}
+
+// finds a face that isn't on disk in the packages, following its VMT if the VTF isn't packaged.
+// the face is looked for at the path it would have in a materials folder, skybox/ if base isn't in one.
+VTFLib::CVPKFile* FindPackagedFace(const std::vector<VTFLib::CVPKFile*>& packages, const char* base, const char* base_nopath, const char* face, std::string& out)
+{
+    size_t root_length = FindMaterialsRoot(base);
+    std::string material = std::string("materials/") + (root_length != 0 ? std::string(base + root_length + 1) : std::string("skybox/") + base_nopath) + face;
+
+    for (auto package : packages)
+    {
+        if (package->FindEntry((material + ".vtf").c_str()) != VPK_INVALID_INDEX)
+        {
+            out = material + ".vtf";
+            return package;
+        }
+    }
+
+    for (auto package : packages)
+    {
+        VTFLib::CVMTFile vmt;
+        if (!vmt.Load(*package, (material + ".vmt").c_str()))
+        {
+            continue;
+        }
+
+        auto node = vmt.GetRoot()->GetNode("$basetexture");
+        if (node == NULL || node->GetType() != NODE_TYPE_STRING)
+        {
+            continue;
+        }
+
+        char texture[MAX_PATH];
+        VTFLib::CMaterialGraph::NormalizeName(static_cast<VTFLib::Nodes::CVMTStringNode*>(node)->GetValue(), texture, sizeof(texture));
+        std::string path = std::string("materials/") + texture + ".vtf";
+        for (auto other : packages)
+        {
+            if (other->FindEntry(path.c_str()) != VPK_INVALID_INDEX)
+            {
+                out = path;
+                return other;
+            }
+        }
+    }
+
+    return NULL;
+}
+
+bool IsBlockTransformable(VTFImageFormat format)
+{
+    return format == VTFImageFormat::IMAGE_FORMAT_DXT1 || format == VTFImageFormat::IMAGE_FORMAT_DXT1_ONEBITALPHA ||
+        format == VTFImageFormat::IMAGE_FORMAT_DXT3 || format == VTFImageFormat::IMAGE_FORMAT_DXT5;
+}
+
 int main(int argc, char* argv[])
 {
     printf(g_banner);
@@ -239,7 +413,42 @@ int main(int argc, char* argv[])
         return 0;
     }
 
-    char* base = argv[1];
+    // dropped files come in any order, so packages and maps are told apart by their extension
+    char* base = NULL;
+    char* map_name = NULL;
+    std::vector<VTFLib::CVPKFile*> packages;
+    for (int i = 1; i < argc; i++)
+    {
+        if (EndsWith(argv[i], ".bsp"))
+        {
+            map_name = map_name == NULL ? argv[i] : map_name;
+            continue;
+        }
+
+        if (!EndsWith(argv[i], ".vpk"))
+        {
+            base = base == NULL ? argv[i] : base;
+            continue;
+        }
+
+        auto package = new VTFLib::CVPKFile();
+        if (!package->Open(argv[i]))
+        {
+            printf("failed to open %s: %s\n", argv[i], vlGetLastError());
+            delete package;
+            continue;
+        }
+        printf("opened %s: %u files\n", argv[i], package->GetEntryCount());
+        packages.push_back(package);
+    }
+
+    if (base == NULL)
+    {
+        printf(g_usage, argv[0]);
+        PressKeyToContinue();
+        return 0;
+    }
+
     char base_nopath[MAX_PATH];
 
     auto errnum = _splitpath_s(base, NULL, 0, NULL, 0, base_nopath, sizeof(base_nopath), NULL, 0);
@@ -268,6 +477,41 @@ int main(int argc, char* argv[])
     strcpy_s(base_nopath, R"(sky_skylab_01)");
     */
 
+    // All 6 faces are read at once, and each output is written while the next is encoded.
+    VTFLib::IO::CAsyncIO io;
+    VTFLib::CMaterialGraph graph;
+    bool scanned = false;
+
+    // faces found in a package are read from it instead of the disk
+    VTFLib::CVPKFile* packaged[6]{};
+    std::string packaged_name[6];
+
+    for (int i = 0; i < 6; i++)
+    {
+        char name[MAX_PATH];
+        snprintf(name, sizeof(name), "%s%s.vtf", base, g_faceorder[i]);
+        // a face without its own VTF uses whatever texture its VMT points at
+        if (GetFileAttributesA(name) == INVALID_FILE_ATTRIBUTES)
+        {
+            char resolved[MAX_PATH];
+            if (ResolveFace(graph, scanned, base, g_faceorder[i], resolved, sizeof(resolved)))
+            {
+                printf("%s%s.vtf is missing, using %s\n", base_nopath, g_faceorder[i], resolved);
+                snprintf(name, sizeof(name), "%s", resolved);
+            }
+        }
+        if (GetFileAttributesA(name) == INVALID_FILE_ATTRIBUTES && !packages.empty())
+        {
+            packaged[i] = FindPackagedFace(packages, base, base_nopath, g_faceorder[i], packaged_name[i]);
+            if (packaged[i] != NULL)
+            {
+                printf("%s%s.vtf is missing, using %s from a package\n", base_nopath, g_faceorder[i], packaged_name[i].c_str());
+                continue;
+            }
+        }
+        io.QueueRead(name);
+    }
+
     VTFLib::CVTFFile* faces[6]{};
 
     vlUInt width = 0;
@@ -275,9 +519,21 @@ int main(int argc, char* argv[])
 
     for (int i = 0; i < 6; i++)
     {
-        char name[256];
-        snprintf(name, sizeof(name), "%s%s.vtf", base, g_faceorder[i]);
-        faces[i] = LoadVTF(name);
+        const char* name;
+        const vlByte* data;
+        vlUInt size;
+        if (packaged[i] != NULL)
+        {
+            name = packaged_name[i].c_str();
+            faces[i] = new VTFLib::CVTFFile();
+            if (!faces[i]->Load(*packaged[i], name))
+            {
+                delete faces[i];
+                faces[i] = NULL;
+            }
+        }
+        else if (io.ReadNext(name, data, size))
+            faces[i] = LoadVTF(data, size);
         if (faces[i] == NULL)
         {
             printf("failed to load file %s\n", name);
@@ -309,6 +565,36 @@ int main(int argc, char* argv[])
     }
     auto cubemap = VTFLib::CVTFFile();
 
+    // when every face is already DXTn at the final size, the LDR cubemap is put together from the
+    // compressed blocks, which are rotated without decoding them. only the sphere map gets compressed.
+    auto passthroughFormat = faces[0]->GetFormat();
+    bool passthrough = width % 4 == 0 && IsBlockTransformable(passthroughFormat);
+    for (int i = 0; i < 6; i++)
+    {
+        passthrough = passthrough && faces[i]->GetFormat() == passthroughFormat && faces[i]->GetWidth() == width && faces[i]->GetHeight() == height;
+    }
+
+    auto ldr = VTFLib::CVTFFile();
+    if (passthrough)
+    {
+        printf("faces are all %s, keeping them compressed\n", VTFLib::CVTFFile::GetImageFormatInfo(passthroughFormat).lpName);
+        if (!ldr.Create(width, height, 1, 7, 1, passthroughFormat, true, false, false))
+        {
+            printf("Create Error %s\n", vlGetLastError());
+            PressKeyToContinue();
+            std::terminate();
+        }
+    }
+
+    // all faces live in one block with room for the sphere map face, which the cubemap takes over without copying
+    vlUInt face_size = 4 * width * height;
+    vlUInt cube_data_size = face_size * 7;
+    vlByte* cube_data = (vlByte*)malloc(cube_data_size);
+    if (cube_data == NULL)
+    {
+        std::terminate();
+    }
+
     vlByte* main_buffer[6];
     RGBA8 lastPixel[6]; // get the last pixel for face sides for stretching method
     RGBA8 lastPixelAverage{};
@@ -318,7 +604,14 @@ int main(int argc, char* argv[])
     {
         auto face_width = faces[i]->GetWidth();
         auto face_height = faces[i]->GetHeight();
-        main_buffer[i] = (vlByte*)malloc(4 * face_height * face_width);
+        if (face_width == width && face_height == height)
+        {
+            main_buffer[i] = cube_data + face_size * i;
+        }
+        else
+        {
+            main_buffer[i] = (vlByte*)malloc(4 * face_height * face_width);
+        }
         auto oldFormat = faces[i]->GetFormat();
 
         // gamma correction for HDR formats
@@ -346,6 +639,18 @@ int main(int argc, char* argv[])
                 new_ptr[j].a = (unsigned char)(old_ptr[j].a * 255.0f);
             }
         }
+        else if (passthrough)
+        {
+            // rotate first so the decoded face is already in place, it decodes the same either way
+            auto success = VTFLib::CVTFFile::TransformImage(faces[i]->GetData(0, 0, 0, 0), ldr.GetData(0, i, 0, 0), width, height, oldFormat, g_facetransform[i]) &&
+                cubemap.ConvertToRGBA8888(ldr.GetData(0, i, 0, 0), main_buffer[i], width, height, oldFormat);
+            if (!success)
+            {
+                printf("TransformImage %s %s\n", g_faceorder[i], vlGetLastError());
+                PressKeyToContinue();
+                std::terminate();
+            }
+        }
         else
         {
             auto success = cubemap.ConvertToRGBA8888(faces[i]->GetData(0, 0, 0, 0), main_buffer[i], face_width, face_height, oldFormat);
@@ -378,7 +683,8 @@ int main(int argc, char* argv[])
         lastPixelAverage.a = (vlByte)round(a / 4.0);
     }
 
-    for(int i = 0; i < 6; i++)
+    // passthrough faces have the right size and were rotated while compressed
+    for(int i = 0; i < 6 && !passthrough; i++)
     {
         auto face_width = faces[i]->GetWidth();
         auto face_height = faces[i]->GetHeight();
@@ -393,7 +699,7 @@ int main(int argc, char* argv[])
             if (i >= 0 && i <= 3 && face_width > face_height)
             {
                 printf("padding rectangular side face\n");
-                vlByte* resized = (vlByte*)malloc(4 * face_width * face_width);
+                vlByte* resized = face_width == width ? cube_data + face_size * i : (vlByte*)malloc(4 * face_width * face_width);
                 memcpy(resized, main_buffer[i], 4 * face_width * face_height);
                 RGBA8* resizedPixelPtr = (RGBA8*)resized;
                 for (vlUInt i = face_width * face_height; i < face_width * face_width; i++)
@@ -409,7 +715,7 @@ int main(int argc, char* argv[])
 
             if (!skip_resize)
             {
-                vlByte* resized = (vlByte*)malloc(4 * height * width);
+                vlByte* resized = cube_data + face_size * i;
                 VTFMipmapFilter filter;
                 if (face_width * face_height < width * height)
                 {
@@ -493,7 +799,7 @@ int main(int argc, char* argv[])
 
     printf("Building cubemap\n");
     bool success;
-    success = cubemap.Create(width, height, 1, 6, 1, (vlByte**)&main_buffer, options);
+    success = cubemap.Create(width, height, 1, 6, 1, cube_data, cube_data_size, FreeCubeData, NULL, options);
     if (!success)
     {
         printf("Create Error %s\n", vlGetLastError());
@@ -501,10 +807,39 @@ int main(int argc, char* argv[])
         std::terminate();
     }
 
-    auto ldr = VTFLib::CVTFFile(cubemap, VTFImageFormat::IMAGE_FORMAT_DXT5);
+    if (passthrough)
+    {
+        success = cubemap.ConvertFromRGBA8888(cubemap.GetData(0, 6, 0, 0), ldr.GetData(0, 6, 0, 0), width, height, passthroughFormat);
+        if (!success)
+        {
+            printf("Sphere map Error %s\n", vlGetLastError());
+            PressKeyToContinue();
+            std::terminate();
+        }
+
+        // match the header the converted copy would have had
+        vlSingle x, y, z;
+        cubemap.GetReflectivity(x, y, z);
+        ldr.SetReflectivity(x, y, z);
+        ldr.SetBumpmapScale(cubemap.GetBumpmapScale());
+        ldr.SetFlags((cubemap.GetFlags() & ~TEXTUREFLAGS_ONEBITALPHA) | (ldr.GetFlags() & TEXTUREFLAGS_ONEBITALPHA));
+        ldr.SetStartFrame(cubemap.GetStartFrame());
+        ldr.SetThumbnailData(cubemap.GetThumbnailData());
+        if (!ldr.SetVersion(cubemap.GetMajorVersion(), cubemap.GetMinorVersion()))
+        {
+            printf("Version Error %s\n", vlGetLastError());
+            PressKeyToContinue();
+            std::terminate();
+        }
+    }
+    else
+    {
+        ldr = VTFLib::CVTFFile(cubemap, VTFImageFormat::IMAGE_FORMAT_DXT5);
+    }
+
     char output_name[FILENAME_MAX];
     snprintf(output_name, sizeof(output_name), "%s_cubemap.vtf", base);
-    success = ldr.Save(output_name);
+    success = io.Write(output_name, ldr);
     if (!success)
     {
         printf("LDR Save Error %s\n", vlGetLastError());
@@ -515,7 +850,7 @@ int main(int argc, char* argv[])
 
     auto ldr_hq = VTFLib::CVTFFile(cubemap, VTFImageFormat::IMAGE_FORMAT_RGB888);
     snprintf(output_name, sizeof(output_name), "%s_cubemap.vtf.hq", base);
-    success = ldr_hq.Save(output_name);
+    success = io.Write(output_name, ldr_hq);
     if (!success)
     {
         printf("LDR high quality Save Error %s\n", vlGetLastError());
@@ -527,7 +862,7 @@ int main(int argc, char* argv[])
     auto hdr = VTFLib::CVTFFile(cubemap, VTFImageFormat::IMAGE_FORMAT_RGBA16161616F);
     ConvertImageToFloat(&hdr, &cubemap);
     snprintf(output_name, sizeof(output_name), "%s_cubemap.hdr.vtf", base);
-    success = hdr.Save(output_name);
+    success = io.Write(output_name, hdr);
     if (!success)
     {
         printf("HDR Save Error %s\n", vlGetLastError());
@@ -536,6 +871,13 @@ int main(int argc, char* argv[])
     }
     hdr.Destroy();
 
+    if (!io.Flush())
+    {
+        printf("Save Error %s\n", vlGetLastError());
+        PressKeyToContinue();
+        std::terminate();
+    }
+
     /*
     auto hdr_lq = VTFLib::CVTFFile(cubemap, VTFImageFormat::IMAGE_FORMAT_BGRA8888);
     ConvertImageToBGRA(&hdr_lq);
@@ -565,6 +907,12 @@ int main(int argc, char* argv[])
     fprintf(f, g_vmt_template, base_nopath);
     fclose(f);
 
+    if (map_name != NULL && !PackIntoMap(map_name, base, base_nopath))
+    {
+        PressKeyToContinue();
+        std::terminate();
+    }
+
     printf(g_completed, base_nopath);
     PressKeyToContinue();
 
@@ -0,0 +1,870 @@
+#include <windows.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <VTFFile.h>
+#include <VTFLib.h>
+
+const char* g_banner = "VTFLib Benchmark\n\n";
+
+const char* g_usage = \
+R"(Times VTFLib on a synthetic texture corpus and writes the results as JSON.  The corpus is generated
+from fixed seeds so results from different builds can be compared directly.
+
+vtfbench [-quick] [-samples n] [-filter text] [-out file] [-cubemaker exe]
+    -quick                       largest size 1024 instead of 4096, fewer samples
+    -samples n                   timed samples per benchmark, default 5 (3 with -quick)
+    -filter text                 only run benchmarks whose id contains text, e.g. convert/DXT1
+    -out file                    JSON output, default vtfbench.json
+    -cubemaker exe               cubemaker to time end to end, default the one next to vtfbench
+
+vtfbench -corpus <folder> [-quick]
+    Writes the corpus to the folder as VTF files instead of timing anything.
+
+The JSON is {"schema": "vtfbench-1", "vtflib": version, "quick": bool, "samples": n, "results": [...]}
+with one result per benchmark, always in the same order:
+    "id"          group and parameters joined with /, unique and stable between builds
+    "group"       convert, decode, flip, mirror, load, save, spheremap, reflectivity, vmt, cubemaker
+    "params"      the parameters as strings
+    "status"      ok, failed or skipped
+    "error"       why it failed or was skipped, only when status is not ok
+    "bytes"       bytes processed by one operation
+    "ops"         operations per sample; fast operations are repeated so a sample lasts about 1 ms
+    "min_ns"      fastest sample, per operation
+    "median_ns"   median sample, per operation
+    "mb_per_s"    bytes / min_ns
+)";
+
+// -----------------------------------------------------------------------------------
+// timing and results
+// -----------------------------------------------------------------------------------
+
+typedef std::vector<std::pair<std::string, std::string>> Params;
+
+struct SResult
+{
+    std::string id;
+    std::string group;
+    Params params;
+    std::string status;
+    std::string error;
+    vlUInt64 bytes = 0;
+    vlUInt ops = 0;
+    double min_ns = 0.0;
+    double median_ns = 0.0;
+};
+
+struct SSettings
+{
+    bool quick = false;
+    vlUInt samples = 0;
+    std::string filter;
+    std::string out = "vtfbench.json";
+    std::string cubemaker;
+    std::string temp;
+};
+
+SSettings g_settings;
+std::vector<SResult> g_results;
+std::string g_error;    // set by benchmarks that fail outside VTFLib, otherwise the VTFLib error is used
+
+std::string MakeId(const std::string& group, const Params& params)
+{
+    std::string id = group;
+    for (auto& param : params)
+        id += "/" + param.second;
+    return id;
+}
+
+// VTFLib's last error on one line, without the "Error:" heading
+std::string LastError()
+{
+    std::string error = vlGetLastError();
+    if (error.compare(0, 7, "Error:\n") == 0)
+        error.erase(0, 7);
+    while (!error.empty() && (error.back() == '\n' || error.back() == ' '))
+        error.pop_back();
+    std::replace(error.begin(), error.end(), '\n', ' ');
+    return error;
+}
+
+SResult* AddResult(const std::string& group, const Params& params)
+{
+    std::string id = MakeId(group, params);
+    if (!g_settings.filter.empty() && id.find(g_settings.filter) == std::string::npos)
+        return NULL;
+
+    SResult result;
+    result.id = id;
+    result.group = group;
+    result.params = params;
+    g_results.push_back(result);
+    return &g_results.back();
+}
+
+void Skip(const std::string& group, const Params& params, const std::string& reason)
+{
+    SResult* result = AddResult(group, params);
+    if (result == NULL)
+        return;
+
+    result->status = "skipped";
+    result->error = reason;
+    printf("%-56s skipped: %s\n", result->id.c_str(), reason.c_str());
+}
+
+//
+// Times body, which processes bytes per call.  If the first call returns false the error
+// is recorded and nothing is timed.
+//
+void Run(const std::string& group, const Params& params, vlUInt64 bytes, const std::function<bool()>& body)
+{
+    SResult* result = AddResult(group, params);
+    if (result == NULL)
+        return;
+
+    result->bytes = bytes;
+
+    typedef std::chrono::high_resolution_clock Clock;
+
+    g_error.clear();
+    auto start = Clock::now();
+    if (!body())
+    {
+        result->status = "failed";
+        result->error = g_error.empty() ? LastError() : g_error;
+        printf("%-56s failed: %s\n", result->id.c_str(), result->error.c_str());
+        return;
+    }
+    double first_ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+
+    // repeat fast operations so each sample is long enough for the clock
+    vlUInt ops = 1;
+    if (first_ns < 1e6)
+        ops = (vlUInt)std::min(65536.0, std::ceil(1e6 / std::max(first_ns, 1.0)));
+
+    std::vector<double> samples;
+    for (vlUInt i = 0; i < g_settings.samples; i++)
+    {
+        auto sample_start = Clock::now();
+        for (vlUInt j = 0; j < ops; j++)
+            body();
+        samples.push_back((double)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - sample_start).count() / ops);
+    }
+    std::sort(samples.begin(), samples.end());
+
+    result->status = "ok";
+    result->ops = ops;
+    result->min_ns = samples.front();
+    result->median_ns = samples[samples.size() / 2];
+
+    printf("%-56s %12.0f ns %10.1f MB/s\n", result->id.c_str(), result->min_ns, bytes / 1048576.0 / (result->min_ns / 1e9));
+}
+
+std::string JsonString(const std::string& str)
+{
+    std::string out = "\"";
+    for (char c : str)
+    {
+        switch (c)
+        {
+        case '"': out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        default:
+            if ((unsigned char)c < 0x20)
+            {
+                char escape[8];
+                snprintf(escape, sizeof(escape), "\\u%04x", (unsigned char)c);
+                out += escape;
+            }
+            else
+            {
+                out += c;
+            }
+        }
+    }
+    return out + "\"";
+}
+
+bool WriteJson(const char* filename)
+{
+    FILE* f = fopen(filename, "wb");
+    if (f == NULL)
+        return false;
+
+    fprintf(f, "{\n");
+    fprintf(f, "  \"schema\": \"vtfbench-1\",\n");
+    fprintf(f, "  \"vtflib\": %s,\n", JsonString(VL_VERSION_STRING).c_str());
+    fprintf(f, "  \"quick\": %s,\n", g_settings.quick ? "true" : "false");
+    fprintf(f, "  \"samples\": %u,\n", g_settings.samples);
+    fprintf(f, "  \"results\": [\n");
+    for (size_t i = 0; i < g_results.size(); i++)
+    {
+        auto& result = g_results[i];
+        fprintf(f, "    {\"id\": %s, \"group\": %s, \"params\": {", JsonString(result.id).c_str(), JsonString(result.group).c_str());
+        for (size_t j = 0; j < result.params.size(); j++)
+            fprintf(f, "%s%s: %s", j ? ", " : "", JsonString(result.params[j].first).c_str(), JsonString(result.params[j].second).c_str());
+        fprintf(f, "}, \"status\": %s", JsonString(result.status).c_str());
+        if (result.status != "ok")
+            fprintf(f, ", \"error\": %s", JsonString(result.error).c_str());
+        fprintf(f, ", \"bytes\": %llu, \"ops\": %u, \"min_ns\": %.0f, \"median_ns\": %.0f, \"mb_per_s\": %.2f}%s\n",
+            (unsigned long long)result.bytes, result.ops, result.min_ns, result.median_ns,
+            result.min_ns > 0.0 ? result.bytes / 1048576.0 / (result.min_ns / 1e9) : 0.0,
+            i + 1 < g_results.size() ? "," : "");
+    }
+    fprintf(f, "  ]\n");
+    fprintf(f, "}\n");
+
+    return fclose(f) == 0;
+}
+
+// -----------------------------------------------------------------------------------
+// corpus
+// -----------------------------------------------------------------------------------
+
+// format names without spaces, for ids and file names
+std::string FormatName(VTFImageFormat format)
+{
+    std::string name = VTFLib::CVTFFile::GetImageFormatInfo(format).lpName;
+    std::replace(name.begin(), name.end(), ' ', '_');
+    return name;
+}
+
+//
+// Formats VTFLib says it supports.  ATI1N and ATI2N are marked supported but have no size
+// calculation, so they can't be created or loaded and are left out.
+//
+std::vector<VTFImageFormat> SupportedFormats()
+{
+    std::vector<VTFImageFormat> formats;
+    for (vlInt i = 0; i < IMAGE_FORMAT_COUNT; i++)
+    {
+        VTFImageFormat format = (VTFImageFormat)i;
+        if (VTFLib::CVTFFile::GetImageFormatInfo(format).bIsSupported && VTFLib::CVTFFile::ComputeImageSize(4, 4, 1, format) != 0)
+            formats.push_back(format);
+    }
+    return formats;
+}
+
+std::vector<vlUInt> Sizes()
+{
+    std::vector<vlUInt> sizes = { 4, 16, 64, 256, 1024 };
+    if (!g_settings.quick)
+        sizes.push_back(4096);
+    return sizes;
+}
+
+std::string SizeName(vlUInt width, vlUInt height, vlUInt depth = 1)
+{
+    char name[64];
+    if (depth > 1)
+        snprintf(name, sizeof(name), "%ux%ux%u", width, height, depth);
+    else
+        snprintf(name, sizeof(name), "%ux%u", width, height);
+    return name;
+}
+
+//
+// Smooth gradients with noise on top and a varying alpha, so every format has something
+// to lose and DXT blocks aren't all flat.  The same seed always gives the same pixels.
+//
+void FillPattern(vlByte* rgba, vlUInt width, vlUInt height, vlUInt seed)
+{
+    vlUInt state = seed * 2654435761u + 1;
+    for (vlUInt y = 0; y < height; y++)
+    {
+        for (vlUInt x = 0; x < width; x++)
+        {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+
+            vlByte* pixel = rgba + ((size_t)y * width + x) * 4;
+            pixel[0] = (vlByte)((x * 255) / std::max(1u, width - 1) + (state & 15));
+            pixel[1] = (vlByte)((y * 255) / std::max(1u, height - 1) + ((state >> 4) & 15));
+            pixel[2] = (vlByte)(((x + y) * 127) / std::max(1u, width + height - 2) + (seed * 37));
+            pixel[3] = (vlByte)(((x ^ y) & 32) ? 255 : (state >> 8) & 255);
+        }
+    }
+}
+
+struct SCorpusImage
+{
+    std::string name;
+    VTFImageFormat format;
+    vlUInt width, height, depth;
+    vlUInt frames;
+    vlUInt faces;
+    bool mips;
+};
+
+//
+// Every supported format at 256 with mips, the common formats at every size with and
+// without mips, and the unusual layouts: cube maps with and without a sphere map,
+// animation and volumes.
+//
+std::vector<SCorpusImage> Corpus()
+{
+    std::vector<SCorpusImage> corpus;
+    auto add = [&](VTFImageFormat format, vlUInt width, vlUInt height, vlUInt depth, vlUInt frames, vlUInt faces, bool mips)
+    {
+        std::string name = FormatName(format) + "_" + SizeName(width, height, depth);
+        if (frames > 1)
+            name += "_" + std::to_string(frames) + "frames";
+        if (faces > 1)
+            name += "_" + std::to_string(faces) + "faces";
+        name += mips ? "_mips" : "_nomips";
+        corpus.push_back({ name, format, width, height, depth, frames, faces, mips });
+    };
+
+    for (auto format : SupportedFormats())
+        add(format, 256, 256, 1, 1, 1, true);
+
+    for (auto format : { IMAGE_FORMAT_RGBA8888, IMAGE_FORMAT_BGR888, IMAGE_FORMAT_DXT1, IMAGE_FORMAT_DXT5 })
+    {
+        for (auto size : Sizes())
+        {
+            add(format, size, size, 1, 1, 1, true);
+            add(format, size, size, 1, 1, 1, false);
+        }
+    }
+
+    for (auto format : { IMAGE_FORMAT_RGBA8888, IMAGE_FORMAT_DXT1 })
+    {
+        add(format, 256, 256, 1, 1, 6, true);
+        add(format, 256, 256, 1, 1, 7, true);
+        add(format, 256, 256, 1, 8, 1, true);
+        add(format, 64, 64, 16, 1, 1, true);
+    }
+
+    return corpus;
+}
+
+//
+// Builds a corpus image by converting the pattern straight into every subresource, so it
+// doesn't depend on mipmap filters or resizing.
+//
+bool BuildImage(const SCorpusImage& desc, vlUInt seed, VTFLib::CVTFFile& image)
+{
+    if (!image.Create(desc.width, desc.height, desc.frames, desc.faces, desc.depth, desc.format, vlFalse, desc.mips, vlFalse))
+        return false;
+
+    std::vector<vlByte> rgba;
+    for (vlUInt mip = 0; mip < image.GetMipmapCount(); mip++)
+    {
+        vlUInt width, height, depth;
+        VTFLib::CVTFFile::ComputeMipmapDimensions(desc.width, desc.height, desc.depth, mip, width, height, depth);
+        rgba.resize((size_t)width * height * 4);
+
+        for (vlUInt frame = 0; frame < desc.frames; frame++)
+        {
+            for (vlUInt face = 0; face < desc.faces; face++)
+            {
+                for (vlUInt slice = 0; slice < depth; slice++)
+                {
+                    FillPattern(rgba.data(), width, height, seed + frame * 1000 + face * 100 + slice);
+                    if (!VTFLib::CVTFFile::ConvertFromRGBA8888(rgba.data(), image.GetData(frame, face, slice, mip), width, height, desc.format))
+                        return false;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+int WriteCorpus(const char* folder)
+{
+    CreateDirectoryA(folder, NULL);
+
+    vlUInt written = 0, failed = 0;
+    auto corpus = Corpus();
+    for (size_t i = 0; i < corpus.size(); i++)
+    {
+        std::string path = std::string(folder) + "\\" + corpus[i].name + ".vtf";
+
+        VTFLib::CVTFFile image;
+        if (!BuildImage(corpus[i], (vlUInt)i, image) || !image.Save(path.c_str()))
+        {
+            printf("%s\n%s\n\n", path.c_str(), vlGetLastError());
+            failed++;
+            continue;
+        }
+        written++;
+    }
+
+    printf("%u files written, %u failed\n", written, failed);
+    return failed == 0 ? 0 : 1;
+}
+
+// -----------------------------------------------------------------------------------
+// benchmarks
+// -----------------------------------------------------------------------------------
+
+void BenchConvert()
+{
+    vlUInt size = g_settings.quick ? 64 : 256;
+    auto formats = SupportedFormats();
+
+    std::vector<vlByte> rgba((size_t)size * size * 4);
+    FillPattern(rgba.data(), size, size, 1);
+
+    std::vector<vlByte> source(VTFLib::CVTFFile::ComputeImageSize(size, size, 1, IMAGE_FORMAT_RGBA32323232F));
+    std::vector<vlByte> dest(source.size());
+
+    for (auto from : formats)
+    {
+        bool have_source = VTFLib::CVTFFile::ConvertFromRGBA8888(rgba.data(), source.data(), size, size, from) != vlFalse;
+        std::string source_error = have_source ? "" : LastError();
+
+        for (auto to : formats)
+        {
+            Params params = { { "from", FormatName(from) }, { "to", FormatName(to) }, { "size", SizeName(size, size) } };
+            if (!have_source)
+            {
+                Skip("convert", params, "could not make source data: " + source_error);
+                continue;
+            }
+
+            // VTFLib only converts between some formats, leave the rest out of the timings
+            if (!VTFLib::CVTFFile::Convert(source.data(), dest.data(), size, size, from, to))
+            {
+                Skip("convert", params, LastError());
+                continue;
+            }
+
+            Run("convert", params, VTFLib::CVTFFile::ComputeImageSize(size, size, 1, from), [&]()
+            {
+                return VTFLib::CVTFFile::Convert(source.data(), dest.data(), size, size, from, to) != vlFalse;
+            });
+        }
+    }
+}
+
+void BenchDecode()
+{
+    for (auto format : { IMAGE_FORMAT_DXT1, IMAGE_FORMAT_DXT1_ONEBITALPHA, IMAGE_FORMAT_DXT3, IMAGE_FORMAT_DXT5 })
+    {
+        for (auto size : Sizes())
+        {
+            Params params = { { "format", FormatName(format) }, { "size", SizeName(size, size) } };
+
+            std::vector<vlByte> rgba((size_t)size * size * 4);
+            FillPattern(rgba.data(), size, size, 2);
+
+            std::vector<vlByte> compressed(VTFLib::CVTFFile::ComputeImageSize(size, size, 1, format));
+            if (!VTFLib::CVTFFile::ConvertFromRGBA8888(rgba.data(), compressed.data(), size, size, format))
+            {
+                Skip("decode", params, std::string("could not make source data: ") + LastError());
+                continue;
+            }
+
+            Run("decode", params, compressed.size(), [&]()
+            {
+                return VTFLib::CVTFFile::ConvertToRGBA8888(compressed.data(), rgba.data(), size, size, format) != vlFalse;
+            });
+        }
+    }
+}
+
+void BenchFlipMirror()
+{
+    for (auto size : Sizes())
+    {
+        std::vector<vlByte> rgba((size_t)size * size * 4);
+        FillPattern(rgba.data(), size, size, 3);
+
+        Run("flip", { { "size", SizeName(size, size) } }, rgba.size(), [&]()
+        {
+            VTFLib::CVTFFile::FlipImage(rgba.data(), size, size);
+            return true;
+        });
+        Run("mirror", { { "size", SizeName(size, size) } }, rgba.size(), [&]()
+        {
+            VTFLib::CVTFFile::MirrorImage(rgba.data(), size, size);
+            return true;
+        });
+    }
+}
+
+//
+// Proc callbacks over a memory buffer, for timing the proc reader and writer themselves.
+//
+struct SProcStream
+{
+    std::vector<vlByte>* data;
+    vlUInt position;
+};
+
+vlBool ProcOpen(vlVoid* user)
+{
+    ((SProcStream*)user)->position = 0;
+    return vlTrue;
+}
+
+vlVoid ProcClose(vlVoid*)
+{
+}
+
+vlUInt ProcRead(vlVoid* buffer, vlUInt bytes, vlVoid* user)
+{
+    auto stream = (SProcStream*)user;
+    bytes = std::min(bytes, (vlUInt)stream->data->size() - stream->position);
+    memcpy(buffer, stream->data->data() + stream->position, bytes);
+    stream->position += bytes;
+    return bytes;
+}
+
+vlUInt ProcWrite(vlVoid* buffer, vlUInt bytes, vlVoid* user)
+{
+    auto stream = (SProcStream*)user;
+    if (stream->position + bytes > stream->data->size())
+        stream->data->resize(stream->position + bytes);
+    memcpy(stream->data->data() + stream->position, buffer, bytes);
+    stream->position += bytes;
+    return bytes;
+}
+
+vlUInt ProcSeek(vlLong offset, VLSeekMode mode, vlVoid* user)
+{
+    auto stream = (SProcStream*)user;
+    vlLong base = mode == SEEK_MODE_BEGIN ? 0 : mode == SEEK_MODE_CURRENT ? (vlLong)stream->position : (vlLong)stream->data->size();
+    stream->position = (vlUInt)std::max<vlLong>(0, base + offset);
+    return stream->position;
+}
+
+vlUInt ProcSize(vlVoid* user)
+{
+    return (vlUInt)((SProcStream*)user)->data->size();
+}
+
+vlUInt ProcTell(vlVoid* user)
+{
+    return ((SProcStream*)user)->position;
+}
+
+void SetMemoryProcs()
+{
+    vlSetProc(PROC_READ_OPEN, (vlVoid*)ProcOpen);
+    vlSetProc(PROC_READ_CLOSE, (vlVoid*)ProcClose);
+    vlSetProc(PROC_READ_READ, (vlVoid*)ProcRead);
+    vlSetProc(PROC_READ_SEEK, (vlVoid*)ProcSeek);
+    vlSetProc(PROC_READ_SIZE, (vlVoid*)ProcSize);
+    vlSetProc(PROC_READ_TELL, (vlVoid*)ProcTell);
+    vlSetProc(PROC_WRITE_OPEN, (vlVoid*)ProcOpen);
+    vlSetProc(PROC_WRITE_CLOSE, (vlVoid*)ProcClose);
+    vlSetProc(PROC_WRITE_WRITE, (vlVoid*)ProcWrite);
+    vlSetProc(PROC_WRITE_SEEK, (vlVoid*)ProcSeek);
+    vlSetProc(PROC_WRITE_SIZE, (vlVoid*)ProcSize);
+    vlSetProc(PROC_WRITE_TELL, (vlVoid*)ProcTell);
+}
+
+void BenchLoadSave(const std::vector<SCorpusImage>& corpus)
+{
+    SetMemoryProcs();
+
+    for (size_t i = 0; i < corpus.size(); i++)
+    {
+        auto& desc = corpus[i];
+        const char* methods[] = { "file", "memory", "proc" };
+
+        VTFLib::CVTFFile image;
+        if (!BuildImage(desc, (vlUInt)i, image))
+        {
+            std::string error = LastError();
+            for (auto method : methods)
+            {
+                Skip("save", { { "image", desc.name }, { "via", method } }, "could not build image: " + error);
+                Skip("load", { { "image", desc.name }, { "via", method } }, "could not build image: " + error);
+            }
+            continue;
+        }
+
+        vlUInt size = image.GetSize();
+        std::string path = g_settings.temp + "\\" + desc.name + ".vtf";
+        std::vector<vlByte> buffer(size);
+        SProcStream stream = { &buffer, 0 };
+
+        Run("save", { { "image", desc.name }, { "via", "file" } }, size, [&]()
+        {
+            return image.Save(path.c_str()) != vlFalse;
+        });
+        Run("save", { { "image", desc.name }, { "via", "memory" } }, size, [&]()
+        {
+            vlUInt written;
+            return image.Save(buffer.data(), size, written) != vlFalse;
+        });
+        Run("save", { { "image", desc.name }, { "via", "proc" } }, size, [&]()
+        {
+            return image.Save(&stream) != vlFalse;
+        });
+
+        // make sure the loads have something to read even if the saves were filtered out
+        image.Save(path.c_str());
+        vlUInt written;
+        image.Save(buffer.data(), size, written);
+
+        Run("load", { { "image", desc.name }, { "via", "file" } }, size, [&]()
+        {
+            VTFLib::CVTFFile loaded;
+            return loaded.Load(path.c_str()) != vlFalse;
+        });
+        Run("load", { { "image", desc.name }, { "via", "memory" } }, size, [&]()
+        {
+            VTFLib::CVTFFile loaded;
+            return loaded.Load((const vlVoid*)buffer.data(), size) != vlFalse;
+        });
+        Run("load", { { "image", desc.name }, { "via", "proc" } }, size, [&]()
+        {
+            VTFLib::CVTFFile loaded;
+            return loaded.Load(&stream) != vlFalse;
+        });
+
+        DeleteFileA(path.c_str());
+    }
+}
+
+void BenchSphereMap()
+{
+    std::vector<vlUInt> sizes = { 128, 512 };
+    if (!g_settings.quick)
+        sizes.push_back(1024);
+
+    for (auto size : sizes)
+    {
+        Params params = { { "size", SizeName(size, size) } };
+
+        SCorpusImage desc = { "spheremap", IMAGE_FORMAT_RGBA8888, size, size, 1, 1, 7, false };
+        VTFLib::CVTFFile image;
+        if (!BuildImage(desc, 4, image))
+        {
+            Skip("spheremap", params, std::string("could not build image: ") + LastError());
+            continue;
+        }
+
+        Run("spheremap", params, (vlUInt64)size * size * 4 * 6, [&]()
+        {
+            return image.GenerateSphereMap() != vlFalse;
+        });
+    }
+}
+
+void BenchReflectivity(const std::vector<SCorpusImage>& corpus)
+{
+    for (size_t i = 0; i < corpus.size(); i++)
+    {
+        auto& desc = corpus[i];
+        if (!desc.mips || desc.depth > 1 || desc.frames > 1 || desc.faces > 1)
+            continue;
+        if (desc.format != IMAGE_FORMAT_RGBA8888 && desc.format != IMAGE_FORMAT_DXT1 && desc.format != IMAGE_FORMAT_RGBA16161616F)
+            continue;
+        if (desc.width < 256)
+            continue;
+
+        Params params = { { "image", desc.name } };
+
+        VTFLib::CVTFFile image;
+        if (!BuildImage(desc, (vlUInt)i, image))
+        {
+            Skip("reflectivity", params, std::string("could not build image: ") + LastError());
+            continue;
+        }
+
+        Run("reflectivity", params, VTFLib::CVTFFile::ComputeImageSize(desc.width, desc.height, 1, desc.format), [&]()
+        {
+            return image.ComputeReflectivity() != vlFalse;
+        });
+    }
+}
+
+//
+// A material with count parameters spread over nested groups, the way large patch and
+// proxy heavy materials look.
+//
+std::string MakeMaterial(vlUInt count)
+{
+    std::string text = "\"VertexLitGeneric\"\n{\n";
+    for (vlUInt i = 0; i < count; i++)
+    {
+        if (i % 50 == 49)
+            text += "\t\"Proxies\"\n\t{\n\t\t\"AnimatedTexture\"\n\t\t{\n\t\t\t\"animatedtexturevar\" \"$basetexture\"\n\t\t\t\"animatedtextureframerate\" 30\n\t\t}\n\t}\n";
+        else if (i % 3 == 0)
+            text += "\t\"$basetexture" + std::to_string(i) + "\" \"models/props/texture_" + std::to_string(i) + "\"\n";
+        else if (i % 3 == 1)
+            text += "\t\"$param" + std::to_string(i) + "\" \"" + std::to_string(i * 0.25) + "\"\n";
+        else
+            text += "\t$flag" + std::to_string(i) + " " + std::to_string(i & 1) + " // comment\n";
+    }
+    return text + "}\n";
+}
+
+void BenchMaterials()
+{
+    for (vlUInt count : { 10u, 100u, 2000u })
+    {
+        std::string text = MakeMaterial(count);
+        Run("vmt", { { "params", std::to_string(count) } }, text.size(), [&]()
+        {
+            VTFLib::CVMTFile material;
+            return material.Load(text.data(), (vlUInt)text.size()) != vlFalse;
+        });
+    }
+}
+
+//
+// Runs the cubemaker executable on six generated faces, as a user dropping a skybox on it
+// would.
+//
+void BenchCubemaker()
+{
+    vlUInt size = g_settings.quick ? 256 : 1024;
+    Params params = { { "size", SizeName(size, size) } };
+
+    if (GetFileAttributesA(g_settings.cubemaker.c_str()) == INVALID_FILE_ATTRIBUTES)
+    {
+        Skip("cubemaker", params, "cubemaker not found at " + g_settings.cubemaker);
+        return;
+    }
+
+    const char* faces[] = { "ft", "bk", "rt", "lf", "up", "dn" };
+    std::string base = g_settings.temp + "\\benchsky";
+    for (int i = 0; i < 6; i++)
+    {
+        SCorpusImage desc = { "face", IMAGE_FORMAT_BGR888, size, size, 1, 1, 1, false };
+        VTFLib::CVTFFile image;
+        if (!BuildImage(desc, 10 + i, image) || !image.Save((base + faces[i] + ".vtf").c_str()))
+        {
+            Skip("cubemaker", params, std::string("could not write faces: ") + LastError());
+            return;
+        }
+    }
+
+    std::string command = "\"" + g_settings.cubemaker + "\" \"" + base + "ft.vtf\"";
+    std::string output = base + "_cubemap.vtf";
+
+    Run("cubemaker", params, (vlUInt64)size * size * 3 * 6, [&]()
+    {
+        DeleteFileA(output.c_str());
+
+        // cubemaker waits for a key when done, so give it an empty stdin
+        SECURITY_ATTRIBUTES inherit = { sizeof(SECURITY_ATTRIBUTES), NULL, TRUE };
+        HANDLE null = CreateFileA("NUL", GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, &inherit, OPEN_EXISTING, 0, NULL);
+
+        STARTUPINFOA startup = {};
+        startup.cb = sizeof(startup);
+        startup.dwFlags = STARTF_USESTDHANDLES;
+        startup.hStdInput = startup.hStdOutput = startup.hStdError = null;
+
+        PROCESS_INFORMATION process = {};
+        std::vector<char> line(command.begin(), command.end());
+        line.push_back('\0');
+        BOOL started = CreateProcessA(NULL, line.data(), NULL, NULL, TRUE, CREATE_NO_WINDOW, NULL, NULL, &startup, &process);
+        CloseHandle(null);
+        if (!started)
+        {
+            g_error = "failed to start cubemaker";
+            return false;
+        }
+
+        WaitForSingleObject(process.hProcess, INFINITE);
+        DWORD exit_code = 1;
+        GetExitCodeProcess(process.hProcess, &exit_code);
+        CloseHandle(process.hProcess);
+        CloseHandle(process.hThread);
+
+        if (exit_code != 0 || GetFileAttributesA(output.c_str()) == INVALID_FILE_ATTRIBUTES)
+        {
+            g_error = "cubemaker did not produce a cubemap";
+            return false;
+        }
+        return true;
+    });
+
+    for (auto suffix : { "_cubemap.vtf", "_cubemap.vtf.hq", "_cubemap.hdr.vtf", "_cubemap.vmt" })
+        DeleteFileA((base + suffix).c_str());
+    for (int i = 0; i < 6; i++)
+        DeleteFileA((base + faces[i] + ".vtf").c_str());
+}
+
+int main(int argc, char* argv[])
+{
+    printf(g_banner);
+
+    const char* corpus_folder = NULL;
+    for (int i = 1; i < argc; i++)
+    {
+        const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (_stricmp(argv[i], "-quick") == 0)
+            g_settings.quick = true;
+        else if (_stricmp(argv[i], "-samples") == 0 && value)
+            g_settings.samples = (vlUInt)strtoul(argv[++i], NULL, 10);
+        else if (_stricmp(argv[i], "-filter") == 0 && value)
+            g_settings.filter = argv[++i];
+        else if (_stricmp(argv[i], "-out") == 0 && value)
+            g_settings.out = argv[++i];
+        else if (_stricmp(argv[i], "-cubemaker") == 0 && value)
+            g_settings.cubemaker = argv[++i];
+        else if (_stricmp(argv[i], "-corpus") == 0 && value)
+            corpus_folder = argv[++i];
+        else
+        {
+            printf(g_usage);
+            return 1;
+        }
+    }
+
+    if (g_settings.samples == 0)
+        g_settings.samples = g_settings.quick ? 3 : 5;
+
+    vlInitialize();
+
+    if (corpus_folder != NULL)
+        return WriteCorpus(corpus_folder);
+
+    char path[MAX_PATH];
+    if (g_settings.cubemaker.empty())
+    {
+        DWORD length = GetModuleFileNameA(NULL, path, MAX_PATH);
+        std::string exe(path, length);
+        g_settings.cubemaker = exe.substr(0, exe.find_last_of("\\/") + 1) + "cubemaker.exe";
+    }
+
+    GetTempPathA(MAX_PATH, path);
+    g_settings.temp = std::string(path) + "vtfbench";
+    CreateDirectoryA(g_settings.temp.c_str(), NULL);
+
+    auto corpus = Corpus();
+
+    BenchConvert();
+    BenchDecode();
+    BenchFlipMirror();
+    BenchLoadSave(corpus);
+    BenchSphereMap();
+    BenchReflectivity(corpus);
+    BenchMaterials();
+    BenchCubemaker();
+
+    RemoveDirectoryA(g_settings.temp.c_str());
+
+    if (!WriteJson(g_settings.out.c_str()))
+    {
+        printf("failed to write %s\n", g_settings.out.c_str());
+        return 1;
+    }
+
+    vlUInt failed = 0;
+    for (auto& result : g_results)
+        failed += result.status == "failed" ? 1 : 0;
+    printf("\n%u benchmarks, %u failed, results in %s\n", (vlUInt)g_results.size(), failed, g_settings.out.c_str());
+
+    return 0;
+}
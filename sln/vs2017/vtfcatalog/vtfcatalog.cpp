@@ -0,0 +1,1570 @@
+#include <windows.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <MaterialGraph.h>
+#include <VTFFile.h>
+#include <VTFLib.h>
+
+const char* g_banner = "VTF Catalog\n\n";
+
+const char* g_usage = \
+R"(Builds a compact index of every VTF under a folder from the file headers alone, and answers
+questions about them without opening the textures again.
+
+vtfcatalog update <index> <folder> [-threads n]
+    Scans the folder recursively.  Files whose size and modified time match the existing index
+    are not opened again, so updating an index of a mostly unchanged tree only costs the walk.
+
+vtfcatalog query <index> [conditions] [-details] [-count]
+    Prints the files matching every condition.
+    -minwidth n, -maxwidth n, -minheight n, -maxheight n
+    -minsize n, -maxsize n       largest side
+    -format name                 e.g. DXT1, repeat to allow several
+    -compressed, -uncompressed
+    -alpha, -noalpha             format has an alpha channel
+    -flag name, -noflag name     e.g. ENVMAP, NOMIP, NORMAL
+    -mips, -nomips
+    -thumbnail, -nothumbnail
+    -version n                   minor version, e.g. 5 for 7.5
+    -name text                   path contains text
+    -errors                      only files that could not be read
+
+vtfcatalog verify <folder> [-threads n]
+    Reads every VTF under the folder in full and runs the checks VTFLib does on load.  Files with
+    an image CRC resource (written with VTFCmd -crc) also have their image data checked.
+
+vtfcatalog dedup <folder> [-threads n] [-faces] [-vmt] [-apply]
+    Hashes every VTF under the folder and lists files that are byte for byte identical, and
+    files whose pixels are identical but whose headers (flags, version, reflectivity...) differ.
+    -faces                       also list top mip faces and frames shared by different files
+    -vmt                         list the changes that point every material at the first file
+                                 of each identical group; the folder should be a materials
+                                 folder so texture names match what the VMTs use
+    -apply                       make those changes
+
+vtfcatalog materials <graph> <folder> [-threads n] [-resolve name] [-uses name]
+    Parses every VMT under a materials folder and saves the textures and materials each one
+    refers to ($basetexture, $bumpmap, $envmap, include).  VMTs whose size and modified time
+    match the existing graph are not parsed again.
+    -resolve name                print the texture each reference of a material resolves to,
+                                 following patch includes
+    -uses name                   list the materials that refer to a texture or material
+
+examples:
+    vtfcatalog query tf.idx -minsize 1025 -uncompressed
+    vtfcatalog query tf.idx -flag ENVMAP -nomips
+    vtfcatalog dedup tf\materials -vmt
+    vtfcatalog materials tf.vmtgraph tf\materials -resolve skybox/sky_day01_01dn
+)";
+
+//
+// Index file layout.  Everything is addressed by offset from the start of the file so the
+// index can be mapped and used in place.
+//
+// SCatalogHeader
+// SCatalogRecord[uiRecordCount]      sorted by path
+// char strings[uiStringsSize]        root folder then every relative path, null terminated
+//
+#define CATALOG_VERSION 1
+
+#pragma pack(1)
+
+struct SCatalogHeader
+{
+    char Signature[4];          // "VTFC"
+    vlUInt uiVersion;
+    vlUInt uiRecordSize;
+    vlUInt uiRecordCount;
+    vlUInt uiStringsOffset;
+    vlUInt uiStringsSize;
+    vlUInt uiRootOffset;        // into the strings
+    vlUInt uiReserved;
+};
+
+enum ECatalogStatus
+{
+    CATALOG_STATUS_OK = 0,
+    CATALOG_STATUS_ERROR
+};
+
+enum ECatalogResource
+{
+    CATALOG_RESOURCE_SHEET = 0x01,
+    CATALOG_RESOURCE_CRC = 0x02,
+    CATALOG_RESOURCE_LOD = 0x04,
+    CATALOG_RESOURCE_TSO = 0x08,
+    CATALOG_RESOURCE_KVD = 0x10,
+    CATALOG_RESOURCE_IMAGE_CRC = 0x20,
+    CATALOG_RESOURCE_OTHER = 0x80
+};
+
+struct SCatalogRecord
+{
+    vlUInt uiPathOffset;        // into the strings
+    vlUInt uiFileSize;
+    vlUInt64 uiModified;        // FILETIME of the last write
+
+    vlUShort uiWidth;
+    vlUShort uiHeight;
+    vlUShort uiDepth;
+    vlUShort uiFrames;
+    vlUInt uiFlags;
+    vlInt ImageFormat;
+
+    vlByte uiFaces;
+    vlByte uiMipmaps;
+    vlByte uiVersion;           // minor version
+    vlByte uiStatus;            // ECatalogStatus
+
+    vlByte ThumbnailFormat;     // 0xff for none
+    vlByte uiThumbnailWidth;
+    vlByte uiThumbnailHeight;
+    vlByte uiResources;         // ECatalogResource
+
+    vlSingle sReflectivity[3];
+    vlSingle sBumpScale;
+    vlUInt uiCRC;               // value of the CRC resource, 0 if none
+    vlUInt uiReserved;
+};
+
+#pragma pack()
+
+static_assert(sizeof(SCatalogRecord) == 64, "catalog records should stay 64 bytes");
+
+//
+// A whole file mapped read only.
+//
+class CMappedFile
+{
+public:
+    CMappedFile() : file(INVALID_HANDLE_VALUE), mapping(NULL), data(NULL), size(0)
+    {
+    }
+
+    ~CMappedFile()
+    {
+        Close();
+    }
+
+    bool Open(const char* filename)
+    {
+        file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (file == INVALID_HANDLE_VALUE)
+            return false;
+
+        // empty files can't be mapped; they are never valid VTFs or indexes anyway
+        LARGE_INTEGER file_size;
+        if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0 || file_size.QuadPart > 0xffffffff)
+        {
+            Close();
+            return false;
+        }
+        size = (vlUInt)file_size.QuadPart;
+
+        mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mapping == NULL)
+        {
+            Close();
+            return false;
+        }
+
+        data = (const vlByte*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (data == NULL)
+        {
+            Close();
+            return false;
+        }
+
+        return true;
+    }
+
+    void Close()
+    {
+        if (data != NULL)
+            UnmapViewOfFile(data);
+        if (mapping != NULL)
+            CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE)
+            CloseHandle(file);
+
+        file = INVALID_HANDLE_VALUE;
+        mapping = NULL;
+        data = NULL;
+        size = 0;
+    }
+
+    const vlByte* Data() const
+    {
+        return data;
+    }
+
+    vlUInt Size() const
+    {
+        return size;
+    }
+
+private:
+    CMappedFile(const CMappedFile&);
+    CMappedFile& operator=(const CMappedFile&);
+
+    HANDLE file;
+    HANDLE mapping;
+    const vlByte* data;
+    vlUInt size;
+};
+
+//
+// A read only view of an index file.
+//
+class CCatalogView
+{
+public:
+    CCatalogView() : data(NULL), size(0)
+    {
+    }
+
+    bool Open(const char* filename)
+    {
+        Close();
+
+        if (!file.Open(filename))
+            return false;
+
+        data = file.Data();
+        size = file.Size();
+        if (size < sizeof(SCatalogHeader) || !Validate())
+        {
+            Close();
+            return false;
+        }
+
+        return true;
+    }
+
+    void Close()
+    {
+        file.Close();
+        data = NULL;
+        size = 0;
+    }
+
+    const SCatalogHeader& Header() const
+    {
+        return *(const SCatalogHeader*)data;
+    }
+
+    vlUInt Count() const
+    {
+        return data != NULL ? Header().uiRecordCount : 0;
+    }
+
+    const SCatalogRecord& Record(vlUInt index) const
+    {
+        return ((const SCatalogRecord*)(data + sizeof(SCatalogHeader)))[index];
+    }
+
+    const char* String(vlUInt offset) const
+    {
+        return (const char*)(data + Header().uiStringsOffset + offset);
+    }
+
+    const char* Root() const
+    {
+        return String(Header().uiRootOffset);
+    }
+
+    const char* Path(const SCatalogRecord& record) const
+    {
+        return String(record.uiPathOffset);
+    }
+
+private:
+    bool Validate() const
+    {
+        auto& header = Header();
+        if (memcmp(header.Signature, "VTFC", 4) != 0 || header.uiVersion != CATALOG_VERSION || header.uiRecordSize != sizeof(SCatalogRecord))
+            return false;
+
+        vlUInt64 records_end = sizeof(SCatalogHeader) + (vlUInt64)header.uiRecordCount * sizeof(SCatalogRecord);
+        if (records_end > header.uiStringsOffset || (vlUInt64)header.uiStringsOffset + header.uiStringsSize > size)
+            return false;
+
+        // every string offset must land inside the table and the table must end in a null
+        if (header.uiStringsSize == 0 || String(header.uiStringsSize - 1)[0] != '\0' || header.uiRootOffset >= header.uiStringsSize)
+            return false;
+
+        for (vlUInt i = 0; i < header.uiRecordCount; i++)
+        {
+            if (Record(i).uiPathOffset >= header.uiStringsSize)
+                return false;
+        }
+
+        return true;
+    }
+
+    CMappedFile file;
+    const vlByte* data;
+    vlUInt size;
+};
+
+// -----------------------------------------------------------------------------------
+// update
+// -----------------------------------------------------------------------------------
+
+struct SCatalogEntry
+{
+    std::string path;           // relative to the root
+    SCatalogRecord record;
+    const SCatalogRecord* previous;
+    std::string error;
+};
+
+vlUInt64 FileTimeToUInt64(const FILETIME& time)
+{
+    return ((vlUInt64)time.dwHighDateTime << 32) | time.dwLowDateTime;
+}
+
+bool EndsWithNoCase(const char* str, const char* suffix)
+{
+    size_t lenstr = strlen(str);
+    size_t lensuffix = strlen(suffix);
+    if (lensuffix > lenstr)
+        return false;
+    return _stricmp(str + lenstr - lensuffix, suffix) == 0;
+}
+
+//
+// Collects every file with the given extension under root + relative.  Sizes and times come
+// from the directory listing itself so unchanged files are never opened.
+//
+void WalkFolder(const std::string& root, const std::string& relative, const char* extension, std::vector<SCatalogEntry>& entries)
+{
+    std::string search = root + "\\" + relative + (relative.empty() ? "*" : "\\*");
+
+    WIN32_FIND_DATAA find_data;
+    HANDLE find = FindFirstFileExA(search.c_str(), FindExInfoBasic, &find_data, FindExSearchNameMatch, NULL, FIND_FIRST_EX_LARGE_FETCH);
+    if (find == INVALID_HANDLE_VALUE)
+        return;
+
+    do
+    {
+        if (strcmp(find_data.cFileName, ".") == 0 || strcmp(find_data.cFileName, "..") == 0)
+            continue;
+
+        std::string path = relative.empty() ? find_data.cFileName : relative + "\\" + find_data.cFileName;
+
+        if (find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+        {
+            WalkFolder(root, path, extension, entries);
+        }
+        else if (EndsWithNoCase(find_data.cFileName, extension))
+        {
+            SCatalogEntry entry;
+            entry.path = path;
+            memset(&entry.record, 0, sizeof(entry.record));
+            entry.record.uiFileSize = find_data.nFileSizeLow;
+            entry.record.uiModified = FileTimeToUInt64(find_data.ftLastWriteTime);
+            entry.previous = NULL;
+            entries.push_back(entry);
+        }
+    } while (FindNextFileA(find, &find_data));
+
+    FindClose(find);
+}
+
+vlByte CatalogResources(const SVTFHeaderInfo& info, vlUInt& crc)
+{
+    vlByte resources = 0;
+    for (vlUInt i = 0; i < info.uiResourceCount; i++)
+    {
+        switch (info.uiResourceTypes[i])
+        {
+        case VTF_LEGACY_RSRC_LOW_RES_IMAGE:
+        case VTF_LEGACY_RSRC_IMAGE:
+            break;
+        case VTF_RSRC_SHEET:
+            resources |= CATALOG_RESOURCE_SHEET;
+            break;
+        case VTF_RSRC_CRC:
+            resources |= CATALOG_RESOURCE_CRC;
+            crc = info.uiResourceData[i];
+            break;
+        case VTF_RSRC_TEXTURE_LOD_SETTINGS:
+            resources |= CATALOG_RESOURCE_LOD;
+            break;
+        case VTF_RSRC_TEXTURE_SETTINGS_EX:
+            resources |= CATALOG_RESOURCE_TSO;
+            break;
+        case VTF_RSRC_KEY_VALUE_DATA:
+            resources |= CATALOG_RESOURCE_KVD;
+            break;
+        case VTF_RSRC_IMAGE_CRC:
+            resources |= CATALOG_RESOURCE_IMAGE_CRC;
+            break;
+        default:
+            resources |= CATALOG_RESOURCE_OTHER;
+            break;
+        }
+    }
+    return resources;
+}
+
+void ScanEntry(const std::string& root, SCatalogEntry& entry)
+{
+    auto& record = entry.record;
+
+    SVTFHeaderInfo info;
+    if (!VTFLib::CVTFFile::LoadHeaderInfo((root + "\\" + entry.path).c_str(), info))
+    {
+        record.uiStatus = CATALOG_STATUS_ERROR;
+        record.ImageFormat = IMAGE_FORMAT_NONE;
+        record.ThumbnailFormat = 0xff;
+        entry.error = vlGetLastError();
+        return;
+    }
+
+    record.uiStatus = CATALOG_STATUS_OK;
+    record.uiWidth = (vlUShort)info.uiWidth;
+    record.uiHeight = (vlUShort)info.uiHeight;
+    record.uiDepth = (vlUShort)info.uiDepth;
+    record.uiFrames = (vlUShort)info.uiFrameCount;
+    record.uiFlags = info.uiFlags;
+    record.ImageFormat = info.ImageFormat;
+    record.uiFaces = (vlByte)info.uiFaceCount;
+    record.uiMipmaps = (vlByte)info.uiMipmapCount;
+    record.uiVersion = (vlByte)info.uiVersion[1];
+    record.ThumbnailFormat = info.ThumbnailFormat == IMAGE_FORMAT_NONE ? 0xff : (vlByte)info.ThumbnailFormat;
+    record.uiThumbnailWidth = (vlByte)info.uiThumbnailWidth;
+    record.uiThumbnailHeight = (vlByte)info.uiThumbnailHeight;
+    record.uiResources = CatalogResources(info, record.uiCRC);
+    memcpy(record.sReflectivity, info.sReflectivity, sizeof(record.sReflectivity));
+    record.sBumpScale = info.sBumpScale;
+}
+
+//
+// Runs work(0) to work(count - 1) on a pool of threads.
+//
+template<typename T>
+void ParallelFor(size_t count, vlUInt threads, const T& work)
+{
+    threads = (vlUInt)std::max<size_t>(1, std::min<size_t>(threads, count));
+
+    std::atomic<size_t> next(0);
+    std::vector<std::thread> workers;
+    for (vlUInt i = 0; i < threads; i++)
+    {
+        workers.emplace_back([&]()
+        {
+            for (size_t k = next++; k < count; k = next++)
+                work(k);
+        });
+    }
+    for (auto& worker : workers)
+        worker.join();
+}
+
+std::string FolderRoot(const char* folder)
+{
+    std::string root = folder;
+    while (!root.empty() && (root.back() == '\\' || root.back() == '/'))
+        root.pop_back();
+    return root;
+}
+
+bool PathLess(const std::string& a, const std::string& b)
+{
+    return _stricmp(a.c_str(), b.c_str()) < 0;
+}
+
+bool WriteCatalog(const char* filename, const std::string& root, const std::vector<SCatalogEntry>& entries)
+{
+    // strings: root first, then the paths in record order
+    std::string strings = root;
+    strings.push_back('\0');
+
+    std::vector<SCatalogRecord> records;
+    records.reserve(entries.size());
+    for (auto& entry : entries)
+    {
+        SCatalogRecord record = entry.record;
+        record.uiPathOffset = (vlUInt)strings.size();
+        strings.append(entry.path);
+        strings.push_back('\0');
+        records.push_back(record);
+    }
+
+    SCatalogHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.Signature, "VTFC", 4);
+    header.uiVersion = CATALOG_VERSION;
+    header.uiRecordSize = sizeof(SCatalogRecord);
+    header.uiRecordCount = (vlUInt)records.size();
+    header.uiStringsOffset = sizeof(SCatalogHeader) + header.uiRecordCount * sizeof(SCatalogRecord);
+    header.uiStringsSize = (vlUInt)strings.size();
+    header.uiRootOffset = 0;
+
+    // write beside the old index and swap it in, so a query never sees half a file
+    std::string temp = std::string(filename) + ".tmp";
+    FILE* f = fopen(temp.c_str(), "wb");
+    if (f == NULL)
+        return false;
+
+    bool ok = fwrite(&header, sizeof(header), 1, f) == 1;
+    if (ok && !records.empty())
+        ok = fwrite(records.data(), sizeof(SCatalogRecord), records.size(), f) == records.size();
+    if (ok)
+        ok = fwrite(strings.data(), 1, strings.size(), f) == strings.size();
+    ok = fclose(f) == 0 && ok;
+
+    if (!ok || !MoveFileExA(temp.c_str(), filename, MOVEFILE_REPLACE_EXISTING))
+    {
+        DeleteFileA(temp.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+int Update(const char* index, const char* folder, vlUInt threads)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    std::string root = FolderRoot(folder);
+
+    std::vector<SCatalogEntry> entries;
+    WalkFolder(root, "", ".vtf", entries);
+    std::sort(entries.begin(), entries.end(), [](const SCatalogEntry& a, const SCatalogEntry& b) { return PathLess(a.path, b.path); });
+
+    // Match the walk against the old index; both are sorted by path.
+    CCatalogView previous;
+    vlUInt removed = 0;
+    if (previous.Open(index) && _stricmp(previous.Root(), root.c_str()) == 0)
+    {
+        vlUInt kept = 0;
+        vlUInt j = 0;
+        for (auto& entry : entries)
+        {
+            while (j < previous.Count() && _stricmp(previous.Path(previous.Record(j)), entry.path.c_str()) < 0)
+                j++;
+            if (j == previous.Count())
+                break;
+
+            auto& old = previous.Record(j);
+            if (_stricmp(previous.Path(old), entry.path.c_str()) != 0)
+                continue;
+
+            kept++;
+            if (old.uiFileSize == entry.record.uiFileSize && old.uiModified == entry.record.uiModified)
+                entry.previous = &old;
+        }
+        removed = previous.Count() - kept;
+    }
+
+    std::vector<SCatalogEntry*> pending;
+    for (auto& entry : entries)
+    {
+        if (entry.previous != NULL)
+            entry.record = *entry.previous;
+        else
+            pending.push_back(&entry);
+    }
+
+    // Headers are tiny so the cost is all in opening files; keep plenty of them in flight.
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency()) * 2;
+
+    ParallelFor(pending.size(), threads, [&](size_t k)
+    {
+        ScanEntry(root, *pending[k]);
+    });
+
+    vlUInt errors = 0;
+    for (auto* entry : pending)
+    {
+        if (entry->record.uiStatus != CATALOG_STATUS_OK)
+        {
+            printf("error reading %s\n%s\n\n", entry->path.c_str(), entry->error.c_str());
+            errors++;
+        }
+    }
+
+    previous.Close();
+
+    if (!WriteCatalog(index, root, entries))
+    {
+        printf("failed to write %s\n", index);
+        return 1;
+    }
+
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    printf("%u files, %u read, %u unchanged, %u removed, %u errors in %lld ms\n",
+        (vlUInt)entries.size(), (vlUInt)pending.size(), (vlUInt)(entries.size() - pending.size()), removed, errors, (long long)ms);
+
+    return 0;
+}
+
+// -----------------------------------------------------------------------------------
+// verify
+// -----------------------------------------------------------------------------------
+
+int Verify(const char* folder, vlUInt threads)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    std::string root = FolderRoot(folder);
+
+    std::vector<SCatalogEntry> entries;
+    WalkFolder(root, "", ".vtf", entries);
+    std::sort(entries.begin(), entries.end(), [](const SCatalogEntry& a, const SCatalogEntry& b) { return PathLess(a.path, b.path); });
+
+    std::vector<vlBool> has_crc(entries.size(), vlFalse);
+
+    // Whole files are read here so a few threads per core is enough to keep the disk busy.
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+
+    ParallelFor(entries.size(), threads, [&](size_t k)
+    {
+        auto& entry = entries[k];
+        if (!VTFLib::CVTFFile::Verify((root + "\\" + entry.path).c_str(), has_crc[k]))
+        {
+            entry.record.uiStatus = CATALOG_STATUS_ERROR;
+            entry.error = vlGetLastError();
+        }
+    });
+
+    vlUInt failed = 0, checked = 0;
+    vlUInt64 bytes = 0;
+    for (size_t k = 0; k < entries.size(); k++)
+    {
+        bytes += entries[k].record.uiFileSize;
+        if (has_crc[k])
+            checked++;
+
+        if (entries[k].record.uiStatus != CATALOG_STATUS_OK)
+        {
+            printf("%s\n%s\n\n", entries[k].path.c_str(), entries[k].error.c_str());
+            failed++;
+        }
+    }
+
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    printf("%u files, %u with image CRC, %u failed, %.1f MB in %lld ms\n",
+        (vlUInt)entries.size(), checked, failed, bytes / (1024.0 * 1024.0), (long long)ms);
+
+    return failed == 0 ? 0 : 1;
+}
+
+// -----------------------------------------------------------------------------------
+// dedup
+// -----------------------------------------------------------------------------------
+
+//
+// XXH64.  Files are hashed in full, so the hash needs to keep up with the disk rather
+// than resist anyone.
+//
+const vlUInt64 XXH_PRIME64_1 = 0x9E3779B185EBCA87ULL;
+const vlUInt64 XXH_PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+const vlUInt64 XXH_PRIME64_3 = 0x165667B19E3779F9ULL;
+const vlUInt64 XXH_PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+const vlUInt64 XXH_PRIME64_5 = 0x27D4EB2F165667C5ULL;
+
+inline vlUInt64 Rotl64(vlUInt64 x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+inline vlUInt64 Read64(const vlByte* p)
+{
+    vlUInt64 v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline vlUInt Read32(const vlByte* p)
+{
+    vlUInt v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline vlUInt64 XXH64Round(vlUInt64 acc, vlUInt64 input)
+{
+    acc += input * XXH_PRIME64_2;
+    acc = Rotl64(acc, 31);
+    return acc * XXH_PRIME64_1;
+}
+
+inline vlUInt64 XXH64Merge(vlUInt64 acc, vlUInt64 val)
+{
+    acc ^= XXH64Round(0, val);
+    return acc * XXH_PRIME64_1 + XXH_PRIME64_4;
+}
+
+vlUInt64 Hash64(const void* data, size_t size, vlUInt64 seed = 0)
+{
+    const vlByte* p = (const vlByte*)data;
+    const vlByte* end = p + size;
+    vlUInt64 h;
+
+    if (size >= 32)
+    {
+        vlUInt64 v1 = seed + XXH_PRIME64_1 + XXH_PRIME64_2;
+        vlUInt64 v2 = seed + XXH_PRIME64_2;
+        vlUInt64 v3 = seed;
+        vlUInt64 v4 = seed - XXH_PRIME64_1;
+
+        const vlByte* limit = end - 32;
+        do
+        {
+            v1 = XXH64Round(v1, Read64(p));
+            v2 = XXH64Round(v2, Read64(p + 8));
+            v3 = XXH64Round(v3, Read64(p + 16));
+            v4 = XXH64Round(v4, Read64(p + 24));
+            p += 32;
+        } while (p <= limit);
+
+        h = Rotl64(v1, 1) + Rotl64(v2, 7) + Rotl64(v3, 12) + Rotl64(v4, 18);
+        h = XXH64Merge(h, v1);
+        h = XXH64Merge(h, v2);
+        h = XXH64Merge(h, v3);
+        h = XXH64Merge(h, v4);
+    }
+    else
+    {
+        h = seed + XXH_PRIME64_5;
+    }
+
+    h += (vlUInt64)size;
+
+    for (; p + 8 <= end; p += 8)
+    {
+        h ^= XXH64Round(0, Read64(p));
+        h = Rotl64(h, 27) * XXH_PRIME64_1 + XXH_PRIME64_4;
+    }
+    if (p + 4 <= end)
+    {
+        h ^= (vlUInt64)Read32(p) * XXH_PRIME64_1;
+        h = Rotl64(h, 23) * XXH_PRIME64_2 + XXH_PRIME64_3;
+        p += 4;
+    }
+    for (; p < end; p++)
+    {
+        h ^= *p * XXH_PRIME64_5;
+        h = Rotl64(h, 11) * XXH_PRIME64_1;
+    }
+
+    h ^= h >> 33;
+    h *= XXH_PRIME64_2;
+    h ^= h >> 29;
+    h *= XXH_PRIME64_3;
+    h ^= h >> 32;
+    return h;
+}
+
+//
+// One frame and face of the top mip.  These are what tie a cube map's black down face to
+// the standalone black texture it was copied from.
+//
+struct SFaceHash
+{
+    vlUInt64 hash;
+    vlUInt frame;
+    vlUInt face;
+};
+
+struct SDedupEntry
+{
+    std::string path;           // relative to the root
+    vlUInt size = 0;
+    vlUInt64 file_hash = 0;     // every byte of the file
+    vlUInt64 pixel_hash = 0;    // format, dimensions and every subresource, nothing else
+
+    vlUInt width = 0, height = 0, depth = 0;
+    VTFImageFormat format = IMAGE_FORMAT_NONE;
+    vlUInt flags = 0;
+    vlUInt version = 0;
+    std::vector<SFaceHash> faces;
+
+    bool ok = false;
+    std::string error;
+};
+
+void HashEntry(const std::string& root, SDedupEntry& entry)
+{
+    CMappedFile file;
+    if (!file.Open((root + "\\" + entry.path).c_str()))
+    {
+        entry.error = "Error:\nFailed to open file.";
+        return;
+    }
+
+    entry.size = file.Size();
+    entry.file_hash = Hash64(file.Data(), file.Size());
+
+    VTFLib::CVTFFile image;
+    if (!image.Load(file.Data(), file.Size()))
+    {
+        entry.error = vlGetLastError();
+        return;
+    }
+
+    entry.width = image.GetWidth();
+    entry.height = image.GetHeight();
+    entry.depth = image.GetDepth();
+    entry.format = image.GetFormat();
+    entry.flags = image.GetFlags();
+    entry.version = image.GetMinorVersion();
+
+    vlUInt frames = image.GetFrameCount();
+    vlUInt faces = image.GetFaceCount();
+    vlUInt mipmaps = image.GetMipmapCount();
+
+    // Each subresource is a frame and face of one mip with all its slices, which VTFLib
+    // keeps together.  The pixel hash is a hash of their hashes.
+    std::vector<vlUInt64> hashes = { (vlUInt64)entry.format, entry.width, entry.height, entry.depth, frames, faces, mipmaps };
+    for (vlUInt mip = 0; mip < mipmaps; mip++)
+    {
+        vlUInt mip_size = VTFLib::CVTFFile::ComputeMipmapSize(entry.width, entry.height, entry.depth, mip, entry.format);
+        for (vlUInt frame = 0; frame < frames; frame++)
+        {
+            for (vlUInt face = 0; face < faces; face++)
+            {
+                vlUInt64 hash = Hash64(image.GetData(frame, face, 0, mip), mip_size);
+                hashes.push_back(hash);
+
+                if (mip == 0)
+                    entry.faces.push_back({ hash, frame, face });
+            }
+        }
+    }
+    entry.pixel_hash = Hash64(hashes.data(), hashes.size() * sizeof(vlUInt64));
+    entry.ok = true;
+}
+
+//
+// The name a VMT would use for a texture: relative to the materials folder, forward
+// slashes, no extension, lower case.
+//
+std::string TextureName(std::string path)
+{
+    std::transform(path.begin(), path.end(), path.begin(), [](char c) { return c == '\\' ? '/' : (char)tolower((unsigned char)c); });
+    while (!path.empty() && path.front() == '/')
+        path.erase(path.begin());
+    if (path.size() >= 4 && path.compare(path.size() - 4, 4, ".vtf") == 0)
+        path.resize(path.size() - 4);
+    return path;
+}
+
+//
+// Points every value in a VMT that names a key of renames at its value.  Works on the
+// text so comments and layout survive.  Returns the number of values changed.
+//
+vlUInt RewriteMaterial(std::string& text, const std::vector<std::pair<std::string, std::string>>& renames, std::vector<std::string>& changes)
+{
+    vlUInt changed = 0;
+    bool key = true;
+
+    size_t i = 0;
+    while (i < text.size())
+    {
+        char c = text[i];
+        if (isspace((unsigned char)c))
+        {
+            i++;
+            continue;
+        }
+        if (c == '/' && i + 1 < text.size() && text[i + 1] == '/')
+        {
+            while (i < text.size() && text[i] != '\n')
+                i++;
+            continue;
+        }
+        if (c == '{' || c == '}')
+        {
+            key = true;
+            i++;
+            continue;
+        }
+        if (c == '[')
+        {
+            // platform conditional after a value, e.g. [$X360]
+            while (i < text.size() && text[i] != ']' && text[i] != '\n')
+                i++;
+            i++;
+            continue;
+        }
+
+        size_t start, end;
+        if (c == '"')
+        {
+            start = ++i;
+            while (i < text.size() && text[i] != '"' && text[i] != '\n')
+                i++;
+            end = i;
+            if (i < text.size() && text[i] == '"')
+                i++;
+        }
+        else
+        {
+            start = i;
+            while (i < text.size() && !isspace((unsigned char)text[i]) && text[i] != '"' && text[i] != '{' && text[i] != '}')
+                i++;
+            end = i;
+        }
+
+        if (!key)
+        {
+            std::string value = text.substr(start, end - start);
+            std::string name = TextureName(value);
+            auto rename = std::lower_bound(renames.begin(), renames.end(), std::make_pair(name, std::string()));
+            if (rename != renames.end() && rename->first == name)
+            {
+                changes.push_back(value + " -> " + rename->second);
+                text.replace(start, end - start, rename->second);
+                i += rename->second.size() - (end - start);
+                changed++;
+            }
+        }
+        key = !key;
+    }
+
+    return changed;
+}
+
+void PrintEntry(const char* prefix, const SDedupEntry& entry)
+{
+    printf("%s7.%u %ux%u %s flags=%08x %s\n", prefix, entry.version, entry.width, entry.height,
+        VTFLib::CVTFFile::GetImageFormatInfo(entry.format).lpName, entry.flags, entry.path.c_str());
+}
+
+int Dedup(const char* folder, vlUInt threads, bool show_faces, bool vmt, bool apply)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    std::string root = FolderRoot(folder);
+
+    std::vector<SCatalogEntry> found;
+    WalkFolder(root, "", ".vtf", found);
+    std::sort(found.begin(), found.end(), [](const SCatalogEntry& a, const SCatalogEntry& b) { return PathLess(a.path, b.path); });
+
+    std::vector<SDedupEntry> entries(found.size());
+    for (size_t k = 0; k < found.size(); k++)
+        entries[k].path = found[k].path;
+
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+
+    ParallelFor(entries.size(), threads, [&](size_t k)
+    {
+        HashEntry(root, entries[k]);
+    });
+
+    vlUInt64 bytes = 0;
+    vlUInt failed = 0;
+    std::vector<size_t> order;
+    for (size_t k = 0; k < entries.size(); k++)
+    {
+        bytes += entries[k].size;
+        if (entries[k].ok)
+            order.push_back(k);
+        else
+        {
+            printf("%s\n%s\n\n", entries[k].path.c_str(), entries[k].error.c_str());
+            failed++;
+        }
+    }
+
+    // Sort so every pixel group is contiguous, with its exact groups contiguous inside it
+    // and the first path of each exact group first.  That first path is the canonical copy.
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b)
+    {
+        auto& x = entries[a];
+        auto& y = entries[b];
+        if (x.pixel_hash != y.pixel_hash)
+            return x.pixel_hash < y.pixel_hash;
+        if (x.file_hash != y.file_hash)
+            return x.file_hash < y.file_hash;
+        return x.size < y.size;
+    });
+
+    auto same_file = [&](size_t a, size_t b) { return entries[a].file_hash == entries[b].file_hash && entries[a].size == entries[b].size; };
+    auto same_pixels = [&](size_t a, size_t b) { return entries[a].pixel_hash == entries[b].pixel_hash; };
+
+    // exact duplicates
+    std::vector<std::pair<std::string, std::string>> renames;
+    vlUInt exact_groups = 0, exact_files = 0;
+    vlUInt64 reclaimable = 0;
+    printf("identical files:\n");
+    for (size_t i = 0, j; i < order.size(); i = j)
+    {
+        for (j = i + 1; j < order.size() && same_file(order[i], order[j]); j++)
+            ;
+        if (j - i < 2)
+            continue;
+
+        auto& canonical = entries[order[i]];
+        printf("  %s\n", canonical.path.c_str());
+        for (size_t k = i + 1; k < j; k++)
+        {
+            auto& duplicate = entries[order[k]];
+            printf("    = %s\n", duplicate.path.c_str());
+            renames.push_back(std::make_pair(TextureName(duplicate.path), TextureName(canonical.path)));
+            reclaimable += duplicate.size;
+            exact_files++;
+        }
+        exact_groups++;
+    }
+
+    // same pixels, different headers: one line per distinct file in the pixel group
+    vlUInt pixel_groups = 0;
+    printf("\nsame pixels, different headers:\n");
+    for (size_t i = 0, j; i < order.size(); i = j)
+    {
+        bool distinct = false;
+        for (j = i + 1; j < order.size() && same_pixels(order[i], order[j]); j++)
+            distinct = distinct || !same_file(order[j - 1], order[j]);
+        if (!distinct)
+            continue;
+
+        for (size_t k = i; k < j; k++)
+        {
+            if (k == i || !same_file(order[k - 1], order[k]))
+                PrintEntry(k == i ? "  " : "    ~ ", entries[order[k]]);
+        }
+        pixel_groups++;
+    }
+
+    // top mip faces and frames shared between files that are otherwise different
+    vlUInt face_groups = 0;
+    if (show_faces)
+    {
+        struct SFaceRef
+        {
+            vlUInt64 key;
+            size_t entry;
+            const SFaceHash* face;
+        };
+
+        std::vector<SFaceRef> refs;
+        for (size_t k : order)
+        {
+            auto& entry = entries[k];
+            vlUInt64 shape[] = { (vlUInt64)entry.format, entry.width, entry.height, entry.depth };
+            vlUInt64 seed = Hash64(shape, sizeof(shape));
+            for (auto& face : entry.faces)
+                refs.push_back({ Hash64(&face.hash, sizeof(face.hash), seed), k, &face });
+        }
+        std::stable_sort(refs.begin(), refs.end(), [](const SFaceRef& a, const SFaceRef& b) { return a.key < b.key; });
+
+        printf("\nshared faces and frames:\n");
+        for (size_t i = 0, j; i < refs.size(); i = j)
+        {
+            bool distinct = false;
+            for (j = i + 1; j < refs.size() && refs[j].key == refs[i].key; j++)
+                distinct = distinct || !same_pixels(refs[i].entry, refs[j].entry);
+            if (!distinct)
+                continue;
+
+            auto& first = entries[refs[i].entry];
+            printf("  %ux%u %s\n", first.width, first.height, VTFLib::CVTFFile::GetImageFormatInfo(first.format).lpName);
+            for (size_t k = i; k < j; k++)
+                printf("    frame %u face %u of %s\n", refs[k].face->frame, refs[k].face->face, entries[refs[k].entry].path.c_str());
+            face_groups++;
+        }
+    }
+
+    // materials that reference a duplicate
+    vlUInt materials_changed = 0, values_changed = 0;
+    if (vmt && !renames.empty())
+    {
+        std::sort(renames.begin(), renames.end());
+
+        std::vector<SCatalogEntry> materials;
+        WalkFolder(root, "", ".vmt", materials);
+        std::sort(materials.begin(), materials.end(), [](const SCatalogEntry& a, const SCatalogEntry& b) { return PathLess(a.path, b.path); });
+
+        printf("\nmaterial rewrites%s:\n", apply ? "" : " (not applied, use -apply)");
+        for (auto& material : materials)
+        {
+            std::string path = root + "\\" + material.path;
+
+            std::string text;
+            {
+                CMappedFile file;
+                if (!file.Open(path.c_str()))
+                    continue;
+                text.assign((const char*)file.Data(), file.Size());
+            }
+
+            std::vector<std::string> changes;
+            vlUInt changed = RewriteMaterial(text, renames, changes);
+            if (changed == 0)
+                continue;
+
+            for (auto& change : changes)
+                printf("  %s: %s\n", material.path.c_str(), change.c_str());
+
+            if (apply)
+            {
+                // same swap as the index so an interrupted run never leaves half a material
+                std::string temp = path + ".tmp";
+                FILE* f = fopen(temp.c_str(), "wb");
+                bool ok = f != NULL && fwrite(text.data(), 1, text.size(), f) == text.size();
+                ok = f != NULL && fclose(f) == 0 && ok;
+                if (!ok || !MoveFileExA(temp.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING))
+                {
+                    DeleteFileA(temp.c_str());
+                    printf("  %s: failed to write\n", material.path.c_str());
+                }
+            }
+
+            materials_changed++;
+            values_changed += changed;
+        }
+    }
+
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    printf("\n%u files, %.1f MB in %lld ms, %u unreadable\n", (vlUInt)entries.size(), bytes / (1024.0 * 1024.0), (long long)ms, failed);
+    printf("%u identical groups, %u redundant files, %.1f MB reclaimable\n", exact_groups, exact_files, reclaimable / (1024.0 * 1024.0));
+    printf("%u groups with the same pixels and different headers\n", pixel_groups);
+    if (show_faces)
+        printf("%u shared faces and frames\n", face_groups);
+    if (vmt)
+        printf("%u values in %u materials %s\n", values_changed, materials_changed, apply ? "rewritten" : "to rewrite");
+
+    return 0;
+}
+
+// -----------------------------------------------------------------------------------
+// query
+// -----------------------------------------------------------------------------------
+
+struct SFlagName
+{
+    const char* name;
+    vlUInt flag;
+};
+
+const SFlagName g_flags[] = {
+    { "POINTSAMPLE", TEXTUREFLAGS_POINTSAMPLE },
+    { "TRILINEAR", TEXTUREFLAGS_TRILINEAR },
+    { "CLAMPS", TEXTUREFLAGS_CLAMPS },
+    { "CLAMPT", TEXTUREFLAGS_CLAMPT },
+    { "ANISOTROPIC", TEXTUREFLAGS_ANISOTROPIC },
+    { "HINT_DXT5", TEXTUREFLAGS_HINT_DXT5 },
+    { "SRGB", TEXTUREFLAGS_SRGB },
+    { "NORMAL", TEXTUREFLAGS_NORMAL },
+    { "NOMIP", TEXTUREFLAGS_NOMIP },
+    { "NOLOD", TEXTUREFLAGS_NOLOD },
+    { "MINMIP", TEXTUREFLAGS_MINMIP },
+    { "PROCEDURAL", TEXTUREFLAGS_PROCEDURAL },
+    { "ONEBITALPHA", TEXTUREFLAGS_ONEBITALPHA },
+    { "EIGHTBITALPHA", TEXTUREFLAGS_EIGHTBITALPHA },
+    { "ENVMAP", TEXTUREFLAGS_ENVMAP },
+    { "RENDERTARGET", TEXTUREFLAGS_RENDERTARGET },
+    { "DEPTHRENDERTARGET", TEXTUREFLAGS_DEPTHRENDERTARGET },
+    { "NODEBUGOVERRIDE", TEXTUREFLAGS_NODEBUGOVERRIDE },
+    { "SINGLECOPY", TEXTUREFLAGS_SINGLECOPY },
+    { "NODEPTHBUFFER", TEXTUREFLAGS_NODEPTHBUFFER },
+    { "CLAMPU", TEXTUREFLAGS_CLAMPU },
+    { "VERTEXTEXTURE", TEXTUREFLAGS_VERTEXTEXTURE },
+    { "SSBUMP", TEXTUREFLAGS_SSBUMP },
+    { "BORDER", TEXTUREFLAGS_BORDER },
+};
+
+bool ParseFlag(const char* name, vlUInt& flag)
+{
+    for (auto& entry : g_flags)
+    {
+        if (_stricmp(entry.name, name) == 0)
+        {
+            flag = entry.flag;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ParseFormat(const char* name, vlInt& format)
+{
+    for (vlInt i = 0; i < IMAGE_FORMAT_COUNT; i++)
+    {
+        if (_stricmp(VTFLib::CVTFFile::GetImageFormatInfo((VTFImageFormat)i).lpName, name) == 0)
+        {
+            format = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+enum ETristate
+{
+    ANY = 0,
+    YES,
+    NO
+};
+
+struct SQuery
+{
+    vlUInt min_width = 0, max_width = 0xffffffff;
+    vlUInt min_height = 0, max_height = 0xffffffff;
+    vlUInt min_size = 0, max_size = 0xffffffff;
+    std::vector<vlInt> formats;
+    ETristate compressed = ANY;
+    ETristate alpha = ANY;
+    ETristate mips = ANY;
+    ETristate thumbnail = ANY;
+    vlUInt flags_set = 0;
+    vlUInt flags_clear = 0;
+    vlInt version = -1;
+    std::string name;
+    bool errors = false;
+};
+
+bool Matches(const SQuery& query, const CCatalogView& view, const SCatalogRecord& record)
+{
+    if (record.uiStatus != CATALOG_STATUS_OK)
+        return query.errors;
+    if (query.errors)
+        return false;
+
+    vlUInt size = std::max(record.uiWidth, record.uiHeight);
+    if (record.uiWidth < query.min_width || record.uiWidth > query.max_width ||
+        record.uiHeight < query.min_height || record.uiHeight > query.max_height ||
+        size < query.min_size || size > query.max_size)
+        return false;
+
+    if (!query.formats.empty() && std::find(query.formats.begin(), query.formats.end(), record.ImageFormat) == query.formats.end())
+        return false;
+
+    if ((record.uiFlags & query.flags_set) != query.flags_set || (record.uiFlags & query.flags_clear) != 0)
+        return false;
+
+    if (query.mips != ANY && (record.uiMipmaps > 1) != (query.mips == YES))
+        return false;
+
+    if (query.thumbnail != ANY && (record.ThumbnailFormat != 0xff) != (query.thumbnail == YES))
+        return false;
+
+    if (query.version >= 0 && record.uiVersion != query.version)
+        return false;
+
+    if (query.compressed != ANY || query.alpha != ANY)
+    {
+        if (record.ImageFormat < 0 || record.ImageFormat >= IMAGE_FORMAT_COUNT)
+            return false;
+
+        auto& info = VTFLib::CVTFFile::GetImageFormatInfo((VTFImageFormat)record.ImageFormat);
+        if (query.compressed != ANY && (info.bIsCompressed != vlFalse) != (query.compressed == YES))
+            return false;
+        if (query.alpha != ANY && (info.uiAlphaBitsPerPixel > 0) != (query.alpha == YES))
+            return false;
+    }
+
+    if (!query.name.empty())
+    {
+        std::string path = view.Path(record);
+        std::transform(path.begin(), path.end(), path.begin(), ::tolower);
+        if (path.find(query.name) == std::string::npos)
+            return false;
+    }
+
+    return true;
+}
+
+void PrintRecord(const CCatalogView& view, const SCatalogRecord& record, bool details)
+{
+    if (!details)
+    {
+        printf("%s\\%s\n", view.Root(), view.Path(record));
+        return;
+    }
+
+    if (record.uiStatus != CATALOG_STATUS_OK)
+    {
+        printf("%-40s %s\\%s\n", "unreadable", view.Root(), view.Path(record));
+        return;
+    }
+
+    const char* format = record.ImageFormat >= 0 && record.ImageFormat < IMAGE_FORMAT_COUNT ? VTFLib::CVTFFile::GetImageFormatInfo((VTFImageFormat)record.ImageFormat).lpName : "NONE";
+
+    char summary[128];
+    snprintf(summary, sizeof(summary), "7.%u %ux%u", record.uiVersion, record.uiWidth, record.uiHeight);
+    if (record.uiDepth > 1)
+        snprintf(summary + strlen(summary), sizeof(summary) - strlen(summary), "x%u", record.uiDepth);
+    snprintf(summary + strlen(summary), sizeof(summary) - strlen(summary), " %s mips=%u faces=%u frames=%u flags=%08x",
+        format, record.uiMipmaps, record.uiFaces, record.uiFrames, record.uiFlags);
+
+    printf("%-40s %s\\%s\n", summary, view.Root(), view.Path(record));
+}
+
+int Query(const char* index, int argc, char* argv[])
+{
+    SQuery query;
+    bool details = false;
+    bool count_only = false;
+
+    for (int i = 0; i < argc; i++)
+    {
+        const char* arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+
+        auto number = [&](vlUInt& out) -> bool
+        {
+            if (value == NULL)
+                return false;
+            out = (vlUInt)strtoul(value, NULL, 10);
+            i++;
+            return true;
+        };
+
+        bool ok = true;
+        if (_stricmp(arg, "-minwidth") == 0) ok = number(query.min_width);
+        else if (_stricmp(arg, "-maxwidth") == 0) ok = number(query.max_width);
+        else if (_stricmp(arg, "-minheight") == 0) ok = number(query.min_height);
+        else if (_stricmp(arg, "-maxheight") == 0) ok = number(query.max_height);
+        else if (_stricmp(arg, "-minsize") == 0) ok = number(query.min_size);
+        else if (_stricmp(arg, "-maxsize") == 0) ok = number(query.max_size);
+        else if (_stricmp(arg, "-format") == 0)
+        {
+            vlInt format;
+            ok = value != NULL && ParseFormat(value, format);
+            if (ok)
+            {
+                query.formats.push_back(format);
+                i++;
+            }
+        }
+        else if (_stricmp(arg, "-flag") == 0 || _stricmp(arg, "-noflag") == 0)
+        {
+            vlUInt flag;
+            ok = value != NULL && ParseFlag(value, flag);
+            if (ok)
+            {
+                (_stricmp(arg, "-flag") == 0 ? query.flags_set : query.flags_clear) |= flag;
+                i++;
+            }
+        }
+        else if (_stricmp(arg, "-compressed") == 0) query.compressed = YES;
+        else if (_stricmp(arg, "-uncompressed") == 0) query.compressed = NO;
+        else if (_stricmp(arg, "-alpha") == 0) query.alpha = YES;
+        else if (_stricmp(arg, "-noalpha") == 0) query.alpha = NO;
+        else if (_stricmp(arg, "-mips") == 0) query.mips = YES;
+        else if (_stricmp(arg, "-nomips") == 0) query.mips = NO;
+        else if (_stricmp(arg, "-thumbnail") == 0) query.thumbnail = YES;
+        else if (_stricmp(arg, "-nothumbnail") == 0) query.thumbnail = NO;
+        else if (_stricmp(arg, "-version") == 0)
+        {
+            vlUInt version;
+            ok = number(version);
+            query.version = (vlInt)version;
+        }
+        else if (_stricmp(arg, "-name") == 0)
+        {
+            ok = value != NULL;
+            if (ok)
+            {
+                query.name = value;
+                std::transform(query.name.begin(), query.name.end(), query.name.begin(), ::tolower);
+                i++;
+            }
+        }
+        else if (_stricmp(arg, "-errors") == 0) query.errors = true;
+        else if (_stricmp(arg, "-details") == 0) details = true;
+        else if (_stricmp(arg, "-count") == 0) count_only = true;
+        else ok = false;
+
+        if (!ok)
+        {
+            printf("bad query argument %s%s%s\n", arg, value ? " " : "", value ? value : "");
+            return 1;
+        }
+    }
+
+    CCatalogView view;
+    if (!view.Open(index))
+    {
+        printf("failed to open index %s\n", index);
+        return 1;
+    }
+
+    vlUInt matches = 0;
+    for (vlUInt i = 0; i < view.Count(); i++)
+    {
+        auto& record = view.Record(i);
+        if (!Matches(query, view, record))
+            continue;
+
+        matches++;
+        if (!count_only)
+            PrintRecord(view, record, details);
+    }
+
+    if (count_only)
+        printf("%u\n", matches);
+
+    return 0;
+}
+
+// -----------------------------------------------------------------------------------
+// materials
+// -----------------------------------------------------------------------------------
+
+const char* g_referencenames[] = {
+    "$basetexture",
+    "$basetexture2",
+    "$bumpmap",
+    "$bumpmap2",
+    "$envmap",
+    "include"
+};
+
+int Materials(const char* graph_name, const char* folder, vlUInt threads, const char* resolve, const char* uses)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    VTFLib::CMaterialGraph graph;
+    graph.Load(graph_name);
+
+    vlUInt previous = graph.GetMaterialCount();
+    if (!graph.Scan(FolderRoot(folder).c_str(), threads))
+    {
+        printf("%s\n", vlGetLastError());
+        return 1;
+    }
+
+    vlUInt errors = 0;
+    for (vlUInt i = 0; i < graph.GetMaterialCount(); i++)
+    {
+        if (graph.GetMaterialError(i) != NULL)
+            errors++;
+    }
+
+    if (!graph.Save(graph_name))
+    {
+        printf("%s\n", vlGetLastError());
+        return 1;
+    }
+
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    printf("%u materials (%u before), %u parsed, %u unchanged, %u errors in %lld ms\n",
+        graph.GetMaterialCount(), previous, graph.GetParsedCount(), graph.GetReusedCount(), errors, (long long)ms);
+
+    if (resolve != NULL)
+    {
+        vlUInt material = graph.FindMaterial(resolve);
+        if (material == MATERIAL_GRAPH_INVALID_INDEX)
+        {
+            printf("material %s not found\n", resolve);
+            return 1;
+        }
+
+        printf("\n%s (%s)\n", graph.GetMaterialName(material), graph.GetMaterialError(material) ? graph.GetMaterialError(material) : graph.GetMaterialShader(material));
+        for (vlUInt type = 0; type < MATERIAL_REFERENCE_COUNT; type++)
+        {
+            const char* name = graph.Resolve(resolve, (MaterialReferenceType)type);
+            if (name != NULL)
+                printf("    %-16s%s\n", g_referencenames[type], name);
+        }
+    }
+
+    if (uses != NULL)
+    {
+        char name[MAX_PATH];
+        VTFLib::CMaterialGraph::NormalizeName(uses, name, sizeof(name));
+
+        printf("\n");
+        vlUInt count = 0;
+        for (vlUInt i = 0; i < graph.GetMaterialCount(); i++)
+        {
+            for (vlUInt j = 0; j < graph.GetReferenceCount(i); j++)
+            {
+                if (strcmp(graph.GetReferenceName(i, j), name) == 0)
+                {
+                    printf("%-64s%s\n", graph.GetMaterialName(i), g_referencenames[graph.GetReferenceType(i, j)]);
+                    count++;
+                }
+            }
+        }
+        printf("%u references to %s\n", count, name);
+    }
+
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc >= 4 && _stricmp(argv[1], "update") == 0)
+    {
+        vlUInt threads = 0;
+        for (int i = 4; i + 1 < argc; i++)
+        {
+            if (_stricmp(argv[i], "-threads") == 0)
+                threads = (vlUInt)strtoul(argv[++i], NULL, 10);
+        }
+        return Update(argv[2], argv[3], threads);
+    }
+
+    if (argc >= 3 && _stricmp(argv[1], "verify") == 0)
+    {
+        vlUInt threads = 0;
+        for (int i = 3; i + 1 < argc; i++)
+        {
+            if (_stricmp(argv[i], "-threads") == 0)
+                threads = (vlUInt)strtoul(argv[++i], NULL, 10);
+        }
+        return Verify(argv[2], threads);
+    }
+
+    if (argc >= 3 && _stricmp(argv[1], "dedup") == 0)
+    {
+        vlUInt threads = 0;
+        bool faces = false, vmt = false, apply = false;
+        for (int i = 3; i < argc; i++)
+        {
+            if (_stricmp(argv[i], "-threads") == 0 && i + 1 < argc)
+                threads = (vlUInt)strtoul(argv[++i], NULL, 10);
+            else if (_stricmp(argv[i], "-faces") == 0)
+                faces = true;
+            else if (_stricmp(argv[i], "-vmt") == 0)
+                vmt = true;
+            else if (_stricmp(argv[i], "-apply") == 0)
+                vmt = apply = true;
+        }
+        return Dedup(argv[2], threads, faces, vmt, apply);
+    }
+
+    if (argc >= 4 && _stricmp(argv[1], "materials") == 0)
+    {
+        vlUInt threads = 0;
+        const char* resolve = NULL;
+        const char* uses = NULL;
+        for (int i = 4; i + 1 < argc; i++)
+        {
+            if (_stricmp(argv[i], "-threads") == 0)
+                threads = (vlUInt)strtoul(argv[++i], NULL, 10);
+            else if (_stricmp(argv[i], "-resolve") == 0)
+                resolve = argv[++i];
+            else if (_stricmp(argv[i], "-uses") == 0)
+                uses = argv[++i];
+        }
+        return Materials(argv[2], argv[3], threads, resolve, uses);
+    }
+
+    if (argc >= 3 && _stricmp(argv[1], "query") == 0)
+    {
+        return Query(argv[2], argc - 3, argv + 3);
+    }
+
+    printf(g_banner);
+    printf(g_usage);
+    return 1;
+}
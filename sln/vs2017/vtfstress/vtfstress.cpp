@@ -0,0 +1,371 @@
+#include <windows.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <VTFFile.h>
+#include <VTFLib.h>
+#include <VTFWrapper.h>
+
+const char* g_banner = "VTFLib Stress Test\n\n";
+
+const char* g_usage = \
+R"(Converts different textures with different settings from many threads at once and checks every
+result matches the one the same job gave on its own.
+
+vtfstress [-threads n] [-iterations n]
+    -threads n                   threads converting at once, default 32
+    -iterations n                jobs each thread runs, as multiples of the job count, default 4
+
+Each job builds a texture from a fixed seed with its own SVTFLibOptions and SVTFCreateOptions,
+saves it to memory and hashes the file, then makes a call fail and keeps the error.  The jobs are
+first run one at a time for reference.  While the threads run, one more thread flips the process
+wide options between two sets with vlSetOptions() and another checks vlGetOptions() only ever
+sees one of the two, never a mix.
+
+Jobs that fail on their own (DXT formats and mipmaps need nvDXTLib) must fail the same way on
+every thread.  Exits with 0 if everything matched, otherwise 1.
+)";
+
+// -----------------------------------------------------------------------------------
+// jobs
+// -----------------------------------------------------------------------------------
+
+struct SJob
+{
+    const char* name;
+    vlUInt width;
+    vlUInt height;
+    vlUInt faces;
+    VTFImageFormat format;
+    bool mipmaps;
+    bool spheremap;
+    vlUInt variant;    // which options to use, see MakeOptions()
+};
+
+// Each option set changes something the job's format depends on, so a job run with another
+// thread's options gives a different file.
+const SJob g_jobs[] =
+{
+    { "rgba8888",            64,  64, 1, IMAGE_FORMAT_RGBA8888,        false, false, 0 },
+    { "bgr888",             128,  64, 1, IMAGE_FORMAT_BGR888,          false, false, 0 },
+    { "i8/weights-a",       128, 128, 1, IMAGE_FORMAT_I8,              false, false, 1 },
+    { "i8/weights-b",       128, 128, 1, IMAGE_FORMAT_I8,              false, false, 2 },
+    { "ia88/weights-a",     128,  32, 1, IMAGE_FORMAT_IA88,            false, false, 1 },
+    { "ia88/weights-b",     128,  32, 1, IMAGE_FORMAT_IA88,            false, false, 2 },
+    { "bluescreen/a",        64, 128, 1, IMAGE_FORMAT_BGR888_BLUESCREEN, false, false, 3 },
+    { "bluescreen/b",        64, 128, 1, IMAGE_FORMAT_BGR888_BLUESCREEN, false, false, 4 },
+    { "rgb565",             256,  16, 1, IMAGE_FORMAT_RGB565,          false, false, 0 },
+    { "bgra4444",            64,  64, 1, IMAGE_FORMAT_BGRA4444,        false, false, 0 },
+    { "rgba16161616f/a",     64,  64, 1, IMAGE_FORMAT_RGBA16161616F,   false, false, 5 },
+    { "rgba16161616f/b",     64,  64, 1, IMAGE_FORMAT_RGBA16161616F,   false, false, 6 },
+    { "dxt1/low",           128, 128, 1, IMAGE_FORMAT_DXT1,            false, false, 7 },
+    { "dxt1/high",          128, 128, 1, IMAGE_FORMAT_DXT1,            false, false, 0 },
+    { "dxt5",               256, 256, 1, IMAGE_FORMAT_DXT5,            false, false, 0 },
+    { "rgba8888/mips/a",    128, 128, 1, IMAGE_FORMAT_RGBA8888,        true,  false, 8 },
+    { "rgba8888/mips/b",    128, 128, 1, IMAGE_FORMAT_RGBA8888,        true,  false, 9 },
+    { "bgr888/cube",         64,  64, 6, IMAGE_FORMAT_BGR888,          false, false, 0 },
+    { "bgr888/spheremap",    64,  64, 6, IMAGE_FORMAT_BGR888,          false, true,  0 },
+    { "rgba8888/spheremap",  32,  32, 6, IMAGE_FORMAT_RGBA8888,        false, true,  1 },
+};
+
+const vlUInt g_job_count = sizeof(g_jobs) / sizeof(g_jobs[0]);
+
+struct SResult
+{
+    bool ok = false;
+    vlUInt64 hash = 0;
+    std::string error;          // error from the job failing, or the deliberate failure
+};
+
+std::vector<SResult> g_reference;
+std::atomic<vlUInt> g_mismatches(0);
+std::atomic<bool> g_running(false);
+
+SVTFLibOptions MakeOptions(vlUInt variant)
+{
+    SVTFLibOptions options;
+    vlGetDefaultOptions(&options);
+
+    switch (variant)
+    {
+    case 1:
+        options.sLuminanceWeightR = 0.2126f;
+        options.sLuminanceWeightG = 0.7152f;
+        options.sLuminanceWeightB = 0.0722f;
+        break;
+    case 2:
+        options.sLuminanceWeightR = 0.9f;
+        options.sLuminanceWeightG = 0.05f;
+        options.sLuminanceWeightB = 0.05f;
+        break;
+    case 3:
+        options.uiBlueScreenMaskR = 0xffff;
+        options.uiBlueScreenMaskB = 0x0000;
+        options.uiBlueScreenClearG = 0x8080;
+        break;
+    case 4:
+        options.uiBlueScreenMaskG = 0xffff;
+        options.uiBlueScreenClearR = 0x4040;
+        break;
+    case 5:
+        options.sFP16HDRKey = 8.0f;
+        options.sFP16HDRShift = 0.25f;
+        break;
+    case 6:
+        options.sFP16HDRKey = 1.5f;
+        options.sFP16HDRGamma = 1.8f;
+        break;
+    case 7:
+        options.uiDXTQuality = DXT_QUALITY_LOW;
+        break;
+    case 8:
+        options.sUnsharpenRadius = 4.0f;
+        options.sUnsharpenAmount = 1.5f;
+        break;
+    case 9:
+        options.sXSharpenStrength = 64.0f;
+        options.sXSharpenThreshold = 16.0f;
+        break;
+    }
+
+    return options;
+}
+
+vlUInt64 Hash(const vlByte* data, size_t size)
+{
+    vlUInt64 hash = 14695981039346656037ull;
+    for (size_t i = 0; i < size; i++)
+        hash = (hash ^ data[i]) * 1099511628211ull;
+    return hash;
+}
+
+//
+// Smooth gradients with noise on top and a varying alpha, as vtfbench uses.
+//
+void FillPattern(vlByte* rgba, vlUInt width, vlUInt height, vlUInt seed)
+{
+    vlUInt state = seed * 2654435761u + 1;
+    for (vlUInt y = 0; y < height; y++)
+    {
+        for (vlUInt x = 0; x < width; x++)
+        {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+
+            vlByte* pixel = rgba + ((size_t)y * width + x) * 4;
+            pixel[0] = (vlByte)((x * 255) / std::max(1u, width - 1) + (state & 15));
+            pixel[1] = (vlByte)((y * 255) / std::max(1u, height - 1) + ((state >> 4) & 15));
+            pixel[2] = (vlByte)(((x + y) * 127) / std::max(1u, width + height - 2) + (seed * 37));
+            pixel[3] = (vlByte)(((x ^ y) & 32) ? 255 : (state >> 8) & 255);
+        }
+    }
+}
+
+SResult RunJob(vlUInt index)
+{
+    const SJob& job = g_jobs[index];
+    SResult result;
+
+    SVTFLibOptions options = MakeOptions(job.variant);
+
+    SVTFCreateOptions create;
+    vlImageCreateDefaultCreateStructure(&create);
+    create.ImageFormat = job.format;
+    create.bMipmaps = job.mipmaps;
+    create.bThumbnail = vlFalse;
+
+    std::vector<std::vector<vlByte>> faces(job.faces);
+    std::vector<vlByte*> pointers(job.faces);
+    for (vlUInt i = 0; i < job.faces; i++)
+    {
+        faces[i].resize((size_t)job.width * job.height * 4);
+        FillPattern(faces[i].data(), job.width, job.height, index * 10 + i);
+        pointers[i] = faces[i].data();
+    }
+
+    VTFLib::CVTFFile image;
+    image.SetOptions(&options);
+
+    if (!image.Create(job.width, job.height, 1, job.faces, 1, pointers.data(), create) || (job.spheremap && !image.GenerateSphereMap()))
+    {
+        result.error = vlGetLastError();
+        return result;
+    }
+
+    std::vector<vlByte> file(image.GetSize());
+    vlUInt written = 0;
+    if (!image.Save(file.data(), (vlUInt)file.size(), written))
+    {
+        result.error = vlGetLastError();
+        return result;
+    }
+
+    result.ok = true;
+    result.hash = Hash(file.data(), written);
+
+    // Fail in a way that depends on the job, so a thread that saw another thread's error
+    // would have the wrong message.
+    VTFLib::CVTFFile broken;
+    switch (index % 3)
+    {
+    case 0:
+        broken.Load((const vlVoid*)file.data(), std::min<vlUInt>(written, 16 + index));
+        break;
+    case 1:
+        broken.Create(0, job.height);
+        break;
+    case 2:
+        broken.Load(("vtfstress-missing-" + std::to_string(index) + ".vtf").c_str());
+        break;
+    }
+    result.error = vlGetLastError();
+
+    return result;
+}
+
+bool Matches(const SResult& a, const SResult& b)
+{
+    return a.ok == b.ok && a.hash == b.hash && a.error == b.error;
+}
+
+// -----------------------------------------------------------------------------------
+// threads
+// -----------------------------------------------------------------------------------
+
+void Worker(vlUInt thread, vlUInt count)
+{
+    for (vlUInt i = 0; i < count; i++)
+    {
+        vlUInt index = (thread + i) % g_job_count;
+        SResult result = RunJob(index);
+        if (!Matches(result, g_reference[index]))
+        {
+            if (g_mismatches++ < 10)
+                printf("thread %u: %s differs: %s\n", thread, g_jobs[index].name, result.ok ? "different file or error" : result.error.c_str());
+        }
+    }
+}
+
+// Two valid option sets, so vlSetOptions() stores them unchanged.
+SVTFLibOptions g_option_sets[2];
+
+void MakeOptionSets()
+{
+    g_option_sets[0] = MakeOptions(1);
+    g_option_sets[1] = MakeOptions(9);
+    g_option_sets[1].uiDXTQuality = DXT_QUALITY_LOW;
+    g_option_sets[1].bWriteCRC = vlTrue;
+}
+
+// Flips the process wide options between the two sets while the workers run.  Nothing in
+// the jobs reads them, so this only tests they are set and read as a whole.
+void OptionsWriter()
+{
+    for (vlUInt i = 0; g_running; i++)
+        vlSetOptions(&g_option_sets[i & 1]);
+}
+
+void OptionsReader()
+{
+    SVTFLibOptions seen;
+    vlUInt torn = 0;
+    while (g_running)
+    {
+        vlGetOptions(&seen);
+        if (memcmp(&seen, &g_option_sets[0], sizeof(seen)) != 0 && memcmp(&seen, &g_option_sets[1], sizeof(seen)) != 0)
+            torn++;
+    }
+
+    if (torn != 0)
+    {
+        printf("vlGetOptions() saw a mix of two option sets %u times\n", torn);
+        g_mismatches += torn;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    printf(g_banner);
+
+    vlUInt threads = 32;
+    vlUInt iterations = 4;
+    for (int i = 1; i < argc; i++)
+    {
+        const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (_stricmp(argv[i], "-threads") == 0 && value)
+            threads = (vlUInt)strtoul(argv[++i], NULL, 10);
+        else if (_stricmp(argv[i], "-iterations") == 0 && value)
+            iterations = (vlUInt)strtoul(argv[++i], NULL, 10);
+        else
+        {
+            printf(g_usage);
+            return 1;
+        }
+    }
+
+    if (threads == 0 || iterations == 0)
+    {
+        printf(g_usage);
+        return 1;
+    }
+
+    vlInitialize();
+
+    vlUInt failing = 0;
+    for (vlUInt i = 0; i < g_job_count; i++)
+    {
+        g_reference.push_back(RunJob(i));
+        if (!g_reference[i].ok)
+        {
+            printf("%s fails on its own: %s\n", g_jobs[i].name, g_reference[i].error.c_str());
+            failing++;
+        }
+    }
+    printf("%u jobs, %u fail on their own\n", g_job_count, failing);
+
+    // Every job should be repeatable before threads are involved.
+    for (vlUInt i = 0; i < g_job_count; i++)
+    {
+        if (!Matches(RunJob(i), g_reference[i]))
+        {
+            printf("%s gives a different result when run again\n", g_jobs[i].name);
+            g_mismatches++;
+        }
+    }
+
+    printf("running %u threads, %u jobs each\n", threads, iterations * g_job_count);
+
+    MakeOptionSets();
+    vlSetOptions(&g_option_sets[0]);
+
+    g_running = true;
+    std::thread writer(OptionsWriter);
+    std::thread reader(OptionsReader);
+
+    std::vector<std::thread> workers;
+    for (vlUInt i = 0; i < threads; i++)
+        workers.emplace_back(Worker, i, iterations * g_job_count);
+    for (auto& worker : workers)
+        worker.join();
+
+    g_running = false;
+    writer.join();
+    reader.join();
+
+    vlShutdown();
+
+    if (g_mismatches != 0)
+    {
+        printf("\nFAILED: %u mismatches\n", g_mismatches.load());
+        return 1;
+    }
+
+    printf("\nall results matched\n");
+    return 0;
+}